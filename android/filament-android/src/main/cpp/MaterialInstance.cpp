@@ -26,6 +26,8 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <vector>
+
 using namespace filament;
 
 template<typename T>
@@ -179,6 +181,22 @@ Java_com_google_android_filament_MaterialInstance_nSetFloatParameterArray(JNIEnv
     env->ReleaseStringUTFChars(name_, name);
 }
 
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_google_android_filament_MaterialInstance_nSetParameterFloatOnAll(JNIEnv *env, jclass,
+        jlongArray nativeInstances_, jstring name_, jfloat x) {
+    jsize count = env->GetArrayLength(nativeInstances_);
+    jlong* nativeInstances = env->GetLongArrayElements(nativeInstances_, NULL);
+    std::vector<MaterialInstance*> instances((size_t) count);
+    for (jsize i = 0; i < count; i++) {
+        instances[i] = (MaterialInstance*) nativeInstances[i];
+    }
+    env->ReleaseLongArrayElements(nativeInstances_, nativeInstances, JNI_ABORT);
+    const char *name = env->GetStringUTFChars(name_, 0);
+    MaterialInstance::setParameter(instances.data(), instances.size(), name, float(x));
+    env->ReleaseStringUTFChars(name_, name);
+}
+
 extern "C"
 JNIEXPORT void JNICALL
 Java_com_google_android_filament_MaterialInstance_nSetParameterTexture(
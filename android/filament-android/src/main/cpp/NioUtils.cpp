@@ -24,31 +24,75 @@ struct {
     jmethodID getBaseArray;
     jmethodID getBaseArrayOffset;
     jmethodID getBufferType;
+    // for the direct-buffer fast path (see the borrowing constructor)
+    jmethodID getPosition;
+    jclass typedBufferClasses[7];
 } gNioUtils;
 
-AutoBuffer::AutoBuffer(JNIEnv *env, jobject buffer, jint size) noexcept : mEnv(env) {
+static uint8_t shiftForType(AutoBuffer::BufferType type) noexcept {
+    switch (type) {
+        case AutoBuffer::BufferType::BYTE:
+            return 0;
+        case AutoBuffer::BufferType::CHAR:
+        case AutoBuffer::BufferType::SHORT:
+            return 1;
+        case AutoBuffer::BufferType::INT:
+        case AutoBuffer::BufferType::FLOAT:
+            return 2;
+        case AutoBuffer::BufferType::LONG:
+        case AutoBuffer::BufferType::DOUBLE:
+            return 3;
+    }
+    return 0;
+}
+
+// resolves the element type with cached class checks, i.e. without up-calls into Java
+static AutoBuffer::BufferType getBufferTypeDirect(JNIEnv* env, jobject buffer) noexcept {
+    // most likely types first
+    static constexpr AutoBuffer::BufferType ordered[7] = {
+            AutoBuffer::BufferType::FLOAT,
+            AutoBuffer::BufferType::BYTE,
+            AutoBuffer::BufferType::INT,
+            AutoBuffer::BufferType::SHORT,
+            AutoBuffer::BufferType::CHAR,
+            AutoBuffer::BufferType::LONG,
+            AutoBuffer::BufferType::DOUBLE,
+    };
+    for (AutoBuffer::BufferType type : ordered) {
+        if (env->IsInstanceOf(buffer, gNioUtils.typedBufferClasses[(size_t)type])) {
+            return type;
+        }
+    }
+    return AutoBuffer::BufferType::BYTE;
+}
+
+AutoBuffer::AutoBuffer(JNIEnv *env, jobject buffer, jint size) noexcept
+        : AutoBuffer(env, buffer, size, false) {
+}
+
+AutoBuffer::AutoBuffer(JNIEnv *env, jobject buffer, jint size, bool borrow) noexcept
+        : mEnv(env) {
+    if (borrow) {
+        jlong directAddress = (jlong) env->GetDirectBufferAddress(buffer);
+        if (directAddress) {
+            // Direct buffer borrowed for the duration of the JNI call: no global
+            // references, and only a single virtual call (position()) into Java.
+            mType = getBufferTypeDirect(env, buffer);
+            mShift = shiftForType(mType);
+            mSize = (size_t) size << mShift;
+            jint position = env->CallIntMethod(buffer, gNioUtils.getPosition);
+            mData = reinterpret_cast<void *>(directAddress + ((jlong) position << mShift));
+            mUserData = mData;
+            return;
+        }
+    }
+
     mBuffer = env->NewGlobalRef(buffer);
 
     mType = (BufferType) env->CallStaticIntMethod(
                 gNioUtils.jniClass, gNioUtils.getBufferType, mBuffer);
 
-    switch (mType) {
-        case BufferType::BYTE:
-            mShift = 0;
-            break;
-        case BufferType::CHAR:
-        case BufferType::SHORT:
-            mShift = 1;
-            break;
-        case BufferType::INT:
-        case BufferType::FLOAT:
-            mShift = 2;
-            break;
-        case BufferType::LONG:
-        case BufferType::DOUBLE:
-            mShift = 3;
-            break;
-    }
+    mShift = shiftForType(mType);
 
     mSize = (size_t) size << mShift;
 
@@ -150,4 +194,24 @@ void registerNioUtils(JNIEnv *env) {
             "(Ljava/nio/Buffer;I)I");
     gNioUtils.getBufferType = env->GetStaticMethodID(gNioUtils.jniClass, "getBufferType",
             "(Ljava/nio/Buffer;)I");
+
+    jclass bufferClass = env->FindClass("java/nio/Buffer");
+    gNioUtils.getPosition = env->GetMethodID(bufferClass, "position", "()I");
+    env->DeleteLocalRef(bufferClass);
+
+    // indexed by AutoBuffer::BufferType
+    static constexpr const char* typedBufferNames[7] = {
+            "java/nio/ByteBuffer",
+            "java/nio/CharBuffer",
+            "java/nio/ShortBuffer",
+            "java/nio/IntBuffer",
+            "java/nio/LongBuffer",
+            "java/nio/FloatBuffer",
+            "java/nio/DoubleBuffer",
+    };
+    for (size_t i = 0; i < 7; i++) {
+        jclass clazz = env->FindClass(typedBufferNames[i]);
+        gNioUtils.typedBufferClasses[i] = (jclass) env->NewGlobalRef(clazz);
+        env->DeleteLocalRef(clazz);
+    }
 }
@@ -33,6 +33,14 @@ public:
     };
 
     AutoBuffer(JNIEnv* env, jobject buffer, jint size) noexcept;
+
+    // Same as above but when 'borrow' is true the buffer is assumed to be accessed only
+    // for the duration of the JNI call: direct buffers are then resolved without
+    // up-calls into Java and without creating global references. Must not be used when
+    // the data is consumed asynchronously (e.g. through a BufferDescriptor), which
+    // needs to pin the buffer until its callback runs.
+    AutoBuffer(JNIEnv* env, jobject buffer, jint size, bool borrow) noexcept;
+
     AutoBuffer(AutoBuffer&& rhs) noexcept;
     ~AutoBuffer() noexcept;
 
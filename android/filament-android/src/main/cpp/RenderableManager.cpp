@@ -171,7 +171,7 @@ extern "C" JNIEXPORT jint JNICALL
 Java_com_google_android_filament_RenderableManager_nBuilderSkinningBones(JNIEnv* env, jclass,
         jlong nativeBuilder, jint boneCount, jobject bones, jint remaining) {
     RenderableManager::Builder *builder = (RenderableManager::Builder *) nativeBuilder;
-    AutoBuffer nioBuffer(env, bones, boneCount * 8);
+    AutoBuffer nioBuffer(env, bones, boneCount * 8, true);
     void* data = nioBuffer.getData();
     size_t sizeInBytes = nioBuffer.getSize();
     if (sizeInBytes > (remaining << nioBuffer.getShift())) {
@@ -189,7 +189,7 @@ Java_com_google_android_filament_RenderableManager_nSetBonesAsMatrices(JNIEnv* e
         jlong nativeRenderableManager, jint i, jobject matrices, jint remaining,
         jint boneCount, jint offset) {
     RenderableManager *rm = (RenderableManager *) nativeRenderableManager;
-    AutoBuffer nioBuffer(env, matrices, boneCount * 16);
+    AutoBuffer nioBuffer(env, matrices, boneCount * 16, true);
     void* data = nioBuffer.getData();
     size_t sizeInBytes = nioBuffer.getSize();
     if (sizeInBytes > (remaining << nioBuffer.getShift())) {
@@ -206,7 +206,7 @@ Java_com_google_android_filament_RenderableManager_nSetBonesAsQuaternions(JNIEnv
         jlong nativeRenderableManager, jint i, jobject quaternions, jint remaining,
         jint boneCount, jint offset) {
     RenderableManager *rm = (RenderableManager *) nativeRenderableManager;
-    AutoBuffer nioBuffer(env, quaternions, boneCount * 8);
+    AutoBuffer nioBuffer(env, quaternions, boneCount * 8, true);
     void* data = nioBuffer.getData();
     size_t sizeInBytes = nioBuffer.getSize();
     if (sizeInBytes > (remaining << nioBuffer.getShift())) {
@@ -20,6 +20,8 @@
 #include <utils/Entity.h>
 #include <filament/TransformManager.h>
 
+#include "NioUtils.h"
+
 using namespace utils;
 using namespace filament;
 
@@ -94,6 +96,29 @@ Java_com_google_android_filament_TransformManager_nSetTransform(JNIEnv* env,
     env->ReleaseFloatArrayElements(localTransform_, localTransform, JNI_ABORT);
 }
 
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_android_filament_TransformManager_nSetTransforms(JNIEnv* env,
+        jclass, jlong nativeTransformManager, jintArray instances_,
+        jobject localTransforms, jint remaining) {
+    TransformManager* tm = (TransformManager*) nativeTransformManager;
+    jsize count = env->GetArrayLength(instances_);
+    AutoBuffer nioBuffer(env, localTransforms, count * 16, true);
+    size_t sizeInBytes = nioBuffer.getSize();
+    if (sizeInBytes > (remaining << nioBuffer.getShift())) {
+        // BufferOverflowException
+        return -1;
+    }
+    math::mat4f const* transforms = static_cast<math::mat4f const*>(nioBuffer.getData());
+    jint* instances = env->GetIntArrayElements(instances_, NULL);
+    tm->openLocalTransformTransaction();
+    for (jsize i = 0; i < count; i++) {
+        tm->setTransform((TransformManager::Instance) instances[i], transforms[i]);
+    }
+    tm->commitLocalTransformTransaction();
+    env->ReleaseIntArrayElements(instances_, instances, JNI_ABORT);
+    return 0;
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_google_android_filament_TransformManager_nGetTransform(JNIEnv* env,
         jclass, jlong nativeTransformManager, jint i,
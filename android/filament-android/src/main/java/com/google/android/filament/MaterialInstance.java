@@ -138,6 +138,21 @@ public class MaterialInstance {
         setParameter(name, FloatElement.FLOAT4, Colors.toLinear(type, r, g, b, a), 0, 1);
     }
 
+    /**
+     * Sets a float parameter on several instances in a single JNI call. The parameter
+     * name is resolved only once, so this is much cheaper than calling
+     * {@link #setParameter(String, float)} in a loop. All instances must have been
+     * created from the same {@link Material}.
+     */
+    public static void setParameter(@NonNull MaterialInstance[] instances,
+            @NonNull String name, float x) {
+        long[] nativeInstances = new long[instances.length];
+        for (int i = 0; i < instances.length; i++) {
+            nativeInstances[i] = instances[i].getNativeObject();
+        }
+        nSetParameterFloatOnAll(nativeInstances, name, x);
+    }
+
     public void setScissor(@IntRange(from = 0) int left, @IntRange(from = 0) int bottom,
             @IntRange(from = 0) int width, @IntRange(from = 0) int height) {
         nSetScissor(getNativeObject(), left, bottom, width, height);
@@ -196,6 +211,9 @@ public class MaterialInstance {
             @NonNull String name, int element, @NonNull @Size(min = 1) float[] v,
             @IntRange(from = 0) int offset, @IntRange(from = 1) int count);
 
+    private static native void nSetParameterFloatOnAll(@NonNull long[] nativeInstances,
+            @NonNull String name, float x);
+
     private static native void nSetParameterTexture(long nativeMaterialInstance,
             @NonNull String name, long nativeTexture, int sampler);
 
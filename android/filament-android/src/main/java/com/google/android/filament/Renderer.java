@@ -42,7 +42,16 @@ public class Renderer {
     }
 
     public boolean beginFrame(@NonNull SwapChain swapChain) {
-        return nBeginFrame(getNativeObject(), swapChain.getNativeObject());
+        return nBeginFrame(getNativeObject(), swapChain.getNativeObject(), 0);
+    }
+
+    /**
+     * Same as {@link #beginFrame(SwapChain)}, additionally passing the vsync timestamp
+     * delivered by {@link android.view.Choreographer.FrameCallback} (frameTimeNanos).
+     * It is used as the frame's reference time and improves the frame skip decision.
+     */
+    public boolean beginFrame(@NonNull SwapChain swapChain, long frameTimeNanos) {
+        return nBeginFrame(getNativeObject(), swapChain.getNativeObject(), frameTimeNanos);
     }
 
     public void endFrame() {
@@ -100,7 +109,8 @@ public class Renderer {
         mNativeObject = 0;
     }
 
-    private static native boolean nBeginFrame(long nativeRenderer, long nativeSwapChain);
+    private static native boolean nBeginFrame(long nativeRenderer, long nativeSwapChain,
+            long frameTimeNanos);
     private static native void nEndFrame(long nativeRenderer);
     private static native void nRender(long nativeRenderer, long nativeView);
     private static native void nMirrorFrame(long nativeRenderer, long nativeDstSwapChain,
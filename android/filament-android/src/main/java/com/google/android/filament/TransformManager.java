@@ -20,6 +20,9 @@ import android.support.annotation.NonNull;
 import android.support.annotation.Nullable;
 import android.support.annotation.Size;
 
+import java.nio.Buffer;
+import java.nio.BufferOverflowException;
+
 public class TransformManager {
     private long mNativeObject;
 
@@ -63,6 +66,25 @@ public class TransformManager {
         nSetTransform(mNativeObject, i, localTransform);
     }
 
+    /**
+     * Sets the local transform of several components in a single JNI call.
+     * <p>
+     * <code>localTransforms</code> holds one column-major 4x4 matrix (16 floats) per
+     * entry of <code>instances</code>, tightly packed, starting at the buffer's current
+     * position. The update is wrapped in a local transform transaction, so the world
+     * transforms are recomputed only once. Use a direct Buffer for best performance.
+     *
+     * @throws BufferOverflowException if the buffer doesn't hold enough data
+     */
+    public void setTransforms(@NonNull @EntityInstance int[] instances,
+            @NonNull Buffer localTransforms) {
+        int result = nSetTransforms(mNativeObject, instances,
+                localTransforms, localTransforms.remaining());
+        if (result < 0) {
+            throw new BufferOverflowException();
+        }
+    }
+
     @NonNull
     @Size(min = 16)
     public float[] getTransform(@EntityInstance int i,
@@ -105,6 +127,7 @@ public class TransformManager {
     private static native void nDestroy(long nativeTransformManager, int entity);
     private static native void nSetParent(long nativeTransformManager, int i, int newParent);
     private static native void nSetTransform(long nativeTransformManager, int i, float[] localTransform);
+    private static native int nSetTransforms(long nativeTransformManager, int[] instances, Buffer localTransforms, int remaining);
     private static native void nGetTransform(long nativeTransformManager, int i, float[] outLocalTransform);
     private static native void nGetWorldTransform(long nativeTransformManager, int i, float[] outWorldTransform);
     private static native void nOpenLocalTransformTransaction(long nativeTransformManager);
@@ -61,6 +61,16 @@ public:
     friend Box rigidTransform(Box const& box, const math::mat3f& m) noexcept;
 };
 
+/**
+ * Batch version of rigidTransform(): transforms count boxes, stored as separate
+ * center/half-extent arrays, in place, each by its own rigid transform. The scalar
+ * version is fine for a single box, but the bound-refit stage recomputes tens of
+ * thousands of world-space AABBs per transform change (see FScene::prepare()), which
+ * is worth the explicitly vectorized abs-matrix kernel (see math/simd.h).
+ */
+UTILS_PUBLIC void rigidTransformBatch(math::float3* centers, math::float3* halfExtents,
+        const math::mat4f* transforms, size_t count) noexcept;
+
 struct Aabb {
     math::float3 min = std::numeric_limits<float>::max();
     math::float3 max = std::numeric_limits<float>::lowest();
@@ -44,8 +44,22 @@ public:
         Type type;
     };
 
+    /**
+     * A monotonically increasing event counter. Counters are incremented from hot
+     * paths with relaxed atomics and aggregated into a snapshot once per frame, at
+     * the end of the frame; value is the last snapshot, so reading it is race-free
+     * and costs nothing on the paths being counted.
+     */
+    struct Counter {
+        const char* name;
+        uint64_t value;     //!< value captured by the last end-of-frame snapshot
+    };
+
     std::pair<Property const*, size_t> getProperties() const noexcept;
 
+    //! Returns the counters captured by the last end-of-frame snapshot.
+    std::pair<Counter const*, size_t> getCounters() const noexcept;
+
     bool hasProperty(const char* name) const noexcept;
 
     void* getPropertyAddress(const char* name) noexcept;
@@ -178,6 +178,13 @@ public:
      *
      * \remark
      * This method is thread-safe.
+     *
+     * \remark
+     * Several Engine instances may coexist in a process, each owning its own driver thread
+     * and GPU -- e.g. one per GPU on a multi-GPU workstation. Objects created from one
+     * Engine can't be used with another, but immutable CPU-side data such as material
+     * packages is shared between engines automatically (see Material.Builder.package()),
+     * so additional engines only pay for their own GPU-side copies.
      */
     static Engine* create(Backend backend = Backend::DEFAULT,
             Platform* platform = nullptr, void* sharedGLContext = nullptr);
@@ -229,6 +236,22 @@ public:
      */
     SwapChain* createSwapChain(void* nativeWindow, uint64_t flags = 0) noexcept;
 
+    /**
+     * Creates a headless SwapChain, not backed by any native window.
+     *
+     * This is useful for offscreen (e.g. server-side) rendering on machines without a
+     * display server. Rendered frames are retrieved with Renderer.readPixels().
+     *
+     * @param width Width of the rendering buffer in pixels.
+     * @param height Height of the rendering buffer in pixels.
+     * @param flags One or more configuration flags as defined in `SwapChain`.
+     *
+     * @return A pointer to the newly created SwapChain or nullptr if it couldn't be created.
+     *
+     * @see Renderer.beginFrame(), Renderer.readPixels()
+     */
+    SwapChain* createSwapChain(uint32_t width, uint32_t height, uint64_t flags = 0) noexcept;
+
     /**
      * Creates a renderer associated to this engine.
      *
@@ -269,6 +292,19 @@ public:
      */
     Fence* createFence(Fence::Type type = Fence::Type::SOFT) noexcept;
 
+    /**
+     * Creates a Fence that tracks the background resource queue.
+     *
+     * When background resource loading is enabled (see setAsyncResourceLoadingEnabled()),
+     * the fence signals once every resource creation and upload issued before it has been
+     * executed; only then may those resources be referenced by frame commands (e.g.
+     * attached to a renderable or a material instance). Wait on it with
+     * Fence::Mode::FLUSH so the pending resource commands are actually submitted.
+     *
+     * @return A pointer to the newly created Fence or nullptr if it couldn't be created.
+     */
+    Fence* createResourceFence() noexcept;
+
     void destroy(const VertexBuffer* p);        //!< Destroys an VertexBuffer object.
     void destroy(const Fence* p);               //!< Destroys a Fence object.
     void destroy(const IndexBuffer* p);         //!< Destroys an IndexBuffer object.
@@ -316,6 +352,113 @@ public:
      */
     void* streamAlloc(size_t size, size_t alignment = alignof(double)) noexcept;
 
+    /**
+     * Allocates upload memory suitable for large streamed data (e.g. decoded texture mips).
+     *
+     * Decode or generate the data directly into the returned buffer, then hand it to the
+     * engine as a BufferDescriptor (or PixelBufferDescriptor) using Engine::uploadCallback
+     * as the callback and this Engine as the user pointer; the memory is returned to an
+     * internal pool when the driver has consumed the descriptor. Compared to malloc'ing a
+     * fresh buffer for every upload, this recycles allocations between uploads of the same
+     * size, which avoids allocator churn for loaders streaming tens of MB per second.
+     *
+     * This can be called from any thread.
+     *
+     * @param size size of the buffer to allocate, in bytes
+     * @return a pointer to the allocated buffer, or nullptr if size is 0
+     *
+     * @see uploadCallback
+     */
+    void* uploadAlloc(size_t size) noexcept;
+
+    /**
+     * BufferDescriptor callback that returns memory obtained from uploadAlloc() to the
+     * engine. The descriptor's user pointer must be the Engine the buffer came from, and the
+     * descriptor's size must be the size passed to uploadAlloc().
+     */
+    static void uploadCallback(void* buffer, size_t size, void* user);
+
+    /**
+     * Sets how many frames the CPU is allowed to run ahead of the GPU.
+     *
+     * A latency of 1 minimizes input-to-photon latency at the cost of more skipped frames
+     * when the GPU can't keep up (e.g. for VR). Higher values absorb short CPU or GPU
+     * spikes instead of missing vsync, at the cost of one extra frame of latency each.
+     * Values are clamped to [1, 3]. The default is 2.
+     *
+     * The new latency takes effect at the beginning of the next frame.
+     *
+     * @param frames How many frames the CPU may run ahead of the GPU.
+     */
+    void setFrameLatency(size_t frames) noexcept;
+
+    //! Returns the frame latency set by setFrameLatency(), or 2 if it was never called.
+    size_t getFrameLatency() const noexcept;
+
+    /**
+     * Enables or disables background resource loading.
+     *
+     * When enabled, Textures, VertexBuffers and IndexBuffers created afterwards record
+     * their creation and data-upload commands on a separate queue that the engine's
+     * thread drains only when frames have slack, so large uploads don't compete with
+     * frame commands and cause hitches. Such resources must not be referenced by frame
+     * commands until a fence created with createResourceFence() has signaled.
+     *
+     * The setting is captured when each resource is created; toggling it doesn't affect
+     * existing resources. It is disabled by default.
+     *
+     * @param enabled true to route subsequent resource creations to the background queue
+     */
+    void setAsyncResourceLoadingEnabled(bool enabled) noexcept;
+
+    //! Returns whether background resource loading is enabled.
+    bool isAsyncResourceLoadingEnabled() const noexcept;
+
+    /**
+     * Estimated GPU memory used by resources created through this Engine, per resource
+     * type. The estimates are computed from the resource descriptions (dimensions, format,
+     * vertex layout...) and tracked as resources are created and destroyed; they don't
+     * include driver-internal overhead.
+     */
+    struct MemoryUsage {
+        size_t textureBytes = 0;        //!< estimated memory used by textures
+        size_t vertexBufferBytes = 0;   //!< estimated memory used by vertex buffers
+        size_t indexBufferBytes = 0;    //!< estimated memory used by index buffers
+        size_t totalBytes = 0;          //!< sum of the above
+    };
+
+    /**
+     * Called synchronously, from the thread creating the resource, when a resource
+     * creation pushes the total estimated usage above the budget set with
+     * setMemoryBudget(). Other resources may be destroyed from the callback (e.g. to
+     * drop high-resolution mips or distant meshes); the resource being created is not
+     * affected.
+     */
+    using MemoryPressureCallback = void(*)(MemoryUsage const& usage, size_t budgetBytes, void* user);
+
+    //! Returns the current estimated GPU memory usage.
+    MemoryUsage getMemoryUsage() const noexcept;
+
+    /**
+     * Sets the GPU memory budget used to trigger the memory pressure callback.
+     * A budget of 0 (the default) disables the callback.
+     */
+    void setMemoryBudget(size_t budgetBytes) noexcept;
+
+    //! Sets the callback invoked when the memory budget is exceeded. May be nullptr.
+    void setMemoryPressureCallback(MemoryPressureCallback callback, void* user) noexcept;
+
+    /**
+     * Returns the most memory the per-render-pass arena has ever used, in bytes.
+     *
+     * Render passes are recorded into a linear arena sized at Engine creation time;
+     * a frame that overflows it spills into heap-allocated slabs, which are retained
+     * across frames. This value can be used as telemetry to size the arena, instead
+     * of guessing.
+     *
+     * @return High watermark of the per-render-pass arena in bytes.
+     */
+    size_t getPerRenderPassArenaHighWatermark() const noexcept;
 
     /**
      * helper for creating an Entity and Camera component in one call
@@ -54,6 +54,13 @@ public:
     // set the frustum from the given projection matrix
     void setProjection(const math::mat4f& pv);
 
+    // Sets count frusta from count projection matrices. Equivalent to calling
+    // setProjection() on each frustum in turn, but the plane extraction is batched
+    // so the normalizations vectorize across planes -- use this when building the
+    // frusta of shadow cascades or multi-view setups.
+    static void setProjection(Frustum* UTILS_RESTRICT frusta,
+            const math::mat4f* UTILS_RESTRICT pv, size_t count) noexcept;
+
     // return the plane equation parameters with normalized normals
     math::float4 getNormalizedPlane(Plane plane) const noexcept;
 
@@ -39,6 +39,7 @@ class UTILS_PUBLIC IndexBuffer : public FilamentAPI {
 
 public:
     using BufferDescriptor = driver::BufferDescriptor;
+    using BufferUsage = driver::Usage;
 
     enum class IndexType : uint8_t {
         USHORT = uint8_t(driver::ElementType::USHORT),
@@ -58,6 +59,14 @@ public:
         Builder& indexCount(uint32_t indexCount) noexcept;
         Builder& bufferType(IndexType indexType) noexcept;
 
+        /**
+         * Hints how often the buffer content will be re-specified. The default is
+         * BufferUsage::STATIC. Use BufferUsage::STREAM for content generated every
+         * frame (e.g. UI geometry): drivers then multi-buffer the storage so
+         * setBuffer() doesn't stall on data the GPU is still reading.
+         */
+        Builder& usage(BufferUsage usage) noexcept;
+
         /**
          * Creates the IndexBuffer object and returns a pointer to it.
          *
@@ -19,6 +19,7 @@
 #ifndef TNT_FILAMENT_INDIRECT_LIGHT_H
 #define TNT_FILAMENT_INDIRECT_LIGHT_H
 
+#include <filament/Box.h>
 #include <filament/FilamentAPI.h>
 
 #include <utils/compiler.h>
@@ -224,6 +225,24 @@ public:
      * @param rotation 3x3 rotation matrix. Must be a rigid-body transform.
      */
     void setRotation(math::mat3f const& rotation) noexcept;
+
+    /**
+     * Turns this IndirectLight into a local reflection probe.
+     *
+     * By default the reflections cubemap is treated as an environment at infinity. When a
+     * probe volume is set, the reflection vector is parallax-corrected against the given
+     * world-space box ("box projection"), so that reflections appear attached to the room
+     * the probe was captured in -- a cheap form of localized reflections. The irradiance
+     * is unaffected.
+     *
+     * @param aabb  World-space box the reflections cubemap was captured in, typically the
+     *              walls of a room. Pass an empty Box to revert to an environment at
+     *              infinity (the default).
+     */
+    void setProbeVolume(const Box& aabb) noexcept;
+
+    //! Returns the probe volume set by setProbeVolume(), empty by default.
+    const Box& getProbeVolume() const noexcept;
 };
 
 } // namespace filament
@@ -89,6 +89,8 @@ public:
 
         // This does not copies the content of the RAM, only copy references.
         // The RAM must stay valid until build() is called.
+        // Packages are deduplicated process-wide: materials built from the same bytes
+        // (e.g. by several Engine instances) share a single immutable copy of the payload.
         Builder& package(const void* payload, size_t size);
 
         /**
@@ -110,6 +112,16 @@ public:
 
     MaterialInstance* createInstance() const noexcept;
 
+    /**
+     * Pre-creates the programs for all of this material's variants.
+     *
+     * By default a variant's program is compiled the first time it is drawn, which can
+     * hitch a frame; call this during a loading screen to pay the compilation cost up
+     * front instead. The set of variants is precomputed by matc and shipped with the
+     * material package, so variants stripped at compile time are not built.
+     */
+    void compile() const noexcept;
+
     const char* getName() const noexcept;
     Shading getShading()  const noexcept;
     Interpolation getInterpolation() const noexcept;
@@ -129,6 +141,23 @@ public:
     size_t getParameters(ParameterInfo* parameters, size_t count) const noexcept;
     bool hasParameter(const char* name) const noexcept;
 
+    using ParameterHandle = MaterialInstance::ParameterHandle;
+
+    /**
+     * Resolves a uniform parameter name to a handle, to be used with the handle
+     * overloads of MaterialInstance::setParameter(). Resolve the handle once and keep
+     * it; this moves the per-call string hashing and compares out of the hot path.
+     *
+     * Handles are only valid for instances of this Material. Sampler parameters don't
+     * have handles, set them by name.
+     *
+     * @param name Name of the parameter as defined by Material. Cannot be nullptr.
+     * @return The parameter's handle, or a negative value if the name doesn't exist.
+     * @throws utils::PreConditionPanic if name doesn't exist or no-op if exceptions
+     *         are disabled.
+     */
+    ParameterHandle getParameterHandle(const char* name) const noexcept;
+
     template <typename T>
     void setDefaultParameter(const char* name, T value) noexcept {
         getDefaultInstance()->setParameter(name, value);
@@ -32,6 +32,13 @@ class UniformInterfaceBlock;
 
 class UTILS_PUBLIC MaterialInstance : public FilamentAPI {
 public:
+    /**
+     * Handle to a uniform parameter, resolved once with Material::getParameterHandle().
+     * A negative handle is invalid; setting a parameter through an invalid handle is
+     * a no-op.
+     */
+    using ParameterHandle = int32_t;
+
     /**
      * @return the Material associated with this instance
      */
@@ -58,6 +65,49 @@ public:
     template<typename T>
     void setParameter(const char* name, const T* values, size_t count) noexcept;
 
+    /**
+     * Set a uniform by handle
+     *
+     * The name lookup (hashing and string compares) was paid once in
+     * Material::getParameterHandle(); this overload goes straight to the uniform
+     * storage, so prefer it in per-frame code that sets many parameters.
+     *
+     * @param handle    Handle obtained from Material::getParameterHandle() on this
+     *                  instance's Material. No-op if the handle is invalid.
+     * @param value     Value of the parameter to set.
+     */
+    template<typename T>
+    void setParameter(ParameterHandle handle, T value) noexcept;
+
+    /**
+     * Set a uniform array by handle
+     *
+     * @param handle    Handle obtained from Material::getParameterHandle() on this
+     *                  instance's Material. No-op if the handle is invalid.
+     * @param values    Array of values to set to the parameter array.
+     * @param count     Size of the array to set.
+     */
+    template<typename T>
+    void setParameter(ParameterHandle handle, const T* values, size_t count) noexcept;
+
+    /**
+     * Set the same uniform by name on several instances at once
+     *
+     * The parameter name is resolved only once, so this is much cheaper than calling
+     * setParameter() on each instance when animating a parameter across many instances
+     * of the same material.
+     *
+     * @param instances Array of MaterialInstance pointers, all created from the same
+     *                  Material. Cannot be nullptr.
+     * @param count     Number of instances in the array.
+     * @param name      Name of the parameter as defined by Material. Cannot be nullptr.
+     * @param value     Value of the parameter to set.
+     * @throws utils::PreConditionPanic if name doesn't exist or no-op if exceptions are disabled.
+     */
+    template<typename T>
+    static void setParameter(MaterialInstance* const* instances, size_t count,
+            const char* name, T value) noexcept;
+
     /**
      * Set a texture as the named parameter
      *
@@ -49,6 +49,9 @@ public:
     using Instance = utils::EntityInstance<RenderableManager>;
     using PrimitiveType = driver::PrimitiveType;
 
+    //! Maximum number of levels of detail per renderable, including the base geometry.
+    static constexpr uint8_t MAX_LOD_COUNT = 4;
+
     bool hasComponent(utils::Entity e) const noexcept;
 
     Instance getInstance(utils::Entity e) const noexcept;
@@ -79,7 +82,12 @@ public:
         Builder& layerMask(uint8_t select, uint8_t values) noexcept;
         // The priority is clamped to the range [0..7], defaults to 4; 7 is lowest priority
         Builder& priority(uint8_t priority) noexcept;
+        // Groups color-pass commands within a priority, see setSortGroup(); defaults to 0
+        Builder& sortGroup(uint8_t group) noexcept;
         Builder& culling(bool enable) noexcept; // true by default
+        // Culls against the bounding box oriented by the renderable's transform instead of its
+        // world-space AABB, which is grossly conservative for long thin meshes under rotation.
+        Builder& orientedBounds(bool enable) noexcept; // false by default
         Builder& castShadows(bool enable) noexcept; // false by default
         Builder& receiveShadows(bool enable) noexcept; // true by default
         Builder& skinning(size_t boneCount) noexcept; // 0 by default, 255 max
@@ -89,6 +97,36 @@ public:
         // Sets an ordering index for blended primitives that all live at the same Z value.
         Builder& blendOrder(size_t index, uint16_t order) noexcept; // 0 by default
 
+        // Sets an object-space bounding box and normal cone for the primitive at index,
+        // enabling per-primitive backface cluster culling: when every triangle of the
+        // primitive faces away from the viewpoint (terrain patches, building sides), its
+        // commands are skipped at generation time. The cone's xyz is its axis and w the
+        // sine of its half-angle; w >= 1 disables the test (the default). Only applies
+        // when the material culls back-faces. filamesh cooks this data (version 3 files).
+        Builder& bounds(size_t index, const Box& aabb, math::float4 const& normalCone) noexcept;
+
+        /**
+         * Declares a coarser level of detail (LOD) for this renderable.
+         *
+         * Each LOD level has the same number of primitives, the same materials and the
+         * same blend orders as the base geometry declared with geometry(); only the
+         * vertex/index data differs (set it with lodGeometry()). The renderer picks the
+         * coarsest level whose on-screen error is acceptable, based on the size the
+         * renderable's bounding sphere projects to.
+         *
+         * @param level         LOD level in [1, MAX_LOD_COUNT); level 0 is the base
+         *                      geometry. Levels must be declared contiguously.
+         * @param minScreenSize fraction of the viewport height the bounding sphere must
+         *                      cover for the *previous* level to be kept; below it, this
+         *                      level is used instead. Must decrease with increasing level.
+         */
+        Builder& lod(uint8_t level, float minScreenSize) noexcept;
+
+        //! Sets the geometry of primitive @p index for LOD level @p level, see lod().
+        Builder& lodGeometry(uint8_t level, size_t index, PrimitiveType type,
+                VertexBuffer* vertices, IndexBuffer* indices,
+                size_t offset, size_t count) noexcept;
+
         /**
          * Adds the Renderable component to an entity.
          *
@@ -123,6 +161,8 @@ public:
             MaterialInstance const* materialInstance = nullptr;
             PrimitiveType type = PrimitiveType::TRIANGLES;
             uint16_t blendOrder = 0;
+            Box aabb = {};                                          // object-space, optional
+            math::float4 normalCone = { 0.0f, 0.0f, 0.0f, 1.0f };   // see bounds()
         };
     };
 
@@ -132,6 +172,22 @@ public:
     void setAxisAlignedBoundingBox(Instance instance, const Box& aabb) noexcept;
     void setLayerMask(Instance instance, uint8_t select, uint8_t values) noexcept;
     void setPriority(Instance instance, uint8_t priority) noexcept;
+
+    /**
+     * Sets the sort group of the renderable.
+     *
+     * Renderables with the same priority are grouped by sort group when the color pass
+     * commands are sorted, ahead of the material-based sorting. This lets applications
+     * force renderables that share GPU state (e.g. all instances of one vegetation type)
+     * to be drawn consecutively, beyond what material sorting achieves on its own. It
+     * has no effect on the depth or blended passes, so it can't break the depth-sorted
+     * order of transparent objects.
+     *
+     * @param instance Instance of the component obtained from getInstance().
+     * @param group    Sort group, in no particular order; defaults to 0.
+     */
+    void setSortGroup(Instance instance, uint8_t group) noexcept;
+
     void setCastShadows(Instance instance, bool enable) noexcept;
     void setReceiveShadows(Instance instance, bool enable) noexcept;
     bool isShadowCaster(Instance instance) const noexcept;
@@ -140,6 +196,46 @@ public:
     void setBones(Instance instance, Bone const* transforms, size_t boneCount = 1, size_t offset = 0) noexcept;
     void setBones(Instance instance, math::mat4f const* transforms, size_t boneCount = 1, size_t offset = 0) noexcept;
 
+    /**
+     * Enables, resizes or disables skinning without rebuilding the component.
+     *
+     * Equivalent to what Builder::skinning() declares, but applied in place: only the
+     * bone storage and the skinning flag are touched, so swapping a static mesh for a
+     * skinned one (or changing the bone count) doesn't go through destroy()/build(),
+     * which would also churn the uniform arena slot and the per-primitive state.
+     * Newly allocated bones are initialized to identity; pass 0 to release the bone
+     * storage and disable skinning.
+     *
+     * @param instance  Instance of the component obtained from getInstance().
+     * @param boneCount Number of bones, clamped to 255 like Builder::skinning().
+     */
+    void setSkinning(Instance instance, size_t boneCount) noexcept;
+
+    /**
+     * Sets the blend weights of the morph targets.
+     *
+     * Morph target i is a per-vertex position delta stored in the MORPH_POSITION_i
+     * vertex attribute and scaled by weights[i] in the vertex shader; the deltas are
+     * uploaded once with the rest of the vertex data. The material must declare the
+     * morph attributes it uses in its "requires" list. Weights default to zero.
+     */
+    void setMorphWeights(Instance instance, math::float4 const& weights) noexcept;
+
+    /**
+     * Sets the dequantization transform of the POSITION vertex attribute.
+     *
+     * Positions quantized to a normalized integer format (e.g. SHORT4 with the
+     * normalized flag, i.e. SNORM16) only span [-1, 1]; the vertex shader remaps
+     * them to model space with: position = attribute * scale + offset. This halves
+     * the vertex position bandwidth compared to FLOAT3. The transform defaults to
+     * identity (scale = 1, offset = 0), which is correct for unquantized positions.
+     *
+     * Note that the bounding box passed to Builder::boundingBox() is always in
+     * model space, i.e. after dequantization.
+     */
+    void setQuantizedPositionTransform(Instance instance,
+            math::float3 const& scale, math::float3 const& offset) noexcept;
+
 
     // getters...
     const Box& getAxisAlignedBoundingBox(Instance instance) const noexcept;
@@ -157,6 +253,14 @@ public:
             PrimitiveType type, VertexBuffer* vertices, IndexBuffer* indices,
             size_t offset, size_t count) noexcept;
 
+    // Full form of the above, with an explicit referenced vertex range (like
+    // Builder::geometry()); the short form assumes the whole vertex buffer is used.
+    // Combine with setAxisAlignedBoundingBox() when the new geometry has different
+    // bounds -- both mutate the component in place, no destroy()/build() needed.
+    void setGeometryAt(Instance instance, size_t primitiveIndex,
+            PrimitiveType type, VertexBuffer* vertices, IndexBuffer* indices,
+            size_t offset, size_t minIndex, size_t maxIndex, size_t count) noexcept;
+
     // set/change the offset/count in the currently set index buffer of a given primitive
     void setGeometryAt(Instance instance, size_t primitiveIndex,
             PrimitiveType type, size_t offset, size_t count) noexcept;
@@ -24,6 +24,7 @@
 
 #include <utils/compiler.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace filament {
@@ -137,6 +138,32 @@ public:
      */
     void render(View const* view);
 
+    /**
+     * Render several Views into this renderer's window in a single call.
+     *
+     * This is equivalent to calling render() on each View of the array in order, but
+     * the per-frame work is shared between them: scene preparation (gathering the
+     * renderables, processing the lights) runs once per Scene rather than once per
+     * View, Views lit by the same directional light reuse a single shadow map, and
+     * the command stream is flushed to the render thread once for the whole batch.
+     *
+     * This is intended for stereo rendering -- one View per eye, sharing a Scene --
+     * and more generally for applications composing a frame out of several Views,
+     * where the per-View fixed cost would otherwise multiply with the view count.
+     *
+     * @param views     Pointer to an array of Views to render, in order. Null entries
+     *                  and Views without a Scene are skipped.
+     * @param viewCount Number of Views in the array.
+     *
+     * @attention
+     * Like render(), this must be called *after* beginFrame() and *before* endFrame(),
+     * from the Engine's main thread.
+     *
+     * @see
+     * render()
+     */
+    void render(View const* const* views, size_t viewCount);
+
     /**
      * Flags used to configure the behavior of mirrorFrame().
      *
@@ -245,6 +272,58 @@ public:
     void readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             driver::PixelBufferDescriptor&& buffer);
 
+    /**
+     * GPU time spent in each of the main passes, in nanoseconds, for the most recent
+     * frame with results available (the GPU runs a few frames behind the CPU). A value
+     * of 0 means no result is available yet, or that the backend doesn't support
+     * timer queries.
+     */
+    struct GpuPassTimings {
+        uint64_t shadowPass = 0;
+        uint64_t colorPass = 0;
+        uint64_t postProcess = 0;
+    };
+
+    /**
+     * Returns the GPU pass timings measured by this Renderer's timer queries. Reading
+     * them is cheap (no synchronization with the GPU) and can be done every frame.
+     */
+    GpuPassTimings getGpuPassTimings() const noexcept;
+
+    /**
+     * A compact telemetry record produced once per frame by endFrame(). Recording is
+     * always on and allocation-free, so draining these in production builds is free.
+     *
+     * The GPU fields have the same semantics as GpuPassTimings: they describe the most
+     * recent frame with results available, which runs a few frames behind the record's
+     * frameId, and are 0 where the backend can't measure them.
+     */
+    struct FrameRecord {
+        uint32_t frameId = 0;           //!< frame id, as passed to the backend
+        uint32_t drawCalls = 0;         //!< draw calls issued to the driver this frame
+        uint32_t instancedDraws = 0;    //!< draw calls folded into instanced draws this frame
+        uint32_t commandArenaBytes = 0; //!< high watermark of the per-frame command arena
+        uint64_t cpuFrameTimeNs = 0;    //!< CPU time between beginFrame() and endFrame()
+        uint64_t gpuShadowPassNs = 0;   //!< GPU time spent in the shadow passes
+        uint64_t gpuColorPassNs = 0;    //!< GPU time spent in the color passes
+        uint64_t gpuPostProcessNs = 0;  //!< GPU time spent in post-processing
+        uint64_t gpuBusyNs = 0;         //!< kernel GPU busy counter, where exposed
+    };
+
+    /**
+     * Drains up to count frame records into records, oldest first, and returns how many
+     * were written. The renderer keeps a short lock-free history (a few dozen frames);
+     * when it fills up because nobody drains it, the newest records are dropped.
+     *
+     * This may be called from any single thread -- typically the application's telemetry
+     * thread -- concurrently with rendering; it never blocks the render thread.
+     *
+     * @param records Destination array, at least count entries.
+     * @param count   Capacity of records.
+     * @return The number of records written.
+     */
+    size_t drainFrameRecords(FrameRecord* records, size_t count) noexcept;
+
     /**
      * Set-up a frame for this Renderer.
      *
@@ -259,8 +338,19 @@ public:
      * beginFrame() attempts to detect this situation and returns false in that case, indicating
      * to the caller to skip the current frame.
      *
+     * beginFrame() integrates with the platform's frame pacing signal when the
+     * application provides it: pass the vsync timestamp delivered by the OS --
+     * Choreographer.FrameCallback's frameTimeNanos on Android, the wake-up time of a
+     * waitable swapchain elsewhere. It is then used as the frame's reference time, and
+     * the skip decision gives the GPU a fraction of the (measured) refresh interval of
+     * grace, so narrowly missing a vsync doesn't drop the frame rate to half.
+     *
      * @param swapChain A pointer to the SwapChain instance to use.
-     * 
+     * @param vsyncSteadyClockTimeNano The time in nanoseconds of when the current frame
+     *                                 started, in the std::chrono::steady_clock
+     *                                 (CLOCK_MONOTONIC) timebase, or 0 to let
+     *                                 beginFrame() read the clock itself.
+     *
      * @return
      *      *false* the current frame must be skipped,
      *      *true* the current frame can be drawn.
@@ -274,7 +364,7 @@ public:
      * @see
      * endFrame()
      */
-    bool beginFrame(SwapChain* swapChain);
+    bool beginFrame(SwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano = 0);
 
     /**
      * Finishes the current frame and schedules it for display.
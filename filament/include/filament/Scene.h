@@ -81,6 +81,21 @@ public:
      */
     void setIndirectLight(IndirectLight const* ibl) noexcept;
 
+    /**
+     * Crossfades the Scene's IndirectLight with a second one.
+     *
+     * Both environments stay bound: their irradiance coefficients and intensities are
+     * blended on the CPU and the prefiltered reflection maps are blended in the shader,
+     * so advancing the transition each frame only costs a few uniform writes. Typically
+     * used to fade between light probes when moving from one room to another.
+     *
+     * @param ibl   The IndirectLight to fade towards, or nullptr to cancel the transition.
+     * @param blend Crossfade factor in [0, 1]; 0 shows only the IndirectLight set with
+     *              setIndirectLight(), 1 shows only @p ibl. To complete a transition,
+     *              call setIndirectLight(ibl) then setIndirectLightBlend(nullptr, 0).
+     */
+    void setIndirectLightBlend(IndirectLight const* ibl, float blend) noexcept;
+
 
     /**
      * Adds an Entity to the Scene.
@@ -93,6 +108,28 @@ public:
      */
     void addEntity(utils::Entity entity);
 
+    /**
+     * Adds a list of Entities to the Scene.
+     *
+     * Equivalent to calling addEntity() on each element, but cheaper when adding many
+     * entities at once (e.g. when streaming-in a world tile).
+     *
+     * @param entities Array of entities to add to the Scene. Cannot be nullptr.
+     * @param count    Number of entities in the array.
+     */
+    void addEntities(const utils::Entity* entities, size_t count);
+
+    /**
+     * Removes a list of Entities from the Scene.
+     *
+     * Equivalent to calling remove() on each element. Entities not in the Scene are
+     * ignored.
+     *
+     * @param entities Array of entities to remove from the Scene. Cannot be nullptr.
+     * @param count    Number of entities in the array.
+     */
+    void removeEntities(const utils::Entity* entities, size_t count);
+
     /**
      * Removes the Renderable from the Scene.
      *
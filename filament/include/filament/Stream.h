@@ -120,6 +120,34 @@ public:
      */
     void setDimensions(uint32_t width, uint32_t height) noexcept;
 
+    /**
+     * Queues the current content of the external texture as a new frame. Use this
+     * from the producer's update path when frames can arrive faster than they are
+     * rendered: the frame is copied into one of three internal slots and tagged with
+     * \p timestampNs, so the producer is never blocked -- when all slots are taken
+     * the oldest unrendered frame is dropped. At Renderer.beginFrame() the newest
+     * queued frame at least the target latency old is selected for rendering (see
+     * setTargetLatency()).
+     *
+     * The Stream must be of type externalTextureId. This function is a no-op
+     * otherwise. Must be called from the Engine's thread.
+     *
+     * @param timestampNs   presentation time of the frame, in the
+     *                      std::chrono::steady_clock timebase (CLOCK_MONOTONIC, the
+     *                      timebase of SurfaceTexture timestamps on Android).
+     */
+    void queueFrame(int64_t timestampNs) noexcept;
+
+    /**
+     * Sets the target latency used to select among frames queued with queueFrame():
+     * the newest frame at least this old is rendered. The default of 0 always picks
+     * the newest queued frame; a latency of roughly one producer frame interval
+     * trades a little delay for even frame pacing.
+     *
+     * @param latencyNs     target latency in nanoseconds
+     */
+    void setTargetLatency(int64_t latencyNs) noexcept;
+
     /**
      * Read-back the content of the last frame of a Stream since the last call to
      * Renderer.beginFrame().
@@ -79,6 +79,18 @@ public:
     using FaceOffsets = driver::FaceOffsets;                        //!< Cube map faces offsets
     using Usage = driver::TextureUsage;                             //!< Usage affects texel layout
 
+    /**
+     * Checks whether a given texture format is natively supported by this Engine's backend.
+     *
+     * Asset pipelines that ship a single compressed format and transcode on devices lacking
+     * it should call this at load time to pick their transcode target (e.g. probe ETC2 first,
+     * then fall back to an uncompressed format), and key any on-disk transcode cache on the
+     * chosen format. The answer is stable for the lifetime of the Engine.
+     *
+     * @param engine Engine to test the format support against
+     * @param format Texture format to check for support
+     * @return true if this format is supported as a texture internal format
+     */
     static bool isTextureFormatSupported(Engine& engine, InternalFormat format) noexcept;
 
     static size_t computeTextureDataSize(Texture::Format format, Texture::Type type,
@@ -111,7 +123,8 @@ public:
 
         /**
          * Specifies the depth in texels of the texture. Doesn't need to be a power-of-two.
-         * This creates a 3D textures.
+         * This creates a 3D texture; for driver::SamplerType::SAMPLER_2D_ARRAY it is
+         * the number of layers instead.
          * @param depth Depth of the texture in texels (default: 1).
          * @return This Builder, for chaining calls.
          */
@@ -128,7 +141,8 @@ public:
 
         /**
          * Specifies whether this texture is a cubemap
-         * @param target either driver::SamplerType::SAMPLER_2D or
+         * @param target either driver::SamplerType::SAMPLER_2D,
+         *                      driver::SamplerType::SAMPLER_2D_ARRAY or
          *                      driver::SamplerType::SAMPLER_CUBEMAP
          * @return This Builder, for chaining calls.
          * @see Sampler
@@ -292,6 +306,26 @@ public:
             uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             PixelBufferDescriptor&& buffer) const noexcept;
 
+    /**
+     * Specify the image of one layer of a 2D array texture for a level.
+     *
+     * @param engine    Engine this texture is associated to.
+     * @param level     Level to set the image for.
+     * @param layer     Layer to set the image for.
+     * @param buffer    Client-side buffer containing the image to set.
+     *
+     * @attention \p engine must be the instance passed to Builder::build()
+     * @attention \p level must be less than getLevels().
+     * @attention \p layer must be less than getDepth().
+     * @attention \p buffer's driver::PixelDataFormat must match that of getFormat().
+     * @attention This Texture instance must use driver::SamplerType::SAMPLER_2D_ARRAY
+     *            or it has no effect
+     *
+     * @see Builder::sampler()
+     */
+    void setImage(Engine& engine, size_t level, size_t layer,
+            PixelBufferDescriptor&& buffer) const noexcept;
+
     /**
      * Specify all six images of a cube map level.
      *
@@ -334,6 +368,29 @@ public:
      */
     void setExternalImage(Engine& engine, void* image) noexcept;
 
+    /**
+     * Specify the hardware buffer holding the external image to associate with this
+     * Texture, for zero-copy sampling of e.g. camera or video frames. Android only,
+     * this is a no-op on other platforms. The same restrictions as with
+     * setExternalImage(Engine&, void*) apply.
+     *
+     * @param engine            Engine this texture is associated to.
+     * @param hardwareBuffer    An AHardwareBuffer. The driver acquires its own reference
+     *                          to the buffer's storage, so the caller may release the
+     *                          buffer as soon as this call returns.
+     * @param fenceFd           A native fence fd signaled by the producer when the
+     *                          buffer's contents are ready, or -1. Ownership of the fd
+     *                          is transferred; the wait happens on the GPU, this call
+     *                          never blocks the calling thread.
+     *
+     * @attention \p engine must be the instance passed to Builder::build()
+     * @attention This Texture instance must use driver::SamplerType::SAMPLER_EXTERNAL or it has no effect
+     *
+     * @see Builder::sampler()
+     *
+     */
+    void setExternalImage(Engine& engine, void* hardwareBuffer, int fenceFd) noexcept;
+
 
     /**
      * Specify the external stream to associate with this Texture. Typically the external
@@ -39,6 +39,7 @@ class UTILS_PUBLIC VertexBuffer : public FilamentAPI {
 public:
     using AttributeType = driver::ElementType;
     using BufferDescriptor = driver::BufferDescriptor;
+    using BufferUsage = driver::Usage;
 
     class Builder : public BuilderBase<BuilderDetails> {
         friend struct BuilderDetails;
@@ -61,8 +62,33 @@ public:
                 uint8_t byteStride = 0) noexcept;     // default is attribute size
 
         // no-op if attribute is an invalid enum
+        // Normalized integer attributes can be used for any slot, including POSITION;
+        // quantized (e.g. SNORM16) positions are remapped to model space with the
+        // per-renderable transform set by RenderableManager::setQuantizedPositionTransform().
         Builder& normalized(VertexAttribute attribute) noexcept;
 
+        /**
+         * Hints how often the buffer content will be re-specified. The default is
+         * BufferUsage::STATIC. Use BufferUsage::STREAM for content generated every
+         * frame (e.g. UI geometry): drivers then multi-buffer the storage so
+         * setBufferAt() doesn't stall on data the GPU is still reading.
+         */
+        Builder& usage(BufferUsage usage) noexcept;
+
+        /**
+         * Enables content-hash deduplication of the GPU storage. Scenes often load
+         * identical meshes through separate asset paths; with dedupe(), vertex buffers
+         * whose declaration and contents match an existing deduplicated buffer share
+         * its GPU storage instead of duplicating it.
+         *
+         * GPU storage creation is deferred until every buffer slot has been populated,
+         * so a deduplicated buffer must have all its slots set with whole-buffer
+         * setBufferAt() calls (byteOffset 0) before it is used with a renderable, and
+         * can't be re-specified afterwards. Only meaningful with BufferUsage::STATIC;
+         * ignored otherwise.
+         */
+        Builder& dedupe() noexcept;
+
         /**
          * Creates the VertexBuffer object and returns a pointer to it.
          *
@@ -290,6 +290,18 @@ public:
      */
     void setShadowsEnabled(bool enabled) noexcept;
 
+    /**
+     * Enable or disable soft shadows (EVSM). Disabled by default.
+     *
+     * When enabled, the shadow map's depth is prefiltered into a mip-chained moments
+     * texture and sampled with hardware trilinear filtering, giving wide, contact-
+     * hardening penumbras at a constant cost, independent of the kernel width.
+     * Requires slightly more memory and bandwidth than the default PCF path.
+     *
+     * @param enabled true enables soft shadows, false uses PCF.
+     */
+    void setSoftShadowsEnabled(bool enabled) noexcept;
+
     /**
      * Specifies which buffers can be discarded before rendering.
      *
@@ -329,6 +341,44 @@ public:
         FXAA = 1
     };
 
+    enum class QualityLevel : int8_t {
+        LOW,
+        MEDIUM,
+        HIGH,
+        ULTRA
+    };
+
+    /**
+     * Structure used to set the quality of the rendering of a View.
+     * @see setRenderQuality()
+     */
+    struct RenderQuality {
+        /**
+         * Sets the quality of the HDR color buffer the scene is rendered into when
+         * post-processing is enabled.
+         *
+         * A quality of HIGH or ULTRA means using an RGB16F or RGBA16F color buffer. This
+         * works well on desktop GPUs. A quality of LOW or MEDIUM means using an
+         * R11F_G11F_B10F opaque color buffer when supported, which trades dynamic range
+         * and precision for bandwidth -- usually the right call on mobile tilers.
+         */
+        QualityLevel hdrColorBuffer = QualityLevel::HIGH;
+    };
+
+    /**
+     * Sets the quality of the rendering of this View, e.g. the precision of intermediate
+     * buffers, allowing quality to be traded for bandwidth per device tier.
+     *
+     * @param renderQuality the quality to use for this View
+     */
+    void setRenderQuality(RenderQuality const& renderQuality) noexcept;
+
+    /**
+     * Returns the render quality set by setRenderQuality().
+     * @return value set by setRenderQuality().
+     */
+    RenderQuality getRenderQuality() const noexcept;
+
     /**
      * Enables or disables in the post-processing stage. Enabled by default.
      *
@@ -379,6 +429,26 @@ public:
      */
     void setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept;
 
+    /**
+     * Sets the shape of the depth-slice distribution used for dynamic-light assignment.
+     *
+     * Light culling divides the [zLightNear, zLightFar] range (see
+     * setDynamicLightingOptions()) into depth slices. By default the slice boundaries
+     * follow an exponential distribution, which concentrates them close to the camera --
+     * the right choice for a first-person camera, but wasteful for e.g. a top-down camera
+     * where the near-field is empty.
+     *
+     * @param power Exponent applied to the normalized slice position. 1.0 (the default)
+     *              gives the standard exponential distribution; values greater than 1
+     *              move slice boundaries away from the camera, improving light-assignment
+     *              precision in the distance; values smaller than 1 concentrate them even
+     *              closer to the camera. Clamped to [0.25, 4].
+     *
+     * This can be changed at runtime at little cost: only derived constants are
+     * recomputed, the culling grid itself is unaffected.
+     */
+    void setFroxelDepthDistribution(float power) noexcept;
+
     /**
      * Enable or disable post processing. Enabled by default.
      *
@@ -397,6 +467,102 @@ public:
 
     bool isPostProcessingEnabled() const noexcept;
 
+    /**
+     * Enables or disables half resolution transparency (disabled by default).
+     *
+     * When enabled, blended primitives are rendered into a separate half resolution
+     * buffer which is then up-sampled and composited over the scene. This reduces the
+     * shading cost of overdraw-heavy transparent effects (smoke, fire, particles) by
+     * about 4x, at the expense of blurring them slightly. Depth occlusion is preserved.
+     *
+     * This is only honored when post-processing is enabled and MSAA is disabled.
+     *
+     * @param enabled true renders blended primitives at half resolution.
+     */
+    void setHalfResolutionTransparencyEnabled(bool enabled) noexcept;
+
+    bool isHalfResolutionTransparencyEnabled() const noexcept;
+
+    /**
+     * Enables or disables caching of this View's rendered frame (disabled by default).
+     *
+     * When enabled, the View keeps its last rendered frame in an off-screen buffer, and
+     * Renderer::render() re-composites that buffer -- instead of re-rendering the View --
+     * as long as its content hasn't changed. This is intended for views whose content
+     * changes rarely relative to the refresh rate, e.g. a UI or HUD View; it trades one
+     * frame's worth of memory for skipping entire render passes.
+     *
+     * The cached frame is invalidated automatically when the Scene's content, the world
+     * transforms or bounds of its renderables, any MaterialInstance parameter, the
+     * camera, or the View's own settings change. Content animated through other channels
+     * (e.g. LightManager parameters or Texture updates) is not tracked; such views
+     * should not enable caching.
+     *
+     * @param enabled true to enable frame caching, false to disable it.
+     */
+    void setCachingEnabled(bool enabled) noexcept;
+
+    //! Returns whether frame caching is enabled. See setCachingEnabled().
+    bool isCachingEnabled() const noexcept;
+
+    /**
+     * Sets the occluder geometry used by the software occlusion-culling stage.
+     *
+     * Occluders are world-space triangle meshes that get rasterized on the CPU into a
+     * low-resolution depth buffer each frame; frustum-visible renderables whose bounding
+     * box is entirely behind them are then culled before any draw commands are generated.
+     * This helps dense scenes (e.g. indoor levels) where large parts of the frustum are
+     * hidden by walls or terrain.
+     *
+     * Depth is sampled at pixel centers, so occluders should be conservative proxies
+     * fully contained within the geometry they stand for -- typically a few dozen
+     * triangles approximating walls, floors or large furniture.
+     *
+     * @param vertices      array of world-space positions. The data is copied.
+     * @param vertexCount   number of vertices in \p vertices.
+     * @param indices       triangle list, three indices per triangle. The data is copied.
+     * @param indexCount    number of indices in \p indices, must be a multiple of 3.
+     *
+     * @note Pass nullptr / 0 to remove the occluder geometry.
+     *
+     * @see setOcclusionCullingEnabled()
+     */
+    void setOccluderGeometry(math::float3 const* vertices, size_t vertexCount,
+            uint32_t const* indices, size_t indexCount) noexcept;
+
+    /**
+     * Enables or disables the software occlusion-culling stage. Disabled by default,
+     * and a no-op until occluder geometry is set with setOccluderGeometry().
+     *
+     * @param enabled true enables occlusion culling, false disables it.
+     */
+    void setOcclusionCullingEnabled(bool enabled) noexcept;
+
+    //! Returns whether occlusion culling is enabled.
+    bool isOcclusionCullingEnabled() const noexcept;
+
+    /**
+     * Enables or disables GPU occlusion culling. Disabled by default.
+     *
+     * When enabled, the depth pre-pass draw of each visible renderable is bracketed by
+     * a GPU occlusion query, and renderables whose query reported no visible samples
+     * skip their (typically much more expensive) color draw. No occluder geometry is
+     * needed: the scene's own depth pre-pass is the occluder, so this complements the
+     * software stage above and is most useful for scenes with high depth complexity.
+     *
+     * Query results are read back without ever stalling the pipeline, at the price of
+     * a couple frames of latency: a renderable that becomes visible again can appear
+     * one frame late. Its depth is still rendered every frame, so errors are bounded
+     * to that. This stage is a no-op when the depth pre-pass is disabled (see
+     * setDepthPrepass()).
+     *
+     * @param enabled true enables GPU occlusion culling, false disables it.
+     */
+    void setGpuOcclusionCullingEnabled(bool enabled) noexcept;
+
+    //! Returns whether GPU occlusion culling is enabled.
+    bool isGpuOcclusionCullingEnabled() const noexcept;
+
     // for debugging...
 
     //! debugging: allows to entirely disable culling. (culling enabled by default).
@@ -23,6 +23,9 @@
 #include <utils/compiler.h>
 
 namespace filament {
+
+class DriverBase;
+
 namespace driver {
 
 class UTILS_PUBLIC BufferDescriptor {
@@ -33,11 +36,32 @@ public:
      */
     using Callback = void(*)(void* buffer, size_t size, void* user);
 
+    /**
+     * A buffer consumed by the engine, as passed to a BatchCallback.
+     */
+    struct Consumed {
+        void* buffer;
+        size_t size;
+        void* user;
+    };
+
+    /**
+     * Callback used to destroy a whole span of consumed buffers at once. Descriptors that share
+     * the same (callback, batchUser) pair and are consumed within the same frame are coalesced
+     * into a single invocation, which amortizes the free path when streaming many small buffers.
+     * It is guaranteed to be called on the main filament thread.
+     */
+    using BatchCallback = void(*)(Consumed const* buffers, size_t count, void* batchUser);
+
     BufferDescriptor() noexcept = default;
 
     ~BufferDescriptor() noexcept {
         if (callback) {
             callback(buffer, size, user);
+        } else if (batchCallback) {
+            // a descriptor destroyed outside the coalescing path sees a span of one
+            Consumed consumed = { buffer, size, user };
+            batchCallback(&consumed, 1, batchUser);
         }
     }
 
@@ -45,9 +69,11 @@ public:
     BufferDescriptor& operator=(const BufferDescriptor& rhs) = delete;
 
     BufferDescriptor(BufferDescriptor&& rhs) noexcept
-        : buffer(rhs.buffer), size(rhs.size), callback(rhs.callback), user(rhs.user) {
+        : buffer(rhs.buffer), size(rhs.size), callback(rhs.callback), user(rhs.user),
+          batchCallback(rhs.batchCallback), batchUser(rhs.batchUser) {
             rhs.buffer = nullptr;
             rhs.callback = nullptr;
+            rhs.batchCallback = nullptr;
     }
 
     BufferDescriptor& operator=(BufferDescriptor&& rhs) noexcept {
@@ -56,8 +82,11 @@ public:
             size = rhs.size;
             callback = rhs.callback;
             user = rhs.user;
+            batchCallback = rhs.batchCallback;
+            batchUser = rhs.batchUser;
             rhs.buffer = nullptr;
             rhs.callback = nullptr;
+            rhs.batchCallback = nullptr;
         }
         return *this;
     }
@@ -67,7 +96,17 @@ public:
                 : buffer(const_cast<void*>(buffer)), size(size), callback(callback), user(user) {
     }
 
-    bool hasCallback() const noexcept { return callback != nullptr; }
+    /**
+     * Sets a callback eligible for coalescing. Mutually exclusive with the per-buffer Callback:
+     * setting one clears the other.
+     */
+    void setBatchCallback(BatchCallback batchCallback, void* batchUser) noexcept {
+        this->callback = nullptr;
+        this->batchCallback = batchCallback;
+        this->batchUser = batchUser;
+    }
+
+    bool hasCallback() const noexcept { return callback != nullptr || batchCallback != nullptr; }
 
 
     Callback getCallback() const noexcept {
@@ -88,9 +127,16 @@ public:
     // no user serviceable parts below ...
 
 private:
+    // DriverBase::purge() coalesces batch callbacks across descriptors.
+    friend class filament::DriverBase;
+
     // callback when the buffer is consumed.
     Callback callback = nullptr;
     void* user = nullptr;
+
+    // alternative coalescable callback, shared by all buffers of a batch
+    BatchCallback batchCallback = nullptr;
+    void* batchUser = nullptr;
 };
 
 } // namespace driver
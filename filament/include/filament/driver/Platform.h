@@ -64,6 +64,13 @@ public:
     virtual void terminate() noexcept = 0;
 
     virtual SwapChain* createSwapChain(void* nativeWindow, uint64_t& flags) noexcept = 0;
+
+    // Creates an offscreen swap chain of the given size, not backed by a native window
+    // (e.g. a pbuffer surface on EGL). Returns nullptr when the platform doesn't
+    // support headless rendering.
+    virtual SwapChain* createSwapChainHeadless(uint32_t width, uint32_t height,
+            uint64_t& flags) noexcept { return nullptr; }
+
     virtual void destroySwapChain(SwapChain* swapChain) noexcept = 0;
 
     // Called to make the OpenGL context active on the calling thread.
@@ -100,6 +107,20 @@ public:
             uint32_t w, uint32_t h, TextureFormat format) noexcept = 0;
 
     virtual void destroyExternalTextureStorage(ExternalTexture* ets) noexcept = 0;
+
+    // Wraps a platform-specific client buffer (AHardwareBuffer on Android) into an
+    // image that can be bound to an external texture without copying its contents.
+    // Returns nullptr when the platform doesn't support importing client buffers.
+    virtual void* createExternalImage(void* clientBuffer) noexcept { return nullptr; }
+
+    // Destroys an image returned by createExternalImage(). The underlying storage
+    // stays alive as long as a texture references it.
+    virtual void destroyExternalImage(void* image) noexcept { }
+
+    // Inserts a server-side wait on a native fence fd into the command stream and
+    // takes ownership of the fd; unlike a client wait this never stalls the calling
+    // thread. Platforms without native fences ignore the fd (it must then be -1).
+    virtual void waitNativeFence(int fenceFd) noexcept { }
 };
 
 class UTILS_PUBLIC VulkanPlatform : public Platform {
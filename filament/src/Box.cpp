@@ -16,6 +16,14 @@
 
 #include <filament/Box.h>
 
+#include <math/compiler.h>
+
+#if defined(MATH_HAS_NEON)
+#include <arm_neon.h>
+#elif defined(MATH_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+
 using namespace math;
 
 namespace filament {
@@ -29,4 +37,108 @@ Box rigidTransform(Box const& UTILS_RESTRICT box, const math::mat3f& UTILS_RESTR
     return { u * box.center, abs(u) * box.halfExtent };
 }
 
+/*
+ * Vectorized form of rigidTransform(): the new center is M * center + translation and
+ * the new half-extent is abs(M) * halfExtent, both plain column-splat multiplies once
+ * the matrix columns are in registers -- abs() is a single sign-bit clear. The vector
+ * loads of a float3 read one float past it, which is only in-bounds while a following
+ * element exists, so the last box always goes through the scalar path.
+ */
+
+#if defined(MATH_HAS_NEON)
+
+void rigidTransformBatch(float3* UTILS_RESTRICT centers, float3* UTILS_RESTRICT halfExtents,
+        const mat4f* UTILS_RESTRICT transforms, size_t count) noexcept {
+    float* UTILS_RESTRICT pc = reinterpret_cast<float*>(centers);
+    float* UTILS_RESTRICT pe = reinterpret_cast<float*>(halfExtents);
+    const float* UTILS_RESTRICT pm = reinterpret_cast<const float*>(transforms);
+    while (count > 1) {
+        const float32x4_t m0 = vld1q_f32(pm);
+        const float32x4_t m1 = vld1q_f32(pm + 4);
+        const float32x4_t m2 = vld1q_f32(pm + 8);
+        const float32x4_t t  = vld1q_f32(pm + 12);
+        const float32x4_t c  = vld1q_f32(pc);
+        const float32x4_t e  = vld1q_f32(pe);
+        float32x4_t rc = vmlaq_lane_f32(t, m0, vget_low_f32(c), 0);
+        rc = vmlaq_lane_f32(rc, m1, vget_low_f32(c), 1);
+        rc = vmlaq_lane_f32(rc, m2, vget_high_f32(c), 0);
+        float32x4_t re = vmulq_lane_f32(vabsq_f32(m0), vget_low_f32(e), 0);
+        re = vmlaq_lane_f32(re, vabsq_f32(m1), vget_low_f32(e), 1);
+        re = vmlaq_lane_f32(re, vabsq_f32(m2), vget_high_f32(e), 0);
+        // store exactly 3 floats: the 4th lane would clobber the next box's
+        // center.x / halfExtent.x, which hasn't been read yet
+        vst1_f32(pc, vget_low_f32(rc));
+        vst1q_lane_f32(pc + 2, rc, 2);
+        vst1_f32(pe, vget_low_f32(re));
+        vst1q_lane_f32(pe + 2, re, 2);
+        pc += 3;
+        pe += 3;
+        pm += 16;
+        count--;
+    }
+    if (count) {
+        float3& center = *reinterpret_cast<float3*>(pc);
+        float3& halfExtent = *reinterpret_cast<float3*>(pe);
+        const Box world = rigidTransform(Box{ center, halfExtent },
+                *reinterpret_cast<const mat4f*>(pm));
+        center = world.center;
+        halfExtent = world.halfExtent;
+    }
+}
+
+#elif defined(MATH_HAS_SSE2)
+
+void rigidTransformBatch(float3* UTILS_RESTRICT centers, float3* UTILS_RESTRICT halfExtents,
+        const mat4f* UTILS_RESTRICT transforms, size_t count) noexcept {
+    float* UTILS_RESTRICT pc = reinterpret_cast<float*>(centers);
+    float* UTILS_RESTRICT pe = reinterpret_cast<float*>(halfExtents);
+    const float* UTILS_RESTRICT pm = reinterpret_cast<const float*>(transforms);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    while (count > 1) {
+        const __m128 m0 = _mm_loadu_ps(pm);
+        const __m128 m1 = _mm_loadu_ps(pm + 4);
+        const __m128 m2 = _mm_loadu_ps(pm + 8);
+        const __m128 t  = _mm_loadu_ps(pm + 12);
+        const __m128 c  = _mm_loadu_ps(pc);
+        const __m128 e  = _mm_loadu_ps(pe);
+        __m128 rc = _mm_add_ps(t, _mm_mul_ps(m0, _mm_shuffle_ps(c, c, 0x00)));
+        rc = _mm_add_ps(rc, _mm_mul_ps(m1, _mm_shuffle_ps(c, c, 0x55)));
+        rc = _mm_add_ps(rc, _mm_mul_ps(m2, _mm_shuffle_ps(c, c, 0xAA)));
+        __m128 re = _mm_mul_ps(_mm_andnot_ps(signMask, m0), _mm_shuffle_ps(e, e, 0x00));
+        re = _mm_add_ps(re, _mm_mul_ps(_mm_andnot_ps(signMask, m1), _mm_shuffle_ps(e, e, 0x55)));
+        re = _mm_add_ps(re, _mm_mul_ps(_mm_andnot_ps(signMask, m2), _mm_shuffle_ps(e, e, 0xAA)));
+        // store exactly 3 floats: the 4th lane would clobber the next box's
+        // center.x / halfExtent.x, which hasn't been read yet
+        _mm_storel_pi(reinterpret_cast<__m64*>(pc), rc);
+        _mm_store_ss(pc + 2, _mm_shuffle_ps(rc, rc, 0xAA));
+        _mm_storel_pi(reinterpret_cast<__m64*>(pe), re);
+        _mm_store_ss(pe + 2, _mm_shuffle_ps(re, re, 0xAA));
+        pc += 3;
+        pe += 3;
+        pm += 16;
+        count--;
+    }
+    if (count) {
+        float3& center = *reinterpret_cast<float3*>(pc);
+        float3& halfExtent = *reinterpret_cast<float3*>(pe);
+        const Box world = rigidTransform(Box{ center, halfExtent },
+                *reinterpret_cast<const mat4f*>(pm));
+        center = world.center;
+        halfExtent = world.halfExtent;
+    }
+}
+
+#else
+
+void rigidTransformBatch(float3* UTILS_RESTRICT centers, float3* UTILS_RESTRICT halfExtents,
+        const mat4f* UTILS_RESTRICT transforms, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        const Box world = rigidTransform(Box{ centers[i], halfExtents[i] }, transforms[i]);
+        centers[i] = world.center;
+        halfExtents[i] = world.halfExtent;
+    }
+}
+
+#endif
+
 } // namespace filament
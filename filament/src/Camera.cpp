@@ -68,11 +68,24 @@ void FCamera::setLensProjection(double focalLength, double near, double far) noe
  * All methods for setting the projection funnel through here
  */
 
+math::mat4 FCamera::getJitteredProjectionMatrix() const noexcept {
+    // the jitter is a translation in clip space (i.e. applied after the projection),
+    // which handles perspective and orthographic projections alike
+    math::mat4 p{ mProjection };
+    const math::double2 jitter = mJitter;
+    for (size_t c = 0; c < 4; c++) {
+        p[c].x += jitter.x * p[c].w;
+        p[c].y += jitter.y * p[c].w;
+    }
+    return p;
+}
+
 void UTILS_NOINLINE FCamera::setCustomProjection(math::mat4 const& p, double near, double far) noexcept {
     mProjectionForCulling = p;
     mProjection = p;
     mNear = (float)near;
     mFar = (float)far;
+    mProjectionGeneration++;
 }
 
 void UTILS_NOINLINE FCamera::setProjection(Camera::Projection projection,
@@ -160,6 +173,7 @@ void UTILS_NOINLINE FCamera::setProjection(Camera::Projection projection,
     mProjection = p;
     mNear = float(near);
     mFar = float(far);
+    mProjectionGeneration++;
 }
 
 void UTILS_NOINLINE FCamera::setModelMatrix(const mat4f& modelMatrix) noexcept {
@@ -180,9 +194,16 @@ mat4f UTILS_NOINLINE FCamera::getViewMatrix() const noexcept {
     return FCamera::getViewMatrix(getModelMatrix());
 }
 
-Frustum FCamera::getFrustum() const noexcept {
+Frustum const& FCamera::getFrustum() const noexcept {
     // for culling purposes we keep the far plane where it is
-    return FCamera::getFrustum(mProjectionForCulling, getViewMatrix());
+    const mat4f viewMatrix{ getViewMatrix() };
+    if (UTILS_UNLIKELY(mFrustumGeneration != mProjectionGeneration
+            || mat4f::fuzzyEqual(mFrustumViewMatrix, viewMatrix))) {
+        mFrustum = FCamera::getFrustum(mProjectionForCulling, viewMatrix);
+        mFrustumViewMatrix = viewMatrix;
+        mFrustumGeneration = mProjectionGeneration;
+    }
+    return mFrustum;
 }
 
 void FCamera::setExposure(float aperture, float shutterSpeed, float sensitivity) noexcept {
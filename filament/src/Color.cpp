@@ -16,9 +16,9 @@
 
 #include <filament/Color.h>
 
-#include <image/ColorTransform.h>
-
+#include <math/fast.h>
 #include <math/mat3.h>
+#include <math/vec4.h>
 
 using namespace math;
 
@@ -27,12 +27,43 @@ namespace filament {
 using xyY = math::float3;
 using XYZ = math::float3;
 
+/*
+ * sRGB transfer functions, with the power curve evaluated on all three channels at
+ * once through the vectorized fast transcendentals. The FAST policy is ~1e-4 off at
+ * worst, well below the 1/255 quantization these colors come from; PRECISE restores
+ * libm accuracy, matching image::sRGBToLinear() / image::linearToSRGB().
+ */
+
+template<fast::Accuracy A>
+static inline float3 transferToLinear(float3 color) noexcept {
+    constexpr float a = 0.055f;
+    constexpr float a1 = 1.055f;
+    const float4 p(fast::pow<A>(float4{ (color + a) * (1.0f / a1), 1.0f }, 2.4f));
+    float3 linear;
+    for (size_t i = 0; i < 3; i++) {
+        linear[i] = color[i] <= 0.04045f ? color[i] * (1.0f / 12.92f) : p[i];
+    }
+    return linear;
+}
+
+template<fast::Accuracy A>
+static inline float3 transferToSRGB(float3 color) noexcept {
+    constexpr float a = 0.055f;
+    constexpr float a1 = 1.055f;
+    const float4 p(fast::pow<A>(float4{ color, 1.0f }, 1.0f / 2.4f));
+    float3 sRGB;
+    for (size_t i = 0; i < 3; i++) {
+        sRGB[i] = color[i] <= 0.0031308f ? color[i] * 12.92f : a1 * p[i] - a;
+    }
+    return sRGB;
+}
+
 float3 Color::sRGBToLinear(float3 color) noexcept {
-    return image::sRGBToLinear(color);
+    return transferToLinear<fast::Accuracy::FAST>(color);
 }
 
 float3 Color::linearToSRGB(float3 color) noexcept {
-    return image::linearToSRGB(color);
+    return transferToSRGB<fast::Accuracy::FAST>(color);
 }
 
 static inline constexpr XYZ xyY_to_XYZ(xyY const& v) {
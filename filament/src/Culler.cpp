@@ -18,12 +18,28 @@
 
 #include <math/fast.h>
 
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#   include <arm_neon.h>
+#   define FILAMENT_CULLER_NEON 1
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#   define FILAMENT_CULLER_SSE 1
+#endif
+
 using namespace math;
 
 namespace filament {
 namespace details {
 
-void Culler::intersects(
+/*
+ * Scalar reference paths. These are compiled unconditionally -- even when a SIMD path
+ * is selected below -- so the conformance tests and the benchmark harness can compare
+ * the vectorized results and costs against them on the same machine (see
+ * Culler::Test::intersectsScalar() and filament_test.cpp).
+ */
+
+UTILS_NOINLINE
+void Culler::intersectsScalar(
         result_type* UTILS_RESTRICT results,
         Frustum const& UTILS_RESTRICT frustum,
         math::float4 const* UTILS_RESTRICT b,
@@ -31,10 +47,11 @@ void Culler::intersects(
 
     math::float4 const * const UTILS_RESTRICT planes = frustum.mPlanes;
 
+    count = round(count); // capacity guaranteed to be multiple of 8
+
     // we use a vectorize width of 8 because, on ARMv8 it allow the compiler to write 8
     // 8-bits results in one go. Without this it has to do 4 separate byte writes, which
     // ends-up being slower.
-    count = round(count); // capacity guaranteed to be multiple of 8
     #pragma clang loop vectorize_width(8)
     for (size_t i = 0; i < count; i++) {
         int visible = ~0;
@@ -54,7 +71,8 @@ void Culler::intersects(
     }
 }
 
-void Culler::intersects(
+UTILS_NOINLINE
+void Culler::intersectsScalar(
         result_type* UTILS_RESTRICT results,
         Frustum const& UTILS_RESTRICT frustum,
         math::float3 const* UTILS_RESTRICT center,
@@ -63,10 +81,11 @@ void Culler::intersects(
 
     math::float4 const * UTILS_RESTRICT const planes = frustum.mPlanes;
 
+    count = round(count); // capacity guaranteed to be multiple of 8
+
     // we use a vectorize width of 8 because, on ARMv8 it allows the compiler to write eight
     // 8-bits results in one go. Without this it has to do 4 separate byte writes, which
     // ends-up being slower.
-    count = round(count); // capacity guaranteed to be multiple of 8
     #pragma clang loop vectorize_width(8)
     for (size_t i = 0; i < count; i++) {
         int visible = ~0;
@@ -88,6 +107,194 @@ void Culler::intersects(
     }
 }
 
+void Culler::intersects(
+        result_type* UTILS_RESTRICT results,
+        Frustum const& UTILS_RESTRICT frustum,
+        math::float4 const* UTILS_RESTRICT b,
+        size_t count) noexcept {
+
+#if defined(FILAMENT_CULLER_NEON) || defined(FILAMENT_CULLER_SSE)
+    math::float4 const * const UTILS_RESTRICT planes = frustum.mPlanes;
+
+    count = round(count); // capacity guaranteed to be multiple of 8
+#endif
+
+#if defined(FILAMENT_CULLER_NEON)
+
+    // splat each plane coefficient so the inner loop is pure vector FMAs
+    float32x4_t px[6], py[6], pz[6], pw[6];
+    for (size_t j = 0; j < 6; j++) {
+        px[j] = vdupq_n_f32(planes[j].x);
+        py[j] = vdupq_n_f32(planes[j].y);
+        pz[j] = vdupq_n_f32(planes[j].z);
+        pw[j] = vdupq_n_f32(planes[j].w);
+    }
+    for (size_t i = 0; i < count; i += 4) {
+        // de-interleave 4 spheres into x, y, z, w lanes
+        float32x4x4_t const s = vld4q_f32(reinterpret_cast<float const*>(b + i));
+        uint32x4_t visible = vdupq_n_u32(~0u);
+        for (size_t j = 0; j < 6; j++) {
+            float32x4_t dot = vfmaq_f32(pw[j], px[j], s.val[0]);
+            dot = vfmaq_f32(dot, py[j], s.val[1]);
+            dot = vfmaq_f32(dot, pz[j], s.val[2]);
+            dot = vsubq_f32(dot, s.val[3]);
+            visible = vandq_u32(visible, vcltq_f32(dot, vdupq_n_f32(0.0f)));
+        }
+        uint32_t v[4];
+        vst1q_u32(v, vandq_u32(visible, vdupq_n_u32(1u)));
+        results[i + 0] = result_type(v[0]);
+        results[i + 1] = result_type(v[1]);
+        results[i + 2] = result_type(v[2]);
+        results[i + 3] = result_type(v[3]);
+    }
+
+#elif defined(FILAMENT_CULLER_SSE)
+
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (size_t j = 0; j < 6; j++) {
+        px[j] = _mm_set1_ps(planes[j].x);
+        py[j] = _mm_set1_ps(planes[j].y);
+        pz[j] = _mm_set1_ps(planes[j].z);
+        pw[j] = _mm_set1_ps(planes[j].w);
+    }
+    for (size_t i = 0; i < count; i += 4) {
+        float const* const p = reinterpret_cast<float const*>(b + i);
+        __m128 x = _mm_loadu_ps(p +  0);
+        __m128 y = _mm_loadu_ps(p +  4);
+        __m128 z = _mm_loadu_ps(p +  8);
+        __m128 w = _mm_loadu_ps(p + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(~0));
+        for (size_t j = 0; j < 6; j++) {
+            __m128 dot = _mm_add_ps(_mm_mul_ps(px[j], x), pw[j]);
+            dot = _mm_add_ps(dot, _mm_mul_ps(py[j], y));
+            dot = _mm_add_ps(dot, _mm_mul_ps(pz[j], z));
+            dot = _mm_sub_ps(dot, w);
+            visible = _mm_and_ps(visible, _mm_cmplt_ps(dot, _mm_setzero_ps()));
+        }
+        alignas(16) uint32_t v[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(v),
+                _mm_and_si128(_mm_castps_si128(visible), _mm_set1_epi32(1)));
+        results[i + 0] = result_type(v[0]);
+        results[i + 1] = result_type(v[1]);
+        results[i + 2] = result_type(v[2]);
+        results[i + 3] = result_type(v[3]);
+    }
+
+#else
+
+    intersectsScalar(results, frustum, b, count);
+
+#endif
+}
+
+void Culler::intersects(
+        result_type* UTILS_RESTRICT results,
+        Frustum const& UTILS_RESTRICT frustum,
+        math::float3 const* UTILS_RESTRICT center,
+        math::float3 const* UTILS_RESTRICT extent,
+        size_t count, size_t bit) noexcept {
+
+#if defined(FILAMENT_CULLER_NEON) || defined(FILAMENT_CULLER_SSE)
+    math::float4 const * UTILS_RESTRICT const planes = frustum.mPlanes;
+
+    count = round(count); // capacity guaranteed to be multiple of 8
+#endif
+
+#if defined(FILAMENT_CULLER_NEON)
+
+    // splat the plane coefficients -- and their absolute value for the extent term --
+    // so the inner loop is pure vector FMAs
+    float32x4_t px[6], py[6], pz[6], pw[6];
+    float32x4_t ax[6], ay[6], az[6];
+    for (size_t j = 0; j < 6; j++) {
+        px[j] = vdupq_n_f32(planes[j].x);
+        py[j] = vdupq_n_f32(planes[j].y);
+        pz[j] = vdupq_n_f32(planes[j].z);
+        pw[j] = vdupq_n_f32(planes[j].w);
+        ax[j] = vabsq_f32(px[j]);
+        ay[j] = vabsq_f32(py[j]);
+        az[j] = vabsq_f32(pz[j]);
+    }
+    uint32x4_t const mask = vdupq_n_u32(1u << bit);
+    for (size_t i = 0; i < count; i += 4) {
+        // vld3 de-interleaves the float3 AoS layout into x, y, z lanes directly
+        float32x4x3_t const c = vld3q_f32(reinterpret_cast<float const*>(center + i));
+        float32x4x3_t const e = vld3q_f32(reinterpret_cast<float const*>(extent + i));
+        uint32x4_t visible = vdupq_n_u32(~0u);
+        for (size_t j = 0; j < 6; j++) {
+            float32x4_t dot = vfmaq_f32(pw[j], px[j], c.val[0]);
+            dot = vfmsq_f32(dot, ax[j], e.val[0]);
+            dot = vfmaq_f32(dot, py[j], c.val[1]);
+            dot = vfmsq_f32(dot, ay[j], e.val[1]);
+            dot = vfmaq_f32(dot, pz[j], c.val[2]);
+            dot = vfmsq_f32(dot, az[j], e.val[2]);
+            visible = vandq_u32(visible, vcltq_f32(dot, vdupq_n_f32(0.0f)));
+        }
+        uint32_t v[4];
+        vst1q_u32(v, vandq_u32(visible, mask));
+        results[i + 0] |= result_type(v[0]);
+        results[i + 1] |= result_type(v[1]);
+        results[i + 2] |= result_type(v[2]);
+        results[i + 3] |= result_type(v[3]);
+    }
+
+#elif defined(FILAMENT_CULLER_SSE)
+
+    __m128 px[6], py[6], pz[6], pw[6];
+    __m128 ax[6], ay[6], az[6];
+    __m128 const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (size_t j = 0; j < 6; j++) {
+        px[j] = _mm_set1_ps(planes[j].x);
+        py[j] = _mm_set1_ps(planes[j].y);
+        pz[j] = _mm_set1_ps(planes[j].z);
+        pw[j] = _mm_set1_ps(planes[j].w);
+        ax[j] = _mm_and_ps(px[j], absMask);
+        ay[j] = _mm_and_ps(py[j], absMask);
+        az[j] = _mm_and_ps(pz[j], absMask);
+    }
+    __m128i const mask = _mm_set1_epi32(1 << bit);
+    for (size_t i = 0; i < count; i += 4) {
+        // transpose 4 float3 from AoS to SoA (x, y, z lanes)
+        auto const load3 = [](float const* p, __m128& x, __m128& y, __m128& z) {
+            __m128 const v0 = _mm_loadu_ps(p + 0);      // x0 y0 z0 x1
+            __m128 const v1 = _mm_loadu_ps(p + 4);      // y1 z1 x2 y2
+            __m128 const v2 = _mm_loadu_ps(p + 8);      // z2 x3 y3 z3
+            __m128 const t0 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 1, 3, 2)); // x2 y2 x3 y3
+            __m128 const t1 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 2, 1)); // y0 z0 y1 z1
+            x = _mm_shuffle_ps(v0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+            y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+            z = _mm_shuffle_ps(t1, v2, _MM_SHUFFLE(3, 0, 3, 1));
+        };
+        __m128 cx, cy, cz, ex, ey, ez;
+        load3(reinterpret_cast<float const*>(center + i), cx, cy, cz);
+        load3(reinterpret_cast<float const*>(extent + i), ex, ey, ez);
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(~0));
+        for (size_t j = 0; j < 6; j++) {
+            __m128 dot = _mm_add_ps(_mm_mul_ps(px[j], cx), pw[j]);
+            dot = _mm_sub_ps(dot, _mm_mul_ps(ax[j], ex));
+            dot = _mm_add_ps(dot, _mm_mul_ps(py[j], cy));
+            dot = _mm_sub_ps(dot, _mm_mul_ps(ay[j], ey));
+            dot = _mm_add_ps(dot, _mm_mul_ps(pz[j], cz));
+            dot = _mm_sub_ps(dot, _mm_mul_ps(az[j], ez));
+            visible = _mm_and_ps(visible, _mm_cmplt_ps(dot, _mm_setzero_ps()));
+        }
+        alignas(16) uint32_t v[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(v),
+                _mm_and_si128(_mm_castps_si128(visible), mask));
+        results[i + 0] |= result_type(v[0]);
+        results[i + 1] |= result_type(v[1]);
+        results[i + 2] |= result_type(v[2]);
+        results[i + 3] |= result_type(v[3]);
+    }
+
+#else
+
+    intersectsScalar(results, frustum, center, extent, count, bit);
+
+#endif
+}
+
 /*
  * returns whether a box intersects with the frustum
  */
@@ -104,6 +311,38 @@ bool Culler::intersects(Frustum const& frustum, Box const& box) noexcept {
     return bool(results[0]);
 }
 
+/*
+ * returns whether a box oriented by a rigid transform intersects with the frustum
+ *
+ * This is the exact separating-axis test against the frustum planes: the box's half-extents
+ * are projected onto each plane normal along the box's own (rotated) axes, instead of being
+ * inflated into a world-space AABB first. Unlike the routines above this is a per-object
+ * test -- oriented boxes don't share axes, so there are no common lanes to vectorize across
+ * objects -- but the plane loop is fully unrolled and branchless.
+ */
+bool Culler::intersectsOriented(Frustum const& frustum,
+        Box const& box, math::mat4f const& model) noexcept {
+    float4 const* UTILS_RESTRICT const planes = frustum.mPlanes;
+
+    // assumes a rigid transform (rotation and translation only), like Box::rigidTransform()
+    const mat3f u(model.upperLeft());
+    const float3 center = u * box.center + model[3].xyz;
+    const float3 ax = u[0] * box.halfExtent.x;
+    const float3 ay = u[1] * box.halfExtent.y;
+    const float3 az = u[2] * box.halfExtent.z;
+
+    int visible = ~0;
+
+    #pragma clang loop unroll(full)
+    for (size_t j = 0; j < 6; j++) {
+        const float3 n = planes[j].xyz;
+        const float r = std::abs(dot(n, ax)) + std::abs(dot(n, ay)) + std::abs(dot(n, az));
+        const float d = dot(n, center) + planes[j].w - r;
+        visible &= fast::signbit(d);
+    }
+    return bool(visible);
+}
+
 /*
  * returns whether an sphere intersects with the frustum
  */
@@ -135,5 +374,21 @@ void Culler::Test::intersects(
     Culler::intersects(results, frustum, b, count);
 }
 
+void Culler::Test::intersectsScalar(
+        result_type* UTILS_RESTRICT results,
+        Frustum const& UTILS_RESTRICT frustum,
+        math::float3 const* UTILS_RESTRICT c,
+        math::float3 const* UTILS_RESTRICT e,
+        size_t count) noexcept {
+    Culler::intersectsScalar(results, frustum, c, e, count, 0);
+}
+
+void Culler::Test::intersectsScalar(
+        result_type* UTILS_RESTRICT results,
+        Frustum const& UTILS_RESTRICT frustum,
+        math::float4 const* UTILS_RESTRICT b, size_t count) noexcept {
+    Culler::intersectsScalar(results, frustum, b, count);
+}
+
 } // namespace details
 } // namespace filament
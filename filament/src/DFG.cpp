@@ -16,21 +16,24 @@
 
 #include "details/DFG.h"
 
+#include "EngineImage.h"
+
 #include "details/Engine.h"
 #include "details/Texture.h"
 
 namespace filament {
 namespace details {
 
-const uint16_t DFG::DFG_LUT[] = {
-#include "generated/data/dfg.inc"
-};
-
 DFG::DFG(FEngine& engine) noexcept : mEngine(engine) {
     constexpr size_t fp16Count = DFG_LUT_SIZE * DFG_LUT_SIZE * 2;
     constexpr size_t byteCount = fp16Count * sizeof(uint16_t);
 
-    static_assert(sizeof(DFG_LUT) == byteCount, "DFG_LUT_SIZE doesn't match size of the DFG LUT");
+    static_assert(DFG_LUT_SIZE == EngineImage::DFG_LUT_SIZE,
+            "DFG_LUT_SIZE doesn't match the engine image");
+
+    // the LUT lives in the engine image and is uploaded in place, without a copy
+    EngineImage const& image = getEngineImage();
+    assert(image.dfgLut.size == byteCount);
 
     Texture* lut = Texture::Builder()
             .width(DFG_LUT_SIZE)
@@ -38,7 +41,7 @@ DFG::DFG(FEngine& engine) noexcept : mEngine(engine) {
             .format(driver::TextureFormat::RG16F)
             .build(mEngine);
 
-    Texture::PixelBufferDescriptor buffer(DFG_LUT, byteCount, Texture::Format::RG,
+    Texture::PixelBufferDescriptor buffer(image.dfgLut.data, byteCount, Texture::Format::RG,
             Texture::Type::HALF);
 
     lut->setImage(mEngine, 0, std::move(buffer));
@@ -47,6 +47,24 @@ void FDebugRegistry::registerProperty(utils::StaticString name, void *p, Type ty
     mPropertyMap[name] = p;
 }
 
+void FDebugRegistry::registerCounter(utils::StaticString name,
+        std::atomic<uint64_t>* counter) noexcept {
+    mCounterAddresses.push_back(counter);
+    mCounters.push_back({ name.c_str(), 0 });
+}
+
+void FDebugRegistry::snapshotCounters() noexcept {
+    auto const& addresses = mCounterAddresses;
+    for (size_t i = 0, n = addresses.size(); i < n; i++) {
+        mCounters[i].value = addresses[i]->load(std::memory_order_relaxed);
+    }
+}
+
+inline std::pair<DebugRegistry::Counter const*, size_t>
+FDebugRegistry::getCounters() const noexcept {
+    return { mCounters.data(), mCounters.size() };
+}
+
 inline std::pair<DebugRegistry::Property const *, size_t> FDebugRegistry::getProperties() const noexcept {
     return {mProperties.data(), mProperties.size()};
 }
@@ -89,6 +107,10 @@ std::pair<DebugRegistry::Property const*, size_t> DebugRegistry::getProperties()
     return upcast(this)->getProperties();
 }
 
+std::pair<DebugRegistry::Counter const*, size_t> DebugRegistry::getCounters() const noexcept {
+    return upcast(this)->getCounters();
+}
+
 bool DebugRegistry::hasProperty(const char* name) const noexcept {
     return upcast(this)->hasProperty(name);
 }
@@ -32,8 +32,9 @@
 #include "details/Texture.h"
 #include "details/View.h"
 #include "driver/Program.h"
+#include "driver/UniformBufferBatch.h"
 
-#include "PrecompiledMaterials.h"
+#include "EngineImage.h"
 
 #include <filament/Exposure.h>
 
@@ -52,7 +53,11 @@
 #include <math/fast.h>
 #include <math/scalar.h>
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <mutex>
 
 #include <stdio.h>
 
@@ -113,18 +118,6 @@ FEngine* FEngine::create(Backend backend, Platform* platform, void* sharedGLCont
     return instance;
 }
 
-UniformInterfaceBlock FEngine::PerViewUib::getUib() noexcept {
-    return UibGenerator::getPerViewUib();
-}
-
-UniformInterfaceBlock FEngine::PerRenderableUib::getUib() noexcept {
-    return UibGenerator::getPerRenderableUib();
-}
-
-UniformInterfaceBlock FEngine::PostProcessingUib::getUib() noexcept {
-    return UibGenerator::getPostProcessingUib();
-}
-
 SamplerInterfaceBlock FEngine::PerViewSib::getSib() noexcept {
     return SibGenerator::getPerViewSib();
 }
@@ -133,16 +126,6 @@ SamplerInterfaceBlock FEngine::PostProcessSib::getSib() noexcept {
     return SibGenerator::getPostProcessSib();
 }
 
-// these must be static because only a pointer is copied to the render stream
-static const half4 sFullScreenTriangleVertices[3] = {
-        { -1.0_h, -1.0_h, 1.0_h, 1.0_h },
-        {  3.0_h, -1.0_h, 1.0_h, 1.0_h },
-        { -1.0_h,  3.0_h, 1.0_h, 1.0_h }
-};
-
-// these must be static because only a pointer is copied to the render stream
-static const uint16_t sFullScreenTriangleIndices[3] = { 0, 1, 2 };
-
 FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext) :
         mBackend(backend),
         mPlatform(platform),
@@ -158,6 +141,7 @@ FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext) :
         mPostProcessUib(PostProcessingUib::getUib()),
         mPostProcessSib(PostProcessSib::getSib()),
         mCommandBufferQueue(CONFIG_MIN_COMMAND_BUFFERS_SIZE, CONFIG_COMMAND_BUFFERS_SIZE),
+        mResourceQueue(CONFIG_MIN_COMMAND_BUFFERS_SIZE, CONFIG_COMMAND_BUFFERS_SIZE),
         mPerRenderPassAllocator("per-renderpass allocator", CONFIG_PER_RENDER_PASS_ARENA_SIZE),
         mEpoch(std::chrono::steady_clock::now()),
         mDriverBarrier(1)
@@ -177,15 +161,26 @@ FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext) :
 void FEngine::init() {
     // this must be first.
     mCommandStream = CommandStream(*mDriver, mCommandBufferQueue.getCircularBuffer());
+    mResourceStream = CommandStream(*mDriver, mResourceQueue.getCircularBuffer());
     DriverApi& driverApi = getDriverApi();
 
-    // Parse all post process shaders now, but create them lazily
+    // everything FEngine::init() consumes lives in the engine image, which is compiled into
+    // the library; parsers and buffer descriptors below point directly into it, no copies
+    EngineImage const& image = getEngineImage();
+
+    // Parse all post process shaders in the background, create them lazily. This is pure CPU
+    // work on memory compiled into the library, so it doesn't need the driver -- it only has
+    // to be complete before the first program is requested (see completeInit()).
     mPostProcessParser = std::make_unique<filaflat::MaterialParser>(mBackend,
-            POST_PROCESS_PACKAGE, POST_PROCESS_PACKAGE_SIZE);
+            image.postProcessPackage.data, image.postProcessPackage.size, false /* copy */);
 
-    UTILS_UNUSED_IN_RELEASE bool ppMaterialOk =
-            mPostProcessParser->parse() && mPostProcessParser->isPostProcessMaterial();
-    assert(ppMaterialOk);
+    JobSystem& js = mJobSystem;
+    mDeferredInitJob = js.createJob();
+    js.run(js.createJob(mDeferredInitJob, [this](JobSystem&, JobSystem::Job*) {
+        UTILS_UNUSED_IN_RELEASE bool ppMaterialOk =
+                mPostProcessParser->parse() && mPostProcessParser->isPostProcessMaterial();
+        assert(ppMaterialOk);
+    }));
 
     mFullScreenTriangleVb = upcast(VertexBuffer::Builder()
             .vertexCount(3)
@@ -194,7 +189,7 @@ void FEngine::init() {
             .build(*this));
 
     mFullScreenTriangleVb->setBufferAt(*this, 0,
-            { sFullScreenTriangleVertices, sizeof(sFullScreenTriangleVertices) });
+            { image.fullScreenTriangleVertices.data, image.fullScreenTriangleVertices.size });
 
     mFullScreenTriangleIb = upcast(IndexBuffer::Builder()
             .indexCount(3)
@@ -202,7 +197,7 @@ void FEngine::init() {
             .build(*this));
 
     mFullScreenTriangleIb->setBuffer(*this,
-            { sFullScreenTriangleIndices, sizeof(sFullScreenTriangleIndices) });
+            { image.fullScreenTriangleIndices.data, image.fullScreenTriangleIndices.size });
 
     mFullScreenTriangleRph = driverApi.createRenderPrimitive();
     driverApi.setRenderPrimitiveBuffer(mFullScreenTriangleRph,
@@ -232,15 +227,58 @@ void FEngine::init() {
             .intensity(1.0f)
             .build(*this));
 
+    mDebugRegistry.registerProperty("d.variants.used", &debug.variants.used);
+
+    // occupancy of the backend's device-memory sub-allocator (all zeroes on backends
+    // that don't sub-allocate)
+    Driver::GpuAllocatorStats& allocatorStats = mDriver->getGpuAllocatorStats();
+    mDebugRegistry.registerProperty("d.driver.gpu_blocks", &allocatorStats.blockCount);
+    mDebugRegistry.registerProperty("d.driver.gpu_allocations", &allocatorStats.allocationCount);
+    mDebugRegistry.registerProperty("d.driver.gpu_used_mb", &allocatorStats.usedMegabytes);
+    mDebugRegistry.registerProperty("d.driver.gpu_unused_mb", &allocatorStats.unusedMegabytes);
+
+    mDebugRegistry.registerCounter("c.renderer.draw_calls", &counters.drawCalls);
+    mDebugRegistry.registerCounter("c.renderer.instanced_draws", &counters.instancedDraws);
+    mDebugRegistry.registerCounter("c.rtpool.hits", &counters.rtPoolHits);
+    mDebugRegistry.registerCounter("c.rtpool.misses", &counters.rtPoolMisses);
+
+    // accumulated GPU busy time and memory-bus traffic, read from the kernel's GPU
+    // counters where exposed (tile-based mobile GPUs); both stay at zero elsewhere
+    mDebugRegistry.registerCounter("c.gpu.busy_ns", &counters.gpuBusyNs);
+    mDebugRegistry.registerCounter("c.gpu.mem_bytes", &counters.gpuMemoryBytes);
+
     mPostProcessManager.init(*this);
     mRenderTargetPool.init(*this);
     mLightManager.init(*this);
+
+    // The DFG and the default material are not needed until something is actually rendered;
+    // building them here would serialize a material parse and texture upload into
+    // Engine::create(). They're created on first use instead (see completeInit()), which
+    // overlaps their cost with the application's own asset loading.
+}
+
+/*
+ * Deferred tail of init(). Runs on the main thread, on first use of the DFG, the default
+ * material or a post-process program -- i.e. at the latest when the first frame is rendered.
+ */
+void FEngine::completeInit() noexcept {
+    if (mInitCompleted) {
+        return;
+    }
+    mInitCompleted = true;
+
+    // make sure the background parse of the post-process package is done
+    mJobSystem.runAndWait(mDeferredInitJob);
+    mDeferredInitJob = nullptr;
+
     mDFG.reset(new DFG(*this));
 
+    EngineImage const& image = getEngineImage();
+
     // Always initialize the default material, most materials' depth shaders fallback on it.
     mDefaultMaterial = upcast(
             FMaterial::DefaultMaterialBuilder()
-                    .package(DEFAULT_MATERIAL_PACKAGE, DEFAULT_MATERIAL_PACKAGE_SIZE)
+                    .package(image.defaultMaterialPackage.data, image.defaultMaterialPackage.size)
                     .build(*const_cast<FEngine*>(this)));
 }
 
@@ -261,13 +299,22 @@ void FEngine::shutdown() {
 
     DriverApi& driver = getDriverApi();
 
+    // if nothing was ever rendered, the deferred part of init() may still be pending
+    if (mDeferredInitJob) {
+        mJobSystem.runAndWait(mDeferredInitJob);
+        mDeferredInitJob = nullptr;
+    }
+
     /*
      * Destroy our own state first
      */
 
     mPostProcessManager.terminate(driver);  // free-up post-process manager resources
     mRenderTargetPool.terminate(driver);    // free-up all offscreen render targets
-    mDFG->terminate();                      // free-up the DFG
+    mTextureArrayPacker.terminate(*this);   // free-up the shared texture arrays
+    if (mDFG) {
+        mDFG->terminate();                  // free-up the DFG
+    }
     mRenderableManager.terminate();         // free-up all renderables
     mLightManager.terminate();              // free-up all lights
     mCameraManager.terminate();             // free-up all cameras
@@ -309,10 +356,14 @@ void FEngine::shutdown() {
         driver.destroyProgram(mPostProcessPrograms[i]);
     }
 
-    // There might be commands added by the terminate() calls
+    // There might be commands added by the terminate() calls; resources routed to the
+    // background queue destroy themselves there, so it must be flushed too -- the driver
+    // thread drains it after the main queue exits (see loop()).
+    flushCommandBuffer(mResourceQueue);
     flushCommandBuffer(mCommandBufferQueue);
     if (!UTILS_HAS_THREADING) {
         execute();
+        executeResourceCommands(false);
     }
 
     /*
@@ -327,14 +378,83 @@ void FEngine::shutdown() {
     // detach this thread from the jobsystem
     mJobSystem.emancipate();
 
+    // free the upload arena; at this point all descriptors have been consumed, so every
+    // buffer handed out by uploadAlloc() is back in the pool
+    for (auto const& item : mUploadPool) {
+        free(item.second);
+    }
+    mUploadPool.clear();
+    mUploadPoolSize = 0;
+
     mTerminated = true;
 }
 
+void FEngine::deferProgramBuild(FMaterial const* material, uint8_t variantKey) noexcept {
+    std::lock_guard<utils::LockingPolicy::SpinLock> guard(mDeferredProgramBuildsLock);
+    mDeferredProgramBuilds.emplace_back(material, variantKey);
+}
+
+void FEngine::cancelDeferredProgramBuilds(FMaterial const* material) noexcept {
+    std::lock_guard<utils::LockingPolicy::SpinLock> guard(mDeferredProgramBuildsLock);
+    auto& builds = mDeferredProgramBuilds;
+    builds.erase(std::remove_if(builds.begin(), builds.end(),
+            [material](auto const& item) { return item.first == material; }), builds.end());
+}
+
+void FEngine::buildDeferredPrograms() noexcept {
+    // a new frame starts here, reset the program build budget
+    mProgramBuildsThisFrame.store(0, std::memory_order_relaxed);
+    std::lock_guard<utils::LockingPolicy::SpinLock> guard(mDeferredProgramBuildsLock);
+    auto& builds = mDeferredProgramBuilds;
+    size_t i = 0;
+    while (i < builds.size() && hasProgramBuildBudget()) {
+        FMaterial const* const material = builds[i].first;
+        const uint8_t variantKey = builds[i].second;
+        // the variant may have been built already (e.g. queued twice from different
+        // primitives), in which case it doesn't count against the budget
+        if (!material->isProgramCached(variantKey)) {
+            material->buildProgram(variantKey);
+        }
+        ++i;
+    }
+    // anything past the budget stays queued for the next frame
+    builds.erase(builds.begin(), builds.begin() + i);
+}
+
 void FEngine::prepare() {
     SYSTRACE_CALL();
+    // process the program builds we deferred during the previous frame, before the
+    // uniform updates below, so the driver thread gets to them as early as possible
+    buildDeferredPrograms();
     // prepare() is called once per Renderer frame. Ideally we would upload the content of
     // UBOs that are visible only. It's not such a big issue because the actual upload() is
     // skipped is the UBO hasn't changed. Still we could have a lot of these.
+    //
+    // All dirty uniform blocks are packed into a single staging buffer and uploaded
+    // with one driver command, instead of one command per material instance.
+    UniformBufferBatch batch;
+    for (auto& materialInstanceList : mMaterialInstances) {
+        for (auto& item : materialInstanceList.second) {
+            if (item->getUniformBuffer().isDirty()) {
+                batch.reserve(item->getUniformBuffer());
+            }
+        }
+    }
+    if (batch.count()) {
+        batch.begin();
+        for (auto& materialInstanceList : mMaterialInstances) {
+            for (auto& item : materialInstanceList.second) {
+                UniformBuffer const& ub = item->getUniformBuffer();
+                if (ub.isDirty()) {
+                    batch.append(item->getUniformBufferHandle(), ub);
+                    ub.clean(); // clean AFTER we copied into the staging buffer
+                }
+            }
+        }
+        batch.commit(getDriverApi());
+    }
+    // the uniforms are clean at this point, so this only commits dirty sampler buffers
+    // (which are uncommon and can't be batched this way)
     for (auto& materialInstanceList : mMaterialInstances) {
         for (auto& item : materialInstanceList.second) {
             item->commit(*this);
@@ -364,6 +484,43 @@ void FEngine::flush() {
     flushCommandBuffer(mCommandBufferQueue);
 }
 
+void FEngine::flushResourceCommands() {
+    flushCommandBuffer(mResourceQueue);
+    // the driver thread only sleeps on the main queue; post a no-op command there so it
+    // notices the new resource work even when no frame is in flight
+    mCommandStream.queueCommand([]() {});
+    flushCommandBuffer(mCommandBufferQueue);
+}
+
+void FEngine::executeResourceCommands(bool frameActive) noexcept {
+    auto& pending = mPendingResourceBuffers;
+    auto buffers = mResourceQueue.tryGetCommands();
+    pending.insert(pending.end(), buffers.begin(), buffers.end());
+    if (pending.empty()) {
+        return;
+    }
+
+    // when a frame is in flight we only use the slack published by the renderer,
+    // otherwise we drain everything. We always make progress by at least one slice.
+    int64_t const budget = frameActive
+            ? mResourceTimeSliceNs.load(std::memory_order_relaxed)
+            : std::numeric_limits<int64_t>::max();
+
+    auto const start = clock::now();
+    size_t executed = 0;
+    for (auto& item : pending) {
+        if (UTILS_LIKELY(item.begin)) {
+            mResourceStream.execute(item.begin);
+            mResourceQueue.releaseBuffer(item);
+        }
+        executed++;
+        if (std::chrono::nanoseconds(clock::now() - start).count() >= budget) {
+            break;
+        }
+    }
+    pending.erase(pending.begin(), pending.begin() + executed);
+}
+
 // -----------------------------------------------------------------------------------------------
 // Render thread / command queue
 // -----------------------------------------------------------------------------------------------
@@ -405,8 +562,17 @@ int FEngine::loop() {
         if (!execute()) {
             break;
         }
+
+        // the engine is between frames: keep chipping away at pending background
+        // resource work until new commands show up on the main queue
+        while (!mPendingResourceBuffers.empty() && !mCommandBufferQueue.hasCommands()) {
+            executeResourceCommands(true);
+        }
     }
 
+    // drain whatever background resource work is left before terminating
+    executeResourceCommands(false);
+
     // terminate() is a synchronous API
     getDriverApi().terminate();
     return 0;
@@ -459,6 +625,8 @@ Handle<HwProgram> FEngine::createPostProcessProgram(MaterialParser& parser,
 }
 
 Handle<HwProgram> FEngine::getPostProcessProgramSlow(PostProcessStage stage) const noexcept {
+    // ensures the post-process package parse has completed
+    const_cast<FEngine*>(this)->completeInit();
     Handle<HwProgram>* const postProcessPrograms = mPostProcessPrograms;
     if (!postProcessPrograms[(uint8_t)stage]) {
         ShaderModel shaderModel = getDriver().getShaderModel();
@@ -561,6 +729,14 @@ FFence* FEngine::createFence(Fence::Type type) noexcept {
     return p;
 }
 
+FFence* FEngine::createResourceFence() noexcept {
+    FFence* p = mHeapAllocator.make<FFence>(*this, Fence::Type::SOFT, true /* onResourceStream */);
+    if (p) {
+        mFences.insert(p);
+    }
+    return p;
+}
+
 FSwapChain* FEngine::createSwapChain(void* nativeWindow, uint64_t flags) noexcept {
     FSwapChain* p = mHeapAllocator.make<FSwapChain>(*this, nativeWindow, flags);
     if (p) {
@@ -569,6 +745,14 @@ FSwapChain* FEngine::createSwapChain(void* nativeWindow, uint64_t flags) noexcep
     return p;
 }
 
+FSwapChain* FEngine::createSwapChain(uint32_t width, uint32_t height, uint64_t flags) noexcept {
+    FSwapChain* p = mHeapAllocator.make<FSwapChain>(*this, width, height, flags);
+    if (p) {
+        mSwapChains.insert(p);
+    }
+    return p;
+}
+
 /*
  * Objects created with a component manager
  */
@@ -600,12 +784,27 @@ void FEngine::cleanupResourceList(ResourceList<T, L>& list) {
         slog.d << "cleaning up " << list.size()
                << " leaked " << CallStack::typeName<T>().c_str() << io::endl;
 #endif
-        // Move the list (copy-and-clear). We can only modify/access the list from this
-        // thread, because it's not thread-safe.
-        auto copy(list.getListAndClear());
-        for (T* item : copy) {
-            item->terminate(*this);
-            mHeapAllocator.destroy(item);
+        // Move the list into a contiguous slab (copy-and-clear) and destroy it in fixed-size
+        // batches, flushing the command buffer between batches. The driver thread can then
+        // release its side of a batch while we're still terminating the next one, instead of
+        // everything piling up in a single giant command buffer flushed at the very end.
+        // We can only modify/access the list from this thread, because it's not thread-safe.
+        auto slab(list.getSlabAndClear());
+        T* const* items = slab.data();
+        size_t count = slab.size();
+        while (count) {
+            const size_t batch = std::min(count, CONFIG_CLEANUP_BATCH_SIZE);
+            for (size_t i = 0; i < batch; i++) {
+                items[i]->terminate(*this);
+                mHeapAllocator.destroy(items[i]);
+            }
+            items += batch;
+            count -= batch;
+            if (count && UTILS_HAS_THREADING) {
+                // in single-threaded mode there is no consumer until execute(), flushing
+                // here would only grow the queue
+                flushCommandBuffer(mCommandBufferQueue);
+            }
         }
     }
 }
@@ -719,6 +918,95 @@ void* FEngine::streamAlloc(size_t size, size_t alignment) noexcept {
     return getDriverApi().allocate(size, alignment);
 }
 
+void* FEngine::uploadAlloc(size_t size) noexcept {
+    if (!size) {
+        return nullptr;
+    }
+    std::unique_lock<utils::Mutex> lock(mUploadPoolLock);
+    // only exact-capacity reuse; a streaming workload requests the same few sizes over and
+    // over, and re-pooling a larger buffer under a smaller size would silently waste memory
+    // (the free callback only knows the descriptor's size, not the buffer's capacity)
+    auto pos = mUploadPool.find(size);
+    if (pos != mUploadPool.end()) {
+        void* const buffer = pos->second;
+        mUploadPoolSize -= pos->first;
+        mUploadPool.erase(pos);
+        return buffer;
+    }
+    lock.unlock();
+    return malloc(size);
+}
+
+void FEngine::uploadFree(void* buffer, size_t size) noexcept {
+    std::unique_lock<utils::Mutex> lock(mUploadPoolLock);
+    if (mUploadPoolSize + size <= CONFIG_UPLOAD_POOL_SIZE) {
+        mUploadPool.emplace(size, buffer);
+        mUploadPoolSize += size;
+        return;
+    }
+    lock.unlock();
+    free(buffer);
+}
+
+void FEngine::trackGpuMemory(GpuMemoryPool pool, int64_t bytes) noexcept {
+    size_t& usage = mGpuMemoryUsage[size_t(pool)];
+    usage = size_t(int64_t(usage) + bytes);
+    // only allocations can push us over budget; the re-entrancy guard lets the callback
+    // destroy (or even create) resources without recursing into itself
+    if (UTILS_UNLIKELY(bytes > 0 && mMemoryBudget > 0 &&
+            mMemoryPressureCallback && !mInMemoryPressureCallback)) {
+        const Engine::MemoryUsage current = getMemoryUsage();
+        if (current.totalBytes > mMemoryBudget) {
+            mInMemoryPressureCallback = true;
+            mMemoryPressureCallback(current, mMemoryBudget, mMemoryPressureUser);
+            mInMemoryPressureCallback = false;
+        }
+    }
+}
+
+Engine::MemoryUsage FEngine::getMemoryUsage() const noexcept {
+    Engine::MemoryUsage usage;
+    usage.textureBytes      = mGpuMemoryUsage[size_t(GpuMemoryPool::TEXTURE)];
+    usage.vertexBufferBytes = mGpuMemoryUsage[size_t(GpuMemoryPool::VERTEX_BUFFER)];
+    usage.indexBufferBytes  = mGpuMemoryUsage[size_t(GpuMemoryPool::INDEX_BUFFER)];
+    usage.totalBytes = usage.textureBytes + usage.vertexBufferBytes + usage.indexBufferBytes;
+    return usage;
+}
+
+static bool operator==(FEngine::SharedShadowKey const& lhs,
+        FEngine::SharedShadowKey const& rhs) noexcept {
+    return lhs.light == rhs.light
+            && lhs.scene == rhs.scene
+            && lhs.dimension == rhs.dimension
+            && !memcmp(&lhs.lightSpace, &rhs.lightSpace, sizeof(lhs.lightSpace));
+}
+
+ShadowMap* FEngine::findSharedShadowMap(
+        SharedShadowKey const& key, ShadowMap const* self) noexcept {
+    for (auto const& entry : mSharedShadowMaps) {
+        if (entry.first != self && entry.second == key) {
+            return entry.first;
+        }
+    }
+    return nullptr;
+}
+
+void FEngine::updateSharedShadowMap(ShadowMap* owner, SharedShadowKey const& key) noexcept {
+    for (auto& entry : mSharedShadowMaps) {
+        if (entry.first == owner) {
+            entry.second = key;
+            return;
+        }
+    }
+    mSharedShadowMaps.push_back({ owner, key });
+}
+
+void FEngine::releaseSharedShadowMap(ShadowMap const* owner) noexcept {
+    auto& entries = mSharedShadowMaps;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+            [owner](auto const& entry) { return entry.first == owner; }), entries.end());
+}
+
 bool FEngine::execute() {
 
     // wait until we get command buffers to be executed (or thread exit requested)
@@ -834,10 +1122,18 @@ Fence* Engine::createFence(Fence::Type type) noexcept {
     return upcast(this)->createFence(type);
 }
 
+Fence* Engine::createResourceFence() noexcept {
+    return upcast(this)->createResourceFence();
+}
+
 SwapChain* Engine::createSwapChain(void* nativeWindow, uint64_t flags) noexcept {
     return upcast(this)->createSwapChain(nativeWindow, flags);
 }
 
+SwapChain* Engine::createSwapChain(uint32_t width, uint32_t height, uint64_t flags) noexcept {
+    return upcast(this)->createSwapChain(width, height, flags);
+}
+
 void Engine::destroy(const VertexBuffer* p) {
     upcast(this)->destroy(upcast(p));
 }
@@ -910,6 +1206,46 @@ void* Engine::streamAlloc(size_t size, size_t alignment) noexcept {
     return upcast(this)->streamAlloc(size, alignment);
 }
 
+void* Engine::uploadAlloc(size_t size) noexcept {
+    return upcast(this)->uploadAlloc(size);
+}
+
+void Engine::uploadCallback(void* buffer, size_t size, void* user) {
+    upcast(static_cast<Engine*>(user))->uploadFree(buffer, size);
+}
+
+size_t Engine::getPerRenderPassArenaHighWatermark() const noexcept {
+    return upcast(this)->getPerRenderPassArenaHighWatermark();
+}
+
+void Engine::setFrameLatency(size_t frames) noexcept {
+    upcast(this)->setFrameLatency(frames);
+}
+
+void Engine::setAsyncResourceLoadingEnabled(bool enabled) noexcept {
+    upcast(this)->setAsyncResourceLoadingEnabled(enabled);
+}
+
+bool Engine::isAsyncResourceLoadingEnabled() const noexcept {
+    return upcast(this)->isAsyncResourceLoadingEnabled();
+}
+
+size_t Engine::getFrameLatency() const noexcept {
+    return upcast(this)->getFrameLatency();
+}
+
+Engine::MemoryUsage Engine::getMemoryUsage() const noexcept {
+    return upcast(this)->getMemoryUsage();
+}
+
+void Engine::setMemoryBudget(size_t budgetBytes) noexcept {
+    upcast(this)->setMemoryBudget(budgetBytes);
+}
+
+void Engine::setMemoryPressureCallback(MemoryPressureCallback callback, void* user) noexcept {
+    upcast(this)->setMemoryPressureCallback(callback, user);
+}
+
 // The external-facing execute does a flush, and is meant only for single-threaded environments.
 // It also discards the boolean return value, which would otherwise indicate a thread exit.
 void Engine::execute() {
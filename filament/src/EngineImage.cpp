@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EngineImage.h"
+
+#include <math/half.h>
+#include <math/vec4.h>
+
+namespace filament {
+namespace details {
+
+using namespace math;
+
+// This package is generated with matc and contains post process shader code.
+static const uint8_t POST_PROCESS_PACKAGE[] = {
+#include "generated/material/postprocess.inc"
+};
+
+// This package is generated with matc and contains default material shader code.
+static const uint8_t DEFAULT_MATERIAL_PACKAGE[] = {
+#include "generated/material/defaultMaterial.inc"
+};
+
+// This lookup table is generated with cmgen.
+static const uint16_t DFG_LUT[] = {
+#include "generated/data/dfg.inc"
+};
+
+static_assert(sizeof(DFG_LUT) ==
+        EngineImage::DFG_LUT_SIZE * EngineImage::DFG_LUT_SIZE * 2 * sizeof(uint16_t),
+        "DFG_LUT_SIZE doesn't match size of the DFG LUT");
+
+static const half4 FULL_SCREEN_TRIANGLE_VERTICES[3] = {
+        { -1.0_h, -1.0_h, 1.0_h, 1.0_h },
+        {  3.0_h, -1.0_h, 1.0_h, 1.0_h },
+        { -1.0_h,  3.0_h, 1.0_h, 1.0_h }
+};
+
+static const uint16_t FULL_SCREEN_TRIANGLE_INDICES[3] = { 0, 1, 2 };
+
+static const EngineImage sEngineImage = {
+        { DEFAULT_MATERIAL_PACKAGE,      sizeof(DEFAULT_MATERIAL_PACKAGE) },
+        { POST_PROCESS_PACKAGE,          sizeof(POST_PROCESS_PACKAGE) },
+        { DFG_LUT,                       sizeof(DFG_LUT) },
+        { FULL_SCREEN_TRIANGLE_VERTICES, sizeof(FULL_SCREEN_TRIANGLE_VERTICES) },
+        { FULL_SCREEN_TRIANGLE_INDICES,  sizeof(FULL_SCREEN_TRIANGLE_INDICES) }
+};
+
+EngineImage const& getEngineImage() noexcept {
+    return sEngineImage;
+}
+
+} // namespace details
+} // namespace filament
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_ENGINEIMAGE_H
+#define TNT_FILAMENT_ENGINEIMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace filament {
+namespace details {
+
+// The engine image gathers every blob FEngine::init() needs at startup -- the default
+// material and post-process packages, the DFG LUT and the full-screen triangle geometry --
+// in a single read-only layout assembled at build time. Sections are consumed in place:
+// material parsers and buffer descriptors point directly into the image, so engine
+// creation never copies or decodes this data.
+struct EngineImage {
+    struct Section {
+        const void* data;
+        size_t size;
+    };
+
+    Section defaultMaterialPackage;     // matc package, parsed in place
+    Section postProcessPackage;         // matc package, parsed in place
+    Section dfgLut;                     // RG16F texels, DFG_LUT_SIZE x DFG_LUT_SIZE
+    Section fullScreenTriangleVertices; // 3 x half4 positions
+    Section fullScreenTriangleIndices;  // 3 x uint16_t
+
+    static constexpr size_t DFG_LUT_SIZE = 128;
+};
+
+EngineImage const& getEngineImage() noexcept;
+
+} // namespace details
+} // namespace filament
+
+#endif // TNT_FILAMENT_ENGINEIMAGE_H
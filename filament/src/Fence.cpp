@@ -22,6 +22,15 @@
 
 #include <utils/Panic.h>
 
+#if defined(__linux__)
+#include <utils/linux/futex.h>
+
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include <limits>
+
 namespace filament {
 
 using namespace driver;
@@ -32,9 +41,11 @@ namespace details {
 std::mutex FFence::sLock;
 std::condition_variable FFence::sCondition;
 
-FFence::FFence(FEngine& engine, Type type)
-    : mEngine(engine), mFenceSignal(std::make_shared<FenceSignal>(type)) {
-    DriverApi& driverApi = engine.getDriverApi();
+FFence::FFence(FEngine& engine, Type type, bool onResourceStream)
+    : mEngine(engine), mOnResourceStream(onResourceStream),
+      mFenceSignal(std::make_shared<FenceSignal>(type)) {
+    DriverApi& driverApi = onResourceStream ?
+            engine.getResourceDriverApi() : engine.getDriverApi();
     if (type == Type::HARD) {
         mFenceHandle = driverApi.createFence();
     }
@@ -73,7 +84,11 @@ FenceStatus FFence::wait(Mode mode, uint64_t timeout) noexcept {
     FEngine& engine = mEngine;
 
     if (mode == Mode::FLUSH) {
-        engine.flush();
+        if (UTILS_UNLIKELY(mOnResourceStream)) {
+            engine.flushResourceCommands();
+        } else {
+            engine.flush();
+        }
     }
 
     FenceSignal * const fs = mFenceSignal.get();
@@ -94,19 +109,52 @@ FenceStatus FFence::wait(Mode mode, uint64_t timeout) noexcept {
 
 UTILS_NOINLINE
 void FFence::FenceSignal::signal(State s) noexcept {
+#if defined(__linux__)
+    // the futex path makes signaling a fence a single store + wake, the driver thread
+    // never takes a lock at the frame boundary
+    mState.store(s, std::memory_order_release);
+    utils::linuxutil::futex_wake_ex(&mState, false, std::numeric_limits<int>::max());
+#else
     std::unique_lock<std::mutex> lock(FFence::sLock);
-    mState = s;
+    mState.store(s, std::memory_order_relaxed);
     lock.unlock();
     FFence::sCondition.notify_all();
+#endif
 }
 
 UTILS_NOINLINE
 Fence::FenceStatus FFence::FenceSignal::wait(uint64_t timeout) noexcept {
-    std::unique_lock<std::mutex> lock(FFence::sLock);
-    while (mState == UNSIGNALED) {
-        if (mState == DESTROYED) {
-            return FenceStatus::ERROR;
+    uint32_t state;
+#if defined(__linux__)
+    // wait directly on the fence's state word; the futex wakeup doesn't go through a
+    // mutex hand-off, which reduces the wakeup latency (and its jitter)
+    struct timespec deadline;
+    const struct timespec* pDeadline = nullptr;
+    if (timeout != FENCE_WAIT_FOR_EVER && timeout != 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec  += time_t(timeout / 1000000000u);
+        deadline.tv_nsec += long(timeout % 1000000000u);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
         }
+        pDeadline = &deadline;
+    }
+    while ((state = mState.load(std::memory_order_acquire)) == UNSIGNALED) {
+        if (timeout == 0) {
+            return FenceStatus::TIMEOUT_EXPIRED;
+        }
+        // the kernel rechecks the state word atomically, so a signal between our load and
+        // the syscall makes the wait return immediately (EAGAIN); spurious wakeups and
+        // EINTR just go around the loop
+        if (utils::linuxutil::futex_wait_ex(&mState, false, UNSIGNALED, false, pDeadline) < 0
+                && errno == ETIMEDOUT) {
+            return FenceStatus::TIMEOUT_EXPIRED;
+        }
+    }
+#else
+    std::unique_lock<std::mutex> lock(FFence::sLock);
+    while ((state = mState.load(std::memory_order_relaxed)) == UNSIGNALED) {
         if (timeout == FENCE_WAIT_FOR_EVER) {
             FFence::sCondition.wait(lock);
         } else {
@@ -117,7 +165,8 @@ Fence::FenceStatus FFence::FenceSignal::wait(uint64_t timeout) noexcept {
             }
         }
     }
-    return FenceStatus::CONDITION_SATISFIED;
+#endif
+    return state == DESTROYED ? FenceStatus::ERROR : FenceStatus::CONDITION_SATISFIED;
 }
 
 // ------------------------------------------------------------------------------------------------
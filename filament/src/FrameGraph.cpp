@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameGraph.h"
+
+#include "details/Engine.h"
+
+#include <utils/Panic.h>
+
+#include <assert.h>
+
+namespace filament {
+
+using namespace driver;
+using namespace details;
+
+FrameGraph::FrameGraph(FEngine& engine) noexcept : mEngine(engine) {
+    mResources.reserve(8);
+    mPasses.reserve(8);
+}
+
+FrameGraph::~FrameGraph() noexcept {
+    // all realized targets are normally returned to the pool during execute(), but don't
+    // leak them if the graph is abandoned before (or during) execution
+    RenderTargetPool& rtp = mEngine.getRenderTargetPool();
+    for (Resource& resource : mResources) {
+        if (UTILS_UNLIKELY(resource.target)) {
+            rtp.put(resource.target);
+        }
+    }
+}
+
+FrameGraph::ResourceId FrameGraph::createResource(const char* name,
+        TargetBufferFlags attachments,
+        uint32_t width, uint32_t height, uint8_t samples,
+        RenderTargetPool::TextureFormat format, uint8_t flags) noexcept {
+    Resource resource;
+    resource.name = name;
+    resource.attachments = attachments;
+    resource.width = width;
+    resource.height = height;
+    resource.format = format;
+    resource.samples = samples;
+    resource.flags = flags;
+    mResources.push_back(resource);
+    return ResourceId(mResources.size() - 1);
+}
+
+FrameGraph::ResourceId FrameGraph::importResource(const char* name) noexcept {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    mResources.push_back(resource);
+    return ResourceId(mResources.size() - 1);
+}
+
+void FrameGraph::addPass(const char* name,
+        std::initializer_list<ResourceId> reads,
+        std::initializer_list<ResourceId> writes,
+        Execute execute) noexcept {
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    pass.reads = reads;
+    pass.writes = writes;
+    mPasses.push_back(std::move(pass));
+}
+
+void FrameGraph::compile() noexcept {
+    auto& resources = mResources;
+    auto& passes = mPasses;
+
+    // Cull the passes whose outputs are never consumed. A single reverse sweep is enough
+    // because passes are declared in submission order: a pass survives if it writes a
+    // resource that a later surviving pass reads, or an imported resource.
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = passes.size(); i > 0; i--) {
+        Pass& pass = passes[i - 1];
+        bool alive = false;
+        for (ResourceId id : pass.writes) {
+            alive = alive || resources[id].imported || needed[id];
+        }
+        pass.culled = !alive;
+        if (alive) {
+            for (ResourceId id : pass.reads) {
+                needed[id] = true;
+            }
+        }
+    }
+
+    // compute each transient resource's lifetime across the surviving passes, so its
+    // render target is checked out of the pool only for the passes that use it
+    for (Resource& resource : resources) {
+        resource.firstUse = UINT16_MAX;
+        resource.lastUse = 0;
+    }
+    for (size_t i = 0, c = passes.size(); i < c; i++) {
+        Pass const& pass = passes[i];
+        if (pass.culled) {
+            continue;
+        }
+        auto touch = [&resources, i](ResourceId id) {
+            Resource& resource = resources[id];
+            resource.firstUse = std::min(resource.firstUse, uint16_t(i));
+            resource.lastUse = std::max(resource.lastUse, uint16_t(i));
+        };
+        for (ResourceId id : pass.reads) {
+            touch(id);
+        }
+        for (ResourceId id : pass.writes) {
+            touch(id);
+        }
+    }
+}
+
+void FrameGraph::execute(DriverApi& driver) noexcept {
+    RenderTargetPool& rtp = mEngine.getRenderTargetPool();
+    auto& resources = mResources;
+    auto& passes = mPasses;
+
+    for (size_t i = 0, c = passes.size(); i < c; i++) {
+        Pass& pass = passes[i];
+        if (pass.culled) {
+            continue;
+        }
+
+        // realize the transient resources first used by this pass
+        for (Resource& resource : resources) {
+            if (!resource.imported && resource.firstUse == i) {
+                assert(!resource.target);
+                resource.target = rtp.get(resource.attachments,
+                        resource.width, resource.height, resource.samples,
+                        resource.format, resource.flags);
+            }
+        }
+
+        pass.execute(*this, driver);
+
+        // return the transient resources last used by this pass to the pool
+        for (Resource& resource : resources) {
+            if (!resource.imported && resource.lastUse == i && resource.target) {
+                rtp.put(resource.target);
+                resource.target = nullptr;
+            }
+        }
+    }
+}
+
+RenderTargetPool::Target const* FrameGraph::getTarget(ResourceId id) const noexcept {
+    assert(id < mResources.size());
+    assert(mResources[id].target);
+    return mResources[id].target;
+}
+
+RenderTargetPool::Target const* FrameGraph::detachTarget(ResourceId id) noexcept {
+    assert(id < mResources.size());
+    RenderTargetPool::Target const* target = mResources[id].target;
+    assert(target);
+    mResources[id].target = nullptr;
+    return target;
+}
+
+} // namespace filament
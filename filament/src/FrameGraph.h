@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_FRAMEGRAPH_H
+#define TNT_FILAMENT_FRAMEGRAPH_H
+
+#include "RenderTargetPool.h"
+
+#include "driver/DriverApiForward.h"
+
+#include <filament/driver/DriverEnums.h>
+
+#include <utils/compiler.h>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+
+namespace details {
+class FEngine;
+} // namespace details
+
+/*
+ * A small frame graph. Render passes are declared up-front, together with the virtual
+ * resources they read and write; compile() then culls the passes whose outputs are never
+ * consumed and computes each transient resource's first and last use, so its render target
+ * is only checked out of the RenderTargetPool for the span of passes that actually need it
+ * (which in turn lets the pool alias it with other targets, see RenderTargetPool::get()).
+ *
+ * Imported resources live outside the graph (e.g. the swap chain, the shadow map); writing
+ * to one is a side effect the graph can't see past, so their writers are never culled.
+ *
+ * The graph is rebuilt every frame; it only stores pointers to the pass and resource
+ * names, which must therefore outlive the frame (string literals in practice).
+ */
+class FrameGraph {
+public:
+    using ResourceId = uint16_t;
+    static constexpr ResourceId INVALID_RESOURCE = 0xffff;
+
+    // a pass's execute closure; called from execute() in declaration order
+    using Execute = std::function<void(FrameGraph& fg, driver::DriverApi& driver)>;
+
+    explicit FrameGraph(details::FEngine& engine) noexcept;
+    ~FrameGraph() noexcept;
+
+    FrameGraph(FrameGraph const&) = delete;
+    FrameGraph& operator=(FrameGraph const&) = delete;
+
+    // declares a transient resource, realized from the RenderTargetPool on first use
+    ResourceId createResource(const char* name,
+            driver::TargetBufferFlags attachments,
+            uint32_t width, uint32_t height, uint8_t samples,
+            RenderTargetPool::TextureFormat format, uint8_t flags = 0) noexcept;
+
+    // declares a resource that lives outside the graph (e.g. the view's render target)
+    ResourceId importResource(const char* name) noexcept;
+
+    // declares a pass with the resources it consumes and produces
+    void addPass(const char* name,
+            std::initializer_list<ResourceId> reads,
+            std::initializer_list<ResourceId> writes,
+            Execute execute) noexcept;
+
+    // culls unused passes and computes transient resource lifetimes. call before execute().
+    void compile() noexcept;
+
+    // executes the surviving passes in declaration order
+    void execute(driver::DriverApi& driver) noexcept;
+
+    // Returns the realized target of a transient resource. Only valid during execute(),
+    // from a pass that declared the resource as a read or a write.
+    RenderTargetPool::Target const* getTarget(ResourceId id) const noexcept;
+
+    // Like getTarget(), but transfers ownership out of the graph; the caller becomes
+    // responsible for returning the target to the RenderTargetPool.
+    RenderTargetPool::Target const* detachTarget(ResourceId id) noexcept;
+
+private:
+    struct Resource {                       // a virtual render target
+        const char* name = nullptr;
+        driver::TargetBufferFlags attachments = driver::TargetBufferFlags::NONE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        RenderTargetPool::TextureFormat format = RenderTargetPool::TextureFormat::RGBA8;
+        uint8_t samples = 1;
+        uint8_t flags = 0;
+        bool imported = false;
+        // pass index range this resource needs to be realized for, set by compile()
+        uint16_t firstUse = 0;
+        uint16_t lastUse = 0;
+        RenderTargetPool::Target const* target = nullptr;
+    };
+
+    struct Pass {
+        const char* name = nullptr;
+        Execute execute;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        bool culled = false;
+    };
+
+    details::FEngine& mEngine;
+    std::vector<Resource> mResources;
+    std::vector<Pass> mPasses;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_FRAMEGRAPH_H
@@ -18,6 +18,8 @@
 
 #include "details/Engine.h"
 
+#include <chrono>
+
 namespace filament {
 namespace details {
 
@@ -35,11 +37,25 @@ FrameSkipper::~FrameSkipper() noexcept {
     }
 }
 
+void FrameSkipper::setLatency(size_t latency) noexcept {
+    latency = std::max(latency, size_t(1));
+    while (mFences.size() < latency) {
+        mFences.push_front(nullptr);
+    }
+    while (mFences.size() > latency) {
+        FFence* fence = mFences.front();
+        if (fence) {
+            mEngine.destroy(fence);
+        }
+        mFences.pop_front();
+    }
+}
+
 void FrameSkipper::endFrame() noexcept {
     mFences.push_back( mEngine.createFence(Fence::Type::HARD) );
 }
 
-bool FrameSkipper::skipFrameNeeded() const noexcept {
+bool FrameSkipper::skipFrameNeeded(int64_t deadlineNs) const noexcept {
     if (mExtraSkipCount) {
         mExtraSkipCount--;
         return true;
@@ -49,10 +65,17 @@ bool FrameSkipper::skipFrameNeeded() const noexcept {
         return true;
     }
 
+    uint64_t timeout = 0;
+    if (deadlineNs > 0) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        timeout = uint64_t(std::max(deadlineNs - now, int64_t(0)));
+    }
+
     auto& fences = mFences;
     FFence* fence = fences.front();
     if (fence) {
-        auto status = fence->wait(Fence::Mode::DONT_FLUSH, 0);
+        auto status = fence->wait(Fence::Mode::DONT_FLUSH, timeout);
         if (status == Fence::FenceStatus::TIMEOUT_EXPIRED) {
             // fence not ready, skip frame
             mExtraSkipCount = 0;
@@ -25,6 +25,7 @@
 
 #include <utils/Allocator.h>
 #include <utils/BinaryTreeArray.h>
+#include <utils/Hash.h>
 #include <utils/Systrace.h>
 
 #include <math/mat4.h>
@@ -34,6 +35,7 @@
 #include <algorithm>
 
 #include <stddef.h>
+#include <string.h>
 
 using namespace math;
 using namespace utils;
@@ -130,10 +132,19 @@ void Froxelizer::setOptions(float zLightNear, float zLightFar) noexcept {
     if (UTILS_UNLIKELY(mZLightNear != zLightNear || mZLightFar != zLightFar)) {
         mZLightNear = zLightNear;
         mZLightFar = zLightFar;
-        mDirtyFlags |= VIEWPORT_CHANGED;
+        // only the derived constants depend on the z-light range, not the froxel layout
+        mDirtyFlags |= DISTRIBUTION_CHANGED;
     }
 }
 
+void Froxelizer::setDepthDistribution(float power) noexcept {
+    power = clamp(power, 0.25f, 4.0f);
+    if (UTILS_UNLIKELY(mDistributionPower != power)) {
+        mDistributionPower = power;
+        mOneOverPower = 1.0f / power;
+        mDirtyFlags |= DISTRIBUTION_CHANGED;
+    }
+}
 
 void Froxelizer::setViewport(Viewport const& viewport) noexcept {
     if (UTILS_UNLIKELY(mViewport != viewport)) {
@@ -301,38 +312,63 @@ bool Froxelizer::update() noexcept {
         assert(mPlanesY);
         assert(mBoundingSpheres);
 
+        if (SUPPORTS_REMAPPED_FROXELS) {
+            mParamsF.x = uint32_t(mFroxelCountZ);
+            mParamsF.y = uint32_t(mFroxelCountX * mFroxelCountZ);
+            mParamsF.z = 1;
+        } else {
+            mParamsF[0] = 1;
+            mParamsF[1] = uint32_t(mFroxelCountX);
+            mParamsF[2] = uint32_t(mFroxelCountX * mFroxelCountY);
+        }
+    }
+
+    if (UTILS_UNLIKELY(mDirtyFlags & (VIEWPORT_CHANGED | DISTRIBUTION_CHANGED))) {
+        // z-slice boundaries and the constants derived from them. This is deliberately
+        // separate from the viewport block above so that changing the z-light range or
+        // the distribution curve at runtime doesn't pay for a froxel layout rebuild.
+        assert(mDistancesZ);
+
         mDistancesZ[0] = 0.0f;
         const float zLightNear = mZLightNear;
         const float zLightFar = mZLightFar;
         const float linearizer = std::log2(zLightFar / zLightNear) / (mFroxelCountZ - 1);
-        // for a strange reason when, vectorizing this loop, clang does some math in double
-        // and generates conversions to float. not worth it for so little iterations.
-        #pragma clang loop vectorize(disable) unroll(disable)
-        for (ssize_t i = 1, n = mFroxelCountZ; i <= n; i++) {
-            mDistancesZ[i] = zLightFar * std::exp2f((i - n) * linearizer);
+        const float power = mDistributionPower;
+        // Four slices at a time through the vectorized fast transcendentals (clang used
+        // to auto-vectorize the scalar loop in double, which wasn't worth it). The FAST
+        // policy is ~5e-5 off on the boundaries, insignificant against froxel granularity.
+        constexpr auto ACCURACY = fast::Accuracy::FAST;
+        for (ssize_t i = 1, n = mFroxelCountZ; i <= n; i += 4) {
+            // normalized distance from the far slice, remapped through the distribution
+            // curve; power == 1 gives the plain exponential distribution
+            float4 t;
+            for (ssize_t j = 0; j < 4; j++) {
+                t[j] = float(n - std::min(i + j, n)) / float(n - 1);
+            }
+            if (power != 1.0f) {
+                t = fast::pow<ACCURACY>(t, power);
+            }
+            const float4 d = zLightFar * fast::exp2<ACCURACY>(t * (-(n - 1) * linearizer));
+            for (ssize_t j = 0; j < 4 && i + j <= n; j++) {
+                mDistancesZ[i + j] = d[j];
+            }
         }
 
         // for the inverse-transformation (view-space z to z-slice)
         mLinearizer = 1 / linearizer;
-        mZLightFar = zLightFar;
         mLog2ZLightFar = std::log2(zLightFar);
 
         mParamsZ[0] = 0; // updated when camera changes
         mParamsZ[1] = 0; // updated when camera changes
         mParamsZ[2] = -mLinearizer;
         mParamsZ[3] = mFroxelCountZ;
-        if (SUPPORTS_REMAPPED_FROXELS) {
-            mParamsF.x = uint32_t(mFroxelCountZ);
-            mParamsF.y = uint32_t(mFroxelCountX * mFroxelCountZ);
-            mParamsF.z = 1;
-        } else {
-            mParamsF[0] = 1;
-            mParamsF[1] = uint32_t(mFroxelCountX);
-            mParamsF[2] = uint32_t(mFroxelCountX * mFroxelCountY);
-        }
+        mParamsCurve[0] = mOneOverPower;
+        mParamsCurve[1] = 1.0f / (mFroxelCountZ - 1);
+        mParamsCurve[2] = float(mFroxelCountZ - 1);
+        uniformsNeedUpdating = true;
     }
 
-    if (UTILS_UNLIKELY(mDirtyFlags & (PROJECTION_CHANGED | VIEWPORT_CHANGED))) {
+    if (UTILS_UNLIKELY(mDirtyFlags & (PROJECTION_CHANGED | VIEWPORT_CHANGED | DISTRIBUTION_CHANGED))) {
         assert(mDistancesZ);
         assert(mPlanesX);
         assert(mPlanesY);
@@ -474,6 +510,9 @@ bool Froxelizer::update() noexcept {
         uniformsNeedUpdating = true;
     }
     assert(mZLightNear >= mNear);
+    // the froxel layout (and therefore the slice boundaries) changed, the previous
+    // froxelization can't be reused
+    mFroxelizeInputsHash = 0;
     mDirtyFlags = 0;
     return uniformsNeedUpdating;
 }
@@ -498,9 +537,19 @@ size_t Froxelizer::findSliceZ(float z) const noexcept {
     // and we "undo" it below otherwise. This works because we're using fast::log2 which
     // doesn't care if given a negative number (we'd have to use abs() otherwise).
 
-    // This whole function is now branch-less.
+    // This whole function is now branch-less (but for the distribution curve below).
 
-    int s = int((fast::log2(-z) - mLog2ZLightFar) * mLinearizer + mFroxelCountZ);
+    float slice = (fast::log2(-z) - mLog2ZLightFar) * mLinearizer + mFroxelCountZ;
+
+    if (UTILS_UNLIKELY(mDistributionPower != 1.0f)) {
+        // remap through the configurable distribution curve, mirroring the shader's
+        // getFroxelCoords() (see setDepthDistribution())
+        const float u = (mFroxelCountZ - slice) / (mFroxelCountZ - 1);
+        slice = mFroxelCountZ
+                - (mFroxelCountZ - 1) * std::pow(std::max(u, 0.0f), mOneOverPower);
+    }
+
+    int s = int(slice);
 
     // there are cases where z can be negative here, e.g.:
     // - the light is visible, but its center is behind the camera
@@ -538,8 +587,21 @@ void Froxelizer::froxelizeLights(FEngine& engine,
         CameraInfo const& UTILS_RESTRICT camera,
         const FScene::LightSoa& UTILS_RESTRICT lightData) noexcept {
     // note: this is called asynchronously
+
+    // Froxelization is a pure function of the camera transform and of the lights'
+    // shapes. When neither changed since the last frame -- the common case with a
+    // static camera and static lights -- the previous result is still resident in the
+    // GPU buffers and everything below is skipped; commit() then uploads nothing,
+    // since the buffers aren't dirty. Froxel layout changes (projection, viewport,
+    // z-light range) are handled by update(), which resets the hash.
+    const uint32_t inputsHash = computeFroxelizeInputsHash(engine, camera, lightData);
+    if (inputsHash && inputsHash == mFroxelizeInputsHash) {
+        return;
+    }
+    mFroxelizeInputsHash = inputsHash;
+
     froxelizeLoop(engine, camera, lightData);
-    froxelizeAssignRecordsCompress();
+    froxelizeAssignRecordsCompress(engine.getJobSystem());
 
 #ifndef NDEBUG
     if (lightData.size()) {
@@ -565,6 +627,30 @@ void Froxelizer::froxelizeLights(FEngine& engine,
 #endif
 }
 
+uint32_t Froxelizer::computeFroxelizeInputsHash(FEngine& engine,
+        const CameraInfo& camera, const FScene::LightSoa& lightData) const noexcept {
+    auto& lcm = engine.getLightManager();
+    auto const* UTILS_RESTRICT spheres      = lightData.data<FScene::POSITION_RADIUS>();
+    auto const* UTILS_RESTRICT directions   = lightData.data<FScene::DIRECTION>();
+    auto const* UTILS_RESTRICT instances    = lightData.data<FScene::LIGHT_INSTANCE>();
+
+    // hash everything froxelizeLoop() reads: the view matrix and, per light, the
+    // same fields that go into LightParams
+    uint32_t h = hash::murmur3(
+            reinterpret_cast<uint32_t const*>(&camera.view), sizeof(mat4f) / 4, 0);
+    for (size_t i = FScene::DIRECTIONAL_LIGHTS_COUNT, c = lightData.size(); i < c; i++) {
+        FLightManager::Instance li = instances[i];
+        const float params[9] = {
+                spheres[i].x, spheres[i].y, spheres[i].z, spheres[i].w,
+                directions[i].x, directions[i].y, directions[i].z,
+                lcm.getCosOuterSquared(li),
+                lcm.getSinInverse(li),
+        };
+        h = hash::murmur3(reinterpret_cast<uint32_t const*>(params), 9, h);
+    }
+    return h;
+}
+
 void Froxelizer::froxelizeLoop(FEngine& engine,
         const CameraInfo& UTILS_RESTRICT camera,
         const FScene::LightSoa& UTILS_RESTRICT lightData) noexcept {
@@ -625,7 +711,7 @@ void Froxelizer::froxelizeLoop(FEngine& engine,
     }
 }
 
-void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
+void Froxelizer::froxelizeAssignRecordsCompress(utils::JobSystem& js) noexcept {
 
     SYSTRACE_CALL();
 
@@ -648,18 +734,26 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
     }
 
     // this gets very well vectorized...
+    // each froxel is an independent gather from the sharded group data, so this
+    // transpose is sliced across the job workers (the record compaction below stays
+    // sequential because entries are allocated in order and reuse their neighbors)
     utils::Slice<LightRecord> records(mLightRecords);
-    for (size_t j = 1, jc = FROXEL_BUFFER_ENTRY_COUNT_MAX; j < jc; j++) {
-        for (size_t i = 0; i < LightRecord::bitset::WORLD_COUNT; i++) {
-            using container_type = LightRecord::bitset::container_type;
-            constexpr size_t r = sizeof(container_type) / sizeof(LightGroupType);
-            container_type b = froxelThreadData[i * r][j];
-            for (size_t k = 0; k < r; k++) {
-                b |= (container_type(froxelThreadData[i * r + k][j]) << (LIGHT_PER_GROUP * k));
+    auto transpose = [froxelThreadData, records = records.data()](uint32_t start, uint32_t count) {
+        for (size_t j = start, jc = start + count; j < jc; j++) {
+            for (size_t i = 0; i < LightRecord::bitset::WORLD_COUNT; i++) {
+                using container_type = LightRecord::bitset::container_type;
+                constexpr size_t r = sizeof(container_type) / sizeof(LightGroupType);
+                container_type b = froxelThreadData[i * r][j];
+                for (size_t k = 0; k < r; k++) {
+                    b |= (container_type(froxelThreadData[i * r + k][j]) << (LIGHT_PER_GROUP * k));
+                }
+                records[j - 1].lights.getBitsAt(i) = b;
             }
-            records[j - 1].lights.getBitsAt(i) = b;
         }
-    }
+    };
+    js.runAndWait(jobs::parallel_for(js, nullptr,
+            1, uint32_t(FROXEL_BUFFER_ENTRY_COUNT_MAX - 1),
+            std::cref(transpose), jobs::CountSplitter<1024, 3>()));
 
     uint16_t offset = 0;
     FroxelEntry* const UTILS_RESTRICT froxels = mFroxelBufferUser.data();
@@ -675,6 +769,11 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
 
     RecordBufferType* const UTILS_RESTRICT froxelRecords = mRecordBufferUser.data();
 
+    // the palette is rebuilt every time the records are reassigned; the map's storage
+    // is reused across frames
+    auto& palette = mRecordPalette;
+    palette.clear();
+
     // how many froxel record entries were reused (for debugging)
     UTILS_UNUSED size_t reused = 0;
 
@@ -688,46 +787,57 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
         // We have a limitation of 255 spot + 255 point lights per froxel.
         FroxelEntry entry = {
                 .offset = offset,
-                .pointLightCount = (uint8_t)std::min(size_t(255), (b.lights & ~spotLights).count()),
-                .spotLightCount  = (uint8_t)std::min(size_t(255), (b.lights &  spotLights).count())
+                .pointLightCount = (uint8_t)std::min(size_t(255), andNot(b.lights, spotLights).count()),
+                .spotLightCount  = (uint8_t)std::min(size_t(255), (b.lights & spotLights).count())
         };
         const size_t lightCount = entry.count[0] + entry.count[1];
 
-        if (UTILS_UNLIKELY(offset + lightCount >= RECORD_BUFFER_ENTRY_COUNT)) {
+        // Palette lookup: froxels with identical light lists share a single record run.
+        // The run loop below already catches the left/above neighbors; the palette
+        // catches the distant repeats (e.g. disjoint spans of froxels inside the same
+        // room), which shrinks the record buffer severalfold on indoor scenes and
+        // improves the shader's cache hit rate on the froxel fetch.
+        auto pal = palette.find(b.lights);
+        if (pal != palette.end()) {
+            entry.u32 = pal->second;
+        } else {
+            if (UTILS_UNLIKELY(offset + lightCount >= RECORD_BUFFER_ENTRY_COUNT)) {
 #ifndef NDEBUG
-            slog.d << "out of space: " << i << ", at " << offset << io::endl;
+                slog.d << "out of space: " << i << ", at " << offset << io::endl;
 #endif
-            // note: instead of dropping froxels we could look for similar records we've already
-            // filed up.
-            do { // this compiles to memset() when remap() is identity
-                froxels[remap(i++)].u32 = 0;
-            } while(i < c);
-            goto out_of_memory;
-        }
-
-        // iterate the bitfield
-        auto beginPoint = froxelRecords + offset;
-        auto beginSpot  = froxelRecords + offset + entry.count[0];
-        b.lights.forEachSetBit([&spotLights,
-                point = beginPoint, spot = beginSpot, beginPoint, beginSpot]
-                (size_t l) mutable {
-
-            // make sure to keep this code branch-less
-            const bool isSpot = spotLights[l];
-            auto& p = isSpot ? spot      : point;
-            auto  s = isSpot ? beginSpot : beginPoint;
-
-            const size_t word = l / LIGHT_PER_GROUP;
-            const size_t bit  = l % LIGHT_PER_GROUP;
-            l = (bit * GROUP_COUNT) | (word % GROUP_COUNT);
+                // note: instead of dropping froxels we could look for similar records
+                // we've already filed up.
+                do { // this compiles to memset() when remap() is identity
+                    froxels[remap(i++)].u32 = 0;
+                } while(i < c);
+                goto out_of_memory;
+            }
 
-            *p = (RecordBufferType)l;
-            // we need to "cancel" the write if we have more than 255 spot or point lights
-            // (this is a limitation of the data type used to store the light counts per froxel)
-            p += (p - s < 255) ? 1 : 0;
-        });
+            // iterate the bitfield
+            auto beginPoint = froxelRecords + offset;
+            auto beginSpot  = froxelRecords + offset + entry.count[0];
+            b.lights.forEachSetBit([&spotLights,
+                    point = beginPoint, spot = beginSpot, beginPoint, beginSpot]
+                    (size_t l) mutable {
+
+                // make sure to keep this code branch-less
+                const bool isSpot = spotLights[l];
+                auto& p = isSpot ? spot      : point;
+                auto  s = isSpot ? beginSpot : beginPoint;
+
+                const size_t word = l / LIGHT_PER_GROUP;
+                const size_t bit  = l % LIGHT_PER_GROUP;
+                l = (bit * GROUP_COUNT) | (word % GROUP_COUNT);
+
+                *p = (RecordBufferType)l;
+                // we need to "cancel" the write if we have more than 255 spot or point lights
+                // (this is a limitation of the data type used to store the light counts per froxel)
+                p += (p - s < 255) ? 1 : 0;
+            });
 
-        offset += lightCount;
+            offset += lightCount;
+            palette.insert({ b.lights, entry.u32 });
+        }
 
 #ifndef NDEBUG
         if (lightCount) { reused--; }
@@ -750,11 +860,41 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
     }
 out_of_memory:
 
-    // froxel buffer is always fully invalidated
-    mFroxelBuffer.invalidate();
-
-    // needed record buffer size may change at each frame
-    mRecordsBuffer.invalidate(0, (offset + RECORD_BUFFER_WIDTH_MASK) >> RECORD_BUFFER_WIDTH_SHIFT);
+    // Delta tracking: diff the new data against a shadow copy of what the GPU buffers
+    // hold and only invalidate the rows that actually changed, so commit() re-uploads
+    // those alone. The shadow copies are needed because the user buffers live in the
+    // per-frame arena. Rows are only compared up to the entry actually in use -- the
+    // tail of the buffers is garbage and never read by the shaders.
+    if (UTILS_UNLIKELY(mFroxelShadow.size() != FROXEL_BUFFER_ENTRY_COUNT_MAX)) {
+        // first frame: upload everything
+        mFroxelShadow.resize(FROXEL_BUFFER_ENTRY_COUNT_MAX);
+        mRecordsShadow.resize(RECORD_BUFFER_ENTRY_COUNT);
+        memcpy(mFroxelShadow.data(), froxels, getFroxelCount() * sizeof(FroxelEntry));
+        memcpy(mRecordsShadow.data(), froxelRecords, offset * sizeof(RecordBufferType));
+        mFroxelBuffer.invalidate();
+        mRecordsBuffer.invalidate(0, (offset + RECORD_BUFFER_WIDTH_MASK) >> RECORD_BUFFER_WIDTH_SHIFT);
+    } else {
+        FroxelEntry* const UTILS_RESTRICT froxelShadow = mFroxelShadow.data();
+        for (size_t row = 0, count = getFroxelCount(); row * FROXEL_BUFFER_WIDTH < count; row++) {
+            const size_t begin = row * FROXEL_BUFFER_WIDTH;
+            const size_t bytes = (std::min(begin + FROXEL_BUFFER_WIDTH, count) - begin)
+                    * sizeof(FroxelEntry);
+            if (memcmp(froxelShadow + begin, froxels + begin, bytes)) {
+                memcpy(froxelShadow + begin, froxels + begin, bytes);
+                mFroxelBuffer.invalidate(row, 1);
+            }
+        }
+        RecordBufferType* const UTILS_RESTRICT recordsShadow = mRecordsShadow.data();
+        for (size_t row = 0; row * RECORD_BUFFER_WIDTH < offset; row++) {
+            const size_t begin = row * RECORD_BUFFER_WIDTH;
+            const size_t bytes = (std::min(begin + RECORD_BUFFER_WIDTH, size_t(offset)) - begin)
+                    * sizeof(RecordBufferType);
+            if (memcmp(recordsShadow + begin, froxelRecords + begin, bytes)) {
+                memcpy(recordsShadow + begin, froxelRecords + begin, bytes);
+                mRecordsBuffer.invalidate(row, 1);
+            }
+        }
+    }
 }
 
 static inline float2 project(mat4f const& p, float3 const& v) noexcept {
@@ -791,6 +931,12 @@ void Froxelizer::froxelizePointAndSpotLight(
         return;
     }
 
+    if (UTILS_UNLIKELY(light.position.z - light.radius > -mNear)) {
+        // This light is fully between the camera and the near plane,
+        // it doesn't light anything visible
+        return;
+    }
+
     // the code below works with radius^2
     const float4 s = { light.position, light.radius * light.radius };
 
@@ -819,12 +965,24 @@ void Froxelizer::froxelizePointAndSpotLight(
     if (xyLeftFar.x  > xyRightFar.x)    std::swap(xyLeftFar.x, xyRightFar.x);
     if (xyLeftFar.y  > xyRightFar.y)    std::swap(xyLeftFar.y, xyRightFar.y);
 
-    const auto imin = clipToIndices(min(xyLeftNear, xyLeftFar));
+    const float2 xyMin = min(xyLeftNear, xyLeftFar);
+    const float2 xyMax = max(xyRightNear, xyRightFar);
+
+    // Cull lights whose conservative rect misses the screen entirely -- with many
+    // lights scattered through a large scene most of them end up here. Without this,
+    // clipToIndices() clamps the empty rect to the edge froxels and the plane tests
+    // below run for nothing.
+    if (UTILS_UNLIKELY(xyMin.x >= 1.0f || xyMin.y >= 1.0f ||
+                       xyMax.x <= -1.0f || xyMax.y <= -1.0f)) {
+        return;
+    }
+
+    const auto imin = clipToIndices(xyMin);
     const size_t x0 = imin.first;
     const size_t y0 = imin.second;
     const size_t z0 = findSliceZ(znear);
 
-    const auto imax = clipToIndices(max(xyRightNear, xyRightFar));
+    const auto imax = clipToIndices(xyMax);
     const size_t x1 = imax.first  + 1;  // x1 points to 1 past the last value (like end() does
     const size_t y1 = imax.second;      // y1 points to the last value
     const size_t z1 = findSliceZ(zfar); // z1 points to the last value
@@ -35,31 +35,32 @@ Frustum::Frustum(const mat4f& pv) {
 
 UTILS_NOINLINE
 void Frustum::setProjection(const mat4f& pv) {
-    const mat4f m(transpose(pv));
-
-    // Note: these "normals" are not normalized -- it's not necessary for the culling tests.
-    float4 l = -m[3] - m[0];
-    float4 r = -m[3] + m[0];
-    float4 b = -m[3] - m[1];
-    float4 t = -m[3] + m[1];
-    float4 n = -m[3] - m[2];
-    float4 f = -m[3] + m[2];
-
-    // NOTE: for our box/frustum intersection routine normalizing these vectors is not required
-    // however, they must be normalized for the sphere/frustum tests.
-    l *= 1 / length(l.xyz);
-    r *= 1 / length(r.xyz);
-    b *= 1 / length(b.xyz);
-    t *= 1 / length(t.xyz);
-    n *= 1 / length(n.xyz);
-    f *= 1 / length(f.xyz);
-
-    mPlanes[0] = l;
-    mPlanes[1] = r;
-    mPlanes[2] = b;
-    mPlanes[3] = t;
-    mPlanes[4] = f;
-    mPlanes[5] = n;
+    Frustum::setProjection(this, &pv, 1);
+}
+
+UTILS_NOINLINE
+void Frustum::setProjection(Frustum* UTILS_RESTRICT frusta,
+        const mat4f* UTILS_RESTRICT pv, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        const mat4f m(transpose(pv[i]));
+
+        float4* UTILS_RESTRICT const planes = frusta[i].mPlanes;
+        planes[0] = -m[3] - m[0];   // left
+        planes[1] = -m[3] + m[0];   // right
+        planes[2] = -m[3] - m[1];   // bottom
+        planes[3] = -m[3] + m[1];   // top
+        planes[4] = -m[3] + m[2];   // far
+        planes[5] = -m[3] - m[2];   // near
+
+        // NOTE: for our box/frustum intersection routine normalizing these vectors is not
+        // required, however, they must be normalized for the sphere/frustum tests.
+        // The six normalizations are independent; with the planes in an array the compiler
+        // vectorizes them instead of issuing six scalar rsqrt sequences.
+        #pragma clang loop unroll(full)
+        for (size_t j = 0; j < 6; j++) {
+            planes[j] *= 1 / length(planes[j].xyz);
+        }
+    }
 }
 
 float4 Frustum::getNormalizedPlane(Frustum::Plane plane) const noexcept {
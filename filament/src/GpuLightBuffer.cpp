@@ -29,9 +29,9 @@ using namespace driver;
 namespace details {
 
 GpuLightBuffer::GpuLightBuffer(FEngine& engine) noexcept
-        : mLightsUb(UibGenerator::getLightsUib()) {
+        : mLightsUb{ UniformBuffer(UibGenerator::getLightsUib()), UniformBuffer() } {
     DriverApi& driverApi = engine.getDriverApi();
-    mLightUbh = driverApi.createUniformBuffer(mLightsUb.getSize());
+    mLightUbh = driverApi.createUniformBuffer(mLightsUb[0].getSize());
     driverApi.bindUniforms(BindingPoints::LIGHTS, mLightUbh);
 }
 
@@ -43,7 +43,7 @@ void GpuLightBuffer::terminate(FEngine& engine) {
 }
 
 void GpuLightBuffer::commit(FEngine& engine) noexcept {
-    if (UTILS_UNLIKELY(mLightsUb.isDirty())) {
+    if (UTILS_UNLIKELY(mLightsUb[mCurrentBuffer].isDirty())) {
         commitSlow(engine);
     }
     engine.getDriverApi().bindUniforms(BindingPoints::LIGHTS, mLightUbh);
@@ -51,8 +51,22 @@ void GpuLightBuffer::commit(FEngine& engine) noexcept {
 
 void GpuLightBuffer::commitSlow(FEngine& engine) noexcept {
     DriverApi& driverApi = engine.getDriverApi();
-    driverApi.updateUniformBuffer(mLightUbh, UniformBuffer(mLightsUb));
-    mLightsUb.clean();
+    // Hand the current staging buffer to the command stream without copying it; only the
+    // invalidated range is uploaded. We then write the next frame's lights into the other
+    // buffer of the ring. This is safe because prepareDynamicLights() rewrites and
+    // invalidates every used light record each frame, so nothing needs to be carried
+    // forward from the previous contents.
+    driverApi.updateUniformBuffer(mLightUbh, std::move(mLightsUb[mCurrentBuffer]));
+    mCurrentBuffer ^= 1u;
+    UniformBuffer& next = mLightsUb[mCurrentBuffer];
+    if (UTILS_LIKELY(!next.getBuffer())) {
+        // this one was moved into the command stream last time around; its allocation
+        // comes from UniformBuffer's memory pool, so this is cheap in steady state
+        next = UniformBuffer(UibGenerator::getLightsUib());
+        // a new UniformBuffer is wholly dirty; reset that so the next commit only
+        // uploads the records actually written
+        next.clean();
+    }
 }
 
 } // namespace details
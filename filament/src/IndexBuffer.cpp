@@ -27,6 +27,7 @@ using namespace details;
 struct IndexBuffer::BuilderDetails {
     uint32_t mIndexCount = 0;
     IndexType mIndexType = IndexType::UINT;
+    BufferUsage mUsage = BufferUsage::STATIC;
 };
 
 using BuilderType = IndexBuffer;
@@ -47,6 +48,11 @@ IndexBuffer::Builder& IndexBuffer::Builder::bufferType(IndexType indexType) noex
     return *this;
 }
 
+IndexBuffer::Builder& IndexBuffer::Builder::usage(BufferUsage usage) noexcept {
+    mImpl->mUsage = usage;
+    return *this;
+}
+
 IndexBuffer* IndexBuffer::Builder::build(Engine& engine) {
     return upcast(engine).createIndexBuffer(*this);
 }
@@ -55,16 +61,29 @@ IndexBuffer* IndexBuffer::Builder::build(Engine& engine) {
 
 namespace details {
 
+// selects the stream an index buffer's create/upload/destroy commands are recorded on
+// (see FEngine::setAsyncResourceLoadingEnabled())
+static inline FEngine::DriverApi& selectDriver(FEngine& engine, bool onResourceStream) noexcept {
+    return onResourceStream ? engine.getResourceDriverApi() : engine.getDriverApi();
+}
+
 FIndexBuffer::FIndexBuffer(FEngine& engine, const IndexBuffer::Builder& builder)
-        : mIndexCount(builder->mIndexCount) {
-    FEngine::DriverApi& driver = engine.getDriverApi();
+        : mIndexCount(builder->mIndexCount),
+          mElementSize(builder->mIndexType == IndexType::USHORT ? 2 : 4),
+          mUsesResourceStream(engine.isAsyncResourceLoadingEnabled()) {
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
     mHandle = driver.createIndexBuffer(
             (driver::ElementType)builder->mIndexType,
-            uint32_t(builder->mIndexCount));
+            uint32_t(builder->mIndexCount),
+            builder->mUsage);
+
+    engine.trackGpuMemory(FEngine::GpuMemoryPool::INDEX_BUFFER, int64_t(getEstimatedSize()));
 }
 
 void FIndexBuffer::terminate(FEngine& engine) {
-    FEngine::DriverApi& driver = engine.getDriverApi();
+    engine.trackGpuMemory(FEngine::GpuMemoryPool::INDEX_BUFFER, -int64_t(getEstimatedSize()));
+
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
     driver.destroyIndexBuffer(mHandle);
 }
 
@@ -75,7 +94,8 @@ void FIndexBuffer::setBuffer(FEngine& engine,
         byteSize = uint32_t(buffer.size);
     }
 
-    engine.getDriverApi().loadIndexBuffer(mHandle, std::move(buffer), byteOffset, byteSize);
+    selectDriver(engine, mUsesResourceStream).loadIndexBuffer(mHandle,
+            std::move(buffer), byteOffset, byteSize);
 }
 
 } // namespace details
@@ -169,4 +169,12 @@ void IndirectLight::setRotation(math::mat3f const& rotation) noexcept {
     upcast(this)->setRotation(rotation);
 }
 
+void IndirectLight::setProbeVolume(const Box& aabb) noexcept {
+    upcast(this)->setProbeVolume(aabb);
+}
+
+const Box& IndirectLight::getProbeVolume() const noexcept {
+    return upcast(this)->getProbeVolume();
+}
+
 } // namespace filament
@@ -31,9 +31,13 @@
 
 #include <filaflat/MaterialParser.h>
 
+#include <utils/Hash.h>
 #include <utils/Panic.h>
 
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 using namespace utils;
 using namespace filaflat;
@@ -47,10 +51,68 @@ using namespace driver;
 struct Material::BuilderDetails {
     const void* mPayload = nullptr;
     size_t mSize = 0;
-    filaflat::MaterialParser* mMaterialParser = nullptr;
+    std::shared_ptr<filaflat::MaterialParser> mMaterialParser;
     bool mDefaultMaterial = false;
 };
 
+// The process-wide cache of parsed material packages. Compiled packages are immutable, so
+// when the same bytes are built into several materials -- typically by several engines in
+// a multi-viewport or multi-GPU setup -- they share a single refcounted core: one copy of
+// the payload and one parsed representation (chunk directory, interface blocks, shader
+// dictionary) per backend, instead of every build duplicating and re-parsing the package.
+// Each engine layers its own program cache on top (FMaterial::mCachedPrograms).
+namespace {
+
+struct MaterialCore {
+    Backend backend = Backend::DEFAULT;
+    size_t size = 0;
+    std::unique_ptr<uint8_t[]> data;
+    std::unique_ptr<MaterialParser> parser;
+};
+
+std::unordered_multimap<uint32_t, std::weak_ptr<MaterialCore>> sMaterialCores;
+std::mutex sMaterialCoresLock;
+
+// returns the shared parsed core for these bytes, parsing them if this is the first
+// build, or null if they don't parse as a shading material
+std::shared_ptr<MaterialCore> acquireMaterialCore(
+        Backend backend, const void* payload, size_t size) {
+    uint32_t const key = utils::hash::murmur3(
+            static_cast<uint32_t const*>(payload), size / 4, 0);
+
+    std::lock_guard<std::mutex> guard(sMaterialCoresLock);
+    auto range = sMaterialCores.equal_range(key);
+    for (auto pos = range.first; pos != range.second; ) {
+        std::shared_ptr<MaterialCore> core = pos->second.lock();
+        if (!core) {
+            // last material using this core is gone, collect the stale entry
+            pos = sMaterialCores.erase(pos);
+            continue;
+        }
+        // the parsed representation depends on the backend's shader language
+        if (core->backend == backend && core->size == size &&
+                !memcmp(core->data.get(), payload, size)) {
+            return core;
+        }
+        ++pos;
+    }
+
+    std::shared_ptr<MaterialCore> core = std::make_shared<MaterialCore>();
+    core->backend = backend;
+    core->size = size;
+    core->data.reset(new uint8_t[size]);
+    memcpy(core->data.get(), payload, size);
+    core->parser.reset(new MaterialParser(backend, core->data.get(), size, false /* copy */));
+    if (!core->parser->parse() || !core->parser->isShadingMaterial()) {
+        // don't cache packages that failed to parse
+        return nullptr;
+    }
+    sMaterialCores.emplace(key, core);
+    return core;
+}
+
+} // anonymous namespace
+
 FMaterial::DefaultMaterialBuilder::DefaultMaterialBuilder() : Material::Builder() {
     mImpl->mDefaultMaterial = true;
 }
@@ -70,15 +132,33 @@ Material::Builder& Material::Builder::package(const void* payload, size_t size)
 }
 
 Material* Material::Builder::build(Engine& engine) {
-    MaterialParser* materialParser = new MaterialParser(
-            upcast(engine).getBackend(), mImpl->mPayload, mImpl->mSize);
-    bool materialOK = materialParser->parse() && materialParser->isShadingMaterial();
-    if (!ASSERT_POSTCONDITION_NON_FATAL(materialOK, "could not parse the material package")) {
+    assert(upcast(engine).getBackend() != Backend::DEFAULT && "Default backend has not been resolved.");
+
+    // The default material package lives in the engine image, which outlives the engine,
+    // so it's parsed in place and the parser is owned outright. All other packages go
+    // through the shared core cache: when another engine already built these bytes, the
+    // parse is skipped entirely and the material just takes a reference on the existing
+    // core. The aliased pointer keeps the whole core (bytes + parsed state) alive for
+    // as long as any material uses its parser.
+    std::shared_ptr<MaterialParser> materialParser;
+    if (mImpl->mDefaultMaterial) {
+        materialParser.reset(new MaterialParser(
+                upcast(engine).getBackend(), mImpl->mPayload, mImpl->mSize, false /* copy */));
+        if (!materialParser->parse() || !materialParser->isShadingMaterial()) {
+            materialParser = nullptr;
+        }
+    } else {
+        std::shared_ptr<MaterialCore> core = acquireMaterialCore(
+                upcast(engine).getBackend(), mImpl->mPayload, mImpl->mSize);
+        if (core) {
+            materialParser = std::shared_ptr<MaterialParser>(core, core->parser.get());
+        }
+    }
+    if (!ASSERT_POSTCONDITION_NON_FATAL(materialParser,
+            "could not parse the material package")) {
         return nullptr;
     }
 
-    assert(upcast(engine).getBackend() != Backend::DEFAULT && "Default backend has not been resolved.");
-
     uint32_t v;
     materialParser->getShaderModels(&v);
     utils::bitset32 shaderModels;
@@ -94,7 +174,7 @@ Material* Material::Builder::build(Engine& engine) {
         return nullptr;
     }
 
-    mImpl->mMaterialParser = materialParser;
+    mImpl->mMaterialParser = std::move(materialParser);
 
     return upcast(engine).createMaterial(*this);
 }
@@ -105,8 +185,8 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
         : mEngine(engine),
           mMaterialId(engine.getMaterialId())
 {
-    MaterialParser* parser = builder->mMaterialParser;
-    mMaterialParser = parser;
+    mMaterialParser = builder->mMaterialParser;
+    MaterialParser* parser = mMaterialParser.get();
 
     UTILS_UNUSED_IN_RELEASE bool nameOk = parser->getName(&mName);
     assert(nameOk);
@@ -117,9 +197,12 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
     UTILS_UNUSED_IN_RELEASE bool uibOK = parser->getUIB(&mUniformInterfaceBlock);
     assert(uibOK);
 
-    // Sampler bindings are only required for Vulkan.
-    UTILS_UNUSED_IN_RELEASE bool sbOK = parser->getSamplerBindingMap(&mSamplerBindings);
-    assert(engine.getBackend() == Backend::OPENGL || sbOK);
+    // The sampler binding table is precomputed by matc and stored in the package, so loading
+    // it is pure deserialization. Packages built by an older matc don't carry the chunk; fall
+    // back to computing the table here (it's cheap, just not free).
+    if (UTILS_UNLIKELY(!parser->getSamplerBindingMap(&mSamplerBindings))) {
+        mSamplerBindings.populate(&mSamplerInterfaceBlock);
+    }
 
     parser->getShading(&mShading);
     parser->getBlendingMode(&mBlendingMode);
@@ -134,6 +217,22 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
     }
     mIsVariantLit = mShading != Shading::UNLIT || mHasShadowMultiplier;
 
+    // Precompute the variant filtering table, so runtime variant resolution is a single
+    // indexed load. The supported-variant set comes from the package when present (matc
+    // excludes variants it stripped); older packages reconstruct it from the shading mode.
+    uint32_t supportedVariants = 0;
+    if (!parser->getSupportedVariants(&supportedVariants)) {
+        for (uint8_t k = 0; k < VARIANT_COUNT; k++) {
+            if (!Variant::isReserved(k)) {
+                supportedVariants |= 1u << Variant::filterVariant(k, mIsVariantLit);
+            }
+        }
+    }
+    mSupportedVariants = uint16_t(supportedVariants);
+    for (size_t k = 0; k < VARIANT_COUNT; k++) {
+        mFilteredVariants[k] = Variant::filterVariant(uint8_t(k), mIsVariantLit);
+    }
+
     // create raster state
     using BlendFunction = Driver::RasterState::BlendFunction;
     using DepthFunc = Driver::RasterState::DepthFunc;
@@ -221,11 +320,11 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
     mDefaultInstance.initDefaultInstance(engine, this);
 }
 
-FMaterial::~FMaterial() noexcept {
-    delete mMaterialParser;
-}
+FMaterial::~FMaterial() noexcept = default;
 
 void FMaterial::terminate(FEngine& engine) {
+    // drop any program build we may still have queued
+    engine.cancelDeferredProgramBuilds(this);
     DriverApi& driverApi = engine.getDriverApi();
     auto& cachedPrograms = mCachedPrograms;
     for (size_t i = 0, n = cachedPrograms.size(); i < n; ++i) {
@@ -254,7 +353,42 @@ bool FMaterial::hasParameter(const char* name) const noexcept {
     return true;
 }
 
+void FMaterial::compile() const noexcept {
+    // The reserved variants are never set in mSupportedVariants, and variants already
+    // cached (e.g. the shared depth variants) are skipped. Unlike the on-demand path,
+    // this ignores the per-frame program build budget: during a load screen paying the
+    // full compilation cost up front is the point.
+    for (uint8_t k = 0; k < VARIANT_COUNT; k++) {
+        if ((mSupportedVariants & (1u << k)) && !mCachedPrograms[k]) {
+            buildProgram(k);
+        }
+    }
+}
+
 Handle<HwProgram> FMaterial::getProgramSlow(uint8_t variantKey) const noexcept {
+    // record which variants are actually requested; the resulting bitmask is exposed as
+    // "d.variants.used" and can seed a matc variant allowlist to strip unused variants.
+    mEngine.debug.variants.used |= 1 << variantKey;
+
+    if (UTILS_UNLIKELY(!mEngine.hasProgramBuildBudget())) {
+        // We're over this frame's program build budget: building now would hitch the frame.
+        // The depth variants were pre-cached at creation time, so use the matching one as
+        // a placeholder and defer the real build to the next FEngine::prepare() -- drawing
+        // depth-only for a frame or two is far less noticeable than a multi-ms stall.
+        // mCachedPrograms[variantKey] is intentionally left empty, so getProgram() keeps
+        // coming back here until the deferred build has landed.
+        const uint8_t placeholderKey = Variant::DEPTH_VARIANT | (variantKey & Variant::SKINNING);
+        Handle<HwProgram> const placeholder = mCachedPrograms[placeholderKey];
+        if (UTILS_LIKELY(placeholder)) {
+            mEngine.deferProgramBuild(this, variantKey);
+            return placeholder;
+        }
+        // no placeholder available (e.g. we *are* the depth variant), build it now
+    }
+    return buildProgram(variantKey);
+}
+
+Handle<HwProgram> FMaterial::buildProgram(uint8_t variantKey) const noexcept {
     const ShaderModel sm = mEngine.getDriver().getShaderModel();
 
     assert(!Variant::isReserved(variantKey));
@@ -312,6 +446,7 @@ Handle<HwProgram> FMaterial::getProgramSlow(uint8_t variantKey) const noexcept {
     auto program = mEngine.getDriverApi().createProgram(std::move(pb));
     assert(program);
 
+    mEngine.countProgramBuild();
     mCachedPrograms[variantKey] = program;
     return program;
 }
@@ -422,6 +557,14 @@ AttributeBitset Material::getRequiredAttributes() const noexcept {
     return upcast(this)->getRequiredAttributes();
 }
 
+void Material::compile() const noexcept {
+    upcast(this)->compile();
+}
+
+Material::ParameterHandle Material::getParameterHandle(const char* name) const noexcept {
+    return upcast(this)->getParameterHandle(name);
+}
+
 bool Material::hasParameter(const char* name) const noexcept {
     return upcast(this)->hasParameter(name);
 }
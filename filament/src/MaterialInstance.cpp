@@ -98,8 +98,11 @@ void FMaterialInstance::commitSlow(FEngine& engine) const {
     }
 }
 
+uint32_t FMaterialInstance::sVersion = 0;
+
 template <typename T>
 inline void FMaterialInstance::setParameter(const char* name, T value) noexcept {
+    sVersion++;
     mUniforms.setUniform<T>(mMaterial->getUniformInterfaceBlock(), name, 0, value);
 }
 
@@ -107,12 +110,30 @@ template <typename T>
 inline void FMaterialInstance::setParameter(const char* name, const T* value, size_t count) noexcept {
     ssize_t offset = mMaterial->getUniformInterfaceBlock().getUniformOffset(name, 0);
     if (offset >= 0) {
+        sVersion++;
         mUniforms.setUniformArray<T>(size_t(offset), value, count);
     }
 }
 
+template <typename T>
+inline void FMaterialInstance::setParameter(int32_t handle, T value) noexcept {
+    if (UTILS_LIKELY(handle >= 0)) {
+        sVersion++;
+        mUniforms.setUniform<T>(size_t(handle), value);
+    }
+}
+
+template <typename T>
+inline void FMaterialInstance::setParameter(int32_t handle, const T* value, size_t count) noexcept {
+    if (UTILS_LIKELY(handle >= 0)) {
+        sVersion++;
+        mUniforms.setUniformArray<T>(size_t(handle), value, count);
+    }
+}
+
 void FMaterialInstance::setParameter(const char* name,
         Texture const* texture, TextureSampler const& sampler) noexcept {
+    sVersion++;
     mSamplers.setSampler(mMaterial->getSamplerInterfaceBlock(), name, 0,
             { upcast(texture)->getHwHandle(), sampler.getSamplerParams() });
 }
@@ -175,6 +196,96 @@ template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (const char*
 template UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>   (const char* name, const mat3f    *v, size_t c);
 template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (const char* name, const mat4f    *v, size_t c);
 
+template <typename T>
+void MaterialInstance::setParameter(ParameterHandle handle, T value) noexcept {
+    upcast(this)->setParameter<T>(handle, value);
+}
+
+// explicit template instantiation of our supported types
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool>    (ParameterHandle h, bool     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float>   (ParameterHandle h, float    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int32_t> (ParameterHandle h, int32_t  v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint32_t>(ParameterHandle h, uint32_t v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool2>   (ParameterHandle h, bool2    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool3>   (ParameterHandle h, bool3    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool4>   (ParameterHandle h, bool4    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int2>    (ParameterHandle h, int2     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int3>    (ParameterHandle h, int3     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int4>    (ParameterHandle h, int4     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint2>   (ParameterHandle h, uint2    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint3>   (ParameterHandle h, uint3    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint4>   (ParameterHandle h, uint4    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float2>  (ParameterHandle h, float2   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float3>  (ParameterHandle h, float3   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (ParameterHandle h, float4   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>   (ParameterHandle h, mat3f    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (ParameterHandle h, mat4f    v);
+
+template <typename T>
+void MaterialInstance::setParameter(ParameterHandle handle, const T* value, size_t count) noexcept {
+    upcast(this)->setParameter<T>(handle, value, count);
+}
+
+// explicit template instantiation of our supported types
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool>    (ParameterHandle h, const bool     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float>   (ParameterHandle h, const float    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int32_t> (ParameterHandle h, const int32_t  *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint32_t>(ParameterHandle h, const uint32_t *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool2>   (ParameterHandle h, const bool2    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool3>   (ParameterHandle h, const bool3    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool4>   (ParameterHandle h, const bool4    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int2>    (ParameterHandle h, const int2     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int3>    (ParameterHandle h, const int3     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int4>    (ParameterHandle h, const int4     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint2>   (ParameterHandle h, const uint2    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint3>   (ParameterHandle h, const uint3    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint4>   (ParameterHandle h, const uint4    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float2>  (ParameterHandle h, const float2   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float3>  (ParameterHandle h, const float3   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (ParameterHandle h, const float4   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>   (ParameterHandle h, const mat3f    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (ParameterHandle h, const mat4f    *v, size_t c);
+
+template <typename T>
+void MaterialInstance::setParameter(MaterialInstance* const* instances, size_t count,
+        const char* name, T value) noexcept {
+    if (UTILS_UNLIKELY(count == 0)) {
+        return;
+    }
+    // resolve the parameter name once; all instances share their material's
+    // uniform layout
+    FMaterial const* const material = upcast(instances[0])->getMaterial();
+    ssize_t offset = material->getUniformInterfaceBlock().getUniformOffset(name, 0);
+    if (offset >= 0) {
+        FMaterialInstance::sVersion++;
+        for (size_t i = 0; i < count; i++) {
+            FMaterialInstance* const instance = upcast(instances[i]);
+            assert(instance->getMaterial() == material);
+            instance->mUniforms.setUniform<T>(size_t(offset), value);
+        }
+    }
+}
+
+// explicit template instantiation of our supported types
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool>    (MaterialInstance* const* i, size_t c, const char* name, bool     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float>   (MaterialInstance* const* i, size_t c, const char* name, float    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int32_t> (MaterialInstance* const* i, size_t c, const char* name, int32_t  v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint32_t>(MaterialInstance* const* i, size_t c, const char* name, uint32_t v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool2>   (MaterialInstance* const* i, size_t c, const char* name, bool2    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool3>   (MaterialInstance* const* i, size_t c, const char* name, bool3    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<bool4>   (MaterialInstance* const* i, size_t c, const char* name, bool4    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int2>    (MaterialInstance* const* i, size_t c, const char* name, int2     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int3>    (MaterialInstance* const* i, size_t c, const char* name, int3     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int4>    (MaterialInstance* const* i, size_t c, const char* name, int4     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint2>   (MaterialInstance* const* i, size_t c, const char* name, uint2    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint3>   (MaterialInstance* const* i, size_t c, const char* name, uint3    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint4>   (MaterialInstance* const* i, size_t c, const char* name, uint4    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float2>  (MaterialInstance* const* i, size_t c, const char* name, float2   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float3>  (MaterialInstance* const* i, size_t c, const char* name, float3   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (MaterialInstance* const* i, size_t c, const char* name, float4   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>   (MaterialInstance* const* i, size_t c, const char* name, mat3f    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (MaterialInstance* const* i, size_t c, const char* name, mat4f    v);
+
 void MaterialInstance::setParameter(const char* name, Texture const* texture,
         TextureSampler const& sampler) noexcept {
     return upcast(this)->setParameter(name, texture, sampler);
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/OcclusionBuffer.h"
+
+#include <utils/JobSystem.h>
+
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#   include <arm_neon.h>
+#   define FILAMENT_OCCLUSION_NEON 1
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#   define FILAMENT_OCCLUSION_SSE 1
+#endif
+
+using namespace math;
+using namespace utils;
+
+namespace filament {
+namespace details {
+
+// clip-space w below which geometry is considered behind the near plane
+static constexpr float NEAR_W = 1.0f / 1024.0f;
+
+OcclusionBuffer::OcclusionBuffer()
+        : mDepth(WIDTH * HEIGHT, 0.0f) {
+}
+
+OcclusionBuffer::~OcclusionBuffer() noexcept = default;
+
+// projects a near-clipped clip-space vertex to pixel coordinates and reciprocal w
+static inline void project(float4 const& clip, float2& p, float& z) noexcept {
+    const float invw = 1.0f / clip.w;
+    p.x = (clip.x * invw * 0.5f + 0.5f) * float(OcclusionBuffer::WIDTH);
+    p.y = (clip.y * invw * 0.5f + 0.5f) * float(OcclusionBuffer::HEIGHT);
+    z = invw;
+}
+
+void OcclusionBuffer::addTriangle(float4 const* clip) noexcept {
+    Triangle t;
+    for (size_t i = 0; i < 3; i++) {
+        project(clip[i], t.p[i], t.z[i]);
+    }
+
+    // scanlines are sampled at pixel centers y + 0.5
+    const float miny = std::min({ t.p[0].y, t.p[1].y, t.p[2].y });
+    const float maxy = std::max({ t.p[0].y, t.p[1].y, t.p[2].y });
+    const int32_t y0 = std::max(0, int32_t(std::ceil(miny - 0.5f)));
+    const int32_t y1 = std::min(int32_t(HEIGHT), int32_t(std::ceil(maxy - 0.5f)));
+    if (y0 >= y1) {
+        return;
+    }
+
+    // triangles entirely left or right of the buffer can't contribute any span
+    const float maxx = std::max({ t.p[0].x, t.p[1].x, t.p[2].x });
+    const float minx = std::min({ t.p[0].x, t.p[1].x, t.p[2].x });
+    if (maxx <= 0.5f || minx >= float(WIDTH) - 0.5f) {
+        return;
+    }
+
+    t.ymin = uint16_t(y0);
+    t.ymax = uint16_t(y1);
+    mTriangles.push_back(t);
+}
+
+void OcclusionBuffer::setupTriangles(float3 const* vertices,
+        uint32_t const* indices, size_t indexCount) noexcept {
+    mTriangles.clear();
+    for (size_t i = 0; i + 3 <= indexCount; i += 3) {
+        float4 clip[3];
+        size_t behind = 0;
+        for (size_t j = 0; j < 3; j++) {
+            clip[j] = mViewProjection * float4{ vertices[indices[i + j]], 1.0f };
+            behind += clip[j].w < NEAR_W;
+        }
+        if (behind == 0) {
+            addTriangle(clip);
+        } else if (behind < 3) {
+            // clip the triangle against the w = NEAR_W plane (Sutherland-Hodgman);
+            // this yields at most 4 vertices, i.e. at most two triangles
+            float4 poly[4];
+            size_t n = 0;
+            for (size_t j = 0; j < 3; j++) {
+                float4 const& a = clip[j];
+                float4 const& b = clip[(j + 1) % 3];
+                const bool ain = a.w >= NEAR_W;
+                const bool bin = b.w >= NEAR_W;
+                if (ain) {
+                    poly[n++] = a;
+                }
+                if (ain != bin) {
+                    const float s = (NEAR_W - a.w) / (b.w - a.w);
+                    poly[n++] = a + (b - a) * s;
+                }
+            }
+            for (size_t j = 2; j < n; j++) {
+                float4 const fan[3] = { poly[0], poly[j - 1], poly[j] };
+                addTriangle(fan);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeBand(uint32_t y0, uint32_t y1) noexcept {
+    float* UTILS_RESTRICT const depth = mDepth.data();
+    for (Triangle const& t : mTriangles) {
+        const uint32_t by0 = std::max(y0, uint32_t(t.ymin));
+        const uint32_t by1 = std::min(y1, uint32_t(t.ymax));
+        for (uint32_t y = by0; y < by1; y++) {
+            // intersect the scanline with the triangle's edges
+            const float yc = float(y) + 0.5f;
+            float xl = std::numeric_limits<float>::max();
+            float xr = std::numeric_limits<float>::lowest();
+            float zl = 0.0f;
+            float zr = 0.0f;
+            for (size_t e = 0; e < 3; e++) {
+                float2 const& a = t.p[e];
+                float2 const& b = t.p[(e + 1) % 3];
+                if ((a.y <= yc && b.y > yc) || (b.y <= yc && a.y > yc)) {
+                    const float s = (yc - a.y) / (b.y - a.y);
+                    const float x = a.x + s * (b.x - a.x);
+                    const float z = t.z[e] + s * (t.z[(e + 1) % 3] - t.z[e]);
+                    if (x < xl) { xl = x; zl = z; }
+                    if (x > xr) { xr = x; zr = z; }
+                }
+            }
+            if (xr <= xl) {
+                continue;
+            }
+
+            // pixels whose center lies inside [xl, xr)
+            const int32_t x0 = std::max(0, int32_t(std::ceil(xl - 0.5f)));
+            const int32_t x1 = std::min(int32_t(WIDTH), int32_t(std::ceil(xr - 0.5f)));
+            if (x0 >= x1) {
+                continue;
+            }
+            const float zstep = (zr - zl) / (xr - xl);
+            float z = zl + ((float(x0) + 0.5f) - xl) * zstep;
+            float* UTILS_RESTRICT const row = depth + y * WIDTH;
+            int32_t x = x0;
+
+#if defined(FILAMENT_OCCLUSION_NEON)
+            const float32x4_t ramp = { 0.0f, zstep, 2.0f * zstep, 3.0f * zstep };
+            float32x4_t zv = vaddq_f32(vdupq_n_f32(z), ramp);
+            const float32x4_t step4 = vdupq_n_f32(4.0f * zstep);
+            for ( ; x + 4 <= x1; x += 4) {
+                vst1q_f32(row + x, vmaxq_f32(vld1q_f32(row + x), zv));
+                zv = vaddq_f32(zv, step4);
+            }
+            z += float(x - x0) * zstep;
+#elif defined(FILAMENT_OCCLUSION_SSE)
+            const __m128 ramp = _mm_setr_ps(0.0f, zstep, 2.0f * zstep, 3.0f * zstep);
+            __m128 zv = _mm_add_ps(_mm_set1_ps(z), ramp);
+            const __m128 step4 = _mm_set1_ps(4.0f * zstep);
+            for ( ; x + 4 <= x1; x += 4) {
+                _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), zv));
+                zv = _mm_add_ps(zv, step4);
+            }
+            z += float(x - x0) * zstep;
+#endif
+            for ( ; x < x1; x++, z += zstep) {
+                row[x] = std::max(row[x], z);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::rasterize(JobSystem& js, mat4f const& viewProjection,
+        float3 const* vertices, uint32_t const* indices, size_t indexCount) noexcept {
+    mViewProjection = viewProjection;
+    setupTriangles(vertices, indices, indexCount);
+
+    std::fill(mDepth.begin(), mDepth.end(), 0.0f);
+    if (UTILS_UNLIKELY(mTriangles.empty())) {
+        return;
+    }
+
+    // each job rasterizes every triangle overlapping its band of scanlines, so bands
+    // never write to the same pixels and need no synchronization
+    const uint32_t bands = (HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    auto functor = [this](uint32_t band, uint32_t count) {
+        rasterizeBand(band * BAND_HEIGHT, std::min(HEIGHT, (band + count) * BAND_HEIGHT));
+    };
+    auto job = jobs::parallel_for(js, nullptr, 0, bands,
+            std::ref(functor), jobs::CountSplitter<1>());
+    js.runAndWait(job);
+}
+
+bool OcclusionBuffer::isOccluded(float3 const& center, float3 const& extent) const noexcept {
+    if (UTILS_UNLIKELY(mTriangles.empty())) {
+        return false;
+    }
+
+    // project the 8 corners; bail out early (i.e. keep visible) as soon as the box
+    // crosses the near plane
+    float minx = std::numeric_limits<float>::max();
+    float miny = std::numeric_limits<float>::max();
+    float maxx = std::numeric_limits<float>::lowest();
+    float maxy = std::numeric_limits<float>::lowest();
+    float boxz = 0.0f;  // reciprocal w of the corner closest to the camera
+    for (size_t i = 0; i < 8; i++) {
+        const float3 corner{
+                center.x + ((i & 1) ? extent.x : -extent.x),
+                center.y + ((i & 2) ? extent.y : -extent.y),
+                center.z + ((i & 4) ? extent.z : -extent.z) };
+        const float4 clip = mViewProjection * float4{ corner, 1.0f };
+        if (clip.w < NEAR_W) {
+            return false;
+        }
+        float2 p;
+        float z;
+        project(clip, p, z);
+        minx = std::min(minx, p.x);
+        miny = std::min(miny, p.y);
+        maxx = std::max(maxx, p.x);
+        maxy = std::max(maxy, p.y);
+        boxz = std::max(boxz, z);
+    }
+
+    // conservative screen rectangle: every pixel whose center the box could touch
+    const int32_t x0 = std::max(0, int32_t(std::floor(minx - 0.5f)));
+    const int32_t y0 = std::max(0, int32_t(std::floor(miny - 0.5f)));
+    const int32_t x1 = std::min(int32_t(WIDTH)  - 1, int32_t(std::ceil(maxx - 0.5f)));
+    const int32_t y1 = std::min(int32_t(HEIGHT) - 1, int32_t(std::ceil(maxy - 0.5f)));
+    if (x0 > x1 || y0 > y1) {
+        // the box covers no pixel center at this resolution, we can't prove it's hidden
+        return false;
+    }
+
+    // occluded if an occluder is strictly in front of the box at every covered pixel
+    float const* UTILS_RESTRICT const depth = mDepth.data();
+    for (int32_t y = y0; y <= y1; y++) {
+        float const* UTILS_RESTRICT const row = depth + y * WIDTH;
+        for (int32_t x = x0; x <= x1; x++) {
+            if (row[x] <= boxz) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void OcclusionBuffer::cullOccluded(uint8_t* UTILS_RESTRICT visibleArray,
+        float3 const* UTILS_RESTRICT center, float3 const* UTILS_RESTRICT extent,
+        size_t count, size_t bit) const noexcept {
+    const uint8_t mask = uint8_t(1u << bit);
+    for (size_t i = 0; i < count; i++) {
+        if ((visibleArray[i] & mask) && isOccluded(center[i], extent[i])) {
+            visibleArray[i] &= uint8_t(~mask);
+        }
+    }
+}
+
+} // namespace details
+} // namespace filament
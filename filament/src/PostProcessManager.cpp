@@ -21,6 +21,11 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
 namespace filament {
 
 using namespace utils;
@@ -40,11 +45,251 @@ void PostProcessManager::init(FEngine& engine) noexcept {
     mPostProcessUbh = driver.createUniformBuffer(engine.getPerPostProcessUib().getSize());
     driver.bindSamplers(BindingPoints::POST_PROCESS, mPostProcessSbh);
     driver.bindUniforms(BindingPoints::POST_PROCESS, mPostProcessUbh);
+
+    engine.getDebugRegistry().registerProperty("d.postprocess.tonemap_lut",
+            &engine.debug.postprocess.tonemap_lut);
+    engine.getDebugRegistry().registerProperty("d.postprocess.auto_exposure",
+            &engine.debug.postprocess.auto_exposure);
 }
 
 void PostProcessManager::terminate(driver::DriverApi& driver) noexcept {
     driver.destroySamplerBuffer(mPostProcessSbh);
     driver.destroyUniformBuffer(mPostProcessUbh);
+    if (mToneMappingLut) {
+        driver.destroyTexture(mToneMappingLut);
+        mToneMappingLut.clear();
+    }
+    if (mHistory.target) {
+        driver.destroyRenderTarget(mHistory.target);
+        mHistory.target.clear();
+    }
+    if (mHistory.texture) {
+        driver.destroyTexture(mHistory.texture);
+        mHistory.texture.clear();
+    }
+    mHistory.valid = false;
+    if (mExposure.pyramid) {
+        driver.destroyRenderTarget(mExposure.pyramidTarget);
+        driver.destroyTexture(mExposure.pyramid);
+        for (size_t i = 0; i < 2; i++) {
+            driver.destroyRenderTarget(mExposure.adaptedTarget[i]);
+            driver.destroyTexture(mExposure.adapted[i]);
+        }
+        mExposure = {};
+    }
+}
+
+PostProcessManager::History const& PostProcessManager::prepareHistory(DriverApi& driver,
+        uint32_t width, uint32_t height, TextureFormat format) noexcept {
+    History& history = mHistory;
+    if (history.width != width || history.height != height || history.format != format) {
+        if (history.target) {
+            driver.destroyRenderTarget(history.target);
+        }
+        if (history.texture) {
+            driver.destroyTexture(history.texture);
+        }
+        history.texture = driver.createTexture(SamplerType::SAMPLER_2D, 1,
+                format, 1, width, height, 1, TextureUsage::COLOR_ATTACHMENT);
+        history.target = driver.createRenderTarget(TargetBufferFlags::COLOR,
+                width, height, 1, format, { history.texture }, {}, {});
+        history.width = width;
+        history.height = height;
+        history.format = format;
+        history.valid = false;
+    }
+    return history;
+}
+
+void PostProcessManager::autoExposure(DriverApi& driver,
+        RenderTargetPool::Target const* hdrTarget, Viewport const& svp) noexcept {
+    FEngine& engine = *mEngine;
+    auto& exposure = mExposure;
+
+    if (UTILS_UNLIKELY(!exposure.pyramid)) {
+        exposure.pyramid = driver.createTexture(SamplerType::SAMPLER_2D, LUMINANCE_LEVELS,
+                TextureFormat::R16F, 1, LUMINANCE_SIZE, LUMINANCE_SIZE, 1,
+                TextureUsage::COLOR_ATTACHMENT);
+        exposure.pyramidTarget = driver.createRenderTarget(TargetBufferFlags::COLOR,
+                LUMINANCE_SIZE, LUMINANCE_SIZE, 1, TextureFormat::R16F,
+                { exposure.pyramid }, {}, {});
+        for (size_t i = 0; i < 2; i++) {
+            exposure.adapted[i] = driver.createTexture(SamplerType::SAMPLER_2D, 1,
+                    TextureFormat::R16F, 1, 1, 1, 1, TextureUsage::COLOR_ATTACHMENT);
+            exposure.adaptedTarget[i] = driver.createRenderTarget(TargetBufferFlags::COLOR,
+                    1, 1, 1, TextureFormat::R16F, { exposure.adapted[i] }, {}, {});
+        }
+    }
+
+    Handle<HwRenderPrimitive> const& fullScreenRenderPrimitive =
+            engine.getFullScreenRenderPrimitive();
+
+    Driver::RasterState rs;
+    rs.culling = Driver::RasterState::CullingMode::NONE;
+    rs.colorWrite = true;
+    rs.depthFunc = Driver::RasterState::DepthFunc::A;
+
+    RenderPassParams params = {};
+    params.discardStart = TargetBufferFlags::ALL;
+    params.discardEnd = TargetBufferFlags::DEPTH_AND_STENCIL;
+    params.left = 0;
+    params.bottom = 0;
+    params.width = LUMINANCE_SIZE;
+    params.height = LUMINANCE_SIZE;
+    params.dependencies = RenderPassParams::DEPENDENCY_BY_REGION;
+
+    // log-luminance of the color buffer into the pyramid's base...
+    setSource(svp.width, svp.height, hdrTarget);
+    driver.beginRenderPass(exposure.pyramidTarget, params);
+    driver.draw(engine.getPostProcessProgram(PostProcessStage::LUMINANCE_DOWNSAMPLE),
+            rs, fullScreenRenderPrimitive, 1);
+    driver.endRenderPass();
+
+    // ...averaged through the mip chain: the top mip holds the average log-luminance,
+    // i.e. the log of the scene's geometric mean luminance
+    driver.generateMipmaps(exposure.pyramid);
+
+    // exponential adaptation towards the new average, with a ~1.5s time constant
+    // (jump straight to it when there is no previous value)
+    const double now = std::chrono::duration<double>(engine.getTime()).count();
+    float adaptation = 1.0f;
+    if (exposure.valid) {
+        adaptation = float(1.0 - std::exp((exposure.lastTime - now) / 1.5));
+    }
+    exposure.lastTime = now;
+
+    // adapt into a 1x1 target, ping-ponging with the previous frame's value
+    const uint8_t previous = exposure.current;
+    const uint8_t current = uint8_t(1 - previous);
+
+    driver::SamplerParams sparams;
+    sparams.filterMag = SamplerMagFilter::LINEAR;
+    sparams.filterMin = SamplerMinFilter::LINEAR_MIPMAP_NEAREST;
+    SamplerBuffer sb(engine.getPostProcessSib());
+    sb.setSampler(FEngine::PostProcessSib::COLOR_BUFFER, exposure.pyramid, sparams);
+    sb.setSampler(FEngine::PostProcessSib::LUMINANCE, exposure.adapted[previous], sparams);
+
+    UniformBuffer& ub = mPostProcessUb;
+    ub.setUniform(offsetof(FEngine::PostProcessingUib, uvScale), math::float2{ 1.0f, 1.0f });
+    ub.setUniform(offsetof(FEngine::PostProcessingUib, exposureInfo),
+            math::float4{ 0.0f, adaptation, float(LUMINANCE_LEVELS - 1), 0.0f });
+    driver.updateSamplerBuffer(mPostProcessSbh, std::move(sb));
+    driver.updateUniformBuffer(mPostProcessUbh, UniformBuffer(ub));
+
+    params.width = 1;
+    params.height = 1;
+    driver.beginRenderPass(exposure.adaptedTarget[current], params);
+    driver.draw(engine.getPostProcessProgram(PostProcessStage::LUMINANCE_ADAPTATION),
+            rs, fullScreenRenderPrimitive, 1);
+    driver.endRenderPass();
+
+    exposure.current = current;
+    exposure.valid = true;
+
+    // the tone-mapping stage picks this up in setSource()
+    mAdaptedLuminance = exposure.adapted[current];
+}
+
+void PostProcessManager::prefilterShadowMap(DriverApi& driver, Handle<HwTexture> depth,
+        Handle<HwRenderTarget> momentsTarget, Handle<HwTexture> moments,
+        uint32_t dimension) noexcept {
+    FEngine& engine = *mEngine;
+
+    Handle<HwRenderPrimitive> const& fullScreenRenderPrimitive =
+            engine.getFullScreenRenderPrimitive();
+
+    Driver::RasterState rs;
+    rs.culling = Driver::RasterState::CullingMode::NONE;
+    rs.colorWrite = true;
+    rs.depthFunc = Driver::RasterState::DepthFunc::A;
+
+    RenderPassParams params = {};
+    params.discardStart = TargetBufferFlags::ALL;
+    params.discardEnd = TargetBufferFlags::DEPTH_AND_STENCIL;
+    params.left = 0;
+    params.bottom = 0;
+    params.width = dimension;
+    params.height = dimension;
+    params.dependencies = RenderPassParams::DEPENDENCY_BY_REGION;
+
+    // the depth is read as a plain texture here (no depth compare)
+    driver::SamplerParams sparams;
+    sparams.filterMag = SamplerMagFilter::NEAREST;
+    sparams.filterMin = SamplerMinFilter::NEAREST;
+    sparams.depthStencil = true;
+    SamplerBuffer sb(engine.getPostProcessSib());
+    sb.setSampler(FEngine::PostProcessSib::COLOR_BUFFER, depth, sparams);
+
+    UniformBuffer& ub = mPostProcessUb;
+    ub.setUniform(offsetof(FEngine::PostProcessingUib, uvScale), math::float2{ 1.0f, 1.0f });
+    driver.updateSamplerBuffer(mPostProcessSbh, std::move(sb));
+    driver.updateUniformBuffer(mPostProcessUbh, UniformBuffer(ub));
+
+    // warp the depth into exponential space and write the first two moments...
+    driver.beginRenderPass(momentsTarget, params);
+    driver.draw(engine.getPostProcessProgram(PostProcessStage::SHADOW_PREFILTER),
+            rs, fullScreenRenderPrimitive, 1);
+    driver.endRenderPass();
+
+    // ...then build the mip chain; hardware trilinear filtering over it is what makes
+    // the shader's kernel width free
+    driver.generateMipmaps(moments);
+}
+
+UTILS_ALWAYS_INLINE
+static inline float OECF_sRGB(float x) noexcept {
+    // IEC 61966-2-1:1999
+    return x <= 0.0031308f ? x * 12.92f : 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+}
+
+UTILS_ALWAYS_INLINE
+static inline float tonemap_ACES(float x) noexcept {
+    // Narkowicz 2015, "ACES Filmic Tone Mapping Curve"
+    constexpr float a = 2.51f;
+    constexpr float b = 0.03f;
+    constexpr float c = 2.43f;
+    constexpr float d = 0.59f;
+    constexpr float e = 0.14f;
+    return (x * (a * x + b)) / (x * (c * x + d) + e);
+}
+
+void PostProcessManager::bakeToneMappingLut() const noexcept {
+    FEngine& engine = *mEngine;
+    DriverApi& driver = engine.getDriverApi();
+
+    // The LUT bakes the full ACES curve and exact sRGB OECF -- since each entry is
+    // evaluated only once on the CPU, the runtime cost of the quality operators is moot.
+    // Entries are indexed in x / (1 + x) space covering [0, TONEMAP_LUT_MAX_HDR], which
+    // gives darker values more precision; the blue axis selects one of the LUT_SIZE
+    // slices laid out along x (see colorGrade() in post_process.fs).
+    constexpr size_t N = TONEMAP_LUT_SIZE;
+    constexpr float cMax = TONEMAP_LUT_MAX_HDR / (1.0f + TONEMAP_LUT_MAX_HDR);
+
+    const size_t size = N * N * N * 3;
+    uint8_t* const data = static_cast<uint8_t*>(malloc(size));
+    uint8_t* p = data;
+    float hdr[N];
+    for (size_t i = 0; i < N; i++) {
+        const float c = (float(i) / float(N - 1)) * cMax;
+        hdr[i] = c / (1.0f - c);
+    }
+    for (size_t g = 0; g < N; g++) {            // v
+        for (size_t b = 0; b < N; b++) {        // slice
+            for (size_t r = 0; r < N; r++) {    // u within the slice
+                const float lut[3] = { hdr[r], hdr[g], hdr[b] };
+                for (float const c : lut) {
+                    const float v = OECF_sRGB(tonemap_ACES(c));
+                    *p++ = uint8_t(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+
+    mToneMappingLut = driver.createTexture(SamplerType::SAMPLER_2D, 1,
+            TextureFormat::RGB8, 1, N * N, N, 1, TextureUsage::DEFAULT);
+    driver.load2DImage(mToneMappingLut, 0, 0, 0, N * N, N,
+            PixelBufferDescriptor(data, size, PixelDataFormat::RGB, PixelDataType::UBYTE,
+                    [](void* buffer, size_t, void*) { free(buffer); }));
 }
 
 void PostProcessManager::setSource(uint32_t viewportWidth, uint32_t viewportHeight,
@@ -60,6 +305,20 @@ void PostProcessManager::setSource(uint32_t viewportWidth, uint32_t viewportHeig
     SamplerBuffer sb(engine.getPostProcessSib());
     sb.setSampler(FEngine::PostProcessSib::COLOR_BUFFER, pos->texture, params);
 
+    const bool useToneMappingLut = engine.debug.postprocess.tonemap_lut;
+    if (UTILS_UNLIKELY(useToneMappingLut)) {
+        if (UTILS_UNLIKELY(!mToneMappingLut)) {
+            bakeToneMappingLut();
+        }
+        // bilinear filtering handles the red/green axes of the LUT
+        sb.setSampler(FEngine::PostProcessSib::COLOR_GRADING_LUT, mToneMappingLut, params);
+    }
+
+    const bool autoExposure = bool(mAdaptedLuminance);
+    if (UTILS_UNLIKELY(autoExposure)) {
+        sb.setSampler(FEngine::PostProcessSib::LUMINANCE, mAdaptedLuminance, params);
+    }
+
     auto duration = engine.getTime();
     float fraction = (duration.count() % 1000000000) / 1000000000.0f;
 
@@ -73,6 +332,16 @@ void PostProcessManager::setSource(uint32_t viewportWidth, uint32_t viewportHeig
     const float yOffset = pos->h - viewportHeight;
     ub.setUniform(offsetof(FEngine::PostProcessingUib, yOffset), yOffset);
 
+    constexpr float cMax = TONEMAP_LUT_MAX_HDR / (1.0f + TONEMAP_LUT_MAX_HDR);
+    ub.setUniform(offsetof(FEngine::PostProcessingUib, lutInfo),
+            math::float4{ useToneMappingLut ? 1.0f : 0.0f,
+                          float(TONEMAP_LUT_SIZE), 1.0f / cMax, 0.0f });
+
+    // maps the adapted average luminance to a 18% middle-grey (only the tone-mapping
+    // stage uses this)
+    ub.setUniform(offsetof(FEngine::PostProcessingUib, exposureInfo),
+            math::float4{ autoExposure ? 1.0f : 0.0f, 0.0f, 0.0f, 0.18f });
+
     driver.updateSamplerBuffer(mPostProcessSbh, std::move(sb));
     driver.updateUniformBuffer(mPostProcessUbh, UniformBuffer(ub));
 }
@@ -102,6 +371,7 @@ void PostProcessManager::finish(driver::TargetBufferFlags discarded,
 
     if (UTILS_UNLIKELY(commands.empty())) {
         rtp.put(previous);
+        mAdaptedLuminance.clear();
         return;
     }
 
@@ -135,7 +405,7 @@ void PostProcessManager::finish(driver::TargetBufferFlags discarded,
 
             // draw a full screen triangle
             driver.beginRenderPass(target->target, params);
-            driver.draw(commands[i].program, rs, fullScreenRenderPrimitive);
+            driver.draw(commands[i].program, rs, fullScreenRenderPrimitive, 1);
             driver.endRenderPass();
         } else {
             driver.blit(TargetBufferFlags::COLOR,
@@ -162,7 +432,7 @@ void PostProcessManager::finish(driver::TargetBufferFlags discarded,
 
         setSource(params.width, params.height, previous);
         driver.beginRenderPass(viewRenderTarget, params);
-        driver.draw(commands.back().program, rs, fullScreenRenderPrimitive);
+        driver.draw(commands.back().program, rs, fullScreenRenderPrimitive, 1);
         driver.endRenderPass();
 
     } else {
@@ -175,6 +445,9 @@ void PostProcessManager::finish(driver::TargetBufferFlags discarded,
 
     // clear our command buffer
     commands.clear();
+
+    // the adapted luminance is only valid for the frame autoExposure() ran in
+    mAdaptedLuminance.clear();
 }
 
 } // namespace filament
@@ -58,6 +58,50 @@ public:
             RenderTargetPool::Target const* linearTarget,
             Viewport const& svp);
 
+    /*
+     * History buffer for temporal effects (TAA): a sampleable color target that
+     * persists across frames, unlike RenderTargetPool targets which are recycled at
+     * the end of each frame.
+     */
+    struct History {
+        Handle<HwTexture> texture;
+        Handle<HwRenderTarget> target;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        driver::TextureFormat format{};
+        // true when the buffer holds the previous frame's contents; false right after
+        // (re)allocation, i.e. temporal accumulation must be restarted
+        bool valid = false;
+    };
+
+    // Returns the history buffer for the given dimensions and format, (re)allocating it
+    // when they changed. The caller renders into it and then calls commitHistory().
+    History const& prepareHistory(driver::DriverApi& driver,
+            uint32_t width, uint32_t height, driver::TextureFormat format) noexcept;
+
+    // marks the history buffer as holding valid data for the next frame
+    void commitHistory() noexcept { mHistory.valid = true; }
+
+    // invalidates the history contents (e.g. on a camera cut)
+    void invalidateHistory() noexcept { mHistory.valid = false; }
+
+    /*
+     * GPU auto-exposure: renders the color buffer's log-luminance into a small pyramid,
+     * averages it through the mip chain and temporally adapts the result into a 1x1
+     * target consumed by the tone-mapping stage -- no CPU readback involved. Must be
+     * called before finish(), from the post-process pass.
+     */
+    void autoExposure(driver::DriverApi& driver, RenderTargetPool::Target const* hdrTarget,
+            Viewport const& svp) noexcept;
+
+    /*
+     * Soft shadows (EVSM): converts the shadow map's depth into exponentially-warped
+     * moments and builds their mip chain, which the surface shaders then sample with
+     * hardware trilinear filtering (see ShadowMap::prefilter()).
+     */
+    void prefilterShadowMap(driver::DriverApi& driver, Handle<HwTexture> depth,
+            Handle<HwRenderTarget> momentsTarget, Handle<HwTexture> moments,
+            uint32_t dimension) noexcept;
 
 private:
     details::FEngine* mEngine = nullptr;
@@ -69,10 +113,36 @@ private:
 
     std::vector<Command> mCommands;
 
+    History mHistory;
+
+    // auto-exposure resources (see autoExposure())
+    static constexpr uint32_t LUMINANCE_SIZE = 64;  // must be a power-of-two
+    static constexpr uint8_t LUMINANCE_LEVELS = 7;  // log2(LUMINANCE_SIZE) + 1
+    struct {
+        Handle<HwTexture> pyramid;              // R16F log-luminance, full mip chain
+        Handle<HwRenderTarget> pyramidTarget;   // renders into the pyramid's base
+        Handle<HwTexture> adapted[2];           // 1x1 adapted average, ping-pong
+        Handle<HwRenderTarget> adaptedTarget[2];
+        double lastTime = 0.0;                  // of the last adaptation, in seconds
+        uint8_t current = 0;                    // adapted[] written last
+        bool valid = false;                     // adapted[current] holds a value
+    } mExposure;
+    // set for the frame by autoExposure(), bound to the tone-mapping stage by setSource()
+    Handle<HwTexture> mAdaptedLuminance;
+
     // we need only one of these
     mutable UniformBuffer mPostProcessUb;
     Handle<HwSamplerBuffer> mPostProcessSbh;
     Handle<HwUniformBuffer> mPostProcessUbh;
+
+    // tone-mapping LUT (see d.postprocess.tonemap_lut): tone-mapping + OECF baked into a
+    // 3D LUT stored as a 2D texture, so the per-pixel path becomes a single fetch. Baked
+    // lazily the first time it's needed; would need re-baking if the transform ever
+    // became parameter-dependent.
+    void bakeToneMappingLut() const noexcept;
+    mutable Handle<HwTexture> mToneMappingLut;
+    static constexpr size_t TONEMAP_LUT_SIZE = 32;
+    static constexpr float TONEMAP_LUT_MAX_HDR = 16.0f;
 };
 
 } // namespace filament
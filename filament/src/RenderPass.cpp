@@ -16,6 +16,8 @@
 
 #include "RenderPass.h"
 
+#include "components/RenderableManager.h"
+
 #include "details/Culler.h"
 #include "details/Material.h"
 #include "details/MaterialInstance.h"
@@ -27,8 +29,12 @@
 #include "details/Renderer.h"
 
 #include <utils/JobSystem.h>
+#include <utils/RadixSort.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <limits>
+
 using namespace utils;
 using namespace math;
 
@@ -40,6 +46,14 @@ namespace details {
 
 RenderPass::~RenderPass() noexcept = default;
 
+bool RenderPass::separateBlendedCommands() const noexcept {
+    return false;
+}
+
+void RenderPass::renderBlendedCommands(FEngine&, driver::DriverApi&,
+        Viewport const&, Slice<Command> const&) noexcept {
+}
+
 UTILS_ALWAYS_INLINE // this allows the compiler to devirtualize some calls
 inline              // this removes the code from the compilation unit
 void RenderPass::render(
@@ -49,6 +63,21 @@ void RenderPass::render(
         const CameraInfo& camera, Viewport const& viewport,
         GrowingSlice<Command>& commands) noexcept {
 
+    appendSortedCommands(engine, js, soa, vr, commandTypeFlags, renderFlags,
+            camera, commands);
+
+    // execute the commands
+    submit(engine, camera, viewport, commands);
+}
+
+UTILS_NOINLINE
+Slice<RenderPass::Command> RenderPass::appendSortedCommands(
+        FEngine& engine, JobSystem& js,
+        FScene::RenderableSoa const& soa, Range<uint32_t> vr,
+        uint32_t commandTypeFlags, RenderFlags renderFlags,
+        const CameraInfo& camera,
+        GrowingSlice<Command>& commands) noexcept {
+
     SYSTRACE_CONTEXT();
 
     // trace the number of visible renderables
@@ -68,6 +97,11 @@ void RenderPass::render(
     // we extract camera position/forward outside of the loop, because these are not cheap.
     const float3 cameraPosition(camera.getPosition());
     const float3 cameraForwardVector(camera.getForwardVector());
+
+    // Command generation below is parallelized across JobSystem workers; each slice writes
+    // into its own disjoint span of the command array, computed from SUMMED_PRIMITIVE_COUNT
+    // (see generateCommands()), so the radix of the subsequent sort sees a single contiguous
+    // buffer and no synchronization is needed between slices.
     auto work = [commandTypeFlags, curr, &soa, renderFlags, cameraPosition, cameraForwardVector]
             (uint32_t startIndex, uint32_t indexCount) {
         RenderPass::generateCommands(commandTypeFlags, curr,
@@ -88,9 +122,38 @@ void RenderPass::render(
     // command buffer.
     commands.grow(1)->key = uint64_t(Pass::SENTINEL);
 
-    { // sort all commands
-        SYSTRACE_NAME("sort commands");
-        std::sort(commands.begin(), commands.end());
+    // sort all commands
+    sortCommands(engine, commands);
+
+    // fold runs of identical draws into instanced draws
+    mergeInstancedCommands(commands);
+
+    return Slice<Command>(commands.begin(), commands.end());
+}
+
+UTILS_NOINLINE
+void RenderPass::submit(FEngine& engine, const CameraInfo& camera,
+        Viewport const& viewport, GrowingSlice<Command>& commands) noexcept {
+
+    // optionally split the blended commands out of the main pass, so they can be
+    // rendered separately (e.g. at half resolution, see ColorPass). The sort has moved
+    // them to a contiguous run just before the sentinel, so splitting is a matter of
+    // terminating the main pass early with a temporary sentinel key.
+    Command* split = commands.end();
+    CommandKey splitKey = 0;
+    if (UTILS_UNLIKELY(separateBlendedCommands())) {
+        split = std::partition_point(commands.begin(), commands.end(),
+                [](Command const& c) {
+                    return (c.key & PASS_MASK) < uint64_t(Pass::BLENDED);
+                });
+        if (split != commands.end() &&
+                (split->key & PASS_MASK) == uint64_t(Pass::BLENDED)) {
+            splitKey = split->key;
+            split->key = uint64_t(Pass::SENTINEL);
+        } else {
+            // no blended commands this frame (or only cancelled ones)
+            split = commands.end();
+        }
     }
 
     // Take care not to upload data within the render pass (synchronize can commit froxel data)
@@ -98,25 +161,127 @@ void RenderPass::render(
     beginRenderPass(driver, viewport, camera);
 
     // Now, execute all commands
-    RenderPass::recordDriverCommands(driver, commands);
+    RenderPass::recordDriverCommands(engine, driver, commands, mOcclusionQueries);
 
     endRenderPass(driver, viewport);
 
+    if (UTILS_UNLIKELY(split != commands.end())) {
+        // restore the key we overwrote above and render the blended commands; the
+        // slice keeps the real sentinel as its terminator.
+        split->key = splitKey;
+        renderBlendedCommands(engine, driver, viewport,
+                Slice<Command>(split, commands.end()));
+    }
+
     // Kick the GPU since we're done with this render target
     driver.flush();
     // Wake-up the driver thread
     engine.flush();
 }
 
+UTILS_NOINLINE
+void RenderPass::renderTiles(FEngine& engine, const CameraInfo& camera,
+        Viewport const& viewport, Slice<Tile> const& tiles) noexcept {
+
+    driver::DriverApi& driver = engine.getDriverApi();
+    const size_t perViewSize = engine.getPerViewUib().getSize();
+
+    beginRenderPass(driver, viewport, camera);
+
+    for (Tile const& tile : tiles) {
+        Viewport const& tv = tile.viewport;
+        // the driver clips each draw's scissor against the current viewport (see
+        // setViewportScissor), so setting the viewport per tile is enough to confine
+        // the per-draw scissor to the tile
+        driver.viewport(tv.left, tv.bottom, tv.width, tv.height);
+        if (tile.perViewUniforms) {
+            // each tile renders with its own camera; its uniform block was committed
+            // by the caller before the pass began
+            driver.bindUniformsRange(BindingPoints::PER_VIEW, tile.perViewUniforms,
+                    tile.perViewOffset, perViewSize);
+        }
+        recordDriverCommands(engine, driver, tile.commands, mOcclusionQueries);
+    }
+
+    endRenderPass(driver, viewport);
+
+    // Kick the GPU since we're done with this render target
+    driver.flush();
+    // Wake-up the driver thread
+    engine.flush();
+}
+
+UTILS_NOINLINE
+void RenderPass::sortCommands(FEngine& engine, GrowingSlice<Command>& commands) noexcept {
+    SYSTRACE_NAME("sort commands");
+
+    size_t const count = commands.size();
+
+    // ping-pong scratch buffer, taken from the per-renderpass arena and released on return;
+    // not needed below the radix threshold, and if the arena is exhausted (shouldn't happen
+    // in practice) RadixSort falls back to introsort
+    ArenaScope arena(engine.getPerRenderPassAllocator());
+    Command* scratch = nullptr;
+    if (count >= RadixSort::MIN_COUNT) {
+        scratch = arena.allocate<Command>(count, CACHELINE_SIZE);
+    }
+
+    // LSD radix sort on the 64-bit key. The histogram sweep is sliced across the job
+    // workers, and passes over the uniform high-order fields of the key (pass, blending,
+    // priority -- see the key layout in RenderPass.h) are skipped, so a typical frame
+    // needs only 3-4 scatter passes. Unlike introsort, this is stable by construction.
+    RadixSort::sort(engine.getJobSystem(),
+            Slice<Command>(commands.begin(), Slice<Command>::size_type(count)),
+            Slice<Command>(scratch, Slice<Command>::size_type(scratch ? count : 0)),
+            [](Command const& command) { return command.key; });
+}
+
+UTILS_NOINLINE
+void RenderPass::mergeInstancedCommands(Slice<Command>& commands) noexcept {
+    SYSTRACE_CALL();
+
+    // After sorting, draws of the same material/primitive are adjacent. A run of commands
+    // that are identical draws -- everything per-instance data could express is still bound
+    // per draw today, so "identical" includes the per-renderable uniforms -- is folded into
+    // its first command with an instance count; the others are marked to be skipped.
+    Command* const begin = commands.begin();
+    for (Command* c = begin; c->key != uint64_t(Pass::SENTINEL); ) {
+        PrimitiveInfo& UTILS_RESTRICT first = c->primitive;
+        Command* n = c + 1;
+        while (n->key != uint64_t(Pass::SENTINEL)
+                && n->primitive.mi == first.mi
+                && n->primitive.primitiveHandle == first.primitiveHandle
+                && n->primitive.programHandle == first.programHandle
+                && n->primitive.perRenderableOffset == first.perRenderableOffset
+                && n->primitive.perRenderableBones == first.perRenderableBones
+                && !(n->primitive.rasterState != first.rasterState)
+                && first.instanceCount < std::numeric_limits<uint16_t>::max()) {
+            n->primitive.instanceCount = 0;
+            first.instanceCount++;
+            ++n;
+        }
+        c = n;
+    }
+}
+
 UTILS_NOINLINE // no need to be inlined
 void RenderPass::recordDriverCommands(
+        FEngine& engine,
         FEngine::DriverApi& UTILS_RESTRICT driver,  // using restrict here is very important
-        Slice<Command> const& commands) noexcept {
+        Slice<Command> const& commands,
+        OcclusionQueryRecorder const* const occlusionQueries) noexcept {
     SYSTRACE_CALL();
 
     if (!commands.empty()) {
+        // every per-renderable block lives in the renderable manager's uniform arena;
+        // per-draw binds below just move an offset within that one buffer
+        FRenderableManager const& rcm = engine.getRenderableManager();
+        const Handle<HwUniformBuffer> uniformArena = rcm.getUniformBufferArena();
+        const size_t uniformSize = engine.getPerRenderableUib().getSize();
+
+        uint64_t drawCalls = 0;
+        uint64_t foldedCommands = 0;
         FMaterialInstance const* UTILS_RESTRICT previousMi = nullptr;
-        FMaterial const* UTILS_RESTRICT ma = nullptr;
         Command const* UTILS_RESTRICT c;
         for (c = commands.cbegin(); c->key != -1LLU; ++c) {
             /*
@@ -125,7 +290,14 @@ void RenderPass::recordDriverCommands(
 
             // per-renderable uniform
             PrimitiveInfo const& UTILS_RESTRICT info = c->primitive;
-            driver.bindUniforms(BindingPoints::PER_RENDERABLE, info.perRenderableUniforms);
+            if (UTILS_UNLIKELY(info.instanceCount == 0)) {
+                // this command was folded into a preceding instanced draw
+                foldedCommands++;
+                continue;
+            }
+            drawCalls++;
+            driver.bindUniformsRange(BindingPoints::PER_RENDERABLE, uniformArena,
+                    info.perRenderableOffset, uniformSize);
             if (info.perRenderableBones) {
                 driver.bindUniforms(BindingPoints::PER_RENDERABLE_BONES, info.perRenderableBones);
             }
@@ -135,14 +307,41 @@ void RenderPass::recordDriverCommands(
                 // this is always taken the first time
                 previousMi = mi;
                 mi->use(driver);
-                ma = mi->getMaterial();
             }
 
-            Handle<HwProgram> const ph = ma->getProgram(info.materialVariant.key);
-            driver.draw(ph, info.rasterState, info.primitiveHandle);
+            if (UTILS_UNLIKELY(occlusionQueries)) {
+                Handle<HwOcclusionQuery> const query =
+                        occlusionQueries->queryFor(info.perRenderableOffset);
+                if (query) {
+                    if ((c->key & PASS_MASK) == uint64_t(Pass::DEPTH)) {
+                        // phase 1: measure the renderable's visibility around its
+                        // depth-pass draw (queries can't nest, so only slots with a
+                        // single depth draw carry a query, see FView)
+                        driver.beginOcclusionQuery(query);
+                        driver.draw(info.programHandle, info.rasterState,
+                                info.primitiveHandle, info.instanceCount);
+                        driver.endOcclusionQuery(query);
+                    } else {
+                        // phase 2: predicate the color draw on the query; backends
+                        // with conditional rendering use this frame's depth-pass
+                        // result, others fall back to the last collected one
+                        driver.drawConditional(info.programHandle, info.rasterState,
+                                info.primitiveHandle, info.instanceCount, query);
+                    }
+                    continue;
+                }
+            }
+
+            // the program was resolved in generateCommands(), no lookup needed here
+            driver.draw(info.programHandle, info.rasterState, info.primitiveHandle,
+                    info.instanceCount);
         }
 
         SYSTRACE_VALUE32("commandCount", c - commands.cbegin());
+
+        // counted locally above so the hot loop pays for two atomic adds per pass, not per draw
+        engine.counters.drawCalls.fetch_add(drawCalls, std::memory_order_relaxed);
+        engine.counters.instancedDraws.fetch_add(foldedCommands, std::memory_order_relaxed);
     }
 }
 
@@ -153,8 +352,8 @@ void RenderPass::setupColorCommand(Command& cmdDraw, bool hasDepthPass,
         FMaterialInstance const* const UTILS_RESTRICT mi) noexcept {
 
     FMaterial const * const UTILS_RESTRICT ma = mi->getMaterial();
-    uint8_t variant =
-            Variant::filterVariant(cmdDraw.primitive.materialVariant.key, ma->isVariantLit());
+    // variant filtering is a precomputed per-material table lookup (see FMaterial)
+    uint8_t variant = ma->getFilteredVariant(cmdDraw.primitive.materialVariant.key);
 
     // Below, we evaluate both commands to avoid a branch
 
@@ -265,10 +464,12 @@ void RenderPass::generateCommandsImpl(uint32_t,
     const bool shadowPass = bool(commandTypeFlags & CommandTypeFlags::SHADOW);
 
     auto const* const UTILS_RESTRICT soaWorldAABBCenter = soa.data<FScene::WORLD_AABB_CENTER>();
+    auto const* const UTILS_RESTRICT soaWorldTransform  = soa.data<FScene::WORLD_TRANSFORM>();
     auto const* const UTILS_RESTRICT soaVisibility      = soa.data<FScene::VISIBILITY_STATE>();
     auto const* const UTILS_RESTRICT soaPrimitives      = soa.data<FScene::PRIMITIVES>();
-    auto const* const UTILS_RESTRICT soaUbh             = soa.data<FScene::UBH>();
+    auto const* const UTILS_RESTRICT soaUboOffset       = soa.data<FScene::UBO_OFFSET>();
     auto const* const UTILS_RESTRICT soaBonesUbh        = soa.data<FScene::BONES_UBH>();
+    auto const* const UTILS_RESTRICT soaVisibleMask     = soa.data<FScene::VISIBLE_MASK>();
 
     const bool hasShadowing = renderFlags & HAS_SHADOWING;
     Variant materialVariant;
@@ -318,7 +519,8 @@ void RenderPass::generateCommandsImpl(uint32_t,
         const uint32_t distanceBits = reinterpret_cast<uint32_t&>(distance);
 
         cmdColor.key = makeField(soaVisibility[i].priority, PRIORITY_MASK, PRIORITY_SHIFT);
-        cmdColor.primitive.perRenderableUniforms = soaUbh[i];
+        cmdColor.key |= makeField(soaVisibility[i].sortGroup, SORT_GROUP_MASK, SORT_GROUP_SHIFT);
+        cmdColor.primitive.perRenderableOffset = soaUboOffset[i];
         cmdColor.primitive.perRenderableBones = soaBonesUbh[i];
         materialVariant.setShadowReceiver(soaVisibility[i].receiveShadows & hasShadowing);
         materialVariant.setSkinning(soaVisibility[i].skinning);
@@ -328,14 +530,28 @@ void RenderPass::generateCommandsImpl(uint32_t,
         cmdDepth.key = uint64_t(Pass::DEPTH);
         cmdDepth.key |= makeField(soaVisibility[i].priority, PRIORITY_MASK, PRIORITY_SHIFT);
         cmdDepth.key |= makeField(distanceBits, DISTANCE_BITS_MASK, DISTANCE_BITS_SHIFT);
-        cmdDepth.primitive.perRenderableUniforms = soaUbh[i];
+        cmdDepth.primitive.perRenderableOffset = soaUboOffset[i];
         cmdDepth.primitive.perRenderableBones = soaBonesUbh[i];
         cmdDepth.primitive.materialVariant.setSkinning(soaVisibility[i].skinning);
 
         const bool shadowCaster = soaVisibility[i].castShadows & hasShadowing;
         const bool writeDepthForShadows = shadowPass & shadowCaster;
 
+        // color commands of renderables whose occlusion query reported "hidden" last
+        // frame are cancelled; their depth commands below are unaffected, so the query
+        // keeps testing them and they reappear when disoccluded (see FView)
+        const uint64_t gpuOccludedCancel = colorPass ?
+                select(soaVisibleMask[i] & FScene::VISIBLE_MASK_GPU_OCCLUDED) : 0llu;
+
         const Slice<FRenderPrimitive>& primitives = soaPrimitives[i];
+        const mat4f& worldTransform = soaWorldTransform[i];
+
+        // conservative world-space scale of the renderable's transform, used to scale the
+        // primitives' object-space bounding sphere radii for the normal cone test below
+        const float sphereScale = std::sqrt(std::max(std::max(
+                length2(worldTransform[0].xyz),
+                length2(worldTransform[1].xyz)),
+                length2(worldTransform[2].xyz)));
 
         /*
          * This is our hot loop. It's written to avoid branches.
@@ -343,11 +559,34 @@ void RenderPass::generateCommandsImpl(uint32_t,
          */
         for (auto const& primitive : primitives) {
             FMaterialInstance const* const mi = primitive.getMaterialInstance();
+
+            // Per-primitive backface cluster culling (see RenderableManager::Builder::bounds()):
+            // cancel the commands of primitives whose triangles all face away from the
+            // viewpoint. The test is the meshoptimizer cone test,
+            //      dot(view, axis) >= cutoff * |view| + radius
+            // with everything in world space; it's only valid when back faces are actually
+            // culled, so it is ANDed below with the command's culling mode. Primitives
+            // without cooked bounds have a cutoff >= 1 and never take this path.
+            uint64_t coneCulled = 0;
+            if (primitive.hasCullingCone()) {
+                const float4 sphere = primitive.getBoundingSphere();
+                const float4 cone = primitive.getNormalCone();
+                const float3 center = (worldTransform * float4{ sphere.xyz, 1.0f }).xyz;
+                const float3 axis = normalize(worldTransform.upperLeft() * cone.xyz);
+                const float3 view = center - cameraPosition;
+                coneCulled = select(dot(view, axis) >=
+                        cone.w * length(view) + sphere.w * sphereScale);
+            }
             if (colorPass) {
                 cmdColor.primitive.primitiveHandle = primitive.getHwHandle();
                 cmdColor.primitive.materialVariant = materialVariant;
                 RenderPass::setupColorCommand(cmdColor, depthPass, mi);
 
+                // resolve the program handle now (cached in the primitive), so that command
+                // execution doesn't have to look it up per draw
+                cmdColor.primitive.programHandle = primitive.getProgram(
+                        mi->getMaterial(), cmdColor.primitive.materialVariant);
+
                 const bool blendPass = Pass(cmdColor.key & PASS_MASK) == Pass::BLENDED;
                 if (blendPass) {
                     // TODO: at least for transparent objects, AABB should be per primitive
@@ -389,6 +628,8 @@ void RenderPass::generateCommandsImpl(uint32_t,
                     // correct for TransparencyMode::DEFAULT -- i.e. cancel the command
                     key |= select(mode == TransparencyMode::DEFAULT);
 
+                    key |= gpuOccludedCancel;
+
                     *curr = cmdColor;
                     curr->key = key;
                     ++curr;
@@ -423,6 +664,10 @@ void RenderPass::generateCommandsImpl(uint32_t,
                 *curr = cmdColor;
                 // handle the case where this primitive is empty / no-op
                 curr->key |= select(primitive.getPrimitiveType() == PrimitiveType::NONE);
+                curr->key |= gpuOccludedCancel;
+                // blended primitives keep both commands (their culling mode is overridden above)
+                curr->key |= coneCulled & select(!blendPass &
+                        (cmdColor.primitive.rasterState.culling == CullingMode::BACK));
                 ++curr;
             }
 
@@ -433,6 +678,8 @@ void RenderPass::generateCommandsImpl(uint32_t,
                 cmdDepth.primitive.primitiveHandle = primitive.getHwHandle();
                 cmdDepth.primitive.mi = mi;
                 cmdDepth.primitive.rasterState.culling = rs.culling;
+                cmdDepth.primitive.programHandle = primitive.getProgram(
+                        mi->getMaterial(), cmdDepth.primitive.materialVariant);
                 *curr = cmdDepth;
 
                 // If we are drawing depth+draw we don't want to put commands using
@@ -448,6 +695,7 @@ void RenderPass::generateCommandsImpl(uint32_t,
 
                 // handle the case where this primitive is empty / no-op
                 curr->key |= select(primitive.getPrimitiveType() == PrimitiveType::NONE);
+                curr->key |= coneCulled & select(rs.culling == CullingMode::BACK);
                 ++curr;
             }
         }
@@ -474,7 +722,12 @@ void RenderPass::updateSummedPrimitiveCounts(
 
 FRenderer::ColorPass::ColorPass(const char* name,
         JobSystem& js, JobSystem::Job* jobFroxelize,FView* view, Handle<HwRenderTarget> const rth)
-        : RenderPass(name), js(js), jobFroxelize(jobFroxelize), view(view), rth(rth) {
+        : RenderPass(name), js(js), jobFroxelize(jobFroxelize), view(view), rth(rth),
+          // half-resolution transparency needs the intermediate HDR target (for the depth
+          // blit and the pre-tonemapping composite) and a resolved depth buffer
+          splitBlendedPass(view->isHalfResolutionTransparencyEnabled()
+                  && view->hasPostProcessPass()
+                  && view->getSampleCount() <= 1) {
 }
 
 void FRenderer::ColorPass::beginRenderPass(
@@ -484,9 +737,12 @@ void FRenderer::ColorPass::beginRenderPass(
     js.wait(jobFroxelize);
     view->commitFroxels(driver);
 
-    // We won't need the depth or stencil buffers after this pass.
+    // We won't need the depth or stencil buffers after this pass -- except when the
+    // blended commands are split into their own half-resolution pass, which blits the
+    // depth buffer after this pass ends (the composite pass discards it instead).
     RenderPassParams params = {};
-    params.discardEnd = TargetBufferFlags::DEPTH_AND_STENCIL;
+    params.discardEnd = splitBlendedPass ? TargetBufferFlags::STENCIL
+                                         : TargetBufferFlags::DEPTH_AND_STENCIL;
     params.left = viewport.left;
     params.bottom = viewport.bottom;
     params.width = viewport.width;
@@ -536,6 +792,79 @@ void FRenderer::ColorPass::endRenderPass(DriverApi& driver, Viewport const& view
     }
 }
 
+bool FRenderer::ColorPass::separateBlendedCommands() const noexcept {
+    return splitBlendedPass;
+}
+
+void FRenderer::ColorPass::renderBlendedCommands(FEngine& engine, DriverApi& driver,
+        Viewport const& viewport, Slice<Command> const& commands) noexcept {
+    // Half-resolution transparency (see View::setHalfResolutionTransparencyEnabled()):
+    // the blended commands are rendered into a half-resolution target that shares the
+    // scene's depth -- blitted below, so occlusion by opaque geometry is preserved --
+    // then up-sampled and composited over the full-resolution color buffer.
+    RenderTargetPool& rtp = engine.getRenderTargetPool();
+    const uint32_t w = std::max(1u, viewport.width / 2);
+    const uint32_t h = std::max(1u, viewport.height / 2);
+    RenderTargetPool::Target const* halfRes = rtp.get(
+            TargetBufferFlags::COLOR_AND_DEPTH, w, h, 1, TextureFormat::RGBA16F);
+    assert(halfRes);
+
+    // bring the opaque pass' depth down to half resolution (the blit is point-sampled,
+    // depth buffers can't be filtered)
+    driver.blit(TargetBufferFlags::DEPTH,
+            halfRes->target, 0, 0, w, h,
+            rth, viewport.left, viewport.bottom, viewport.width, viewport.height);
+
+    RenderPassParams params = {};
+    params.left = 0;
+    params.bottom = 0;
+    params.width = w;
+    params.height = h;
+    // the color buffer starts as transparent black so the composite below only
+    // affects pixels actually covered by blended primitives
+    params.clear = TargetBufferFlags::COLOR;
+    params.discardStart = TargetBufferFlags::COLOR;
+    params.discardEnd = TargetBufferFlags::DEPTH_AND_STENCIL;
+
+    driver.pushGroupMarker("Blended Pass");
+    driver.beginRenderPass(halfRes->target, params);
+    RenderPass::recordDriverCommands(engine, driver, commands);
+    driver.endRenderPass();
+
+    // Composite with a bilinear up-sample. Note that this is not an edge-aware filter:
+    // the pool's depth attachments are render buffers and can't be sampled, so depth
+    // correctness comes from the blit above rather than from bilateral weights here.
+    PostProcessManager& ppm = engine.getPostProcessManager();
+    ppm.setSource(w, h, halfRes);
+
+    Driver::RasterState rs;
+    rs.culling = Driver::RasterState::CullingMode::NONE;
+    rs.colorWrite = true;
+    rs.depthFunc = Driver::RasterState::DepthFunc::A;
+    // the half-resolution buffer holds pre-multiplied colors
+    rs.blendFunctionSrcRGB = Driver::RasterState::BlendFunction::ONE;
+    rs.blendFunctionSrcAlpha = Driver::RasterState::BlendFunction::ONE;
+    rs.blendFunctionDstRGB = Driver::RasterState::BlendFunction::ONE_MINUS_SRC_ALPHA;
+    rs.blendFunctionDstAlpha = Driver::RasterState::BlendFunction::ONE_MINUS_SRC_ALPHA;
+
+    RenderPassParams compositeParams = {};
+    compositeParams.left = viewport.left;
+    compositeParams.bottom = viewport.bottom;
+    compositeParams.width = viewport.width;
+    compositeParams.height = viewport.height;
+    // the depth/stencil discard elided by the main pass happens here instead
+    compositeParams.discardStart = TargetBufferFlags::DEPTH_AND_STENCIL;
+    compositeParams.discardEnd = TargetBufferFlags::DEPTH_AND_STENCIL;
+
+    driver.beginRenderPass(rth, compositeParams);
+    driver.draw(engine.getPostProcessProgram(PostProcessStage::TRANSPARENCY_UPSAMPLE),
+            rs, engine.getFullScreenRenderPrimitive(), 1);
+    driver.endRenderPass();
+    driver.popGroupMarker();
+
+    rtp.put(halfRes);
+}
+
 void FRenderer::ColorPass::renderColorPass(FEngine& engine, JobSystem& js,
         Handle<HwRenderTarget> const rth, FView* view, Viewport const& scaledViewport,
         GrowingSlice<Command>& commands) noexcept {
@@ -549,9 +878,6 @@ void FRenderer::ColorPass::renderColorPass(FEngine& engine, JobSystem& js,
     auto& soa = view->getScene()->getRenderableData();
     auto vr = view->getVisibleRenderables();
 
-    // populate the RenderPrimitive array with the proper LOD
-    view->updatePrimitivesLod(engine, cameraInfo, soa, vr);
-
     DriverApi& driver = engine.getDriverApi();
     view->prepareCamera(cameraInfo, scaledViewport);
     view->commitUniforms(driver);
@@ -563,14 +889,23 @@ void FRenderer::ColorPass::renderColorPass(FEngine& engine, JobSystem& js,
 
     CommandTypeFlags commandType;
     switch (view->getDepthPrepass()) {
-        case View::DepthPrepass::DEFAULT:
-            // TODO: better default strategy (can even change on a per-frame basis)
+        case View::DepthPrepass::DEFAULT: {
+            // The pre-pass' depth commands are generated in the same pass over the
+            // renderables as the color commands and sorted into the same command
+            // buffer, so its CPU cost is the extra draw calls; it only pays off when
+            // there's enough geometry for overdraw savings to amortize them. On
+            // tilers the hardware already eliminates hidden surfaces, so it's always
+            // skipped there.
 #ifdef ANDROID
             commandType = COLOR;
 #else
-            commandType = DEPTH_AND_COLOR;
+            constexpr size_t DEPTH_PREPASS_MIN_PRIMITIVES = 128;
+            const size_t primitiveCount = FScene::getPrimitiveCount(soa, vr.last);
+            commandType = primitiveCount >= DEPTH_PREPASS_MIN_PRIMITIVES
+                    ? DEPTH_AND_COLOR : COLOR;
 #endif
             break;
+        }
         case View::DepthPrepass::DISABLED:
             commandType = COLOR;
             break;
@@ -579,9 +914,28 @@ void FRenderer::ColorPass::renderColorPass(FEngine& engine, JobSystem& js,
             break;
     }
 
+    // Retained command list: when every input of command generation is unchanged from
+    // the last frame (see FView::CommandCache), the sorted command array would come
+    // out bit-identical, so last frame's copy is resubmitted instead and generation,
+    // sorting and LOD selection are skipped. The per-frame uniform blocks were
+    // committed above either way, so camera, lights and material parameters stay
+    // up-to-date; froxelization also still runs (its output is uniform data).
+    const bool reuseCommands = view->reuseCachedCommands(engine, commandType, flags, commands);
+    if (!reuseCommands) {
+        // populate the RenderPrimitive array with the proper LOD
+        view->updatePrimitivesLod(engine, cameraInfo, soa, vr);
+    }
+
     ColorPass colorPass("ColorPass", js, jobFroxelize, view, rth);
+    colorPass.setOcclusionQueryRecorder(view->getOcclusionQueryRecorder());
     driver.pushGroupMarker("Color Pass");
-    colorPass.render(engine, js, soa, vr, commandType, flags, cameraInfo, scaledViewport, commands);
+    if (UTILS_UNLIKELY(reuseCommands)) {
+        colorPass.submit(engine, cameraInfo, scaledViewport, commands);
+    } else {
+        colorPass.render(engine, js, soa, vr, commandType, flags, cameraInfo, scaledViewport,
+                commands);
+        view->cacheCommands(engine, commandType, flags, commands);
+    }
     driver.popGroupMarker();
 }
 
@@ -601,7 +955,7 @@ void FRenderer::ShadowPass::renderShadowMap(FEngine& engine, JobSystem& js,
 
     auto& soa = view->getScene()->getRenderableData();
     auto vr = view->getVisibleShadowCasters();
-    ShadowMap const& shadowMap = view->getShadowMap();
+    ShadowMap& shadowMap = view->getShadowMap();
     Viewport const& viewport = shadowMap.getViewport();
     FCamera const& camera = shadowMap.getCamera();
 
@@ -630,6 +984,16 @@ void FRenderer::ShadowPass::renderShadowMap(FEngine& engine, JobSystem& js,
     driver.pushGroupMarker("Shadow map Pass");
     shadowPass.render(engine, js, soa, vr, CommandTypeFlags::SHADOW, flags, cameraInfo, viewport, commands);
     driver.popGroupMarker();
+
+    if (UTILS_UNLIKELY(shadowMap.isSoftShadowsEnabled())) {
+        // soft shadows: convert the depth we just rendered into prefiltered EVSM
+        // moments, which the color pass samples with a single trilinear fetch
+        driver.pushGroupMarker("Shadow prefilter");
+        shadowMap.prefilter(driver, engine.getPostProcessManager());
+        driver.popGroupMarker();
+    }
+
+    shadowMap.markRendered();
 }
 
 void FRenderer::ShadowPass::endRenderPass(DriverApi& driver, Viewport const& viewport) noexcept {
@@ -66,6 +66,9 @@ public:
     static constexpr uint64_t Z_BUCKET_MASK                 = 0x3FF00000000llu;
     static constexpr int Z_BUCKET_SHIFT                     = 32;
 
+    static constexpr uint64_t SORT_GROUP_MASK               = 0x0003FC0000000000llu;
+    static constexpr int SORT_GROUP_SHIFT                   = 42;
+
     static constexpr uint64_t PRIORITY_MASK                 = 0x001C000000000000llu;
     static constexpr int PRIORITY_SHIFT                     = 50;
 
@@ -96,6 +99,7 @@ public:
     // a     = alpha masking
     // bbb   = blending
     // ppp   = priority
+    // gggg  = user sort group (color pass only, groups commands beyond material sorting)
     // t     = two-pass transparency ordering
     // 0     = reserved, must be zero
     //
@@ -108,19 +112,19 @@ public:
     //
     //
     // COLOR command (with depth prepass)
-    // |    8   | 3 | 3 | 2|       16       |               32               |
-    // +--------+---+---+--+----------------+--------------------------------+
-    // |00000001|00a|ppp|00|0000000000000000|          material-id           |
-    // +--------+---+---+--+----------------+--------------------------------+
-    // | correctness    |        optimizations (truncation allowed)          |
+    // |    8   | 3 | 3 |    8   |    10    |               32               |
+    // +--------+---+---+--------+----------+--------------------------------+
+    // |00000001|00a|ppp|gggggggg|0000000000|          material-id           |
+    // +--------+---+---+--------+----------+--------------------------------+
+    // | correctness    |      optimizations (truncation allowed)            |
     //
     //
     // COLOR command (without depth prepass)
-    // |    8   | 3 | 3 | 2|  6   |   10     |               32               |
-    // +--------+---+---+--+------+----------+--------------------------------+
-    // |00000001|00a|ppp|00|000000| Z-bucket |          material-id           |
-    // +--------+---+---+--+------+----------+--------------------------------+
-    // | correctness    |      optimizations (truncation allowed)             |
+    // |    8   | 3 | 3 |    8   |    10    |               32               |
+    // +--------+---+---+--------+----------+--------------------------------+
+    // |00000001|00a|ppp|gggggggg| Z-bucket |          material-id           |
+    // +--------+---+---+--------+----------+--------------------------------+
+    // | correctness    |      optimizations (truncation allowed)            |
     //
     //
     // BLENDED command
@@ -172,19 +176,21 @@ public:
         return boolish ? -1llu : 0llu;
     }
 
-    struct PrimitiveInfo { // 28 bytes
+    struct PrimitiveInfo { // 32 bytes
         FMaterialInstance const* mi = nullptr;              // 8 bytes (4)
         Handle<HwRenderPrimitive> primitiveHandle;          // 4 bytes
-        Handle<HwUniformBuffer> perRenderableUniforms;      // 4 bytes
+        Handle<HwProgram> programHandle;                    // 4 bytes
+        uint32_t perRenderableOffset = 0;                   // 4 bytes
         Handle<HwUniformBuffer> perRenderableBones;         // 4 bytes
         Driver::RasterState rasterState;                    // 4 bytes
         Variant materialVariant;                            // 1 byte
-        uint8_t reserved[3] = { };                          // 3 bytes (that helps the compiler)
+        uint8_t reserved[1] = { };                          // 1 byte  (that helps the compiler)
+        uint16_t instanceCount = 1;                         // 2 bytes (0 = merged, skip)
     };
 
-    struct alignas(8) Command {     // 32 bytes
+    struct alignas(8) Command {     // 40 bytes
         CommandKey key = 0;         //  8 bytes
-        PrimitiveInfo primitive;    // 24 bytes
+        PrimitiveInfo primitive;    // 32 bytes
         bool operator < (Command const& rhs) const noexcept { return key < rhs.key; }
         // placement new declared as "throw" to avoid the compiler's null-check
         inline void* operator new (std::size_t size, void* ptr) {
@@ -201,6 +207,25 @@ public:
     static constexpr RenderFlags HAS_DIRECTIONAL_LIGHT  = 0x02;
     static constexpr RenderFlags HAS_DYNAMIC_LIGHTING   = 0x04;
 
+    // GPU occlusion queries (see View::setGpuOcclusionCullingEnabled()): maps a
+    // command's perRenderableOffset -- its slot in the per-renderable uniform arena --
+    // to the renderable's query. When a recorder is attached to the pass,
+    // recordDriverCommands() brackets each tested slot's depth-pass draw with its
+    // query and predicates the slot's color draws on it.
+    struct OcclusionQueryRecorder {
+        Handle<HwOcclusionQuery> const* queries = nullptr;  // indexed by uniform slot
+        uint32_t slotSize = 0;          // size of one per-renderable uniform block
+        uint32_t count = 0;             // number of slots
+        Handle<HwOcclusionQuery> queryFor(uint32_t perRenderableOffset) const noexcept {
+            const uint32_t slot = perRenderableOffset / slotSize;
+            return slot < count ? queries[slot] : Handle<HwOcclusionQuery>{};
+        }
+    };
+
+    void setOcclusionQueryRecorder(OcclusionQueryRecorder const* recorder) noexcept {
+        mOcclusionQueries = recorder;
+    }
+
 
     RenderPass(const char* name) noexcept : mName(name) { }
 
@@ -214,6 +239,46 @@ public:
             const CameraInfo& camera, Viewport const& viewport,
             utils::GrowingSlice<Command>& commands) noexcept;
 
+    // Generates, sorts and instance-merges the commands for the given view without
+    // executing them; this is render() without its submit() tail. Returns the appended
+    // commands, sentinel included -- e.g. to build the tiles of renderTiles(). The
+    // slice must be empty on entry, as sorting covers the whole slice (callers of
+    // render() already guarantee this, see FRenderer::render()).
+    utils::Slice<Command> appendSortedCommands(
+            FEngine& engine, utils::JobSystem& js,
+            FScene::RenderableSoa const& soa, utils::Range<uint32_t> visibleRenderables,
+            uint32_t commandTypeFlags, RenderFlags renderFlags,
+            const CameraInfo& camera,
+            utils::GrowingSlice<Command>& commands) noexcept;
+
+    // Executes an already generated and sorted command buffer; this is the tail end of
+    // render(). Used to resubmit a retained command list (see FView::CommandCache)
+    // without re-running generation and sorting. The per-frame uniform blocks must
+    // have been committed by the caller.
+    void submit(FEngine& engine, const CameraInfo& camera, Viewport const& viewport,
+            utils::GrowingSlice<Command>& commands) noexcept;
+
+    // A tile to be rendered by renderTiles(): a sub-rectangle of the render target,
+    // the per-view uniform block of its camera, and its sorted commands.
+    struct Tile {
+        Viewport viewport;                          // tile rectangle within the target
+        Handle<HwUniformBuffer> perViewUniforms;    // this tile's per-view block
+        uint32_t perViewOffset = 0;                 // byte offset of the block within it
+        utils::Slice<Command> commands;             // sorted, sentinel-terminated
+    };
+
+    // Renders several tiles of the same render target within a single driver render
+    // pass: beginRenderPass()/endRenderPass() are issued once for the whole target and
+    // each tile's commands execute with the viewport restricted to the tile's
+    // rectangle -- the per-draw scissor set by MaterialInstance::use() is clipped
+    // against the current viewport by the driver, so draws can't spill into a
+    // neighboring tile. On tile-based GPUs this pays the render target load/store once
+    // per atlas instead of once per tile (see ShadowAtlas). Each tile's uniform block
+    // must have been committed by the caller before this is called -- no uploads can
+    // happen within the render pass.
+    void renderTiles(FEngine& engine, const CameraInfo& camera, Viewport const& viewport,
+            utils::Slice<Tile> const& tiles) noexcept;
+
 private:
     // Called just before rendering, make sure all needed asynchronous tasks are finished.
     // Set-up the render-target as needed. At least call driver.beginRenderPass().
@@ -225,6 +290,18 @@ private:
     // but at least call driver.endRenderPass().
     virtual void endRenderPass(driver::DriverApi& driver, Viewport const& viewport) noexcept = 0;
 
+    // When this returns true, the commands of Pass::BLENDED are split out of the main
+    // pass -- which then stops at the first blended command -- and handed to
+    // renderBlendedCommands() after endRenderPass(). The sort key guarantees they form
+    // a contiguous run at the end of the command buffer. Off by default.
+    virtual bool separateBlendedCommands() const noexcept;
+
+    // Called after endRenderPass() with the blended commands when
+    // separateBlendedCommands() returned true. The slice is terminated by the sentinel
+    // command. The default implementation does nothing.
+    virtual void renderBlendedCommands(FEngine& engine, driver::DriverApi& driver,
+            Viewport const& viewport, utils::Slice<Command> const& commands) noexcept;
+
 private:
     friend class FRenderer;
 
@@ -249,13 +326,25 @@ private:
     static void setupColorCommand(Command& cmdDraw, bool hasDepthPass,
             FMaterialInstance const* const mi) noexcept;
 
-    static void recordDriverCommands(FEngine::DriverApi& driver,
-            utils::Slice<Command> const& commands) noexcept;
+    // stable LSD radix sort of the commands on their key, with a std::sort
+    // fallback for small command counts
+    static void sortCommands(FEngine& engine,
+            utils::GrowingSlice<Command>& commands) noexcept;
+
+    // folds runs of identical draws (same program, raster state, primitive and uniforms)
+    // into a single instanced draw. Merged commands get an instanceCount of 0 and are
+    // skipped by recordDriverCommands().
+    static void mergeInstancedCommands(utils::Slice<Command>& commands) noexcept;
+
+    static void recordDriverCommands(FEngine& engine, FEngine::DriverApi& driver,
+            utils::Slice<Command> const& commands,
+            OcclusionQueryRecorder const* occlusionQueries = nullptr) noexcept;
 
     static void updateSummedPrimitiveCounts(
             FScene::RenderableSoa& renderableData, utils::Range<uint32_t> vr) noexcept;
 
     const char* const mName;
+    OcclusionQueryRecorder const* mOcclusionQueries = nullptr;
 };
 
 } // namespace details
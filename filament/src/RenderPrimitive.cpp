@@ -32,6 +32,8 @@ void FRenderPrimitive::init(driver::DriverApi& driver,
     mHandle = driver.createRenderPrimitive();
     mMaterialInstance = upcast(entry.materialInstance);
     mBlendOrder = entry.blendOrder;
+    mBoundingSphere = entry.aabb.getBoundingSphere();
+    mNormalCone = entry.normalCone;
 
     if (entry.indices && entry.vertices) {
         FVertexBuffer* vertexBuffer = upcast(entry.vertices);
@@ -82,5 +84,19 @@ void FRenderPrimitive::set(FEngine& engine, RenderableManager::PrimitiveType typ
     mPrimitiveType = type;
 }
 
+UTILS_NOINLINE
+Handle<HwProgram> FRenderPrimitive::getProgramSlow(FMaterial const* ma,
+        Variant variant) const noexcept {
+    Handle<HwProgram> const handle = ma->getProgram(variant.key);
+    // don't latch placeholder programs (builds deferred by the per-frame budget): the
+    // entry keeps its invalid key, so we re-resolve until the real variant is available
+    if (UTILS_LIKELY(ma->isProgramCached(variant.key))) {
+        ProgramCacheEntry& entry = mCachedPrograms[variant.isDepthPass()];
+        entry.handle = handle;
+        entry.variantKey = variant.key;
+    }
+    return handle;
+}
+
 } // namespace details
 } // namespace filament
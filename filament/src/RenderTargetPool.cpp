@@ -75,6 +75,9 @@ RenderTargetPool::Target const* RenderTargetPool::get(
         // update last usage age, remove the entry from the pool and return it
         (*pos)->age = mCacheAge;
         mPool.erase(pos);
+        mInUseSize += getSize(it);
+        mFrameHighWatermark = std::max(mFrameHighWatermark, mInUseSize);
+        engine.counters.rtPoolHits.fetch_add(1, std::memory_order_relaxed);
         return it;
     }
 
@@ -84,8 +87,13 @@ RenderTargetPool::Target const* RenderTargetPool::get(
         entry.target = driver.createRenderTarget(
                 entry.attachments, target_w, target_h, samples, format, {}, {}, {});
     } else {
+        // with an in-tile resolve the target is multi-sampled, but its color texture is
+        // single-sample (the driver resolves into it when storing the tile)
+        const uint8_t textureSamples =
+                (attachments & driver::TargetBufferFlags::RESOLVE_IN_TILE) ? 1 : samples;
         entry.texture = driver.createTexture(Driver::SamplerType::SAMPLER_2D, 1,
-                format, samples, target_w, target_h, 1, Driver::TextureUsage::COLOR_ATTACHMENT);
+                format, textureSamples, target_w, target_h, 1,
+                Driver::TextureUsage::COLOR_ATTACHMENT);
 
         entry.target = driver.createRenderTarget(
                 entry.attachments, target_w, target_h, samples, format,
@@ -95,7 +103,11 @@ RenderTargetPool::Target const* RenderTargetPool::get(
     // update last used age
     entry.age = mCacheAge;
 
+    engine.counters.rtPoolMisses.fetch_add(1, std::memory_order_relaxed);
+
     mPoolSize += getSize(&entry);
+    mInUseSize += getSize(&entry);
+    mFrameHighWatermark = std::max(mFrameHighWatermark, mInUseSize);
 
     // entry not found, create one
     return mEntryArena.make<Entry>(entry);
@@ -104,6 +116,7 @@ RenderTargetPool::Target const* RenderTargetPool::get(
 void RenderTargetPool::put(Target const* target) noexcept {
     // insert the entry back into the pool
     Entry const* entry = static_cast<Entry const*>(target);
+    mInUseSize -= getSize(entry);
     auto pos = find(entry);
     mPool.insert(pos, entry);
 }
@@ -140,10 +153,22 @@ void RenderTargetPool::gc() noexcept {
 //    slog.d << "RenderTargetPool: " << mPoolSize/1024.0f << "KiB, count=" << mPool.size() << io::endl;
 //#endif
 
+    // record this frame's working set and shrink the cache down to the largest working
+    // set seen in the recent past -- entries beyond that are memory we retain but never
+    // use concurrently, so they can go. Targets still checked out seed next frame's
+    // watermark since their lifetime spans the frame boundary.
+    mWatermarkHistory[mWatermarkHistoryIndex] = mFrameHighWatermark;
+    mWatermarkHistoryIndex = (mWatermarkHistoryIndex + 1) % WATERMARK_HISTORY_SIZE;
+    mFrameHighWatermark = mInUseSize;
+    size_t const retainSize = *std::max_element(
+            std::begin(mWatermarkHistory), std::end(mWatermarkHistory));
+
     DriverApi& driver = mEngine->getDriverApi();
     auto& cache = mPool;
     size_t count = cache.size();
-    while (count && (count > POOL_MAX_ENTRY_COUNT || mPoolSize > POOL_MAX_SIZE)) {
+    while (count && (count > POOL_MAX_ENTRY_COUNT
+                     || mPoolSize > POOL_MAX_SIZE
+                     || mPoolSize > retainSize)) {
 
         // find the least recently used entry (linear search here)
         auto pos = std::min_element(cache.begin(), cache.end(),
@@ -46,6 +46,10 @@ class RenderTargetPool {
     // 2 pages is way enough for the entry sturctures (should be about 400)
     static constexpr size_t POOL_ENTRY_ARENA_SIZE = 8192;
 
+    // number of frames of usage high-watermarks we remember; the cache is shrunk to the
+    // largest of them, i.e. to the working set actually used concurrently in recent frames
+    static constexpr size_t WATERMARK_HISTORY_SIZE = 16;
+
 public:
     using TextureFormat = Driver::TextureFormat;
 
@@ -100,6 +104,15 @@ private:
     details::FEngine* mEngine = nullptr;
     mutable std::vector<Entry const*> mPool;
     mutable size_t mPoolSize = 0;
+
+    // lifetime tracking: bytes currently checked out of the pool, and the largest amount
+    // that was checked out at any one time during the current frame. Targets whose
+    // lifetimes don't overlap go through get()/put() and therefore never both count
+    // towards the watermark, so it measures the frame's true working set.
+    mutable size_t mInUseSize = 0;
+    mutable size_t mFrameHighWatermark = 0;
+    size_t mWatermarkHistory[WATERMARK_HISTORY_SIZE] = { 0 };
+    uint32_t mWatermarkHistoryIndex = 0;
     // at 60 fps, 32 bit gives us 828 days without overflow
     uint32_t mDeepPurgeCountDown = POOL_ENTRY_MAX_AGE;
     uint32_t mCacheAge = POOL_ENTRY_MAX_AGE;
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/RenderableBvh.h"
+
+#include <filament/Box.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <assert.h>
+
+using namespace math;
+
+namespace filament {
+namespace details {
+
+void RenderableBvh::clear() noexcept {
+    mNodes.clear();
+    mOrder.clear();
+    mSortedCenters.clear();
+    mSortedExtents.clear();
+    mResults.clear();
+    mCount = 0;
+}
+
+uint32_t RenderableBvh::buildNode(float3 const* center, uint32_t first, uint32_t count) {
+    const uint32_t index = uint32_t(mNodes.size());
+    mNodes.push_back({ {}, {}, 0, 0, first, count });
+
+    if (count > LEAF_COUNT) {
+        // split at the median of the widest axis of the centroid bounds
+        float3 lo = std::numeric_limits<float>::max();
+        float3 hi = std::numeric_limits<float>::lowest();
+        for (uint32_t i = first; i < first + count; i++) {
+            lo = min(lo, center[mOrder[i]]);
+            hi = max(hi, center[mOrder[i]]);
+        }
+        const float3 d = hi - lo;
+        const size_t axis = (d.x > d.y) ? ((d.x > d.z) ? 0 : 2) : ((d.y > d.z) ? 1 : 2);
+
+        const uint32_t half = count / 2;
+        uint32_t* const order = mOrder.data();
+        std::nth_element(order + first, order + first + half, order + first + count,
+                [center, axis](uint32_t lhs, uint32_t rhs) {
+                    return center[lhs][axis] < center[rhs][axis];
+                });
+
+        // children are allocated after their parent, so a reverse traversal of the
+        // node array (see refit()) always visits children first
+        const uint32_t left = buildNode(center, first, half);
+        const uint32_t right = buildNode(center, first + half, count - half);
+        mNodes[index].left = left;
+        mNodes[index].right = right;
+    }
+    return index;
+}
+
+void RenderableBvh::build(float3 const* UTILS_RESTRICT center,
+        float3 const* UTILS_RESTRICT extent, uint32_t count) {
+    clear();
+    if (!count) {
+        return;
+    }
+    mCount = count;
+
+    mOrder.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        mOrder[i] = i;
+    }
+
+    // a complete tree over count/LEAF_COUNT leaves has fewer than 4 * count / LEAF_COUNT nodes
+    mNodes.reserve(4 * (count / LEAF_COUNT) + 2);
+    buildNode(center, 0, count);
+
+    // the leaves are tested with the vectorized Culler, which processes batches of
+    // MODULO entries and can read (and harmlessly re-test) a few entries past a
+    // leaf's range -- pad the arrays so the last batch stays in bounds
+    const size_t padded = Culler::round(count) + Culler::MODULO;
+    mSortedCenters.resize(padded);
+    mSortedExtents.resize(padded);
+    mResults.resize(padded);
+
+    refit(center, extent);
+}
+
+void RenderableBvh::refit(float3 const* UTILS_RESTRICT center,
+        float3 const* UTILS_RESTRICT extent) noexcept {
+    uint32_t const* UTILS_RESTRICT const order = mOrder.data();
+    float3* UTILS_RESTRICT const sortedCenters = mSortedCenters.data();
+    float3* UTILS_RESTRICT const sortedExtents = mSortedExtents.data();
+
+    const uint32_t count = mCount;
+    for (uint32_t i = 0; i < count; i++) {
+        sortedCenters[i] = center[order[i]];
+        sortedExtents[i] = extent[order[i]];
+    }
+    // the padding must not generate visible bits for real renderables, it's simply
+    // never looked at -- degenerate boxes are fine
+    for (size_t i = count, e = mSortedCenters.size(); i < e; i++) {
+        sortedCenters[i] = float3{ 0 };
+        sortedExtents[i] = float3{ 0 };
+    }
+
+    // children always follow their parent, so a reverse traversal sees them first
+    auto& nodes = mNodes;
+    for (size_t i = nodes.size(); i > 0; i--) {
+        Node& node = nodes[i - 1];
+        if (node.left) {
+            Node const& l = nodes[node.left];
+            Node const& r = nodes[node.right];
+            const float3 lo = min(l.center - l.halfExtent, r.center - r.halfExtent);
+            const float3 hi = max(l.center + l.halfExtent, r.center + r.halfExtent);
+            node.center = (lo + hi) * 0.5f;
+            node.halfExtent = (hi - lo) * 0.5f;
+        } else {
+            float3 lo = std::numeric_limits<float>::max();
+            float3 hi = std::numeric_limits<float>::lowest();
+            for (uint32_t j = node.first, e = node.first + node.count; j < e; j++) {
+                lo = min(lo, sortedCenters[j] - sortedExtents[j]);
+                hi = max(hi, sortedCenters[j] + sortedExtents[j]);
+            }
+            node.center = (lo + hi) * 0.5f;
+            node.halfExtent = (hi - lo) * 0.5f;
+        }
+    }
+}
+
+void RenderableBvh::cull(Frustum const& frustum,
+        Culler::result_type* UTILS_RESTRICT visibleArray, size_t bit) noexcept {
+    if (mNodes.empty()) {
+        return;
+    }
+
+    Culler::result_type* UTILS_RESTRICT const results = mResults.data();
+    std::fill(mResults.begin(), mResults.end(), 0);
+
+    // the tree is depth-bounded by the leaf size, 64 entries is plenty
+    uint32_t stack[64];
+    size_t sp = 0;
+    stack[sp++] = 0;
+
+    Node const* UTILS_RESTRICT const nodes = mNodes.data();
+    float3 const* UTILS_RESTRICT const sortedCenters = mSortedCenters.data();
+    float3 const* UTILS_RESTRICT const sortedExtents = mSortedExtents.data();
+
+    while (sp) {
+        Node const& node = nodes[stack[--sp]];
+        if (!Culler::intersects(frustum, Box{ node.center, node.halfExtent })) {
+            // the whole subtree is outside the frustum
+            continue;
+        }
+        if (node.left) {
+            assert(sp + 2 <= sizeof(stack) / sizeof(stack[0]));
+            stack[sp++] = node.left;
+            stack[sp++] = node.right;
+        } else {
+            // rounding can re-test the first few entries of the next leaf, which is
+            // harmless: culling is a pure function and the results are OR-ed
+            Culler::intersects(results + node.first, frustum,
+                    sortedCenters + node.first, sortedExtents + node.first,
+                    Culler::round(node.count), bit);
+        }
+    }
+
+    // scatter back to SoA order
+    uint32_t const* UTILS_RESTRICT const order = mOrder.data();
+    for (uint32_t i = 0, c = mCount; i < c; i++) {
+        visibleArray[order[i]] |= results[i];
+    }
+}
+
+} // namespace details
+} // namespace filament
@@ -16,6 +16,7 @@
 
 #include "details/Renderer.h"
 
+#include "FrameGraph.h"
 #include "RenderPass.h"
 
 #include "details/Engine.h"
@@ -28,12 +29,16 @@
 
 #include <filament/driver/PixelBufferDescriptor.h>
 
+#include <utils/GpuCounters.h>
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 #include <utils/vector.h>
 
 #include <assert.h>
 
+#include <algorithm>
+#include <chrono>
+
 using namespace math;
 using namespace utils;
 
@@ -45,10 +50,12 @@ namespace details {
 
 FRenderer::FRenderer(FEngine& engine) :
         mEngine(engine),
-        mFrameSkipper(engine, 2),
+        mFrameSkipper(engine, engine.getFrameLatency()),
         mFrameInfoManager(engine),
         mIsRGB16FSupported(false),
         mIsRGB8Supported(false),
+        mIsRG11B10FSupported(false),
+        mIsInTileResolveSupported(false),
         mPerRenderPassArena(engine.getPerRenderPassAllocator())
 {
 }
@@ -56,13 +63,32 @@ FRenderer::FRenderer(FEngine& engine) :
 void FRenderer::init() noexcept {
     DriverApi& driver = mEngine.getDriverApi();
     mRenderTarget = driver.createDefaultRenderTarget();
+    mShadowPassQuery = driver.createTimerQuery();
+    mColorPassQuery = driver.createTimerQuery();
+    mPostProcessQuery = driver.createTimerQuery();
     mIsRGB16FSupported = driver.isRenderTargetFormatSupported(driver::TextureFormat::RGB16F);
     mIsRGB8Supported = driver.isRenderTargetFormatSupported(driver::TextureFormat::RGB8);
+    mIsRG11B10FSupported =
+            driver.isRenderTargetFormatSupported(driver::TextureFormat::R11F_G11F_B10F);
+    mIsInTileResolveSupported = driver.isInTileResolveSupported();
     if (UTILS_HAS_THREADING) {
         mFrameInfoManager.run();
     }
 }
 
+TextureFormat FRenderer::getHdrFormat(FView const& view) const noexcept {
+    const bool translucent = mSwapChain->isTransparent();
+    // at LOW/MEDIUM quality, trade precision for bandwidth with an R11F_G11F_B10F
+    // intermediate (the format has no alpha, so translucent views can't use it)
+    const View::QualityLevel quality = view.getRenderQuality().hdrColorBuffer;
+    if ((quality == View::QualityLevel::LOW || quality == View::QualityLevel::MEDIUM)
+            && !translucent && mIsRG11B10FSupported) {
+        return TextureFormat::R11F_G11F_B10F;
+    }
+    return (translucent || !mIsRGB16FSupported) ? TextureFormat::RGBA16F
+                                                : TextureFormat::RGB16F;
+}
+
 FRenderer::~FRenderer() noexcept {
     // There shouldn't be any resource left when we get here, but if there is, make sure
     // to free what we can (it would probably mean something when wrong).
@@ -81,6 +107,9 @@ void FRenderer::terminate(FEngine& engine) {
     // shut down threads if we created any.
     DriverApi& driver = engine.getDriverApi();
     driver.destroyRenderTarget(mRenderTarget);
+    driver.destroyTimerQuery(mShadowPassQuery);
+    driver.destroyTimerQuery(mColorPassQuery);
+    driver.destroyTimerQuery(mPostProcessQuery);
 
     // before we can destroy this Renderer's resources, we must make sure
     // that all pending commands have been executed (as they could reference data in this
@@ -122,19 +151,70 @@ void FRenderer::render(FView const* view) {
     }
 }
 
+void FRenderer::render(View const* const* views, size_t viewCount) {
+    SYSTRACE_CALL();
+
+    assert(mSwapChain);
+
+    FEngine& engine = mEngine;
+    JobSystem& js = engine.getJobSystem();
+
+    // create a master job so no other job can escape
+    auto masterJob = js.setMasterJob(js.createJob());
+
+    // Each view gets its own arena scope -- and therefore its own command buffer --
+    // but the scene-level work is shared between them: FScene::prepare() short-circuits
+    // for every view after the first one on a given scene (nothing can have changed
+    // within the frame), and views lit by an identical directional light pick up the
+    // same shadow map from the engine's shadow map cache instead of rendering their
+    // own. The command stream is flushed to the render thread once for the batch.
+    //
+    // The per-view prepare phases stay sequential on this thread: views sharing a
+    // Scene write to the scene's renderable SoA (visibility masks, partitioning), so
+    // they cannot overlap. The parallelism lives inside each phase, on the job system
+    // (culling, froxelization, command generation).
+    for (size_t i = 0; i < viewCount; i++) {
+        FView const* const view = views[i] ? upcast(views[i]) : nullptr;
+        if (UTILS_LIKELY(view && view->getScene())) {
+            ArenaScope rootArena(mPerRenderPassArena);
+            renderJob(rootArena, const_cast<FView*>(view));
+        }
+    }
+
+    // make sure to flush the command buffer
+    engine.flush();
+
+    // and wait for all jobs to finish as a safety (this should be a no-op)
+    js.runAndWait(masterJob);
+    js.reset();
+}
+
 void FRenderer::renderJob(ArenaScope& arena, FView* view) {
     FEngine& engine = getEngine();
     JobSystem& js = engine.getJobSystem();
     FEngine::DriverApi& driver = engine.getDriverApi();
     PostProcessManager& ppm = engine.getPostProcessManager();
-    RenderTargetPool& rtp = engine.getRenderTargetPool();
 
     // DEBUG: driver commands must all happen from the same thread. Enforce that on debug builds.
     engine.getDriverApi().debugThreading();
 
     Viewport const& vp = view->getViewport();
     const bool hasPostProcess = view->hasPostProcessPass();
-    float2 scale = view->updateScale(mFrameInfoManager.getLastFrameTime());
+    // Prefer the GPU time measured by the pass timer queries to drive dynamic resolution:
+    // it isolates the GPU load from CPU time and vsync, so the controller tracks the actual
+    // rendering cost and can react to load spikes before frames get dropped. We fall back
+    // to the CPU frame time where timer queries aren't supported.
+    GpuPassTimings const gpuTimings = getGpuPassTimings();
+    // On tile-based GPUs the passes overlap and the timer queries can under-report the
+    // total load; worse, a bandwidth-bound frame looks cheap to them because the stalls
+    // happen on the memory bus. The kernel's device busy counter (see endFrame()) covers
+    // both, so feed the controller whichever is larger.
+    const uint64_t gpuTimeNs = std::max(
+            gpuTimings.shadowPass + gpuTimings.colorPass + gpuTimings.postProcess,
+            mGpuBusyNs);
+    float2 scale = view->updateScale(gpuTimeNs > 0
+            ? std::chrono::duration<float, std::milli>(float(gpuTimeNs) * 1e-6f)
+            : mFrameInfoManager.getLastFrameTime());
     bool useFXAA = view->getAntiAliasing() == View::AntiAliasing::FXAA;
     if (!hasPostProcess) {
         // dynamic scaling and FXAA are part of the post-process phase and can't happen if
@@ -149,6 +229,29 @@ void FRenderer::renderJob(ArenaScope& arena, FView* view) {
         return;
     }
 
+    // FIXME: viewRenderTarget doesn't have a depth-buffer, so when skipping post-process, don't rely on it
+    const Handle<HwRenderTarget> viewRenderTarget = getRenderTarget();
+
+    /*
+     * Per-view render caching: when the view opted in and nothing that affects its
+     * rendered content changed since the last frame, skip rendering entirely and
+     * re-composite the cached frame into the view's render target.
+     */
+
+    const bool caching = view->isCachingEnabled();
+    if (UTILS_UNLIKELY(caching)) {
+        RenderTargetPool::Target const* const cached = view->getValidCachedFrame(engine);
+        if (cached) {
+            driver.blit(TargetBufferFlags::COLOR,
+                    viewRenderTarget, vp.left, vp.bottom, vp.width, vp.height,
+                    cached->target, 0, 0, vp.width, vp.height);
+            return;
+        }
+    } else if (UTILS_UNLIKELY(view->hasCachedFrame())) {
+        // caching was just disabled, return the cached frame's target to the pool
+        view->releaseCachedFrame(engine);
+    }
+
     view->prepare(engine, driver, arena, svp);
     // TODO: froxelization could actually start now, instead of in ColorPass::renderColorPass()
 
@@ -161,15 +264,34 @@ void FRenderer::renderJob(ArenaScope& arena, FView* view) {
     GrowingSlice<Command> commands(
             arena.allocate<Command>(commandsCount, CACHELINE_SIZE), commandsCount);
 
+    /*
+     * Build the frame graph. Passes declare the virtual resources they read and write;
+     * passes whose outputs are never consumed are culled, and transient targets are
+     * checked out of the RenderTargetPool only for the span of passes that use them.
+     */
+
+    FrameGraph fg(engine);
+
     /*
      * Shadow pass
      */
 
     if (view->hasShadowing()) {
-        ShadowPass::renderShadowMap(engine, js, view, commands);
-        recordHighWatermark(commands); // for debugging
-        // reset the command buffer
-        commands.clear();
+        // skip the pass entirely when the shadow map's content is still valid, i.e. when
+        // neither the light's frustum nor the scene changed since the last render
+        if (view->getShadowMap().needsRendering()) {
+            // the shadow map's texture lives in ShadowMap, not in the graph
+            const FrameGraph::ResourceId shadowMap = fg.importResource("shadow map");
+            fg.addPass("shadows", {}, { shadowMap },
+                    [&](FrameGraph&, FEngine::DriverApi& driver) {
+                driver.beginTimerQuery(mShadowPassQuery);
+                ShadowPass::renderShadowMap(engine, js, view, commands);
+                driver.endTimerQuery(mShadowPassQuery);
+                recordHighWatermark(commands); // for debugging
+                // reset the command buffer
+                commands.clear();
+            });
+        }
     }
 
     /*
@@ -177,58 +299,123 @@ void FRenderer::renderJob(ArenaScope& arena, FView* view) {
      */
 
     const uint8_t useMSAA = view->getSampleCount();
-    const TextureFormat hdrFormat = getHdrFormat();
+    const TextureFormat hdrFormat = getHdrFormat(*view);
     const TextureFormat ldrFormat = getLdrFormat();
-    RenderTargetPool::Target const* colorTarget = nullptr;
 
+    // when caching, the frame renders into a target the view keeps across frames, and
+    // is composited into the view's render target afterwards; reuse the previous
+    // (stale) target when it's large enough rather than cycling through the pool
+    RenderTargetPool::Target const* cacheTarget = nullptr;
+    if (UTILS_UNLIKELY(caching)) {
+        cacheTarget = view->getCachedFrameTarget();
+        if (!cacheTarget || cacheTarget->w < vp.width || cacheTarget->h < vp.height) {
+            cacheTarget = engine.getRenderTargetPool().get(
+                    TargetBufferFlags::COLOR_AND_DEPTH, vp.width, vp.height, 1, ldrFormat,
+                    RenderTargetPool::Target::NO_TEXTURE);
+        }
+    }
+
+    // either the view's render target, or the cached frame's target standing in for it
+    const Handle<HwRenderTarget> outputTarget =
+            cacheTarget ? cacheTarget->target : viewRenderTarget;
+    const Viewport outputVp = cacheTarget ?
+            Viewport{ 0, 0, vp.width, vp.height } : vp;
+
+    const FrameGraph::ResourceId viewTarget = fg.importResource("view render target");
+
+    // with post-processing the scene renders into a transient HDR target, otherwise
+    // directly into the view's render target
+    // with an in-tile resolve the MSAA color buffer never reaches main memory and the
+    // separate resolve-blit in the post-process pass below is not needed
+    const bool inTileResolve = useMSAA > 1 && mIsInTileResolveSupported;
+
+    FrameGraph::ResourceId color = viewTarget;
     if (UTILS_LIKELY(hasPostProcess)) {
-        // allocate the target we need for rendering the scene
-        colorTarget = rtp.get(TargetBufferFlags::COLOR_AND_DEPTH,
+        TargetBufferFlags colorAttachments = TargetBufferFlags::COLOR_AND_DEPTH;
+        if (inTileResolve) {
+            colorAttachments = TargetBufferFlags(
+                    colorAttachments | TargetBufferFlags::RESOLVE_IN_TILE);
+        }
+        color = fg.createResource("color buffer", colorAttachments,
                 svp.width, svp.height, useMSAA, hdrFormat);
         svp.left = svp.bottom = 0;
+    } else if (UTILS_UNLIKELY(cacheTarget)) {
+        // the cache target stands in for the view's render target but has its own origin
+        svp.left = svp.bottom = 0;
     }
 
-    // FIXME: viewRenderTarget doesn't have a depth-buffer, so when skipping post-process, don't rely on it
-    const Handle<HwRenderTarget> viewRenderTarget = getRenderTarget();
-    ColorPass::renderColorPass(engine, js,
-            colorTarget ? colorTarget->target : viewRenderTarget, view, svp, commands);
+    fg.addPass("color", {}, { color },
+            [&, color, viewTarget](FrameGraph& fg, FEngine::DriverApi& driver) {
+        Handle<HwRenderTarget> target = (color == viewTarget) ?
+                outputTarget : fg.getTarget(color)->target;
+        driver.beginTimerQuery(mColorPassQuery);
+        ColorPass::renderColorPass(engine, js, target, view, svp, commands);
+        driver.endTimerQuery(mColorPassQuery);
+    });
 
     /*
      * Post Processing...
      */
 
     if (UTILS_LIKELY(hasPostProcess)) {
-        driver.pushGroupMarker("Post Processing");
-
-        ppm.start();
-
-        if (useMSAA > 1) {
-            // Note: MSAA, when used is applied before tone-mapping (which is not ideal)
-            // (tone mapping currently only works without multi-sampling)
-            // this blit does a MSAA resolve
-            ppm.blit(hdrFormat);
-        }
-
-        const bool translucent = mSwapChain->isTransparent();
-        Handle<HwProgram> toneMappingProgram = engine.getPostProcessProgram(
-                translucent ? PostProcessStage::TONE_MAPPING_TRANSLUCENT
-                            : PostProcessStage::TONE_MAPPING_OPAQUE);
-        ppm.pass(useFXAA ? TextureFormat::RGBA8 : ldrFormat, toneMappingProgram);
-
-        if (useFXAA) {
-            Handle<HwProgram> antiAliasingProgram = engine.getPostProcessProgram(
-                    translucent ? PostProcessStage::ANTI_ALIASING_TRANSLUCENT
-                                : PostProcessStage::ANTI_ALIASING_OPAQUE);
-            ppm.pass(ldrFormat, antiAliasingProgram);
-        }
+        fg.addPass("postProcess", { color }, { viewTarget },
+                [&, color](FrameGraph& fg, FEngine::DriverApi& driver) {
+            driver.pushGroupMarker("Post Processing");
+            driver.beginTimerQuery(mPostProcessQuery);
+
+            ppm.start();
+
+            // The GPU auto-exposure passes sample the color buffer, which isn't possible
+            // when it's backed by a true multi-sample texture; in that case fall back to
+            // the camera-driven exposure.
+            if (UTILS_UNLIKELY(engine.debug.postprocess.auto_exposure
+                    && (useMSAA <= 1 || inTileResolve))) {
+                ppm.autoExposure(driver, fg.getTarget(color), svp);
+            }
+
+            if (useMSAA > 1 && !inTileResolve) {
+                // Note: MSAA, when used is applied before tone-mapping (which is not ideal)
+                // (tone mapping currently only works without multi-sampling)
+                // this blit does a MSAA resolve; with an in-tile resolve the color buffer's
+                // texture is already resolved and can be sampled directly
+                ppm.blit(hdrFormat);
+            }
+
+            const bool translucent = mSwapChain->isTransparent();
+            Handle<HwProgram> toneMappingProgram = engine.getPostProcessProgram(
+                    translucent ? PostProcessStage::TONE_MAPPING_TRANSLUCENT
+                                : PostProcessStage::TONE_MAPPING_OPAQUE);
+            ppm.pass(useFXAA ? TextureFormat::RGBA8 : ldrFormat, toneMappingProgram);
+
+            if (useFXAA) {
+                Handle<HwProgram> antiAliasingProgram = engine.getPostProcessProgram(
+                        translucent ? PostProcessStage::ANTI_ALIASING_TRANSLUCENT
+                                    : PostProcessStage::ANTI_ALIASING_OPAQUE);
+                ppm.pass(ldrFormat, antiAliasingProgram);
+            }
+
+            if (scaled) {
+                // because it's the last command, the TextureFormat is not relevant
+                ppm.blit();
+            }
+            // finish() owns the color target from here and returns it to the pool itself
+            ppm.finish(cacheTarget ? TargetBufferFlags::ALL : view->getDiscardedTargetBuffers(),
+                    outputTarget, outputVp, fg.detachTarget(color), svp);
+
+            driver.endTimerQuery(mPostProcessQuery);
+            driver.popGroupMarker();
+        });
+    }
 
-        if (scaled) {
-            // because it's the last command, the TextureFormat is not relevant
-            ppm.blit();
-        }
-        ppm.finish(view->getDiscardedTargetBuffers(), viewRenderTarget, vp, colorTarget, svp);
+    fg.compile();
+    fg.execute(driver);
 
-        driver.popGroupMarker();
+    if (UTILS_UNLIKELY(cacheTarget)) {
+        // composite the freshly rendered frame and keep it for the next frames
+        driver.blit(TargetBufferFlags::COLOR,
+                viewRenderTarget, vp.left, vp.bottom, vp.width, vp.height,
+                cacheTarget->target, 0, 0, vp.width, vp.height);
+        view->commitCachedFrame(engine, cacheTarget);
     }
 
     // for debugging
@@ -288,7 +475,7 @@ void FRenderer::mirrorFrame(FSwapChain* dstSwapChain, Viewport const& dstViewpor
     mSwapChain->makeCurrent(driver);
 }
 
-bool FRenderer::beginFrame(FSwapChain* swapChain) {
+bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano) {
     SYSTRACE_CALL();
 
     assert(swapChain);
@@ -313,11 +500,46 @@ bool FRenderer::beginFrame(FSwapChain* swapChain) {
     mSwapChain = swapChain;
     swapChain->makeCurrent(driver);
 
-    uint64_t monotonic_clock_ns (std::chrono::steady_clock::now().time_since_epoch().count());
+    // When the application drives us from its vsync source (Choreographer on Android,
+    // a waitable swapchain elsewhere), use that timestamp as the frame's reference
+    // time and keep a running estimate of the display period for the skip decision
+    // below.
+    int64_t gpuDeadlineNs = 0;
+    if (vsyncSteadyClockTimeNano) {
+        if (mLastVsyncTimestamp && vsyncSteadyClockTimeNano > mLastVsyncTimestamp) {
+            const uint64_t period = vsyncSteadyClockTimeNano - mLastVsyncTimestamp;
+            // ignore periods that can't be a single refresh interval (missed vsyncs,
+            // resumed apps); 4ms..50ms covers 240Hz down to 20Hz displays
+            if (period >= 4000000 && period <= 50000000) {
+                mVsyncPeriodNs = period;
+            }
+        }
+        mLastVsyncTimestamp = vsyncSteadyClockTimeNano;
+        // give the GPU a fraction of the refresh interval to finish the frame the
+        // skipper is waiting on; this avoids dropping to half rate when it misses
+        // the vsync by a hair, which is what causes 30/60Hz oscillation
+        gpuDeadlineNs = int64_t(vsyncSteadyClockTimeNano + mVsyncPeriodNs / 4);
+    }
+
+    uint64_t monotonic_clock_ns = vsyncSteadyClockTimeNano ? vsyncSteadyClockTimeNano
+            : uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
     driver.beginFrame(monotonic_clock_ns, mFrameId);
     driver.setPresentationTime(monotonic_clock_ns);
 
-    if (mFrameSkipper.skipFrameNeeded()) {
+    // pick-up latency changes requested through Engine::setFrameLatency()
+    mFrameSkipper.setLatency(engine.getFrameLatency());
+
+    // publish how much background resource work the driver thread may do during this
+    // frame: half the slack left against a 60 Hz frame, clamped to [0.5ms, 4ms]
+    // (see FEngine::executeResourceCommands())
+    auto const lastFrameTime =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    mFrameInfoManager.getLastFrameTime());
+    int64_t const slack = (16666667 - lastFrameTime.count()) / 2;
+    engine.setResourceTimeSliceNs(
+            std::min(std::max(slack, int64_t(500000)), int64_t(4000000)));
+
+    if (mFrameSkipper.skipFrameNeeded(gpuDeadlineNs)) {
         mFrameInfoManager.cancelFrame();
         driver.endFrame(mFrameId);
         engine.flush();
@@ -349,6 +571,51 @@ void FRenderer::endFrame() {
     }
     mFrameSkipper.endFrame();
 
+    // Sample the kernel's GPU counters where the platform exposes them (tile-based
+    // mobile GPUs) and fold them into the engine's counters before the snapshot below.
+    // mGpuBusyNs feeds the dynamic-resolution controller next frame (see renderJob()).
+    GpuCounters& gpuCounters = GpuCounters::get();
+    if (UTILS_UNLIKELY(gpuCounters.isValid())) {
+        GpuCounters::Sample const sample = gpuCounters.sample();
+        engine.counters.gpuBusyNs.fetch_add(sample.busyNs, std::memory_order_relaxed);
+        engine.counters.gpuMemoryBytes.fetch_add(sample.bytes, std::memory_order_relaxed);
+        mGpuBusyNs = sample.busyNs;
+    }
+
+    // capture the per-frame counter snapshot (see DebugRegistry::getCounters())
+    engine.getDebugRegistry().snapshotCounters();
+
+    // record this frame's telemetry into the history ring (see drainFrameRecords());
+    // everything below reads data already published, so this costs a few loads
+    {
+        uint64_t const drawCalls =
+                engine.counters.drawCalls.load(std::memory_order_relaxed);
+        uint64_t const instancedDraws =
+                engine.counters.instancedDraws.load(std::memory_order_relaxed);
+        GpuPassTimings const gpuTimings = getGpuPassTimings();
+        FrameRecord record;
+        record.frameId = mFrameId;
+        // the engine counters are cumulative, turn them into per-frame deltas
+        record.drawCalls = uint32_t(drawCalls - mLastDrawCalls);
+        record.instancedDraws = uint32_t(instancedDraws - mLastInstancedDraws);
+        record.commandArenaBytes = uint32_t(mPerRenderPassArena.getAllocator().highWatermark());
+        record.cpuFrameTimeNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                frameInfoManager.getLastFrameTime()).count());
+        record.gpuShadowPassNs = gpuTimings.shadowPass;
+        record.gpuColorPassNs = gpuTimings.colorPass;
+        record.gpuPostProcessNs = gpuTimings.postProcess;
+        record.gpuBusyNs = mGpuBusyNs;
+        mLastDrawCalls = drawCalls;
+        mLastInstancedDraws = instancedDraws;
+
+        uint32_t const head = mFrameRecordHead.load(std::memory_order_relaxed);
+        if (head - mFrameRecordTail.load(std::memory_order_acquire) < FRAME_RECORD_COUNT) {
+            mFrameRecords[head % FRAME_RECORD_COUNT] = record;
+            mFrameRecordHead.store(head + 1, std::memory_order_release);
+        }
+        // ring full: nobody is draining, drop the record
+    }
+
     driver.endFrame(mFrameId);
 
     if (mSwapChain) {
@@ -384,6 +651,30 @@ void FRenderer::endFrame() {
 #endif
 }
 
+FRenderer::GpuPassTimings FRenderer::getGpuPassTimings() const noexcept {
+    // getTimerQueryValue() is synchronous, but only reads results already published by the
+    // backend, so this is cheap and can be called every frame.
+    GpuPassTimings timings;
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    driver.getTimerQueryValue(mShadowPassQuery, &timings.shadowPass);
+    driver.getTimerQueryValue(mColorPassQuery, &timings.colorPass);
+    driver.getTimerQueryValue(mPostProcessQuery, &timings.postProcess);
+    return timings;
+}
+
+size_t FRenderer::drainFrameRecords(FrameRecord* records, size_t count) noexcept {
+    // single consumer: only this thread moves the tail, only the render thread moves
+    // the head (see endFrame())
+    uint32_t tail = mFrameRecordTail.load(std::memory_order_relaxed);
+    uint32_t const head = mFrameRecordHead.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (tail != head && n < count) {
+        records[n++] = mFrameRecords[tail++ % FRAME_RECORD_COUNT];
+    }
+    mFrameRecordTail.store(tail, std::memory_order_release);
+    return n;
+}
+
 void FRenderer::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
         driver::PixelBufferDescriptor&& buffer) {
 
@@ -437,8 +728,12 @@ void Renderer::render(View const* view) {
     upcast(this)->render(upcast(view));
 }
 
-bool Renderer::beginFrame(SwapChain* swapChain) {
-    return upcast(this)->beginFrame(upcast(swapChain));
+void Renderer::render(View const* const* views, size_t viewCount) {
+    upcast(this)->render(views, viewCount);
+}
+
+bool Renderer::beginFrame(SwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano) {
+    return upcast(this)->beginFrame(upcast(swapChain), vsyncSteadyClockTimeNano);
 }
 
 void Renderer::mirrorFrame(SwapChain* dstSwapChain, Viewport const& dstViewport, Viewport const& srcViewport,
@@ -451,6 +746,14 @@ void Renderer::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, ui
     upcast(this)->readPixels(xoffset, yoffset, width, height, std::move(buffer));
 }
 
+Renderer::GpuPassTimings Renderer::getGpuPassTimings() const noexcept {
+    return upcast(this)->getGpuPassTimings();
+}
+
+size_t Renderer::drainFrameRecords(FrameRecord* records, size_t count) noexcept {
+    return upcast(this)->drainFrameRecords(records, count);
+}
+
 void Renderer::endFrame() {
     upcast(this)->endFrame();
 }
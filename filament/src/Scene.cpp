@@ -27,10 +27,12 @@
 
 #include <utils/compiler.h>
 #include <utils/EntityManager.h>
+#include <utils/JobSystem.h>
 #include <utils/Range.h>
 #include <utils/Zip2Iterator.h>
 
 #include <algorithm>
+#include <cstring>
 
 using namespace math;
 using namespace utils;
@@ -48,11 +50,17 @@ FScene::FScene(FEngine& engine) :
 
 FScene::~FScene() noexcept = default;
 
+// spreads the lower 10 bits of v two bits apart (bit i moves to bit 3i), so three
+// spread coordinates can be interleaved into a 30-bit Morton code
+static inline uint32_t spreadBits(uint32_t v) noexcept {
+    v = (v | (v << 16u)) & 0x030000FFu;
+    v = (v | (v <<  8u)) & 0x0300F00Fu;
+    v = (v | (v <<  4u)) & 0x030C30C3u;
+    v = (v | (v <<  2u)) & 0x09249249u;
+    return v;
+}
 
-void FScene::prepare(const math::mat4f& worldOriginTansform) {
-    // TODO: can we skip this in most cases? Since we rely on indices staying the same,
-    //       we could only skip, if nothing changed in the RCM.
-
+void FScene::prepare(JobSystem& js, const math::mat4f& worldOriginTansform) {
     FEngine& engine = mEngine;
     EntityManager& em = engine.getEntityManager();
     FRenderableManager& rcm = engine.getRenderableManager();
@@ -63,6 +71,18 @@ void FScene::prepare(const math::mat4f& worldOriginTansform) {
     auto& lightData = mLightData;
     auto const& entities = mEntities;
 
+    // The renderable SoA only depends on the scene's content, the components and the
+    // world origin; when none of those changed since the last prepare() we keep it
+    // as-is -- the per-frame columns (visibility masks, primitive lists) are
+    // overwritten each frame regardless. The light data is always rebuilt: it's
+    // small, and prepareDynamicLights() sorts and truncates it in place.
+    const uint32_t transformEpoch = tcm.getEpoch();
+    const uint32_t renderableEpoch = rcm.getEpoch();
+    const bool reuseRenderables = mRenderableDataValid
+            && mPrepareSceneVersion == mVersion
+            && mPrepareTransformEpoch == transformEpoch
+            && mPrepareRenderableEpoch == renderableEpoch
+            && !memcmp(&mPrepareWorldOrigin, &worldOriginTansform, sizeof(mat4f));
 
     // NOTE: we can't know in advance how many entities are renderable or lights because the corresponding
     // component can be added after the entity is added to the scene.
@@ -74,9 +94,12 @@ void FScene::prepare(const math::mat4f& worldOriginTansform) {
     // we need 1 extra entry at the end for teh summed primitive count
     capacity = capacity + 1;
 
-    sceneData.clear();
-    if (sceneData.capacity() < capacity) {
-        sceneData.setCapacity(capacity);
+    if (!reuseRenderables) {
+        sceneData.clear();
+        if (sceneData.capacity() < capacity) {
+            sceneData.setCapacity(capacity);
+        }
+        mRefitTransforms.clear();
     }
 
     lightData.clear();
@@ -101,31 +124,35 @@ void FScene::prepare(const math::mat4f& worldOriginTansform) {
         if (!ri & !li)
             continue;
 
-        // get the world transform
+        // when the renderable SoA is reused, only the lights need processing
+        if (reuseRenderables && !li)
+            continue;
+
         auto ti = tcm.getInstance(e);
-        const mat4f worldTransform = worldOriginTansform * tcm.getWorldTransform(ti);
 
         // don't even draw this object if it doesn't have a transform (which shouldn't happen
         // because one is always created when creating a Renderable component).
-        if (ri && ti) {
-            // compute the world AABB so we can perform culling
-            const Box worldAABB = rigidTransform(rcm.getAABB(ri), worldTransform);
-
-            // we know there is enough space in the array
+        if (ri && ti && !reuseRenderables) {
+            // the world transform and world-space AABB are filled-in by the parallel
+            // refit job below; we know there is enough space in the array
             sceneData.push_back_unsafe(
                     ri,
-                    worldTransform,
+                    mat4f{},
                     rcm.getVisibility(ri),
-                    rcm.getUbh(ri),
+                    rcm.getUniformOffset(ri),
                     rcm.getBonesUbh(ri),
-                    worldAABB.center,
+                    float3{},
                     0,
                     rcm.getLayerMask(ri),
-                    worldAABB.halfExtent,
+                    float3{},
                     {}, {});
+            mRefitTransforms.push_back(ti);
         }
 
         if (li) {
+            // get the world transform
+            const mat4f worldTransform = worldOriginTansform * tcm.getWorldTransform(ti);
+
             // find the dominant directional light
             if (UTILS_UNLIKELY(lcm.isDirectionalLight(li))) {
                 // we don't store the directional lights, because we only have a single one
@@ -151,12 +178,179 @@ void FScene::prepare(const math::mat4f& worldOriginTansform) {
         }
     }
 
+    if (!reuseRenderables) {
+        // Re-sort the rows by layer mask, so layer-restricted views can skip whole groups
+        // (see acquireLayerRestrictedRange()), and within each group by the Morton code of
+        // the renderable's world position, so the per-row loops (refit, culling, command
+        // generation, UBO updates) visit spatially-close renderables at close addresses --
+        // insertion order is memory-random with respect to spatial locality. The
+        // world-space AABBs aren't computed yet (the refit job below does that), so the
+        // transform's translation stands in for the AABB center, quantized on a 1024^3
+        // grid over the gathered positions' bounds. Both key columns are scratch at this
+        // point: WORLD_AABB_CENTER is overwritten by the refit and
+        // SUMMED_PRIMITIVE_COUNT by RenderPass::updateSummedPrimitiveCounts().
+        mLayerBuckets.clear();
+        if (sceneData.size()) {
+            size_t const count = sceneData.size();
+            auto const* const UTILS_RESTRICT transforms = mRefitTransforms.data();
+            float3* const UTILS_RESTRICT positions = sceneData.data<WORLD_AABB_CENTER>();
+            float3 pmin = std::numeric_limits<float>::max();
+            float3 pmax = std::numeric_limits<float>::lowest();
+            for (size_t i = 0; i < count; i++) {
+                const float3 p = (worldOriginTansform *
+                        tcm.getWorldTransform(transforms[i])[3]).xyz;
+                positions[i] = p;
+                pmin = min(pmin, p);
+                pmax = max(pmax, p);
+            }
+            uint32_t* const UTILS_RESTRICT codes = sceneData.data<SUMMED_PRIMITIVE_COUNT>();
+            const float3 scale =
+                    1023.0f / max(pmax - pmin, float3{ std::numeric_limits<float>::min() });
+            for (size_t i = 0; i < count; i++) {
+                const float3 p = min((positions[i] - pmin) * scale, float3{ 1023.0f });
+                codes[i] = (spreadBits(uint32_t(p.x)) << 2u) |
+                           (spreadBits(uint32_t(p.y)) << 1u) |
+                            spreadBits(uint32_t(p.z));
+            }
+            Zip2Iterator<RenderableSoa::iterator, FTransformManager::Instance*> b =
+                    { sceneData.begin(), mRefitTransforms.data() };
+            std::sort(b, b + count, [](auto const& lhs, auto const& rhs) {
+                const uint8_t l = lhs.first.template get<LAYERS>();
+                const uint8_t r = rhs.first.template get<LAYERS>();
+                if (l != r) {
+                    return l < r;
+                }
+                return lhs.first.template get<SUMMED_PRIMITIVE_COUNT>() <
+                        rhs.first.template get<SUMMED_PRIMITIVE_COUNT>();
+            });
+            uint8_t const* const UTILS_RESTRICT layers = sceneData.data<LAYERS>();
+            for (uint32_t i = 0, c = uint32_t(sceneData.size()); i < c; ) {
+                uint32_t j = i + 1;
+                while (j < c && layers[j] == layers[i]) {
+                    j++;
+                }
+                mLayerBuckets.push_back({ layers[i], i, j });
+                i = j;
+            }
+        }
+    }
+
+    // Refit stage: recompute the world transforms and world-space AABBs of the gathered
+    // renderables on the job system -- this is the dominant cost of prepare() for large
+    // scenes, and each row is independent. The job is joined just before the BVH update,
+    // which (like the culling that follows) consumes its results.
+    JobSystem::Job* refitJob = nullptr;
+    if (!reuseRenderables && sceneData.size()) {
+        assert(mRefitTransforms.size() == sceneData.size());
+        auto const* const UTILS_RESTRICT soaInstance = sceneData.data<RENDERABLE_INSTANCE>();
+        mat4f* const UTILS_RESTRICT soaWorldTransform = sceneData.data<WORLD_TRANSFORM>();
+        float3* const UTILS_RESTRICT soaAabbCenter = sceneData.data<WORLD_AABB_CENTER>();
+        float3* const UTILS_RESTRICT soaAabbExtent = sceneData.data<WORLD_AABB_EXTENT>();
+        auto const* const UTILS_RESTRICT transforms = mRefitTransforms.data();
+        auto refit = [&rcm, &tcm, worldOriginTansform, soaInstance, soaWorldTransform,
+                soaAabbCenter, soaAabbExtent, transforms](uint32_t index, uint32_t c) {
+            // gather pass: world transforms and local AABBs into the SoA columns...
+            for (uint32_t i = index, last = index + c; i < last; i++) {
+                const Box localAABB = rcm.getAABB(soaInstance[i]);
+                soaWorldTransform[i] =
+                        worldOriginTansform * tcm.getWorldTransform(transforms[i]);
+                soaAabbCenter[i] = localAABB.center;
+                soaAabbExtent[i] = localAABB.halfExtent;
+            }
+            // ...then transform the whole chunk's AABBs to world space in place
+            rigidTransformBatch(soaAabbCenter + index, soaAabbExtent + index,
+                    soaWorldTransform + index, c);
+        };
+        refitJob = jobs::parallel_for(js, nullptr, 0, uint32_t(sceneData.size()),
+                std::ref(refit), jobs::AdaptiveSplitter<64, 8>());
+        js.run(refitJob);
+    }
+
     // some elements past the end of the array will be accessed by SIMD code, we need to make
     // sure the data is valid enough as not to produce errors such as divide-by-zero
     // (e.g. in computeLightRanges())
     for (size_t i = lightData.size(), e = (lightData.size() + 3) & ~3; i < e; i++) {
         new(lightData.data<POSITION_RADIUS>() + i) float4{ 0, 0, 0, 1 };
     }
+
+    if (UTILS_LIKELY(refitJob)) {
+        js.wait(refitJob);
+    }
+
+    if (!reuseRenderables) {
+        mRenderableDataValid = true;
+        mPrepareSceneVersion = mVersion;
+        mPrepareTransformEpoch = transformEpoch;
+        mPrepareRenderableEpoch = renderableEpoch;
+        mPrepareWorldOrigin = worldOriginTansform;
+        // the sort above keys on the current world positions, so even an identical
+        // entity set can land in a different row order after a transform-only change:
+        // every rebuild is an order change as far as row-indexed captures are concerned
+        mRenderableOrderVersion++;
+    }
+
+    updateRenderableBvh();
+}
+
+void FScene::updateRenderableBvh() noexcept {
+    // Large scenes get a BVH over the renderable bounds so views can cull whole
+    // subtrees; small scenes are better served by the flat vectorized path. The
+    // leaf order maps BVH entries to SoA rows, so the topology is valid for exactly
+    // one row order: it is rebuilt whenever the order version moved -- prepare()
+    // bumps it on every SoA rebuild (see above), and FView bumps it when its
+    // visibility partition moved rows. Conversely, an unchanged order version means
+    // the SoA was reused as-is, so the bounds are unchanged too and the BVH can be
+    // reused without even a refit.
+    auto& sceneData = mRenderableData;
+    const uint32_t count = uint32_t(sceneData.size());
+    if (UTILS_LIKELY(count < RenderableBvh::MIN_RENDERABLE_COUNT)) {
+        mRenderableBvh.clear();
+        return;
+    }
+
+    if (mRenderableBvh.size() != count || mBvhOrderVersion != mRenderableOrderVersion) {
+        mRenderableBvh.build(sceneData.data<WORLD_AABB_CENTER>(),
+                sceneData.data<WORLD_AABB_EXTENT>(), count);
+        mBvhOrderVersion = mRenderableOrderVersion;
+    }
+}
+
+UTILS_NOINLINE
+utils::Range<uint32_t> FScene::acquireLayerRestrictedRange(uint8_t visibleLayers) noexcept {
+    auto& buckets = mLayerBuckets;
+    const uint32_t count = uint32_t(mRenderableData.size());
+    if (UTILS_UNLIKELY(buckets.empty())) {
+        return { 0, count };
+    }
+
+    // find the span of buckets that intersect visibleLayers; buckets in between that
+    // don't intersect are swept along -- their rows just fail the per-row layer test
+    // as before, and a single contiguous range keeps the callers simple
+    size_t first = buckets.size();
+    size_t last = 0;
+    for (size_t i = 0, c = buckets.size(); i < c; i++) {
+        if (buckets[i].layers & visibleLayers) {
+            first = std::min(first, i);
+            last = std::max(last, i + 1);
+        }
+    }
+    if (first >= last) {
+        // no bucket intersects: this view draws nothing
+        return { 0, 0 };
+    }
+
+    // the caller may reorder rows within the returned range, mixing the spanned
+    // buckets together; merge them (union of their masks) so the grouping invariant
+    // -- a row's layers are contained in its bucket's mask -- keeps holding
+    if (last - first > 1) {
+        LayerBucket merged{ 0, buckets[first].first, buckets[last - 1].last };
+        for (size_t i = first; i < last; i++) {
+            merged.layers |= buckets[i].layers;
+        }
+        buckets[first] = merged;
+        buckets.erase(buckets.begin() + first + 1, buckets.begin() + last);
+    }
+    return { buckets[first].first, buckets[first].last };
 }
 
 void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables) const noexcept {
@@ -277,13 +471,28 @@ void FScene::computeLightRanges(
 }
 
 void FScene::addEntity(Entity entity) {
+    mVersion++;
     mEntities.insert(entity);
 }
 
+void FScene::addEntities(const Entity* entities, size_t count) {
+    mVersion++;
+    mEntities.reserve(mEntities.size() + count);
+    mEntities.insert(entities, entities + count);
+}
+
 void FScene::remove(Entity entity) {
+    mVersion++;
     mEntities.erase(entity);
 }
 
+void FScene::removeEntities(const Entity* entities, size_t count) {
+    mVersion++;
+    for (size_t i = 0; i < count; i++) {
+        mEntities.erase(entities[i]);
+    }
+}
+
 size_t FScene::getRenderableCount() const noexcept {
     FEngine& engine = mEngine;
     EntityManager& em = engine.getEntityManager();
@@ -363,14 +572,26 @@ void Scene::setIndirectLight(IndirectLight const* ibl) noexcept {
     upcast(this)->setIndirectLight(upcast(ibl));
 }
 
+void Scene::setIndirectLightBlend(IndirectLight const* ibl, float blend) noexcept {
+    upcast(this)->setIndirectLightBlend(upcast(ibl), blend);
+}
+
 void Scene::addEntity(Entity entity) {
     upcast(this)->addEntity(entity);
 }
 
+void Scene::addEntities(const Entity* entities, size_t count) {
+    upcast(this)->addEntities(entities, count);
+}
+
 void Scene::remove(Entity entity) {
     upcast(this)->remove(entity);
 }
 
+void Scene::removeEntities(const Entity* entities, size_t count) {
+    upcast(this)->removeEntities(entities, count);
+}
+
 size_t Scene::getRenderableCount() const noexcept {
     return upcast(this)->getRenderableCount();
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/ShadowAtlas.h"
+
+#include "driver/DriverApi.h"
+
+#include <assert.h>
+
+namespace filament {
+using namespace driver;
+namespace details {
+
+ShadowAtlas::ShadowAtlas(uint16_t atlasDimension, uint16_t tileDimension) noexcept
+        : mAtlasDimension(atlasDimension), mTileDimension(tileDimension) {
+    assert(tileDimension && (atlasDimension % tileDimension) == 0);
+    const size_t tilesPerRow = atlasDimension / tileDimension;
+    mEntries.resize(tilesPerRow * tilesPerRow);
+    for (size_t y = 0; y < tilesPerRow; y++) {
+        for (size_t x = 0; x < tilesPerRow; x++) {
+            Entry& entry = mEntries[y * tilesPerRow + x];
+            // each tile has a 1-texel border so PCF doesn't bleed into its neighbors
+            // (same border the single ShadowMap keeps, see ShadowMap::prepare())
+            entry.tile.viewport = {
+                    int32_t(x * tileDimension + 1), int32_t(y * tileDimension + 1),
+                    uint32_t(tileDimension - 2), uint32_t(tileDimension - 2) };
+        }
+    }
+}
+
+void ShadowAtlas::prepare(DriverApi& driver) noexcept {
+    if (UTILS_LIKELY(mTexture)) {
+        return;
+    }
+    // The atlas must be sampleable, so it can't come from the RenderTargetPool whose
+    // depth attachments are render buffers; it's allocated like ShadowMap's texture.
+    const uint32_t dim = mAtlasDimension;
+    mTexture = driver.createTexture(
+            Driver::SamplerType::SAMPLER_2D, 1, Driver::TextureFormat::DEPTH16, 1, dim, dim, 1,
+            TextureUsage::DEPTH_ATTACHMENT);
+    mRenderTarget = driver.createRenderTarget(
+            TargetBufferFlags::SHADOW, dim, dim, 1, Driver::TextureFormat::DEPTH16,
+            {}, { mTexture }, {});
+}
+
+void ShadowAtlas::terminate(DriverApi& driver) noexcept {
+    if (mRenderTarget) {
+        driver.destroyRenderTarget(mRenderTarget);
+        mRenderTarget.clear();
+    }
+    if (mTexture) {
+        driver.destroyTexture(mTexture);
+        mTexture.clear();
+    }
+}
+
+ShadowAtlas::Tile const* ShadowAtlas::acquire(
+        LightId light, float importance, uint32_t contentHash) noexcept {
+    Entry* entry;
+    auto pos = mTileForLight.find(light);
+    if (pos != mTileForLight.end()) {
+        // this light already has a tile; it only needs re-rendering if its content
+        // changed
+        entry = &mEntries[pos->second];
+        entry->tile.needsRendering = (entry->contentHash != contentHash);
+    } else {
+        // look for a free tile, or the best eviction candidate among the tiles not
+        // acquired this frame: least-recently-used first, then least important
+        Entry* victim = nullptr;
+        for (Entry& e : mEntries) {
+            if (!e.allocated) {
+                victim = &e;
+                break;
+            }
+            if (e.lastUsedFrame == mFrame) {
+                continue;   // already acquired this frame
+            }
+            if (!victim
+                    || e.lastUsedFrame < victim->lastUsedFrame
+                    || (e.lastUsedFrame == victim->lastUsedFrame
+                            && e.importance < victim->importance)) {
+                victim = &e;
+            }
+        }
+        if (!victim) {
+            // every tile was acquired this frame
+            return nullptr;
+        }
+        if (victim->allocated) {
+            if (victim->lastUsedFrame + 1 >= mFrame && victim->importance >= importance) {
+                // don't steal the tile of a light that's still active and at least
+                // as important
+                return nullptr;
+            }
+            mTileForLight.erase(victim->light);
+        }
+        victim->allocated = true;
+        victim->light = light;
+        victim->tile.needsRendering = true;
+        mTileForLight[light] = uint32_t(victim - mEntries.data());
+        entry = victim;
+    }
+    entry->importance = importance;
+    entry->contentHash = contentHash;
+    entry->lastUsedFrame = mFrame;
+    return &entry->tile;
+}
+
+} // namespace details
+} // namespace filament
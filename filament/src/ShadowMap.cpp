@@ -24,8 +24,11 @@
 
 #include <filament/driver/DriverEnums.h>
 
+#include <cmath>
 #include <limits>
 
+#include <string.h>
+
 using namespace math;
 using namespace utils;
 
@@ -48,6 +51,7 @@ ShadowMap::ShadowMap(FEngine& engine) noexcept :
     FDebugRegistry& debugRegistry = engine.getDebugRegistry();
     debugRegistry.registerProperty("d.shadowmap.focus_shadowcasters", &engine.debug.shadowmap.focus_shadowcasters);
     debugRegistry.registerProperty("d.shadowmap.far_uses_shadowcasters", &engine.debug.shadowmap.far_uses_shadowcasters);
+    debugRegistry.registerProperty("d.shadowmap.visible_depth_range", &engine.debug.shadowmap.visible_depth_range);
     if (ENABLE_LISPSM) {
         debugRegistry.registerProperty("d.shadowmap.lispsm", &engine.debug.shadowmap.lispsm);
         debugRegistry.registerProperty("d.shadowmap.dzn", &engine.debug.shadowmap.dzn);
@@ -65,9 +69,16 @@ void ShadowMap::prepare(DriverApi& driver, SamplerBuffer& sb) noexcept {
 
     uint32_t dim = mShadowMapDimension;
     uint32_t currentDimension = mViewport.width + 2;
-    if (currentDimension == dim) {
-        // nothing to do here.
+    if (currentDimension == dim && mVsmEnabled == bool(mVsmHandle)) {
         assert(mShadowMapHandle);
+        if (UTILS_UNLIKELY(mBoundToSharedTexture)) {
+            // we were bound to another view's shadow map (see shareFrom()), re-bind our
+            // own texture; its content is from before sharing started, so it's stale
+            setSamplers(sb, mShadowMapHandle, mVsmHandle);
+            mBoundToSharedTexture = false;
+            mNeedsRendering = true;
+        }
+        // nothing else to do here.
         return;
     }
 
@@ -78,8 +89,19 @@ void ShadowMap::prepare(DriverApi& driver, SamplerBuffer& sb) noexcept {
     if (mShadowMapHandle) {
         driver.destroyTexture(mShadowMapHandle);
     }
+    if (mVsmRenderTarget) {
+        driver.destroyRenderTarget(mVsmRenderTarget);
+        mVsmRenderTarget.clear();
+    }
+    if (mVsmHandle) {
+        driver.destroyTexture(mVsmHandle);
+        mVsmHandle.clear();
+    }
 
     // allocate new ones...
+    // the new texture has no content, it must be rendered
+    mNeedsRendering = true;
+
     // we set a viewport with a 1-texel border for when we index outside of the texture
     // DON'T CHANGE this unless computeLightSpaceMatrix() is updated too.
     // see: computeLightSpaceMatrix()
@@ -93,22 +115,75 @@ void ShadowMap::prepare(DriverApi& driver, SamplerBuffer& sb) noexcept {
             TargetBufferFlags::SHADOW, dim, dim, 1, Driver::TextureFormat::DEPTH16,
             {}, { mShadowMapHandle }, {});
 
+    if (mVsmEnabled) {
+        // EVSM moments, with a mip chain so the shader's penumbra width maps to a lod
+        mVsmHandle = driver.createTexture(
+                Driver::SamplerType::SAMPLER_2D, vsmLevelCount(dim),
+                Driver::TextureFormat::RG16F, 1, dim, dim, 1,
+                TextureUsage::COLOR_ATTACHMENT);
+
+        mVsmRenderTarget = driver.createRenderTarget(
+                TargetBufferFlags::COLOR, dim, dim, 1, Driver::TextureFormat::RG16F,
+                { mVsmHandle }, {}, {});
+    }
+
+    setSamplers(sb, mShadowMapHandle, mVsmHandle);
+    mBoundToSharedTexture = false;
+}
+
+uint8_t ShadowMap::vsmLevelCount(uint32_t dimension) noexcept {
+    // a kernel wider than 1/32 of the map is past any plausible penumbra, so don't
+    // bother building (or fetching through) coarser mips
+    return uint8_t(std::min(int(std::ilogbf(float(dimension))) + 1, 6));
+}
+
+void ShadowMap::setSamplers(SamplerBuffer& sb,
+        Handle<HwTexture> depth, Handle<HwTexture> moments) noexcept {
     SamplerParams s;
     s.filterMag = SamplerMagFilter::LINEAR;
     s.filterMin = SamplerMinFilter::LINEAR;
     s.compareFunc = SamplerCompareFunc::LE;
     s.compareMode = SamplerCompareMode::COMPARE_TO_TEXTURE;
     s.depthStencil = true;
-    sb.setSampler(FEngine::PerViewSib::SHADOW_MAP, { mShadowMapHandle, s });
+    sb.setSampler(FEngine::PerViewSib::SHADOW_MAP, { depth, s });
+
+    if (moments) {
+        // the whole point of the moments is hardware trilinear filtering
+        SamplerParams v;
+        v.filterMag = SamplerMagFilter::LINEAR;
+        v.filterMin = SamplerMinFilter::LINEAR_MIPMAP_LINEAR;
+        sb.setSampler(FEngine::PerViewSib::SHADOW_VSM, { moments, v });
+    }
+}
+
+void ShadowMap::prefilter(DriverApi& driver, PostProcessManager& ppm) noexcept {
+    assert(mVsmEnabled && mVsmHandle);
+    ppm.prefilterShadowMap(driver, mShadowMapHandle, mVsmRenderTarget, mVsmHandle,
+            mShadowMapDimension);
+}
+
+void ShadowMap::shareFrom(ShadowMap const& donor, SamplerBuffer& sb) noexcept {
+    assert(&donor != this);
+    assert(donor.mShadowMapHandle);
+    setSamplers(sb, donor.mShadowMapHandle, donor.mVsmHandle);
+    mBoundToSharedTexture = true;
+    mNeedsRendering = false;
 }
 
 void ShadowMap::terminate(DriverApi& driverApi) noexcept {
+    mEngine.releaseSharedShadowMap(this);
     if (mShadowMapRenderTarget) {
         driverApi.destroyRenderTarget(mShadowMapRenderTarget);
     }
     if (mShadowMapHandle) {
         driverApi.destroyTexture(mShadowMapHandle);
     }
+    if (mVsmRenderTarget) {
+        driverApi.destroyRenderTarget(mVsmRenderTarget);
+    }
+    if (mVsmHandle) {
+        driverApi.destroyTexture(mVsmHandle);
+    }
 }
 
 void ShadowMap::beginRenderPass(DriverApi& driver) const noexcept {
@@ -129,7 +204,8 @@ void ShadowMap::beginRenderPass(DriverApi& driver) const noexcept {
 
 void ShadowMap::update(
         const FScene::LightSoa& lightData, size_t index, FScene const* scene,
-        details::CameraInfo const& camera, uint8_t visibleLayers) noexcept {
+        details::CameraInfo const& camera, uint8_t visibleLayers,
+        math::float2 csNearFar) noexcept {
     // this is the hard part here, find a good frustum for our camera
 
     auto& lcm = mEngine.getLightManager();
@@ -139,9 +215,21 @@ void ShadowMap::update(
 
     FLightManager::ShadowParams params = lcm.getShadowParams(li);
     mat4f projection(camera.cullingProjection);
-    if (params.shadowFar > 0.0f) {
-        float n = camera.zn;
-        float f = params.shadowFar;
+    float n = camera.zn;
+    float f = params.shadowFar > 0.0f ? params.shadowFar : camera.zf;
+    if (mEngine.debug.shadowmap.visible_depth_range) {
+        // Tighten the depth range used for fitting the shadow frustum to the range actually
+        // covered by visible renderables; empty space near the camera's near/far planes
+        // would otherwise waste shadow map resolution.
+        n = std::max(n, csNearFar.x);
+        f = std::min(f, csNearFar.y);
+        if (UTILS_UNLIKELY(!(n < f))) {
+            // degenerate range (e.g. a single flat object), fall back to the camera's planes
+            n = camera.zn;
+            f = params.shadowFar > 0.0f ? params.shadowFar : camera.zf;
+        }
+    }
+    if (n != camera.zn || f != camera.zf) {
         if (std::abs(projection[2].w) <= std::numeric_limits<float>::epsilon()) {
             // perspective projection
             projection[2].z =     (f + n) / (n - f);
@@ -189,6 +277,28 @@ void ShadowMap::update(
         case Type::POINT:
             break;
     }
+
+    if (mHasVisibleShadows) {
+        // Decide whether the shadow map's content must be re-rendered. The depth texture
+        // persists across frames, so if the light's frustum is unchanged and no transform
+        // or renderable changed either, the previous content is still valid.
+        // snapLightFrustum() stabilizes mLightSpace against sub-texel motion, so a static
+        // scene and camera produce a bit-identical matrix every frame.
+        uint32_t const transformEpoch = mEngine.getTransformManager().getEpoch();
+        uint32_t const renderableEpoch = mEngine.getRenderableManager().getEpoch();
+        if (memcmp(&mCachedLightSpace, &mLightSpace, sizeof(mLightSpace)) != 0 ||
+                mCachedScene != scene ||
+                mCachedTransformEpoch != transformEpoch ||
+                mCachedRenderableEpoch != renderableEpoch ||
+                mCachedVisibleLayers != visibleLayers) {
+            mNeedsRendering = true;
+            mCachedLightSpace = mLightSpace;
+            mCachedScene = scene;
+            mCachedTransformEpoch = transformEpoch;
+            mCachedRenderableEpoch = renderableEpoch;
+            mCachedVisibleLayers = visibleLayers;
+        }
+    }
 }
 
 void ShadowMap::computeShadowCameraDirectional(
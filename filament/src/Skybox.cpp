@@ -106,6 +106,14 @@ FSkybox::FSkybox(FEngine& engine, const Builder& builder) noexcept
 
     mSkybox = engine.getEntityManager().create();
 
+    // The skybox relies on the following invariants to avoid paying full-screen shading
+    // behind geometry on tiled GPUs:
+    // - priority 7 sorts it after all opaque geometry in the color pass, so it's drawn last
+    // - the full-screen triangle sits exactly on the far plane (z = w = 1 in device domain)
+    //   and the material's default LE depth test then only passes where the depth buffer
+    //   still holds the clear value, i.e. pixels covered by geometry are rejected by early-z
+    // - depthWrite is false in the material, which also keeps it out of the depth pre-pass
+    // (the color clear is elided when a skybox is visible, see FView::getClearTargetColor())
     RenderableManager::Builder(1)
             .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
                     engine.getFullScreenVertexBuffer(),
@@ -112,6 +112,26 @@ void FStream::setDimensions(uint32_t width, uint32_t height) noexcept {
     mEngine.getDriverApi().setStreamDimensions(mStreamHandle, mWidth, mHeight);
 }
 
+void FStream::queueFrame(int64_t timestampNs) noexcept {
+    if (isExternalTextureId()) {
+        // unfortunately, because this call is synchronous, we must make sure the handle has been
+        // created first
+        if (UTILS_UNLIKELY(!mStreamHandle)) {
+            FFence::waitAndDestroy(mEngine.createFence(Fence::Type::SOFT), Fence::Mode::FLUSH);
+        }
+        mEngine.getDriverApi().queueStreamFrame(mStreamHandle, timestampNs);
+    }
+}
+
+void FStream::setTargetLatency(int64_t latencyNs) noexcept {
+    // unfortunately, because this call is synchronous, we must make sure the handle has been
+    // created first
+    if (UTILS_UNLIKELY(!mStreamHandle)) {
+        FFence::waitAndDestroy(mEngine.createFence(Fence::Type::SOFT), Fence::Mode::FLUSH);
+    }
+    mEngine.getDriverApi().setStreamTargetLatency(mStreamHandle, latencyNs);
+}
+
 void FStream::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
         driver::PixelBufferDescriptor&& buffer) noexcept {
     if (isExternalTextureId()) {
@@ -150,6 +170,14 @@ void Stream::setDimensions(uint32_t width, uint32_t height) noexcept {
     upcast(this)->setDimensions(width, height);
 }
 
+void Stream::queueFrame(int64_t timestampNs) noexcept {
+    upcast(this)->queueFrame(timestampNs);
+}
+
+void Stream::setTargetLatency(int64_t latencyNs) noexcept {
+    upcast(this)->setTargetLatency(latencyNs);
+}
+
 void Stream::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
         driver::PixelBufferDescriptor&& buffer) noexcept {
     upcast(this)->readPixels(xoffset, yoffset, width, height, std::move(buffer));
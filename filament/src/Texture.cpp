@@ -100,7 +100,14 @@ Texture* Texture::Builder::build(Engine& engine) {
 
 namespace details {
 
+// selects the stream a texture's create/upload/destroy commands are recorded on
+// (see FEngine::setAsyncResourceLoadingEnabled())
+static inline FEngine::DriverApi& selectDriver(FEngine& engine, bool onResourceStream) noexcept {
+    return onResourceStream ? engine.getResourceDriverApi() : engine.getDriverApi();
+}
+
 FTexture::FTexture(FEngine& engine, const Builder& builder) {
+    mUsesResourceStream = engine.isAsyncResourceLoadingEnabled();
     mWidth  = static_cast<uint32_t>(builder->mWidth);
     mHeight = static_cast<uint32_t>(builder->mHeight);
     mFormat = builder->mFormat;
@@ -111,17 +118,32 @@ FTexture::FTexture(FEngine& engine, const Builder& builder) {
     mLevels = std::min(builder->mLevels,
             static_cast<uint8_t>(std::ilogbf(std::max(mWidth, mHeight)) + 1));
 
-    FEngine::DriverApi& driver = engine.getDriverApi();
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
     mHandle = driver.createTexture(
             mTarget, mLevels, mFormat, mSampleCount, mWidth, mHeight, mDepth, mUsage);
+
+    engine.trackGpuMemory(FEngine::GpuMemoryPool::TEXTURE, int64_t(getEstimatedSize()));
 }
 
 // frees driver resources, object becomes invalid
 void FTexture::terminate(FEngine& engine) {
-    FEngine::DriverApi& driver = engine.getDriverApi();
+    engine.trackGpuMemory(FEngine::GpuMemoryPool::TEXTURE, -int64_t(getEstimatedSize()));
+
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
     driver.destroyTexture(mHandle);
 }
 
+size_t FTexture::getEstimatedSize() const noexcept {
+    size_t texels = 0;
+    for (size_t level = 0; level < mLevels; level++) {
+        texels += getWidth(level) * getHeight(level) * getDepth(level);
+    }
+    if (isCubemap()) {
+        texels *= 6;
+    }
+    return texels * std::max(size_t(1), getSampleCount()) * getFormatSize(mFormat);
+}
+
 static inline size_t valueForLevel(size_t level, size_t value) {
     return std::max(size_t(1), value >> level);
 }
@@ -143,17 +165,29 @@ void FTexture::setImage(FEngine& engine,
         Texture::PixelBufferDescriptor&& buffer) const noexcept {
     if (!mStream && mTarget != Sampler::SAMPLER_CUBEMAP && level < mLevels) {
         if (buffer.buffer) {
-            engine.getDriverApi().load2DImage(mHandle,
+            selectDriver(engine, mUsesResourceStream).load2DImage(mHandle,
                     uint8_t(level), xoffset, yoffset, width, height, std::move(buffer));
         }
     }
 }
 
+void FTexture::setImage(FEngine& engine, size_t level, size_t layer,
+        uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
+        Texture::PixelBufferDescriptor&& buffer) const noexcept {
+    if (!mStream && mTarget == Sampler::SAMPLER_2D_ARRAY && level < mLevels && layer < mDepth) {
+        if (buffer.buffer) {
+            selectDriver(engine, mUsesResourceStream).loadArrayImage(mHandle,
+                    uint8_t(level), uint32_t(layer), xoffset, yoffset, width, height,
+                    std::move(buffer));
+        }
+    }
+}
+
 void FTexture::setImage(FEngine& engine, size_t level,
         Texture::PixelBufferDescriptor&& buffer, const FaceOffsets& faceOffsets) const noexcept {
     if (!mStream && mTarget == Sampler::SAMPLER_CUBEMAP && level < mLevels) {
         if (buffer.buffer) {
-            engine.getDriverApi().loadCubeImage(mHandle, uint8_t(level),
+            selectDriver(engine, mUsesResourceStream).loadCubeImage(mHandle, uint8_t(level),
                     std::move(buffer), faceOffsets);
         }
     }
@@ -165,6 +199,12 @@ void FTexture::setExternalImage(FEngine& engine, void* image) noexcept {
     }
 }
 
+void FTexture::setExternalImage(FEngine& engine, void* hardwareBuffer, int fenceFd) noexcept {
+    if (mTarget == Sampler::SAMPLER_EXTERNAL) {
+        engine.getDriverApi().setExternalHardwareBuffer(mHandle, hardwareBuffer, fenceFd);
+    }
+}
+
 void FTexture::setExternalStream(FEngine& engine, FStream* stream) noexcept {
     if (stream) {
         if (!ASSERT_POSTCONDITION_NON_FATAL(mTarget == Sampler::SAMPLER_EXTERNAL,
@@ -180,9 +220,9 @@ void FTexture::setExternalStream(FEngine& engine, FStream* stream) noexcept {
 }
 
 void FTexture::generateMipmaps(FEngine& engine) const noexcept {
-    if ((mTarget == Sampler::SAMPLER_2D || mTarget == Sampler::SAMPLER_CUBEMAP)
-            && mLevels > 1) {
-        engine.getDriverApi().generateMipmaps(mHandle);
+    if ((mTarget == Sampler::SAMPLER_2D || mTarget == Sampler::SAMPLER_2D_ARRAY
+            || mTarget == Sampler::SAMPLER_CUBEMAP) && mLevels > 1) {
+        selectDriver(engine, mUsesResourceStream).generateMipmaps(mHandle);
     }
 }
 
@@ -332,6 +372,12 @@ void Texture::setImage(Engine& engine,
             level, xoffset, yoffset, width, height, std::move(buffer));
 }
 
+void Texture::setImage(Engine& engine, size_t level, size_t layer,
+        Texture::PixelBufferDescriptor&& buffer) const noexcept {
+    upcast(this)->setImage(upcast(engine), level, layer,
+            0, 0, uint32_t(getWidth(level)), uint32_t(getHeight(level)), std::move(buffer));
+}
+
 void Texture::setImage(Engine& engine, size_t level,
         Texture::PixelBufferDescriptor&& buffer, const FaceOffsets& faceOffsets) const noexcept {
     upcast(this)->setImage(upcast(engine), level, std::move(buffer), faceOffsets);
@@ -341,6 +387,10 @@ void Texture::setExternalImage(Engine& engine, void* image) noexcept {
     upcast(this)->setExternalImage(upcast(engine), image);
 }
 
+void Texture::setExternalImage(Engine& engine, void* hardwareBuffer, int fenceFd) noexcept {
+    upcast(this)->setExternalImage(upcast(engine), hardwareBuffer, fenceFd);
+}
+
 void Texture::setExternalStream(Engine& engine, Stream* stream) noexcept {
     upcast(this)->setExternalStream(upcast(engine), upcast(stream));
 }
@@ -20,8 +20,12 @@
 
 #include "FilamentAPI-impl.h"
 
+#include <utils/Hash.h>
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
+#include <cstring>
+
 namespace filament {
 
 using namespace details;
@@ -31,6 +35,8 @@ struct VertexBuffer::BuilderDetails {
     AttributeBitset mDeclaredAttributes;
     uint32_t mVertexCount = 0;
     uint8_t mBufferCount = 0;
+    BufferUsage mUsage = BufferUsage::STATIC;
+    bool mDedupe = false;
 };
 
 static bool hasIntegerTarget(VertexAttribute attribute) {
@@ -93,6 +99,16 @@ VertexBuffer::Builder& VertexBuffer::Builder::attribute(VertexAttribute attribut
     return *this;
 }
 
+VertexBuffer::Builder& VertexBuffer::Builder::usage(BufferUsage usage) noexcept {
+    mImpl->mUsage = usage;
+    return *this;
+}
+
+VertexBuffer::Builder& VertexBuffer::Builder::dedupe() noexcept {
+    mImpl->mDedupe = true;
+    return *this;
+}
+
 VertexBuffer::Builder& VertexBuffer::Builder::normalized(VertexAttribute attribute) noexcept {
     if (size_t(attribute) < MAX_ATTRIBUTE_BUFFERS_COUNT) {
         AttributeData& entry = mImpl->mAttributes[attribute];
@@ -117,13 +133,45 @@ VertexBuffer* VertexBuffer::Builder::build(Engine& engine) {
 
 namespace details {
 
+// selects the stream a vertex buffer's create/upload/destroy commands are recorded on
+// (see FEngine::setAsyncResourceLoadingEnabled())
+static inline FEngine::DriverApi& selectDriver(FEngine& engine, bool onResourceStream) noexcept {
+    return onResourceStream ? engine.getResourceDriverApi() : engine.getDriverApi();
+}
+
+// a buffer slot stashed by setBufferAt() while deduplication is in flight
+// (see Builder::dedupe()); the hash is computed on the JobSystem
+struct FVertexBuffer::PendingBuffer {
+    driver::BufferDescriptor data;
+    uint32_t size = 0;
+    uint64_t hash[2] = {};
+    utils::JobSystem::Job* job = nullptr;
+};
+
+static inline uint64_t hashCombine(uint64_t seed, uint64_t value) noexcept {
+    return seed ^ (value + 0x9e3779b97f4a7c15llu + (seed << 6u) + (seed >> 2u));
+}
+
 FVertexBuffer::FVertexBuffer(FEngine& engine, const VertexBuffer::Builder& builder)
-        : mVertexCount(builder->mVertexCount), mBufferCount(builder->mBufferCount) {
+        : mVertexCount(builder->mVertexCount), mBufferCount(builder->mBufferCount),
+          mUsage(builder->mUsage),
+          mUsesResourceStream(engine.isAsyncResourceLoadingEnabled()),
+          mDedupEnabled(builder->mDedupe && builder->mUsage == BufferUsage::STATIC) {
     std::copy(std::begin(builder->mAttributes), std::end(builder->mAttributes), mAttributes.begin());
-
     mDeclaredAttributes = builder->mDeclaredAttributes;
-    uint8_t attributeCount = (uint8_t) mDeclaredAttributes.count();
 
+    if (UTILS_UNLIKELY(mDedupEnabled)) {
+        // GPU storage is deferred until every buffer slot has been set, so we can
+        // match the content against the engine's registry first (see setBufferAt())
+        mPendingBuffers = new PendingBuffer[mBufferCount];
+        mPendingMask = (1u << mBufferCount) - 1u;
+    } else {
+        mHandle = createHwBuffer(engine);
+        engine.trackGpuMemory(FEngine::GpuMemoryPool::VERTEX_BUFFER, int64_t(getEstimatedSize()));
+    }
+}
+
+Handle<HwVertexBuffer> FVertexBuffer::createHwBuffer(FEngine& engine) noexcept {
     Driver::AttributeArray attributeArray;
 
     static_assert(attributeArray.size() == MAX_ATTRIBUTE_BUFFERS_COUNT,
@@ -144,20 +192,66 @@ FVertexBuffer::FVertexBuffer(FEngine& engine, const VertexBuffer::Builder& build
         }
     }
 
-    FEngine::DriverApi& driver = engine.getDriverApi();
-    mHandle = driver.createVertexBuffer(
-            mBufferCount, attributeCount, mVertexCount, attributeArray);
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
+    return driver.createVertexBuffer(
+            mBufferCount, (uint8_t) declaredAttributes.count(), mVertexCount,
+            attributeArray, mUsage);
 }
 
 void FVertexBuffer::terminate(FEngine& engine) {
-    FEngine::DriverApi& driver = engine.getDriverApi();
-    driver.destroyVertexBuffer(mHandle);
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
+    if (UTILS_UNLIKELY(mSharedHandle)) {
+        // shared storage: release our reference, destroy it with the last one
+        auto& registry = engine.getVertexBufferDedupRegistry();
+        auto pos = registry.find({ mDedupKey[0], mDedupKey[1] });
+        assert(pos != registry.end());
+        if (--pos->second.refs == 0) {
+            engine.trackGpuMemory(FEngine::GpuMemoryPool::VERTEX_BUFFER,
+                    -int64_t(pos->second.bytes));
+            driver.destroyVertexBuffer(pos->second.handle);
+            registry.erase(pos);
+        }
+    } else if (UTILS_UNLIKELY(mPendingBuffers != nullptr)) {
+        // deduplication never completed, no GPU storage was ever created; wait for
+        // in-flight hash jobs and release the stashed data
+        utils::JobSystem& js = engine.getJobSystem();
+        for (size_t i = 0; i < mBufferCount; i++) {
+            if (mPendingBuffers[i].job) {
+                js.wait(mPendingBuffers[i].job);
+            }
+        }
+        delete [] mPendingBuffers;
+        mPendingBuffers = nullptr;
+    } else {
+        engine.trackGpuMemory(FEngine::GpuMemoryPool::VERTEX_BUFFER,
+                -int64_t(getEstimatedSize()));
+        driver.destroyVertexBuffer(mHandle);
+    }
 }
 
 size_t FVertexBuffer::getVertexCount() const noexcept {
     return mVertexCount;
 }
 
+size_t FVertexBuffer::getEstimatedSize() const noexcept {
+    // each backing buffer must be at least large enough for the furthest-reaching
+    // attribute assigned to it (strides are never 0 here, the builder fixed them up)
+    size_t bufferSizes[MAX_ATTRIBUTE_BUFFERS_COUNT] = {};
+    auto const& declaredAttributes = mDeclaredAttributes;
+    auto const& attributes = mAttributes;
+    for (size_t i = 0, n = attributes.size(); i < n; ++i) {
+        if (declaredAttributes[i]) {
+            const size_t end = attributes[i].offset + mVertexCount * attributes[i].stride;
+            bufferSizes[attributes[i].buffer] = std::max(bufferSizes[attributes[i].buffer], end);
+        }
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < mBufferCount; i++) {
+        size += bufferSizes[i];
+    }
+    return size;
+}
+
 void FVertexBuffer::setBufferAt(FEngine& engine, uint8_t bufferIndex,
         driver::BufferDescriptor&& buffer, uint32_t byteOffset, uint32_t byteSize) {
 
@@ -165,13 +259,134 @@ void FVertexBuffer::setBufferAt(FEngine& engine, uint8_t bufferIndex,
         byteSize = uint32_t(buffer.size);
     }
 
-    if (bufferIndex < mBufferCount) {
-        engine.getDriverApi().loadVertexBuffer(mHandle, bufferIndex,
-                std::move(buffer), byteOffset, byteSize);
+    if (!ASSERT_PRECONDITION_NON_FATAL(bufferIndex < mBufferCount,
+            "bufferIndex must be < bufferCount")) {
+        return;
+    }
+
+    if (UTILS_UNLIKELY(mDedupEnabled)) {
+        if (!ASSERT_PRECONDITION_NON_FATAL(mPendingBuffers != nullptr,
+                "deduplicated vertex buffers can't be re-specified")) {
+            return;
+        }
+        const uint32_t bit = 1u << bufferIndex;
+        if (UTILS_LIKELY(byteOffset == 0 && (mPendingMask & bit))) {
+            // stash the data and hash it on the JobSystem while the caller prepares
+            // the next buffer; every byte contributes to the hash, including trailing
+            // bytes that don't fill a 32-bit word
+            PendingBuffer& pending = mPendingBuffers[bufferIndex];
+            pending.data = std::move(buffer);
+            pending.size = byteSize;
+            utils::JobSystem& js = engine.getJobSystem();
+            pending.job = utils::jobs::createJob(js, nullptr, [](PendingBuffer* p) {
+                uint32_t const* const words = static_cast<uint32_t const*>(p->data.buffer);
+                size_t const wordCount = p->size / 4;
+                // the size isn't necessarily a multiple of 4; fold the trailing bytes
+                // into an extra zero-padded word
+                uint32_t tail = 0;
+                size_t const tailBytes = p->size & 3u;
+                if (tailBytes) {
+                    memcpy(&tail, reinterpret_cast<uint8_t const*>(p->data.buffer)
+                            + p->size - tailBytes, tailBytes);
+                }
+                auto hash = [&](uint32_t seed) -> uint32_t {
+                    // murmur3() requires a non-zero word count
+                    uint32_t const h = wordCount
+                            ? utils::hash::murmur3(words, wordCount, seed) : seed;
+                    return tailBytes ? utils::hash::murmur3(&tail, 1, h) : h;
+                };
+                p->hash[0] = (uint64_t(hash(0x9747b28cu)) << 32u) | hash(0u);
+                p->hash[1] = (uint64_t(hash(0xc2b2ae35u)) << 32u) | hash(0x85ebca6bu);
+            }, &pending);
+            js.run(pending.job);
+            mPendingMask &= ~bit;
+            if (mPendingMask == 0) {
+                finishDedup(engine);
+            }
+        } else {
+            // partial or repeated updates can't be deduplicated, fall back to
+            // private storage and apply this update normally
+            abandonDedup(engine);
+            selectDriver(engine, mUsesResourceStream).loadVertexBuffer(mHandle, bufferIndex,
+                    std::move(buffer), byteOffset, byteSize);
+        }
+        return;
+    }
+
+    selectDriver(engine, mUsesResourceStream).loadVertexBuffer(mHandle, bufferIndex,
+            std::move(buffer), byteOffset, byteSize);
+}
+
+UTILS_NOINLINE
+void FVertexBuffer::finishDedup(FEngine& engine) noexcept {
+    utils::JobSystem& js = engine.getJobSystem();
+
+    // The layout must match too, not just the content: the same bytes interpreted
+    // with a different declaration are a different buffer. Two independently seeded
+    // chains form a 128-bit key: a match aliases user geometry on shared GPU storage
+    // with nothing left to byte-compare against (the stashed CPU copies are handed
+    // to the driver or released), so the key alone has to make accidental collisions
+    // implausible -- 64 bits would not.
+    uint64_t lo = utils::hash::murmur3(
+            reinterpret_cast<uint32_t const*>(mAttributes.data()),
+            sizeof(mAttributes) / 4, mDeclaredAttributes.getValue());
+    uint64_t hi = utils::hash::murmur3(
+            reinterpret_cast<uint32_t const*>(mAttributes.data()),
+            sizeof(mAttributes) / 4, ~mDeclaredAttributes.getValue());
+    lo = hashCombine(lo, (uint64_t(mVertexCount) << 8u) | mBufferCount);
+    hi = hashCombine(hi, (uint64_t(mBufferCount) << 32u) | mVertexCount);
+    for (size_t i = 0; i < mBufferCount; i++) {
+        PendingBuffer& pending = mPendingBuffers[i];
+        js.wait(pending.job);
+        pending.job = nullptr;
+        lo = hashCombine(lo, hashCombine(pending.hash[0], pending.size));
+        hi = hashCombine(hi, hashCombine(pending.hash[1], pending.size));
+    }
+    const FEngine::VertexBufferDedupKey key{ lo, hi };
+
+    auto& registry = engine.getVertexBufferDedupRegistry();
+    auto pos = registry.find(key);
+    if (pos != registry.end()) {
+        // matched an existing buffer: adopt its storage; our stashed copies are
+        // released below without ever reaching the GPU
+        mHandle = pos->second.handle;
+        pos->second.refs++;
     } else {
-        ASSERT_PRECONDITION_NON_FATAL(bufferIndex < mBufferCount,
-                "bufferIndex must be < bufferCount");
+        mHandle = createHwBuffer(engine);
+        FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
+        for (size_t i = 0; i < mBufferCount; i++) {
+            PendingBuffer& pending = mPendingBuffers[i];
+            driver.loadVertexBuffer(mHandle, i, std::move(pending.data), 0, pending.size);
+        }
+        uint32_t const bytes = uint32_t(getEstimatedSize());
+        registry[key] = { mHandle, 1, bytes };
+        engine.trackGpuMemory(FEngine::GpuMemoryPool::VERTEX_BUFFER, int64_t(bytes));
+    }
+    mDedupKey[0] = key.lo;
+    mDedupKey[1] = key.hi;
+    mSharedHandle = true;
+    delete [] mPendingBuffers;
+    mPendingBuffers = nullptr;
+}
+
+UTILS_NOINLINE
+void FVertexBuffer::abandonDedup(FEngine& engine) noexcept {
+    // give up on sharing: create private storage and flush the slots already stashed
+    mDedupEnabled = false;
+    mHandle = createHwBuffer(engine);
+    engine.trackGpuMemory(FEngine::GpuMemoryPool::VERTEX_BUFFER, int64_t(getEstimatedSize()));
+
+    utils::JobSystem& js = engine.getJobSystem();
+    FEngine::DriverApi& driver = selectDriver(engine, mUsesResourceStream);
+    for (size_t i = 0; i < mBufferCount; i++) {
+        PendingBuffer& pending = mPendingBuffers[i];
+        if (pending.job) {
+            js.wait(pending.job);
+            driver.loadVertexBuffer(mHandle, i, std::move(pending.data), 0, pending.size);
+        }
     }
+    delete [] mPendingBuffers;
+    mPendingBuffers = nullptr;
 }
 
 } // namespace details
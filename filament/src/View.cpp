@@ -36,6 +36,8 @@
 #include <math/scalar.h>
 #include <math/fast.h>
 
+#include <cstring>
+
 using namespace math;
 using namespace utils;
 
@@ -52,6 +54,11 @@ static constexpr uint8_t VISIBLE_RENDERABLE = 1u << VISIBLE_RENDERABLE_BIT;
 static constexpr uint8_t VISIBLE_SHADOW_CASTER = 1u << VISIBLE_SHADOW_CASTER_BIT;
 static constexpr uint8_t VISIBLE_ALL = VISIBLE_RENDERABLE | VISIBLE_SHADOW_CASTER;
 
+// Slack of the potential-shadow-caster capture, as a fraction of the scene's bounding
+// radius (see FView::ShadowCasterCache). Larger values keep the capture valid through
+// more light/camera drift but make the candidate set bigger.
+static constexpr float SHADOW_CASTER_CACHE_MARGIN = 0.05f;
+
 FView::FView(FEngine& engine)
     : mFroxelizer(engine),
       mPerViewUb(engine.getPerViewUib()),
@@ -84,8 +91,129 @@ void FView::terminate(FEngine& engine) {
     DriverApi& driverApi = engine.getDriverApi();
     driverApi.destroyUniformBuffer(mPerViewUbh);
     driverApi.destroySamplerBuffer(mPerViewSbh);
+    for (auto const& query : mOcclusionQueries.handles) {
+        if (query) {
+            driverApi.destroyOcclusionQuery(query);
+        }
+    }
+    mOcclusionQueries.handles.clear();
+    mOcclusionQueries.recorder = {};
     mDirectionalShadowMap.terminate(driverApi);
     mFroxelizer.terminate(driverApi);
+    releaseCachedFrame(engine);
+}
+
+void FView::computeCacheSignature(RenderCache::Signature& sig, FEngine& engine) const noexcept {
+    // the signature is compared bitwise, make sure the padding is cleared
+    memset(&sig, 0, sizeof(sig));
+    FCamera const* const camera = mViewingCamera ? mViewingCamera : mCullingCamera;
+    if (camera) {
+        sig.cameraModel = camera->getModelMatrix();
+        sig.cameraProjection = camera->getProjectionMatrix();
+    }
+    sig.camera = camera;
+    sig.scene = mScene;
+    sig.sceneVersion = mScene ? mScene->getVersion() : 0;
+    sig.transformEpoch = engine.getTransformManager().getEpoch();
+    sig.renderableEpoch = engine.getRenderableManager().getEpoch();
+    sig.materialVersion = FMaterialInstance::getVersion();
+    sig.occlusionResultsVersion = mOcclusionQueries.resultsVersion;
+    sig.clearColor = mClearColor;
+    sig.viewport = mViewport;
+    sig.antiAliasing = mAntiAliasing;
+    sig.visibleLayers = mVisibleLayers;
+    sig.sampleCount = mSampleCount;
+    sig.flags = uint8_t(mClearTargetColor)
+            | (uint8_t(mClearTargetDepth) << 1u)
+            | (uint8_t(mHasPostProcessPass) << 2u)
+            | (uint8_t(mShadowingEnabled) << 3u)
+            | (uint8_t(mGpuOcclusionCullingEnabled) << 4u);
+}
+
+RenderTargetPool::Target const* FView::getValidCachedFrame(FEngine& engine) const noexcept {
+    RenderCache const& cache = mRenderCache;
+    if (!cache.valid || !cache.target) {
+        return nullptr;
+    }
+    RenderCache::Signature sig;
+    computeCacheSignature(sig, engine);
+    if (memcmp(&sig, &cache.signature, sizeof(sig)) != 0) {
+        return nullptr;
+    }
+    return cache.target;
+}
+
+void FView::commitCachedFrame(FEngine& engine, RenderTargetPool::Target const* target) noexcept {
+    RenderCache& cache = mRenderCache;
+    if (cache.target && cache.target != target) {
+        engine.getRenderTargetPool().put(cache.target);
+    }
+    cache.target = target;
+    computeCacheSignature(cache.signature, engine);
+    cache.valid = true;
+}
+
+void FView::releaseCachedFrame(FEngine& engine) noexcept {
+    RenderCache& cache = mRenderCache;
+    if (cache.target) {
+        engine.getRenderTargetPool().put(cache.target);
+        cache.target = nullptr;
+    }
+    cache.valid = false;
+}
+
+void FView::computeCommandSignature(CommandCache::Signature& sig, FEngine& engine,
+        uint32_t commandTypeFlags, RenderPass::RenderFlags renderFlags) const noexcept {
+    // the signature is compared bitwise, make sure the padding is cleared
+    memset(&sig, 0, sizeof(sig));
+    FCamera const* const camera = mViewingCamera ? mViewingCamera : mCullingCamera;
+    if (camera) {
+        sig.cameraModel = camera->getModelMatrix();
+        sig.cameraProjection = camera->getProjectionMatrix();
+    }
+    sig.cullingViewProjection = mCullingViewProjection;
+    sig.camera = camera;
+    sig.scene = mScene;
+    sig.sceneVersion = mScene ? mScene->getVersion() : 0;
+    sig.transformEpoch = engine.getTransformManager().getEpoch();
+    sig.renderableEpoch = engine.getRenderableManager().getEpoch();
+    sig.occluderVersion = mOccluderVersion;
+    sig.occlusionResultsVersion = mOcclusionQueries.resultsVersion;
+    sig.commandTypeFlags = commandTypeFlags;
+    sig.renderFlags = renderFlags;
+    sig.visibleLayers = mVisibleLayers;
+    sig.flags = uint8_t(mCulling)
+            | (uint8_t(mOcclusionCullingEnabled) << 1u)
+            | (uint8_t(mGpuOcclusionCullingEnabled) << 2u);
+}
+
+bool FView::reuseCachedCommands(FEngine& engine, uint32_t commandTypeFlags,
+        RenderPass::RenderFlags renderFlags,
+        GrowingSlice<RenderPass::Command>& commands) const noexcept {
+    CommandCache const& cache = mCommandCache;
+    if (!cache.valid || cache.commands.empty()) {
+        return false;
+    }
+    CommandCache::Signature sig;
+    computeCommandSignature(sig, engine, commandTypeFlags, renderFlags);
+    if (memcmp(&sig, &cache.signature, sizeof(sig)) != 0) {
+        return false;
+    }
+    // the cached commands include the trailing sentinel
+    RenderPass::Command* const p = commands.grow(cache.commands.size());
+    memcpy(p, cache.commands.data(), cache.commands.size() * sizeof(RenderPass::Command));
+    return true;
+}
+
+void FView::cacheCommands(FEngine& engine, uint32_t commandTypeFlags,
+        RenderPass::RenderFlags renderFlags,
+        Slice<RenderPass::Command> const& commands) noexcept {
+    CommandCache& cache = mCommandCache;
+    cache.commands.resize(commands.size());
+    memcpy(cache.commands.data(), commands.begin(),
+            commands.size() * sizeof(RenderPass::Command));
+    computeCommandSignature(cache.signature, engine, commandTypeFlags, renderFlags);
+    cache.valid = true;
 }
 
 void FView::setViewport(Viewport const& viewport) noexcept {
@@ -140,6 +268,10 @@ void FView::setDynamicLightingOptions(float zLightNear, float zLightFar) noexcep
     mFroxelizer.setOptions(zLightNear, zLightFar);
 }
 
+void FView::setFroxelDepthDistribution(float power) noexcept {
+    mFroxelizer.setDepthDistribution(power);
+}
+
 
 math::float2 FView::updateScale(duration frameTime) noexcept {
     DynamicResolutionOptions const& options = mDynamicResolution;
@@ -271,16 +403,33 @@ void FView::prepareShadowing(FEngine& engine, driver::DriverApi& driver,
     FLightManager::Instance directionalLight = lightData.elementAt<FScene::LIGHT_INSTANCE>(0);
     mHasShadowing = mShadowingEnabled && directionalLight && lcm.isShadowCaster(directionalLight);
     if (UTILS_UNLIKELY(mHasShadowing)) {
+        // depth bounds of the visible set, used to tighten the shadow camera's frustum fit
+        float2 const csNearFar = computeVisibleDepthRange(renderableData);
+
         // compute the frustum for this light
         ShadowMap& shadowMap = mDirectionalShadowMap;
-        shadowMap.update(lightData, 0, scene, mViewingCameraInfo, mVisibleLayers);
+        shadowMap.setSoftShadowsEnabled(mSoftShadowsEnabled);
+        shadowMap.update(lightData, 0, scene, mViewingCameraInfo, mVisibleLayers, csNearFar);
         if (shadowMap.hasVisibleShadows()) {
-            // Cull shadow casters
-            Frustum const& frustum = shadowMap.getCamera().getFrustum();
-            prepareVisibleShadowCasters(engine.getJobSystem(), renderableData, frustum);
-
-            // allocates shadowmap driver resources
-            shadowMap.prepare(driver, getUs());
+            // Another view rendering the same scene may already hold shadow map content
+            // for an identical shadow camera (e.g. split-screen); if so, bind its
+            // texture instead of culling shadow casters and rendering our own.
+            FEngine::SharedShadowKey const key{ directionalLight, scene,
+                    shadowMap.getLightSpaceMatrix(),
+                    lcm.getShadowMapSize(directionalLight) };
+            ShadowMap* const donor = engine.findSharedShadowMap(key, &shadowMap);
+            if (UTILS_UNLIKELY(donor && !donor->needsRendering()
+                    && donor->isSoftShadowsEnabled() == mSoftShadowsEnabled)) {
+                shadowMap.shareFrom(*donor, getUs());
+            } else {
+                // Cull shadow casters
+                Frustum const& frustum = shadowMap.getCamera().getFrustum();
+                prepareVisibleShadowCasters(engine, engine.getJobSystem(), renderableData, frustum);
+
+                // allocates shadowmap driver resources
+                shadowMap.prepare(driver, getUs());
+                engine.updateSharedShadowMap(&shadowMap, key);
+            }
 
             mat4f const& lightFromWorldMatrix = shadowMap.getLightSpaceMatrix();
             u.setUniform(offsetof(FEngine::PerViewUib, lightFromWorldMatrix), lightFromWorldMatrix);
@@ -293,6 +442,12 @@ void FView::prepareShadowing(FEngine& engine, driver::DriverApi& driver,
             const float normalBias = lcm.getShadowNormalBias(directionalLight);
             u.setUniform(offsetof(FEngine::PerViewUib, shadowBias),
                     float3{ 2 * constantBias / sceneRange, normalBias * texelSizeWorldSpace, 0 });
+
+            // soft shadows: tell the shader to sample the prefiltered moments instead of
+            // the depth, and how far up the mip chain the penumbra may reach
+            u.setUniform(offsetof(FEngine::PerViewUib, vsmParams),
+                    float4{ mSoftShadowsEnabled ? 1.0f : 0.0f,
+                            shadowMap.getMaxPenumbraLod(), 0, 0 });
         }
     }
 }
@@ -322,18 +477,50 @@ void FView::prepareLighting(FEngine& engine, FEngine::DriverApi& driver, ArenaSc
     // IBL
     FIndirectLight const* const ibl = scene->getIndirectLight();
     if (ibl) {
-        u.setUniform(offsetof(FEngine::PerViewUib, iblLuminance), ibl->getIntensity() * exposure);
-        u.setUniformArray(offsetof(FEngine::PerViewUib, iblSH), ibl->getSH(), 9);
+        FIndirectLight const* const blendIbl = scene->getBlendIndirectLight();
+        const float blend = blendIbl ? scene->getIndirectLightBlend() : 0.0f;
+
+        float intensity = ibl->getIntensity();
+        float3 sh[9];
+        std::copy_n(ibl->getSH(), 9, sh);
+        if (UTILS_UNLIKELY(blend > 0.0f)) {
+            // SH coefficients and intensity are linear, so the irradiance crossfade is
+            // just a CPU-side lerp into the per-view UBO
+            intensity = intensity + (blendIbl->getIntensity() - intensity) * blend;
+            float3 const* const UTILS_RESTRICT sh2 = blendIbl->getSH();
+            for (size_t i = 0; i < 9; i++) {
+                sh[i] = sh[i] + (sh2[i] - sh[i]) * blend;
+            }
+        }
+        u.setUniform(offsetof(FEngine::PerViewUib, iblLuminance), intensity * exposure);
+        u.setUniformArray(offsetof(FEngine::PerViewUib, iblSH), sh, 9);
+
+        SamplerParams reflectionSamplerParams;
+        reflectionSamplerParams.filterMag = SamplerMagFilter::LINEAR;
+        reflectionSamplerParams.filterMin = SamplerMinFilter::LINEAR_MIPMAP_LINEAR;
         if (ibl->getReflectionMap()) {
-            SamplerParams reflectionSamplerParams;
-            reflectionSamplerParams.filterMag = SamplerMagFilter::LINEAR;
-            reflectionSamplerParams.filterMin = SamplerMinFilter::LINEAR_MIPMAP_LINEAR;
             mPerViewSb.setSampler(FEngine::PerViewSib::IBL_SPECULAR,
                     { ibl->getReflectionMap(), reflectionSamplerParams });
         }
+        // the reflections crossfade happens in the shader; only pass a non-zero factor
+        // down when the second prefiltered map is actually bound
+        const bool blendReflections = blend > 0.0f && blendIbl->getReflectionMap();
+        if (blendReflections) {
+            mPerViewSb.setSampler(FEngine::PerViewSib::IBL_SPECULAR_BLEND,
+                    { blendIbl->getReflectionMap(), reflectionSamplerParams });
+        }
+        u.setUniform(offsetof(FEngine::PerViewUib, iblBlend), blendReflections ? blend : 0.0f);
+
+        // probe volume for parallax-corrected reflections ("box projection")
+        Box const& probe = ibl->getProbeVolume();
+        u.setUniform(offsetof(FEngine::PerViewUib, iblProbeCenter),
+                float4{ probe.center, probe.isEmpty() ? 0.0f : 1.0f });
+        u.setUniform(offsetof(FEngine::PerViewUib, iblProbeHalfExtent),
+                float4{ probe.halfExtent, 0.0f });
     } else {
         u.setUniform(offsetof(FEngine::PerViewUib, iblLuminance),
                 FIndirectLight::DEFAULT_INTENSITY * exposure);
+        u.setUniform(offsetof(FEngine::PerViewUib, iblBlend), 0.0f);
     }
 
     // Directional light (always at index 0)
@@ -416,8 +603,8 @@ void FView::prepare(FEngine& engine, driver::DriverApi& driver, ArenaScope& aren
     const mat4f worldOriginCamera = worldOriginScene;
     const mat4f model{ worldOriginCamera * camera->getModelMatrix() };
     mViewingCameraInfo = CameraInfo{
-            // projection with infinite z-far
-            .projection         = mat4f{ camera->getProjectionMatrix() },
+            // projection with infinite z-far (and the TAA jitter, when set)
+            .projection         = mat4f{ camera->getJitteredProjectionMatrix() },
             // projection used for culling, with finite z-far
             .cullingProjection  = mat4f{ camera->getCullingProjectionMatrix() },
             // camera model matrix -- apply the world origin to it
@@ -433,15 +620,18 @@ void FView::prepare(FEngine& engine, driver::DriverApi& driver, ArenaScope& aren
             // world origin transform, use only for debugging
             .worldOrigin        = worldOriginCamera
     };
+    const mat4f cullingView =
+            FCamera::getViewMatrix(worldOriginScene * mCullingCamera->getModelMatrix());
     mCullingFrustum = FCamera::getFrustum(
-            mCullingCamera->getCullingProjectionMatrix(),
-            FCamera::getViewMatrix(worldOriginScene * mCullingCamera->getModelMatrix()));
+            mCullingCamera->getCullingProjectionMatrix(), cullingView);
+    // also needed by the occlusion stage, which rasterizes in clip space
+    mCullingViewProjection = mat4f(mCullingCamera->getCullingProjectionMatrix()) * cullingView;
 
     /*
      * Gather all information needed to render this scene. Apply the world origin to all
      * objects in the scene.
      */
-    scene->prepare(worldOriginScene);
+    scene->prepare(js, worldOriginScene);
 
     /*
      * Culling: as soon as possible we perform our camera-culling
@@ -451,7 +641,58 @@ void FView::prepare(FEngine& engine, driver::DriverApi& driver, ArenaScope& aren
     FScene::RenderableSoa& renderableData = scene->getRenderableData();
     Slice<Culler::result_type> cullingMask = renderableData.slice<FScene::VISIBLE_MASK>();
     std::fill(cullingMask.begin(), cullingMask.end(), 0); // TODO: can we avoid this fill?
-    prepareVisibleRenderables(js, renderableData);
+
+    // The SoA rows are grouped by layer; a view restricted to a small layer subset
+    // (e.g. a UI view) only processes the rows that can possibly be in its layers,
+    // rather than testing the layer mask of the whole scene row by row.
+    const Range candidates = scene->acquireLayerRestrictedRange(getVisibleLayers());
+
+    // Culling is a pure function of the world-space AABBs and the culling frustum. The
+    // AABBs can only have changed if a transform or a renderable component was touched
+    // since last frame, which we detect with the managers' epoch counters -- and the SoA
+    // above is rebuilt in the same (entity) order by FScene::prepare() otherwise. The
+    // masks are restored by row index, so the capture is only usable while the SoA rows
+    // are in the order they were captured under: the visibility partition below permutes
+    // them in place, which the scene's order version tracks. When all of this is
+    // unchanged, we reuse last frame's visibility instead of re-culling.
+    VisibilityCache& cache = mVisibilityCache;
+    const uint32_t transformEpoch = engine.getTransformManager().getEpoch();
+    const uint32_t renderableEpoch = engine.getRenderableManager().getEpoch();
+    const uint32_t sceneVersion = scene->getVersion();
+    const uint32_t orderVersion = scene->getRenderableOrderVersion();
+    const bool cacheHit = isCullingEnabled()
+            && cache.valid
+            && cache.scene == scene
+            && cache.sceneVersion == sceneVersion
+            && cache.transformEpoch == transformEpoch
+            && cache.renderableEpoch == renderableEpoch
+            && cache.orderVersion == orderVersion
+            && cache.occluderVersion == mOccluderVersion
+            && cache.occlusionEnabled == mOcclusionCullingEnabled
+            && cache.masks.size() == renderableData.size()
+            && !memcmp(cache.planes, mCullingFrustum.getNormalizedPlanes(),
+                       sizeof(cache.planes));
+
+    if (UTILS_LIKELY(!cacheHit)) {
+        prepareVisibleRenderables(engine, js, renderableData, candidates);
+        if (isCullingEnabled()) {
+            // remember this frame's visibility for the next frame
+            cache.masks.assign(cullingMask.begin(), cullingMask.end());
+            memcpy(cache.planes, mCullingFrustum.getNormalizedPlanes(), sizeof(cache.planes));
+            cache.scene = scene;
+            cache.sceneVersion = sceneVersion;
+            cache.transformEpoch = transformEpoch;
+            cache.renderableEpoch = renderableEpoch;
+            cache.orderVersion = orderVersion;
+            cache.occluderVersion = mOccluderVersion;
+            cache.occlusionEnabled = mOcclusionCullingEnabled;
+            cache.valid = true;
+        } else {
+            cache.valid = false;
+        }
+    } else {
+        std::copy(cache.masks.begin(), cache.masks.end(), cullingMask.begin());
+    }
 
     /*
      * Shadowing: compute the shadow camera and cull shadow casters
@@ -469,22 +710,52 @@ void FView::prepare(FEngine& engine, driver::DriverApi& driver, ArenaScope& aren
      * O(3.N) instead of O(N.log(N)) application of swap().
      */
 
-    // calculate the sorting key for all elements, based on their visibility
+    // calculate the sorting key for the candidate elements, based on their visibility
     uint8_t const* layers = renderableData.data<FScene::LAYERS>();
     auto const* visibility = renderableData.data<FScene::VISIBILITY_STATE>();
-    computeVisibilityMasks(getVisibleLayers(), layers, visibility, cullingMask.begin(),
-            renderableData.size());
+    computeVisibilityMasks(getVisibleLayers(), layers + candidates.first,
+            visibility + candidates.first, cullingMask.begin() + candidates.first,
+            candidates.size());
+
+    // computeVisibilityMasks() rounds its count up for vectorization; re-clear the
+    // few masks it may have overwritten past the candidate range
+    const uint32_t roundedLast = std::min(uint32_t((candidates.last + 0xFu) & ~0xFu),
+            uint32_t(renderableData.size()));
+    std::fill(cullingMask.begin() + candidates.last, cullingMask.begin() + roundedLast, 0);
 
     auto const beginRenderables = renderableData.begin();
-    auto beginCasters = partition(beginRenderables, renderableData.end(), VISIBLE_RENDERABLE);
-    auto beginCastersOnly = partition(beginCasters, renderableData.end(), VISIBLE_ALL);
-    auto endCastersOnly = partition(beginCastersOnly, renderableData.end(), VISIBLE_SHADOW_CASTER);
+    auto const beginCandidates = beginRenderables + candidates.first;
+    auto const endCandidates = beginRenderables + candidates.last;
+    bool rowsMoved = false;
+    auto beginCasters = partition(beginCandidates, endCandidates,
+            VISIBLE_RENDERABLE, rowsMoved);
+    auto beginCastersOnly = partition(beginCasters, endCandidates,
+            VISIBLE_ALL, rowsMoved);
+    auto endCastersOnly = partition(beginCastersOnly, endCandidates,
+            VISIBLE_SHADOW_CASTER, rowsMoved);
+
+    // the partition permuted the shared SoA in place: the row-indexed captures made
+    // above (the visibility masks, the shadow-caster candidates) and the BVH's leaf
+    // order no longer match the rows, so bump the scene's order version to invalidate
+    // them. When the rows already were in partitioned order -- every frame of a steady
+    // state after the first -- nothing moves and the captures stay valid.
+    if (rowsMoved) {
+        scene->bumpRenderableOrderVersion();
+    }
 
     // convert to indices
     uint32_t iEnd = uint32_t(endCastersOnly - beginRenderables);
-    mVisibleRenderables = Range{ 0, uint32_t(beginCastersOnly - beginRenderables) };
+    mVisibleRenderables = Range{ candidates.first, uint32_t(beginCastersOnly - beginRenderables) };
     mVisibleShadowCasters = Range{ uint32_t(beginCasters - beginRenderables), iEnd };
-    Range merged = { 0, iEnd };
+    Range merged = { candidates.first, iEnd };
+
+    /*
+     * GPU occlusion queries: fold last frame's depth-pass query results into the
+     * visible renderables (this sets VISIBLE_MASK_GPU_OCCLUDED, which only cancels
+     * color commands) and set up this frame's queries.
+     */
+
+    prepareOcclusionQueries(engine, driver, renderableData);
 
     // update those UBOs
     scene->updateUBOs(merged);
@@ -544,10 +815,31 @@ UTILS_NOINLINE
 /* static */ FScene::RenderableSoa::iterator FView::partition(
         FScene::RenderableSoa::iterator begin,
         FScene::RenderableSoa::iterator end,
-        uint8_t mask) noexcept {
-    return std::partition(begin, end, [mask](auto it) {
+        uint8_t mask, bool& moved) noexcept {
+    // hand-rolled std::partition (same two-pointer algorithm) so we can report whether
+    // any row actually moved: the scene's row-order version must only be bumped when
+    // the order changed, or the captures keyed on it could never be reused
+    auto pred = [mask](auto it) {
         return it.template get<FScene::VISIBLE_MASK>() == mask;
-    });
+    };
+    while (true) {
+        while (begin != end && pred(*begin)) {
+            ++begin;
+        }
+        if (begin == end) {
+            break;
+        }
+        do {
+            --end;
+        } while (begin != end && !pred(*end));
+        if (begin == end) {
+            break;
+        }
+        std::iter_swap(begin, end);
+        moved = true;
+        ++begin;
+    }
+    return begin;
 }
 
 void FView::prepareCamera(const CameraInfo& camera, const Viewport& viewport) const noexcept {
@@ -613,45 +905,304 @@ void FView::commitFroxels(driver::DriverApi& driverApi) const noexcept {
 }
 
 UTILS_NOINLINE
-void FView::prepareVisibleRenderables(JobSystem& js,
-        FScene::RenderableSoa& renderableData) const noexcept {
+void FView::prepareVisibleRenderables(FEngine& engine, JobSystem& js,
+        FScene::RenderableSoa& renderableData, Range candidates) const noexcept {
     SYSTRACE_CALL();
     if (UTILS_LIKELY(isCullingEnabled())) {
-        cullRenderables(js, renderableData, mCullingFrustum, VISIBLE_RENDERABLE_BIT);
+        cullRenderables(engine, js, renderableData, candidates,
+                mCullingFrustum, VISIBLE_RENDERABLE_BIT);
+        cullOccludedRenderables(js, renderableData, candidates);
     } else {
-        std::fill(renderableData.begin<FScene::VISIBLE_MASK>(),
-                  renderableData.end<FScene::VISIBLE_MASK>(), VISIBLE_RENDERABLE);
+        std::fill(renderableData.begin<FScene::VISIBLE_MASK>() + candidates.first,
+                  renderableData.begin<FScene::VISIBLE_MASK>() + candidates.last,
+                  VISIBLE_RENDERABLE);
+    }
+}
+
+UTILS_NOINLINE
+float2 FView::computeVisibleDepthRange(FScene::RenderableSoa const& renderableData) const noexcept {
+    float3 const* const UTILS_RESTRICT worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
+    float3 const* const UTILS_RESTRICT worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+    uint8_t const* const UTILS_RESTRICT visibleArray   = renderableData.data<FScene::VISIBLE_MASK>();
+
+    // depth is measured along the camera's forward vector, i.e. view-space -z
+    // (the view matrix is column-major, so the z row is spread across the columns)
+    mat4f const& view = mViewingCameraInfo.view;
+    const float3 axis = -float3{ view[0].z, view[1].z, view[2].z };
+    const float originDepth = -view[3].z;
+
+    float dnear = std::numeric_limits<float>::max();
+    float dfar = std::numeric_limits<float>::lowest();
+    for (size_t i = 0, c = renderableData.size(); i < c; i++) {
+        if (visibleArray[i] & VISIBLE_RENDERABLE) {
+            const float d = dot(axis, worldAABBCenter[i]) + originDepth;
+            const float r = dot(abs(axis), worldAABBExtent[i]);
+            dnear = std::min(dnear, d - r);
+            dfar = std::max(dfar, d + r);
+        }
+    }
+
+    // clamp to the camera's depth range; an empty (or fully behind) visible set
+    // degenerates to the camera's own planes, i.e. no tightening
+    const float zn = mViewingCameraInfo.zn;
+    const float zf = mViewingCameraInfo.zf;
+    dnear = std::max(zn, dnear);
+    dfar = std::min(zf, dfar);
+    if (UTILS_UNLIKELY(!(dnear < dfar))) {
+        dnear = zn;
+        dfar = zf;
+    }
+    return { dnear, dfar };
+}
+
+void FView::cullOccludedRenderables(JobSystem& js,
+        FScene::RenderableSoa& renderableData, Range candidates) const noexcept {
+    if (!mOcclusionCullingEnabled || mOccluderIndices.empty() || candidates.empty()) {
+        return;
+    }
+    SYSTRACE_CALL();
+    mOcclusionBuffer.rasterize(js, mCullingViewProjection,
+            mOccluderVertices.data(), mOccluderIndices.data(), mOccluderIndices.size());
+    mOcclusionBuffer.cullOccluded(
+            renderableData.data<FScene::VISIBLE_MASK>() + candidates.first,
+            renderableData.data<FScene::WORLD_AABB_CENTER>() + candidates.first,
+            renderableData.data<FScene::WORLD_AABB_EXTENT>() + candidates.first,
+            candidates.size(), VISIBLE_RENDERABLE_BIT);
+}
+
+void FView::setOccluderGeometry(float3 const* vertices, size_t vertexCount,
+        uint32_t const* indices, size_t indexCount) noexcept {
+    // ignore a trailing partial triangle and any index pointing past the vertex array
+    indexCount -= indexCount % 3;
+    mOccluderVertices.assign(vertices, vertices + vertexCount);
+    mOccluderIndices.clear();
+    mOccluderIndices.reserve(indexCount);
+    for (size_t i = 0; i + 3 <= indexCount; i += 3) {
+        if (indices[i] < vertexCount && indices[i + 1] < vertexCount
+                && indices[i + 2] < vertexCount) {
+            mOccluderIndices.push_back(indices[i]);
+            mOccluderIndices.push_back(indices[i + 1]);
+            mOccluderIndices.push_back(indices[i + 2]);
+        }
+    }
+    mOccluderVersion++;
+}
+
+void FView::prepareOcclusionQueries(FEngine& engine, DriverApi& driver,
+        FScene::RenderableSoa& renderableData) noexcept {
+    OcclusionQueries& oq = mOcclusionQueries;
+    if (!mGpuOcclusionCullingEnabled) {
+        oq.recorder = {};
+        return;
+    }
+    SYSTRACE_CALL();
+
+    // renderables are keyed by their slot in the per-renderable uniform arena, which
+    // is stable across frames and is what RenderPass commands carry (perRenderableOffset)
+    const uint32_t uniformSize = uint32_t(engine.getPerRenderableUib().getSize());
+    auto const* const UTILS_RESTRICT soaUboOffset = renderableData.data<FScene::UBO_OFFSET>();
+    auto const* const UTILS_RESTRICT soaPrimitives = renderableData.data<FScene::PRIMITIVES>();
+    uint8_t* const UTILS_RESTRICT visibleArray = renderableData.data<FScene::VISIBLE_MASK>();
+
+    std::vector<uint8_t>& occluded = oq.scratch;
+    occluded.clear();
+    occluded.resize(oq.occluded.size(), 0);
+
+    Range const vr = mVisibleRenderables;
+    for (uint32_t i = vr.first; i < vr.last; ++i) {
+        // only single-primitive renderables are tested: a query brackets exactly one
+        // depth-pass draw, and query objects can't be begun twice within a pass
+        if (soaPrimitives[i].size() != 1) {
+            continue;
+        }
+        const uint32_t slot = soaUboOffset[i] / uniformSize;
+        if (slot >= oq.handles.size()) {
+            oq.handles.resize(slot + 1);
+        }
+        if (slot >= occluded.size()) {
+            occluded.resize(slot + 1, 0);
+        }
+        Handle<HwOcclusionQuery>& query = oq.handles[slot];
+        if (!query) {
+            query = driver.createOcclusionQuery();
+        }
+        // non-blocking: false until the backend has collected a result, in which case
+        // the renderable conservatively stays visible
+        bool visible = true;
+        if (driver.getOcclusionQueryResult(query, &visible) && !visible) {
+            visibleArray[i] |= FScene::VISIBLE_MASK_GPU_OCCLUDED;
+            occluded[slot] = 1;
+        }
+    }
+
+    // the cancelled color commands are baked into the generated (and possibly
+    // retained, see CommandCache) command buffer: invalidate it when results change
+    if (occluded != oq.occluded) {
+        oq.occluded.swap(occluded);
+        oq.resultsVersion++;
     }
+
+    oq.recorder.queries = oq.handles.data();
+    oq.recorder.slotSize = uniformSize;
+    oq.recorder.count = uint32_t(oq.handles.size());
 }
 
 UTILS_NOINLINE
-void FView::prepareVisibleShadowCasters(JobSystem& js,
+void FView::prepareVisibleShadowCasters(FEngine& engine, JobSystem& js,
         FScene::RenderableSoa& renderableData, Frustum const& lightFrustum) const noexcept {
     SYSTRACE_CALL();
-    cullRenderables(js, renderableData, lightFrustum, VISIBLE_SHADOW_CASTER_BIT);
+
+    FScene const* const scene = mScene;
+    ShadowCasterCache& cache = mShadowCasterCache;
+    float4 const* const UTILS_RESTRICT planes = lightFrustum.getNormalizedPlanes();
+    const uint32_t transformEpoch = engine.getTransformManager().getEpoch();
+    const uint32_t renderableEpoch = engine.getRenderableManager().getEpoch();
+    const uint32_t sceneVersion = scene->getVersion();
+    const uint32_t orderVersion = scene->getRenderableOrderVersion();
+
+    bool cacheHit = cache.valid
+            && cache.scene == scene
+            && cache.sceneVersion == sceneVersion
+            && cache.transformEpoch == transformEpoch
+            && cache.renderableEpoch == renderableEpoch
+            && cache.orderVersion == orderVersion
+            && cache.count == renderableData.size();
+    if (cacheHit) {
+        // the capture is usable only while each plane has drifted by less than the
+        // margin over the scene's bounding sphere; past that, a caster inside the
+        // exact frustum could be missing from the candidate set
+        for (size_t j = 0; j < 6; j++) {
+            const float4 d = planes[j] - cache.planes[j];
+            if (length(d.xyz) * cache.radius + std::abs(d.w) > cache.margin) {
+                cacheHit = false;
+                break;
+            }
+        }
+    }
+
+    float3 const* const UTILS_RESTRICT center = renderableData.data<FScene::WORLD_AABB_CENTER>();
+    float3 const* const UTILS_RESTRICT extent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+    auto const* const UTILS_RESTRICT visibility = renderableData.data<FScene::VISIBILITY_STATE>();
+
+    if (UTILS_LIKELY(cacheHit)) {
+        // only re-test the captured candidates against the exact frustum
+        FRenderableManager const& rcm = engine.getRenderableManager();
+        uint8_t* const UTILS_RESTRICT visibleArray = renderableData.data<FScene::VISIBLE_MASK>();
+        auto const* const UTILS_RESTRICT instances = renderableData.data<FScene::RENDERABLE_INSTANCE>();
+        auto const* const UTILS_RESTRICT worldTransform = renderableData.data<FScene::WORLD_TRANSFORM>();
+        for (uint32_t const i : cache.candidates) {
+            if (lightFrustum.intersects(Box{ center[i], extent[i] })) {
+                // same refine pass as cullRenderables() for oriented bounds
+                if (UTILS_UNLIKELY(visibility[i].orientedBounds)
+                        && !Culler::intersectsOriented(lightFrustum,
+                                rcm.getAxisAlignedBoundingBox(instances[i]), worldTransform[i])) {
+                    continue;
+                }
+                visibleArray[i] |= VISIBLE_SHADOW_CASTER;
+            }
+        }
+        return;
+    }
+
+    cullRenderables(engine, js, renderableData,
+            { 0, uint32_t(renderableData.size()) }, lightFrustum, VISIBLE_SHADOW_CASTER_BIT);
+
+    // (re)capture the potential-caster set: casters whose bounds pass the plane test
+    // with 'margin' of slack, i.e. the frustum expanded outward by the margin
+    const size_t count = renderableData.size();
+    float radius = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        radius = std::max(radius, length(center[i]) + length(extent[i]));
+    }
+    const float margin = std::max(radius * SHADOW_CASTER_CACHE_MARGIN, 1e-3f);
+    auto& candidates = cache.candidates;
+    candidates.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (!visibility[i].castShadows) {
+            continue;
+        }
+        bool inside = true;
+        for (size_t j = 0; j < 6; j++) {
+            const float dot =
+                    planes[j].x * center[i].x - std::abs(planes[j].x) * extent[i].x +
+                    planes[j].y * center[i].y - std::abs(planes[j].y) * extent[i].y +
+                    planes[j].z * center[i].z - std::abs(planes[j].z) * extent[i].z +
+                    planes[j].w;
+            if (dot >= margin) {
+                inside = false;
+                break;
+            }
+        }
+        if (inside) {
+            candidates.push_back(uint32_t(i));
+        }
+    }
+    std::copy_n(planes, 6, cache.planes);
+    cache.scene = scene;
+    cache.sceneVersion = sceneVersion;
+    cache.transformEpoch = transformEpoch;
+    cache.renderableEpoch = renderableEpoch;
+    cache.orderVersion = orderVersion;
+    cache.count = uint32_t(count);
+    cache.radius = radius;
+    cache.margin = margin;
+    cache.valid = true;
 }
 
-void FView::cullRenderables(JobSystem& js,
-        FScene::RenderableSoa& renderableData, Frustum const& frustum, size_t bit) noexcept {
+void FView::cullRenderables(FEngine& engine, JobSystem& js,
+        FScene::RenderableSoa& renderableData, Range candidates,
+        Frustum const& frustum, size_t bit) const noexcept {
+
+    if (UTILS_UNLIKELY(candidates.empty())) {
+        return;
+    }
 
     float3 const* worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
     float3 const* worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
     uint8_t     * visibleArray    = renderableData.data<FScene::VISIBLE_MASK>();
 
-    // culling job (this runs on multiple threads)
-    auto functor = [&frustum, worldAABBCenter, worldAABBExtent, visibleArray, bit]
-            (uint32_t index, uint32_t c) {
-        Culler::intersects(
-                visibleArray + index,
-                frustum,
-                worldAABBCenter + index,
-                worldAABBExtent + index, c, bit);
-    };
+    // large scenes carry a BVH over the renderable bounds (see RenderableBvh),
+    // which rejects whole subtrees instead of testing every object; it covers the
+    // whole scene, so it only applies when the candidate range does too -- a
+    // restricted range is small and well served by the flat vectorized path
+    RenderableBvh& bvh = mScene->getRenderableBvh();
+    if (UTILS_UNLIKELY(!bvh.empty() && bvh.size() == renderableData.size()
+            && candidates.size() == renderableData.size())) {
+        bvh.cull(frustum, visibleArray, bit);
+    } else {
+        // culling job (this runs on multiple threads)
+        auto functor = [&frustum, worldAABBCenter, worldAABBExtent, visibleArray, bit]
+                (uint32_t index, uint32_t c) {
+            Culler::intersects(
+                    visibleArray + index,
+                    frustum,
+                    worldAABBCenter + index,
+                    worldAABBExtent + index, c, bit);
+        };
+
+        // launch the computation on multiple threads. Culling workloads are skewed (scenes of
+        // very different sizes), so let the splitter adapt instead of using a static count.
+        auto job = jobs::parallel_for(js, nullptr, candidates.first, (uint32_t)candidates.size(),
+                std::ref(functor),
+                jobs::AdaptiveSplitter<Culler::MODULO * Culler::MIN_LOOP_COUNT_HINT, 8>());
+        js.runAndWait(job);
+    }
 
-    // launch the computation on multiple threads
-    auto job = jobs::parallel_for(js, nullptr, 0, (uint32_t)renderableData.size(),
-            std::ref(functor), jobs::CountSplitter<Culler::MODULO * Culler::MIN_LOOP_COUNT_HINT, 8>());
-    js.runAndWait(job);
+    // Refine pass for renderables that opted into oriented bounds: the world-space AABB
+    // tested above is grossly conservative for long thin meshes under rotation, so survivors
+    // are re-tested exactly against their model-space box oriented by their transform.
+    FRenderableManager const& rcm = engine.getRenderableManager();
+    auto const* UTILS_RESTRICT visibility     = renderableData.data<FScene::VISIBILITY_STATE>();
+    auto const* UTILS_RESTRICT instances      = renderableData.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* UTILS_RESTRICT worldTransform = renderableData.data<FScene::WORLD_TRANSFORM>();
+    for (size_t i = candidates.first, c = candidates.last; i < c; i++) {
+        if ((visibleArray[i] & uint8_t(1u << bit)) && UTILS_UNLIKELY(visibility[i].orientedBounds)) {
+            if (!Culler::intersectsOriented(frustum,
+                    rcm.getAxisAlignedBoundingBox(instances[i]), worldTransform[i])) {
+                visibleArray[i] &= ~uint8_t(1u << bit);
+            }
+        }
+    }
 }
 
 void FView::prepareVisibleLights(FLightManager& lcm, utils::JobSystem&, FScene::LightSoa& lightData) const {
@@ -711,12 +1262,23 @@ void FView::prepareVisibleLights(FLightManager& lcm, utils::JobSystem&, FScene::
     mHasDynamicLighting = visibleLightCount > FScene::DIRECTIONAL_LIGHTS_COUNT;
 }
 
-void FView::updatePrimitivesLod(FEngine& engine, const CameraInfo&,
+void FView::updatePrimitivesLod(FEngine& engine, const CameraInfo& camera,
         FScene::RenderableSoa& renderableData, Range visibles) noexcept {
     FRenderableManager const& rcm = engine.getRenderableManager();
+    const float3 position = camera.getPosition();
+    // projection[1][1] == cot(fovy / 2); (r * cot(fovy/2)) / d is the fraction of the
+    // viewport height covered by a bounding sphere of radius r at distance d
+    const float cotHalfFov = camera.projection[1][1];
     for (uint32_t index : visibles) {
-        uint8_t level = 0; // TODO: pick the proper level of detail
         auto ri = renderableData.elementAt<FScene::RENDERABLE_INSTANCE>(index);
+        uint8_t level = 0;
+        if (UTILS_UNLIKELY(rcm.getLevelCount(ri) > 1)) {
+            const float3 center = renderableData.elementAt<FScene::WORLD_AABB_CENTER>(index);
+            const float3 extent = renderableData.elementAt<FScene::WORLD_AABB_EXTENT>(index);
+            const float d = std::max(camera.zn, length(center - position));
+            const float screenSize = (length(extent) * cotHalfFov) / d;
+            level = rcm.selectLod(ri, screenSize);
+        }
         renderableData.elementAt<FScene::PRIMITIVES>(index) = rcm.getRenderPrimitives(ri, level);
     }
 }
@@ -776,6 +1338,27 @@ bool View::isCullingEnabled() const noexcept {
     return upcast(this)->isCullingEnabled();
 }
 
+void View::setOccluderGeometry(math::float3 const* vertices, size_t vertexCount,
+        uint32_t const* indices, size_t indexCount) noexcept {
+    upcast(this)->setOccluderGeometry(vertices, vertexCount, indices, indexCount);
+}
+
+void View::setOcclusionCullingEnabled(bool enabled) noexcept {
+    upcast(this)->setOcclusionCullingEnabled(enabled);
+}
+
+bool View::isOcclusionCullingEnabled() const noexcept {
+    return upcast(this)->isOcclusionCullingEnabled();
+}
+
+void View::setGpuOcclusionCullingEnabled(bool enabled) noexcept {
+    upcast(this)->setGpuOcclusionCullingEnabled(enabled);
+}
+
+bool View::isGpuOcclusionCullingEnabled() const noexcept {
+    return upcast(this)->isGpuOcclusionCullingEnabled();
+}
+
 void View::setDebugCamera(Camera* camera) noexcept {
     upcast(this)->setViewingCamera(upcast(camera));
 }
@@ -800,6 +1383,10 @@ void View::setShadowsEnabled(bool enabled) noexcept {
     upcast(this)->setShadowsEnabled(enabled);
 }
 
+void View::setSoftShadowsEnabled(bool enabled) noexcept {
+    upcast(this)->setSoftShadowsEnabled(enabled);
+}
+
 void View::setRenderTarget(TargetBufferFlags discard) noexcept {
     upcast(this)->setRenderTarget(discard);
 }
@@ -832,10 +1419,34 @@ void View::setPostProcessingEnabled(bool enabled) noexcept {
     upcast(this)->setPostProcessingEnabled(enabled);
 }
 
+void View::setRenderQuality(RenderQuality const& renderQuality) noexcept {
+    upcast(this)->setRenderQuality(renderQuality);
+}
+
+View::RenderQuality View::getRenderQuality() const noexcept {
+    return upcast(this)->getRenderQuality();
+}
+
 bool View::isPostProcessingEnabled() const noexcept {
     return upcast(this)->hasPostProcessPass();
 }
 
+void View::setHalfResolutionTransparencyEnabled(bool enabled) noexcept {
+    upcast(this)->setHalfResolutionTransparencyEnabled(enabled);
+}
+
+bool View::isHalfResolutionTransparencyEnabled() const noexcept {
+    return upcast(this)->isHalfResolutionTransparencyEnabled();
+}
+
+void View::setCachingEnabled(bool enabled) noexcept {
+    upcast(this)->setCachingEnabled(enabled);
+}
+
+bool View::isCachingEnabled() const noexcept {
+    return upcast(this)->isCachingEnabled();
+}
+
 void View::setDepthPrepass(View::DepthPrepass prepass) noexcept {
     upcast(this)->setDepthPrepass(prepass);
 }
@@ -844,5 +1455,9 @@ void View::setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept
     upcast(this)->setDynamicLightingOptions(zLightNear, zLightFar);
 }
 
+void View::setFroxelDepthDistribution(float power) noexcept {
+    upcast(this)->setFroxelDepthDistribution(power);
+}
+
 
 } // namespace filament
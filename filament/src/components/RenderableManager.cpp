@@ -24,6 +24,8 @@
 #include "details/Material.h"
 #include "details/RenderPrimitive.h"
 
+#include "driver/UniformBufferBatch.h"
+
 #include <utils/Log.h>
 #include <utils/Panic.h>
 
@@ -41,15 +43,23 @@ struct RenderableManager::BuilderDetails {
     Box mAABB;
     uint8_t mLayerMask = 0x1;
     uint8_t mPriority = 0x4;
+    uint8_t mSortGroup = 0x0;
     bool mCulling : 1;
     bool mCastShadows : 1;
     bool mReceiveShadows : 1;
+    bool mOrientedBounds : 1;
     uint8_t mSkinningBoneCount = 0;
     Bone const* mBones = nullptr;
     math::mat4f const* mBoneMatrices = nullptr;
 
+    // levels of detail; slot 0 is unused (the base geometry is in mEntries)
+    Entry* mLodEntries[RenderableManager::MAX_LOD_COUNT] = {};
+    float mLodScreenSize[RenderableManager::MAX_LOD_COUNT] = {};
+    uint8_t mLodCount = 1;
+
     explicit BuilderDetails(size_t count)
-            : mEntriesCount(count), mCulling(true), mCastShadows(false), mReceiveShadows(true) {
+            : mEntriesCount(count), mCulling(true), mCastShadows(false), mReceiveShadows(true),
+              mOrientedBounds(false) {
     }
     // this is only needed for the explicit instantiation below
     BuilderDetails() = default;
@@ -62,6 +72,9 @@ BuilderType::Builder::Builder(size_t count) noexcept
 }
 BuilderType::Builder::~Builder() noexcept {
     delete [] mImpl->mEntries;
+    for (Entry* entries : mImpl->mLodEntries) {
+        delete [] entries;
+    }
 }
 BuilderType::Builder::Builder(BuilderType::Builder&& rhs) noexcept = default;
 BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs) noexcept = default;
@@ -118,11 +131,21 @@ RenderableManager::Builder& RenderableManager::Builder::priority(uint8_t priorit
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::sortGroup(uint8_t group) noexcept {
+    mImpl->mSortGroup = group;
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::culling(bool enable) noexcept {
     mImpl->mCulling = enable;
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::orientedBounds(bool enable) noexcept {
+    mImpl->mOrientedBounds = enable;
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::castShadows(bool enable) noexcept {
     mImpl->mCastShadows = enable;
     return *this;
@@ -152,6 +175,34 @@ RenderableManager::Builder& RenderableManager::Builder::skinning(
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::lod(uint8_t level, float minScreenSize) noexcept {
+    if (level >= 1 && level < MAX_LOD_COUNT) {
+        if (!mImpl->mLodEntries[level]) {
+            mImpl->mLodEntries[level] = new Entry[mImpl->mEntriesCount];
+        }
+        mImpl->mLodScreenSize[level] = minScreenSize;
+        mImpl->mLodCount = std::max(mImpl->mLodCount, uint8_t(level + 1));
+    }
+    return *this;
+}
+
+RenderableManager::Builder& RenderableManager::Builder::lodGeometry(uint8_t level, size_t index,
+        PrimitiveType type, VertexBuffer* vertices, IndexBuffer* indices,
+        size_t offset, size_t count) noexcept {
+    if (level >= 1 && level < MAX_LOD_COUNT && index < mImpl->mEntriesCount
+            && mImpl->mLodEntries[level]) {
+        Entry& entry = mImpl->mLodEntries[level][index];
+        entry.vertices = vertices;
+        entry.indices = indices;
+        entry.offset = offset;
+        entry.minIndex = 0;
+        entry.maxIndex = vertices ? vertices->getVertexCount() - 1 : 0;
+        entry.count = count;
+        entry.type = type;
+    }
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::blendOrder(size_t index, uint16_t blendOrder) noexcept {
     if (index < mImpl->mEntriesCount) {
         mImpl->mEntries[index].blendOrder = blendOrder;
@@ -159,6 +210,15 @@ RenderableManager::Builder& RenderableManager::Builder::blendOrder(size_t index,
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::bounds(size_t index,
+        const Box& aabb, math::float4 const& normalCone) noexcept {
+    if (index < mImpl->mEntriesCount) {
+        mImpl->mEntries[index].aabb = aabb;
+        mImpl->mEntries[index].normalCone = normalCone;
+    }
+    return *this;
+}
+
 RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& engine, Entity entity) {
     bool isEmpty = true;
     for (size_t i = 0, c = mImpl->mEntriesCount; i < c; i++) {
@@ -212,6 +272,35 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
         isEmpty = false;
     }
 
+    // LOD levels must be declared contiguously; they inherit the base geometry's
+    // materials, blend orders and per-primitive bounds
+    for (uint8_t level = 1; level < mImpl->mLodCount; level++) {
+        if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->mLodEntries[level],
+                "[entity=%u] %u LOD levels declared, but level %u is missing",
+                entity.getId(), mImpl->mLodCount, level)) {
+            return Error;
+        }
+        for (size_t i = 0, c = mImpl->mEntriesCount; i < c; i++) {
+            auto& entry = mImpl->mLodEntries[level][i];
+            entry.materialInstance = mImpl->mEntries[i].materialInstance;
+            entry.blendOrder = mImpl->mEntries[i].blendOrder;
+            // LOD geometry covers the same spatial region as the base primitive
+            entry.aabb = mImpl->mEntries[i].aabb;
+            entry.normalCone = mImpl->mEntries[i].normalCone;
+            if (!entry.indices || !entry.vertices) {
+                continue;
+            }
+            if (!ASSERT_PRECONDITION_NON_FATAL(
+                    entry.offset + entry.count <= entry.indices->getIndexCount(),
+                    "[entity=%u, lod %u, primitive @ %u] offset (%u) + count (%u) > indexCount (%u)",
+                    entity.getId(), level, i,
+                    entry.offset, entry.count, entry.indices->getIndexCount())) {
+                entry.vertices = nullptr;
+                return Error;
+            }
+        }
+    }
+
     if (!ASSERT_POSTCONDITION_NON_FATAL(
             !mImpl->mAABB.isEmpty() ||
             (!mImpl->mCulling && (!(mImpl->mReceiveShadows || mImpl->mCastShadows)) ||
@@ -241,6 +330,107 @@ FRenderableManager::~FRenderableManager() {
     assert(mManager.getComponentCount() == 0);
 }
 
+// ------------------------------------------------------------------------------------------------
+
+static_assert(sizeof(FRenderPrimitive) >= sizeof(void*),
+        "FRenderPrimitive too small to hold a free-list link");
+
+FRenderableManager::PrimitivePool::~PrimitivePool() noexcept {
+    // all primitives have been destroyed by now, we just release the storage
+    for (void* slab : mSlabs) {
+        ::free(slab);
+    }
+}
+
+size_t FRenderableManager::PrimitivePool::binOf(size_t count) noexcept {
+    assert(count >= 1 && count <= (size_t(1) << (BIN_COUNT - 1)));
+    size_t bin = 0;
+    while ((size_t(1) << bin) < count) {
+        bin++;
+    }
+    return bin;
+}
+
+FRenderPrimitive* FRenderableManager::PrimitivePool::alloc(size_t count) noexcept {
+    if (count == 0) {
+        return nullptr;
+    }
+    if (UTILS_UNLIKELY(count > (size_t(1) << (BIN_COUNT - 1)))) {
+        // rare: unusually large arrays go to the heap directly
+        return new FRenderPrimitive[count];
+    }
+    size_t const bin = binOf(count);
+    void* p = mBins[bin];
+    if (p) {
+        mBins[bin] = static_cast<Range*>(p)->next;
+    } else {
+        size_t const bytes = (size_t(1) << bin) * sizeof(FRenderPrimitive);
+        if (UTILS_UNLIKELY(mCurrent + bytes > mEnd)) {
+            // the tail of the current slab (at most 15 slots) is sacrificed
+            char* const slab = (char*)malloc(SLAB_PRIMITIVE_COUNT * sizeof(FRenderPrimitive));
+            mSlabs.push_back(slab);
+            mCurrent = slab;
+            mEnd = slab + SLAB_PRIMITIVE_COUNT * sizeof(FRenderPrimitive);
+        }
+        p = mCurrent;
+        mCurrent += bytes;
+    }
+    FRenderPrimitive* const rp = static_cast<FRenderPrimitive*>(p);
+    for (size_t i = 0; i < count; ++i) {
+        new(rp + i) FRenderPrimitive;
+    }
+    return rp;
+}
+
+void FRenderableManager::PrimitivePool::free(FRenderPrimitive* p, size_t count) noexcept {
+    if (!p) {
+        return;
+    }
+    if (UTILS_UNLIKELY(count > (size_t(1) << (BIN_COUNT - 1)))) {
+        delete[] p;
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        p[i].~FRenderPrimitive();
+    }
+    Range* const r = reinterpret_cast<Range*>(p);
+    r->next = mBins[binOf(count)];
+    mBins[binOf(count)] = r;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+uint32_t FRenderableManager::allocateUniformSlot() noexcept {
+    if (UTILS_UNLIKELY(!mUniformSlotStride)) {
+        mUniformSlotStride =
+                (uint32_t(mEngine.getPerRenderableUib().getSize()) + UNIFORM_ARENA_ALIGNMENT - 1)
+                        & ~(UNIFORM_ARENA_ALIGNMENT - 1);
+    }
+    if (!mUniformSlotFreeList.empty()) {
+        const uint32_t slot = mUniformSlotFreeList.back();
+        mUniformSlotFreeList.pop_back();
+        return slot * mUniformSlotStride;
+    }
+    if (UTILS_UNLIKELY(mUniformSlotCount == mUniformArenaCapacity)) {
+        // grow the arena. The old buffer's content is not copied over; instead every
+        // live block is invalidated and re-uploaded by the next prepare() that sees it
+        // (i.e. when its renderable becomes visible again).
+        FEngine::DriverApi& driver = mEngine.getDriverApi();
+        mUniformArenaCapacity = std::max(UNIFORM_ARENA_INITIAL_SLOTS, mUniformArenaCapacity * 2);
+        if (mUniformArena) {
+            driver.destroyUniformBuffer(mUniformArena);
+        }
+        mUniformArena = driver.createUniformBuffer(mUniformArenaCapacity * mUniformSlotStride);
+        for (size_t i = 1, c = mManager.getComponentCount(); i <= c; i++) {
+            UniformBuffer& ub = getUniformBuffer(Instance(Instance::Type(i)));
+            if (ub.getSize()) {
+                ub.invalidateUniforms(0, ub.getSize());
+            }
+        }
+    }
+    return mUniformSlotCount++ * mUniformSlotStride;
+}
+
 void FRenderableManager::create(
         const RenderableManager::Builder& UTILS_RESTRICT builder, Entity entity) {
     FEngine& engine = mEngine;
@@ -248,16 +438,18 @@ void FRenderableManager::create(
     FEngine::DriverApi& driver = engine.getDriverApi();
 
     // If we already have an instance we can reuse parts of it without completely
-    // destroying it. In particular we can reuse the UBO since it's the same for
-    // all renderables
+    // destroying it. In particular we can reuse its slot in the uniform arena since
+    // the per-renderable block is the same for all renderables
     bool canReuse = false;
     Instance ci = getInstance(entity);
     if (UTILS_UNLIKELY(ci)) {
         canReuse = true;
         destroyComponentPrimitives(engine, manager[ci].primitives);
-        std::unique_ptr<Bones> const& bones = manager[ci].bones;
+        destroyComponentLods(engine, manager[ci].lods);
+        std::unique_ptr<Bones>& bones = manager[ci].bones;
         if (bones && !builder->mSkinningBoneCount) {
             driver.destroyUniformBuffer(bones->handle);
+            bones.reset();
         }
     }
 
@@ -268,34 +460,58 @@ void FRenderableManager::create(
         // create and initialize all needed RenderPrimitives
         using size_type = Slice<FRenderPrimitive>::size_type;
         Builder::Entry const * const entries = builder->mEntries;
-        FRenderPrimitive* rp = new FRenderPrimitive[builder->mEntriesCount];
+        FRenderPrimitive* rp = mPrimitivePool.alloc(builder->mEntriesCount);
         for (size_t i = 0, c = builder->mEntriesCount; i < c; ++i) {
             rp[i].init(driver, entries[i]);
         }
-        setPrimitives(ci, { rp, size_type(builder->mEntriesCount) });
+        const Slice<FRenderPrimitive> base{ rp, size_type(builder->mEntriesCount) };
+        setPrimitives(ci, base);
+
+        // create the coarser LOD levels, if any
+        if (UTILS_UNLIKELY(builder->mLodCount > 1)) {
+            std::unique_ptr<LodGroup>& lods = manager[ci].lods;
+            lods.reset(new LodGroup);
+            lods->count = builder->mLodCount;
+            lods->levels[0] = base;
+            for (uint8_t level = 1; level < builder->mLodCount; level++) {
+                Builder::Entry const* const lodEntries = builder->mLodEntries[level];
+                FRenderPrimitive* const lrp = mPrimitivePool.alloc(builder->mEntriesCount);
+                for (size_t i = 0, c = builder->mEntriesCount; i < c; ++i) {
+                    lrp[i].init(driver, lodEntries[i]);
+                }
+                lods->levels[level] = { lrp, size_type(builder->mEntriesCount) };
+                lods->screenSize[level] = builder->mLodScreenSize[level];
+            }
+        }
 
         setAxisAlignedBoundingBox(ci, builder->mAABB);
         setLayerMask(ci, builder->mLayerMask);
         setPriority(ci, builder->mPriority);
+        setSortGroup(ci, builder->mSortGroup);
         setCastShadows(ci, builder->mCastShadows);
         setReceiveShadows(ci, builder->mReceiveShadows);
         setCulling(ci, builder->mCulling);
+        setOrientedBounds(ci, builder->mOrientedBounds);
         static_cast<Visibility&>(manager[ci].visibility).skinning = builder->mSkinningBoneCount > 0;
 
         if (!canReuse) {
             getUniformBuffer(ci) = UniformBuffer(engine.getPerRenderableUib());
-            setUniformHandle(ci, driver.createUniformBuffer(getUniformBuffer(ci).getSize()));
-            if (builder->mSkinningBoneCount) {
-                std::unique_ptr<Bones>& bones = manager[ci].bones;
-
+            setUniformOffset(ci, allocateUniformSlot());
+        }
+        // the dequantization transform must be the identity, not zero, by default
+        setQuantizedPositionTransform(ci, math::float3{ 1.0f }, math::float3{ 0.0f });
+        if (builder->mSkinningBoneCount) {
+            std::unique_ptr<Bones>& bones = manager[ci].bones;
+            if (!bones) {
                 bones.reset(new Bones); // FIXME: maybe use a pool allocator
-                bones->bones = UniformBuffer(CONFIG_MAX_BONE_COUNT * sizeof(Bone));
+                // the GPU-side buffer must match the size of the uniform block declared in
+                // the shader, but the CPU-side copy -- and therefore the per-frame upload --
+                // only needs to cover the bones actually used
                 bones->handle = driver.createUniformBuffer(CONFIG_MAX_BONE_COUNT * sizeof(Bone));
             }
-        }
-        if (builder->mSkinningBoneCount) {
-            std::unique_ptr<Bones> const& bones = manager[ci].bones;
-            assert(bones);
+            if (bones->bones.getSize() != builder->mSkinningBoneCount * sizeof(Bone)) {
+                bones->bones = UniformBuffer(builder->mSkinningBoneCount * sizeof(Bone));
+            }
             bones->count = builder->mSkinningBoneCount;
             if (builder->mBones) {
                 setBones(ci, builder->mBones, builder->mSkinningBoneCount);
@@ -334,6 +550,10 @@ void FRenderableManager::terminate() noexcept {
             manager.removeComponent(manager.getEntity(ci));
         }
     }
+    if (mUniformArena) {
+        mEngine.getDriverApi().destroyUniformBuffer(mUniformArena);
+        mUniformArena = {};
+    }
 }
 
 // This is basically a Renderable's destructor.
@@ -341,11 +561,15 @@ void FRenderableManager::destroyComponent(Instance ci) noexcept {
     auto& manager = mManager;
     FEngine& engine = mEngine;
 
+    mEpoch++;
+
     FEngine::DriverApi& driver = engine.getDriverApi();
-    driver.destroyUniformBuffer(manager[ci].uniformsHandle);
+    // the component's slot in the uniform arena goes back to the free list
+    mUniformSlotFreeList.push_back(manager[ci].uniformOffset / mUniformSlotStride);
 
     // See create(RenderableManager::Builder&, Entity)
     destroyComponentPrimitives(engine, manager[ci].primitives);
+    destroyComponentLods(engine, manager[ci].lods);
 
     // destroy the bones structures if any
     std::unique_ptr<Bones> const& bones = manager[ci].bones;
@@ -359,7 +583,19 @@ void FRenderableManager::destroyComponentPrimitives(
     for (auto& primitive : primitives) {
         primitive.terminate(engine);
     }
-    delete[] primitives.data();
+    mPrimitivePool.free(primitives.data(), primitives.size());
+}
+
+void FRenderableManager::destroyComponentLods(
+        FEngine& engine, std::unique_ptr<LodGroup>& lods) noexcept {
+    if (UTILS_UNLIKELY(lods)) {
+        // level 0 aliases the component's main primitive array, which is destroyed by
+        // destroyComponentPrimitives()
+        for (size_t level = 1; level < lods->count; level++) {
+            destroyComponentPrimitives(engine, lods->levels[level]);
+        }
+        lods.reset();
+    }
 }
 
 
@@ -369,23 +605,60 @@ void FRenderableManager::prepare(
         utils::Range<uint32_t> list) const noexcept {
     auto& manager = mManager;
     UniformBuffer           const * const UTILS_RESTRICT uniforms = manager.raw_array<UNIFORMS>();
-    Handle<HwUniformBuffer> const * const UTILS_RESTRICT ubhs     = manager.raw_array<UNIFORMS_HANDLE>();
+    uint32_t                const * const UTILS_RESTRICT offsets  = manager.raw_array<UNIFORM_OFFSET>();
     std::unique_ptr<Bones>  const * const UTILS_RESTRICT bones    = manager.raw_array<BONES>();
+
+    // first pass: figure out how much staging memory the dirty uniform blocks need
+    UniformBufferBatch batch;
     for (uint32_t index : list) {
         size_t i = instances[index].asValue();
         assert(i);  // we should never get the null instance here
         if (uniforms[i].isDirty()) {
-            // update per-renderable uniform buffer
-            driver.updateUniformBuffer(ubhs[i], UniformBuffer(uniforms[i]));
-            uniforms[i].clean(); // clean AFTER we send to the driver
-        }
-        if (UTILS_UNLIKELY(bones[i])) {
-            if (bones[i]->bones.isDirty()) {
-                driver.updateUniformBuffer(bones[i]->handle, UniformBuffer(bones[i]->bones));
-                bones[i]->bones.clean();
-            }
+            batch.reserve(uniforms[i]);
+        }
+        if (UTILS_UNLIKELY(bones[i] && bones[i]->bones.isDirty())) {
+            batch.reserve(bones[i]->bones);
         }
     }
+
+    if (!batch.count()) {
+        return;
+    }
+
+    // second pass: pack them all into a single update command
+    batch.begin();
+    for (uint32_t index : list) {
+        size_t i = instances[index].asValue();
+        if (uniforms[i].isDirty()) {
+            batch.append(mUniformArena, uniforms[i], offsets[i]);
+            uniforms[i].clean(); // clean AFTER we copied into the staging buffer
+        }
+        if (UTILS_UNLIKELY(bones[i] && bones[i]->bones.isDirty())) {
+            batch.append(bones[i]->handle, bones[i]->bones);
+            bones[i]->bones.clean();
+        }
+    }
+    batch.commit(driver);
+}
+
+void FRenderableManager::setMorphWeights(Instance instance, math::float4 const& weights) noexcept {
+    if (instance) {
+        // the weights end-up in the per-renderable UBO, whose upload is already batched,
+        // so a morphed renderable uploads 16 bytes per frame instead of new vertex data
+        getUniformBuffer(instance).setUniform(
+                offsetof(FEngine::PerRenderableUib, morphWeights), weights);
+    }
+}
+
+void FRenderableManager::setQuantizedPositionTransform(Instance instance,
+        math::float3 const& scale, math::float3 const& offset) noexcept {
+    if (instance) {
+        auto& uniforms = getUniformBuffer(instance);
+        uniforms.setUniform(offsetof(FEngine::PerRenderableUib, posUnpackScale),
+                math::float4{ scale, 0.0f });
+        uniforms.setUniform(offsetof(FEngine::PerRenderableUib, posUnpackOffset),
+                math::float4{ offset, 0.0f });
+    }
 }
 
 void FRenderableManager::updateLocalUBO(Instance instance, const math::mat4f& model) noexcept {
@@ -408,6 +681,7 @@ void FRenderableManager::updateLocalUBO(Instance instance, const math::mat4f& mo
 void FRenderableManager::setMaterialInstanceAt(Instance instance, uint8_t level,
         size_t primitiveIndex, FMaterialInstance const* mi) noexcept {
     if (instance) {
+        mEpoch++;
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].setMaterialInstance(upcast(mi));
@@ -440,6 +714,7 @@ MaterialInstance* FRenderableManager::getMaterialInstanceAt(
 void FRenderableManager::setBlendOrderAt(Instance instance, uint8_t level,
         size_t primitiveIndex, uint16_t order) noexcept {
     if (instance) {
+        mEpoch++;
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].setBlendOrder(order);
@@ -462,6 +737,7 @@ void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t
         PrimitiveType type, FVertexBuffer* vertices, FIndexBuffer* indices,
         size_t offset, size_t count) noexcept {
     if (instance) {
+        mEpoch++;
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].set(mEngine, type, vertices, indices, offset,
@@ -470,9 +746,23 @@ void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t
     }
 }
 
+void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t primitiveIndex,
+        PrimitiveType type, FVertexBuffer* vertices, FIndexBuffer* indices,
+        size_t offset, size_t minIndex, size_t maxIndex, size_t count) noexcept {
+    if (instance) {
+        mEpoch++;
+        Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
+        if (primitiveIndex < primitives.size()) {
+            primitives[primitiveIndex].set(mEngine, type, vertices, indices, offset,
+                    minIndex, maxIndex, count);
+        }
+    }
+}
+
 void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t primitiveIndex,
         PrimitiveType type, size_t offset, size_t count) noexcept {
     if (instance) {
+        mEpoch++;
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].set(mEngine, type, offset, 0, 0, count);
@@ -480,6 +770,37 @@ void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t
     }
 }
 
+void FRenderableManager::setSkinning(Instance instance, size_t boneCount) noexcept {
+    if (instance) {
+        mEpoch++;
+        boneCount = std::min(size_t(255), boneCount);
+        std::unique_ptr<Bones>& bones = mManager[instance].bones;
+        if (!boneCount) {
+            if (bones) {
+                mEngine.getDriverApi().destroyUniformBuffer(bones->handle);
+                bones.reset();
+            }
+        } else {
+            // see create(): the GPU-side buffer is sized for the shader's uniform block,
+            // the CPU-side copy only covers the bones actually used
+            if (!bones) {
+                bones.reset(new Bones);
+                bones->handle = mEngine.getDriverApi().createUniformBuffer(
+                        CONFIG_MAX_BONE_COUNT * sizeof(Bone));
+            }
+            if (bones->bones.getSize() != boneCount * sizeof(Bone)) {
+                bones->bones = UniformBuffer(boneCount * sizeof(Bone));
+                // the resized block is fully re-uploaded, so initialize it to identity
+                Bone* UTILS_RESTRICT out =
+                        (Bone*)bones->bones.invalidateUniforms(0, boneCount * sizeof(Bone));
+                std::fill_n(out, boneCount, Bone{});
+            }
+            bones->count = (uint8_t)boneCount;
+        }
+        static_cast<Visibility&>(mManager[instance].visibility).skinning = boneCount > 0;
+    }
+}
+
 void FRenderableManager::setBones(Instance ci,
         Bone const* UTILS_RESTRICT transforms, size_t boneCount, size_t offset) noexcept {
     if (ci) {
@@ -548,6 +869,10 @@ void RenderableManager::setPriority(Instance instance, uint8_t priority) noexcep
     upcast(this)->setPriority(instance, priority);
 }
 
+void RenderableManager::setSortGroup(Instance instance, uint8_t group) noexcept {
+    upcast(this)->setSortGroup(instance, group);
+}
+
 void RenderableManager::setCastShadows(Instance instance, bool enable) noexcept {
     upcast(this)->setCastShadows(instance, enable);
 }
@@ -597,16 +922,36 @@ void RenderableManager::setGeometryAt(Instance instance, size_t primitiveIndex,
             type, upcast(vertices), upcast(indices), offset, count);
 }
 
+void RenderableManager::setGeometryAt(Instance instance, size_t primitiveIndex,
+        PrimitiveType type, VertexBuffer* vertices, IndexBuffer* indices,
+        size_t offset, size_t minIndex, size_t maxIndex, size_t count) noexcept {
+    upcast(this)->setGeometryAt(instance, 0, primitiveIndex,
+            type, upcast(vertices), upcast(indices), offset, minIndex, maxIndex, count);
+}
+
 void RenderableManager::setGeometryAt(RenderableManager::Instance instance, size_t primitiveIndex,
         RenderableManager::PrimitiveType type, size_t offset, size_t count) noexcept {
     upcast(this)->setGeometryAt(instance, 0, primitiveIndex, type, offset, count);
 }
 
+void RenderableManager::setSkinning(Instance instance, size_t boneCount) noexcept {
+    upcast(this)->setSkinning(instance, boneCount);
+}
+
 void RenderableManager::setBones(Instance instance,
         RenderableManager::Bone const* transforms, size_t boneCount, size_t offset) noexcept {
     upcast(this)->setBones(instance, transforms, boneCount, offset);
 }
 
+void RenderableManager::setMorphWeights(Instance instance, math::float4 const& weights) noexcept {
+    upcast(this)->setMorphWeights(instance, weights);
+}
+
+void RenderableManager::setQuantizedPositionTransform(Instance instance,
+        math::float3 const& scale, math::float3 const& offset) noexcept {
+    upcast(this)->setQuantizedPositionTransform(instance, scale, offset);
+}
+
 void RenderableManager::setBones(Instance instance,
         mat4f const* transforms, size_t boneCount, size_t offset) noexcept {
     upcast(this)->setBones(instance, transforms, boneCount, offset);
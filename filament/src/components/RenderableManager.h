@@ -31,6 +31,8 @@
 #include <utils/Slice.h>
 #include <utils/Range.h>
 
+#include <vector>
+
 namespace filament {
 namespace details {
 
@@ -47,6 +49,8 @@ public:
         bool receiveShadows : 1;
         bool culling        : 1;
         bool skinning       : 1;
+        bool orientedBounds : 1;
+        uint8_t sortGroup;      // groups color commands within a priority
     };
 
     FRenderableManager(FEngine& engine) noexcept;
@@ -85,10 +89,14 @@ public:
         return mManager.slice<UNIFORMS>();
     }
 
-    utils::Slice<const Handle<HwUniformBuffer>> getUniformBufferHandles() const noexcept {
-        return mManager.slice<UNIFORMS_HANDLE>();
+    utils::Slice<const uint32_t> getUniformOffsets() const noexcept {
+        return mManager.slice<UNIFORM_OFFSET>();
     }
 
+    // the shared UBO holding every component's per-renderable block; each component's
+    // block lives at the offset returned by getUniformOffset()
+    Handle<HwUniformBuffer> getUniformBufferArena() const noexcept { return mUniformArena; }
+
     void updateLocalUBO(Instance instance, const math::mat4f& model) noexcept;
     inline void setAxisAlignedBoundingBox(Instance instance, const Box& aabb) noexcept;
 
@@ -97,15 +105,22 @@ public:
     // The priority is clamped to the range [0..7]
     inline void setPriority(Instance instance, uint8_t priority) noexcept;
 
+    inline void setSortGroup(Instance instance, uint8_t group) noexcept;
+
     inline void setCastShadows(Instance instance, bool enable) noexcept;
 
     inline void setLayerMask(Instance instance, uint8_t enable) noexcept;
     inline void setReceiveShadows(Instance instance, bool enable) noexcept;
     inline void setCulling(Instance instance, bool enable) noexcept;
-    inline void setUniformHandle(Instance instance, Handle<HwUniformBuffer> const& handle) noexcept;
+    inline void setOrientedBounds(Instance instance, bool enable) noexcept;
+    inline void setUniformOffset(Instance instance, uint32_t offset) noexcept;
     inline void setPrimitives(Instance instance, utils::Slice<FRenderPrimitive> const& primitives) noexcept;
+    void setSkinning(Instance instance, size_t boneCount) noexcept;
     inline void setBones(Instance instance, Bone const* transforms, size_t boneCount, size_t offset = 0) noexcept;
     inline void setBones(Instance instance, math::mat4f const* transforms, size_t boneCount, size_t offset = 0) noexcept;
+    void setMorphWeights(Instance instance, math::float4 const& weights) noexcept;
+    void setQuantizedPositionTransform(Instance instance,
+            math::float3 const& scale, math::float3 const& offset) noexcept;
 
 
     inline bool isShadowCaster(Instance instance) const noexcept;
@@ -117,15 +132,19 @@ public:
     inline Visibility getVisibility(Instance instance) const noexcept;
     inline uint8_t getLayerMask(Instance instance) const noexcept;
     inline uint8_t getPriority(Instance instance) const noexcept;
+    inline uint8_t getSortGroup(Instance instance) const noexcept;
 
     inline UniformBuffer const& getUniformBuffer(Instance instance) const noexcept;
     inline UniformBuffer& getUniformBuffer(Instance instance) noexcept;
 
-    inline Handle<HwUniformBuffer> getUbh(Instance instance) const noexcept;
+    inline uint32_t getUniformOffset(Instance instance) const noexcept;
     inline Handle<HwUniformBuffer> getBonesUbh(Instance instance) const noexcept;
 
 
-    inline size_t getLevelCount(Instance instance) const noexcept { return 1; }
+    inline size_t getLevelCount(Instance instance) const noexcept;
+    // picks the level of detail for a given projected screen size (fraction of the
+    // viewport height covered by the renderable's bounding sphere)
+    inline uint8_t selectLod(Instance instance, float screenSize) const noexcept;
     inline size_t getPrimitiveCount(Instance instance, uint8_t level) const noexcept;
     void setMaterialInstanceAt(Instance instance, uint8_t level,
             size_t primitiveIndex, FMaterialInstance const* materialInstance) noexcept;
@@ -133,6 +152,9 @@ public:
     void setGeometryAt(Instance instance, uint8_t level, size_t primitiveIndex,
             PrimitiveType type, FVertexBuffer* vertices, FIndexBuffer* indices,
             size_t offset, size_t count) noexcept;
+    void setGeometryAt(Instance instance, uint8_t level, size_t primitiveIndex,
+            PrimitiveType type, FVertexBuffer* vertices, FIndexBuffer* indices,
+            size_t offset, size_t minIndex, size_t maxIndex, size_t count) noexcept;
     void setGeometryAt(Instance instance, uint8_t level, size_t primitiveIndex,
             PrimitiveType type, size_t offset, size_t count) noexcept;
     void setBlendOrderAt(Instance instance, uint8_t level, size_t primitiveIndex, uint16_t blendOrder) noexcept;
@@ -140,11 +162,47 @@ public:
     inline utils::Slice<FRenderPrimitive> const& getRenderPrimitives(Instance instance, uint8_t level) const noexcept;
     inline utils::Slice<FRenderPrimitive>& getRenderPrimitives(Instance instance, uint8_t level) noexcept;
 
+    // monotonic counter bumped when a component is created/destroyed, or when its bounding
+    // box, layers or visibility state changes; this lets clients (e.g. FView's visibility
+    // cache or FScene's renderable data) cheaply detect that their inputs are unchanged.
+    uint32_t getEpoch() const noexcept { return mEpoch; }
 
 private:
+    struct LodGroup;
+
     void destroyComponent(Instance ci) noexcept;
-    static void destroyComponentPrimitives(FEngine& engine,
+    void destroyComponentPrimitives(FEngine& engine,
             utils::Slice<FRenderPrimitive>& primitives) noexcept;
+    void destroyComponentLods(FEngine& engine, std::unique_ptr<LodGroup>& lods) noexcept;
+
+    // All FRenderPrimitive arrays are carved out of a few large slabs instead of being
+    // individual heap allocations, so that RenderPass::generateCommands() streams through
+    // (mostly) contiguous memory instead of chasing one pointer per renderable.
+    // Freed arrays are binned by power-of-two size for reuse.
+    class PrimitivePool {
+    public:
+        PrimitivePool() noexcept = default;
+        ~PrimitivePool() noexcept;
+
+        PrimitivePool(PrimitivePool const& rhs) = delete;
+        PrimitivePool& operator=(PrimitivePool const& rhs) = delete;
+
+        // allocates and default-constructs count primitives
+        FRenderPrimitive* alloc(size_t count) noexcept;
+
+        // destroys and recycles a range previously returned by alloc()
+        void free(FRenderPrimitive* p, size_t count) noexcept;
+
+    private:
+        struct Range { Range* next; };
+        static constexpr size_t SLAB_PRIMITIVE_COUNT = 1024;    // primitives per slab
+        static constexpr size_t BIN_COUNT = 5;                  // bins of 1, 2, 4, 8, 16
+        static size_t binOf(size_t count) noexcept;
+        std::vector<void*> mSlabs;
+        Range* mBins[BIN_COUNT] = { nullptr };
+        char* mCurrent = nullptr;   // bump pointer into the current slab
+        char* mEnd = nullptr;
+    };
 
     struct Bones {
         filament::Handle<HwUniformBuffer> handle;
@@ -152,14 +210,25 @@ private:
         uint8_t count;
     };
 
+    // Levels of detail. levels[0] aliases the PRIMITIVES slice (it is not owned here);
+    // screenSize[i] (i >= 1) is the projected screen size below which level i replaces
+    // level i-1. Most renderables have no LODs, so this lives behind a unique_ptr like
+    // the bones data.
+    struct LodGroup {
+        utils::Slice<FRenderPrimitive> levels[RenderableManager::MAX_LOD_COUNT];
+        float screenSize[RenderableManager::MAX_LOD_COUNT] = {};
+        uint8_t count = 1;
+    };
+
     enum {
         AABB,               // user data
         LAYERS,             // user data
         VISIBILITY,         // user data
         PRIMITIVES,         // user data
         UNIFORMS,           // filament data, UBO data where world-transform is stored
-        UNIFORMS_HANDLE,    // filament data, handle to the driver's UBO
+        UNIFORM_OFFSET,     // filament data, offset of the block in the shared UBO
         BONES,              // filament data, UBO storing a pointer to the bones information
+        LODS,               // filament data, optional levels of detail
     };
 
     using Base = utils::SingleInstanceComponentManager<
@@ -168,8 +237,9 @@ private:
             Visibility,
             utils::Slice<FRenderPrimitive>,
             UniformBuffer,
-            filament::Handle<HwUniformBuffer>,
-            std::unique_ptr<Bones>
+            uint32_t,
+            std::unique_ptr<Bones>,
+            std::unique_ptr<LodGroup>
     >;
 
     struct Sim : public Base {
@@ -189,8 +259,9 @@ private:
                 Field<VISIBILITY>       visibility;
                 Field<PRIMITIVES>       primitives;
                 Field<UNIFORMS>         uniforms;
-                Field<UNIFORMS_HANDLE>  uniformsHandle;
+                Field<UNIFORM_OFFSET>   uniformOffset;
                 Field<BONES>            bones;
+                Field<LODS>             lods;
             };
         };
 
@@ -202,14 +273,40 @@ private:
         }
     };
 
+    /*
+     * All the per-renderable uniform blocks are carved out of a single large UBO
+     * (the "arena"); a component only remembers the offset of its block. Draws then
+     * bind (arena, offset, size) instead of a different buffer object per renderable:
+     * on GL this is a glBindBufferRange() into an already-bound buffer, on Vulkan a
+     * descriptor with a different offset, both much cheaper than rebinding buffers.
+     * Slots are fixed-size -- the per-renderable block layout is the same for every
+     * renderable -- and recycled through a free list when components are destroyed.
+     */
+
+    // worst case of GL's GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and Vulkan's
+    // minUniformBufferOffsetAlignment; using it unconditionally wastes a bit of
+    // space but avoids a synchronous query into the driver thread
+    static constexpr uint32_t UNIFORM_ARENA_ALIGNMENT = 256;
+    static constexpr uint32_t UNIFORM_ARENA_INITIAL_SLOTS = 128;
+
+    uint32_t allocateUniformSlot() noexcept;
+
     Sim mManager;
     FEngine& mEngine;
+    PrimitivePool mPrimitivePool;
+    filament::Handle<HwUniformBuffer> mUniformArena;
+    std::vector<uint32_t> mUniformSlotFreeList;
+    uint32_t mUniformSlotStride = 0;    // size of a slot, in bytes
+    uint32_t mUniformSlotCount = 0;     // slots handed out so far (high-water mark)
+    uint32_t mUniformArenaCapacity = 0; // size of the arena, in slots
+    uint32_t mEpoch = 0;
 };
 
 FILAMENT_UPCAST(RenderableManager)
 
 void FRenderableManager::setAxisAlignedBoundingBox(Instance instance, const Box& aabb) noexcept {
     if (instance) {
+        mEpoch++;
         mManager[instance].aabb = aabb;
     }
 }
@@ -217,6 +314,7 @@ void FRenderableManager::setAxisAlignedBoundingBox(Instance instance, const Box&
 void FRenderableManager::setLayerMask(Instance instance,
         uint8_t select, uint8_t values) noexcept {
     if (instance) {
+        mEpoch++;
         uint8_t& layers = mManager[instance].layers;
         layers = (layers & ~select) | (values & select);
     }
@@ -224,19 +322,30 @@ void FRenderableManager::setLayerMask(Instance instance,
 
 void FRenderableManager::setLayerMask(Instance instance, uint8_t layerMask) noexcept {
     if (instance) {
+        mEpoch++;
         mManager[instance].layers = layerMask;
     }
 }
 
 void FRenderableManager::setPriority(Instance instance, uint8_t priority) noexcept {
     if (instance) {
+        mEpoch++;
         Visibility& visibility = mManager[instance].visibility;
         visibility.priority = priority;
     }
 }
 
+void FRenderableManager::setSortGroup(Instance instance, uint8_t group) noexcept {
+    if (instance) {
+        mEpoch++;
+        Visibility& visibility = mManager[instance].visibility;
+        visibility.sortGroup = group;
+    }
+}
+
 void FRenderableManager::setCastShadows(Instance instance, bool enable) noexcept {
     if (instance) {
+        mEpoch++;
         Visibility& visibility = mManager[instance].visibility;
         visibility.castShadows = enable;
     }
@@ -244,6 +353,7 @@ void FRenderableManager::setCastShadows(Instance instance, bool enable) noexcept
 
 void FRenderableManager::setReceiveShadows(Instance instance, bool enable) noexcept {
     if (instance) {
+        mEpoch++;
         Visibility& visibility = mManager[instance].visibility;
         visibility.receiveShadows = enable;
     }
@@ -251,15 +361,23 @@ void FRenderableManager::setReceiveShadows(Instance instance, bool enable) noexc
 
 void FRenderableManager::setCulling(Instance instance, bool enable) noexcept {
     if (instance) {
+        mEpoch++;
         Visibility& visibility = mManager[instance].visibility;
         visibility.culling = enable;
     }
 }
 
-void FRenderableManager::setUniformHandle(Instance instance,
-        Handle<HwUniformBuffer> const& handle) noexcept {
+void FRenderableManager::setOrientedBounds(Instance instance, bool enable) noexcept {
     if (instance) {
-        mManager[instance].uniformsHandle = handle;
+        mEpoch++;
+        Visibility& visibility = mManager[instance].visibility;
+        visibility.orientedBounds = enable;
+    }
+}
+
+void FRenderableManager::setUniformOffset(Instance instance, uint32_t offset) noexcept {
+    if (instance) {
+        mManager[instance].uniformOffset = offset;
     }
 }
 
@@ -295,6 +413,10 @@ uint8_t FRenderableManager::getPriority(Instance instance) const noexcept {
     return getVisibility(instance).priority;
 }
 
+uint8_t FRenderableManager::getSortGroup(Instance instance) const noexcept {
+    return getVisibility(instance).sortGroup;
+}
+
 Box const& FRenderableManager::getAABB(Instance instance) const noexcept {
     return mManager[instance].aabb;
 }
@@ -307,8 +429,8 @@ UniformBuffer& FRenderableManager::getUniformBuffer(Instance instance) noexcept
     return mManager[instance].uniforms;
 }
 
-Handle<HwUniformBuffer> FRenderableManager::getUbh(Instance instance) const noexcept {
-    return mManager[instance].uniformsHandle;
+uint32_t FRenderableManager::getUniformOffset(Instance instance) const noexcept {
+    return mManager[instance].uniformOffset;
 }
 
 Handle<HwUniformBuffer> FRenderableManager::getBonesUbh(Instance instance) const noexcept {
@@ -318,11 +440,19 @@ Handle<HwUniformBuffer> FRenderableManager::getBonesUbh(Instance instance) const
 
 utils::Slice<FRenderPrimitive> const& FRenderableManager::getRenderPrimitives(
         Instance instance, uint8_t level) const noexcept {
+    std::unique_ptr<LodGroup> const& lods = mManager[instance].lods;
+    if (UTILS_UNLIKELY(lods && level < lods->count)) {
+        return lods->levels[level];
+    }
     return mManager[instance].primitives;
 }
 
 utils::Slice<FRenderPrimitive>& FRenderableManager::getRenderPrimitives(
         Instance instance, uint8_t level) noexcept {
+    std::unique_ptr<LodGroup> const& lods = mManager[instance].lods;
+    if (UTILS_UNLIKELY(lods && level < lods->count)) {
+        return lods->levels[level];
+    }
     return mManager[instance].primitives;
 }
 
@@ -330,6 +460,22 @@ size_t FRenderableManager::getPrimitiveCount(Instance instance, uint8_t level) c
     return getRenderPrimitives(instance, level).size();
 }
 
+size_t FRenderableManager::getLevelCount(Instance instance) const noexcept {
+    std::unique_ptr<LodGroup> const& lods = mManager[instance].lods;
+    return lods ? lods->count : 1;
+}
+
+uint8_t FRenderableManager::selectLod(Instance instance, float screenSize) const noexcept {
+    std::unique_ptr<LodGroup> const& lods = mManager[instance].lods;
+    uint8_t level = 0;
+    if (UTILS_UNLIKELY(lods)) {
+        while (level + 1 < lods->count && screenSize < lods->screenSize[level + 1]) {
+            level++;
+        }
+    }
+    return level;
+}
+
 } // namespace details
 } // namespace filament
 
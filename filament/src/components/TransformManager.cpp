@@ -16,6 +16,10 @@
 
 #include "components/TransformManager.h"
 
+#include <utils/JobSystem.h>
+
+#include <utils/vector.h>
+
 using namespace utils;
 using namespace math;
 
@@ -50,6 +54,7 @@ void FTransformManager::create(Entity entity, Instance parent, const mat4f& loca
         manager[i].next = 0;
         manager[i].prev = 0;
         manager[i].firstChild = 0;
+        manager[i].flags = 0;
         insertNode(i, parent);
         setTransform(i, localTransform);
     }
@@ -75,6 +80,8 @@ void FTransformManager::destroy(Entity e) noexcept {
     Instance i = manager.getInstance(e);
     validateNode(i);
     if (i) {
+        mEpoch++;
+
         // 1) remove the entry from the linked lists
         removeNode(i);
 
@@ -110,32 +117,18 @@ void FTransformManager::updateNodeTransform(Instance i) noexcept {
     auto& manager = mManager;
     assert(i);
 
+    // world transforms are about to change
+    mEpoch++;
+
     if (UTILS_UNLIKELY(mLocalTransformTransactionOpen)) {
-        // don't update the world transform until commitLocalTransformTransaction() is called
-        Instance ci = manager[i].firstChild;
-        while (ci) {
-            Instance child = manager[ci].firstChild;
-            ci = manager[ci].next;
-            if (child) {
-                updateNodeTransform(child);
-            }
-        }
+        // don't update the world transform until commitLocalTransformTransaction() is
+        // called; just mark the subtree root dirty, the commit recomputes each dirty
+        // subtree exactly once.
+        manager[i].flags = uint8_t(manager[i].flags | FLAG_LOCAL_DIRTY);
         return;
     }
 
-    // find our parent's world transform, if any
-    // note: by using the raw_array() we don't need to check that parent is valid.
-    Instance parent = manager[i].parent;
-    mat4f const& pt = manager.raw_array<WORLD>()[parent];
-
-    // compute our world transform
-    manager[i].world = pt * static_cast<mat4f const&>(manager[i].local);
-
-    // update our children's world transforms
-    Instance child = manager[i].firstChild;
-    if (UTILS_UNLIKELY(child)) { // assume we don't have a hierarchy in the common case
-        transformChildren(manager, child);
-    }
+    computeWorldTransform(manager, i);
 }
 
 void FTransformManager::openLocalTransformTransaction() noexcept {
@@ -145,25 +138,78 @@ void FTransformManager::openLocalTransformTransaction() noexcept {
 void FTransformManager::commitLocalTransformTransaction() noexcept {
     if (mLocalTransformTransactionOpen) {
         mLocalTransformTransactionOpen = false;
+        mEpoch++;
         auto& manager = mManager;
 
         // swapNode() below needs some temporary storage which we provide here
         auto& soa = manager.getSoA();
         soa.ensureCapacity(soa.size() + 1);
 
-        mat4f const* const UTILS_RESTRICT world = manager.raw_array<WORLD>();
+        // Ensure that children are always sorted after their parent.
         for (Instance i = manager.begin(), e = manager.end(); i != e; ++i) {
-            // Ensure that children are always sorted after their parent.
             if (UTILS_UNLIKELY(Instance(manager[i].parent) > i)) {
                 swapNode(i, manager[i].parent);
             }
+            assert(Instance(manager[i].parent) < i);
+        }
+
+        // Collect the roots of the dirty subtrees, i.e. dirty nodes without a dirty
+        // ancestor. Because parents now sort before their children, a single forward
+        // pass can propagate "some ancestor is dirty" down the hierarchy.
+        manager.elementAt<FLAGS>(0) = 0;    // the implicit root is never dirty
+        SmallVector<Instance, 128> roots;
+        for (Instance i = manager.begin(), e = manager.end(); i != e; ++i) {
             Instance parent = manager[i].parent;
-            assert(parent < i);
-            manager[i].world = world[parent] * static_cast<mat4f const&>(manager[i].local);
+            if (manager[parent].flags & (FLAG_LOCAL_DIRTY | FLAG_ANCESTOR_DIRTY)) {
+                manager[i].flags = uint8_t(manager[i].flags | FLAG_ANCESTOR_DIRTY);
+            } else if (manager[i].flags & FLAG_LOCAL_DIRTY) {
+                roots.push_back(i);
+            }
+        }
+
+        // The dirty subtrees are disjoint by construction, so each world matrix is
+        // computed exactly once, and independent subtrees can be processed in parallel.
+        // A subtree root's parent is clean, so its world transform is stable.
+        if (!roots.empty()) {
+            auto work = [&manager](Instance const* r, size_t c) {
+                for (size_t k = 0; k < c; k++) {
+                    computeWorldTransform(manager, r[k]);
+                }
+            };
+            JobSystem* const js = JobSystem::getJobSystem();
+            if (js && roots.size() > 1) {
+                // subtree sizes are typically skewed, let the splitter adapt
+                auto job = jobs::parallel_for(*js, nullptr,
+                        roots.data(), (uint32_t)roots.size(),
+                        std::ref(work), jobs::AdaptiveSplitter<1, 8>());
+                js->runAndWait(job);
+            } else {
+                // not on a JobSystem thread (e.g. tests), or a single subtree
+                work(roots.data(), roots.size());
+            }
+        }
+
+        #pragma nounroll
+        for (Instance i = manager.begin(), e = manager.end(); i != e; ++i) {
+            manager[i].flags = 0;
         }
     }
 }
 
+void FTransformManager::computeWorldTransform(Sim& manager, Instance i) noexcept {
+    // find our parent's world transform, if any
+    // note: by using the raw_array() we don't need to check that parent is valid.
+    Instance parent = manager[i].parent;
+    mat4f const& pt = manager.raw_array<WORLD>()[parent];
+
+    manager[i].world = pt * static_cast<mat4f const&>(manager[i].local);
+
+    Instance child = manager[i].firstChild;
+    if (UTILS_UNLIKELY(child)) {
+        transformChildren(manager, child);
+    }
+}
+
 // Inserts a parentless node in the hierarchy
 void FTransformManager::insertNode(Instance i, Instance parent) noexcept {
     auto& manager = mManager;
@@ -197,6 +243,7 @@ void FTransformManager::swapNode(Instance i, Instance j) noexcept {
     // swap the content of the nodes directly
     std::swap(manager.elementAt<LOCAL>(i), manager.elementAt<LOCAL>(j));
     std::swap(manager.elementAt<WORLD>(i), manager.elementAt<WORLD>(j));
+    std::swap(manager.elementAt<FLAGS>(i), manager.elementAt<FLAGS>(j));
     manager.swap(i, j); // this swaps the data relative to SingleInstanceComponentManager
 
     // now swap the linked-list references, to do that correctly we must use a temporary
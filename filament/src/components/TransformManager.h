@@ -82,6 +82,10 @@ public:
         return mManager[ci].world;
     }
 
+    // monotonic counter bumped every time a world transform may have changed; this lets
+    // clients (e.g. FView's visibility cache) cheaply detect that nothing moved.
+    uint32_t getEpoch() const noexcept { return mEpoch; }
+
 private:
     struct Sim;
 
@@ -92,6 +96,7 @@ private:
     void insertNode(Instance i, Instance p) noexcept;
     void swapNode(Instance i, Instance j) noexcept;
     static void transformChildren(Sim& manager, Instance firstChild) noexcept;
+    static void computeWorldTransform(Sim& manager, Instance i) noexcept;
 
 
     enum {
@@ -101,15 +106,22 @@ private:
         FIRST_CHILD,    // instance to our first child
         NEXT,           // instance to our next sibling
         PREV,           // instance to our previous sibling
+        FLAGS,          // per-node dirty flags, see below
     };
 
+    // set when the local transform changed during an open transaction
+    static constexpr uint8_t FLAG_LOCAL_DIRTY    = 0x01;
+    // transient, only used within commitLocalTransformTransaction()
+    static constexpr uint8_t FLAG_ANCESTOR_DIRTY = 0x02;
+
     using Base = utils::SingleInstanceComponentManager<
             math::mat4f,
             math::mat4f,
             Instance,
             Instance,
             Instance,
-            Instance
+            Instance,
+            uint8_t
     >;
 
     struct Sim : public Base {
@@ -132,6 +144,7 @@ private:
                 Field<FIRST_CHILD>  firstChild;
                 Field<NEXT>         next;
                 Field<PREV>         prev;
+                Field<FLAGS>        flags;
             };
         };
 
@@ -144,6 +157,7 @@ private:
     };
 
     Sim mManager;
+    uint32_t mEpoch = 0;
     bool mLocalTransformTransactionOpen = false;
 };
 
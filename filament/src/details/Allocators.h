@@ -24,14 +24,21 @@ namespace details {
 
 // per render pass allocations
 // Froxelization needs about 1 MiB. Command buffer needs about 1 MiB.
+// This only sizes the primary area; frames that overflow it spill to heap-allocated
+// slabs which are retained across frames (see utils::LinearAllocatorWithFallback).
 static constexpr size_t CONFIG_PER_RENDER_PASS_ARENA_SIZE    = 2 * 1024 * 1024;
 
 // size of the high-level draw commands buffer (comes from the per-render pass allocator)
 static constexpr size_t CONFIG_PER_FRAME_COMMANDS_SIZE = 1 * 1024 * 1024;
 
+// How many frames the main thread may run ahead of the driver thread. This sizes the
+// command-stream buffer and bounds the runtime knob (see Engine::setFrameLatency).
+static constexpr size_t CONFIG_MAX_FRAME_LATENCY = 3;
+
 // size of a command-stream buffer (comes from mmap -- not the per-engine arena)
 static constexpr size_t CONFIG_MIN_COMMAND_BUFFERS_SIZE = 1 * 1024 * 1024;
-static constexpr size_t CONFIG_COMMAND_BUFFERS_SIZE     = 3 * CONFIG_MIN_COMMAND_BUFFERS_SIZE;
+static constexpr size_t CONFIG_COMMAND_BUFFERS_SIZE     =
+        CONFIG_MAX_FRAME_LATENCY * CONFIG_MIN_COMMAND_BUFFERS_SIZE;
 
 #ifndef NDEBUG
 
@@ -40,7 +47,7 @@ using HeapAllocatorArena = utils::Arena<
         utils::LockingPolicy::NoLock>;
 
 using LinearAllocatorArena = utils::Arena<
-        utils::LinearAllocator,
+        utils::LinearAllocatorWithFallback,
         utils::LockingPolicy::NoLock,
         utils::TrackingPolicy::HighWatermark>;
 
@@ -51,7 +58,7 @@ using HeapAllocatorArena = utils::Arena<
         utils::LockingPolicy::NoLock>;
 
 using LinearAllocatorArena = utils::Arena<
-        utils::LinearAllocator,
+        utils::LinearAllocatorWithFallback,
         utils::LockingPolicy::NoLock>;
 
 #endif
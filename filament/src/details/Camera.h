@@ -27,6 +27,7 @@
 #include <utils/Entity.h>
 
 #include <math/mat4.h>
+#include <math/vec2.h>
 
 namespace filament {
 namespace details {
@@ -68,6 +69,15 @@ public:
         return mProjectionForCulling;
     }
 
+    // Sub-pixel jitter for temporal anti-aliasing, in NDC units (e.g. one pixel is
+    // 2.0/width in x). Applied to the viewing projection only -- never to the culling
+    // projection, so visibility results stay stable across jittered frames.
+    void setProjectionJitter(math::double2 jitterInNdc) noexcept { mJitter = jitterInNdc; }
+    math::double2 getProjectionJitter() const noexcept { return mJitter; }
+
+    // returns the projection matrix with the jitter applied, see setProjectionJitter()
+    math::mat4 getJitteredProjectionMatrix() const noexcept;
+
     float getNear() const noexcept { return mNear; }
     float getCullingFar() const noexcept { return mFar; }
 
@@ -111,8 +121,9 @@ public:
         return normalize(-getModelMatrix()[2].xyz);
     }
 
-    // returns a Frustum object in world space
-    Frustum getFrustum() const noexcept;
+    // Returns a Frustum object in world space. The result is cached and only recomputed
+    // when the projection or the camera's transform changed since the last call.
+    Frustum const& getFrustum() const noexcept;
 
     // sets this camera's exposure (default is f/16, 1/125s, 100 ISO)
     void setExposure(float aperture, float shutterSpeed, float sensitivity) noexcept;
@@ -145,6 +156,7 @@ private:
 
     math::mat4 mProjection;            // projection matrix (infinite far)
     math::mat4 mProjectionForCulling;  // projection matrix (with far plane)
+    math::double2 mJitter{};           // TAA sub-pixel jitter in NDC units
 
     float mNear;
     float mFar;
@@ -152,6 +164,16 @@ private:
     float mAperture = 16.0f;
     float mShutterSpeed = 1.0f / 125.0f;
     float mSensitivity = 100.0f;
+
+    // getFrustum() cache. The generation is bumped by the projection setters; the view
+    // matrix is compared directly instead, because the camera's transform can change
+    // through the TransformManager without going through FCamera. Note that the jitter
+    // doesn't participate: the frustum is built from mProjectionForCulling, which the
+    // jitter never touches.
+    uint32_t mProjectionGeneration = 1;
+    mutable uint32_t mFrustumGeneration = 0;    // != mProjectionGeneration: cache invalid
+    mutable math::mat4f mFrustumViewMatrix;
+    mutable Frustum mFrustum;
 };
 
 struct CameraInfo {
@@ -80,6 +80,14 @@ public:
             Frustum const& frustum,
             math::float4 const& sphere) noexcept;
 
+    /*
+     * returns whether a box oriented by a rigid transform intersects with the frustum
+     */
+    static bool intersectsOriented(
+            Frustum const& frustum,
+            Box const& box,
+            math::mat4f const& model) noexcept;
+
 
     struct UTILS_PUBLIC Test {
         static void intersects(result_type* results,
@@ -92,7 +100,36 @@ public:
                 Frustum const& frustum,
                 math::float4 const* b,
                 size_t count) noexcept;
+
+        // Scalar reference paths. These are always compiled -- even when a SIMD path
+        // is selected in Culler.cpp -- so the conformance tests and the benchmark
+        // harness can validate and time the vectorized paths against them on the
+        // same machine.
+        static void intersectsScalar(result_type* results,
+                Frustum const& frustum,
+                math::float3 const* c,
+                math::float3 const* e,
+                size_t count) noexcept;
+
+        static void intersectsScalar(result_type* results,
+                Frustum const& frustum,
+                math::float4 const* b,
+                size_t count) noexcept;
     };
+
+private:
+    // scalar implementations, used as the fallback when no SIMD path is available
+    // and as the reference the SIMD paths are validated against (see Test above)
+    static void intersectsScalar(result_type* results,
+            Frustum const& frustum,
+            math::float3 const* center,
+            math::float3 const* extent,
+            size_t count, size_t bit) noexcept;
+
+    static void intersectsScalar(result_type* results,
+            Frustum const& frustum,
+            math::float4 const* b,
+            size_t count) noexcept;
 };
 
 } // namespace details
@@ -29,6 +29,8 @@ namespace details {
 class FEngine;
 class FTexture;
 
+// Holds the DFG (BRDF integration) LUT. The LUT is generated offline by cmgen and embedded
+// in the engine image; at engine creation it is only uploaded, never computed.
 class DFG {
 public:
     explicit DFG(FEngine& engine) noexcept;
@@ -58,9 +60,6 @@ private:
 
     // make sure to use the right size here
     static constexpr size_t DFG_LUT_SIZE = 128;
-
-    // this lookup table is generated with cmgen
-    static const uint16_t DFG_LUT[];
 };
 
 } // namespace details
@@ -26,6 +26,8 @@
 
 #include <tsl/robin_map.h>
 
+#include <atomic>
+
 namespace filament {
 namespace details {
 
@@ -59,10 +61,19 @@ public:
         registerProperty(name, p, type);
     }
 
+    // Counters are incremented from hot paths with relaxed atomics; snapshotCounters()
+    // captures their values into the public Counter array, once per frame from
+    // FRenderer::endFrame(). The atomics must outlive this registry.
+    void registerCounter(utils::StaticString name, std::atomic<uint64_t>* counter) noexcept;
+    void snapshotCounters() noexcept;
+    std::pair<Counter const*, size_t> getCounters() const noexcept;
+
 private:
     void registerProperty(utils::StaticString name, void* p, Type type) noexcept;
     std::vector<Property> mProperties;
     tsl::robin_map<utils::StaticString, void*> mPropertyMap;
+    std::vector<std::atomic<uint64_t>*> mCounterAddresses;
+    std::vector<Counter> mCounters;
 };
 
 FILAMENT_UPCAST(DebugRegistry)
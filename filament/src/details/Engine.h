@@ -31,6 +31,7 @@
 #include "details/DebugRegistry.h"
 #include "details/ResourceList.h"
 #include "details/Skybox.h"
+#include "details/TextureArrayPacker.h"
 
 #include "driver/CommandStream.h"
 #include "driver/CommandBufferQueue.h"
@@ -47,17 +48,25 @@
 #include <filaflat/MaterialParser.h>
 #include <filaflat/ShaderBuilder.h>
 
+#include <private/filament/UibStructs.h>
+
 #include <utils/compiler.h>
+#include <utils/AdaptiveMutex.h>
 #include <utils/Allocator.h>
 #include <utils/JobSystem.h>
 #include <utils/CountDownLatch.h>
+#include <utils/Mutex.h>
 
 #include <math/mat4.h>
 #include <math/quat.h>
 
+#include <atomic>
 #include <chrono>
+#include <map>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace filament {
 
@@ -68,6 +77,7 @@ class Program;
 namespace details {
 
 class FFence;
+class FMaterial;
 class FMaterialInstance;
 class FRenderer;
 class FScene;
@@ -76,6 +86,7 @@ class FView;
 
 class DFG;
 class ProgramCache;
+class ShadowMap;
 
 /*
  * Concrete implementation of the Engine interface. This keeps track of all hardware resources
@@ -103,63 +114,29 @@ public:
     static constexpr size_t CONFIG_FROXEL_SLICE_COUNT      = 16;
     static constexpr bool   CONFIG_IBL_USE_IRRADIANCE_MAP  = false;
 
+    // how many shader programs FMaterial may build in a single frame; builds past this
+    // budget are deferred to the next prepare() (see FMaterial::getProgramSlow())
+    static constexpr size_t CONFIG_MAX_PROGRAM_BUILDS_PER_FRAME = 8;
+
+    // how many leaked objects cleanupResourceList() destroys between command buffer flushes;
+    // bounds command buffer usage and lets the driver thread tear down its side of each
+    // batch while we keep terminating the next one
+    static constexpr size_t CONFIG_CLEANUP_BATCH_SIZE = 128;
+
     static constexpr size_t CONFIG_PER_RENDER_PASS_ARENA_SIZE   = details::CONFIG_PER_RENDER_PASS_ARENA_SIZE;
     static constexpr size_t CONFIG_PER_FRAME_COMMANDS_SIZE      = details::CONFIG_PER_FRAME_COMMANDS_SIZE;
     static constexpr size_t CONFIG_MIN_COMMAND_BUFFERS_SIZE     = details::CONFIG_MIN_COMMAND_BUFFERS_SIZE;
     static constexpr size_t CONFIG_COMMAND_BUFFERS_SIZE         = details::CONFIG_COMMAND_BUFFERS_SIZE;
+    static constexpr size_t CONFIG_MAX_FRAME_LATENCY            = details::CONFIG_MAX_FRAME_LATENCY;
 
-    struct PerViewUib {
-        static UniformInterfaceBlock getUib() noexcept;
-        // these fields are only used to call offsetof() and make it easy to visualize the UBO
-        // IMPORTANT NOTE: Respect std140 layout, don't update without updating getUib()
-        math::mat4f viewFromWorldMatrix;
-        math::mat4f worldFromViewMatrix;
-        math::mat4f clipFromViewMatrix;
-        math::mat4f viewFromClipMatrix;
-        math::mat4f clipFromWorldMatrix;
-        math::mat4f lightFromWorldMatrix;
-
-        math::float4 resolution; // width, height, 1/width, 1/height
-
-        math::float3 cameraPosition;
-        float time; // time in seconds, with a 1 second period
-
-        math::float4 lightColorIntensity; // directional light
-
-        math::float4 sun; // cos(sunAngle), sin(sunAngle), 1/(sunAngle*HALO_SIZE-sunAngle), HALO_EXP
-
-        math::float3 lightDirection;
-        uint32_t fParamsX; // stride-x
-
-        math::float3 shadowBias; // constant bias, normal bias, unused
-        float oneOverFroxelDimensionY;
-
-        math::float4 zParams; // froxel Z parameters
-
-        math::uint2 fParams; // stride-y, stride-z
-        math::float2 origin; // viewport left, viewport bottom
-
-        float oneOverFroxelDimensionX;
-        float iblLuminance;
-        float exposure;
-        float ev100;
-
-        alignas(16) math::float4 iblSH[9]; // actually float3 entries (std140 requires float4 alignment)
-    };
-
-    struct PerRenderableUib {
-        static UniformInterfaceBlock getUib() noexcept;
-        // these fields are only used to call offsetof() and make it easy to visualize the UBO
-        math::mat4f worldFromModelMatrix;
-        math::mat3f worldFromModelNormalMatrix;
-    };
-
-    struct PostProcessingUib {
-        static UniformInterfaceBlock getUib() noexcept;
-        math::float2 uvScale;
-        float time;             // time in seconds, with a 1 second period, used for dithering
-        float yOffset;
-    };
+    // C++ mirrors of the engine-owned uniform blocks; the layouts live in filabridge
+    // (private/filament/UibStructs.h) so the shader generator consumes the same
+    // definitions, and uniform writes are direct stores via offsetof().
+    using PerViewUib = filament::PerViewUib;
+    using PerRenderableUib = filament::PerRenderableUib;
+    using LightsUib = filament::LightsUib;
+    using PostProcessingUib = filament::PostProcessingUib;
+    using PerRenderableBonesUib = filament::PerRenderableBonesUib;
 
     struct PerViewSib {
         static SamplerInterfaceBlock getSib() noexcept;
@@ -167,15 +144,18 @@ public:
         static constexpr size_t SHADOW_MAP     = 0;
         static constexpr size_t RECORDS        = 1;
         static constexpr size_t FROXELS        = 2;
-        static constexpr size_t IBL_DFG_LUT    = 3;
-        static constexpr size_t IBL_SPECULAR   = 4;
-        static constexpr size_t IBL_IRRADIANCE = 5;
+        static constexpr size_t IBL_DFG_LUT         = 3;
+        static constexpr size_t IBL_SPECULAR        = 4;
+        static constexpr size_t IBL_SPECULAR_BLEND  = 5;
+        static constexpr size_t SHADOW_VSM          = 6;
     };
 
     struct PostProcessSib {
         static SamplerInterfaceBlock getSib() noexcept;
         // indices of each samplers in this SamplerInterfaceBlock (see: getSib())
-        static constexpr size_t COLOR_BUFFER   = 0;
+        static constexpr size_t COLOR_BUFFER      = 0;
+        static constexpr size_t COLOR_GRADING_LUT = 1;
+        static constexpr size_t LUMINANCE         = 2;
     };
 
 public:
@@ -186,7 +166,13 @@ public:
 
     Driver& getDriver() const noexcept { return *mDriver; }
     DriverApi& getDriverApi() noexcept { return mCommandStream; }
-    DFG* getDFG() const noexcept { return mDFG.get(); }
+    DriverApi& getResourceDriverApi() noexcept { return mResourceStream; }
+    DFG* getDFG() const noexcept {
+        if (UTILS_UNLIKELY(!mInitCompleted)) {
+            const_cast<FEngine*>(this)->completeInit();
+        }
+        return mDFG.get();
+    }
 
 
     // Uniforms...
@@ -203,10 +189,37 @@ public:
     // we'll simply have to use separate Areas (for instance).
     LinearAllocatorArena& getPerRenderPassAllocator() noexcept { return mPerRenderPassAllocator; }
 
+    size_t getPerRenderPassArenaHighWatermark() const noexcept {
+        return mPerRenderPassAllocator.getAllocator().highWatermark();
+    }
+
+    // how many frames the CPU may run ahead of the GPU; applied by FRenderer at the
+    // start of each frame (see FrameSkipper)
+    void setFrameLatency(size_t frames) noexcept {
+        mFrameLatency = std::min(std::max(frames, size_t(1)), CONFIG_MAX_FRAME_LATENCY);
+    }
+    size_t getFrameLatency() const noexcept { return mFrameLatency; }
+
+    // GPU memory accounting, see Engine::setMemoryBudget(). Resources credit/debit their
+    // pool from their constructor/terminate(), which run on the engine's thread.
+    enum class GpuMemoryPool : uint8_t { TEXTURE, VERTEX_BUFFER, INDEX_BUFFER, COUNT };
+    void trackGpuMemory(GpuMemoryPool pool, int64_t bytes) noexcept;
+    Engine::MemoryUsage getMemoryUsage() const noexcept;
+    void setMemoryBudget(size_t budgetBytes) noexcept { mMemoryBudget = budgetBytes; }
+    void setMemoryPressureCallback(Engine::MemoryPressureCallback callback, void* user) noexcept {
+        mMemoryPressureCallback = callback;
+        mMemoryPressureUser = user;
+    }
+
     // Material IDs...
     uint32_t getMaterialId() const noexcept { return mMaterialId++; }
 
-    const FMaterial* getDefaultMaterial() const noexcept { return mDefaultMaterial; }
+    const FMaterial* getDefaultMaterial() const noexcept {
+        if (UTILS_UNLIKELY(!mInitCompleted)) {
+            const_cast<FEngine*>(this)->completeInit();
+        }
+        return mDefaultMaterial;
+    }
     const FMaterial* getSkyboxMaterial(bool rgbm) const noexcept;
     const FIndirectLight* getDefaultIndirectLight() const noexcept { return mDefaultIbl; }
 
@@ -247,6 +260,10 @@ public:
         return mRenderTargetPool;
     }
 
+    TextureArrayPacker& getTextureArrayPacker() noexcept {
+        return mTextureArrayPacker;
+    }
+
     FRenderableManager& getRenderableManager() noexcept {
         return mRenderableManager;
     }
@@ -281,8 +298,41 @@ public:
 
     void* streamAlloc(size_t size, size_t alignment) noexcept;
 
+    // upload memory arena, see Engine::uploadAlloc()
+    void* uploadAlloc(size_t size) noexcept;
+    void uploadFree(void* buffer, size_t size) noexcept;
+
     utils::JobSystem& getJobSystem() noexcept { return mJobSystem; }
 
+    // shared GPU storage of deduplicated vertex buffers, keyed by content hash and
+    // refcounted; managed by FVertexBuffer (see VertexBuffer::Builder::dedupe()).
+    // A key match silently aliases user geometry on shared storage, so the key is
+    // 128 bits wide -- two independently seeded hash chains -- to keep accidental
+    // collisions out of reach even for very large asset sets.
+    struct VertexBufferDedupKey {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        bool operator==(VertexBufferDedupKey const& rhs) const noexcept {
+            return lo == rhs.lo && hi == rhs.hi;
+        }
+        struct Hasher {
+            size_t operator()(VertexBufferDedupKey const& key) const noexcept {
+                return size_t(key.lo ^ key.hi);
+            }
+        };
+    };
+    struct SharedVertexBuffer {
+        Handle<HwVertexBuffer> handle;
+        uint32_t refs = 0;
+        uint32_t bytes = 0;
+    };
+    using VertexBufferDedupRegistry =
+            std::unordered_map<VertexBufferDedupKey, SharedVertexBuffer,
+                    VertexBufferDedupKey::Hasher>;
+    VertexBufferDedupRegistry& getVertexBufferDedupRegistry() noexcept {
+        return mVertexBufferDedupRegistry;
+    }
+
     Epoch getEpoch() const { return mEpoch; }
 
     void shutdown();
@@ -308,7 +358,9 @@ public:
     FView* createView() noexcept;
     FCamera* createCamera(utils::Entity entity) noexcept;
     FFence* createFence(Fence::Type type = Fence::Type::SOFT) noexcept;
+    FFence* createResourceFence() noexcept;
     FSwapChain* createSwapChain(void* nativeWindow, uint64_t flags) noexcept;
+    FSwapChain* createSwapChain(uint32_t width, uint32_t height, uint64_t flags) noexcept;
 
     void destroy(const FVertexBuffer* p);
     void destroy(const FFence* p);
@@ -328,9 +380,41 @@ public:
     // flush the current buffer
     void flush();
 
+    // Background resource loading. When enabled, Texture, VertexBuffer and IndexBuffer
+    // record their creation and data-upload commands on a separate queue, which the
+    // driver thread drains only when the frame has slack (see executeResourceCommands()),
+    // so large uploads don't compete with frame commands and cause hitches. Such
+    // resources must not be referenced by frame commands -- e.g. attached to a
+    // renderable -- until a fence created with createResourceFence() has signaled.
+    void setAsyncResourceLoadingEnabled(bool enabled) noexcept { mAsyncResourceLoading = enabled; }
+    bool isAsyncResourceLoadingEnabled() const noexcept { return mAsyncResourceLoading; }
+
+    // flush the background resource command buffer
+    void flushResourceCommands();
+
+    // per-frame time budget for background resource uploads on the driver thread,
+    // published by FRenderer from the measured frame times
+    void setResourceTimeSliceNs(int64_t ns) noexcept {
+        mResourceTimeSliceNs.store(ns, std::memory_order_relaxed);
+    }
+
     void prepare();
     void gc();
 
+    // Program-build budgeting. A material variant showing up mid-frame normally compiles
+    // its program synchronously, which can hitch the frame; materials check the budget
+    // below and defer the build (drawing with a placeholder instead) when it's exhausted.
+    // Deferred builds are executed at the beginning of the next frame, in prepare().
+    bool hasProgramBuildBudget() const noexcept {
+        return mProgramBuildsThisFrame.load(std::memory_order_relaxed)
+                < CONFIG_MAX_PROGRAM_BUILDS_PER_FRAME;
+    }
+    void countProgramBuild() noexcept {
+        mProgramBuildsThisFrame.fetch_add(1, std::memory_order_relaxed);
+    }
+    void deferProgramBuild(FMaterial const* material, uint8_t variantKey) noexcept;
+    void cancelDeferredProgramBuilds(FMaterial const* material) noexcept;
+
     filaflat::ShaderBuilder& getVertexShaderBuilder() noexcept {
         return mVertexShaderBuilder;
     }
@@ -343,15 +427,44 @@ public:
         return mDebugRegistry;
     }
 
+    /*
+     * Cross-view shadow map sharing: when several views render the same scene with the
+     * same dominant light and end up with an identical shadow camera, the first view's
+     * rendered shadow map is valid for all of them, and the others simply bind its
+     * texture instead of rendering their own (see FView::prepareShadowing()).
+     */
+    struct SharedShadowKey {
+        FLightManager::Instance light;
+        FScene const* scene = nullptr;
+        math::mat4f lightSpace;
+        uint32_t dimension = 0;
+    };
+
+    // Returns another view's shadow map registered with an identical key, or null.
+    ShadowMap* findSharedShadowMap(
+            SharedShadowKey const& key, ShadowMap const* self) noexcept;
+
+    // Registers owner as holding (or about to hold) content for key.
+    void updateSharedShadowMap(ShadowMap* owner, SharedShadowKey const& key) noexcept;
+
+    // Forgets owner's entry; called when a shadow map is terminated.
+    void releaseSharedShadowMap(ShadowMap const* owner) noexcept;
+
     bool execute();
 
 private:
     FEngine(Backend backend, Platform* platform, void* sharedGLContext);
     void init();
+    void completeInit() noexcept;
 
     int loop();
     void flushCommandBuffer(CommandBufferQueue& commandBufferQueue);
 
+    // Executes pending background resource commands on the driver thread. When a frame
+    // is in flight the work is bounded by the time slice published by the renderer;
+    // otherwise (the engine is idle or shutting down) everything pending is drained.
+    void executeResourceCommands(bool frameActive) noexcept;
+
     template<typename T, typename L>
     void terminateAndDestroy(const T* p, ResourceList<T, L>& list);
 
@@ -361,6 +474,8 @@ private:
     Handle<HwProgram> createPostProcessProgram(filaflat::MaterialParser& parser,
             driver::ShaderModel model, PostProcessStage stage) const noexcept;
 
+    void buildDeferredPrograms() noexcept;
+
     Driver* mDriver = nullptr;
 
     Backend mBackend;
@@ -373,6 +488,7 @@ private:
 
     PostProcessManager mPostProcessManager;
     RenderTargetPool mRenderTargetPool;
+    TextureArrayPacker mTextureArrayPacker;
 
     utils::EntityManager& mEntityManager;
     FRenderableManager mRenderableManager;
@@ -383,7 +499,9 @@ private:
     ResourceList<FRenderer> mRenderers{ "Renderer" };
     ResourceList<FView> mViews{ "View" };
     ResourceList<FScene> mScenes{ "Scene" };
-    ResourceList<FFence, utils::LockingPolicy::SpinLock> mFences{"Fence"};
+    // fences are created/destroyed from any thread; the insert/remove critical
+    // sections are tiny, so spin briefly before parking (see utils::AdaptiveMutex)
+    ResourceList<FFence, utils::AdaptiveMutex> mFences{"Fence"};
     ResourceList<FSwapChain> mSwapChains{ "SwapChain" };
     ResourceList<FStream> mStreams{ "Stream" };
     ResourceList<FIndexBuffer> mIndexBuffers{ "IndexBuffer" };
@@ -395,10 +513,36 @@ private:
 
     mutable uint32_t mMaterialId = 0;
 
+    // see setFrameLatency()
+    size_t mFrameLatency = 2;
+
+    // GPU memory accounting, see trackGpuMemory()
+    size_t mGpuMemoryUsage[size_t(GpuMemoryPool::COUNT)] = {};
+    size_t mMemoryBudget = 0;
+    Engine::MemoryPressureCallback mMemoryPressureCallback = nullptr;
+    void* mMemoryPressureUser = nullptr;
+    bool mInMemoryPressureCallback = false;
+
+    // free buffers of the upload arena, keyed on capacity (see uploadAlloc). The callbacks
+    // that return buffers run on the main thread, but acquisition can come from loader
+    // threads, hence the lock.
+    utils::Mutex mUploadPoolLock;
+    std::multimap<size_t, void*> mUploadPool;
+    size_t mUploadPoolSize = 0;
+
+    // how many bytes of free upload buffers we keep around for reuse
+    static constexpr size_t CONFIG_UPLOAD_POOL_SIZE = 32 * 1024 * 1024;
+
     // FMaterialInstance are handled directly by FMaterial
     std::unordered_map<const FMaterial*, ResourceList<FMaterialInstance>> mMaterialInstances;
 
+    // registry of deduplicated vertex buffers (see VertexBuffer::Builder::dedupe()):
+    // content+declaration hash to the shared driver handle and its refcount
+    VertexBufferDedupRegistry mVertexBufferDedupRegistry;
+
     std::unique_ptr<DFG> mDFG;
+    bool mInitCompleted = false;
+    utils::JobSystem::Job* mDeferredInitJob = nullptr;
 
     // Per-view Uniform interface block
     UniformInterfaceBlock mPerViewUib;
@@ -417,6 +561,15 @@ private:
     CommandBufferQueue mCommandBufferQueue;
     DriverApi mCommandStream;
 
+    // background queue for resource creation/upload commands (see
+    // setAsyncResourceLoadingEnabled())
+    CommandBufferQueue mResourceQueue;
+    DriverApi mResourceStream;
+    // resource slices handed out by the queue but not executed yet; driver thread only
+    std::vector<CommandBufferQueue::Slice> mPendingResourceBuffers;
+    std::atomic<int64_t> mResourceTimeSliceNs = { 2000000 };  // 2ms, until measured
+    bool mAsyncResourceLoading = false;
+
     LinearAllocatorArena mPerRenderPassAllocator;
     HeapAllocatorArena mHeapAllocator;
 
@@ -439,17 +592,51 @@ private:
     filaflat::ShaderBuilder mFragmentShaderBuilder;
     FDebugRegistry mDebugRegistry;
 
+    // see findSharedShadowMap(); at most one entry per view, linear search is fine
+    std::vector<std::pair<ShadowMap*, SharedShadowKey>> mSharedShadowMaps;
+
+    // program builds deferred because the per-frame budget was exhausted. Written from
+    // job threads during command generation, drained in prepare().
+    utils::LockingPolicy::SpinLock mDeferredProgramBuildsLock;
+    std::vector<std::pair<FMaterial const*, uint8_t>> mDeferredProgramBuilds;
+    std::atomic<uint32_t> mProgramBuildsThisFrame = { 0 };
+
 public:
     // these are the debug properties used by FDebug. They're accessed directly by modules who need them.
     struct {
         struct {
             bool far_uses_shadowcasters = true;
             bool focus_shadowcasters = true;
+            bool visible_depth_range = true;
             bool lispsm = true;
             float dzn = -1.0f;
             float dzf =  1.0f;
         } shadowmap;
+        struct {
+            // bitmask of the material variants requested so far, one bit per variant key.
+            // can be saved as an allowlist manifest for matc --variant-allowlist.
+            int used = 0;
+        } variants;
+        struct {
+            // when true, tone-mapping + OECF are baked into a LUT and the per-pixel
+            // path becomes a single texture fetch (see PostProcessManager)
+            bool tonemap_lut = false;
+            // when true, a GPU luminance pyramid drives the exposure of the tone-mapping
+            // stage, with no CPU readback (see PostProcessManager::autoExposure())
+            bool auto_exposure = false;
+        } postprocess;
     } debug;
+
+    // Event counters registered with DebugRegistry. Incremented from hot paths with
+    // relaxed atomics and snapshotted once per frame (see FRenderer::endFrame()).
+    struct {
+        std::atomic<uint64_t> drawCalls{};          // draw calls issued to the driver
+        std::atomic<uint64_t> instancedDraws{};     // commands folded into instanced draws
+        std::atomic<uint64_t> rtPoolHits{};         // render targets served from the pool
+        std::atomic<uint64_t> rtPoolMisses{};       // render targets created on pool miss
+        std::atomic<uint64_t> gpuBusyNs{};          // GPU busy time (see utils::GpuCounters)
+        std::atomic<uint64_t> gpuMemoryBytes{};     // GPU memory-bus traffic estimate
+    } counters;
 };
 
 FILAMENT_UPCAST(Engine)
@@ -25,6 +25,7 @@
 
 #include <utils/compiler.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 
@@ -35,7 +36,7 @@ class FEngine;
 
 class FFence : public Fence {
 public:
-    FFence(FEngine& engine, Type type);
+    FFence(FEngine& engine, Type type, bool onResourceStream = false);
 
     void terminate(FEngine& engine) noexcept;
 
@@ -44,24 +45,30 @@ public:
     static FenceStatus waitAndDestroy(FFence* fence, Mode mode) noexcept;
 
 private:
-    // We assume we don't have a lot of contention of fence and have all of them
-    // share a single lock/condition
+    // Fallback for platforms without a futex syscall: we assume we don't have a lot of
+    // contention of fence and have all of them share a single lock/condition. On Linux
+    // the waiters sleep directly on the fence's state word instead (see Fence.cpp), so
+    // signaling a fence is a single store + wake with no lock involved.
     static std::mutex sLock;
     static std::condition_variable sCondition;
 
     struct FenceSignal {
         FenceSignal(Type type) noexcept : mType(type) { }
-        enum State : uint8_t { UNSIGNALED, SIGNALED, DESTROYED };
+        // 32-bit because this is the word the futex waits on
+        enum State : uint32_t { UNSIGNALED, SIGNALED, DESTROYED };
         // we store mType here instead of in FFence, because it allows sizeof(FFence) to be
         // much smaller (since it needs to be multiple of 8 on 64 bits architectures)
         const Type mType;
-        State mState = UNSIGNALED;
+        std::atomic<uint32_t> mState = { UNSIGNALED };
         void signal(State s = SIGNALED) noexcept;
         FenceStatus wait(uint64_t timeout) noexcept;
     };
 
     FEngine& mEngine;
     Handle<HwFence> mFenceHandle;
+    // whether the signal command was recorded on the engine's background resource
+    // stream (see FEngine::createResourceFence())
+    const bool mOnResourceStream;
     // TODO: use custom allocator for these small objects
     std::shared_ptr<FenceSignal> mFenceSignal;
 };
@@ -33,7 +33,17 @@ public:
 
     void endFrame() noexcept;
 
-    bool skipFrameNeeded() const noexcept;
+    // Returns whether the current frame should be skipped because the GPU has fallen
+    // too far behind. When deadlineNs is non-zero (a std::chrono::steady_clock time,
+    // typically a fraction of the refresh interval past the vsync), the GPU is given
+    // until then to catch up before the frame is skipped; with 0 the decision is
+    // made immediately.
+    bool skipFrameNeeded(int64_t deadlineNs = 0) const noexcept;
+
+    // Changes how many frames the GPU may fall behind before frames get skipped. Growing
+    // takes effect immediately; shrinking stops waiting on the oldest fences, so the
+    // tighter latency is enforced starting with the next frame.
+    void setLatency(size_t latency) noexcept;
 
 private:
     FEngine& mEngine;
@@ -29,8 +29,11 @@
 
 #include <utils/compiler.h>
 #include <utils/bitset.h>
+#include <utils/Hash.h>
 #include <utils/Slice.h>
 
+#include <tsl/robin_map.h>
+
 #include <math/mat4.h>
 #include <math/vec4.h>
 
@@ -98,6 +101,12 @@ public:
 
     void setOptions(float zLightNear, float zLightFar) noexcept;
 
+    // Sets the exponent shaping the z-slice distribution (see View::setFroxelDepthDistribution).
+    // 1.0 is the default exponential distribution; larger values concentrate the slices away
+    // from the camera. Only the derived constants (slice boundaries, bounding spheres, shader
+    // parameters) are recomputed, the froxel layout is unchanged.
+    void setDepthDistribution(float power) noexcept;
+
     /*
      * Allocate per-frame data structures for froxelization.
      *
@@ -125,6 +134,7 @@ public:
 
     void updateUniforms(UniformBuffer& u) {
         u.setUniform(offsetof(FEngine::PerViewUib, zParams), mParamsZ);
+        u.setUniform(offsetof(FEngine::PerViewUib, froxelCurve), mParamsCurve);
         u.setUniform(offsetof(FEngine::PerViewUib, fParams), mParamsF.yz);
         u.setUniform(offsetof(FEngine::PerViewUib, fParamsX), mParamsF.x);
         u.setUniform(offsetof(FEngine::PerViewUib, oneOverFroxelDimensionX), mOneOverDimension.x);
@@ -202,7 +212,12 @@ private:
     void froxelizeLoop(FEngine& engine,
             const CameraInfo& camera, const FScene::LightSoa& lightData) noexcept;
 
-    void froxelizeAssignRecordsCompress() noexcept;
+    // signature of the inputs froxelization depends on (camera transform and light
+    // shapes), used to skip re-froxelization entirely when nothing changed
+    uint32_t computeFroxelizeInputsHash(FEngine& engine,
+            const CameraInfo& camera, const FScene::LightSoa& lightData) const noexcept;
+
+    void froxelizeAssignRecordsCompress(utils::JobSystem& js) noexcept;
 
     void froxelizePointAndSpotLight(FroxelThreadData& froxelThread, size_t bit,
             math::mat4f const& projection, const LightParams& light) const noexcept;
@@ -253,19 +268,47 @@ private:
     GPUBuffer mRecordsBuffer;
     GPUBuffer mFroxelBuffer;
 
+    // shadow copies of the data committed to the GPU buffers; needed to compute the
+    // dirty row ranges (the user buffers live in the per-frame arena)
+    std::vector<FroxelEntry> mFroxelShadow;
+    std::vector<RecordBufferType> mRecordsShadow;
+
+    // palette of the record runs written this frame, keyed by the froxel's light list:
+    // froxels with identical lists (e.g. all froxels inside the same room) share a single
+    // run in the record buffer (see froxelizeAssignRecordsCompress()). The value is the
+    // packed FroxelEntry (offset + light counts) of the first occurrence.
+    struct LightRecordHasher {
+        size_t operator()(LightRecord::bitset const& b) const noexcept {
+            return utils::hash::murmur3(
+                    reinterpret_cast<uint32_t const*>(&b), sizeof(b) / 4, 0);
+        }
+    };
+    tsl::robin_map<LightRecord::bitset, uint32_t, LightRecordHasher> mRecordPalette;
+
+    // see computeFroxelizeInputsHash(). 0 means "unknown", never skip.
+    uint32_t mFroxelizeInputsHash = 0;
+
     // needed for update()
     Viewport mViewport;
     math::float4 mParamsZ = {};
+    // z-slice distribution curve handed to the shader:
+    // x = 1/power, y = 1/(sliceCount-1), z = sliceCount-1, w = unused
+    math::float4 mParamsCurve = { 1.0f, 0.0f, 0.0f, 0.0f };
     math::uint3 mParamsF = {};
     float mNear = 0.0f;        // camera near
     float mZLightFar = FEngine::CONFIG_Z_LIGHT_FAR;
     float mZLightNear = FEngine::CONFIG_Z_LIGHT_NEAR;  // light near (first slice)
+    float mDistributionPower = 1.0f;    // see setDepthDistribution()
+    float mOneOverPower = 1.0f;
 
     // track if we need to update our internal state before froxelizing
     uint8_t mDirtyFlags = 0;
     enum {
         VIEWPORT_CHANGED = 0x01,
-        PROJECTION_CHANGED = 0x02
+        PROJECTION_CHANGED = 0x02,
+        // the z-slice distribution changed: only the derived constants need
+        // recomputing, not the froxel layout (see update())
+        DISTRIBUTION_CHANGED = 0x04
     };
 };
 
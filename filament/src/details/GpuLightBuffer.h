@@ -53,18 +53,24 @@ public:
     LightParameters& getLightParameters(LightIndex h) noexcept {
         // This assumes the layout of the LightsUniforms uniform buffer
         // it is defined in UibGenerator.cpp
-        LightParameters* lights = (LightParameters *)mLightsUb.getBuffer();
+        LightParameters* lights = (LightParameters *)mLightsUb[mCurrentBuffer].getBuffer();
         return lights[h];
     }
 
     void invalidate(LightIndex h, size_t count) noexcept {
-        mLightsUb.invalidateUniforms(h * sizeof(LightParameters), count * sizeof(LightParameters));
+        mLightsUb[mCurrentBuffer].invalidateUniforms(
+                h * sizeof(LightParameters), count * sizeof(LightParameters));
     }
 
 private:
     void commitSlow(FEngine& engine) noexcept;
     Handle<HwUniformBuffer> mLightUbh;
-    mutable UniformBuffer mLightsUb;
+    // Double-buffered CPU staging for the lights UBO. The buffer most recently committed
+    // is owned by the command stream -- the driver thread reads from it directly and
+    // returns its (pooled) allocation when done -- while the next frame's lights are
+    // written into the other one. This avoids copying the whole lights UBO every frame.
+    UniformBuffer mLightsUb[2];
+    uint32_t mCurrentBuffer = 0;
 };
 
 } // namespace details
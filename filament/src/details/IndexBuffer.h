@@ -41,6 +41,9 @@ public:
 
     size_t getIndexCount() const noexcept { return mIndexCount; }
 
+    // GPU memory used by the backing buffer (used for the engine's memory accounting)
+    size_t getEstimatedSize() const noexcept { return mIndexCount * mElementSize; }
+
     void setBuffer(FEngine& engine,
             BufferDescriptor&& buffer, uint32_t byteOffset = 0, uint32_t byteSize = 0);
 
@@ -48,6 +51,10 @@ private:
     friend class IndexBuffer;
     Handle<HwIndexBuffer> mHandle;
     uint32_t mIndexCount;
+    uint8_t mElementSize;
+    // whether our driver commands are recorded on the engine's background resource
+    // stream (captured at creation, see FEngine::setAsyncResourceLoadingEnabled())
+    bool mUsesResourceStream = false;
 };
 
 FILAMENT_UPCAST(IndexBuffer)
@@ -47,6 +47,8 @@ public:
     void setIntensity(float intensity) noexcept { mIntensity = intensity; }
     void setRotation(math::mat3f const& rotation) noexcept { mRotation = rotation; }
     const math::mat3f& getRotation() const { return mRotation; }
+    void setProbeVolume(Box const& aabb) noexcept { mProbeVolume = aabb; }
+    Box const& getProbeVolume() const noexcept { return mProbeVolume; }
 
 private:
     Handle<HwTexture> mReflectionsMapHandle;
@@ -54,6 +56,7 @@ private:
     std::array<math::float3, 9> mIrradianceCoefs;
     float mIntensity = DEFAULT_INTENSITY;
     math::mat3f mRotation;
+    Box mProbeVolume = {};  // empty = environment at infinity
 };
 
 FILAMENT_UPCAST(IndirectLight)
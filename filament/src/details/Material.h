@@ -29,6 +29,8 @@
 
 #include <utils/compiler.h>
 
+#include <memory>
+
 
 namespace filaflat {
     class MaterialParser;
@@ -68,11 +70,26 @@ public:
 
     bool hasParameter(const char* name) const noexcept;
 
+    // a parameter handle is the parameter's byte offset in the uniform buffer
+    int32_t getParameterHandle(const char* name) const noexcept {
+        return int32_t(mUniformInterfaceBlock.getUniformOffset(name, 0));
+    }
+
     FMaterialInstance const* getDefaultInstance() const noexcept { return &mDefaultInstance; }
     FMaterialInstance* getDefaultInstance() noexcept { return &mDefaultInstance; }
 
     FEngine& getEngine() const noexcept  { return mEngine; }
 
+    // whether the program for this variant has actually been built -- getProgram() may
+    // return a placeholder program when this returns false (see getProgramSlow())
+    bool isProgramCached(uint8_t variantKey) const noexcept {
+        return bool(mCachedPrograms[variantKey]);
+    }
+
+    // builds the program for the given variant and caches it. Called from getProgramSlow()
+    // or from FEngine::prepare() for builds that were deferred by the per-frame budget.
+    Handle<HwProgram> buildProgram(uint8_t variantKey) const noexcept;
+
     Handle<HwProgram> getProgramSlow(uint8_t variantKey) const noexcept;
     Handle<HwProgram> getProgram(uint8_t variantKey) const noexcept {
 
@@ -85,6 +102,19 @@ public:
 
     bool isVariantLit() const noexcept { return mIsVariantLit; }
 
+    // variant filtering resolved to a single indexed load; the table is precomputed
+    // at creation time (see the ctor), replacing Variant::filterVariant() in hot loops
+    uint8_t getFilteredVariant(uint8_t variantKey) const noexcept {
+        return mFilteredVariants[variantKey & (VARIANT_COUNT - 1)];
+    }
+
+    // set of variants whose shaders are present in the package, from matc
+    // (reconstructed from the shading mode for older packages)
+    uint16_t getSupportedVariants() const noexcept { return mSupportedVariants; }
+
+    // builds the programs for all supported variants now (see Material::compile())
+    void compile() const noexcept;
+
     const utils::CString& getName() const noexcept { return mName; }
     Driver::RasterState getRasterState() const noexcept  { return mRasterState; }
     uint32_t getId() const noexcept { return mMaterialId; }
@@ -117,6 +147,8 @@ private:
     // try to order by frequency of use
     mutable std::array<Handle<HwProgram>, VARIANT_COUNT> mCachedPrograms;
     Driver::RasterState mRasterState;
+    uint8_t mFilteredVariants[VARIANT_COUNT] = {};
+    uint16_t mSupportedVariants = 0;
     Shading mShading;
     bool mIsVariantLit;
     BlendingMode mBlendingMode;
@@ -140,7 +172,12 @@ private:
     FEngine& mEngine;
     const uint32_t mMaterialId;
     mutable uint32_t mMaterialInstanceId = 0;
-    filaflat::MaterialParser* mMaterialParser = nullptr;
+    // The parsed material package. Except for the default material (parsed in place and
+    // owned outright), this aliases a process-wide refcounted core shared by all materials
+    // built from the same bytes -- typically by several engines -- so the package is
+    // copied and parsed once per backend. The programs built from it (mCachedPrograms
+    // above) stay per-engine, as driver handles can't cross engines.
+    std::shared_ptr<filaflat::MaterialParser> mMaterialParser;
 };
 
 
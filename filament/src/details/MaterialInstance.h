@@ -66,6 +66,12 @@ public:
     template <typename T>
     void setParameter(const char* name, const T* value, size_t count) noexcept;
 
+    template <typename T>
+    void setParameter(int32_t handle, T value) noexcept;
+
+    template <typename T>
+    void setParameter(int32_t handle, const T* value, size_t count) noexcept;
+
     void setParameter(const char* name,
             Texture const* texture, TextureSampler const& sampler) noexcept;
 
@@ -73,9 +79,19 @@ public:
 
     uint64_t getSortingKey() const noexcept { return mMaterialSortingKey; }
 
+    UniformBuffer const& getUniformBuffer() const noexcept { return mUniforms; }
+
+    Handle<HwUniformBuffer> getUniformBufferHandle() const noexcept { return mUbHandle; }
+
     SamplerBuffer const& getSamplerBuffer() const noexcept { return mSamplers; }
 
+    // Monotonically increased whenever any material instance's content changes.
+    // This is a coarse, process-wide change signal used by FView's frame cache to
+    // detect that some material parameter was touched since the last render.
+    static uint32_t getVersion() noexcept { return sVersion; }
+
     void setScissor(int32_t left, int32_t bottom, uint32_t width, uint32_t height) noexcept {
+        sVersion++;
         mScissorRect[0] = left;
         mScissorRect[1] = bottom;
         mScissorRect[2] = (int32_t)std::min(width,  (uint32_t)std::numeric_limits<int32_t>::max());
@@ -83,6 +99,7 @@ public:
     }
 
     void unsetScissor() noexcept {
+        sVersion++;
         mScissorRect[0] = mScissorRect[1] = 0;
         mScissorRect[2] = mScissorRect[3] = std::numeric_limits<int32_t>::max();
     }
@@ -96,6 +113,9 @@ private:
 
     void commitSlow(FEngine& engine) const;
 
+    // see getVersion(); like the rest of this API, not meant to be used concurrently
+    static uint32_t sVersion;
+
     // keep these grouped, they're accessed together in the render-loop
     FMaterial const* mMaterial = nullptr;
     Handle<HwUniformBuffer> mUbHandle;
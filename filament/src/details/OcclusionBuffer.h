@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_OCCLUSIONBUFFER_H
+#define TNT_FILAMENT_DETAILS_OCCLUSIONBUFFER_H
+
+#include <utils/compiler.h>
+
+#include <math/mat4.h>
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace utils {
+class JobSystem;
+} // namespace utils
+
+namespace filament {
+namespace details {
+
+/*
+ * A low-resolution depth buffer rasterized on the CPU from designated occluder geometry.
+ * FView uses it after frustum culling to clear the visibility bit of renderables whose
+ * bounding box is entirely behind the occluders, before any command generation happens.
+ *
+ * Each pixel stores the nearest occluder's reciprocal clip-space w (0 meaning "no occluder"),
+ * which interpolates linearly in screen space. Depth is sampled at pixel centers, so
+ * occluder meshes should be conservative proxies contained within the geometry they
+ * stand for.
+ */
+class OcclusionBuffer {
+public:
+    static constexpr uint32_t WIDTH  = 256;
+    static constexpr uint32_t HEIGHT = 128;
+
+    // scanlines rasterized by a single job; a band is only ever written by its own job,
+    // so the rasterizer needs no synchronization
+    static constexpr uint32_t BAND_HEIGHT = 16;
+
+    OcclusionBuffer();
+    ~OcclusionBuffer() noexcept;
+
+    // Transforms, near-clips and rasterizes the given world-space triangle list into the
+    // depth buffer, replacing its previous content. indexCount must be a multiple of 3.
+    void rasterize(utils::JobSystem& js, math::mat4f const& viewProjection,
+            math::float3 const* vertices, uint32_t const* indices, size_t indexCount) noexcept;
+
+    // Returns whether a world-space AABB is entirely hidden by the rasterized occluders.
+    bool isOccluded(math::float3 const& center, math::float3 const& extent) const noexcept;
+
+    // Clears `bit` in visibleArray[] for every AABB hidden by the rasterized occluders.
+    void cullOccluded(uint8_t* UTILS_RESTRICT visibleArray,
+            math::float3 const* UTILS_RESTRICT center,
+            math::float3 const* UTILS_RESTRICT extent,
+            size_t count, size_t bit) const noexcept;
+
+private:
+    // a screen-space triangle after near-clipping and projection; z holds the reciprocal
+    // of clip-space w at each vertex
+    struct Triangle {
+        math::float2 p[3];
+        float z[3];
+        uint16_t ymin;      // first scanline covered
+        uint16_t ymax;      // one past the last scanline covered
+    };
+
+    void setupTriangles(math::float3 const* vertices,
+            uint32_t const* indices, size_t indexCount) noexcept;
+    void addTriangle(math::float4 const* clip) noexcept;
+    void rasterizeBand(uint32_t y0, uint32_t y1) noexcept;
+
+    std::vector<Triangle> mTriangles;
+    std::vector<float> mDepth;
+    math::mat4f mViewProjection;
+};
+
+} // namespace details
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_OCCLUSIONBUFFER_H
@@ -23,12 +23,17 @@
 
 #include "driver/Handle.h"
 
+#include <private/filament/Variant.h>
+
+#include <math/vec4.h>
+
 #include <utils/compiler.h>
 
 namespace filament {
 namespace details {
 
 class FEngine;
+class FMaterial;
 class FVertexBuffer;
 class FIndexBuffer;
 class FRenderer;
@@ -55,14 +60,57 @@ public:
     AttributeBitset getEnabledAttributes() const noexcept { return mEnabledAttributes; }
     uint16_t getBlendOrder() const noexcept { return mBlendOrder; }
 
-    void setMaterialInstance(FMaterialInstance const* mi) noexcept { mMaterialInstance = mi; }
+    // Object-space culling proxy (see RenderableManager::Builder::bounds()): bounding
+    // sphere of the primitive's geometry (xyz center, w radius) and normal cone
+    // (xyz axis, w = sine of the half-angle). Command generation cancels the primitive
+    // when all of its triangles face away from the viewpoint; a cutoff >= 1 can never
+    // cull, so primitives without cooked bounds just take the default.
+    bool hasCullingCone() const noexcept { return mNormalCone.w < 1.0f; }
+    math::float4 getBoundingSphere() const noexcept { return mBoundingSphere; }
+    math::float4 getNormalCone() const noexcept { return mNormalCone; }
+
+    void setMaterialInstance(FMaterialInstance const* mi) noexcept {
+        mMaterialInstance = mi;
+        // the program depends on the material, invalidate the cached handles
+        mCachedPrograms[0].variantKey = INVALID_VARIANT_KEY;
+        mCachedPrograms[1].variantKey = INVALID_VARIANT_KEY;
+    }
+
     void setBlendOrder(uint16_t order) noexcept {
         mBlendOrder = static_cast<uint16_t>(order & 0x7FFF);
     }
 
+    // Returns the program to use for this primitive with the given material and (filtered)
+    // variant. The resolved handle is cached here and re-resolved only when the variant key
+    // changes, so steady-state frames don't touch the material's program cache at all.
+    Handle<HwProgram> getProgram(FMaterial const* ma, Variant variant) const noexcept {
+        ProgramCacheEntry& entry = mCachedPrograms[variant.isDepthPass()];
+        if (UTILS_LIKELY(entry.variantKey == variant.key)) {
+            return entry.handle;
+        }
+        return getProgramSlow(ma, variant);
+    }
+
 private:
+    struct ProgramCacheEntry {
+        Handle<HwProgram> handle;
+        uint8_t variantKey = INVALID_VARIANT_KEY;
+    };
+
+    // forces a resolution on first use (real variant keys are 5 bits)
+    static constexpr uint8_t INVALID_VARIANT_KEY = 0xff;
+
+    Handle<HwProgram> getProgramSlow(FMaterial const* ma, Variant variant) const noexcept;
+
     FMaterialInstance const* mMaterialInstance = nullptr;
     Handle<HwRenderPrimitive> mHandle;
+    // one entry for the color variant, one for the depth variant. mutable because this is
+    // just a cache and command generation is const on the primitive. Command generation is
+    // parallelized, but each primitive is only ever visited by a single job (the slices are
+    // disjoint), so this doesn't race.
+    mutable ProgramCacheEntry mCachedPrograms[2];
+    math::float4 mBoundingSphere = {};
+    math::float4 mNormalCone = { 0.0f, 0.0f, 0.0f, 1.0f };
     driver::PrimitiveType mPrimitiveType = driver::PrimitiveType::NONE;
     AttributeBitset mEnabledAttributes;
     uint16_t mBlendOrder = 0;
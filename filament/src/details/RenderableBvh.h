@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_RENDERABLEBVH_H
+#define TNT_FILAMENT_DETAILS_RENDERABLEBVH_H
+
+#include "details/Culler.h"
+
+#include <filament/Frustum.h>
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+namespace details {
+
+/*
+ * A binary BVH over the scene's renderable bounds, used by FView to cull whole
+ * subtrees instead of testing every object against the frustum. Only large scenes
+ * benefit -- with a few thousand objects the flat vectorized Culler path is faster
+ * than any hierarchy -- so FScene only maintains one past MIN_RENDERABLE_COUNT.
+ *
+ * The topology (a median split over the AABB centers) captures a permutation of
+ * the renderable SoA rows, so it is only valid for the row order it was built
+ * against; FScene rebuilds it whenever that order changes (it tracks the scene's
+ * row-order version). Leaves cover LEAF_COUNT renderables and are tested with the
+ * vectorized Culler, so the hierarchy only pays for itself on the subtrees it
+ * rejects.
+ */
+class RenderableBvh {
+public:
+    // below this many renderables the flat culling path wins
+    static constexpr uint32_t MIN_RENDERABLE_COUNT = 1024;
+
+    // renderables per leaf; a multiple of Culler::MODULO, large enough to amortize
+    // the per-node frustum test over a vectorized batch
+    static constexpr uint32_t LEAF_COUNT = 64;
+
+    // rebuilds the hierarchy from scratch (new topology and bounds)
+    void build(math::float3 const* UTILS_RESTRICT center,
+            math::float3 const* UTILS_RESTRICT extent, uint32_t count);
+
+    // ORs (1 << bit) into visibleArray for each renderable intersecting the frustum,
+    // just like Culler::intersects() on the flat array would
+    void cull(Frustum const& frustum, Culler::result_type* UTILS_RESTRICT visibleArray,
+            size_t bit) noexcept;
+
+    void clear() noexcept;
+
+    bool empty() const noexcept { return mNodes.empty(); }
+
+    // number of renderables covered, 0 when empty
+    uint32_t size() const noexcept { return mCount; }
+
+private:
+    struct Node {
+        math::float3 center;        // world-space bounds of the subtree
+        math::float3 halfExtent;
+        uint32_t left;              // children indices; the right child does not follow the
+        uint32_t right;             // left one (depth-first layout), 0 for leaves
+        uint32_t first;             // first covered entry in mOrder
+        uint32_t count;             // number of covered entries
+    };
+
+    uint32_t buildNode(math::float3 const* center, uint32_t first, uint32_t count);
+
+    // recomputes all node bounds bottom-up, keeping the topology; build() uses it
+    // for the initial bounds pass
+    void refit(math::float3 const* UTILS_RESTRICT center,
+            math::float3 const* UTILS_RESTRICT extent) noexcept;
+
+    std::vector<Node> mNodes;           // [0] is the root; children follow their parent
+    std::vector<uint32_t> mOrder;       // permutation: BVH order -> SoA index
+    std::vector<math::float3> mSortedCenters;   // renderable bounds in BVH order,
+    std::vector<math::float3> mSortedExtents;   // padded for the vectorized Culler
+    std::vector<Culler::result_type> mResults;  // culling scratch, in BVH order
+    uint32_t mCount = 0;
+};
+
+} // namespace details
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_RENDERABLEBVH_H
@@ -36,6 +36,8 @@
 #include <utils/Allocator.h>
 #include <utils/Slice.h>
 
+#include <atomic>
+
 namespace filament {
 
 class Driver;
@@ -61,17 +63,26 @@ public:
 
     // do all the work here!
     void render(FView const* view);
+    void render(View const* const* views, size_t viewCount);
     void renderJob(ArenaScope& arena, FView* view);
 
     void mirrorFrame(FSwapChain* dstSwapChain, Viewport const& dstViewport, Viewport const& srcViewport,
                      MirrorFrameFlag flags);
 
-    bool beginFrame(FSwapChain* swapChain);
+    bool beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano = 0);
     void endFrame();
 
     void readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             driver::PixelBufferDescriptor&& buffer);
 
+    // GPU time spent in each pass, measured with the timer queries (see the public
+    // GpuPassTimings for the semantics)
+    GpuPassTimings getGpuPassTimings() const noexcept;
+
+    // drains the per-frame telemetry ring (see the public FrameRecord); single
+    // consumer, callable from any thread
+    size_t drainFrameRecords(FrameRecord* records, size_t count) noexcept;
+
     // Clean-up everything, this is typically called when the client calls Engine::destroyRenderer()
     void terminate(FEngine& engine);
 
@@ -85,8 +96,12 @@ private:
         utils::JobSystem::Job* jobFroxelize = nullptr;
         FView* const view;
         Handle<HwRenderTarget> const rth;
+        bool const splitBlendedPass;
         void beginRenderPass(driver::DriverApi& driver, Viewport const& viewport, const CameraInfo& camera) noexcept override;
         void endRenderPass(DriverApi& driver, Viewport const& viewport) noexcept override;
+        bool separateBlendedCommands() const noexcept override;
+        void renderBlendedCommands(FEngine& engine, driver::DriverApi& driver,
+                Viewport const& viewport, utils::Slice<Command> const& commands) noexcept override;
     public:
         ColorPass(const char* name, utils::JobSystem& js, utils::JobSystem::Job* jobFroxelize,
                 FView* view, Handle<HwRenderTarget> rth);
@@ -120,11 +135,7 @@ private:
         return mCommandsHighWatermark * sizeof(RenderPass::Command);
     }
 
-    driver::TextureFormat getHdrFormat() const noexcept {
-        const bool translucent = mSwapChain->isTransparent();
-        return (translucent || !mIsRGB16FSupported) ? driver::TextureFormat::RGBA16F
-                                                    : driver::TextureFormat::RGB16F;
-    }
+    driver::TextureFormat getHdrFormat(FView const& view) const noexcept;
 
     driver::TextureFormat getLdrFormat() const noexcept {
         const bool translucent = mSwapChain->isTransparent();
@@ -136,16 +147,42 @@ private:
     FEngine& mEngine;
     FrameSkipper mFrameSkipper;
     Handle<HwRenderTarget> mRenderTarget;
+
+    // GPU timer queries used to attribute frame time to the main passes (see renderJob())
+    Handle<HwTimerQuery> mShadowPassQuery;
+    Handle<HwTimerQuery> mColorPassQuery;
+    Handle<HwTimerQuery> mPostProcessQuery;
     FSwapChain* mSwapChain = nullptr;
     size_t mCommandsHighWatermark = 0;
     uint32_t mFrameId = 0;
+    // vsync pacing (see beginFrame()): last timestamp handed in by the application's
+    // vsync source and the display period estimated from successive timestamps
+    uint64_t mLastVsyncTimestamp = 0;
+    uint64_t mVsyncPeriodNs = 16666667;
+    // GPU busy time over the last frame interval, from the kernel's GPU counters
+    // where exposed (see endFrame()); 0 on platforms without them
+    uint64_t mGpuBusyNs = 0;
     FrameInfoManager mFrameInfoManager;
     bool mIsRGB16FSupported : 1;
     bool mIsRGB8Supported : 1;
+    bool mIsRG11B10FSupported : 1;
+    bool mIsInTileResolveSupported : 1;
 
     // per-frame arena for this Renderer
     LinearAllocatorArena& mPerRenderPassArena;
 
+    // Telemetry history: a single-producer (render thread, see endFrame()) single-
+    // consumer (the application's telemetry thread, see drainFrameRecords()) ring of
+    // the last frames' records. When full -- i.e. nobody is draining -- new records
+    // are simply dropped, so recording stays allocation- and wait-free.
+    static constexpr uint32_t FRAME_RECORD_COUNT = 32;    // power-of-two
+    FrameRecord mFrameRecords[FRAME_RECORD_COUNT];
+    std::atomic<uint32_t> mFrameRecordHead = { 0 };       // written by the render thread
+    std::atomic<uint32_t> mFrameRecordTail = { 0 };       // written by the consumer
+    // previous values of the engine-wide counters, to turn them into per-frame deltas
+    uint64_t mLastDrawCalls = 0;
+    uint64_t mLastInstancedDraws = 0;
+
 #if EXTRA_TIMING_INFO
     Series<float> mRendering;
     Series<float> mPostProcess;
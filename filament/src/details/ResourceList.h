@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <mutex>
+#include <vector>
 
 namespace filament {
 namespace details {
@@ -70,6 +71,13 @@ public:
         return std::move(mList);
     }
 
+    UTILS_NOINLINE
+    std::vector<void*> getSlabAndClear() noexcept {
+        std::vector<void*> slab(mList.begin(), mList.end());
+        mList.clear();
+        return slab;
+    }
+
     using iterator = typename tsl::robin_set<void*>::iterator;
 
     iterator begin() noexcept {
@@ -126,6 +134,15 @@ public:
         return std::move(reinterpret_cast<tsl::robin_set<T*>&>(list));
     }
 
+    // Returns the content laid out in a contiguous slab and clears the list. Used at
+    // shutdown, where batched destruction matters (see FEngine::cleanupResourceList()).
+    std::vector<T*> getSlabAndClear() noexcept {
+        std::lock_guard<LockingPolicy> guard(mLock);
+        std::vector<void*> slab(ResourceListBase::getSlabAndClear());
+        // this is pretty ugly, but this avoids a copy
+        return std::move(reinterpret_cast<std::vector<T*>&>(slab));
+    }
+
     /*
      * the methods below are only safe when LockingPolicy is NoLock, so disable them
      * otherwise
@@ -24,12 +24,15 @@
 
 #include "details/Culler.h"
 #include "details/GpuLightBuffer.h"
+#include "details/RenderableBvh.h"
 
 #include "Allocators.h"
 
 #include <filament/Box.h>
 #include <filament/Scene.h>
 
+#include <math/scalar.h>
+
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/Slice.h>
@@ -37,8 +40,13 @@
 #include <utils/Range.h>
 
 #include <cstddef>
+#include <vector>
 #include <tsl/robin_set.h>
 
+namespace utils {
+class JobSystem;
+}
+
 namespace filament {
 namespace details {
 
@@ -63,8 +71,21 @@ public:
     void setIndirectLight(FIndirectLight const* ibl) noexcept { mIndirectLight = ibl; }
     FIndirectLight const* getIndirectLight() const noexcept { return mIndirectLight; }
 
+    void setIndirectLightBlend(FIndirectLight const* ibl, float blend) noexcept {
+        mBlendIndirectLight = ibl;
+        mIndirectLightBlend = math::clamp(blend, 0.0f, 1.0f);
+    }
+    FIndirectLight const* getBlendIndirectLight() const noexcept { return mBlendIndirectLight; }
+    float getIndirectLightBlend() const noexcept { return mIndirectLightBlend; }
+
     void addEntity(utils::Entity entity);
+    void addEntities(const utils::Entity* entities, size_t count);
     void remove(utils::Entity entity);
+    void removeEntities(const utils::Entity* entities, size_t count);
+
+    // monotonic counter bumped when entities are added or removed, used to detect
+    // that the scene's content is unchanged (e.g. by FView's visibility cache)
+    uint32_t getVersion() const noexcept { return mVersion; }
 
     size_t getRenderableCount() const noexcept;
     size_t getLightCount() const noexcept;
@@ -82,7 +103,7 @@ public:
     ~FScene() noexcept;
     void terminate(FEngine& engine);
 
-    void prepare(const math::mat4f& worldOriginTansform);
+    void prepare(utils::JobSystem& js, const math::mat4f& worldOriginTansform);
     void prepareDynamicLights(const CameraInfo& camera, ArenaScope& arena) noexcept;
     void computeBounds(Aabb& castersBox, Aabb& receiversBox, uint32_t visibleLayers) const noexcept;
 
@@ -90,11 +111,19 @@ public:
      * Storage for per-frame renderable data
      */
 
+    // Bit of VISIBLE_MASK set by FView when the renderable's GPU occlusion query
+    // reported zero samples last frame (see View::setGpuOcclusionQueriesEnabled()).
+    // Unlike the per-pass visibility bits (owned by View.cpp), command generation
+    // consults it too: it cancels the renderable's color commands while keeping its
+    // depth commands, so the query keeps being issued and the renderable can
+    // reappear when it gets disoccluded.
+    static constexpr uint8_t VISIBLE_MASK_GPU_OCCLUDED = 0x4;
+
     enum {
         RENDERABLE_INSTANCE,    //  4 instance of the Renderable component
         WORLD_TRANSFORM,        // 16 instance of the Transform component
-        VISIBILITY_STATE,       //  1 visibility data of the component
-        UBH,                    //  4 uniform buffer handle
+        VISIBILITY_STATE,       //  2 visibility data of the component
+        UBO_OFFSET,             //  4 offset of the block in the shared per-renderable UBO
         BONES_UBH,              //  4 bones uniform buffer handle
         WORLD_AABB_CENTER,      // 12 world-space bounding box center of the renderable
         VISIBLE_MASK,           //  1 each bit represents a visibility in a pass
@@ -112,7 +141,7 @@ public:
             utils::EntityInstance<RenderableManager>,
             math::mat4f,
             FRenderableManager::Visibility,
-            Handle<HwUniformBuffer>,
+            uint32_t,
             Handle<HwUniformBuffer>,
             math::float3,
             Culler::result_type,
@@ -125,6 +154,30 @@ public:
     RenderableSoa const& getRenderableData() const noexcept { return mRenderableData; }
     RenderableSoa& getRenderableData() noexcept { return mRenderableData; }
 
+    // Monotonic counter identifying the current row order of the renderable SoA.
+    // FView's visibility partition permutes the rows in place; anything that captures
+    // row indices or row-indexed data across frames (FView's visibility and
+    // shadow-caster caches, the BVH's leaf order) must include this counter in its
+    // validity signature, since a row index is only meaningful for the order it was
+    // captured under.
+    uint32_t getRenderableOrderVersion() const noexcept { return mRenderableOrderVersion; }
+    // called by FView when it permuted the renderable SoA rows
+    void bumpRenderableOrderVersion() noexcept { mRenderableOrderVersion++; }
+
+    // The renderable SoA rows are grouped by layer mask when prepare() rebuilds it, so
+    // a view whose visible layers select only some of the groups can restrict its
+    // per-row work (culling, visibility masks, partition) to the rows that can
+    // possibly match -- e.g. a UI view rendering 50 renderables of a 50k scene.
+    // Returns the row range to process; rows outside of it are guaranteed not to
+    // intersect visibleLayers. The caller is allowed to reorder rows within the
+    // returned range (FView's visibility partition does); the spanned groups are
+    // merged to keep the grouping valid for the next caller.
+    utils::Range<uint32_t> acquireLayerRestrictedRange(uint8_t visibleLayers) noexcept;
+
+    // BVH over the renderable bounds, empty for small scenes (see RenderableBvh);
+    // kept in sync with the renderable SoA by prepare()
+    RenderableBvh& getRenderableBvh() noexcept { return mRenderableBvh; }
+
     static inline uint32_t getPrimitiveCount(RenderableSoa const& soa,
             uint32_t first, uint32_t last) noexcept {
         // the caller must guarantee that last is dereferencable
@@ -163,6 +216,8 @@ public:
     void updateUBOs(utils::Range<uint32_t> visibleRenderables) const noexcept;
 
 private:
+    void updateRenderableBvh() noexcept;
+
     static inline void computeLightRanges(math::float2* zrange,
             CameraInfo const& camera, const math::float4* spheres, size_t count) noexcept;
 
@@ -172,6 +227,8 @@ private:
     FEngine& mEngine;
     FSkybox const* mSkybox = nullptr;
     FIndirectLight const* mIndirectLight = nullptr;
+    FIndirectLight const* mBlendIndirectLight = nullptr;
+    float mIndirectLightBlend = 0.0f;
     GpuLightBuffer mGpuLightData;
 
     // list of Entities in the scene. We use a robin_set<> so we can do efficient removes
@@ -180,6 +237,34 @@ private:
     tsl::robin_set<utils::Entity> mEntities;
     RenderableSoa mRenderableData;
     LightSoa mLightData;
+    uint32_t mVersion = 0;
+    uint32_t mRenderableOrderVersion = 0;
+
+    // BVH over the renderable bounds (see updateRenderableBvh()); its leaf order is
+    // tied to the SoA row order it was built against, tracked by mBvhOrderVersion
+    RenderableBvh mRenderableBvh;
+    uint32_t mBvhOrderVersion = 0;
+
+    // Layer grouping of the renderable SoA (see acquireLayerRestrictedRange()):
+    // rows of each bucket are contiguous, and a row's layer mask is always contained
+    // in its bucket's mask. Rebuilt with the SoA, merged as views partition it.
+    struct LayerBucket {
+        uint8_t layers;     // union of the layer masks of the rows in the bucket
+        uint32_t first;     // first row of the bucket
+        uint32_t last;      // one past the last row of the bucket
+    };
+    std::vector<LayerBucket> mLayerBuckets;
+
+    // signals captured when the renderable SoA was last rebuilt, so prepare() can
+    // reuse it as-is when nothing that feeds it has changed (see prepare())
+    bool mRenderableDataValid = false;
+    // scratch for prepare(): transform instance of each gathered renderable, consumed
+    // by the parallel world-transform/AABB refit
+    std::vector<FTransformManager::Instance> mRefitTransforms;
+    uint32_t mPrepareSceneVersion = 0;
+    uint32_t mPrepareTransformEpoch = 0;
+    uint32_t mPrepareRenderableEpoch = 0;
+    math::mat4f mPrepareWorldOrigin;
 };
 
 FILAMENT_UPCAST(Scene)
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_SHADOWATLAS_H
+#define TNT_FILAMENT_DETAILS_SHADOWATLAS_H
+
+#include "driver/DriverApiForward.h"
+#include "driver/Handle.h"
+
+#include <filament/Viewport.h>
+
+#include <utils/compiler.h>
+
+#include <tsl/robin_map.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+namespace details {
+
+/*
+ * A shadow atlas for local (spot/point) shadow-casting lights: one large depth target
+ * divided into fixed-size square tiles, one tile per light. Tiles persist across
+ * frames, so a light whose shadow content didn't change keeps its tile and skips
+ * re-rendering; when the atlas is full, the least-recently-used, least important
+ * light is evicted first. This keeps the per-frame shadow cost proportional to the
+ * number of lights that actually changed, not to the light count.
+ *
+ * This class only manages tile assignment and the shared depth target; computing each
+ * light's shadow camera and rendering into the tiles is the caller's business.
+ */
+class ShadowAtlas {
+public:
+    using LightId = uint32_t;
+
+    struct Tile {
+        Viewport viewport;      // the tile's viewport within the atlas
+        bool needsRendering;    // tile content must be (re-)rendered this frame
+    };
+
+    // atlasDimension and tileDimension in texels; tileDimension must divide
+    // atlasDimension
+    ShadowAtlas(uint16_t atlasDimension, uint16_t tileDimension) noexcept;
+
+    // Lazily creates the atlas' depth texture and render target.
+    void prepare(driver::DriverApi& driver) noexcept;
+
+    void terminate(driver::DriverApi& driver) noexcept;
+
+    // Must be called once per frame, before any acquire().
+    void beginFrame() noexcept { mFrame++; }
+
+    /*
+     * Acquire the tile assigned to the given light, assigning one if needed.
+     *
+     * contentHash captures everything the tile's content depends on (light transform
+     * and parameters, caster bounds); needsRendering is set when the tile is newly
+     * assigned or the hash changed. importance drives eviction: when no tile is free,
+     * the least-recently-used, least important light not seen this frame is evicted,
+     * but never for a less important light. Returns nullptr when the atlas is full of
+     * more important lights; callers should acquire in decreasing importance order.
+     */
+    Tile const* acquire(LightId light, float importance, uint32_t contentHash) noexcept;
+
+    uint16_t getAtlasDimension() const noexcept { return mAtlasDimension; }
+    uint16_t getTileDimension() const noexcept { return mTileDimension; }
+    size_t getTileCount() const noexcept { return mEntries.size(); }
+    size_t getAllocatedCount() const noexcept { return mTileForLight.size(); }
+
+    // Valid after prepare().
+    Handle<HwTexture> getTexture() const noexcept { return mTexture; }
+    Handle<HwRenderTarget> getRenderTarget() const noexcept { return mRenderTarget; }
+
+private:
+    struct Entry {
+        LightId light = 0;
+        uint32_t contentHash = 0;
+        uint32_t lastUsedFrame = 0;
+        float importance = 0.0f;
+        bool allocated = false;
+        Tile tile;
+    };
+
+    std::vector<Entry> mEntries;                    // one per tile
+    tsl::robin_map<LightId, uint32_t> mTileForLight;
+    uint32_t mFrame = 0;
+    uint16_t mAtlasDimension;
+    uint16_t mTileDimension;
+
+    Handle<HwTexture> mTexture;
+    Handle<HwRenderTarget> mRenderTarget;
+};
+
+} // namespace details
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_SHADOWATLAS_H
@@ -31,6 +31,9 @@
 #include <math/vec4.h>
 
 namespace filament {
+
+class PostProcessManager;
+
 namespace details {
 
 class ShadowMap {
@@ -41,17 +44,53 @@ public:
     void terminate(driver::DriverApi& driverApi) noexcept;
 
     // Call once per frame if the light, scene (or visible layers) or camera changes.
-    // This computes the light's camera.
+    // This computes the light's camera. csNearFar is the camera-space depth range actually
+    // covered by visible renderables (from the culling results); it tightens the near/far
+    // planes used for fitting the shadow frustum, which improves the shadow map's texel
+    // density and shrinks the caster set (sample-distribution shadow maps, done on the CPU
+    // from the renderables' bounds rather than from a GPU depth-buffer reduction).
     void update(
             const FScene::LightSoa& lightData, size_t index, FScene const* scene,
-            details::CameraInfo const& camera, uint8_t visibleLayers) noexcept;
+            details::CameraInfo const& camera, uint8_t visibleLayers,
+            math::float2 csNearFar) noexcept;
 
     // Do we have visible shadows. Valid after calling update().
     bool hasVisibleShadows() const noexcept { return mHasVisibleShadows; }
 
+    // Whether the shadow map's content must be re-rendered. Valid after calling prepare().
+    // The depth texture persists across frames, so when neither the light's frustum nor
+    // the scene content changed since the last render, the previous content is reused.
+    bool needsRendering() const noexcept { return mNeedsRendering; }
+
+    // Call after the shadow map has been rendered.
+    void markRendered() noexcept { mNeedsRendering = false; }
+
+    // Binds another view's shadow map texture instead of our own and marks this map as
+    // not needing rendering; used when that view already rendered an identical shadow
+    // map (see FEngine::findSharedShadowMap()). Our own texture, if any, is kept and
+    // re-bound by prepare() when sharing stops applying.
+    void shareFrom(ShadowMap const& donor, SamplerBuffer& buffer) noexcept;
+
     // Allocates shadow texture based on user parameters (e.g. dimensions)
     void prepare(driver::DriverApi& driver, SamplerBuffer& buffer) noexcept;
 
+    // Soft shadows (EVSM): when enabled, prepare() additionally allocates a mip-chained
+    // moments texture; after the depth has been rendered, prefilter() converts it into
+    // warped moments and builds the chain, which the shader samples with a single
+    // trilinear fetch (see shadowVsm() in shadowing.fs). Call before prepare().
+    void setSoftShadowsEnabled(bool enabled) noexcept { mVsmEnabled = enabled; }
+    bool isSoftShadowsEnabled() const noexcept { return mVsmEnabled; }
+
+    // Converts the rendered depth into prefiltered EVSM moments; call after the shadow
+    // map has been rendered, and only when soft shadows are enabled.
+    void prefilter(driver::DriverApi& driver, PostProcessManager& ppm) noexcept;
+
+    // Coarsest useful mip of the moments' chain, i.e. the widest penumbra available.
+    // Valid after update().
+    float getMaxPenumbraLod() const noexcept {
+        return float(vsmLevelCount(mShadowMapDimension) - 1);
+    }
+
     // Returns the shadow map's viewport. Valid after prepare().
     Viewport const& getViewport() const noexcept { return mViewport; }
 
@@ -150,6 +189,11 @@ private:
 
     math::mat4f getTextureCoordsMapping() const noexcept;
 
+    static void setSamplers(SamplerBuffer& buffer,
+            Handle<HwTexture> depth, Handle<HwTexture> moments) noexcept;
+
+    static uint8_t vsmLevelCount(uint32_t dimension) noexcept;
+
     float texelSizeWorldSpace(const math::mat4f& lightSpaceMatrix) const noexcept;
     float texelSizeWorldSpace(const math::mat4f& lightSpaceMatrix, math::float3 const& str) const noexcept;
 
@@ -178,10 +222,26 @@ private:
     Handle<HwTexture> mShadowMapHandle;
     Handle<HwRenderTarget> mShadowMapRenderTarget;
 
+    // soft shadows (EVSM): mip-chained moments derived from the depth, see prefilter()
+    Handle<HwTexture> mVsmHandle;
+    Handle<HwRenderTarget> mVsmRenderTarget;
+    bool mVsmEnabled = false;
+
     // set-up in update()
     uint32_t mShadowMapDimension = 0;
     bool mHasVisibleShadows = false;
 
+    // state the last rendered content depends on, used to skip redundant re-renders
+    math::mat4f mCachedLightSpace;
+    FScene const* mCachedScene = nullptr;
+    uint32_t mCachedTransformEpoch = 0;
+    uint32_t mCachedRenderableEpoch = 0;
+    uint8_t mCachedVisibleLayers = 0;
+    bool mNeedsRendering = true;
+
+    // whether the sampler currently binds another shadow map's texture, see shareFrom()
+    bool mBoundToSharedTexture = false;
+
     // use a member here (instead of stack) because we don't want to pay the
     // initialization of the float3 each time
     FrustumBoxIntersection mWsClippedShadowReceiverVolume;
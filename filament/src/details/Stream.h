@@ -39,6 +39,10 @@ public:
 
     void setDimensions(uint32_t width, uint32_t height) noexcept;
 
+    void queueFrame(int64_t timestampNs) noexcept;
+
+    void setTargetLatency(int64_t latencyNs) noexcept;
+
     void readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             driver::PixelBufferDescriptor&& buffer) noexcept;
 
@@ -56,10 +56,15 @@ public:
             uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             PixelBufferDescriptor&& buffer) const noexcept;
 
+    void setImage(FEngine& engine, size_t level, size_t layer,
+            uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
+            PixelBufferDescriptor&& buffer) const noexcept;
+
     void setImage(FEngine& engine, size_t level,
             PixelBufferDescriptor&& buffer, const FaceOffsets& faceOffsets) const noexcept;
 
     void setExternalImage(FEngine& engine, void* image) noexcept;
+    void setExternalImage(FEngine& engine, void* hardwareBuffer, int fenceFd) noexcept;
     void setExternalStream(FEngine& engine, FStream* stream) noexcept;
 
     void generateMipmaps(FEngine& engine) const noexcept;
@@ -74,6 +79,10 @@ public:
 
     static size_t getFormatSize(InternalFormat format) noexcept;
 
+    // estimated GPU memory used by this texture, all levels/faces included
+    // (used for the engine's memory accounting)
+    size_t getEstimatedSize() const noexcept;
+
 private:
     friend class Texture;
     Handle<HwTexture> mHandle;
@@ -85,6 +94,9 @@ private:
     Sampler mTarget = Sampler::SAMPLER_2D;
     uint8_t mLevels = 1;
     uint8_t mSampleCount = 1;
+    // whether our driver commands are recorded on the engine's background resource
+    // stream (captured at creation, see FEngine::setAsyncResourceLoadingEnabled())
+    bool mUsesResourceStream = false;
     FStream* mStream = nullptr;
     Usage mUsage = Usage::DEFAULT;
 };
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/TextureArrayPacker.h"
+
+#include "details/Engine.h"
+#include "details/Texture.h"
+
+#include <assert.h>
+
+namespace filament {
+namespace details {
+
+TextureArrayPacker::Allocation TextureArrayPacker::acquireLayer(FEngine& engine,
+        uint32_t width, uint32_t height, uint8_t levels,
+        Texture::InternalFormat format) noexcept {
+    std::vector<Group>& groups = mGroups[makeKey(width, height, levels, format)];
+
+    for (Group& group : groups) {
+        if (!group.freeLayers.empty()) {
+            const uint16_t layer = group.freeLayers.back();
+            group.freeLayers.pop_back();
+            return { group.texture, layer };
+        }
+        if (group.allocated < LAYER_COUNT) {
+            return { group.texture, group.allocated++ };
+        }
+    }
+
+    // all compatible arrays are full, create a new one
+    FTexture* const texture = engine.createTexture(Texture::Builder()
+            .width(width).height(height).depth(LAYER_COUNT)
+            .levels(levels)
+            .sampler(Texture::Sampler::SAMPLER_2D_ARRAY)
+            .format(format));
+    if (UTILS_UNLIKELY(!texture)) {
+        return {};
+    }
+    groups.push_back({ texture, 1, {} });
+    return { texture, 0 };
+}
+
+void TextureArrayPacker::releaseLayer(Allocation const& allocation) noexcept {
+    if (!allocation) {
+        return;
+    }
+    // we don't keep a reverse map; the group count is small (one entry per distinct
+    // texture shape), so a linear scan is fine here
+    for (auto it = mGroups.begin(); it != mGroups.end(); ++it) {
+        for (Group& group : it.value()) {
+            if (group.texture == allocation.texture) {
+                assert(allocation.layer < group.allocated);
+                group.freeLayers.push_back(allocation.layer);
+                return;
+            }
+        }
+    }
+    assert(false); // the allocation doesn't belong to this packer
+}
+
+void TextureArrayPacker::terminate(FEngine& engine) noexcept {
+    for (auto& item : mGroups) {
+        for (Group const& group : item.second) {
+            engine.destroy(group.texture);
+        }
+    }
+    mGroups.clear();
+}
+
+} // namespace details
+} // namespace filament
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_TEXTUREARRAYPACKER_H
+#define TNT_FILAMENT_DETAILS_TEXTUREARRAYPACKER_H
+
+#include <filament/Texture.h>
+
+#include <utils/compiler.h>
+
+#include <tsl/robin_map.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+namespace details {
+
+class FEngine;
+class FTexture;
+
+/*
+ * Packs many same-shaped 2D textures into the layers of a few shared 2D array
+ * textures. Materials that differ only by their textures can't be merged by the
+ * instancing stage because their sampler groups differ; when they sample from a
+ * shared array instead -- a sampler2dArray material parameter plus a per-instance
+ * layer index in the uniform block -- the textures stop being a batching barrier.
+ *
+ * Textures are compatible when width, height, level count and format all match;
+ * each compatible group is backed by one or more array textures of a fixed number
+ * of layers. Layers are recycled through a per-group free list; backing arrays are
+ * only destroyed at terminate().
+ *
+ * This only hands out (array, layer) pairs: uploading the image data into the layer
+ * (Texture::setImage() with a layer) and routing the layer index to the shader is
+ * the caller's business.
+ */
+class TextureArrayPacker {
+public:
+    struct Allocation {
+        FTexture* texture = nullptr;    // the shared array texture, valid until terminate()
+        uint16_t layer = 0;             // the layer assigned within it
+        explicit operator bool() const noexcept { return texture != nullptr; }
+    };
+
+    // Allocates a layer for a texture of the given shape, creating a new backing
+    // array if all compatible ones are full.
+    Allocation acquireLayer(FEngine& engine, uint32_t width, uint32_t height,
+            uint8_t levels, Texture::InternalFormat format) noexcept;
+
+    // Returns a layer to its group's free list. The layer's content is left as-is;
+    // it will be overwritten by the next user.
+    void releaseLayer(Allocation const& allocation) noexcept;
+
+    // destroys all backing arrays; outstanding Allocations become invalid
+    void terminate(FEngine& engine) noexcept;
+
+private:
+    // layers per backing array. A full group just gets another array, so this only
+    // trades arrays' count for wasted layers; 16 keeps the waste of a nearly-empty
+    // group small while still folding 16 materials' worth of textures into one bind.
+    static constexpr uint16_t LAYER_COUNT = 16;
+
+    struct Group {
+        FTexture* texture = nullptr;
+        uint16_t allocated = 0;             // layers handed out (high-water mark)
+        std::vector<uint16_t> freeLayers;
+    };
+
+    static uint64_t makeKey(uint32_t width, uint32_t height,
+            uint8_t levels, Texture::InternalFormat format) noexcept {
+        return (uint64_t(width) << 40u) | (uint64_t(height) << 16u) |
+               (uint64_t(format) << 8u) | uint64_t(levels);
+    }
+
+    tsl::robin_map<uint64_t, std::vector<Group>> mGroups;
+};
+
+} // namespace details
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_TEXTUREARRAYPACKER_H
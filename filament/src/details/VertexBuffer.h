@@ -45,6 +45,10 @@ public:
 
     size_t getVertexCount() const noexcept;
 
+    // estimated GPU memory used by the backing buffers
+    // (used for the engine's memory accounting)
+    size_t getEstimatedSize() const noexcept;
+
     AttributeBitset getDeclaredAttributes() const noexcept {
         return mDeclaredAttributes;
     }
@@ -57,11 +61,28 @@ public:
 private:
     friend class VertexBuffer;
 
+    // content-hash deduplication (see Builder::dedupe()): data is stashed here and
+    // hashed on the JobSystem until the last buffer slot arrives, then matched
+    // against the engine's registry of shared buffers (defined in VertexBuffer.cpp)
+    struct PendingBuffer;
+    Handle<HwVertexBuffer> createHwBuffer(FEngine& engine) noexcept;
+    void finishDedup(FEngine& engine) noexcept;
+    void abandonDedup(FEngine& engine) noexcept;
+
     Handle<HwVertexBuffer> mHandle;
     std::array<Builder::AttributeData, MAX_ATTRIBUTE_BUFFERS_COUNT> mAttributes;
     AttributeBitset mDeclaredAttributes;
     uint32_t mVertexCount = 0;
     uint8_t mBufferCount = 0;
+    BufferUsage mUsage = BufferUsage::STATIC;
+    // whether our driver commands are recorded on the engine's background resource
+    // stream (captured at creation, see FEngine::setAsyncResourceLoadingEnabled())
+    bool mUsesResourceStream = false;
+    bool mDedupEnabled = false;     // creation deferred until all slots are set
+    bool mSharedHandle = false;     // mHandle is refcounted in the engine's registry
+    uint32_t mPendingMask = 0;      // buffer slots not yet set (dedup only)
+    uint64_t mDedupKey[2] = {};     // our 128-bit key in the engine's registry (dedup only)
+    PendingBuffer* mPendingBuffers = nullptr;
 };
 
 FILAMENT_UPCAST(VertexBuffer)
@@ -24,9 +24,13 @@
 #include "details/Allocators.h"
 #include "details/Camera.h"
 #include "details/Froxelizer.h"
+#include "details/OcclusionBuffer.h"
 #include "details/ShadowMap.h"
 #include "details/Scene.h"
 
+#include "RenderPass.h"
+#include "RenderTargetPool.h"
+
 #include "driver/DriverApi.h"
 #include "driver/Handle.h"
 #include "driver/UniformBuffer.h"
@@ -38,6 +42,8 @@
 #include <utils/Range.h>
 
 #include <deque>
+#include <utils/vector.h>
+#include <vector>
 
 namespace utils {
 class JobSystem;
@@ -126,21 +132,65 @@ public:
     bool hasDynamicLighting() const noexcept { return mHasDynamicLighting; }
     bool hasShadowing() const noexcept { return mHasShadowing & mDirectionalShadowMap.hasVisibleShadows(); }
 
-    void prepareVisibleRenderables(utils::JobSystem& js, FScene::RenderableSoa& renderableData) const noexcept;
+    // candidates restricts the work to a row range of the SoA; rows outside of it are
+    // left untouched (see FScene::acquireLayerRestrictedRange())
+    void prepareVisibleRenderables(FEngine& engine, utils::JobSystem& js,
+            FScene::RenderableSoa& renderableData, Range candidates) const noexcept;
+
+    // Runs the software occlusion stage: rasterizes the occluder geometry into the
+    // low-res depth buffer and clears VISIBLE_RENDERABLE for the renderables it hides.
+    // Must run after the camera culling (it only tests already-visible renderables).
+    void cullOccludedRenderables(utils::JobSystem& js,
+            FScene::RenderableSoa& renderableData, Range candidates) const noexcept;
+
+    void setOccluderGeometry(math::float3 const* vertices, size_t vertexCount,
+            uint32_t const* indices, size_t indexCount) noexcept;
 
-    void prepareVisibleShadowCasters(utils::JobSystem& js, FScene::RenderableSoa& renderableData,
-                                     Frustum const& lightFrustum) const noexcept;
+    void setOcclusionCullingEnabled(bool enabled) noexcept { mOcclusionCullingEnabled = enabled; }
+    bool isOcclusionCullingEnabled() const noexcept { return mOcclusionCullingEnabled; }
+
+    void setGpuOcclusionCullingEnabled(bool enabled) noexcept {
+        mGpuOcclusionCullingEnabled = enabled;
+    }
+    bool isGpuOcclusionCullingEnabled() const noexcept { return mGpuOcclusionCullingEnabled; }
+
+    // Consumes the results collected by last frame's depth-pass occlusion queries into
+    // VISIBLE_MASK_GPU_OCCLUDED, and (lazily) creates queries for the renderables to
+    // test this frame. Must run after the visibility partition, it walks the visible
+    // range (see prepare()).
+    void prepareOcclusionQueries(FEngine& engine, driver::DriverApi& driver,
+            FScene::RenderableSoa& renderableData) noexcept;
+
+    // The query recorder for RenderPass::recordDriverCommands(), or null when GPU
+    // occlusion culling is disabled or has nothing to test.
+    RenderPass::OcclusionQueryRecorder const* getOcclusionQueryRecorder() const noexcept {
+        return mGpuOcclusionCullingEnabled && mOcclusionQueries.recorder.count
+                ? &mOcclusionQueries.recorder : nullptr;
+    }
+
+    void prepareVisibleShadowCasters(FEngine& engine, utils::JobSystem& js,
+            FScene::RenderableSoa& renderableData, Frustum const& lightFrustum) const noexcept;
+
+    // Returns the camera-space depth range (near, far) covered by the visible renderables,
+    // clamped to the camera's [zn, zf]. Valid after the camera culling.
+    math::float2 computeVisibleDepthRange(
+            FScene::RenderableSoa const& renderableData) const noexcept;
 
     void updatePrimitivesLod(
             FEngine& engine, const CameraInfo& camera,
             FScene::RenderableSoa& renderableData, Range visibles) noexcept;
 
-    static void cullRenderables(utils::JobSystem& js, FScene::RenderableSoa& renderableData,
-                                Frustum const& frustum, size_t bit) noexcept;
+    void cullRenderables(FEngine& engine, utils::JobSystem& js,
+            FScene::RenderableSoa& renderableData, Range candidates,
+            Frustum const& frustum, size_t bit) const noexcept;
 
     void setShadowsEnabled(bool enabled) noexcept { mShadowingEnabled = enabled; }
 
+    void setSoftShadowsEnabled(bool enabled) noexcept { mSoftShadowsEnabled = enabled; }
+    bool isSoftShadowsEnabled() const noexcept { return mSoftShadowsEnabled; }
+
     ShadowMap const& getShadowMap() const { return mDirectionalShadowMap; }
+    ShadowMap& getShadowMap() { return mDirectionalShadowMap; }
 
     FCamera const* getDirectionalLightCamera() const noexcept {
         return &mDirectionalShadowMap.getDebugCamera();
@@ -182,10 +232,69 @@ public:
 
     void setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept;
 
+    void setFroxelDepthDistribution(float power) noexcept;
+
     void setPostProcessingEnabled(bool enabled) noexcept {
         mHasPostProcessPass = enabled;
     }
 
+    void setHalfResolutionTransparencyEnabled(bool enabled) noexcept {
+        mHalfResolutionTransparency = enabled;
+    }
+
+    bool isHalfResolutionTransparencyEnabled() const noexcept {
+        return mHalfResolutionTransparency;
+    }
+
+    void setRenderQuality(RenderQuality const& renderQuality) noexcept {
+        mRenderQuality = renderQuality;
+    }
+
+    RenderQuality getRenderQuality() const noexcept {
+        return mRenderQuality;
+    }
+
+    void setCachingEnabled(bool enabled) noexcept {
+        mRenderCache.enabled = enabled;
+    }
+
+    bool isCachingEnabled() const noexcept {
+        return mRenderCache.enabled;
+    }
+
+    bool hasCachedFrame() const noexcept {
+        return mRenderCache.target != nullptr;
+    }
+
+    // Returns the cached frame if it is still valid for the view's current content,
+    // i.e. it can be re-composited as-is, or null if the view must be re-rendered.
+    RenderTargetPool::Target const* getValidCachedFrame(FEngine& engine) const noexcept;
+
+    // Returns the cached frame's target whether it is valid or not, so FRenderer can
+    // render the new frame into it instead of cycling targets through the pool.
+    RenderTargetPool::Target const* getCachedFrameTarget() const noexcept {
+        return mRenderCache.target;
+    }
+
+    // Makes target the cached frame for the view's current content; called by
+    // FRenderer after rendering into it. The view takes ownership of the checkout.
+    void commitCachedFrame(FEngine& engine, RenderTargetPool::Target const* target) noexcept;
+
+    // Returns the cached frame's target to the pool, if any.
+    void releaseCachedFrame(FEngine& engine) noexcept;
+
+    // Retained command list (see CommandCache below). When last frame's sorted
+    // commands are still valid for this frame, appends them to the slice and returns
+    // true; the caller can then skip command generation and sorting altogether.
+    bool reuseCachedCommands(FEngine& engine, uint32_t commandTypeFlags,
+            RenderPass::RenderFlags renderFlags,
+            utils::GrowingSlice<RenderPass::Command>& commands) const noexcept;
+
+    // Captures this frame's sorted commands for reuse by the next frame.
+    void cacheCommands(FEngine& engine, uint32_t commandTypeFlags,
+            RenderPass::RenderFlags renderFlags,
+            utils::Slice<RenderPass::Command> const& commands) noexcept;
+
     void setDepthPrepass(DepthPrepass prepass) noexcept {
         mDepthPrepass = prepass;
     }
@@ -220,9 +329,11 @@ private:
     }
 
     // we don't inline this one, because the function is quite large and there is not much to
-    // gain from inlining.
+    // gain from inlining. 'moved' is set when any row was actually swapped (and left
+    // untouched otherwise), so the caller knows whether the SoA row order changed.
     static FScene::RenderableSoa::iterator partition(
-            FScene::RenderableSoa::iterator begin, FScene::RenderableSoa::iterator end, uint8_t mask) noexcept;
+            FScene::RenderableSoa::iterator begin, FScene::RenderableSoa::iterator end,
+            uint8_t mask, bool& moved) noexcept;
 
 
     // these are accessed in the render loop, keep together
@@ -241,9 +352,33 @@ private:
 
     CameraInfo mViewingCameraInfo;
     Frustum mCullingFrustum;
+    math::mat4f mCullingViewProjection;
 
     mutable Froxelizer mFroxelizer;
 
+    // software occlusion culling (see OcclusionBuffer). The buffer is scratch space
+    // rebuilt each frame by cullOccludedRenderables(), hence mutable.
+    mutable OcclusionBuffer mOcclusionBuffer;
+    std::vector<math::float3> mOccluderVertices;
+    std::vector<uint32_t> mOccluderIndices;
+    uint32_t mOccluderVersion = 0;
+    bool mOcclusionCullingEnabled = false;
+
+    // GPU occlusion queries (see prepareOcclusionQueries()): one query per
+    // per-renderable uniform slot, created lazily for the visible single-primitive
+    // renderables. Results are consumed with a couple frames of latency -- the driver
+    // collects them without ever stalling -- so a disoccluded renderable can reappear
+    // a frame late; its depth draw is never skipped, which bounds the error to that.
+    struct OcclusionQueries {
+        std::vector<Handle<HwOcclusionQuery>> handles;  // indexed by uniform slot
+        std::vector<uint8_t> occluded;                  // last applied results, by slot
+        std::vector<uint8_t> scratch;                   // this frame's results, by slot
+        RenderPass::OcclusionQueryRecorder recorder;
+        uint32_t resultsVersion = 0;    // bumped when 'occluded' changes
+    };
+    OcclusionQueries mOcclusionQueries;
+    bool mGpuOcclusionCullingEnabled = false;
+
     Viewport mViewport;
     LinearColorA mClearColor;
     bool mCulling = true;
@@ -255,8 +390,11 @@ private:
     uint8_t mSampleCount = 1;
     AntiAliasing mAntiAliasing = AntiAliasing::FXAA;
     bool mShadowingEnabled = true;
+    bool mSoftShadowsEnabled = false;
     bool mHasPostProcessPass = true;
+    bool mHalfResolutionTransparency = false;
     DepthPrepass mDepthPrepass = DepthPrepass::DEFAULT;
+    RenderQuality mRenderQuality;
 
     using duration = std::chrono::duration<float, std::milli>;
     DynamicResolutionOptions mDynamicResolution;
@@ -272,6 +410,109 @@ private:
     utils::CString mName;
     const bool mClipSpace01;
 
+    // Cached result of the camera culling, reused by prepare() as long as neither the
+    // scene's content, the world transforms, the renderables' bounds nor the culling
+    // frustum changed since the frame it was captured (see the epoch counters in
+    // FTransformManager / FRenderableManager).
+    struct VisibilityCache {
+        math::float4 planes[6] = {};        // frustum of the cached result
+        FScene const* scene = nullptr;
+        uint32_t sceneVersion = 0;
+        uint32_t transformEpoch = 0;
+        uint32_t renderableEpoch = 0;
+        uint32_t orderVersion = 0;          // SoA row order at capture time
+        uint32_t occluderVersion = 0;
+        bool occlusionEnabled = false;
+        bool valid = false;
+        utils::SmallVector<Culler::result_type, 1024> masks;
+    };
+    VisibilityCache mVisibilityCache;
+
+    // Potential shadow casters of the directional light. Captured by culling the shadow
+    // casters against the light frustum expanded by a world-space margin; as long as the
+    // scene is unchanged and the frustum has drifted by less than that margin (slow sun
+    // movement, small camera moves), per-frame shadow culling only re-tests the captured
+    // candidates instead of the whole scene. Mutable because it's refreshed from
+    // prepareVisibleShadowCasters(), which is const like the rest of the culling path.
+    struct ShadowCasterCache {
+        math::float4 planes[6] = {};        // exact frustum at capture time
+        FScene const* scene = nullptr;
+        uint32_t sceneVersion = 0;
+        uint32_t transformEpoch = 0;
+        uint32_t renderableEpoch = 0;
+        uint32_t orderVersion = 0;          // SoA row order at capture time
+        uint32_t count = 0;                 // renderable count at capture time
+        float radius = 0.0f;                // bounding radius of the scene's content
+        float margin = 0.0f;                // world-space slack baked into the capture
+        bool valid = false;
+        std::vector<uint32_t> candidates;   // indices into the renderable SoA
+    };
+    mutable ShadowCasterCache mShadowCasterCache;
+
+    // Last rendered frame of this view, kept in a target checked out of the
+    // RenderTargetPool across frames (see setCachingEnabled()). The signature captures
+    // everything that affects the view's rendered content; as long as it doesn't
+    // change, FRenderer re-composites the cached frame instead of re-rendering.
+    struct RenderCache {
+        struct Signature {      // compared bitwise, see computeCacheSignature()
+            math::mat4f cameraModel;
+            math::mat4 cameraProjection;
+            LinearColorA clearColor;
+            Viewport viewport;
+            FCamera const* camera;
+            FScene const* scene;
+            uint32_t sceneVersion;
+            uint32_t transformEpoch;
+            uint32_t renderableEpoch;
+            uint32_t materialVersion;
+            uint32_t occlusionResultsVersion;
+            AntiAliasing antiAliasing;
+            uint8_t visibleLayers;
+            uint8_t sampleCount;
+            uint8_t flags;      // clear / post-process / shadowing toggles
+        };
+        RenderTargetPool::Target const* target = nullptr;
+        Signature signature = {};
+        bool enabled = false;
+        bool valid = false;
+    };
+    RenderCache mRenderCache;
+
+    void computeCacheSignature(RenderCache::Signature& sig, FEngine& engine) const noexcept;
+
+    // Last frame's sorted color-pass commands (see ColorPass::renderColorPass). The
+    // signature captures every input of command generation and sorting; as long as it
+    // doesn't change, the commands would come out bit-identical, so last frame's copy
+    // is resubmitted as-is and only the per-frame uniform blocks are updated --
+    // effectively a display list for static content. Unlike RenderCache, material
+    // parameters are not part of the signature: the commands don't depend on uniform
+    // values, which keeps the cache valid while materials animate.
+    struct CommandCache {
+        struct Signature {      // compared bitwise, see computeCommandSignature()
+            math::mat4f cameraModel;
+            math::mat4 cameraProjection;
+            math::mat4f cullingViewProjection;
+            FCamera const* camera;
+            FScene const* scene;
+            uint32_t sceneVersion;
+            uint32_t transformEpoch;
+            uint32_t renderableEpoch;
+            uint32_t occluderVersion;
+            uint32_t occlusionResultsVersion;
+            uint32_t commandTypeFlags;
+            uint8_t renderFlags;
+            uint8_t visibleLayers;
+            uint8_t flags;      // culling / occlusion-culling toggles
+        };
+        std::vector<RenderPass::Command> commands;  // terminated by the sentinel
+        Signature signature = {};
+        bool valid = false;
+    };
+    CommandCache mCommandCache;
+
+    void computeCommandSignature(CommandCache::Signature& sig, FEngine& engine,
+            uint32_t commandTypeFlags, RenderPass::RenderFlags renderFlags) const noexcept;
+
     // the following values are set by prepare()
     Range mVisibleRenderables;
     Range mVisibleShadowCasters;
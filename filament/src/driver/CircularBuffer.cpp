@@ -43,7 +43,7 @@ CircularBuffer::CircularBuffer(size_t size) {
 #endif
     mSize = size;
     mTail = mData;
-    mHead = mData;
+    mHead.store(static_cast<char*>(mData), std::memory_order_relaxed);
 }
 
 CircularBuffer::~CircularBuffer() noexcept {
@@ -134,22 +134,27 @@ void* CircularBuffer::alloc(size_t size) noexcept {
 }
 
 void CircularBuffer::circularize() noexcept {
+    // this runs on the producer side once all recording has joined (see allocate()),
+    // so plain relaxed accesses to the head are sufficient here
+    char* head = mHead.load(std::memory_order_relaxed);
     if (mUsesAshmem > 0) {
-        intptr_t overflow = intptr_t(mHead) - (intptr_t(mData) + ssize_t(mSize));
+        intptr_t overflow = intptr_t(head) - (intptr_t(mData) + ssize_t(mSize));
         if (overflow >= 0) {
             assert(size_t(overflow) <= mSize);
-            mHead = (void *) (intptr_t(mData) + overflow);
+            head = (char*)(intptr_t(mData) + overflow);
+            mHead.store(head, std::memory_order_relaxed);
             #ifndef NDEBUG
             memset(mData, 0xA5, size_t(overflow));
             #endif
         }
     } else {
         // Only circularize if mHead if in the second buffer.
-        if (intptr_t(mHead) - intptr_t(mData) > ssize_t(mSize)) {
-            mHead = mData;
+        if (intptr_t(head) - intptr_t(mData) > ssize_t(mSize)) {
+            head = static_cast<char*>(mData);
+            mHead.store(head, std::memory_order_relaxed);
         }
     }
-    mTail = mHead;
+    mTail = head;
 }
 
 } // namespace filament
@@ -17,6 +17,8 @@
 #ifndef TNT_FILAMENT_DRIVER_CIRCULARBUFFER_H
 #define TNT_FILAMENT_DRIVER_CIRCULARBUFFER_H
 
+#include <atomic>
+
 #include <stddef.h>
 #include <stdint.h>
 
@@ -45,21 +47,23 @@ public:
 
     ~CircularBuffer() noexcept;
 
-    // allocates 'size' bytes in the circular buffer and returns a pointer to the memory
-    // return the current head and moves it forward by size bytes
+    // Allocates 'size' bytes in the circular buffer and returns a pointer to the memory.
+    // The head is advanced with an atomic fetch-add, which reserves a private range of
+    // the buffer for the caller; this allows several producer threads to record commands
+    // concurrently. Each producer must have committed its content before the buffer is
+    // flushed -- CommandBufferQueue::flush() provides that synchronization point (it can
+    // only run once all recording jobs have joined).
     inline void* allocate(size_t size) noexcept {
-        char* const cur = static_cast<char*>(mHead);
-        mHead = cur + size;
-        return cur;
+        return mHead.fetch_add(size, std::memory_order_relaxed);
     }
 
     // Total size of circular buffer
     size_t size() const noexcept { return mSize; }
 
     // returns true if the buffer is empty (e.g. after calling flush)
-    bool empty() const noexcept { return mTail == mHead; }
+    bool empty() const noexcept { return mTail == mHead.load(std::memory_order_relaxed); }
 
-    void* getHead() const noexcept { return mHead; }
+    void* getHead() const noexcept { return mHead.load(std::memory_order_relaxed); }
 
     void* getTail() const noexcept { return mTail; }
 
@@ -79,8 +83,9 @@ private:
     // pointer to the beginning of recorded data
     void* mTail = nullptr;
 
-    // pointer to the next available command
-    void* mHead = nullptr;
+    // pointer to the next available command; atomic so that multiple producers can
+    // reserve ranges concurrently (see allocate())
+    std::atomic<char*> mHead{ nullptr };
 };
 
 } // namespace filament
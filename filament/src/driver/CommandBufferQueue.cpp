@@ -112,6 +112,16 @@ std::vector<CommandBufferQueue::Slice> CommandBufferQueue::waitForCommands() con
     return std::move(mCommandBuffersToExecute);
 }
 
+std::vector<CommandBufferQueue::Slice> CommandBufferQueue::tryGetCommands() const {
+    std::unique_lock<utils::Mutex> lock(mLock);
+    return std::move(mCommandBuffersToExecute);
+}
+
+bool CommandBufferQueue::hasCommands() const {
+    std::unique_lock<utils::Mutex> lock(mLock);
+    return !mCommandBuffersToExecute.empty() || mExitRequested;
+}
+
 void CommandBufferQueue::releaseBuffer(CommandBufferQueue::Slice const& buffer) {
     std::unique_lock<utils::Mutex> lock(mLock);
     mFreeSpace += uintptr_t(buffer.end) - uintptr_t(buffer.begin);
@@ -31,11 +31,13 @@ namespace filament {
  * A producer-consumer command queue that uses a CircularBuffer as main storage
  */
 class CommandBufferQueue {
+public:
     struct Slice {
         void* begin;
         void* end;
     };
 
+private:
     const size_t mRequiredSize;
 
     CircularBuffer mCircularBuffer;
@@ -61,6 +63,13 @@ public:
     // wait for commands to be available and returns an array containing these commands
     std::vector<Slice> waitForCommands() const;
 
+    // non-blocking version of waitForCommands(); returns an empty vector when no
+    // commands are pending
+    std::vector<Slice> tryGetCommands() const;
+
+    // returns true if a subsequent waitForCommands() would not block
+    bool hasCommands() const;
+
     // return the memory used by this command buffer to the circular buffer
     // WARNING: releaseBuffer() must be called in sequence of the Slices returned by
     // waitForCommands()
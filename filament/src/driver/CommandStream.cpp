@@ -16,12 +16,22 @@
 
 #include "driver/CommandStream.h"
 
+#include <utils/architecture.h>
 #include <utils/CallStack.h>
+#include <utils/Hash.h>
 #include <utils/Log.h>
 #include <utils/Profiler.h>
 #include <utils/Systrace.h>
 
+#include <tsl/robin_map.h>
+
 #include <functional>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
 
 namespace filament {
 
@@ -73,9 +83,42 @@ void CommandStream::execute(void* buffer) {
 
     Driver& UTILS_RESTRICT driver = *mDriver;
     CommandBase* UTILS_RESTRICT base = static_cast<CommandBase*>(buffer);
-    UTILS_ALIGN_LOOP
-    while (UTILS_LIKELY(base)) {
-        base = base->execute(driver);
+    if (UTILS_UNLIKELY(mRecorder)) {
+        // capture & replay path, not performance sensitive
+        while (base) {
+            // must happen before execute(), which consumes the command's arguments
+            recordCommand(base);
+            base = base->execute(driver);
+        }
+    } else {
+        // Commands are laid out back-to-back in the circular buffer, so even though the
+        // next command's exact offset is only known once the current one is decoded, its
+        // header lives just past the current command. Prefetching the next cache lines
+        // before the indirect call overlaps the next header's fetch with the dispatch,
+        // which otherwise stalls on that load on every single command. Decoding four
+        // commands per loop iteration amortizes the loop overhead and gives the
+        // prefetches enough time to land.
+        UTILS_ALIGN_LOOP
+        while (UTILS_LIKELY(base)) {
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + CACHELINE_SIZE);
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + 2 * CACHELINE_SIZE);
+            base = base->execute(driver);
+            if (UTILS_UNLIKELY(!base)) break;
+
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + CACHELINE_SIZE);
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + 2 * CACHELINE_SIZE);
+            base = base->execute(driver);
+            if (UTILS_UNLIKELY(!base)) break;
+
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + CACHELINE_SIZE);
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + 2 * CACHELINE_SIZE);
+            base = base->execute(driver);
+            if (UTILS_UNLIKELY(!base)) break;
+
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + CACHELINE_SIZE);
+            UTILS_PREFETCH(reinterpret_cast<char const*>(base) + 2 * CACHELINE_SIZE);
+            base = base->execute(driver);
+        }
     }
 
     if (SYSTRACE_TAG) {
@@ -99,6 +142,333 @@ void CommandStream::queueCommand(std::function<void()> command) {
     new(allocateCommand(CustomCommand::align(sizeof(CustomCommand)))) CustomCommand(command);
 }
 
+// ------------------------------------------------------------------------------------------------
+// Capture & replay
+// ------------------------------------------------------------------------------------------------
+
+// Dispatcher is a standard-layout class whose members are all Execute pointers, in
+// DriverAPI.inc order, so we can view it as an array; the position of a command's
+// execute pointer in this table is a stable identifier for the driver method, which
+// is what we serialize instead of the pointer itself.
+static constexpr size_t DISPATCH_COUNT = sizeof(Dispatcher) / sizeof(Dispatcher::Execute);
+static_assert(sizeof(Dispatcher) % sizeof(Dispatcher::Execute) == 0,
+        "Dispatcher isn't just a table of Execute pointers");
+
+static inline Dispatcher::Execute* dispatcherTable(Dispatcher& dispatcher) noexcept {
+    return reinterpret_cast<Dispatcher::Execute*>(&dispatcher);
+}
+
+// true for commands whose saved arguments are trivially destructible: their bytes are
+// intact after dispatch and can be replayed from a bitwise copy. Commands carrying
+// ownership (BufferDescriptor, std::function, ...) are skipped during capture.
+static const bool sCommandIsReplayable[DISPATCH_COUNT] = {
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
+        std::is_trivially_destructible<                                                         \
+                CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>>::value,
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
+        std::is_trivially_destructible<                                                         \
+                CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>>::value,
+#include "driver/DriverAPI.inc"
+};
+
+// stringified method names, written into captures so command indices can be re-matched
+// by name when a capture is replayed by a binary with a different DriverAPI.inc revision
+static const char* const sCommandName[DISPATCH_COUNT] = {
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)         #methodName,
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) #methodName,
+#include "driver/DriverAPI.inc"
+};
+
+// commands have a static size (execute() advances by align(sizeof(Command))), so it can
+// be looked up before dispatch
+static const uint32_t sCommandSize[DISPATCH_COUNT] = {
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
+        uint32_t(CommandBase::align(sizeof(                                                     \
+                CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>))),
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
+        uint32_t(CommandBase::align(sizeof(                                                     \
+                CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>))),
+#include "driver/DriverAPI.inc"
+};
+
+// per-command accessor for the data payload descriptor (nullptr result = no payload)
+using BlobGetter = driver::BufferDescriptor* (*)(CommandBase*);
+static const BlobGetter sCommandBlobGetter[DISPATCH_COUNT] = {
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
+        &CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>::getBlobArgument,
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
+        &CommandType<decltype(&Driver::methodName)>::Command<&Driver::methodName>::getBlobArgument,
+#include "driver/DriverAPI.inc"
+};
+
+static constexpr uint32_t CAPTURE_MAGIC = 0x50414346;   // 'FCAP'
+static constexpr uint32_t CAPTURE_VERSION = 2;
+
+/*
+ * Capture file layout (all sections contiguous):
+ *      CaptureHeader
+ *      method name table       methodCount null-terminated strings
+ *      commands                commandCount x { CaptureCommand, <size> raw bytes }
+ *      blob dictionary         blobCount x { uint32_t size, <size> raw bytes }
+ */
+struct CaptureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t methodCount;       // command count of the capturing binary's API table
+    uint32_t commandCount;      // number of captured commands
+    uint32_t skippedCount;      // informational: commands that couldn't be captured
+    uint32_t commandBytes;      // total command payload, excluding the prefixes
+    uint32_t nameTableBytes;    // size of the method name table
+    uint32_t blobCount;         // deduplicated data payloads
+    uint32_t blobBytes;         // total dictionary payload, excluding the size prefixes
+};
+
+struct CaptureCommand {
+    static constexpr uint32_t NO_BLOB = ~0u;
+    uint32_t methodIndex;
+    uint32_t size;
+    uint32_t blobIndex;         // dictionary entry of the data payload, or NO_BLOB
+    uint32_t blobOffset;        // offset of the BufferDescriptor within the command
+};
+
+struct CommandStream::CaptureRecorder {
+    FILE* file;
+    uint32_t commands = 0;
+    uint32_t skipped = 0;
+    uint32_t bytes = 0;
+    // blob dictionary: payloads are deduplicated by content, keyed by a murmur3 hash
+    // with collisions resolved by comparison
+    std::vector<uint8_t> dictionary;
+    std::vector<std::pair<uint32_t, uint32_t>> blobs;       // offset, size in dictionary
+    tsl::robin_map<uint32_t, std::vector<uint32_t>> blobMap; // hash -> candidate blobs
+
+    uint32_t internBlob(void const* data, size_t size) {
+        uint32_t hash = uint32_t(size);
+        if (size >= sizeof(uint32_t)) {
+            hash = utils::hash::murmur3(static_cast<uint32_t const*>(data),
+                    size / sizeof(uint32_t), uint32_t(size));
+        }
+        auto& candidates = blobMap[hash];
+        for (uint32_t i : candidates) {
+            if (blobs[i].second == size &&
+                    !memcmp(dictionary.data() + blobs[i].first, data, size)) {
+                return i;
+            }
+        }
+        const uint32_t index = uint32_t(blobs.size());
+        const uint32_t offset = uint32_t(dictionary.size());
+        dictionary.insert(dictionary.end(),
+                static_cast<uint8_t const*>(data), static_cast<uint8_t const*>(data) + size);
+        blobs.emplace_back(offset, uint32_t(size));
+        candidates.push_back(index);
+        return index;
+    }
+};
+
+bool CommandStream::startRecording(const char* path) noexcept {
+    if (mRecorder) {
+        return false;
+    }
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    // placeholder header, rewritten with the actual counts by stopRecording()
+    CaptureHeader h = {};
+    h.magic = CAPTURE_MAGIC;
+    h.version = CAPTURE_VERSION;
+    h.methodCount = uint32_t(DISPATCH_COUNT);
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for (size_t i = 0; ok && i < DISPATCH_COUNT; i++) {
+        const size_t len = strlen(sCommandName[i]) + 1;
+        ok = fwrite(sCommandName[i], 1, len, f) == len;
+        h.nameTableBytes += uint32_t(len);
+    }
+    if (!ok) {
+        fclose(f);
+        return false;
+    }
+    mRecorder = new CaptureRecorder{ f };
+    return true;
+}
+
+void CommandStream::stopRecording() noexcept {
+    CaptureRecorder* const r = mRecorder;
+    if (!r) {
+        return;
+    }
+    mRecorder = nullptr;
+
+    // append the blob dictionary
+    bool ok = true;
+    for (auto const& blob : r->blobs) {
+        ok = ok && fwrite(&blob.second, sizeof(blob.second), 1, r->file) == 1 &&
+                fwrite(r->dictionary.data() + blob.first, 1, blob.second, r->file) == blob.second;
+    }
+
+    CaptureHeader h = {};
+    h.magic = CAPTURE_MAGIC;
+    h.version = CAPTURE_VERSION;
+    h.methodCount = uint32_t(DISPATCH_COUNT);
+    h.commandCount = r->commands;
+    h.skippedCount = r->skipped;
+    h.commandBytes = r->bytes;
+    for (size_t i = 0; i < DISPATCH_COUNT; i++) {
+        h.nameTableBytes += uint32_t(strlen(sCommandName[i]) + 1);
+    }
+    h.blobCount = uint32_t(r->blobs.size());
+    h.blobBytes = uint32_t(r->dictionary.size());
+    fseek(r->file, 0, SEEK_SET);
+    fwrite(&h, sizeof(h), 1, r->file);
+    fclose(r->file);
+    delete r;
+}
+
+void CommandStream::recordCommand(CommandBase* cmd) noexcept {
+    CaptureRecorder* const r = mRecorder;
+    Dispatcher::Execute* const table = dispatcherTable(*mDispatcher);
+    size_t index = 0;
+    while (index < DISPATCH_COUNT && table[index] != cmd->mExecute) {
+        index++;
+    }
+    if (index >= DISPATCH_COUNT) {
+        // NoopCommands (buffer-internal jumps) and CustomCommands don't resolve to a
+        // driver method; they're only counted
+        r->skipped++;
+        return;
+    }
+    CaptureCommand c = { uint32_t(index), sCommandSize[index], CaptureCommand::NO_BLOB, 0 };
+    if (!sCommandIsReplayable[index]) {
+        // upload commands carry their payload in a BufferDescriptor: intern the bytes
+        // in the dictionary and record where the descriptor lives so loadCapture() can
+        // reconstitute it. The rest (uniform/sampler moves, ...) can't be captured.
+        driver::BufferDescriptor* const data = sCommandBlobGetter[index](cmd);
+        if (!data || !data->buffer) {
+            r->skipped++;
+            return;
+        }
+        c.blobIndex = r->internBlob(data->buffer, data->size);
+        c.blobOffset = uint32_t(reinterpret_cast<char*>(data) - reinterpret_cast<char*>(cmd));
+    }
+    if (fwrite(&c, sizeof(c), 1, r->file) == 1 &&
+            fwrite(cmd, 1, c.size, r->file) == c.size) {
+        r->commands++;
+        r->bytes += c.size;
+    }
+}
+
+void* CommandStream::loadCapture(const char* path, Driver& driver,
+        size_t* outSize, size_t* outCommandCount) noexcept {
+    FILE* const f = fopen(path, "rb");
+    if (!f) {
+        return nullptr;
+    }
+    CaptureHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 ||
+            h.magic != CAPTURE_MAGIC || h.version != CAPTURE_VERSION) {
+        fclose(f);
+        return nullptr;
+    }
+
+    // re-match the capture's command indices against this binary's API table by name,
+    // so captures survive insertions/removals in DriverAPI.inc
+    std::vector<char> names(h.nameTableBytes);
+    std::vector<uint32_t> remap(h.methodCount, CaptureCommand::NO_BLOB);
+    bool ok = h.nameTableBytes > 0 &&
+            fread(names.data(), 1, names.size(), f) == names.size() &&
+            names.back() == '\0';
+    char const* name = names.data();
+    for (uint32_t i = 0; ok && i < h.methodCount; i++) {
+        ok = name < names.data() + names.size();
+        for (size_t j = 0; ok && j < DISPATCH_COUNT; j++) {
+            if (!strcmp(name, sCommandName[j])) {
+                remap[i] = uint32_t(j);
+                break;
+            }
+        }
+        name += strlen(name) + 1;
+    }
+
+    const size_t terminatorSize = CommandBase::align(sizeof(NoopCommand));
+    char* const blob = static_cast<char*>(
+            malloc(h.commandBytes + terminatorSize + h.blobBytes));
+    ok = ok && blob != nullptr;
+
+    // load the dictionary first (it's stored after the commands), into the tail of the
+    // returned allocation, so it lives exactly as long as the command buffer
+    char* const dictionary = blob + h.commandBytes + terminatorSize;
+    std::vector<std::pair<char*, uint32_t>> blobs(h.blobCount);
+    const long commandsStart = ftell(f);
+    ok = ok && fseek(f, long(h.commandBytes + h.commandCount * sizeof(CaptureCommand)),
+            SEEK_CUR) == 0;
+    char* d = dictionary;
+    for (uint32_t i = 0; ok && i < h.blobCount; i++) {
+        uint32_t size;
+        ok = fread(&size, sizeof(size), 1, f) == 1 &&
+                d + size <= dictionary + h.blobBytes &&
+                fread(d, 1, size, f) == size;
+        if (ok) {
+            blobs[i] = { d, size };
+            d += size;
+        }
+    }
+    ok = ok && fseek(f, commandsStart, SEEK_SET) == 0;
+
+    Dispatcher::Execute* const table = dispatcherTable(driver.getDispatcher());
+    char* p = blob;
+    size_t count = 0;
+    for (uint32_t i = 0; ok && i < h.commandCount; i++) {
+        CaptureCommand c;
+        ok = fread(&c, sizeof(c), 1, f) == 1 &&
+                c.methodIndex < h.methodCount &&
+                p + c.size <= blob + h.commandBytes &&
+                fread(p, 1, c.size, f) == c.size;
+        if (!ok) {
+            break;
+        }
+        const uint32_t local = remap[c.methodIndex];
+        if (local == CaptureCommand::NO_BLOB) {
+            // this binary doesn't have that command anymore; drop it
+            continue;
+        }
+        // retarget the command to the given driver
+        reinterpret_cast<CommandBase*>(p)->mExecute = table[local];
+        if (c.blobIndex != CaptureCommand::NO_BLOB) {
+            // reconstitute the data payload from the dictionary; no release callback,
+            // the dictionary belongs to the returned allocation
+            ok = c.blobIndex < h.blobCount &&
+                    c.blobOffset + sizeof(driver::BufferDescriptor) <= c.size;
+            if (ok) {
+                auto* data = reinterpret_cast<driver::BufferDescriptor*>(p + c.blobOffset);
+                *data = driver::BufferDescriptor(
+                        blobs[c.blobIndex].first, blobs[c.blobIndex].second);
+            }
+        }
+        if (ok) {
+            p += c.size;
+            count++;
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        free(blob);
+        return nullptr;
+    }
+
+    new(p) NoopCommand(nullptr);
+    if (outSize) {
+        *outSize = size_t(p - blob) + terminatorSize;
+    }
+    if (outCommandCount) {
+        *outCommandCount = count;
+    }
+    return blob;
+}
+
 template<typename... ARGS>
 template<void (Driver::*METHOD)(ARGS...)>
 template<std::size_t... I>
@@ -30,6 +30,7 @@
 #include <assert.h>
 #include <cstddef>
 #include <stdint.h>
+#include <stdio.h>
 
 // Set to true to print every commands out on log.d. This requires RTTI and DEBUG
 #define DEBUG_COMMAND_STREAM false
@@ -61,6 +62,9 @@ public:
 // ------------------------------------------------------------------------------------------------
 
 class CommandBase {
+    // for capture & replay (see CommandStream::startRecording())
+    friend class CommandStream;
+
     static constexpr size_t FILAMENT_OBJECT_ALIGNMENT = alignof(std::max_align_t);
 
 protected:
@@ -102,6 +106,21 @@ constexpr void apply(M&& m, D&& d, T&& t) {
             std::make_index_sequence< std::tuple_size<std::remove_reference_t<T>>::value >{});
 }
 
+// index of the first tuple element deriving from BufferDescriptor, or tuple_size if none;
+// used by capture & replay to locate a command's data payload (see Command::getBlobArgument())
+template<typename Tuple, size_t I, size_t N>
+struct BlobArgSearch {
+    static constexpr size_t value =
+            std::is_base_of<driver::BufferDescriptor,
+                    typename std::tuple_element<I, Tuple>::type>::value
+            ? I : BlobArgSearch<Tuple, I + 1, N>::value;
+};
+
+template<typename Tuple, size_t N>
+struct BlobArgSearch<Tuple, N, N> {
+    static constexpr size_t value = N;
+};
+
 /*
  * CommandType<> is just a wrapper class to specialize on a pointer-to-member of Driver
  * (i.e. a method pointer to a method of Driver of a particular type -- but not the
@@ -128,15 +147,19 @@ struct CommandType<void (Driver::*)(ARGS...)> {
         template<std::size_t... I> void log(std::index_sequence<I...>) noexcept;
 
     public:
-        template<typename M, typename D>
-        static inline void execute(M&& method, D&& driver, CommandBase* base, intptr_t* next) noexcept {
+        // The concrete driver's method is a template parameter rather than a runtime
+        // argument, so the call through it is bound at compile-time and inlines into
+        // the driver -- the only indirect call left per command is the one through
+        // CommandBase's execute pointer.
+        template<typename D, void (D::*METHOD_OF_D)(ARGS...)>
+        static inline void execute(D& driver, CommandBase* base, intptr_t* next) noexcept {
             Command* self = static_cast<Command*>(base);
             *next = align(sizeof(Command));
             if (DEBUG_COMMAND_STREAM) {
                 // must call this before invoking the method
                 self->log();
             }
-            apply(method, driver, self->mArgs);
+            apply(METHOD_OF_D, driver, self->mArgs);
             self->~Command();
         }
 
@@ -148,6 +171,31 @@ struct CommandType<void (Driver::*)(ARGS...)> {
                 : CommandBase(execute), mArgs(std::move(args)...) {
         }
 
+        // For capture & replay: a pointer to this command's data payload descriptor (its
+        // first BufferDescriptor-derived argument), or nullptr if it doesn't carry one.
+        // Must be called before the command is executed (dispatching consumes the args).
+        static driver::BufferDescriptor* getBlobArgument(CommandBase* base) noexcept {
+            Command* const self = static_cast<Command*>(base);
+            return getBlobArgument(self->mArgs, std::integral_constant<size_t,
+                    BlobArgSearch<SavedParameters, 0,
+                            std::tuple_size<SavedParameters>::value>::value>{});
+        }
+
+    private:
+        template<size_t I>
+        static driver::BufferDescriptor* getBlobArgument(SavedParameters& args,
+                std::integral_constant<size_t, I>) noexcept {
+            return &std::get<I>(args);
+        }
+
+        static driver::BufferDescriptor* getBlobArgument(SavedParameters&,
+                std::integral_constant<size_t,
+                        std::tuple_size<SavedParameters>::value>) noexcept {
+            return nullptr;
+        }
+
+    public:
+
         // placement new declared as "throw" to avoid the compiler's null-check
         inline void* operator new(std::size_t size, void* ptr) {
             assert(ptr);
@@ -158,6 +206,84 @@ struct CommandType<void (Driver::*)(ARGS...)> {
 
 // ------------------------------------------------------------------------------------------------
 
+/*
+ * Compact commands: bindUniforms and bindSamplers are issued for nearly every primitive
+ * drawn, and the generic Command<> encoding above spends a full alignment quantum on
+ * their (size_t, handle) tuple in addition to the one holding the execute pointer. The
+ * specializations below pack the binding point and the 32-bit handle into the slot
+ * already paid for by CommandBase, halving the bytes these commands push through the
+ * CircularBuffer. Both the CommandStream methods and ConcreteDispatcher name commands
+ * through CommandType<>::Command<>, so they pick these up transparently.
+ *
+ * draw() doesn't get a compact encoding: its arguments (two 32-bit handles, a packed
+ * RasterState word and the instance count) exactly fill its quantum already, and
+ * handles can't be truncated to 16 bits without a remapping table.
+ */
+
+template<>
+template<>
+class CommandType<decltype(&Driver::bindUniforms)>::Command<&Driver::bindUniforms>
+        : public CommandBase {
+    uint32_t mIndex;
+    Driver::UniformBufferHandle mUbh;
+
+public:
+    template<typename D, void (D::*METHOD_OF_D)(size_t, Driver::UniformBufferHandle)>
+    static inline void execute(D& driver, CommandBase* base, intptr_t* next) noexcept {
+        Command* self = static_cast<Command*>(base);
+        *next = align(sizeof(Command));
+        (driver.*METHOD_OF_D)(size_t(self->mIndex), self->mUbh);
+        self->~Command();
+    }
+
+    static driver::BufferDescriptor* getBlobArgument(CommandBase*) noexcept { return nullptr; }
+
+    inline explicit Command(Command&& rhs) = default;
+
+    inline Command(Execute execute, size_t index, Driver::UniformBufferHandle ubh) noexcept
+            : CommandBase(execute), mIndex(uint32_t(index)), mUbh(ubh) {
+    }
+
+    // placement new declared as "throw" to avoid the compiler's null-check
+    inline void* operator new(std::size_t size, void* ptr) {
+        assert(ptr);
+        return ptr;
+    }
+};
+
+template<>
+template<>
+class CommandType<decltype(&Driver::bindSamplers)>::Command<&Driver::bindSamplers>
+        : public CommandBase {
+    uint32_t mIndex;
+    Driver::SamplerBufferHandle mSbh;
+
+public:
+    template<typename D, void (D::*METHOD_OF_D)(size_t, Driver::SamplerBufferHandle)>
+    static inline void execute(D& driver, CommandBase* base, intptr_t* next) noexcept {
+        Command* self = static_cast<Command*>(base);
+        *next = align(sizeof(Command));
+        (driver.*METHOD_OF_D)(size_t(self->mIndex), self->mSbh);
+        self->~Command();
+    }
+
+    static driver::BufferDescriptor* getBlobArgument(CommandBase*) noexcept { return nullptr; }
+
+    inline explicit Command(Command&& rhs) = default;
+
+    inline Command(Execute execute, size_t index, Driver::SamplerBufferHandle sbh) noexcept
+            : CommandBase(execute), mIndex(uint32_t(index)), mSbh(sbh) {
+    }
+
+    // placement new declared as "throw" to avoid the compiler's null-check
+    inline void* operator new(std::size_t size, void* ptr) {
+        assert(ptr);
+        return ptr;
+    }
+};
+
+// ------------------------------------------------------------------------------------------------
+
 class CustomCommand : public CommandBase {
     std::function<void()> mCommand;
     static void execute(Driver&, CommandBase* self, intptr_t* next) noexcept;
@@ -198,14 +324,16 @@ private:
         using Type = CommandType<decltype(&Driver::methodName)>;                                \
         using Cmd = typename Type::template Command<&Driver::methodName>;                       \
         ConcreteDriver& concreteDriver = static_cast<ConcreteDriver&>(driver);                  \
-        Cmd::execute(&ConcreteDriver::methodName, concreteDriver, base, next);                  \
+        Cmd::template execute<ConcreteDriver, &ConcreteDriver::methodName>(                     \
+                concreteDriver, base, next);                                                    \
      }
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
     static void methodName(Driver& driver, CommandBase* base, intptr_t* next) {                 \
         using Type = CommandType<decltype(&Driver::methodName)>;                                \
         using Cmd = typename Type::template Command<&Driver::methodName>;                       \
         ConcreteDriver& concreteDriver = static_cast<ConcreteDriver&>(driver);                  \
-        Cmd::execute(&ConcreteDriver::methodName, concreteDriver, base, next);                  \
+        Cmd::template execute<ConcreteDriver, &ConcreteDriver::methodName>(                     \
+                concreteDriver, base, next);                                                    \
      }
 #include "driver/DriverAPI.inc"
 };
@@ -237,6 +365,12 @@ public:
         return mDriver->methodName(params);                                                     \
     }
 
+#define DECL_DRIVER_API_SYNCHRONOUS_CONST(RetType, methodName, paramsDecl, params)              \
+    inline RetType methodName(paramsDecl) const {                                               \
+        DEBUG_COMMAND(methodName, params);                                                      \
+        return mDriver->methodName(params);                                                     \
+    }
+
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
     inline RetType methodName(paramsDecl) {                                                     \
         DEBUG_COMMAND(methodName, params);                                                      \
@@ -272,6 +406,37 @@ public:
 
     void execute(void* buffer);
 
+    /*
+     * Capture & replay, for A/B benchmarking of driver work against captured frames
+     * (see test/filament_replay.cpp). The file format is versioned; v2 additionally
+     * stores a method-name table -- so command indices stay valid across binaries with
+     * different DriverAPI.inc revisions -- and a deduplicated blob dictionary holding
+     * the data payloads of upload commands, making captures replayable against real
+     * drivers (OpenGL, Vulkan), not just the no-op driver.
+     *
+     * While recording, commands are serialized to disk just before they are executed
+     * on the driver thread. Commands with trivially-destructible arguments are stored
+     * verbatim; upload commands (those carrying a BufferDescriptor) have their payload
+     * interned in the dictionary and are reconstituted at load time. The rest --
+     * custom commands, uniform/sampler buffer moves -- are counted and skipped.
+     * startRecording()/stopRecording() must not race with execute(), so call them
+     * while the driver thread is idle.
+     */
+    bool startRecording(const char* path) noexcept;
+    void stopRecording() noexcept;
+
+    /*
+     * Loads a capture created by startRecording() and retargets its commands to the
+     * given driver's dispatcher (matching commands by name, so captures survive
+     * API-table changes). Returns a malloc()ed command buffer, terminated like a
+     * regular frame and suitable for execute(), or nullptr on error. The buffer must
+     * be copied before each execute() call, since dispatching consumes the commands;
+     * the original must be kept alive while copies are replayed (it also owns the
+     * blob dictionary the copies' upload commands point into) and free()d when done.
+     */
+    static void* loadCapture(const char* path, Driver& driver,
+            size_t* outSize, size_t* outCommandCount) noexcept;
+
     /*
      * queueCommand() allows to queue a lambda function as a command.
      * This is much less efficient than using the Driver* API.
@@ -294,12 +459,19 @@ public:
             size_t count = 1, size_t alignment = alignof(PodType)) noexcept;
 
 private:
+    void recordCommand(CommandBase* cmd) noexcept;
+
     // Dispatcher could be a value (instead of pointer), which saves a load when writing commands
     // at the expense of a larger CommandStream object (about ~400 bytes)
     Dispatcher* mDispatcher = nullptr;
     Driver* mDriver = nullptr;
     CircularBuffer* UTILS_RESTRICT mCurrentBuffer = nullptr;
 
+    // capture state (see startRecording()); heap-allocated while recording, since it
+    // carries the blob-deduplication dictionary
+    struct CaptureRecorder;
+    CaptureRecorder* mRecorder = nullptr;
+
 #ifndef NDEBUG
     // just for debugging...
     std::thread::id mThreadId;
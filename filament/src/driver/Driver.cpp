@@ -48,6 +48,29 @@ void DriverBase::purge() noexcept {
     std::unique_lock<std::mutex> lock(mPurgeLock);
     std::swap(buffersToPurge, mBufferToPurge);
     lock.unlock(); // don't remove this, it ensures mBufferToPurge is destroyed without lock held
+
+    // Coalesce descriptors that share a batch callback: each (callback, user) group gets a single
+    // invocation covering the whole span of consumed buffers, instead of one call per descriptor.
+    // The number of distinct groups is expected to be tiny (typically one per streaming system),
+    // so the quadratic grouping below is cheaper than sorting. Descriptors with a per-buffer
+    // callback are serviced by their destructor, as before.
+    std::vector<BufferDescriptor::Consumed> batch;
+    for (size_t i = 0, c = buffersToPurge.size(); i < c; i++) {
+        BufferDescriptor::BatchCallback const callback = buffersToPurge[i].batchCallback;
+        if (!callback) {
+            continue;
+        }
+        void* const user = buffersToPurge[i].batchUser;
+        batch.clear();
+        for (size_t j = i; j < c; j++) {
+            BufferDescriptor& item = buffersToPurge[j];
+            if (item.batchCallback == callback && item.batchUser == user) {
+                batch.push_back({ item.buffer, item.size, item.user });
+                item.batchCallback = nullptr; // consumed here, don't fire again on destruction
+            }
+        }
+        callback(batch.data(), batch.size(), user);
+    }
 }
 
 void DriverBase::scheduleDestroySlow(BufferDescriptor&& buffer) noexcept {
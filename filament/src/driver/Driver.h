@@ -51,7 +51,7 @@ class Dispatcher;
 class Driver {
 public:
     // constants
-    static constexpr size_t MAX_ATTRIBUTE_BUFFER_COUNT = 8;
+    static constexpr size_t MAX_ATTRIBUTE_BUFFER_COUNT = 12;
 
     /*
      * Driver types...
@@ -98,6 +98,8 @@ public:
     using FenceHandle           = Handle<HwFence>;
     using SwapChainHandle       = Handle<HwSwapChain>;
     using StreamHandle          = Handle<HwStream>;
+    using TimerQueryHandle      = Handle<HwTimerQuery>;
+    using OcclusionQueryHandle  = Handle<HwOcclusionQuery>;
 
     struct Attribute {
         static constexpr uint8_t FLAG_NORMALIZED     = 0x1;
@@ -111,6 +113,15 @@ public:
 
     using AttributeArray = std::array<Attribute, MAX_ATTRIBUTE_BUFFER_COUNT>;
 
+    // describes one uniform block packed in the staging buffer of updateUniformBuffers().
+    // the staging buffer starts with an array of these records, followed by the payload.
+    struct UniformBufferUpdateRecord {
+        UniformBufferHandle ubh;
+        uint32_t offset = 0;        // offset of the block in the staging buffer, in bytes
+        uint32_t size = 0;          // size of the block, in bytes
+        uint32_t bufferOffset = 0;  // offset of the block in the target buffer object, in bytes
+    };
+
     // types of the data returned by samplers in the shaders
     enum class SamplerFormat : uint8_t {
         // don't change values of enums (used w/ UniformInterfaceBlock::Type)
@@ -214,6 +225,21 @@ public:
         command();
     }
 
+    // Occupancy of the backend's device-memory sub-allocator. Backends that sub-allocate
+    // (currently vulkan) refresh these once per frame from the driver thread; other backends
+    // leave them at zero. The frontend exposes them through DebugRegistry as "d.driver.*".
+    struct GpuAllocatorStats {
+        int blockCount = 0;             // device memory blocks allocated from the driver
+        int allocationCount = 0;        // resource sub-allocations served from those blocks
+        float usedMegabytes = 0.0f;     // bytes occupied by sub-allocations
+        float unusedMegabytes = 0.0f;   // bytes allocated from the device but unoccupied
+    };
+
+    GpuAllocatorStats& getGpuAllocatorStats() noexcept { return mGpuAllocatorStats; }
+
+private:
+    GpuAllocatorStats mGpuAllocatorStats;
+
     // --------------------------------------------------------------------------------------------
     // DriverAPI interface
     // --------------------------------------------------------------------------------------------
@@ -248,6 +274,9 @@ public:
 #define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params) \
     virtual RetType methodName(paramsDecl) = 0;
 
+#define DECL_DRIVER_API_SYNCHRONOUS_CONST(RetType, methodName, paramsDecl, params) \
+    virtual RetType methodName(paramsDecl) const = 0;
+
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) \
     virtual RetType methodName##Synchronous() noexcept = 0; \
     void methodName(RetType, paramsDecl) {}
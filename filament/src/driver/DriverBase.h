@@ -18,6 +18,7 @@
 #define TNT_FILAMENT_DRIVER_DRIVERBASE_H
 
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <assert.h>
 #include <stdint.h>
@@ -52,26 +53,30 @@ struct HwVertexBuffer : public HwBase {
     uint32_t vertexCount;                 //   4
     uint8_t bufferCount;                  //   1
     uint8_t attributeCount;               //   1
-    uint8_t padding[2];                   //   2 -> 56 bytes
+    Driver::Usage usage;                  //   1
+    uint8_t padding[1];                   //   1 -> 56 bytes
 
     HwVertexBuffer(
             uint8_t bufferCount,
             uint8_t attributeCount,
             uint32_t elementCount,
-            Driver::AttributeArray const& attributes) noexcept
+            Driver::AttributeArray const& attributes,
+            Driver::Usage usage) noexcept
             : attributes(attributes),
               vertexCount(elementCount),
               bufferCount(bufferCount),
-              attributeCount(attributeCount) {
+              attributeCount(attributeCount),
+              usage(usage) {
     }
 };
 
 struct HwIndexBuffer : public HwBase {
-    HwIndexBuffer(uint8_t elementSize, uint32_t indexCount) noexcept :
-            count(indexCount), elementSize(elementSize) {
+    HwIndexBuffer(uint8_t elementSize, uint32_t indexCount, Driver::Usage usage) noexcept :
+            count(indexCount), elementSize(elementSize), usage(usage) {
     }
     uint32_t count;
     uint8_t elementSize;
+    Driver::Usage usage;
 };
 
 struct HwRenderPrimitive : public HwBase {
@@ -133,6 +138,19 @@ struct HwSwapChain : public HwBase {
     driver::Platform::SwapChain* swapChain;
 };
 
+struct HwTimerQuery : public HwBase {
+    // written by the backend thread when the result becomes available,
+    // read from the main thread by getTimerQueryValue()
+    std::atomic<uint64_t> elapsed = { 0 };
+};
+
+struct HwOcclusionQuery : public HwBase {
+    enum : uint32_t { NO_RESULT = 0, SAMPLES_PASSED = 1, NO_SAMPLES_PASSED = 2 };
+    // written by the backend thread when the result becomes available,
+    // read from the main thread by getOcclusionQueryResult()
+    std::atomic<uint32_t> state = { NO_RESULT };
+};
+
 struct HwStream : public HwBase {
     HwStream() = default;
     explicit HwStream(driver::Platform::Stream* stream) : stream(stream) { }
@@ -128,9 +128,18 @@ void GPUBuffer::commitSlow(driver::DriverApi& driverApi, void const* begin, void
     const driver::PixelDataFormat format = mFormat;
     const driver::PixelDataType type = mType;
     const uint32_t w = mWidth;
+    const size_t rowSizeInBytes = mRowSizeInBytes;
     for (auto const& range : mDirtyRanges) {
+        // upload each dirty range as a sub-rect of full rows; the source pointer is
+        // offset to the first dirty row so the driver only references (and copies,
+        // on backends that do) the bytes that actually changed.
+        assert(range.start * rowSizeInBytes < sizeInBytes);
+        uint8_t const* const rangeBegin =
+                static_cast<uint8_t const*>(begin) + range.start * rowSizeInBytes;
+        const size_t rangeSizeInBytes = std::min(range.getCount() * rowSizeInBytes,
+                sizeInBytes - range.start * rowSizeInBytes);
         // we need a new PixelBufferDescriptor for each range (std:move)
-        PixelBufferDescriptor desc(begin, sizeInBytes, format, type);
+        PixelBufferDescriptor desc(rangeBegin, rangeSizeInBytes, format, type);
         driverApi.load2DImage(texture, 0,
                 0, range.start,
                 w, range.getCount(), std::move(desc));
@@ -147,4 +156,10 @@ void GPUBuffer::invalidate(size_t row, size_t count) noexcept {
     mDirtyRanges.set(uint32_t(row), uint32_t(count));
 }
 
+void GPUBuffer::invalidateElements(size_t index, size_t count) noexcept {
+    const size_t first = index / mWidth;
+    const size_t last = (index + count + mWidth - 1) / mWidth;
+    invalidate(first, last - first);
+}
+
 } // namespace filament
@@ -65,6 +65,10 @@ public:
     void invalidate() noexcept;
     void invalidate(size_t row, size_t count) noexcept;
 
+    // invalidate a range of elements, mapped to the covering range of rows
+    // (commit() uploads whole rows, a partial row isn't worth an extra driver call)
+    void invalidateElements(size_t index, size_t count) noexcept;
+
     bool isDirty() const noexcept {
         return !mDirtyRanges.isEmpty();
     }
@@ -40,6 +40,8 @@ struct HwTexture;
 struct HwUniformBuffer;
 struct HwSwapChain;
 struct HwStream;
+struct HwTimerQuery;
+struct HwOcclusionQuery;
 
 /*
  * A type handle to a h/w resource
@@ -68,9 +70,11 @@ public:
     // implement move ctor and copy operator for safety
     HandleBase(HandleBase&& rhs) noexcept : object(nullid) {
         std::swap(object, rhs.object);
+        std::swap(generation, rhs.generation);
     }
     HandleBase& operator = (HandleBase&& rhs) noexcept {
         std::swap(object, rhs.object);
+        std::swap(generation, rhs.generation);
         return *this;
     }
 #endif
@@ -85,8 +89,21 @@ public:
     // get this handle's handleId
     HandleId getId() const noexcept { return object; }
 
+#ifndef NDEBUG
+    // Debug-only generation used to catch use-after-destroy: a handle is stamped with
+    // its slot's generation when created, and validated against the driver's
+    // side-table -- which is bumped when the slot is destroyed -- when cast back to a
+    // pointer (see OpenGLDriver::handle_cast). Release builds keep the handle a bare
+    // 32-bit index.
+    HandleId getGeneration() const noexcept { return generation; }
+    void setGeneration(HandleId g) noexcept { generation = g; }
+#endif
+
 protected:
     HandleId object;
+#ifndef NDEBUG
+    HandleId generation = 0;
+#endif
 };
 
 template <typename T>
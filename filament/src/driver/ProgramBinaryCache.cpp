@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/ProgramBinaryCache.h"
+
+#include <utils/Log.h>
+
+#include <stdio.h>
+
+namespace filament {
+namespace driver {
+
+// bump the version whenever the file layout below changes
+static constexpr uint32_t CACHE_MAGIC = 0x43425046u; // 'FPBC'
+static constexpr uint32_t CACHE_VERSION = 1;
+
+// File layout (all integers little-endian, i.e. written in host order):
+//   uint32 magic, uint32 version, uint32 identityLength, uint32 entryCount
+//   identity bytes
+//   per entry: uint64 key, uint32 format, uint32 size, data bytes
+
+static std::string sCacheDirectory;
+
+void ProgramBinaryCache::setCacheDirectory(const char* path) noexcept {
+    sCacheDirectory = path ? path : "";
+}
+
+const char* ProgramBinaryCache::getCacheDirectory() noexcept {
+    return sCacheDirectory.empty() ? nullptr : sCacheDirectory.c_str();
+}
+
+void ProgramBinaryCache::load(const std::string& path, const std::string& identity) noexcept {
+    mPath = path;
+    mIdentity = identity;
+    mEntries.clear();
+    mDirty = false;
+
+    FILE* const file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return; // cold start, the file doesn't exist yet
+    }
+
+    uint32_t header[4];
+    if (fread(header, sizeof(header), 1, file) != 1 ||
+            header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION ||
+            header[2] != identity.size()) {
+        fclose(file);
+        return;
+    }
+
+    std::string fileIdentity(header[2], '\0');
+    if (fread(&fileIdentity[0], 1, fileIdentity.size(), file) != fileIdentity.size() ||
+            fileIdentity != identity) {
+        // the cache was written by a different GPU or driver revision, discard it
+        fclose(file);
+        return;
+    }
+
+    const uint32_t entryCount = header[3];
+    for (uint32_t i = 0; i < entryCount; i++) {
+        uint64_t key;
+        uint32_t format;
+        uint32_t size;
+        if (fread(&key, sizeof(key), 1, file) != 1 ||
+                fread(&format, sizeof(format), 1, file) != 1 ||
+                fread(&size, sizeof(size), 1, file) != 1) {
+            mEntries.clear();
+            break;
+        }
+        Blob blob{ format, std::vector<uint8_t>(size) };
+        if (fread(blob.data.data(), 1, size, file) != size) {
+            mEntries.clear();
+            break;
+        }
+        mEntries.emplace(key, std::move(blob));
+    }
+    fclose(file);
+}
+
+void ProgramBinaryCache::save() const noexcept {
+    if (!mDirty || mPath.empty()) {
+        return;
+    }
+
+    // write to a temporary file first so a crash can't leave a truncated cache behind
+    const std::string tmpPath = mPath + ".tmp";
+    FILE* const file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+
+    bool success = true;
+    const uint32_t header[4] = {
+            CACHE_MAGIC, CACHE_VERSION,
+            uint32_t(mIdentity.size()), uint32_t(mEntries.size())
+    };
+    success = success && fwrite(header, sizeof(header), 1, file) == 1;
+    success = success && fwrite(mIdentity.data(), 1, mIdentity.size(), file) == mIdentity.size();
+    for (auto const& pair : mEntries) {
+        const uint64_t key = pair.first;
+        const Blob& blob = pair.second;
+        const uint32_t format = blob.format;
+        const uint32_t size = uint32_t(blob.data.size());
+        success = success && fwrite(&key, sizeof(key), 1, file) == 1;
+        success = success && fwrite(&format, sizeof(format), 1, file) == 1;
+        success = success && fwrite(&size, sizeof(size), 1, file) == 1;
+        success = success && fwrite(blob.data.data(), 1, size, file) == size;
+        if (!success) {
+            break;
+        }
+    }
+    fclose(file);
+
+    if (success) {
+        rename(tmpPath.c_str(), mPath.c_str());
+        mDirty = false;
+    } else {
+        remove(tmpPath.c_str());
+    }
+}
+
+ProgramBinaryCache::Blob const* ProgramBinaryCache::get(uint64_t key) const noexcept {
+    auto iter = mEntries.find(key);
+    return iter == mEntries.end() ? nullptr : &iter->second;
+}
+
+void ProgramBinaryCache::put(uint64_t key, uint32_t format, const void* data,
+        size_t size) noexcept {
+    if (mPath.empty()) {
+        return;
+    }
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    mEntries[key] = Blob{ format, std::vector<uint8_t>(bytes, bytes + size) };
+    mDirty = true;
+}
+
+std::vector<uint8_t> ProgramBinaryCache::readBlobFile(const std::string& path) noexcept {
+    std::vector<uint8_t> result;
+    FILE* const file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return result;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0) {
+        result.resize(size_t(size));
+        if (fread(result.data(), 1, result.size(), file) != result.size()) {
+            result.clear();
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+bool ProgramBinaryCache::writeBlobFile(const std::string& path, const void* data,
+        size_t size) noexcept {
+    const std::string tmpPath = path + ".tmp";
+    FILE* const file = fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool success = fwrite(data, 1, size, file) == size;
+    fclose(file);
+    if (success) {
+        rename(tmpPath.c_str(), path.c_str());
+    } else {
+        remove(tmpPath.c_str());
+    }
+    return success;
+}
+
+} // namespace driver
+} // namespace filament
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DRIVER_PROGRAMBINARYCACHE_H
+#define TNT_FILAMENT_DRIVER_PROGRAMBINARYCACHE_H
+
+#include <utils/compiler.h>
+
+#include <tsl/robin_map.h>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+namespace driver {
+
+// ProgramBinaryCache is a driver-level store of opaque binary blobs (e.g. glProgramBinary
+// results) persisted to a file, so that warm starts skip shader compilation entirely.
+//
+// The file carries an identity string (GPU renderer + driver version); a cache written by a
+// different device or driver revision is silently discarded on load since binary formats are
+// not portable across them.
+//
+// Persistence is opt-in: the application must call setCacheDirectory() before creating the
+// engine. Without it, load() and save() are no-ops and drivers compile from source as before.
+class ProgramBinaryCache {
+public:
+    struct Blob {
+        uint32_t format;            // client-defined, e.g. a GLenum binary format
+        std::vector<uint8_t> data;
+    };
+
+    // Sets the directory used by all drivers to persist binaries (e.g. the app's cache
+    // directory on Android). Pass nullptr to disable persistence (the default).
+    static void setCacheDirectory(const char* path) noexcept;
+    static const char* getCacheDirectory() noexcept;
+
+    // Loads the cache content from the given file, if the file exists and its identity
+    // string matches. save() writes back to the same file.
+    void load(const std::string& path, const std::string& identity) noexcept;
+
+    // Writes the cache back to the file it was loaded from, if any entry was added.
+    void save() const noexcept;
+
+    // Whether a cache file path has been configured via load().
+    bool isEnabled() const noexcept { return !mPath.empty(); }
+
+    // Returns the cached blob for this key, or null.
+    Blob const* get(uint64_t key) const noexcept;
+
+    // Stores a blob under the given key, replacing any previous entry.
+    void put(uint64_t key, uint32_t format, const void* data, size_t size) noexcept;
+
+    // Helpers for drivers that persist a single self-validating blob (e.g. VkPipelineCache,
+    // which embeds its own vendor/device identity). Returns an empty vector on failure.
+    static std::vector<uint8_t> readBlobFile(const std::string& path) noexcept;
+    static bool writeBlobFile(const std::string& path, const void* data, size_t size) noexcept;
+
+private:
+    std::string mPath;
+    std::string mIdentity;
+    tsl::robin_map<uint64_t, Blob> mEntries;
+    mutable bool mDirty = false;
+};
+
+} // namespace driver
+} // namespace filament
+
+#endif // TNT_FILAMENT_DRIVER_PROGRAMBINARYCACHE_H
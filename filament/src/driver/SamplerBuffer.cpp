@@ -32,6 +32,7 @@ SamplerBuffer::SamplerBuffer(size_t count) noexcept : mSize(uint8_t(count)) {
 
 SamplerBuffer::SamplerBuffer(const SamplerBuffer& rhs) noexcept
         : mDirty(rhs.mDirty),
+          mVersion(rhs.mVersion),
           mSize(rhs.mSize) {
     Sampler const *b = rhs.mBuffer.data();
     Sampler const * const e = b + rhs.mSize;
@@ -42,6 +43,7 @@ SamplerBuffer::SamplerBuffer(const SamplerBuffer& rhs) noexcept
 SamplerBuffer& SamplerBuffer::operator=(const SamplerBuffer& rhs) noexcept {
     if (this != &rhs) {
         mDirty = rhs.mDirty;
+        mVersion = rhs.mVersion;
         mSize = rhs.mSize;
         Sampler const *b = rhs.mBuffer.data();
         Sampler const * const e = b + rhs.mSize;
@@ -53,8 +55,15 @@ SamplerBuffer& SamplerBuffer::operator=(const SamplerBuffer& rhs) noexcept {
 
 void SamplerBuffer::setSampler(size_t index, Sampler const& sampler) noexcept {
     if (index < mSize) {
-        mBuffer[index] = sampler;
-        mDirty.set(index);
+        // ignore no-op writes, so that sampler groups that are merely re-set to the
+        // same content (material instances often are, every frame) stay clean and
+        // don't get dragged through the command stream
+        Sampler& entry = mBuffer[index];
+        if (entry.t.getId() != sampler.t.getId() || entry.s.u != sampler.s.u) {
+            entry = sampler;
+            mDirty.set(index);
+            mVersion++;
+        }
     }
 }
 
@@ -72,6 +72,11 @@ public:
     // return if any samplers has been changed
     bool isDirty() const noexcept { return mDirty.any(); }
 
+    // content generation, bumped only when a set actually modifies a sampler; the
+    // drivers compare it at dispatch to skip updates carrying content they already
+    // hold (the generation survives the copy sent through the command stream)
+    uint32_t getVersion() const noexcept { return mVersion; }
+
     // return if the specified sampler  is dirty
     bool isDirty(const SamplerInterfaceBlock::SamplerInfo& info) const noexcept {
         return mDirty[info.offset];
@@ -118,6 +123,7 @@ private:
 
     std::array<Sampler, 16> mBuffer;    // 128 bytes
     mutable utils::bitset32 mDirty;
+    uint32_t mVersion = 0;
     uint8_t mSize = 0;
 };
 
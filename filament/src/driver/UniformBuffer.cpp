@@ -21,7 +21,7 @@
 
 #include <mutex>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
 #include <utils/Mutex.h>
 
@@ -29,67 +29,80 @@ using namespace math;
 
 namespace filament {
 
+/*
+ * Size-class slab allocator for uniform data. Each size class carves its blocks out
+ * of large contiguous slabs, so all the instances of a given material -- same block
+ * size, hence same class -- end up packed together in memory: the per-frame
+ * instance-commit walk then touches consecutive cache lines instead of scattered heap
+ * allocations. Freed blocks go to a per-class free list and are reused
+ * most-recently-freed first. Slabs are never returned to the heap, so the pool's
+ * footprint is bounded by the peak number of live blocks; sizes too large to be worth
+ * pooling fall back to malloc().
+ */
 class Pool {
-    // TODO: not sure what's a good value here
-    static constexpr size_t DEFAULT_BIN_COUNT = 256;
     static constexpr size_t SIZE_ALIGNMENT = 32;
+    static constexpr size_t MAX_POOLED_SIZE = 1024;
+    static constexpr size_t CLASS_COUNT = MAX_POOLED_SIZE / SIZE_ALIGNMENT;
+    static constexpr size_t SLAB_SIZE = 16384;
 
-public:
-    Pool() noexcept {
-        mBlocks.reserve(mMaxElementCount);
-    }
-
-    Pool(size_t maxCount) noexcept : mMaxElementCount(maxCount) {
-        mBlocks.reserve(maxCount);
-    }
+    struct SizeClass {
+        void* freeList = nullptr;   // singly-linked through the free blocks themselves
+        char* current = nullptr;    // bump pointer into the newest slab
+        char* end = nullptr;
+    };
 
+public:
     ~Pool() noexcept {
-        for (auto& item : mBlocks) {
-            free(item.second);
+        for (void* slab : mSlabs) {
+            free(slab);
         }
     }
 
-    // always round size up to reduce the number of bins
+    // always round size up to reduce the number of size classes
     static size_t align(size_t size) noexcept {
         return (size + (SIZE_ALIGNMENT-1)) & ~(SIZE_ALIGNMENT-1);
     }
 
     void* get(size_t size) noexcept {
+        assert(size);
         size = align(size);
-        std::unique_lock<utils::Mutex> lock(mLock);
-        void* addr = nullptr;
-        auto& blocks = mBlocks;
-        auto pos = blocks.find(size);
-        if (UTILS_LIKELY(pos != blocks.end())) {
-            addr = pos->second;
-            mTotalMemory -= pos->first;
-            blocks.erase(pos);
-        } else {
-            lock.unlock();
-            addr = malloc(size);
+        if (UTILS_UNLIKELY(size > MAX_POOLED_SIZE)) {
+            return malloc(size);
+        }
+        std::lock_guard<utils::Mutex> lock(mLock);
+        SizeClass& c = mClasses[size / SIZE_ALIGNMENT - 1];
+        if (UTILS_LIKELY(c.freeList)) {
+            void* const addr = c.freeList;
+            c.freeList = *static_cast<void**>(addr);
+            return addr;
+        }
+        if (UTILS_UNLIKELY(size_t(c.end - c.current) < size)) {
+            char* const slab = static_cast<char*>(malloc(SLAB_SIZE));
+            mSlabs.push_back(slab);
+            c.current = slab;
+            c.end = slab + SLAB_SIZE;
         }
+        void* const addr = c.current;
+        c.current += size;
         return addr;
     }
 
     void put(void* addr, size_t size) noexcept {
         size = align(size);
-        std::unique_lock<utils::Mutex> lock(mLock);
-        auto& blocks = mBlocks;
-        if (UTILS_LIKELY(blocks.size() < mMaxElementCount)) {
-            mTotalMemory += size;
-            // TODO: maybe we should purge the Pool at some point
-            blocks.emplace(size, addr);
-        } else {
-            lock.unlock();
+        if (UTILS_UNLIKELY(size > MAX_POOLED_SIZE)) {
             free(addr);
+            return;
         }
+        std::lock_guard<utils::Mutex> lock(mLock);
+        SizeClass& c = mClasses[size / SIZE_ALIGNMENT - 1];
+        *static_cast<void**>(addr) = c.freeList;
+        c.freeList = addr;
     }
 
 private:
     utils::Mutex mLock;
-    std::unordered_multimap<size_t, void*> mBlocks;
-    size_t mMaxElementCount = DEFAULT_BIN_COUNT;
-    size_t mTotalMemory = 0;
+    SizeClass mClasses[CLASS_COUNT];
+    std::vector<void*> mSlabs;
 };
 
 static Pool sMemoryPool;
@@ -98,7 +111,9 @@ static Pool sMemoryPool;
 UniformBuffer::UniformBuffer(size_t size) noexcept
     : mBuffer(mStorage),
       mSize(uint32_t(size)),
-      mSomethingDirty(true) {
+      mDirtyRanges{{ 0, uint16_t((size + 3u) >> 2u) }},
+      mDirtyRangeCount(1) {
+    assert(size <= 0xFFFFu * sizeof(uint32_t)); // see PackedRange
     if (UTILS_LIKELY(size > sizeof(mStorage))) {
         mBuffer = UniformBuffer::alloc(size);
     }
@@ -112,7 +127,9 @@ UniformBuffer::UniformBuffer(UniformInterfaceBlock const& uib) noexcept
 UniformBuffer::UniformBuffer(const UniformBuffer& rhs)
         : mBuffer(mStorage),
           mSize(rhs.mSize),
-          mSomethingDirty(rhs.mSomethingDirty) {
+          mDirtyRangeCount(rhs.mDirtyRangeCount),
+          mLastDirtyRange(rhs.mLastDirtyRange) {
+    memcpy(mDirtyRanges, rhs.mDirtyRanges, sizeof(mDirtyRanges));
     if (UTILS_LIKELY(mSize > sizeof(mStorage))) {
         mBuffer = UniformBuffer::alloc(rhs.mSize);
     }
@@ -122,7 +139,9 @@ UniformBuffer::UniformBuffer(const UniformBuffer& rhs)
 UniformBuffer::UniformBuffer(UniformBuffer&& rhs) noexcept
         : mBuffer(rhs.mBuffer),
           mSize(rhs.mSize),
-          mSomethingDirty(rhs.mSomethingDirty) {
+          mDirtyRangeCount(rhs.mDirtyRangeCount),
+          mLastDirtyRange(rhs.mLastDirtyRange) {
+    memcpy(mDirtyRanges, rhs.mDirtyRanges, sizeof(mDirtyRanges));
     if (UTILS_LIKELY(rhs.isLocalStorage())) {
         mBuffer = mStorage;
         memcpy(mBuffer, rhs.mBuffer, mSize);
@@ -133,7 +152,9 @@ UniformBuffer::UniformBuffer(UniformBuffer&& rhs) noexcept
 
 UniformBuffer& UniformBuffer::operator=(UniformBuffer&& rhs) noexcept {
     if (this != &rhs) {
-        mSomethingDirty = rhs.mSomethingDirty;
+        mDirtyRangeCount = rhs.mDirtyRangeCount;
+        mLastDirtyRange = rhs.mLastDirtyRange;
+        memcpy(mDirtyRanges, rhs.mDirtyRanges, sizeof(mDirtyRanges));
         if (UTILS_LIKELY(rhs.isLocalStorage())) {
             mBuffer = mStorage;
             mSize = rhs.mSize;
@@ -146,6 +167,45 @@ UniformBuffer& UniformBuffer::operator=(UniformBuffer&& rhs) noexcept {
     return *this;
 }
 
+void UniformBuffer::addDirtyRange(uint16_t begin, uint16_t end) noexcept {
+    // all of this is O(MAX_DIRTY_RANGES), which is tiny
+    PackedRange* const ranges = mDirtyRanges;
+    uint32_t const count = mDirtyRangeCount;
+
+    // the write may still be close enough to a range other than the last one touched
+    for (uint32_t i = 0; i < count; i++) {
+        if (begin <= ranges[i].end + MERGE_GAP && end + MERGE_GAP >= ranges[i].begin) {
+            ranges[i].begin = std::min(ranges[i].begin, begin);
+            ranges[i].end = std::max(ranges[i].end, end);
+            mLastDirtyRange = uint8_t(i);
+            return;
+        }
+    }
+
+    if (UTILS_LIKELY(count < MAX_DIRTY_RANGES)) {
+        ranges[count] = { begin, end };
+        mDirtyRangeCount = uint8_t(count + 1);
+        mLastDirtyRange = uint8_t(count);
+        return;
+    }
+
+    // the set is full: merge with the range that re-uploads the fewest extra bytes.
+    // the loop above guarantees every range is more than MERGE_GAP away.
+    uint32_t best = 0;
+    uint32_t bestGap = 0xFFFFFFFFu;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t const gap = begin > ranges[i].end ?
+                uint32_t(begin - ranges[i].end) : uint32_t(ranges[i].begin - end);
+        if (gap < bestGap) {
+            bestGap = gap;
+            best = i;
+        }
+    }
+    ranges[best].begin = std::min(ranges[best].begin, begin);
+    ranges[best].end = std::max(ranges[best].end, end);
+    mLastDirtyRange = uint8_t(best);
+}
+
 void* UniformBuffer::alloc(size_t size) noexcept {
     return sMemoryPool.get(size);
 }
@@ -64,7 +64,19 @@ public:
     // invalidate a range of uniforms and return a pointer to it. offset and size given in bytes
     void* invalidateUniforms(size_t offset, size_t size) {
         assert(offset + size <= mSize);
-        mSomethingDirty = true;
+        // ranges are tracked in uint32 units; std140 members never straddle them
+        uint16_t const begin = uint16_t(offset >> 2u);
+        uint16_t const end = uint16_t((offset + size + 3u) >> 2u);
+        // fast path: successive writes usually land in -- or right next to -- the range
+        // touched last; everything else goes through the out-of-line slow path
+        PackedRange& last = mDirtyRanges[mLastDirtyRange];
+        if (UTILS_LIKELY(mDirtyRangeCount &&
+                begin <= last.end + MERGE_GAP && end + MERGE_GAP >= last.begin)) {
+            last.begin = std::min(last.begin, begin);
+            last.end = std::max(last.end, end);
+        } else {
+            addDirtyRange(begin, end);
+        }
         return static_cast<char*>(mBuffer) + offset;
     }
 
@@ -75,10 +87,48 @@ public:
     size_t getSize() const noexcept { return mSize; }
 
     // return if any uniform has been changed
-    bool isDirty() const noexcept { return mSomethingDirty; }
+    bool isDirty() const noexcept { return mDirtyRangeCount != 0; }
+
+    // invalidated byte range since the last clean(); only valid when isDirty() is true.
+    // this lets the backends upload just the modified part of the buffer.
+    size_t getDirtyOffset() const noexcept {
+        uint32_t begin = 0xFFFFu;
+        for (size_t i = 0, c = mDirtyRangeCount; i < c; i++) {
+            begin = std::min(begin, uint32_t(mDirtyRanges[i].begin));
+        }
+        return begin * sizeof(uint32_t);
+    }
+    size_t getDirtySize() const noexcept {
+        uint32_t end = 0;
+        for (size_t i = 0, c = mDirtyRangeCount; i < c; i++) {
+            end = std::max(end, uint32_t(mDirtyRanges[i].end));
+        }
+        return end * sizeof(uint32_t) - getDirtyOffset();
+    }
+
+    // The dirty bytes are tracked as up to MAX_DIRTY_RANGES individual ranges, so that
+    // e.g. a per-frame scalar at the front and a rarely-set array at the back of a
+    // large block don't force a single upload spanning the whole block. Writes closer
+    // than MERGE_GAP to an existing range grow that range instead of creating a new
+    // one -- an extra upload costs more in fixed overhead than a few redundant bytes --
+    // and when the set is full the write merges with the nearest range. Ranges can
+    // overlap a little after merging, which only re-uploads the overlap.
+    struct DirtyRange {
+        uint32_t begin;     // first dirty byte
+        uint32_t end;       // one past the last dirty byte
+    };
+    size_t getDirtyRangeCount() const noexcept { return mDirtyRangeCount; }
+    DirtyRange getDirtyRange(size_t i) const noexcept {
+        assert(i < mDirtyRangeCount);
+        return { uint32_t(mDirtyRanges[i].begin) * uint32_t(sizeof(uint32_t)),
+                 uint32_t(mDirtyRanges[i].end)   * uint32_t(sizeof(uint32_t)) };
+    }
 
     // mark the whole buffer as clean (no modified uniforms)
-    void clean() const noexcept { mSomethingDirty = false; }
+    void clean() const noexcept {
+        mDirtyRangeCount = 0;
+        mLastDirtyRange = 0;
+    }
 
     /*
      * -----------------------------------------------
@@ -146,22 +196,45 @@ public:
         }
     }
 
+    // pooled allocator used for the uniform data; also used by UniformBufferBatch for
+    // its frame-scoped staging buffers.
+    static void* alloc(size_t size) noexcept;
+    static void free(void* addr, size_t size) noexcept;
+
 private:
 #if !defined(NDEBUG)
     friend utils::io::ostream& operator<<(utils::io::ostream& out, const UniformBuffer& rhs);
 #endif
-    static void* alloc(size_t size) noexcept;
-    static void free(void* addr, size_t size) noexcept;
 
     inline bool isLocalStorage() const noexcept { return mBuffer == mStorage; }
 
+    // dirty ranges are stored in uint32 units to keep the whole set at 16 bytes;
+    // this caps the trackable size at 256 KiB, far above what uniform blocks allow
+    struct PackedRange {
+        uint16_t begin;
+        uint16_t end;
+    };
+
+    // slow path of invalidateUniforms(): the write doesn't land near the most recently
+    // touched range
+    void addDirtyRange(uint16_t begin, uint16_t end) noexcept;
+
+    static constexpr uint32_t MAX_DIRTY_RANGES = 4;
+    // don't split an upload for a hole smaller than this (in uint32 units, 128 bytes);
+    // the fixed cost of an extra glBufferSubData (or equivalent) exceeds that of
+    // re-sending a couple cache lines
+    static constexpr uint32_t MERGE_GAP = 32;
+
     // TODO: we need a better to calculate this local storage.
     // Probably the better thing to do would be to use a special allocator.
-    // Local storage is limited by the total size of a handle (128 byte for GL)
-    char mStorage[96];
+    // Local storage (plus the dirty range set) is limited by the total size of
+    // a handle (128 byte for GL)
+    char mStorage[88];
     void *mBuffer = nullptr;
     uint32_t mSize = 0;
-    mutable bool mSomethingDirty = false;
+    mutable PackedRange mDirtyRanges[MAX_DIRTY_RANGES] = {};
+    mutable uint8_t mDirtyRangeCount = 0;
+    mutable uint8_t mLastDirtyRange = 0;
 };
 
 // specialization for float3 (which has a different alignment)
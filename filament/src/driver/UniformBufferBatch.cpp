@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/UniformBufferBatch.h"
+
+#include "driver/DriverApi.h"
+
+#include <assert.h>
+#include <string.h>
+
+namespace filament {
+
+void UniformBufferBatch::begin() noexcept {
+    assert(mCount > 0 && !mStaging);
+    const uint32_t recordBytes = align(mCount * sizeof(Driver::UniformBufferUpdateRecord));
+    mStagingSize = recordBytes + mPayloadSize;
+    mStaging = static_cast<char*>(UniformBuffer::alloc(mStagingSize));
+    mRecords = reinterpret_cast<Driver::UniformBufferUpdateRecord*>(mStaging);
+    mOffset = recordBytes;
+}
+
+void UniformBufferBatch::append(Handle<HwUniformBuffer> ubh, UniformBuffer const& ub,
+        uint32_t bufferOffset) noexcept {
+    assert(mStaging && mAppended < mCount);
+    const uint32_t size = uint32_t(ub.getSize());
+    Driver::UniformBufferUpdateRecord& record = mRecords[mAppended++];
+    record.ubh = ubh;
+    record.offset = mOffset;
+    record.size = size;
+    record.bufferOffset = bufferOffset;
+    memcpy(mStaging + mOffset, ub.getBuffer(), size);
+    mOffset += align(size);
+}
+
+void UniformBufferBatch::commit(driver::DriverApi& driver) noexcept {
+    assert(mAppended == mCount && mOffset <= mStagingSize);
+    driver.updateUniformBuffers(mCount, driver::BufferDescriptor(mStaging, mStagingSize,
+            [](void* buffer, size_t size, void*) {
+                UniformBuffer::free(buffer, size);
+            }));
+    mStaging = nullptr;
+    mRecords = nullptr;
+}
+
+} // namespace filament
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DRIVER_UNIFORMBUFFERBATCH_H
+#define TNT_FILAMENT_DRIVER_UNIFORMBUFFERBATCH_H
+
+#include "driver/Driver.h"
+#include "driver/DriverApiForward.h"
+#include "driver/Handle.h"
+#include "driver/UniformBuffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Packs several dirty UniformBuffers into a single staging buffer, uploaded with one
+ * updateUniformBuffers() command instead of one command (and one small copy) per buffer.
+ *
+ * Used in two passes over the dirty buffers:
+ *   - call reserve() for each buffer, to size the staging buffer
+ *   - call begin(), then append() for each buffer, then commit()
+ *
+ * The staging memory comes from UniformBuffer's pooled allocator and is returned to it
+ * once the command has executed.
+ */
+class UniformBufferBatch {
+public:
+    UniformBufferBatch() noexcept = default;
+
+    UniformBufferBatch(UniformBufferBatch const&) = delete;
+    UniformBufferBatch& operator=(UniformBufferBatch const&) = delete;
+
+    // how many buffers have been reserve()'d
+    uint32_t count() const noexcept { return mCount; }
+
+    // first pass: declare each buffer that will later be appended
+    void reserve(UniformBuffer const& ub) noexcept {
+        mCount++;
+        mPayloadSize += align(ub.getSize());
+    }
+
+    // allocates the staging buffer; call between the two passes
+    void begin() noexcept;
+
+    // second pass: pack a buffer's data into the staging buffer. bufferOffset is where
+    // the block lands within the target buffer object (non-zero when several blocks
+    // share a large buffer, e.g. the per-renderable arena).
+    void append(Handle<HwUniformBuffer> ubh, UniformBuffer const& ub,
+            uint32_t bufferOffset = 0) noexcept;
+
+    // issues the driver command; this object can't be reused afterwards
+    void commit(driver::DriverApi& driver) noexcept;
+
+private:
+    // keep each block vec4-aligned within the staging buffer
+    static uint32_t align(size_t size) noexcept {
+        return uint32_t((size + 0xFu) & ~size_t(0xFu));
+    }
+
+    Driver::UniformBufferUpdateRecord* mRecords = nullptr;
+    char* mStaging = nullptr;
+    uint32_t mStagingSize = 0;
+    uint32_t mPayloadSize = 0;
+    uint32_t mCount = 0;
+    uint32_t mAppended = 0;
+    uint32_t mOffset = 0;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DRIVER_UNIFORMBUFFERBATCH_H
@@ -47,6 +47,9 @@ private:
 #define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params) \
     RetType methodName(paramsDecl) override { return RetType(); }
 
+#define DECL_DRIVER_API_SYNCHRONOUS_CONST(RetType, methodName, paramsDecl, params) \
+    RetType methodName(paramsDecl) const override { return RetType(); }
+
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) \
     RetType methodName##Synchronous() noexcept override { \
         return RetType((RetType::HandleId)0xDEAD0000); } \
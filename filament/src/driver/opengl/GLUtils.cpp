@@ -27,7 +27,18 @@ using namespace utils;
 
 namespace GLUtils {
 
+// set when errors are delivered through the asynchronous KHR_debug callback instead
+// (see OpenGLDriver::initDebugOutput()); only written at driver initialization
+static bool sErrorCallbackChannelActive = false;
+
+void setErrorCallbackChannelActive(bool active) noexcept {
+    sErrorCallbackChannelActive = active;
+}
+
 void checkGLError(io::ostream& out, const char* function, size_t line) noexcept {
+    if (sErrorCallbackChannelActive) {
+        return;
+    }
     GLenum err = glGetError();
     const char* error = "unknown";
     switch (err) {
@@ -30,6 +30,11 @@ namespace GLUtils {
 void checkGLError(utils::io::ostream& out, const char* function, size_t line) noexcept;
 void checkFramebufferStatus(utils::io::ostream& out, const char* function, size_t line) noexcept;
 
+// When the driver has an asynchronous KHR_debug error channel (see
+// OpenGLDriver::initDebugOutput()), the polling checks become redundant and checkGLError()
+// turns into a no-op, so debug builds don't also pay for the glGetError() serialization.
+void setErrorCallbackChannelActive(bool active) noexcept;
+
 #ifdef NDEBUG
 #define CHECK_GL_ERROR(out)
 #define CHECK_GL_FRAMEBUFFER_STATUS(out)
@@ -16,6 +16,7 @@
 
 #include "driver/opengl/OpenGLDriver.h"
 
+#include <chrono>
 #include <set>
 
 #include <utils/compiler.h>
@@ -51,6 +52,24 @@
 #   define DEBUG_MARKER()
 #endif
 
+// Timer queries are core since OpenGL 3.3, and available on GLES through
+// GL_EXT_disjoint_timer_query (runtime support is checked with ext.EXT_disjoint_timer_query).
+#if defined(GL_TIME_ELAPSED) || defined(GL_EXT_disjoint_timer_query)
+#   define HAS_TIMER_QUERIES 1
+#   ifndef GL_TIME_ELAPSED
+#       define GL_TIME_ELAPSED GL_TIME_ELAPSED_EXT
+#   endif
+#else
+#   define HAS_TIMER_QUERIES 0
+#endif
+
+// Boolean occlusion queries (GL_ANY_SAMPLES_PASSED) are core since OpenGL 3.3 and GLES 3.0.
+#ifdef GL_ANY_SAMPLES_PASSED
+#   define HAS_OCCLUSION_QUERIES 1
+#else
+#   define HAS_OCCLUSION_QUERIES 0
+#endif
+
 using namespace math;
 using namespace utils;
 
@@ -178,6 +197,10 @@ OpenGLDriver::OpenGLDriver(OpenGLPlatform* platform) noexcept
     };
     mShaderModel = shaderModel;
 
+    // Route GL errors to the asynchronous KHR_debug channel when available, instead of
+    // polling glGetError() (see initDebugOutput()).
+    initDebugOutput();
+
     /*
      * Set our default state
      */
@@ -210,6 +233,20 @@ OpenGLDriver::OpenGLDriver(OpenGLPlatform* platform) noexcept
     // For the shadow pass
     glPolygonOffset(1.0f, 1.0f);
 
+    // Load the persisted program binaries, if the application configured a cache directory.
+    // Binaries are only valid for the exact GPU and driver revision that produced them, so
+    // the renderer and version strings key the cache file.
+    if (char const* const cacheDirectory = ProgramBinaryCache::getCacheDirectory()) {
+        GLint numBinaryFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+        if (numBinaryFormats > 0) {
+            std::string identity(renderer);
+            identity.append("/").append(version);
+            mProgramBinaryCache.load(
+                    std::string(cacheDirectory) + "/filament_gl_programs.bin", identity);
+        }
+    }
+
     // On some implementation we need to clear the viewport with a triangle, for performance
     // reasons
     initClearProgram();
@@ -243,6 +280,8 @@ void OpenGLDriver::initExtensionsGLES(GLint major, GLint minor, std::set<StaticS
     ext.EXT_color_buffer_half_float = hasExtension(exts, "GL_EXT_color_buffer_half_float");
     ext.texture_compression_s3tc = hasExtension(exts, "WEBGL_compressed_texture_s3tc");
     ext.EXT_multisampled_render_to_texture = hasExtension(exts, "GL_EXT_multisampled_render_to_texture");
+    ext.EXT_disjoint_timer_query = hasExtension(exts, "GL_EXT_disjoint_timer_query");
+    ext.KHR_debug = hasExtension(exts, "GL_KHR_debug");
 }
 
 void OpenGLDriver::initExtensionsGL(GLint major, GLint minor, std::set<StaticString> const& exts) {
@@ -252,9 +291,127 @@ void OpenGLDriver::initExtensionsGL(GLint major, GLint minor, std::set<StaticStr
     ext.OES_EGL_image_external_essl3 = hasExtension(exts, "GL_OES_EGL_image_external_essl3");
     ext.EXT_debug_marker = hasExtension(exts, "GL_EXT_debug_marker");
     ext.EXT_color_buffer_half_float = true;  // Assumes core profile.
+    ext.EXT_disjoint_timer_query = true;     // Timer queries are core in GL 3.3+.
+    // Debug output is core in GL 4.3+ (with unsuffixed entry points, same as the
+    // extension in non-ES contexts).
+    ext.KHR_debug = (major > 4 || (major == 4 && minor >= 3))
+            || hasExtension(exts, "GL_KHR_debug");
+}
+
+// ------------------------------------------------------------------------------------------------
+// Error surveillance (see the DebugMessageSlot ring in OpenGLDriver.h)
+// ------------------------------------------------------------------------------------------------
+
+#if GLES31_HEADERS && defined(GL_KHR_debug)
+// KHR_debug tokens and entry points are suffixed in ES contexts
+#define glDebugMessageCallback          glDebugMessageCallbackKHR
+#define glDebugMessageControl           glDebugMessageControlKHR
+#define GL_DEBUG_OUTPUT                 GL_DEBUG_OUTPUT_KHR
+#define GL_DEBUG_TYPE_ERROR             GL_DEBUG_TYPE_ERROR_KHR
+#define GL_DEBUG_SEVERITY_NOTIFICATION  GL_DEBUG_SEVERITY_NOTIFICATION_KHR
+#endif
+
+void OpenGLDriver::initDebugOutput() noexcept {
+#ifdef GL_KHR_debug
+    if (!ext.KHR_debug) {
+        return;
+    }
+    for (uint32_t i = 0; i < DEBUG_MESSAGE_COUNT; i++) {
+        mDebugMessageRing[i].seq.store(i, std::memory_order_relaxed);
+    }
+    // Deliberately NOT enabling GL_DEBUG_OUTPUT_SYNCHRONOUS: asynchronous delivery is the
+    // whole point, the GL is free to report from its own threads without a sync point.
+    glDebugMessageCallback(&OpenGLDriver::debugMessageCallback, this);
+    // notifications (buffer usage hints, etc.) are chatty and would flood the ring
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION,
+            0, nullptr, GL_FALSE);
+    glEnable(GL_DEBUG_OUTPUT);
+    // the CHECK_GL_ERROR polling is now redundant, and glGetError() serializes the pipeline
+    GLUtils::setErrorCallbackChannelActive(true);
+#endif
+}
+
+void OpenGLDriver::debugMessageCallback(GLenum source, GLenum type, GLuint id,
+        GLenum severity, GLsizei length, const GLchar* message,
+        const void* userParam) noexcept {
+    // can be invoked from any thread inside the GL implementation; the driver pointer is
+    // the user parameter registered in initDebugOutput()
+    OpenGLDriver* const driver =
+            const_cast<OpenGLDriver*>(static_cast<OpenGLDriver const*>(userParam));
+    driver->pushDebugMessage(source, type, id, severity,
+            length < 0 ? strlen(message) : size_t(length), message);
+}
+
+void OpenGLDriver::pushDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+        size_t length, const char* message) noexcept {
+    auto& ring = mDebugMessageRing;
+    uint32_t pos = mDebugMessageHead.load(std::memory_order_relaxed);
+    for (;;) {
+        DebugMessageSlot& slot = ring[pos & (DEBUG_MESSAGE_COUNT - 1u)];
+        uint32_t const seq = slot.seq.load(std::memory_order_acquire);
+        int32_t const diff = int32_t(seq) - int32_t(pos);
+        if (diff == 0) {
+            // the slot is free -- claim it (other reporting threads may race us)
+            if (mDebugMessageHead.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                slot.source = source;
+                slot.type = type;
+                slot.id = id;
+                slot.severity = severity;
+                size_t const n = std::min(length, sizeof(slot.text) - 1);
+                memcpy(slot.text, message, n);
+                slot.text[n] = '\0';
+                // publish: drainDebugMessages() consumes the slot once seq == pos + 1
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // the ring is full; dropping is the price of never blocking the reporting
+            // thread -- the drop count is surfaced by drainDebugMessages()
+            mDebugMessagesDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = mDebugMessageHead.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void OpenGLDriver::drainDebugMessages() noexcept {
+#ifdef GL_KHR_debug
+    auto& ring = mDebugMessageRing;
+    uint32_t pos = mDebugMessageTail;
+    for (;;) {
+        DebugMessageSlot& slot = ring[pos & (DEBUG_MESSAGE_COUNT - 1u)];
+        uint32_t const seq = slot.seq.load(std::memory_order_acquire);
+        if (int32_t(seq) - int32_t(pos + 1) < 0) {
+            // not published yet
+            break;
+        }
+        io::ostream& out = (slot.type == GL_DEBUG_TYPE_ERROR) ? slog.e : slog.w;
+        out << "KHR_debug: " << slot.text
+            << io::hex
+            << " [source=0x" << slot.source
+            << " type=0x" << slot.type
+            << " id=0x" << slot.id
+            << " severity=0x" << slot.severity << "]"
+            << io::dec << io::endl;
+        // free the slot for the producers' next lap around the ring
+        slot.seq.store(pos + DEBUG_MESSAGE_COUNT, std::memory_order_release);
+        pos++;
+    }
+    mDebugMessageTail = pos;
+    uint32_t const dropped = mDebugMessagesDropped.exchange(0, std::memory_order_relaxed);
+    if (UTILS_UNLIKELY(dropped)) {
+        slog.w << "KHR_debug: " << dropped << " message(s) dropped (ring full)" << io::endl;
+    }
+#endif
 }
 
 void OpenGLDriver::terminate() {
+    // deliver outstanding readbacks before tearing down the context
+    if (UTILS_UNLIKELY(!mPendingReadbacks.empty())) {
+        processReadbacks(true);
+    }
     for (auto& item : mSamplerMap) {
         unbindSampler(item.second);
         glDeleteSamplers(1, &item.second);
@@ -264,6 +421,27 @@ void OpenGLDriver::terminate() {
         mOpenGLBlitter->terminate();
     }
     terminateClearProgram();
+    mProgramBinaryCache.save();
+
+#ifndef NDEBUG
+    if (mStateChangeStats.requested) {
+        uint32_t const filtered = mStateChangeStats.requested - mStateChangeStats.issued;
+        slog.d << "GL state changes: issued " << mStateChangeStats.issued
+               << " of " << mStateChangeStats.requested << " requested ("
+               << (filtered * 100) / mStateChangeStats.requested
+               << "% filtered)" << io::endl;
+    }
+#endif
+
+#if !defined(NDEBUG) && UTILS_HAS_RTTI
+    for (auto const& item : mLiveHandleCounts) {
+        if (item.second) {
+            slog.d << "Leaked " << item.second << " handle(s) of type "
+                   << item.first << io::endl;
+        }
+    }
+#endif
+
     mPlatform.terminate();
 }
 
@@ -399,8 +577,10 @@ void OpenGLDriver::bindBuffer(GLenum target, GLuint buffer) noexcept {
         // GL_ELEMENT_ARRAY_BUFFER is a special case, where the currently bound VAO remembers
         // the index buffer, unless there are no VAO bound (see: bindVertexArray)
         assert(state.vao.p);
-        if (state.buffers.targets[targetIndex].genericBinding != buffer
-                || ((state.vao.p != &mDefaultVAO) && (state.vao.p->gl.elementArray != buffer))) {
+        const bool changed = state.buffers.targets[targetIndex].genericBinding != buffer
+                || ((state.vao.p != &mDefaultVAO) && (state.vao.p->gl.elementArray != buffer));
+        countStateChange(changed);
+        if (changed) {
             state.buffers.targets[targetIndex].genericBinding = buffer;
             if (state.vao.p != &mDefaultVAO) {
                 state.vao.p->gl.elementArray = buffer;
@@ -416,30 +596,52 @@ void OpenGLDriver::bindBuffer(GLenum target, GLuint buffer) noexcept {
 
 void OpenGLDriver::bindBufferBase(GLenum target, GLuint index, GLuint buffer) noexcept {
     size_t targetIndex = getIndexForBufferTarget(target);
+    auto& binding = state.buffers.targets[targetIndex].buffers[index];
     // this ALSO sets the generic binding
-    if (state.buffers.targets[targetIndex].buffers[index] != buffer
-            || state.buffers.targets[targetIndex].genericBinding != buffer) {
-        state.buffers.targets[targetIndex].buffers[index] = buffer;
+    const bool changed = binding.name != buffer || binding.size != 0
+            || state.buffers.targets[targetIndex].genericBinding != buffer;
+    countStateChange(changed);
+    if (changed) {
+        binding = { buffer, 0, 0 };
         state.buffers.targets[targetIndex].genericBinding = buffer;
         glBindBufferBase(target, index, buffer);
     }
 }
 
+void OpenGLDriver::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+        GLintptr offset, GLsizeiptr size) noexcept {
+    size_t targetIndex = getIndexForBufferTarget(target);
+    auto& binding = state.buffers.targets[targetIndex].buffers[index];
+    // this ALSO sets the generic binding
+    const bool changed = binding.name != buffer
+            || binding.offset != offset || binding.size != size
+            || state.buffers.targets[targetIndex].genericBinding != buffer;
+    countStateChange(changed);
+    if (changed) {
+        binding = { buffer, offset, size };
+        state.buffers.targets[targetIndex].genericBinding = buffer;
+        glBindBufferRange(target, index, buffer, offset, size);
+    }
+}
+
 void OpenGLDriver::bindFramebuffer(GLenum target, GLuint buffer) noexcept {
     switch (target) {
         case GL_FRAMEBUFFER:
+            countStateChange(state.draw_fbo != buffer || state.read_fbo != buffer);
             if (state.draw_fbo != buffer || state.read_fbo != buffer) {
                 state.draw_fbo = state.read_fbo = buffer;
                 glBindFramebuffer(target, buffer);
             }
             break;
         case GL_DRAW_FRAMEBUFFER:
+            countStateChange(state.draw_fbo != buffer);
             if (state.draw_fbo != buffer) {
                 state.draw_fbo = buffer;
                 glBindFramebuffer(target, buffer);
             }
             break;
         case GL_READ_FRAMEBUFFER:
+            countStateChange(state.read_fbo != buffer);
             if (state.read_fbo != buffer) {
                 state.read_fbo = buffer;
                 glBindFramebuffer(target, buffer);
@@ -489,6 +691,7 @@ void OpenGLDriver::useProgram(OpenGLProgram* p) noexcept {
 void OpenGLDriver::enableVertexAttribArray(GLuint index) noexcept {
     assert(state.vao.p);
     assert(index < state.vao.p->gl.vertexAttribArray.size());
+    countStateChange(!state.vao.p->gl.vertexAttribArray[index]);
     if (UTILS_UNLIKELY(!state.vao.p->gl.vertexAttribArray[index])) {
         state.vao.p->gl.vertexAttribArray.set(index);
         glEnableVertexAttribArray(index);
@@ -498,6 +701,7 @@ void OpenGLDriver::enableVertexAttribArray(GLuint index) noexcept {
 void OpenGLDriver::disableVertexAttribArray(GLuint index) noexcept {
     assert(state.vao.p);
     assert(index < state.vao.p->gl.vertexAttribArray.size());
+    countStateChange(state.vao.p->gl.vertexAttribArray[index]);
     if (UTILS_UNLIKELY(state.vao.p->gl.vertexAttribArray[index])) {
         state.vao.p->gl.vertexAttribArray.unset(index);
         glDisableVertexAttribArray(index);
@@ -506,6 +710,7 @@ void OpenGLDriver::disableVertexAttribArray(GLuint index) noexcept {
 
 void OpenGLDriver::enable(GLenum cap) noexcept {
     size_t index = getIndexForCap(cap);
+    countStateChange(!state.enables.caps[index]);
     if (UTILS_UNLIKELY(!state.enables.caps[index])) {
         state.enables.caps.set(index);
         glEnable(cap);
@@ -514,6 +719,7 @@ void OpenGLDriver::enable(GLenum cap) noexcept {
 
 void OpenGLDriver::disable(GLenum cap) noexcept {
     size_t index = getIndexForCap(cap);
+    countStateChange(state.enables.caps[index]);
     if (UTILS_UNLIKELY(state.enables.caps[index])) {
         state.enables.caps.unset(index);
         glDisable(cap);
@@ -709,18 +915,82 @@ OpenGLDriver::HandleAllocator::HandleAllocator(const utils::HeapArea& area)
 #endif
 }
 
+size_t OpenGLDriver::HandleAllocator::poolIndex(size_t size) noexcept {
+    if (size <= 16)  return 0;
+    if (size <= 64)  return 1;
+    return 2;
+}
+
+void* OpenGLDriver::HandleAllocator::allocFromPool(size_t index) noexcept {
+    switch (index) {
+        case 0:  return mPool0.alloc(16, 16);
+        case 1:  return mPool1.alloc(64, 32);
+        default: return mPool2.alloc(128, 32);
+    }
+}
+
+void OpenGLDriver::HandleAllocator::freeToPool(size_t index, void* p) noexcept {
+    switch (index) {
+        case 0:  mPool0.free(p); break;
+        case 1:  mPool1.free(p); break;
+        default: mPool2.free(p); break;
+    }
+}
+
+OpenGLDriver::HandleAllocator::ThreadCache* OpenGLDriver::HandleAllocator::getThreadCache() noexcept {
+    const std::thread::id tid = std::this_thread::get_id();
+    for (ThreadCache& cache : mThreadCaches) {
+        std::thread::id owner = cache.tid.load(std::memory_order_relaxed);
+        if (owner == tid) {
+            return &cache;
+        }
+        if (owner == std::thread::id{} &&
+                cache.tid.compare_exchange_strong(owner, tid, std::memory_order_relaxed)) {
+            // first time this thread allocates a handle, claim a free cache slot
+            return &cache;
+        }
+    }
+    // more threads than cache slots, fall back to the shared freelists
+    return nullptr;
+}
+
 void* OpenGLDriver::HandleAllocator::alloc(size_t size, size_t alignment, size_t extra) noexcept {
     assert(size <= mPool2.getSize());
-    if (size <= mPool0.getSize()) return mPool0.alloc(size, 16, extra);
-    if (size <= mPool1.getSize()) return mPool1.alloc(size, 32, extra);
-    if (size <= mPool2.getSize()) return mPool2.alloc(size, 32, extra);
-    return nullptr;
+    const size_t index = poolIndex(size);
+    ThreadCache* const cache = getThreadCache();
+    if (UTILS_UNLIKELY(!cache)) {
+        return allocFromPool(index);
+    }
+    size_t& count = cache->count[index];
+    if (UTILS_UNLIKELY(count == 0)) {
+        // batch-refill half the cache, so steady-state churn stays thread-local
+        while (count < CACHE_CAPACITY / 2) {
+            void* const p = allocFromPool(index);
+            if (UTILS_UNLIKELY(!p)) break;
+            cache->blocks[index][count++] = p;
+        }
+        if (UTILS_UNLIKELY(count == 0)) {
+            return nullptr;
+        }
+    }
+    return cache->blocks[index][--count];
 }
 
 void OpenGLDriver::HandleAllocator::free(void* p, size_t size) noexcept {
-    if (size <= mPool0.getSize()) { mPool0.free(p); return; }
-    if (size <= mPool1.getSize()) { mPool1.free(p); return; }
-    if (size <= mPool2.getSize()) { mPool2.free(p); return; }
+    const size_t index = poolIndex(size);
+    ThreadCache* const cache = getThreadCache();
+    if (UTILS_UNLIKELY(!cache)) {
+        freeToPool(index, p);
+        return;
+    }
+    size_t& count = cache->count[index];
+    if (UTILS_UNLIKELY(count == CACHE_CAPACITY)) {
+        // cache full, spill half of it back to the shared freelist
+        while (count > CACHE_CAPACITY / 2) {
+            freeToPool(index, cache->blocks[index][--count]);
+        }
+    }
+    cache->blocks[index][count++] = p;
 }
 
 
@@ -743,6 +1013,7 @@ OpenGLDriver::construct(Handle<B> const& handle, ARGS&& ... args) noexcept {
     new(addr) D(std::forward<ARGS>(args)...);
 #if !defined(NDEBUG) && UTILS_HAS_RTTI
     addr->typeId = typeid(D).name();
+    mLiveHandleCounts[addr->typeId]++;
 #endif
     return addr;
 }
@@ -758,58 +1029,107 @@ void OpenGLDriver::destruct(Handle<B>& handle, D const* p) noexcept {
             std::terminate();
         }
         const_cast<D *>(p)->typeId = "(deleted)";
+        mLiveHandleCounts[typeid(D).name()]--;
 #endif
         p->~D();
         mHandleArena.free(const_cast<D*>(p), sizeof(D));
+#ifndef NDEBUG
+        // invalidate every outstanding copy of this handle, including a future handle
+        // that recycles the slot
+        std::lock_guard<utils::LockingPolicy::SpinLock> guard(mHandleGenerationsLock);
+        mHandleGenerations[handle.getId()]++;
+#endif
     }
 }
 
+#ifndef NDEBUG
+UTILS_NOINLINE
+void OpenGLDriver::debugCheckHandle(HandleBase const& handle) noexcept {
+    if (UTILS_UNLIKELY(!handle)) {
+        return; // null handles are checked (or tolerated) by the callers
+    }
+    HandleBase::HandleId current;
+    {
+        std::lock_guard<utils::LockingPolicy::SpinLock> guard(mHandleGenerationsLock);
+        auto pos = mHandleGenerations.find(handle.getId());
+        current = (pos != mHandleGenerations.end()) ? pos->second : 0;
+    }
+    if (UTILS_UNLIKELY(handle.getGeneration() != current)) {
+        slog.e << "Using handle " << handle.getId() << " of generation "
+               << handle.getGeneration() << ", but its slot is at generation "
+               << current << " (use after destroy?)" << io::endl;
+        std::terminate();
+    }
+}
+#endif
+
 Handle<HwVertexBuffer> OpenGLDriver::createVertexBufferSynchronous() noexcept {
-    return Handle<HwVertexBuffer>( allocateHandle(sizeof(GLVertexBuffer)) );
+    return initHandle<HwVertexBuffer>(sizeof(GLVertexBuffer));
 }
 
 Handle<HwIndexBuffer> OpenGLDriver::createIndexBufferSynchronous() noexcept {
-    return Handle<HwIndexBuffer>( allocateHandle(sizeof(GLIndexBuffer)) );
+    return initHandle<HwIndexBuffer>(sizeof(GLIndexBuffer));
 }
 
 Handle<HwRenderPrimitive> OpenGLDriver::createRenderPrimitiveSynchronous() noexcept {
-    return Handle<HwRenderPrimitive>( allocateHandle(sizeof(GLRenderPrimitive)) );
+    return initHandle<HwRenderPrimitive>(sizeof(GLRenderPrimitive));
 }
 
 Handle<HwProgram> OpenGLDriver::createProgramSynchronous() noexcept {
-    return Handle<HwProgram>( allocateHandle(sizeof(OpenGLProgram)) );
+    return initHandle<HwProgram>(sizeof(OpenGLProgram));
 }
 
 Handle<HwSamplerBuffer> OpenGLDriver::createSamplerBufferSynchronous() noexcept {
-    return Handle<HwSamplerBuffer>( allocateHandle(sizeof(GLSamplerBuffer)) );
+    return initHandle<HwSamplerBuffer>(sizeof(GLSamplerBuffer));
 }
 
 Handle<HwUniformBuffer> OpenGLDriver::createUniformBufferSynchronous() noexcept {
-    return Handle<HwUniformBuffer>( allocateHandle(sizeof(GLUniformBuffer)) );
+    return initHandle<HwUniformBuffer>(sizeof(GLUniformBuffer));
 }
 
 Handle<HwTexture> OpenGLDriver::createTextureSynchronous() noexcept {
-    return Handle<HwTexture>( allocateHandle(sizeof(GLTexture)) );
+    return initHandle<HwTexture>(sizeof(GLTexture));
 }
 
 Handle<HwRenderTarget> OpenGLDriver::createDefaultRenderTargetSynchronous() noexcept {
-    return Handle<HwRenderTarget>( allocateHandle(sizeof(GLRenderTarget)) );
+    return initHandle<HwRenderTarget>(sizeof(GLRenderTarget));
 }
 
 Handle<HwRenderTarget> OpenGLDriver::createRenderTargetSynchronous() noexcept {
-    return Handle<HwRenderTarget>( allocateHandle(sizeof(GLRenderTarget)) );
+    return initHandle<HwRenderTarget>(sizeof(GLRenderTarget));
 }
 
 Handle<HwFence> OpenGLDriver::createFenceSynchronous() noexcept {
-    return Handle<HwFence>( allocateHandle(sizeof(HwFence)) );
+    return initHandle<HwFence>(sizeof(HwFence));
+}
+
+Handle<HwTimerQuery> OpenGLDriver::createTimerQuerySynchronous() noexcept {
+    return initHandle<HwTimerQuery>(sizeof(GLTimerQuery));
+}
+
+Handle<HwOcclusionQuery> OpenGLDriver::createOcclusionQuerySynchronous() noexcept {
+    return initHandle<HwOcclusionQuery>(sizeof(GLOcclusionQuery));
 }
 
 Handle<HwSwapChain> OpenGLDriver::createSwapChainSynchronous() noexcept {
-    return Handle<HwSwapChain>( allocateHandle(sizeof(HwSwapChain)) );
+    return initHandle<HwSwapChain>(sizeof(HwSwapChain));
+}
+
+Handle<HwSwapChain> OpenGLDriver::createSwapChainHeadlessSynchronous() noexcept {
+    return initHandle<HwSwapChain>(sizeof(HwSwapChain));
 }
 
 Handle<HwStream> OpenGLDriver::createStreamFromTextureIdSynchronous() noexcept {
-    return Handle<HwStream>( allocateHandle(sizeof(GLStream)) );
+    return initHandle<HwStream>(sizeof(GLStream));
+}
+
+GLenum OpenGLDriver::getBufferUsage(Driver::Usage usage) noexcept {
+    switch (usage) {
+        case Driver::Usage::STATIC:     return GL_STATIC_DRAW;
+        case Driver::Usage::DYNAMIC:    return GL_DYNAMIC_DRAW;
+        case Driver::Usage::STREAM:     return GL_STREAM_DRAW;
+    }
+    return GL_STATIC_DRAW;
 }
 
 void OpenGLDriver::createVertexBuffer(
@@ -817,50 +1137,97 @@ void OpenGLDriver::createVertexBuffer(
     uint8_t bufferCount,
     uint8_t attributeCount,
     uint32_t elementCount,
-    Driver::AttributeArray attributes) {
+    Driver::AttributeArray attributes,
+    Driver::Usage usage) {
     DEBUG_MARKER()
 
     GLVertexBuffer* vb = construct<GLVertexBuffer>(vbh,
-            bufferCount, attributeCount, elementCount, attributes);
+            bufferCount, attributeCount, elementCount, attributes, usage);
 
+    allocVertexBufferStorage(vb);
+    mRecreationJournal[vbh.getId()] = { JournalEntry::Type::VERTEX_BUFFER };
+
+    CHECK_GL_ERROR(utils::slog.e)
+}
+
+// (re-)allocates the GL-side storage of a vertex buffer; everything needed is retained by
+// GLVertexBuffer, so this is also used to re-create it after a context loss.
+void OpenGLDriver::allocVertexBufferStorage(GLVertexBuffer* vb) noexcept {
     GLsizei n = GLsizei(vb->bufferCount);
-    glGenBuffers(n, vb->gl.buffers.data());
-
-    for (GLsizei i = 0; i < n; i++) {
-        // figure out the size needed for each buffer
-        size_t size = 0;
-        for (auto const& item : attributes) {
-            if (item.buffer == i) {
-                size_t end = item.offset + elementCount * item.stride;
-                size = std::max(size, end);
-            }
+
+    // figure out the size needed for each buffer
+    size_t sizes[Driver::MAX_ATTRIBUTE_BUFFER_COUNT] = {};
+    for (auto const& item : vb->attributes) {
+        if (item.buffer != 0xFF) {
+            size_t end = item.offset + vb->vertexCount * item.stride;
+            sizes[item.buffer] = std::max(sizes[item.buffer], end);
         }
-        bindBuffer(GL_ARRAY_BUFFER, vb->gl.buffers[i]);
-        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
     }
 
-    CHECK_GL_ERROR(utils::slog.e)
+    const GLenum glUsage = getBufferUsage(vb->usage);
+    if (UTILS_UNLIKELY(vb->usage == Driver::Usage::STREAM)) {
+        // allocate one round of storage per in-flight frame, so re-specifying the
+        // content doesn't force the driver to orphan or stall on in-use data
+        GLBufferRing* const ring = vb->gl.ring ? vb->gl.ring : new GLBufferRing;
+        for (auto& names : ring->names) {
+            glGenBuffers(n, names.data());
+            for (GLsizei i = 0; i < n; i++) {
+                bindBuffer(GL_ARRAY_BUFFER, names[i]);
+                glBufferData(GL_ARRAY_BUFFER, sizes[i], nullptr, glUsage);
+            }
+        }
+        ring->round = 0;
+        vb->gl.buffers = ring->names[0];
+        vb->gl.ring = ring;
+    } else {
+        glGenBuffers(n, vb->gl.buffers.data());
+        for (GLsizei i = 0; i < n; i++) {
+            bindBuffer(GL_ARRAY_BUFFER, vb->gl.buffers[i]);
+            glBufferData(GL_ARRAY_BUFFER, sizes[i], nullptr, glUsage);
+        }
+    }
 }
 
 void OpenGLDriver::createIndexBuffer(Driver::IndexBufferHandle ibh, Driver::ElementType elementType,
-        uint32_t indexCount) {
+        uint32_t indexCount, Driver::Usage usage) {
     DEBUG_MARKER()
 
     uint8_t elementSize = static_cast<uint8_t>(getElementTypeSize(elementType));
-    GLIndexBuffer* ib = construct<GLIndexBuffer>(ibh, elementSize, indexCount);
-    glGenBuffers(1, &ib->gl.buffer);
-    GLsizeiptr size = elementSize * indexCount;
-    bindVertexArray(nullptr);
-    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    GLIndexBuffer* ib = construct<GLIndexBuffer>(ibh, elementSize, indexCount, usage);
+    allocIndexBufferStorage(ib);
+    mRecreationJournal[ibh.getId()] = { JournalEntry::Type::INDEX_BUFFER };
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+// (re-)allocates the GL-side storage of an index buffer; everything needed is retained by
+// GLIndexBuffer, so this is also used to re-create it after a context loss.
+void OpenGLDriver::allocIndexBufferStorage(GLIndexBuffer* ib) noexcept {
+    GLsizeiptr size = ib->elementSize * ib->count;
+    const GLenum glUsage = getBufferUsage(ib->usage);
+    bindVertexArray(nullptr);
+    if (UTILS_UNLIKELY(ib->usage == Driver::Usage::STREAM)) {
+        GLBufferRing* const ring = ib->gl.ring ? ib->gl.ring : new GLBufferRing;
+        for (auto& names : ring->names) {
+            glGenBuffers(1, names.data());
+            bindBuffer(GL_ELEMENT_ARRAY_BUFFER, names[0]);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, glUsage);
+        }
+        ring->round = 0;
+        ib->gl.buffer = ring->names[0][0];
+        ib->gl.ring = ring;
+    } else {
+        glGenBuffers(1, &ib->gl.buffer);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, glUsage);
+    }
+}
+
 void OpenGLDriver::createRenderPrimitive(Driver::RenderPrimitiveHandle rph, int) {
     DEBUG_MARKER()
 
     GLRenderPrimitive* rp = construct<GLRenderPrimitive>(rph);
     glGenVertexArrays(1, &rp->gl.vao);
+    mRecreationJournal[rph.getId()] = { JournalEntry::Type::RENDER_PRIMITIVE };
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -875,6 +1242,7 @@ void OpenGLDriver::createSamplerBuffer(Driver::SamplerBufferHandle sbh, size_t s
     DEBUG_MARKER()
 
     construct<GLSamplerBuffer>(sbh, size);
+    mRecreationJournal[sbh.getId()] = { JournalEntry::Type::SAMPLER_BUFFER };
 }
 
 void OpenGLDriver::createUniformBuffer(Driver::UniformBufferHandle ubh, size_t size) {
@@ -884,6 +1252,7 @@ void OpenGLDriver::createUniformBuffer(Driver::UniformBufferHandle ubh, size_t s
     glGenBuffers(1, &ub->gl.ubo);
     bindBuffer(GL_UNIFORM_BUFFER, ub->gl.ubo);
     glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    mRecreationJournal[ubh.getId()] = { JournalEntry::Type::UNIFORM_BUFFER };
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -901,7 +1270,8 @@ void OpenGLDriver::textureStorage(OpenGLDriver::GLTexture* t,
             glTexStorage2D(t->gl.target, GLsizei(t->levels), t->gl.internalFormat,
                     GLsizei(width), GLsizei(height));
             break;
-        case GL_TEXTURE_3D: {
+        case GL_TEXTURE_3D:
+        case GL_TEXTURE_2D_ARRAY: {
             glTexStorage3D(t->gl.target, GLsizei(t->levels), t->gl.internalFormat,
                     GLsizei(width), GLsizei(height), GLsizei(depth));
             break;
@@ -962,6 +1332,10 @@ void OpenGLDriver::createTexture(Driver::TextureHandle th, SamplerType target, u
                 t->gl.targetIndex = (uint8_t)
                         getIndexForTextureTarget(t->gl.target = GL_TEXTURE_2D);
                 break;
+            case SamplerType::SAMPLER_2D_ARRAY:
+                t->gl.targetIndex = (uint8_t)
+                        getIndexForTextureTarget(t->gl.target = GL_TEXTURE_2D_ARRAY);
+                break;
             case SamplerType::SAMPLER_CUBEMAP:
                 t->gl.targetIndex = (uint8_t)
                         getIndexForTextureTarget(t->gl.target = GL_TEXTURE_CUBE_MAP);
@@ -986,6 +1360,8 @@ void OpenGLDriver::createTexture(Driver::TextureHandle th, SamplerType target, u
         textureStorage(t, w, h, depth);
     }
 
+    mRecreationJournal[th.getId()] = { JournalEntry::Type::TEXTURE };
+
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -999,13 +1375,17 @@ void OpenGLDriver::framebufferTexture(Driver::TargetBufferInfo& binfo,
     switch (t->target) {
         case SamplerType::SAMPLER_2D:
 #if GLES31_HEADERS
-            if (t->samples > 1 && !features.multisample_texture && ext.EXT_multisampled_render_to_texture) {
-                // we have a multi-sample texture, but multi-sampled textures are not supported,
-                // however, we have EXT_multisampled_render_to_texture -- phew.
-                // In that case, we create a multi-sampled framebuffer into our regular texture.
-                // Resolve happens automatically when sampling the texture.
+            if (rt->gl.samples > 1 && t->gl.target == GL_TEXTURE_2D
+                    && ext.EXT_multisampled_render_to_texture) {
+                // We have a multi-sampled render target backed by a regular (single-sample)
+                // texture -- either because multi-sampled textures are not supported, or
+                // because the target requested an in-tile resolve (RESOLVE_IN_TILE).
+                // EXT_multisampled_render_to_texture lets us create a multi-sampled
+                // framebuffer into that texture; the resolve happens automatically
+                // when the tile is stored, so the texture can be sampled directly.
                 glext::glFramebufferTexture2DMultisampleEXT(GL_FRAMEBUFFER,
-                        attachment, t->gl.target, t->gl.texture_id, binfo.level, t->samples);
+                        attachment, t->gl.target, t->gl.texture_id, binfo.level,
+                        rt->gl.samples);
             } else
 #endif
             {
@@ -1022,6 +1402,7 @@ void OpenGLDriver::framebufferTexture(Driver::TargetBufferInfo& binfo,
                     target, t->gl.texture_id, binfo.level);
             break;
         }
+        case SamplerType::SAMPLER_2D_ARRAY:
         case SamplerType::SAMPLER_EXTERNAL:
             // cannot happen by construction
             break;
@@ -1084,6 +1465,34 @@ void OpenGLDriver::createRenderTarget(Driver::RenderTargetHandle rth,
     GLRenderTarget* rt = construct<GLRenderTarget>(rth);
     glGenFramebuffers(1, &rt->gl.fbo);
 
+    // render targets are the one object whose creation parameters aren't all retained by
+    // their handle struct, so the journal keeps the attachment info
+    JournalEntry& entry = mRecreationJournal[rth.getId()];
+    entry.type = JournalEntry::Type::RENDER_TARGET;
+    entry.targets = targets;
+    entry.samples = samples;
+    entry.format = format;
+    entry.color = color;
+    entry.depth = depth;
+    entry.stencil = stencil;
+
+    initRenderTarget(rt, targets, width, height, samples, format, color, depth, stencil);
+
+    CHECK_GL_ERROR(utils::slog.e)
+}
+
+// builds the framebuffer and its attachments; also used to re-create the render target
+// after a context loss (with the parameters saved in the re-creation journal)
+void OpenGLDriver::initRenderTarget(GLRenderTarget* rt,
+        Driver::TargetBufferFlags targets,
+        uint32_t width,
+        uint32_t height,
+        uint8_t samples,
+        TextureFormat format,
+        Driver::TargetBufferInfo color,
+        Driver::TargetBufferInfo depth,
+        Driver::TargetBufferInfo stencil) noexcept {
+
     /*
      * Special case for GLES 3.0 (i.e. multi-sample texture not supported):
      * When we get here, textures can't be multi-sample and we can't create a framebuffer with
@@ -1099,6 +1508,17 @@ void OpenGLDriver::createRenderTarget(Driver::RenderTargetHandle rth,
         }
     }
 
+    /*
+     * An in-tile resolve (RESOLVE_IN_TILE) attaches single-sample textures to a
+     * multi-sampled framebuffer, which also requires EXT_multisampled_render_to_texture.
+     * Without it, fall back to single-sample rather than creating a framebuffer with
+     * heterogeneous sample counts.
+     */
+    if (samples > 1 && (targets & TargetBufferFlags::RESOLVE_IN_TILE)
+            && !ext.EXT_multisampled_render_to_texture) {
+        samples = 1;
+    }
+
     rt->width = width;
     rt->height = height;
     rt->gl.samples = samples;
@@ -1157,8 +1577,6 @@ void OpenGLDriver::createRenderTarget(Driver::RenderTargetHandle rth,
     if (rt->gl.color.id || rt->gl.depth.id || rt->gl.stencil.id) {
         glBindRenderbuffer(GL_RENDERBUFFER, 0);
     }
-
-    CHECK_GL_ERROR(utils::slog.e)
 }
 
 void OpenGLDriver::createFence(Driver::FenceHandle fh, int) {
@@ -1168,6 +1586,30 @@ void OpenGLDriver::createFence(Driver::FenceHandle fh, int) {
     f->fence = mPlatform.createFence();
 }
 
+void OpenGLDriver::createTimerQuery(Driver::TimerQueryHandle tqh, int) {
+    DEBUG_MARKER()
+
+    GLTimerQuery* tq = construct<GLTimerQuery>(tqh);
+#if HAS_TIMER_QUERIES
+    if (ext.EXT_disjoint_timer_query) {
+        glGenQueries(1, &tq->gl.query);
+        CHECK_GL_ERROR(utils::slog.e)
+    }
+#endif
+    mRecreationJournal[tqh.getId()] = { JournalEntry::Type::TIMER_QUERY };
+}
+
+void OpenGLDriver::createOcclusionQuery(Driver::OcclusionQueryHandle oqh, int) {
+    DEBUG_MARKER()
+
+    GLOcclusionQuery* oq = construct<GLOcclusionQuery>(oqh);
+#if HAS_OCCLUSION_QUERIES
+    glGenQueries(1, &oq->gl.query);
+    CHECK_GL_ERROR(utils::slog.e)
+#endif
+    mRecreationJournal[oqh.getId()] = { JournalEntry::Type::OCCLUSION_QUERY };
+}
+
 void OpenGLDriver::createSwapChain(Driver::SwapChainHandle sch, void* nativeWindow, uint64_t flags) {
     DEBUG_MARKER()
 
@@ -1175,6 +1617,14 @@ void OpenGLDriver::createSwapChain(Driver::SwapChainHandle sch, void* nativeWind
     sc->swapChain = mPlatform.createSwapChain(nativeWindow, flags);
 }
 
+void OpenGLDriver::createSwapChainHeadless(Driver::SwapChainHandle sch,
+        uint32_t width, uint32_t height, uint64_t flags) {
+    DEBUG_MARKER()
+
+    HwSwapChain* sc = construct<HwSwapChain>(sch);
+    sc->swapChain = mPlatform.createSwapChainHeadless(width, height, flags);
+}
+
 void OpenGLDriver::createStreamFromTextureId(Driver::StreamHandle sh,
         intptr_t externalTextureId, uint32_t width, uint32_t height) {
     DEBUG_MARKER()
@@ -1211,6 +1661,18 @@ void OpenGLDriver::destroyVertexBuffer(Driver::VertexBufferHandle vbh) {
                 target.genericBinding = 0;
             }
         }
+        if (UTILS_UNLIKELY(eb->gl.ring)) {
+            // the state cache may reference any round of the ring
+            for (auto const& names : eb->gl.ring->names) {
+                for (GLuint b : names) {
+                    if (target.genericBinding == b) {
+                        target.genericBinding = 0;
+                    }
+                }
+            }
+            destroyBufferRing(eb->gl.ring);
+        }
+        mRecreationJournal.erase(vbh.getId());
         destruct(vbh, eb);
     }
 }
@@ -1227,6 +1689,16 @@ void OpenGLDriver::destroyIndexBuffer(Driver::IndexBufferHandle ibh) {
         if (target.genericBinding == ib->gl.buffer) {
             target.genericBinding = 0;
         }
+        if (UTILS_UNLIKELY(ib->gl.ring)) {
+            // the state cache may reference any round of the ring
+            for (auto const& names : ib->gl.ring->names) {
+                if (target.genericBinding == names[0]) {
+                    target.genericBinding = 0;
+                }
+            }
+            destroyBufferRing(ib->gl.ring);
+        }
+        mRecreationJournal.erase(ibh.getId());
         destruct(ibh, ib);
     }
 }
@@ -1241,6 +1713,7 @@ void OpenGLDriver::destroyRenderPrimitive(Driver::RenderPrimitiveHandle rph) {
         if (state.vao.p == rp) {
             state.vao.p = &mDefaultVAO;
         }
+        mRecreationJournal.erase(rph.getId());
         destruct(rph, rp);
     }
 }
@@ -1259,6 +1732,7 @@ void OpenGLDriver::destroySamplerBuffer(Driver::SamplerBufferHandle sbh) {
 
     if (sbh) {
         GLSamplerBuffer* sb = handle_cast<GLSamplerBuffer*>(sbh);
+        mRecreationJournal.erase(sbh.getId());
         destruct(sbh, sb);
     }
 }
@@ -1273,13 +1747,14 @@ void OpenGLDriver::destroyUniformBuffer(Driver::UniformBufferHandle ubh) {
         const size_t targetIndex = getIndexForBufferTarget(GL_UNIFORM_BUFFER);
         auto& target = state.buffers.targets[targetIndex];
         for (auto& buffer : target.buffers) {
-            if (buffer == ub->gl.ubo) {
-                buffer = 0;
+            if (buffer.name == ub->gl.ubo) {
+                buffer = { 0, 0, 0 };
             }
         }
         if (target.genericBinding == ub->gl.ubo) {
             target.genericBinding = 0;
         }
+        mRecreationJournal.erase(ubh.getId());
         destruct(ubh, ub);
     }
 }
@@ -1297,6 +1772,7 @@ void OpenGLDriver::destroyTexture(Driver::TextureHandle th) {
             glDeleteSync(t->gl.fence);
         }
         glDeleteTextures(1, &t->gl.texture_id);
+        mRecreationJournal.erase(th.getId());
         destruct(th, t);
     }
 }
@@ -1326,6 +1802,7 @@ void OpenGLDriver::destroyRenderTarget(Driver::RenderTargetHandle rth) {
             // finally delete the framebuffer object
             glDeleteFramebuffers(1, &rt->gl.fbo);
         }
+        mRecreationJournal.erase(rth.getId());
         destruct(rth, rt);
     }
 }
@@ -1364,18 +1841,199 @@ void OpenGLDriver::destroyStream(Driver::StreamHandle sh) {
             for (auto const& info : s->user_thread.infos) {
                 mPlatform.destroyExternalTextureStorage(info.ets);
             }
+            for (uint8_t i = 0; i < s->user_thread.frameCount; i++) {
+                glDeleteSync(s->user_thread.frames[i].fence);
+            }
         }
         destruct(sh, s);
     }
 }
 
+void OpenGLDriver::destroyTimerQuery(Driver::TimerQueryHandle tqh) {
+    DEBUG_MARKER()
+
+    if (tqh) {
+        GLTimerQuery* tq = handle_cast<GLTimerQuery*>(tqh);
+#if HAS_TIMER_QUERIES
+        if (tq->gl.query) {
+            glDeleteQueries(1, &tq->gl.query);
+        }
+#endif
+        mRecreationJournal.erase(tqh.getId());
+        destruct(tqh, tq);
+    }
+}
+
+void OpenGLDriver::destroyOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+    DEBUG_MARKER()
+
+    if (oqh) {
+        GLOcclusionQuery* oq = handle_cast<GLOcclusionQuery*>(oqh);
+#if HAS_OCCLUSION_QUERIES
+        if (oq->gl.query) {
+            glDeleteQueries(1, &oq->gl.query);
+        }
+#endif
+        mRecreationJournal.erase(oqh.getId());
+        destruct(oqh, oq);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Context-loss recovery
+// ------------------------------------------------------------------------------------------------
+
+/*
+ * Re-creates the GL objects of every live handle from the re-creation journal, after the
+ * platform restored a lost context. Contents are not journaled: textures and vertex/index
+ * buffers come back with undefined contents and must be re-uploaded by their owners
+ * (re-loadable assets do this lazily); uniform buffers are re-filled from their CPU shadow
+ * copy the next time they're loaded. Programs are not journaled either -- their sources
+ * aren't retained here -- they are re-created through the material system, helped by the
+ * program binary cache when one is configured.
+ */
+void OpenGLDriver::recoverFromContextLoss() noexcept {
+    // The shadowed GL state refers to names that died with the old context; reset it to
+    // the context's default state so the re-creation below doesn't filter out binds as
+    // redundant.
+    state = State{};
+    mRasterState = {};
+    mSamplerMap.clear();        // sampler objects are re-created lazily by getSampler()
+    mRingsToFence.clear();      // the guarding fences died with the context
+
+    // in-flight readbacks are lost; return their (unwritten) buffers to their owners
+    for (auto& readback : mPendingReadbacks) {
+        scheduleDestroy(std::move(readback.p));
+    }
+    mPendingReadbacks.clear();
+
+    initClearProgram();
+
+    auto const& journal = mRecreationJournal;
+
+    // first pass: storage objects, which nothing below depends on
+    for (auto const& entry : journal) {
+        switch (entry.second.type) {
+            case JournalEntry::Type::TEXTURE: {
+                Driver::TextureHandle th(entry.first);
+                GLTexture* t = handle_cast<GLTexture*>(th);
+                t->gl.fence = nullptr;
+                if (t->gl.target == GL_TEXTURE_EXTERNAL_OES) {
+                    // owned by the stream attached to it, re-latched on the next frame
+                    break;
+                }
+                glGenTextures(1, &t->gl.texture_id);
+                textureStorage(t, t->width, t->height, t->depth);
+                break;
+            }
+            case JournalEntry::Type::VERTEX_BUFFER: {
+                Driver::VertexBufferHandle vbh(entry.first);
+                GLVertexBuffer* vb = handle_cast<GLVertexBuffer*>(vbh);
+                if (UTILS_UNLIKELY(vb->gl.ring)) {
+                    vb->gl.ring->fencePending = false;
+                    for (auto& fence : vb->gl.ring->fences) {
+                        fence = nullptr;
+                    }
+                }
+                allocVertexBufferStorage(vb);
+                break;
+            }
+            case JournalEntry::Type::INDEX_BUFFER: {
+                Driver::IndexBufferHandle ibh(entry.first);
+                GLIndexBuffer* ib = handle_cast<GLIndexBuffer*>(ibh);
+                if (UTILS_UNLIKELY(ib->gl.ring)) {
+                    ib->gl.ring->fencePending = false;
+                    for (auto& fence : ib->gl.ring->fences) {
+                        fence = nullptr;
+                    }
+                }
+                allocIndexBufferStorage(ib);
+                break;
+            }
+            case JournalEntry::Type::UNIFORM_BUFFER: {
+                Driver::UniformBufferHandle ubh(entry.first);
+                GLUniformBuffer* ub = handle_cast<GLUniformBuffer*>(ubh);
+                glGenBuffers(1, &ub->gl.ubo);
+                bindBuffer(GL_UNIFORM_BUFFER, ub->gl.ubo);
+                glBufferData(GL_UNIFORM_BUFFER, ub->ub.getSize(), ub->ub.getBuffer(),
+                        GL_DYNAMIC_DRAW);
+                break;
+            }
+            case JournalEntry::Type::SAMPLER_BUFFER: {
+                Driver::SamplerBufferHandle sbh(entry.first);
+                GLSamplerBuffer* sb = handle_cast<GLSamplerBuffer*>(sbh);
+                sb->gl.samplers = {};   // re-resolved lazily against the new sampler objects
+                break;
+            }
+            case JournalEntry::Type::TIMER_QUERY: {
+                Driver::TimerQueryHandle tqh(entry.first);
+                GLTimerQuery* tq = handle_cast<GLTimerQuery*>(tqh);
+                tq->gl.query = 0;
+                tq->gl.begun = false;
+#if HAS_TIMER_QUERIES
+                if (ext.EXT_disjoint_timer_query) {
+                    glGenQueries(1, &tq->gl.query);
+                }
+#endif
+                break;
+            }
+            case JournalEntry::Type::OCCLUSION_QUERY: {
+                Driver::OcclusionQueryHandle oqh(entry.first);
+                GLOcclusionQuery* oq = handle_cast<GLOcclusionQuery*>(oqh);
+                oq->gl.query = 0;
+                oq->gl.begun = false;
+                oq->state.store(HwOcclusionQuery::NO_RESULT, std::memory_order_relaxed);
+#if HAS_OCCLUSION_QUERIES
+                glGenQueries(1, &oq->gl.query);
+#endif
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // second pass: VAOs, which record the buffers re-created above
+    for (auto const& entry : journal) {
+        if (entry.second.type == JournalEntry::Type::RENDER_PRIMITIVE) {
+            Driver::RenderPrimitiveHandle rph(entry.first);
+            GLRenderPrimitive* rp = handle_cast<GLRenderPrimitive*>(rph);
+            glGenVertexArrays(1, &rp->gl.vao);
+            if (rp->gl.vertexBufferHandle && rp->gl.indexBufferHandle) {
+                GLVertexBuffer const* vb =
+                        handle_cast<const GLVertexBuffer*>(rp->gl.vertexBufferHandle);
+                GLIndexBuffer const* ib =
+                        handle_cast<const GLIndexBuffer*>(rp->gl.indexBufferHandle);
+                updatePrimitiveBuffers(rp, vb, ib, rp->gl.enabledAttributes);
+            }
+        }
+    }
+
+    // third pass: framebuffers, which attach the textures re-created above
+    for (auto const& entry : journal) {
+        if (entry.second.type == JournalEntry::Type::RENDER_TARGET) {
+            Driver::RenderTargetHandle rth(entry.first);
+            GLRenderTarget* rt = handle_cast<GLRenderTarget*>(rth);
+            rt->gl.color = {};
+            rt->gl.depth = {};
+            rt->gl.stencil = {};
+            glGenFramebuffers(1, &rt->gl.fbo);
+            JournalEntry const& e = entry.second;
+            initRenderTarget(rt, e.targets, rt->width, rt->height, e.samples, e.format,
+                    e.color, e.depth, e.stencil);
+        }
+    }
+
+    CHECK_GL_ERROR(utils::slog.e)
+}
+
 // ------------------------------------------------------------------------------------------------
 // Synchronous APIs
 // These are called on the application's thread
 // ------------------------------------------------------------------------------------------------
 
 Handle<HwStream> OpenGLDriver::createStream(void* nativeStream) {
-    Handle<HwStream> sh( allocateHandle(sizeof(GLStream)) );
+    Handle<HwStream> sh = initHandle<HwStream>(sizeof(GLStream));
     Platform::Stream* stream = mPlatform.createStream(nativeStream);
     construct<GLStream>(sh, stream);
     return sh;
@@ -1386,11 +2044,53 @@ void OpenGLDriver::updateStreams(driver::DriverApi* driver) {
         OpenGLBlitter::State state;
         for (GLTexture* t : mExternalStreams) {
             assert(t && t->hwStream);
-            if (!static_cast<GLStream*>(t->hwStream)->isNativeStream()) {
-                state.setup();
-                updateStream(t, driver);
+            GLStream* s = static_cast<GLStream*>(t->hwStream);
+            if (!s->isNativeStream()) {
+                if (UTILS_UNLIKELY(s->user_thread.frameCount)) {
+                    // the producer queues frames explicitly, pick one by timestamp
+                    selectStreamFrame(t, s, driver);
+                } else {
+                    state.setup();
+                    updateStream(t, driver);
+                }
+            }
+        }
+    }
+}
+
+void OpenGLDriver::queueStreamFrame(Driver::StreamHandle sh, int64_t timestampNs) {
+    if (sh) {
+        GLStream* s = handle_cast<GLStream*>(sh);
+        if (UTILS_UNLIKELY(s->isNativeStream() || !mOpenGLBlitter)) {
+            // only external-texture-id streams have a frame queue
+            return;
+        }
+        OpenGLBlitter::State state;
+        state.setup();
+
+        GLStream::Frame frame = copyStreamFrame(s);
+        frame.timestamp = timestampNs;
+
+        // drop the frame whose slot we just overwrote, if any (the producer is
+        // outpacing the renderer); the queue stays ordered oldest to newest
+        auto& ut = s->user_thread;
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < ut.frameCount; i++) {
+            if (ut.frames[i].slot == frame.slot) {
+                glDeleteSync(ut.frames[i].fence);
+            } else {
+                ut.frames[n++] = ut.frames[i];
             }
         }
+        ut.frames[n++] = frame;
+        ut.frameCount = n;
+    }
+}
+
+void OpenGLDriver::setStreamTargetLatency(Driver::StreamHandle sh, int64_t latencyNs) {
+    if (sh) {
+        GLStream* s = handle_cast<GLStream*>(sh);
+        s->user_thread.targetLatency = latencyNs;
     }
 }
 
@@ -1418,7 +2118,7 @@ Driver::FenceStatus OpenGLDriver::wait(Driver::FenceHandle fh, uint64_t timeout)
     return FenceStatus::ERROR;
 }
 
-bool OpenGLDriver::isTextureFormatSupported(Driver::TextureFormat format) {
+bool OpenGLDriver::isTextureFormatSupported(Driver::TextureFormat format) const {
     if (driver::isETC2Compression(format)) {
         return ext.texture_compression_etc2;
     }
@@ -1428,7 +2128,7 @@ bool OpenGLDriver::isTextureFormatSupported(Driver::TextureFormat format) {
     return getInternalFormat(format) != 0;
 }
 
-bool OpenGLDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) {
+bool OpenGLDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) const {
     // Supported formats per http://docs.gl/es3/glRenderbufferStorage, note that desktop OpenGL may
     // support more formats, but it requires querying GL_INTERNALFORMAT_SUPPORTED which is not
     // available in OpenGL ES.
@@ -1487,11 +2187,48 @@ bool OpenGLDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) {
     }
 }
 
-bool OpenGLDriver::isFrameTimeSupported() {
+bool OpenGLDriver::isFrameTimeSupported() const {
     // TODO: Measuring the frame time is currently only done using fences
     return mPlatform.canCreateFence();
 }
 
+bool OpenGLDriver::isInTileResolveSupported() const {
+#if GLES31_HEADERS
+    // the resolve happens in the tiler when storing the tile to the single-sample texture
+    return ext.EXT_multisampled_render_to_texture;
+#else
+    return false;
+#endif
+}
+
+bool OpenGLDriver::getTimerQueryValue(Driver::TimerQueryHandle tqh, uint64_t* elapsedTime) {
+    // this is a synchronous call, it runs on the application's thread; the result is
+    // published by the backend thread when it becomes available (see beginTimerQuery()).
+    if (tqh) {
+        GLTimerQuery* tq = handle_cast<GLTimerQuery*>(tqh);
+        uint64_t elapsed = tq->elapsed.load(std::memory_order_relaxed);
+        if (elapsed) {
+            *elapsedTime = elapsed;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OpenGLDriver::getOcclusionQueryResult(Driver::OcclusionQueryHandle oqh, bool* visible) {
+    // this is a synchronous call, it runs on the application's thread; the result is
+    // published by the backend thread when it becomes available (see beginOcclusionQuery()).
+    if (oqh) {
+        GLOcclusionQuery* oq = handle_cast<GLOcclusionQuery*>(oqh);
+        uint32_t state = oq->state.load(std::memory_order_relaxed);
+        if (state != HwOcclusionQuery::NO_RESULT) {
+            *visible = (state == HwOcclusionQuery::SAMPLES_PASSED);
+            return true;
+        }
+    }
+    return false;
+}
+
 // ------------------------------------------------------------------------------------------------
 // Swap chains
 // ------------------------------------------------------------------------------------------------
@@ -1520,6 +2257,45 @@ void OpenGLDriver::makeCurrent(Driver::SwapChainHandle schDraw, Driver::SwapChai
 // Updating driver objects
 // ------------------------------------------------------------------------------------------------
 
+// moves a STREAM buffer ring to its next round of storage, waiting on the guard fence
+// if that round is potentially still in use by the GPU. Rotates at most once per frame;
+// returns true if a rotation took place.
+bool OpenGLDriver::rotateBufferRing(GLBufferRing* ring) noexcept {
+    if (ring->fencePending) {
+        // already rotated this frame, subsequent updates go to the same round
+        return false;
+    }
+    uint8_t const round = uint8_t((ring->round + 1) % GLBufferRing::ROUNDS);
+    ring->round = round;
+    GLsync& fence = ring->fences[round];
+    if (UTILS_UNLIKELY(fence)) {
+        // the GPU may still be reading this round; with ROUNDS frames of storage this
+        // only happens when the GPU has fallen far behind
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 /* 1s */);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    ring->fencePending = true;
+    mRingsToFence.push_back(ring);
+    return true;
+}
+
+void OpenGLDriver::destroyBufferRing(GLBufferRing* ring) noexcept {
+    for (auto& names : ring->names) {
+        glDeleteBuffers(GLsizei(names.size()), names.data());
+    }
+    for (GLsync fence : ring->fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (ring->fencePending) {
+        auto& rings = mRingsToFence;
+        rings.erase(std::remove(rings.begin(), rings.end(), ring), rings.end());
+    }
+    delete ring;
+}
+
 void OpenGLDriver::loadVertexBuffer(
         Driver::VertexBufferHandle vbh,
         size_t index,
@@ -1531,6 +2307,14 @@ void OpenGLDriver::loadVertexBuffer(
 
     GLVertexBuffer* eb = handle_cast<GLVertexBuffer *>(vbh);
 
+    if (UTILS_UNLIKELY(eb->gl.ring)) {
+        GLBufferRing* const ring = eb->gl.ring;
+        if (rotateBufferRing(ring)) {
+            eb->gl.buffers = ring->names[ring->round];
+            eb->gl.bufferVersion++;
+        }
+    }
+
     bindBuffer(GL_ARRAY_BUFFER, eb->gl.buffers[index]);
     glBufferSubData(GL_ARRAY_BUFFER, byteOffset, byteSize, p.buffer);
 
@@ -1548,6 +2332,14 @@ void OpenGLDriver::loadIndexBuffer(
     GLIndexBuffer* ib = handle_cast<GLIndexBuffer *>(ibh);
     assert(ib->elementSize == 2 || ib->elementSize == 4);
 
+    if (UTILS_UNLIKELY(ib->gl.ring)) {
+        GLBufferRing* const ring = ib->gl.ring;
+        if (rotateBufferRing(ring)) {
+            ib->gl.buffer = ring->names[ring->round][0];
+            ib->gl.bufferVersion++;
+        }
+    }
+
     bindVertexArray(nullptr);
     bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, byteOffset, byteSize, p.buffer);
@@ -1562,7 +2354,13 @@ void OpenGLDriver::updateSamplerBuffer(Driver::SamplerBufferHandle sbh,
     DEBUG_MARKER()
 
     GLSamplerBuffer* sb = handle_cast<GLSamplerBuffer *>(sbh);
+    if (sb->sb->getVersion() == samplerBuffer.getVersion()) {
+        // same content generation as what we already hold, don't invalidate anything
+        return;
+    }
     *sb->sb = std::move(samplerBuffer);
+    // the resolved GL sampler objects may no longer match the new entries
+    sb->gl.samplers = {};
 }
 
 void OpenGLDriver::beginRenderPass(Driver::RenderTargetHandle rth,
@@ -1810,43 +2608,58 @@ void OpenGLDriver::setRenderPrimitiveBuffer(Driver::RenderPrimitiveHandle rph,
         GLVertexBuffer const* const eb = handle_cast<const GLVertexBuffer*>(vbh);
         GLIndexBuffer const* const ib = handle_cast<const GLIndexBuffer*>(ibh);
 
-        assert(ib->elementSize == 2 || ib->elementSize == 4);
+        rp->gl.vertexBufferHandle = vbh;
+        rp->gl.indexBufferHandle = ibh;
+        rp->gl.enabledAttributes = enabledAttributes;
+        rp->gl.usesStreamBuffers = eb->gl.ring != nullptr || ib->gl.ring != nullptr;
+        updatePrimitiveBuffers(rp, eb, ib, enabledAttributes);
+    }
+}
 
-        bindVertexArray(rp);
-        CHECK_GL_ERROR(utils::slog.e)
+// (re-)records the vertex/index buffer bindings into rp's VAO. Called from
+// setRenderPrimitiveBuffer(), and again from draw() when a STREAM buffer has rotated
+// to a new round of storage since the VAO was last recorded.
+void OpenGLDriver::updatePrimitiveBuffers(GLRenderPrimitive* rp, GLVertexBuffer const* eb,
+        GLIndexBuffer const* ib, uint32_t enabledAttributes) noexcept {
 
-        rp->gl.indicesType = ib->elementSize == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
-        rp->maxVertexCount = eb->vertexCount;
-        for (size_t i = 0, n = eb->attributes.size(); i < n; i++) {
-            if (enabledAttributes & (1U << i)) {
-                uint8_t bi = eb->attributes[i].buffer;
-                assert(bi != 0xFF);
-                bindBuffer(GL_ARRAY_BUFFER, eb->gl.buffers[bi]);
-                if (UTILS_UNLIKELY(eb->attributes[i].flags & Attribute::FLAG_INTEGER_TARGET)) {
-                    glVertexAttribIPointer(GLuint(i),
-                            getComponentCount(eb->attributes[i].type),
-                            getComponentType(eb->attributes[i].type),
-                            eb->attributes[i].stride,
-                            (void*) uintptr_t(eb->attributes[i].offset));
-                } else {
-                    glVertexAttribPointer(GLuint(i),
-                            getComponentCount(eb->attributes[i].type),
-                            getComponentType(eb->attributes[i].type),
-                            getNormalization(eb->attributes[i].flags & Attribute::FLAG_NORMALIZED),
-                            eb->attributes[i].stride,
-                            (void*) uintptr_t(eb->attributes[i].offset));
-                }
+    assert(ib->elementSize == 2 || ib->elementSize == 4);
 
-                enableVertexAttribArray(GLuint(i));
+    bindVertexArray(rp);
+    CHECK_GL_ERROR(utils::slog.e)
+
+    rp->gl.indicesType = ib->elementSize == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    rp->maxVertexCount = eb->vertexCount;
+    rp->gl.vertexBufferVersion = eb->gl.bufferVersion;
+    rp->gl.indexBufferVersion = ib->gl.bufferVersion;
+    for (size_t i = 0, n = eb->attributes.size(); i < n; i++) {
+        if (enabledAttributes & (1U << i)) {
+            uint8_t bi = eb->attributes[i].buffer;
+            assert(bi != 0xFF);
+            bindBuffer(GL_ARRAY_BUFFER, eb->gl.buffers[bi]);
+            if (UTILS_UNLIKELY(eb->attributes[i].flags & Attribute::FLAG_INTEGER_TARGET)) {
+                glVertexAttribIPointer(GLuint(i),
+                        getComponentCount(eb->attributes[i].type),
+                        getComponentType(eb->attributes[i].type),
+                        eb->attributes[i].stride,
+                        (void*) uintptr_t(eb->attributes[i].offset));
             } else {
-                disableVertexAttribArray(GLuint(i));
+                glVertexAttribPointer(GLuint(i),
+                        getComponentCount(eb->attributes[i].type),
+                        getComponentType(eb->attributes[i].type),
+                        getNormalization(eb->attributes[i].flags & Attribute::FLAG_NORMALIZED),
+                        eb->attributes[i].stride,
+                        (void*) uintptr_t(eb->attributes[i].offset));
             }
-        }
-        // this records the index buffer into the currently bound VAO
-        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
 
-        CHECK_GL_ERROR(utils::slog.e)
+            enableVertexAttribArray(GLuint(i));
+        } else {
+            disableVertexAttribArray(GLuint(i));
+        }
     }
+    // this records the index buffer into the currently bound VAO
+    bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
+
+    CHECK_GL_ERROR(utils::slog.e)
 }
 
 void OpenGLDriver::setRenderPrimitiveRange(Driver::RenderPrimitiveHandle rph,
@@ -1901,15 +2714,39 @@ void OpenGLDriver::updateUniformBuffer(Driver::UniformBufferHandle ubh,
     assert(ub);
 
     if (UTILS_UNLIKELY(uniformBuffer.isDirty())) {
-        // TODO: upload only the dirty parts
         assert(ub->gl.ubo);
         bindBuffer(GL_UNIFORM_BUFFER, ub->gl.ubo);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, uniformBuffer.getSize(), uniformBuffer.getBuffer());
+        // only upload the invalidated ranges
+        char const* const data = static_cast<char const*>(uniformBuffer.getBuffer());
+        for (size_t i = 0, c = uniformBuffer.getDirtyRangeCount(); i < c; i++) {
+            UniformBuffer::DirtyRange const range = uniformBuffer.getDirtyRange(i);
+            glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(range.begin),
+                    GLsizeiptr(range.end - range.begin), data + range.begin);
+        }
         CHECK_GL_ERROR(utils::slog.e)
     }
     ub->ub = std::move(uniformBuffer);
 }
 
+void OpenGLDriver::updateUniformBuffers(uint32_t count, Driver::BufferDescriptor&& batch) {
+    DEBUG_MARKER()
+
+    auto const* const UTILS_RESTRICT records =
+            static_cast<Driver::UniformBufferUpdateRecord const*>(batch.buffer);
+    char const* const UTILS_RESTRICT base = static_cast<char const*>(batch.buffer);
+    for (uint32_t i = 0; i < count; i++) {
+        Handle<HwUniformBuffer> ubh = records[i].ubh;
+        GLUniformBuffer* ub = handle_cast<GLUniformBuffer *>(ubh);
+        assert(ub && ub->gl.ubo);
+        bindBuffer(GL_UNIFORM_BUFFER, ub->gl.ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(records[i].bufferOffset),
+                records[i].size, base + records[i].offset);
+    }
+    CHECK_GL_ERROR(utils::slog.e)
+
+    scheduleDestroy(std::move(batch));
+}
+
 void OpenGLDriver::load2DImage(Driver::TextureHandle th,
         uint32_t level, uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
         PixelBufferDescriptor&& data) {
@@ -1925,6 +2762,21 @@ void OpenGLDriver::load2DImage(Driver::TextureHandle th,
     }
 }
 
+void OpenGLDriver::loadArrayImage(Driver::TextureHandle th, uint32_t level, uint32_t layer,
+        uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
+        PixelBufferDescriptor&& data) {
+    DEBUG_MARKER()
+
+    GLTexture* t = handle_cast<GLTexture *>(th);
+    if (data.type == driver::PixelDataType::COMPRESSED) {
+        setCompressedTextureData(t,
+                level, xoffset, yoffset, layer, width, height, 1, std::move(data), nullptr);
+    } else {
+        setTextureData(t,
+                level, xoffset, yoffset, layer, width, height, 1, std::move(data), nullptr);
+    }
+}
+
 void OpenGLDriver::loadCubeImage(Driver::TextureHandle th, uint32_t level,
         PixelBufferDescriptor&& data, FaceOffsets faceOffsets) {
     DEBUG_MARKER()
@@ -1996,6 +2848,14 @@ void OpenGLDriver::setTextureData(GLTexture* t,
                     GLint(level), GLint(xoffset), GLint(yoffset),
                     width, height, glFormat, glType, p.buffer);
             break;
+        case SamplerType::SAMPLER_2D_ARRAY:
+            assert(t->gl.target == GL_TEXTURE_2D_ARRAY);
+            bindTexture(MAX_TEXTURE_UNITS - 1, GL_TEXTURE_2D_ARRAY, t);
+            activeTexture(MAX_TEXTURE_UNITS - 1);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                    GLint(level), GLint(xoffset), GLint(yoffset), GLint(zoffset),
+                    width, height, depth, glFormat, glType, p.buffer);
+            break;
         case SamplerType::SAMPLER_CUBEMAP: {
             assert(t->gl.target == GL_TEXTURE_CUBE_MAP);
             bindTexture(MAX_TEXTURE_UNITS - 1, GL_TEXTURE_CUBE_MAP, t);
@@ -2066,6 +2926,14 @@ void OpenGLDriver::setCompressedTextureData(GLTexture* t,
                     GLint(level), GLint(xoffset), GLint(yoffset),
                     width, height, t->gl.internalFormat, imageSize, p.buffer);
             break;
+        case SamplerType::SAMPLER_2D_ARRAY:
+            assert(t->gl.target == GL_TEXTURE_2D_ARRAY);
+            bindTexture(MAX_TEXTURE_UNITS - 1, GL_TEXTURE_2D_ARRAY, t);
+            activeTexture(MAX_TEXTURE_UNITS - 1);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                    GLint(level), GLint(xoffset), GLint(yoffset), GLint(zoffset),
+                    width, height, depth, t->gl.internalFormat, imageSize, p.buffer);
+            break;
         case SamplerType::SAMPLER_CUBEMAP: {
             assert(faceOffsets);
             assert(t->gl.target == GL_TEXTURE_CUBE_MAP);
@@ -2118,6 +2986,37 @@ void OpenGLDriver::setExternalImage(Driver::TextureHandle th, void* image) {
     }
 }
 
+void OpenGLDriver::setExternalHardwareBuffer(Driver::TextureHandle th,
+        void* hardwareBuffer, int fenceFd) {
+    DEBUG_MARKER()
+
+    // insert the producer's fence into our command stream first. This is a server-side
+    // wait, it never stalls this thread -- and it disposes of fenceFd in all cases.
+    mPlatform.waitNativeFence(fenceFd);
+
+    if (ext.OES_EGL_image_external_essl3) {
+        GLTexture* t = handle_cast<GLTexture*>(th);
+
+        assert(t->target == SamplerType::SAMPLER_EXTERNAL);
+        assert(t->gl.target == GL_TEXTURE_EXTERNAL_OES);
+
+        void* image = mPlatform.createExternalImage(hardwareBuffer);
+        if (UTILS_UNLIKELY(!image)) {
+            return;
+        }
+
+        bindTexture(MAX_TEXTURE_UNITS - 1, GL_TEXTURE_EXTERNAL_OES, t);
+        activeTexture(MAX_TEXTURE_UNITS - 1);
+
+#ifdef GL_OES_EGL_image
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(image));
+#endif
+        // the texture is now a sibling of the image and keeps the client buffer's
+        // storage alive, so the image itself can go
+        mPlatform.destroyExternalImage(image);
+    }
+}
+
 void OpenGLDriver::setExternalStream(Driver::TextureHandle th, Driver::StreamHandle sh) {
     if (ext.OES_EGL_image_external_essl3) {
         DEBUG_MARKER()
@@ -2220,38 +3119,6 @@ void OpenGLDriver::updateStream(GLTexture* t, driver::DriverApi* driver) noexcep
                 }
             });
         } else {
-            s->user_thread.cur = uint8_t(
-                    (s->user_thread.cur + 1) % GLStream::ROUND_ROBIN_TEXTURE_COUNT);
-            GLuint writeTexture = s->user_thread.write[s->user_thread.cur];
-            GLuint readTexture = s->user_thread.read[s->user_thread.cur];
-
-            // Make sure we're using the proper size
-            GLStream::Info& info = s->user_thread.infos[s->user_thread.cur];
-            if (UTILS_UNLIKELY(info.width != s->width || info.height != s->height)) {
-
-                // nothing guarantees that this buffer is free (i.e. has been consumed by the
-                // GL thread), so we could potentially cause a glitch by reallocating the
-                // texture here. This should be very rare though.
-                // This could be fixed by always using a new temporary texture here, and
-                // replacing it in the queueCommand() below. imho, not worth it.
-
-                info.width = s->width;
-                info.height = s->height;
-
-                Platform::ExternalTexture* ets = s->user_thread.infos[s->user_thread.cur].ets;
-                mPlatform.reallocateExternalStorage(ets, info.width, info.height,
-                        TextureFormat::RGB8);
-
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, writeTexture);
-                glBindTexture(GL_TEXTURE_EXTERNAL_OES, readTexture);
-#ifdef GL_OES_EGL_image
-                glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)ets->image);
-                glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, (GLeglImageOES)ets->image);
-#endif
-            }
-
-            // copy the texture...
 #ifndef NDEBUG
             if (t->gl.fence) {
                 // we're about to overwrite a buffer that hasn't been consumed
@@ -2260,37 +3127,119 @@ void OpenGLDriver::updateStream(GLTexture* t, driver::DriverApi* driver) noexcep
                        << io::endl;
             }
 #endif
-            mOpenGLBlitter->blit(s->gl.externalTextureId, writeTexture, s->width, s->height);
+            GLStream::Frame frame = copyStreamFrame(s);
+            latchStreamFrame(t, s, frame.slot, frame.fence, driver);
+        }
+    }
+}
 
-            // We need a fence to guarantee that this copy has happened when we need the texture
-            // in OpenGLProgram::updateSamplers(), i.e. when we bind textures just before use.
-            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-            // Per https://www.khronos.org/opengl/wiki/Sync_Object, flush to make sure that the
-            // sync object is in the driver's command queue.
-            glFlush();
+// called on the user thread. Copies the current contents of the external texture into
+// the next round-robin slot and returns it, guarded by a fence.
+OpenGLDriver::GLStream::Frame OpenGLDriver::copyStreamFrame(GLStream* s) noexcept {
+    auto& ut = s->user_thread;
+    ut.cur = uint8_t((ut.cur + 1) % GLStream::ROUND_ROBIN_TEXTURE_COUNT);
+    GLuint writeTexture = ut.write[ut.cur];
+    GLuint readTexture = ut.read[ut.cur];
 
-            driver->queueCommand([this, t, s, fence, readTexture, writeTexture,
-                    width = info.width, height = info.height]() {
-                // the stream may have been destroyed since we enqueued the command
-                // also make sure that this texture is still associated with the same stream
-                auto& streams = mExternalStreams;
-                if (UTILS_LIKELY(std::find(streams.begin(), streams.end(), t) != streams.end()) &&
-                    (t->hwStream == s)) {
-                    if (UTILS_UNLIKELY(t->gl.fence)) {
-                        // if the texture still has a fence set, destroy it now, so it's not leaked.
-                        glDeleteSync(t->gl.fence);
-                    }
-                    t->gl.texture_id = readTexture;
-                    t->gl.fence = fence;
-                    s->gl.externalTexture2DId = writeTexture;
-                    s->gl.width = width;
-                    s->gl.height = height;
-                } else {
-                    glDeleteSync(fence);
-                }
-            });
+    // Make sure we're using the proper size
+    GLStream::Info& info = ut.infos[ut.cur];
+    if (UTILS_UNLIKELY(info.width != s->width || info.height != s->height)) {
+
+        // nothing guarantees that this buffer is free (i.e. has been consumed by the
+        // GL thread), so we could potentially cause a glitch by reallocating the
+        // texture here. This should be very rare though.
+        // This could be fixed by always using a new temporary texture here, and
+        // replacing it in latchStreamFrame()'s queueCommand(). imho, not worth it.
+
+        info.width = s->width;
+        info.height = s->height;
+
+        Platform::ExternalTexture* ets = info.ets;
+        mPlatform.reallocateExternalStorage(ets, info.width, info.height,
+                TextureFormat::RGB8);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, writeTexture);
+        glBindTexture(GL_TEXTURE_EXTERNAL_OES, readTexture);
+#ifdef GL_OES_EGL_image
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)ets->image);
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, (GLeglImageOES)ets->image);
+#endif
+    }
+
+    // copy the texture...
+    mOpenGLBlitter->blit(s->gl.externalTextureId, writeTexture, s->width, s->height);
+
+    // We need a fence to guarantee that this copy has happened when we need the texture
+    // in OpenGLProgram::updateSamplers(), i.e. when we bind textures just before use.
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Per https://www.khronos.org/opengl/wiki/Sync_Object, flush to make sure that the
+    // sync object is in the driver's command queue.
+    glFlush();
+
+    return { ut.cur, 0, fence };
+}
+
+// called on the user thread. Picks the frame to render among the queued ones -- the
+// newest frame at least targetLatency old -- and latches it; keeps the currently
+// latched frame when none is old enough yet.
+void OpenGLDriver::selectStreamFrame(GLTexture* t, GLStream* s,
+        driver::DriverApi* driver) noexcept {
+    auto& ut = s->user_thread;
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    int8_t best = -1;
+    for (int8_t i = 0; i < int8_t(ut.frameCount); i++) {
+        if (now - ut.frames[i].timestamp >= ut.targetLatency) {
+            best = i;
         }
     }
+    if (best < 0) {
+        return;
+    }
+
+    // frames older than the selected one will never be shown, drop them
+    for (int8_t i = 0; i < best; i++) {
+        glDeleteSync(ut.frames[i].fence);
+    }
+    GLStream::Frame const frame = ut.frames[best];
+    const uint8_t remaining = uint8_t(ut.frameCount - best - 1);
+    for (uint8_t i = 0; i < remaining; i++) {
+        ut.frames[i] = ut.frames[best + 1 + i];
+    }
+    ut.frameCount = remaining;
+
+    latchStreamFrame(t, s, frame.slot, frame.fence, driver);
+}
+
+// called on the user thread
+UTILS_NOINLINE
+void OpenGLDriver::latchStreamFrame(GLTexture* t, GLStream* s, uint8_t slot, GLsync fence,
+        driver::DriverApi* driver) noexcept {
+    GLuint readTexture = s->user_thread.read[slot];
+    GLuint writeTexture = s->user_thread.write[slot];
+    GLStream::Info const& info = s->user_thread.infos[slot];
+    driver->queueCommand([this, t, s, fence, readTexture, writeTexture,
+            width = info.width, height = info.height]() {
+        // the stream may have been destroyed since we enqueued the command
+        // also make sure that this texture is still associated with the same stream
+        auto& streams = mExternalStreams;
+        if (UTILS_LIKELY(std::find(streams.begin(), streams.end(), t) != streams.end()) &&
+            (t->hwStream == s)) {
+            if (UTILS_UNLIKELY(t->gl.fence)) {
+                // if the texture still has a fence set, destroy it now, so it's not leaked.
+                glDeleteSync(t->gl.fence);
+            }
+            t->gl.texture_id = readTexture;
+            t->gl.fence = fence;
+            s->gl.externalTexture2DId = writeTexture;
+            s->gl.width = width;
+            s->gl.height = height;
+        } else {
+            glDeleteSync(fence);
+        }
+    });
 }
 
 void OpenGLDriver::readStreamPixels(Driver::StreamHandle sh,
@@ -2391,6 +3340,17 @@ void OpenGLDriver::bindUniforms(size_t index, Driver::UniformBufferHandle ubh) {
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+void OpenGLDriver::bindUniformsRange(size_t index, Driver::UniformBufferHandle ubh,
+        size_t offset, size_t size) {
+    DEBUG_MARKER()
+
+    GLUniformBuffer* ub = handle_cast<GLUniformBuffer *>(ubh);
+    // the caller is responsible for aligning offset to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    bindBufferRange(GL_UNIFORM_BUFFER, GLuint(index), ub->gl.ubo,
+            GLintptr(offset), GLsizeiptr(size));
+    CHECK_GL_ERROR(utils::slog.e)
+}
+
 void OpenGLDriver::bindSamplers(size_t index, Driver::SamplerBufferHandle sbh) {
     DEBUG_MARKER()
 
@@ -2449,6 +3409,72 @@ void OpenGLDriver::popGroupMarker(int) {
 #endif
 }
 
+void OpenGLDriver::beginTimerQuery(Driver::TimerQueryHandle tqh) {
+#if HAS_TIMER_QUERIES
+    if (ext.EXT_disjoint_timer_query) {
+        GLTimerQuery* tq = handle_cast<GLTimerQuery*>(tqh);
+        // before reusing the query object, collect the result of its previous use if it's
+        // ready -- if it isn't (i.e. the GPU is more than a frame behind), that sample is
+        // simply dropped.
+        if (tq->gl.begun) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(tq->gl.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsed = 0;
+#ifdef GL_EXT_disjoint_timer_query
+                glGetQueryObjectui64vEXT(tq->gl.query, GL_QUERY_RESULT_EXT, &elapsed);
+#else
+                glGetQueryObjectui64v(tq->gl.query, GL_QUERY_RESULT, &elapsed);
+#endif
+                tq->elapsed.store(elapsed, std::memory_order_relaxed);
+            }
+        }
+        glBeginQuery(GL_TIME_ELAPSED, tq->gl.query);
+        tq->gl.begun = true;
+        CHECK_GL_ERROR(utils::slog.e)
+    }
+#endif
+}
+
+void OpenGLDriver::endTimerQuery(Driver::TimerQueryHandle tqh) {
+#if HAS_TIMER_QUERIES
+    if (ext.EXT_disjoint_timer_query) {
+        glEndQuery(GL_TIME_ELAPSED);
+        CHECK_GL_ERROR(utils::slog.e)
+    }
+#endif
+}
+
+void OpenGLDriver::beginOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+#if HAS_OCCLUSION_QUERIES
+    GLOcclusionQuery* oq = handle_cast<GLOcclusionQuery*>(oqh);
+    // before reusing the query object, collect the result of its previous use if it's
+    // ready -- if it isn't (i.e. the GPU is more than a frame behind), the previous
+    // result simply stays current a little longer.
+    if (oq->gl.begun) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(oq->gl.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint anySamplesPassed = 0;
+            glGetQueryObjectuiv(oq->gl.query, GL_QUERY_RESULT, &anySamplesPassed);
+            oq->state.store(anySamplesPassed ?
+                    HwOcclusionQuery::SAMPLES_PASSED : HwOcclusionQuery::NO_SAMPLES_PASSED,
+                    std::memory_order_relaxed);
+        }
+    }
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, oq->gl.query);
+    oq->gl.begun = true;
+    CHECK_GL_ERROR(utils::slog.e)
+#endif
+}
+
+void OpenGLDriver::endOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+#if HAS_OCCLUSION_QUERIES
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    CHECK_GL_ERROR(utils::slog.e)
+#endif
+}
+
 // ------------------------------------------------------------------------------------------------
 // Read-back ops
 // ------------------------------------------------------------------------------------------------
@@ -2494,23 +3520,60 @@ void OpenGLDriver::readPixels(Driver::RenderTargetHandle src,
     GLRenderTarget const* s = handle_cast<GLRenderTarget const*>(src);
     bindFramebuffer(GL_READ_FRAMEBUFFER, s->gl.fbo);
 
-    // TODO: we could use a PBO to make this asynchronous
-    glReadPixels(GLint(x), GLint(y), GLint(width), GLint(height), glFormat, glType, p.buffer);
+    // Read into a PBO so the GPU->CPU copy doesn't stall the pipeline. The fence below
+    // is polled in beginFrame() (see processReadbacks()) and the result is delivered a
+    // few frames later through the buffer's callback, as documented in
+    // Renderer::readPixels(). Readbacks are sparse (picking, testing), so each one gets
+    // its own buffer rather than going through a preallocated ring.
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, p.size, nullptr, GL_STATIC_READ);
+    glReadPixels(GLint(x), GLint(y), GLint(width), GLint(height), glFormat, glType, nullptr);
+    bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // make sure the sync reaches the server queue
+    glFlush();
+    mPendingReadbacks.push_back({ pbo, sync, width, height, std::move(p) });
 
-    // now we need to flip the buffer vertically to match our API
-    size_t stride = p.stride ? p.stride : width;
-    size_t bpp = PixelBufferDescriptor::computeDataSize(p.format, p.type, 1, 1, 1);
-    size_t bpr = PixelBufferDescriptor::computeDataSize(p.format, p.type, stride, 1, p.alignment);
-    char* head = (char*)p.buffer + p.left * bpp + bpr * p.top;
-    char* tail = (char*)p.buffer + p.left * bpp + bpr * (p.top + height - 1);
-    // clang vectorizes this loop
-    while (head < tail) {
-        std::swap_ranges(head, head + bpp * width, tail);
-        head += bpr;
-        tail -= bpr;
-    }
+    CHECK_GL_ERROR(utils::slog.e)
+}
 
-    scheduleDestroy(std::move(p));
+void OpenGLDriver::processReadbacks(bool wait) noexcept {
+    auto& pending = mPendingReadbacks;
+    for (auto it = pending.begin(); it != pending.end();) {
+        GLReadback& r = *it;
+        GLenum const status = glClientWaitSync(r.sync,
+                wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 /* 1s */ : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait) {
+            ++it;
+            continue;
+        }
+        // copy out of the PBO, flipping the buffer vertically to match our API
+        PixelBufferDescriptor& p = r.p;
+        bindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+        void const* const data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, p.size,
+                GL_MAP_READ_BIT);
+        if (UTILS_LIKELY(data)) {
+            size_t stride = p.stride ? p.stride : r.width;
+            size_t bpp = PixelBufferDescriptor::computeDataSize(p.format, p.type, 1, 1, 1);
+            size_t bpr = PixelBufferDescriptor::computeDataSize(
+                    p.format, p.type, stride, 1, p.alignment);
+            char const* src = (char const*)data + p.left * bpp + bpr * p.top;
+            char* dst = (char*)p.buffer + p.left * bpp + bpr * (p.top + r.height - 1);
+            for (uint32_t i = 0; i < r.height; i++) {
+                memcpy(dst, src, bpp * r.width);
+                src += bpr;
+                dst -= bpr;
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(1, &r.pbo);
+        glDeleteSync(r.sync);
+        scheduleDestroy(std::move(r.p));
+        it = pending.erase(it);
+    }
 
     CHECK_GL_ERROR(utils::slog.e)
 }
@@ -2521,6 +3584,9 @@ void OpenGLDriver::readPixels(Driver::RenderTargetHandle src,
 
 void OpenGLDriver::beginFrame(uint64_t monotonic_clock_ns, uint32_t frameId) {
     insertEventMarker("beginFrame");
+    if (UTILS_UNLIKELY(!mPendingReadbacks.empty())) {
+        processReadbacks(false);
+    }
     if (UTILS_UNLIKELY(!mExternalStreams.empty())) {
         driver::OpenGLPlatform& platform = mPlatform;
         const size_t index = getIndexForTextureTarget(GL_TEXTURE_EXTERNAL_OES);
@@ -2541,9 +3607,41 @@ void OpenGLDriver::setPresentationTime(uint64_t monotonic_clock_ns) {
     mPlatform.setPresentationTime(monotonic_clock_ns);
 }
 
+// re-records rp's VAO if one of its STREAM buffers has rotated to a new round of
+// storage since the VAO was last recorded (see GLBufferRing).
+void OpenGLDriver::refreshStreamPrimitive(GLRenderPrimitive* rp) noexcept {
+    GLVertexBuffer const* const eb =
+            handle_cast<const GLVertexBuffer*>(rp->gl.vertexBufferHandle);
+    GLIndexBuffer const* const ib =
+            handle_cast<const GLIndexBuffer*>(rp->gl.indexBufferHandle);
+    if (rp->gl.vertexBufferVersion != eb->gl.bufferVersion ||
+            rp->gl.indexBufferVersion != ib->gl.bufferVersion) {
+        updatePrimitiveBuffers(rp, eb, ib, rp->gl.enabledAttributes);
+    }
+}
+
 void OpenGLDriver::endFrame(uint32_t frameId) {
     //SYSTRACE_NAME("glFinish");
     //glFinish();
+
+    auto& rings = mRingsToFence;
+    if (UTILS_UNLIKELY(!rings.empty())) {
+        for (GLBufferRing* ring : rings) {
+            // guard the round written this frame against reuse before the commands
+            // reading it have executed
+            ring->fences[ring->round] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            ring->fencePending = false;
+        }
+        rings.clear();
+        // make sure the syncs reach the server queue
+        glFlush();
+    }
+
+    // surface the GL debug messages accumulated during the frame, if any
+    if (ext.KHR_debug) {
+        drainDebugMessages();
+    }
+
     insertEventMarker("endFrame");
 }
 
@@ -2648,6 +3746,9 @@ void OpenGLDriver::blit(TargetBufferFlags buffers,
     }
 
     if (mask) {
+        // GL_LINEAR is only valid for color blits; depth/stencil blits require GL_NEAREST
+        GLenum filter = (mask & (GLbitfield(GL_DEPTH_BUFFER_BIT) | GLbitfield(GL_STENCIL_BUFFER_BIT)))
+                ? GL_NEAREST : GL_LINEAR;
         GLRenderTarget const* s = handle_cast<GLRenderTarget const*>(src);
         GLRenderTarget const* d = handle_cast<GLRenderTarget const*>(dst);
         bindFramebuffer(GL_READ_FRAMEBUFFER, s->gl.fbo);
@@ -2656,7 +3757,7 @@ void OpenGLDriver::blit(TargetBufferFlags buffers,
         glBlitFramebuffer(
                 srcLeft, srcBottom, srcLeft + srcWidth, srcBottom + srcHeight,
                 dstLeft, dstBottom, dstLeft + dstWidth, dstBottom + dstHeight,
-                mask, GL_LINEAR);
+                mask, filter);
         enable(GL_SCISSOR_TEST);
         CHECK_GL_ERROR(utils::slog.e)
     }
@@ -2665,23 +3766,63 @@ void OpenGLDriver::blit(TargetBufferFlags buffers,
 void OpenGLDriver::draw(
         Driver::ProgramHandle ph,
         Driver::RasterState rs,
-        Driver::RenderPrimitiveHandle rph) {
+        Driver::RenderPrimitiveHandle rph,
+        uint32_t instanceCount) {
     DEBUG_MARKER()
 
     OpenGLProgram* p = handle_cast<OpenGLProgram*>(ph);
     useProgram(p);
 
     const GLRenderPrimitive* rp = handle_cast<const GLRenderPrimitive *>(rph);
+    if (UTILS_UNLIKELY(rp->gl.usesStreamBuffers)) {
+        refreshStreamPrimitive(const_cast<GLRenderPrimitive*>(rp));
+    }
     bindVertexArray(rp);
 
     setRasterState(rs);
 
-    glDrawRangeElements(GLenum(rp->type), rp->minIndex, rp->maxIndex, rp->count,
-            rp->gl.indicesType, reinterpret_cast<const void*>(rp->offset));
+    if (UTILS_UNLIKELY(instanceCount > 1)) {
+        glDrawElementsInstanced(GLenum(rp->type), rp->count, rp->gl.indicesType,
+                reinterpret_cast<const void*>(rp->offset), GLsizei(instanceCount));
+    } else {
+        glDrawRangeElements(GLenum(rp->type), rp->minIndex, rp->maxIndex, rp->count,
+                rp->gl.indicesType, reinterpret_cast<const void*>(rp->offset));
+    }
 
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+void OpenGLDriver::drawConditional(
+        Driver::ProgramHandle ph,
+        Driver::RasterState rs,
+        Driver::RenderPrimitiveHandle rph,
+        uint32_t instanceCount,
+        Driver::OcclusionQueryHandle oqh) {
+#if HAS_OCCLUSION_QUERIES
+    if (oqh) {
+        GLOcclusionQuery* oq = handle_cast<GLOcclusionQuery*>(oqh);
+#ifdef GL_QUERY_NO_WAIT
+        // desktop GL: predicate the draw on the GPU itself; NO_WAIT draws if the
+        // query result isn't available yet, so a slow GPU never causes false culls
+        if (oq->gl.begun) {
+            glBeginConditionalRender(oq->gl.query, GL_QUERY_NO_WAIT);
+            draw(ph, rs, rph, instanceCount);
+            glEndConditionalRender();
+            CHECK_GL_ERROR(utils::slog.e)
+            return;
+        }
+#else
+        // GLES has no conditional rendering: consult the last collected result,
+        // skipping only when the query positively reported zero samples
+        if (oq->state.load(std::memory_order_relaxed) == HwOcclusionQuery::NO_SAMPLES_PASSED) {
+            return;
+        }
+#endif
+    }
+#endif
+    draw(ph, rs, rph, instanceCount);
+}
+
 // explicit instantiation of the Dispatcher
 template class ConcreteDispatcher<OpenGLDriver>;
 
@@ -19,6 +19,7 @@
 
 #include "driver/Driver.h"
 #include "driver/DriverBase.h"
+#include "driver/ProgramBinaryCache.h"
 #include "driver/opengl/GLUtils.h"
 
 #include <utils/compiler.h>
@@ -28,7 +29,10 @@
 
 #include <tsl/robin_map.h>
 
+#include <atomic>
+#include <mutex>
 #include <set>
+#include <thread>
 
 #include <assert.h>
 
@@ -49,11 +53,25 @@ class OpenGLDriver final : public DriverBase {
 public:
     static Driver* create(driver::OpenGLPlatform* platform, void* sharedGLContext) noexcept;
 
+    // Fenced multi-buffered storage backing Usage::STREAM vertex/index buffers: each
+    // re-specification rotates to the next round of GL buffer objects, and a fence
+    // created at the end of the frame that last wrote a round guards its reuse
+    // (see loadVertexBuffer() / endFrame()). Heap-allocated to keep the handles small.
+    struct GLBufferRing {
+        static constexpr size_t ROUNDS = 3;     // frames of storage
+        std::array<GLuint, Driver::MAX_ATTRIBUTE_BUFFER_COUNT> names[ROUNDS] = {};
+        GLsync fences[ROUNDS] = {};
+        uint8_t round = 0;
+        bool fencePending = false;              // queued for a fence at endFrame()
+    };
+
     // OpenGLDriver specific fields
     struct GLVertexBuffer : public HwVertexBuffer {
         using HwVertexBuffer::HwVertexBuffer;
         struct {
             std::array<GLuint, MAX_ATTRIBUTE_BUFFER_COUNT> buffers;  // 4*6 bytes
+            GLBufferRing* ring = nullptr;       // only for Usage::STREAM
+            uint8_t bufferVersion = 0;          // bumped when the ring rotates
         } gl;
     };
 
@@ -61,6 +79,8 @@ public:
         using HwIndexBuffer::HwIndexBuffer;
         struct {
             GLuint buffer;
+            GLBufferRing* ring = nullptr;       // only for Usage::STREAM
+            uint8_t bufferVersion = 0;          // bumped when the ring rotates
         } gl;
     };
 
@@ -71,6 +91,13 @@ public:
             GLenum indicesType = GL_UNSIGNED_INT;
             GLuint elementArray = 0;
             utils::bitset32 vertexAttribArray;
+            // so the VAO can be re-specified when a STREAM buffer rotates its storage
+            Driver::VertexBufferHandle vertexBufferHandle;
+            Driver::IndexBufferHandle indexBufferHandle;
+            uint32_t enabledAttributes = 0;
+            uint8_t vertexBufferVersion = 0;
+            uint8_t indexBufferVersion = 0;
+            bool usesStreamBuffers = false;
         } gl;
     };
 
@@ -127,6 +154,13 @@ public:
             GLuint fbo = 0;
         } gl;
 
+        // a frame copied into one of the round-robin slots (see queueStreamFrame())
+        struct Frame {
+            uint8_t slot;
+            int64_t timestamp;
+            GLsync fence;
+        };
+
         /*
          * The fields below are access from the main application thread
          * (not the GL thread)
@@ -138,12 +172,40 @@ public:
             GLuint write[ROUND_ROBIN_TEXTURE_COUNT];
             Info infos[ROUND_ROBIN_TEXTURE_COUNT];
             uint8_t cur = 0;
+            // producer frame queue, ordered oldest to newest. Empty when the stream
+            // is driven by the legacy copy-on-beginFrame path instead.
+            Frame frames[ROUND_ROBIN_TEXTURE_COUNT];
+            uint8_t frameCount = 0;
+            int64_t targetLatency = 0;
         } user_thread;
     };
 
     struct GLSamplerBuffer : public HwSamplerBuffer {
         using HwSamplerBuffer::HwSamplerBuffer;
         struct {
+            // GL sampler object for each entry, resolved lazily from its SamplerParams
+            // (0 = not resolved yet, glGenSamplers never returns 0). This keeps the
+            // sampler-map lookup off the texture bind hot path; reset whenever the
+            // buffer's contents are replaced. The size matches SamplerBuffer's capacity.
+            std::array<GLuint, 16> samplers = {};
+        } gl;
+    };
+
+    struct GLTimerQuery : public HwTimerQuery {
+        struct {
+            GLuint query = 0;
+            // whether this query object has been used at least once (i.e. it's legal
+            // to ask for its result)
+            bool begun = false;
+        } gl;
+    };
+
+    struct GLOcclusionQuery : public HwOcclusionQuery {
+        struct {
+            GLuint query = 0;
+            // whether this query object has been used at least once (i.e. it's legal
+            // to ask for its result)
+            bool begun = false;
         } gl;
     };
 
@@ -175,6 +237,12 @@ public:
 
     void useProgram(GLuint program) noexcept;
 
+    // Called (on the driver thread) by the platform after it restored a lost GL context
+    // (e.g. EGL_CONTEXT_LOST on Android): re-creates the GL objects of all live handles
+    // from the re-creation journal. See the journal below for what is -- and is not --
+    // recovered.
+    void recoverFromContextLoss() noexcept;
+
     OpenGLDriver(OpenGLDriver const&) = delete;
     OpenGLDriver& operator=(OpenGLDriver const&) = delete;
 
@@ -194,6 +262,9 @@ private:
 #define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params) \
     RetType methodName(paramsDecl) override;
 
+#define DECL_DRIVER_API_SYNCHRONOUS_CONST(RetType, methodName, paramsDecl, params) \
+    RetType methodName(paramsDecl) const override;
+
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) \
     RetType methodName##Synchronous() noexcept override; \
     UTILS_ALWAYS_INLINE void methodName(RetType, paramsDecl);
@@ -204,9 +275,28 @@ private:
     // Memory management...
 
     class HandleAllocator {
-        utils::PoolAllocator< 16, 16>   mPool0;
-        utils::PoolAllocator< 64, 32>   mPool1;
-        utils::PoolAllocator<128, 32>   mPool2;
+        static constexpr size_t POOL_COUNT = 3;
+        utils::PoolAllocator< 16, 16, 0, utils::AtomicFreeList>   mPool0;
+        utils::PoolAllocator< 64, 32, 0, utils::AtomicFreeList>   mPool1;
+        utils::PoolAllocator<128, 32, 0, utils::AtomicFreeList>   mPool2;
+
+        // Small per-thread cache in front of each pool. Handles are typically allocated on
+        // the user thread and freed on the driver thread, so the caches are refilled and
+        // spilled in batches through the pools' lock-free freelists; in steady state,
+        // create/destroy churn never contends on a shared freelist.
+        static constexpr size_t CACHE_CAPACITY = 16;
+        struct ThreadCache {
+            std::atomic<std::thread::id> tid = { std::thread::id{} };
+            void* blocks[POOL_COUNT][CACHE_CAPACITY];
+            size_t count[POOL_COUNT] = { 0, 0, 0 };
+        };
+        // enough for the user and driver threads, with some slack
+        ThreadCache mThreadCaches[4];
+
+        ThreadCache* getThreadCache() noexcept;
+        void* allocFromPool(size_t index) noexcept;
+        void freeToPool(size_t index, void* p) noexcept;
+        static size_t poolIndex(size_t size) noexcept;
     public:
         static constexpr size_t MIN_ALIGNMENT_SHIFT = 4;
         explicit HandleAllocator(const utils::HeapArea& area);
@@ -214,20 +304,52 @@ private:
         void free(void* p, size_t size) noexcept;
     };
 
-    // the arenas for handle allocation needs to be thread-safe
+    // the arena for handle allocation needs to be thread-safe; the allocator itself is
+    // lock-free, so the arena only takes a lock in debug builds to keep the watermark
+    // tracking consistent.
 #ifndef NDEBUG
     using HandleArena = utils::Arena<HandleAllocator,
             utils::LockingPolicy::SpinLock,
             utils::TrackingPolicy::HighWatermark>;
 #else
     using HandleArena = utils::Arena<HandleAllocator,
-            utils::LockingPolicy::SpinLock>;
+            utils::LockingPolicy::NoLock>;
 #endif
 
     HandleArena mHandleArena;
 
+#if !defined(NDEBUG) && UTILS_HAS_RTTI
+    // number of live handles per concrete type, updated from the driver thread as handles
+    // are constructed and destructed; leaks are logged when the driver terminates.
+    tsl::robin_map<const char*, int32_t> mLiveHandleCounts;
+#endif
+
+#ifndef NDEBUG
+    // Current generation of each handle slot, bumped when the slot's object is
+    // destroyed. Handles are stamped with the generation they were created under, so
+    // using a destroyed handle -- including one whose slot has since been recycled --
+    // is caught in handle_cast. Guarded by a spin-lock because slots are created on
+    // the user thread but destroyed and cast on the driver thread.
+    mutable utils::LockingPolicy::SpinLock mHandleGenerationsLock;
+    tsl::robin_map<HandleBase::HandleId, HandleBase::HandleId> mHandleGenerations;
+
+    void debugCheckHandle(HandleBase const& handle) noexcept;
+#endif
+
     HandleBase::HandleId allocateHandle(size_t size) noexcept;
 
+    // creates a handle to a newly allocated slot, stamped with the slot's current
+    // generation in debug builds
+    template<typename B>
+    Handle<B> initHandle(size_t size) noexcept {
+        Handle<B> h{ allocateHandle(size) };
+#ifndef NDEBUG
+        std::lock_guard<utils::LockingPolicy::SpinLock> guard(mHandleGenerationsLock);
+        h.setGeneration(mHandleGenerations[h.getId()]);
+#endif
+        return h;
+    }
+
     template<typename D, typename B, typename ... ARGS>
     typename std::enable_if<std::is_base_of<B, D>::value, D>::type*
             construct(Handle<B> const& handle, ARGS&& ... args) noexcept;
@@ -249,6 +371,9 @@ private:
             std::is_pointer<Dp>::value &&
             std::is_base_of<B, typename std::remove_pointer<Dp>::type>::value, Dp>::type
     handle_cast(Handle<B>& handle) noexcept {
+#ifndef NDEBUG
+        debugCheckHandle(handle);
+#endif
         char* const base = (char *)mHandleArena.getArea().begin();
         size_t offset = handle.getId() << HandleAllocator::MIN_ALIGNMENT_SHIFT;
         return static_cast<Dp>(static_cast<void *>(base + offset));
@@ -324,6 +449,8 @@ private:
 
     inline void bindBuffer(GLenum target, GLuint buffer) noexcept;
     inline void bindBufferBase(GLenum target, GLuint index, GLuint buffer) noexcept;
+    inline void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+            GLintptr offset, GLsizeiptr size) noexcept;
 
     inline void bindFramebuffer(GLenum target, GLuint buffer) noexcept;
 
@@ -360,6 +487,10 @@ private:
         return mSamplerBindings;
     }
 
+    driver::ProgramBinaryCache& getProgramBinaryCache() noexcept {
+        return mProgramBinaryCache;
+    }
+
     GLsizei getAttachments(std::array<GLenum, 3>& attachments,
             GLRenderTarget const* rt, uint8_t buffers) const noexcept;
 
@@ -369,9 +500,27 @@ private:
     GLRenderPrimitive mDefaultVAO;
     GLint mMaxRenderBufferSize = 0;
 
+#ifndef NDEBUG
+    // how many state changes were requested vs. actually issued to GL, so the win of
+    // redundant-state filtering can be measured on a given device (logged at termination)
+    struct {
+        uint32_t requested = 0;
+        uint32_t issued = 0;
+    } mStateChangeStats;
+#endif
+
+    inline void countStateChange(bool issued) noexcept {
+#ifndef NDEBUG
+        mStateChangeStats.requested++;
+        mStateChangeStats.issued += issued ? 1 : 0;
+#endif
+    }
+
     template <typename T, typename F>
     inline void update_state(T& state, T const& expected, F functor, bool force = false) noexcept {
-        if (UTILS_UNLIKELY(force || state != expected)) {
+        const bool changed = force || state != expected;
+        countStateChange(changed);
+        if (UTILS_UNLIKELY(changed)) {
             state = expected;
             functor();
         }
@@ -409,7 +558,13 @@ private:
 
         struct {
             struct {
-                GLuint buffers[MAX_BUFFER_BINDINGS] = { 0 };
+                // an indexed binding with size == 0 covers the whole buffer
+                // (i.e. it was established with glBindBufferBase)
+                struct {
+                    GLuint name = 0;
+                    GLintptr offset = 0;
+                    GLsizeiptr size = 0;
+                } buffers[MAX_BUFFER_BINDINGS];
                 GLuint genericBinding = 0;
             } targets[8];
         } buffers;
@@ -420,7 +575,7 @@ private:
                 GLuint sampler = 0;
                 struct {
                     GLuint texture_id = 0;
-                } targets[5];
+                } targets[6];
             } units[MAX_TEXTURE_UNITS];
         } textures;
 
@@ -485,6 +640,10 @@ private:
     mutable tsl::robin_map<uint32_t, GLuint> mSamplerMap;
     mutable std::vector<GLTexture*> mExternalStreams;
 
+    // persisted program binaries (see ProgramBinaryCache.h); empty and inert unless the
+    // application configured a cache directory
+    driver::ProgramBinaryCache mProgramBinaryCache;
+
     // features supported by this version of GL or GLES
     struct {
         bool multisample_texture = false;
@@ -500,6 +659,8 @@ private:
         bool EXT_debug_marker = false;
         bool EXT_color_buffer_half_float = false;
         bool EXT_multisampled_render_to_texture = false;
+        bool EXT_disjoint_timer_query = false;
+        bool KHR_debug = false;
     } ext;
 
     struct {
@@ -531,10 +692,99 @@ private:
     void detachStream(GLTexture* t) noexcept;
     void replaceStream(GLTexture* t, GLStream* stream) noexcept;
 
+    // STREAM buffer support (see GLBufferRing)
+    static GLenum getBufferUsage(Driver::Usage usage) noexcept;
+    bool rotateBufferRing(GLBufferRing* ring) noexcept;
+    void destroyBufferRing(GLBufferRing* ring) noexcept;
+    void updatePrimitiveBuffers(GLRenderPrimitive* rp, GLVertexBuffer const* eb,
+            GLIndexBuffer const* ib, uint32_t enabledAttributes) noexcept;
+    void refreshStreamPrimitive(GLRenderPrimitive* rp) noexcept;
+    // rings rotated since the last endFrame(), waiting for their guard fence
+    std::vector<GLBufferRing*> mRingsToFence;
+
+    // Asynchronous readbacks (see readPixels()): each one reads into a PBO guarded by a
+    // fence; the fences are polled in beginFrame() and the result is delivered a few
+    // frames later through the buffer's callback (via scheduleDestroy()).
+    struct GLReadback {
+        GLuint pbo;
+        GLsync sync;
+        uint32_t width;
+        uint32_t height;
+        Driver::PixelBufferDescriptor p;
+    };
+    void processReadbacks(bool wait) noexcept;
+    std::vector<GLReadback> mPendingReadbacks;
+
+    /*
+     * GL error surveillance (see initDebugOutput()): with KHR_debug the GL reports errors
+     * by invoking a callback -- potentially from a driver-internal thread -- instead of us
+     * polling glGetError(), which serializes the pipeline. The callback deposits each
+     * message into this fixed-size lock-free ring (a bounded queue with per-slot sequence
+     * numbers); endFrame() drains it to the log from the driver thread. When the ring is
+     * full, messages are dropped and counted -- the reporting thread is never blocked, so
+     * error monitoring can stay enabled in production builds at near-zero cost.
+     */
+    static constexpr uint32_t DEBUG_MESSAGE_COUNT = 32;     // must be a power-of-two
+    struct DebugMessageSlot {
+        std::atomic<uint32_t> seq;
+        GLenum source;
+        GLenum type;
+        GLuint id;
+        GLenum severity;
+        char text[104];                                     // truncated if longer
+    };
+    void initDebugOutput() noexcept;
+    void pushDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+            size_t length, const char* message) noexcept;
+    void drainDebugMessages() noexcept;
+    static void debugMessageCallback(GLenum source, GLenum type, GLuint id,
+            GLenum severity, GLsizei length, const GLchar* message,
+            const void* userParam) noexcept;
+    DebugMessageSlot mDebugMessageRing[DEBUG_MESSAGE_COUNT];
+    std::atomic<uint32_t> mDebugMessageHead{ 0 };           // written by reporting threads
+    uint32_t mDebugMessageTail = 0;                         // driver thread only
+    std::atomic<uint32_t> mDebugMessagesDropped{ 0 };
+
+    /*
+     * Context-loss re-creation journal (see recoverFromContextLoss()): one entry per live
+     * handle whose GL objects must be re-created after a context loss. Only creation
+     * parameters are journaled (sizes, formats, usage -- never contents); most of them
+     * already live in the Hw* structs, which survive the loss, so entries carry just the
+     * object kind plus the attachment info of render targets, which isn't retained
+     * anywhere else. Contents come back undefined and are re-uploaded by their owners.
+     */
+    struct JournalEntry {
+        enum class Type : uint8_t {
+            VERTEX_BUFFER, INDEX_BUFFER, UNIFORM_BUFFER, SAMPLER_BUFFER,
+            RENDER_PRIMITIVE, TEXTURE, RENDER_TARGET, TIMER_QUERY, OCCLUSION_QUERY
+        };
+        Type type;
+        // RENDER_TARGET only: creation parameters not retained by GLRenderTarget
+        Driver::TargetBufferFlags targets = {};
+        uint8_t samples = 1;
+        Driver::TextureFormat format = {};
+        Driver::TargetBufferInfo color;
+        Driver::TargetBufferInfo depth;
+        Driver::TargetBufferInfo stencil;
+    };
+    tsl::robin_map<HandleBase::HandleId, JournalEntry> mRecreationJournal;
+
+    // storage (re-)allocation, shared between createXxxBuffer() and recoverFromContextLoss()
+    void allocVertexBufferStorage(GLVertexBuffer* vb) noexcept;
+    void allocIndexBufferStorage(GLIndexBuffer* ib) noexcept;
+    void initRenderTarget(GLRenderTarget* rt, Driver::TargetBufferFlags targets,
+            uint32_t width, uint32_t height, uint8_t samples, TextureFormat format,
+            Driver::TargetBufferInfo color, Driver::TargetBufferInfo depth,
+            Driver::TargetBufferInfo stencil) noexcept;
+
     driver::OpenGLPlatform& mPlatform;
 
     OpenGLBlitter* mOpenGLBlitter = nullptr;
     void updateStream(GLTexture* t, driver::DriverApi* driver) noexcept;
+    GLStream::Frame copyStreamFrame(GLStream* s) noexcept;
+    void selectStreamFrame(GLTexture* t, GLStream* s, driver::DriverApi* driver) noexcept;
+    void latchStreamFrame(GLTexture* t, GLStream* s, uint8_t slot, GLsync fence,
+            driver::DriverApi* driver) noexcept;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -546,6 +796,7 @@ constexpr size_t OpenGLDriver::getIndexForTextureTarget(GLuint target) noexcept
         case GL_TEXTURE_CUBE_MAP:       return 2;
         case GL_TEXTURE_2D_MULTISAMPLE: return 3;
         case GL_TEXTURE_EXTERNAL_OES:   return 4;
+        case GL_TEXTURE_2D_ARRAY:       return 5;
         default:                        return 0;
     }
 }
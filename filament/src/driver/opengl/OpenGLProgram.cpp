@@ -18,6 +18,7 @@
 
 #include <cctype>
 #include <sstream>
+#include <vector>
 
 #include <utils/Log.h>
 #include <utils/compiler.h>
@@ -30,6 +31,15 @@ namespace filament {
 using namespace math;
 using namespace utils;
 
+// FNV-1a over the shader sources; the resulting key identifies a program in the binary cache
+// across runs.
+static uint64_t hashShaderSource(char const* data, size_t size, uint64_t hash) noexcept {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ uint8_t(data[i])) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
 OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) noexcept
         :  HwProgram(programBuilder.getName()), mIsValid(false) {
 
@@ -37,9 +47,33 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
 
     const auto& shadersSource = programBuilder.getShadersSource();
 
-    // build all shaders
+    // Try the binary cache first: on a warm start this skips compilation and link entirely.
+    driver::ProgramBinaryCache& cache = gl->getProgramBinaryCache();
+    uint64_t cacheKey = 0xcbf29ce484222325ull;
+    GLuint program = 0;
+    if (cache.isEnabled()) {
+        for (size_t i = 0; i < Program::NUM_SHADER_TYPES; i++) {
+            cacheKey = hashShaderSource(shadersSource[i].c_str(),
+                    shadersSource[i].length(), cacheKey);
+        }
+        driver::ProgramBinaryCache::Blob const* const blob = cache.get(cacheKey);
+        if (blob) {
+            GLint status;
+            program = glCreateProgram();
+            glProgramBinary(program, blob->format, blob->data.data(), GLsizei(blob->data.size()));
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            if (UTILS_UNLIKELY(status != GL_TRUE)) {
+                // the binary was rejected (this shouldn't happen since the cache is keyed by
+                // the driver version, but it's allowed to), fall back to source compilation
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+    }
+
+    // build all shaders (unless the binary cache provided the program)
     #pragma nounroll
-    for (size_t i = 0; i < Program::NUM_SHADER_TYPES; i++) {
+    for (size_t i = 0; !program && i < Program::NUM_SHADER_TYPES; i++) {
         GLenum glShaderType;
         Shader type = (Shader)i;
         switch (type) {
@@ -52,19 +86,16 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
         }
 
         if (shadersSource[i].length()) {
-            GLint status;
             char const* const source = shadersSource[i].c_str();
 
             GLuint shaderId = glCreateShader(glShaderType);
             glShaderSource(shaderId, 1, &source, nullptr);
             glCompileShader(shaderId);
 
-            glGetShaderiv(shaderId, GL_COMPILE_STATUS, &status);
-            if (UTILS_UNLIKELY(status != GL_TRUE)) {
-                logCompilationError(slog.e, shaderId, source);
-                glDeleteShader(shaderId);
-                return;
-            }
+            // the compile status is deliberately not queried here: that's a sync point
+            // that would serialize the compiles, while without it drivers with a threaded
+            // compiler can overlap both shaders (and the link). Errors are detected when
+            // the link below fails, and logged then.
             this->gl.shaders[i] = shaderId;
             mValidShaderSet |= 1U << i;
         }
@@ -73,24 +104,57 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
     // we need at least a vertex and fragment program
     const uint8_t validShaderSet = mValidShaderSet;
     const uint8_t mask = VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT;
-    if (UTILS_LIKELY((mValidShaderSet & mask) == mask)) {
+    if (UTILS_LIKELY(program || (validShaderSet & mask) == mask)) {
         GLint status;
-        GLuint program = glCreateProgram();
-        for (size_t i = 0; i < Program::NUM_SHADER_TYPES; i++) {
-            if (validShaderSet & (1U << i)) {
-                glAttachShader(program, this->gl.shaders[i]);
+        if (!program) {
+            program = glCreateProgram();
+            for (size_t i = 0; i < Program::NUM_SHADER_TYPES; i++) {
+                if (validShaderSet & (1U << i)) {
+                    glAttachShader(program, this->gl.shaders[i]);
+                }
             }
-        }
-        glLinkProgram(program);
+            if (cache.isEnabled()) {
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glLinkProgram(program);
 
-        glGetProgramiv(program, GL_LINK_STATUS, &status);
-        if (UTILS_UNLIKELY(status != GL_TRUE)) {
-            char error[512];
-            glGetProgramInfoLog(program, sizeof(error), nullptr, error);
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            if (UTILS_UNLIKELY(status != GL_TRUE)) {
+                // a failed compile also fails the link, so this is where we retrieve
+                // the compile status we skipped above, for diagnostics
+                for (size_t i = 0; i < Program::NUM_SHADER_TYPES; i++) {
+                    if (validShaderSet & (1U << i)) {
+                        GLint compileStatus;
+                        glGetShaderiv(this->gl.shaders[i], GL_COMPILE_STATUS, &compileStatus);
+                        if (compileStatus != GL_TRUE) {
+                            logCompilationError(slog.e, this->gl.shaders[i],
+                                    shadersSource[i].c_str());
+                        }
+                    }
+                }
+                char error[512];
+                glGetProgramInfoLog(program, sizeof(error), nullptr, error);
 
-            slog.e << "LINKING: " << error << io::endl;
-            glDeleteProgram(program);
-            return;
+                slog.e << "LINKING: " << error << io::endl;
+                glDeleteProgram(program);
+                return;
+            }
+
+            // stash the binary so the next start skips this whole path
+            if (cache.isEnabled()) {
+                GLint binaryLength = 0;
+                glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+                if (binaryLength > 0) {
+                    std::vector<uint8_t> binary(size_t(binaryLength), 0);
+                    GLenum binaryFormat = 0;
+                    GLsizei written = 0;
+                    glGetProgramBinary(program, binaryLength, &written, &binaryFormat,
+                            binary.data());
+                    if (written > 0) {
+                        cache.put(cacheKey, binaryFormat, binary.data(), size_t(written));
+                    }
+                }
+            }
         }
         this->gl.program = program;
 
@@ -203,7 +267,8 @@ void OpenGLProgram::updateSamplers(OpenGLDriver* gl) noexcept {
     UTILS_ASSUME(mUsedBindingsCount > 0);
     for (uint8_t i = 0, tmu = 0, n = mUsedBindingsCount; i < n; i++) {
         BlockInfo blockInfo = blockInfos[i];
-        HwSamplerBuffer const * const UTILS_RESTRICT hwsb = samplerBindings[blockInfo.binding];
+        auto* const UTILS_RESTRICT hwsb =
+                static_cast<OpenGLDriver::GLSamplerBuffer*>(samplerBindings[blockInfo.binding]);
         SamplerBuffer const& UTILS_RESTRICT sb = *(hwsb->sb);
         SamplerBuffer::Sampler const* const UTILS_RESTRICT samplers = sb.getBuffer();
         for (uint8_t j = 0, m = blockInfo.count ; j <= m; ++j, ++tmu) { // "<=" on purpose here
@@ -224,8 +289,13 @@ void OpenGLProgram::updateSamplers(OpenGLDriver* gl) noexcept {
 
             gl->bindTexture(tmu, t->gl.target, t, t->gl.targetIndex);
 
-            // FIXME: getSampler() is expensive because it's a hashmap lookup
-            GLuint sampler = gl->getSampler(samplers[index].s);
+            // getSampler() is a hashmap lookup, so cache the resolved sampler object in the
+            // sampler buffer itself; the cache is reset when the buffer is updated
+            GLuint sampler = hwsb->gl.samplers[index];
+            if (UTILS_UNLIKELY(sampler == 0)) {
+                sampler = gl->getSampler(samplers[index].s);
+                hwsb->gl.samplers[index] = sampler;
+            }
             gl->bindSampler(tmu, sampler);
         }
     }
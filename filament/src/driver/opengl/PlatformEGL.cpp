@@ -19,6 +19,7 @@
 #include <jni.h>
 
 #include <assert.h>
+#include <unistd.h>
 
 #include <string>
 #include <unordered_set>
@@ -53,6 +54,7 @@ namespace glext {
 UTILS_PRIVATE PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR;
 UTILS_PRIVATE PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
 UTILS_PRIVATE PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR;
+UTILS_PRIVATE PFNEGLWAITSYNCKHRPROC eglWaitSyncKHR;
 UTILS_PRIVATE PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC eglGetNativeClientBufferANDROID;
 UTILS_PRIVATE PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
 UTILS_PRIVATE PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
@@ -143,6 +145,7 @@ Driver* PlatformEGL::createDriver(void* sharedContext) noexcept {
     eglCreateSyncKHR = (PFNEGLCREATESYNCKHRPROC) eglGetProcAddress("eglCreateSyncKHR");
     eglDestroySyncKHR = (PFNEGLDESTROYSYNCKHRPROC) eglGetProcAddress("eglDestroySyncKHR");
     eglClientWaitSyncKHR = (PFNEGLCLIENTWAITSYNCKHRPROC) eglGetProcAddress("eglClientWaitSyncKHR");
+    eglWaitSyncKHR = (PFNEGLWAITSYNCKHRPROC) eglGetProcAddress("eglWaitSyncKHR");
     eglCreateImageKHR = (PFNEGLCREATEIMAGEKHRPROC) eglGetProcAddress("eglCreateImageKHR");
     eglDestroyImageKHR = (PFNEGLDESTROYIMAGEKHRPROC) eglGetProcAddress("eglDestroyImageKHR");
     eglGetNativeClientBufferANDROID = (PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC) eglGetProcAddress("eglGetNativeClientBufferANDROID");
@@ -313,6 +316,23 @@ Platform::SwapChain* PlatformEGL::createSwapChain(
     return (SwapChain*)sur;
 }
 
+Platform::SwapChain* PlatformEGL::createSwapChainHeadless(
+        uint32_t width, uint32_t height, uint64_t& flags) noexcept {
+    EGLint attribs[] = {
+            EGL_WIDTH,  EGLint(width),
+            EGL_HEIGHT, EGLint(height),
+            EGL_NONE
+    };
+    EGLSurface sur = eglCreatePbufferSurface(mEGLDisplay,
+            (flags & driver::SWAP_CHAIN_CONFIG_TRANSPARENT) ? mEGLTransparentConfig : mEGLConfig,
+            attribs);
+    if (UTILS_UNLIKELY(sur == EGL_NO_SURFACE)) {
+        logEglError("eglCreatePbufferSurface");
+        return nullptr;
+    }
+    return (SwapChain*)sur;
+}
+
 void PlatformEGL::destroySwapChain(Platform::SwapChain* swapChain) noexcept {
     EGLSurface sur = (EGLSurface) swapChain;
     if (sur != EGL_NO_SURFACE) {
@@ -452,6 +472,51 @@ void PlatformEGL::destroyExternalTextureStorage(
     }
 }
 
+void* PlatformEGL::createExternalImage(void* clientBuffer) noexcept {
+    EGLClientBuffer buffer =
+            eglGetNativeClientBufferANDROID(static_cast<AHardwareBuffer*>(clientBuffer));
+    if (UTILS_UNLIKELY(!buffer)) {
+        logEglError("eglGetNativeClientBufferANDROID");
+        return nullptr;
+    }
+    const EGLint attr[] = { EGL_NONE };
+    EGLImageKHR image = eglCreateImageKHR(mEGLDisplay,
+            EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID, buffer, attr);
+    if (UTILS_UNLIKELY(image == EGL_NO_IMAGE_KHR)) {
+        logEglError("eglCreateImageKHR");
+        return nullptr;
+    }
+    return (void*)image;
+}
+
+void PlatformEGL::destroyExternalImage(void* image) noexcept {
+    eglDestroyImageKHR(mEGLDisplay, (EGLImageKHR)image);
+}
+
+void PlatformEGL::waitNativeFence(int fenceFd) noexcept {
+    if (fenceFd < 0) {
+        return;
+    }
+#ifdef EGL_ANDROID_native_fence_sync
+    const EGLint attr[] = { EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fenceFd, EGL_NONE };
+    EGLSyncKHR sync = eglCreateSyncKHR(mEGLDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, attr);
+    if (UTILS_LIKELY(sync != EGL_NO_SYNC_KHR)) {
+        // eglCreateSyncKHR() took ownership of the fd. Make the GPU wait for the
+        // producer instead of this thread, unlike eglClientWaitSyncKHR() would.
+        if (UTILS_LIKELY(eglWaitSyncKHR)) {
+            eglWaitSyncKHR(mEGLDisplay, sync, 0);
+        } else {
+            eglClientWaitSyncKHR(mEGLDisplay, sync,
+                    EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+        }
+        eglDestroySyncKHR(mEGLDisplay, sync);
+        return;
+    }
+    logEglError("eglCreateSyncKHR");
+#endif
+    close(fenceFd);
+}
+
 int PlatformEGL::getOSVersion() const noexcept {
     return mOSVersion;
 }
@@ -42,6 +42,8 @@ public:
     void terminate() noexcept override;
 
     SwapChain* createSwapChain(void* nativewindow, uint64_t& flags) noexcept final;
+    SwapChain* createSwapChainHeadless(uint32_t width, uint32_t height,
+            uint64_t& flags) noexcept final;
     void destroySwapChain(SwapChain* swapChain) noexcept final;
     void makeCurrent(SwapChain* drawSwapChain, SwapChain* readSwapChain) noexcept final;
     void commit(SwapChain* swapChain) noexcept final;
@@ -64,6 +66,10 @@ public:
             uint32_t w, uint32_t h, driver::TextureFormat format) noexcept final;
     void destroyExternalTextureStorage(ExternalTexture* ets) noexcept final;
 
+    void* createExternalImage(void* clientBuffer) noexcept final;
+    void destroyExternalImage(void* image) noexcept final;
+    void waitNativeFence(int fenceFd) noexcept final;
+
     int getOSVersion() const noexcept final;
 
 private:
@@ -33,6 +33,13 @@ PFNGLINSERTEVENTMARKEREXTPROC glInsertEventMarkerEXT;
 PFNGLPUSHGROUPMARKEREXTPROC glPushGroupMarkerEXT;
 PFNGLPOPGROUPMARKEREXTPROC glPopGroupMarkerEXT;
 #endif
+#ifdef GL_EXT_disjoint_timer_query
+PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
+#endif
+#ifdef GL_KHR_debug
+PFNGLDEBUGMESSAGECALLBACKKHRPROC glDebugMessageCallbackKHR;
+PFNGLDEBUGMESSAGECONTROLKHRPROC glDebugMessageControlKHR;
+#endif
 #if GL_EXT_multisampled_render_to_texture
 PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
 #endif
@@ -73,6 +80,20 @@ public:
                 (PFNGLPOPGROUPMARKEREXTPROC)eglGetProcAddress(
                         "glPopGroupMarkerEXT");
 #endif
+#ifdef GL_EXT_disjoint_timer_query
+        glGetQueryObjectui64vEXT =
+                (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress(
+                        "glGetQueryObjectui64vEXT");
+#endif
+#ifdef GL_KHR_debug
+        glDebugMessageCallbackKHR =
+                (PFNGLDEBUGMESSAGECALLBACKKHRPROC)eglGetProcAddress(
+                        "glDebugMessageCallbackKHR");
+
+        glDebugMessageControlKHR =
+                (PFNGLDEBUGMESSAGECONTROLKHRPROC)eglGetProcAddress(
+                        "glDebugMessageControlKHR");
+#endif
 #if GL_EXT_multisampled_render_to_texture
         glFramebufferTexture2DMultisampleEXT =
                 (PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC)eglGetProcAddress(
@@ -36,6 +36,13 @@
         extern PFNGLPUSHGROUPMARKEREXTPROC glPushGroupMarkerEXT;
         extern PFNGLPOPGROUPMARKEREXTPROC glPopGroupMarkerEXT;
 #endif
+#ifdef GL_EXT_disjoint_timer_query
+        extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
+#endif
+#ifdef GL_KHR_debug
+        extern PFNGLDEBUGMESSAGECALLBACKKHRPROC glDebugMessageCallbackKHR;
+        extern PFNGLDEBUGMESSAGECONTROLKHRPROC glDebugMessageControlKHR;
+#endif
 #if GL_EXT_multisampled_render_to_texture
         extern PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
 #endif
@@ -40,8 +40,22 @@ static constexpr VkAllocationCallbacks* VKALLOC = nullptr;
 // - Allow multiple descriptors to bind simultaneously; organize binding points into groups.
 static constexpr uint32_t MAX_NUM_DESCRIPTORS = 1000;
 
+// Initial bucket counts for the two caches. In traced scenes we see a few dozen pipelines and a
+// few hundred descriptor sets at steady state; pre-sizing the open-addressing tables keeps the
+// render loop from ever paying for a rehashing growth.
+static constexpr uint32_t INITIAL_PIPELINE_CAPACITY = 128;
+static constexpr uint32_t INITIAL_DESCRIPTOR_CAPACITY = 512;
+
 static VulkanBinder::RasterState createDefaultRasterState();
 
+// Hashes a single POD with the given seed. The seed is the binding slot (or field group) index,
+// so that identical contents bound at different slots still hash differently.
+template<typename T>
+static uint32_t hashStruct(const T& s, uint32_t seed) noexcept {
+    static_assert(0 == (sizeof(T) & 3), "Hashing requires a size that is a multiple of 4.");
+    return utils::hash::murmur3((const uint32_t*) &s, sizeof(T) / 4, seed);
+}
+
 VulkanBinder::VulkanBinder() : mDefaultRasterState(createDefaultRasterState()) {
     mColorBlendState = VkPipelineColorBlendStateCreateInfo{};
     mColorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -57,7 +71,74 @@ VulkanBinder::VulkanBinder() : mDefaultRasterState(createDefaultRasterState()) {
     mShaderStages[1].pName = "main";
     resetBindings();
 
+    mPipelineKey = {};
     mDescriptorKey = {};
+
+    // Seed the incrementally maintained hashes from the zeroed-out keys.
+    for (uint32_t group = 0; group < PIPELINE_HASH_GROUP_COUNT; group++) {
+        updatePipelineHash(PipelineHashGroup(group));
+    }
+    for (uint32_t binding = 0; binding < NUM_UBUFFER_BINDINGS; binding++) {
+        updateUniformBufferHash(binding);
+    }
+    for (uint32_t binding = 0; binding < NUM_SAMPLER_BINDINGS; binding++) {
+        updateSamplerHash(binding);
+    }
+
+    mPipelines.reserve(INITIAL_PIPELINE_CAPACITY);
+    mDescriptorSets.reserve(INITIAL_DESCRIPTOR_CAPACITY);
+}
+
+void VulkanBinder::updatePipelineHash(PipelineHashGroup group) noexcept {
+    PipelineKey& key = mPipelineKey;
+    uint32_t hash = 0;
+    switch (group) {
+        case PIPELINE_HASH_SHADERS:
+            hash = hashStruct(key.shaders, group);
+            break;
+        case PIPELINE_HASH_RASTER_STATE:
+            hash = hashStruct(key.rasterState, group);
+            break;
+        case PIPELINE_HASH_RENDER_PASS:
+            hash = hashStruct(key.renderPass, group);
+            break;
+        case PIPELINE_HASH_TOPOLOGY:
+            hash = hashStruct(key.topology, group);
+            break;
+        case PIPELINE_HASH_VERTEX_ARRAY:
+            // vertexAttributes and vertexBuffers are adjacent (no implicit padding), hash both.
+            hash = utils::hash::murmur3((const uint32_t*) key.vertexAttributes,
+                    (sizeof(key.vertexAttributes) + sizeof(key.vertexBuffers)) / 4, group);
+            break;
+        case PIPELINE_HASH_GROUP_COUNT:
+            break;
+    }
+    key.cachedHash ^= mPipelineGroupHashes[group] ^ hash;
+    mPipelineGroupHashes[group] = hash;
+}
+
+void VulkanBinder::updateUniformBufferHash(uint32_t bindingIndex) noexcept {
+    DescriptorKey& key = mDescriptorKey;
+    const struct alignas(8) {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    } slot = {
+        key.uniformBuffers[bindingIndex],
+        key.uniformBufferOffsets[bindingIndex],
+        key.uniformBufferSizes[bindingIndex],
+    };
+    const uint32_t hash = hashStruct(slot, bindingIndex);
+    key.cachedHash ^= mUniformBufferHashes[bindingIndex] ^ hash;
+    mUniformBufferHashes[bindingIndex] = hash;
+}
+
+void VulkanBinder::updateSamplerHash(uint32_t bindingIndex) noexcept {
+    DescriptorKey& key = mDescriptorKey;
+    const uint32_t hash = hashStruct(key.samplers[bindingIndex],
+            NUM_UBUFFER_BINDINGS + bindingIndex);
+    key.cachedHash ^= mSamplerHashes[bindingIndex] ^ hash;
+    mSamplerHashes[bindingIndex] = hash;
 }
 
 VulkanBinder::~VulkanBinder() {
@@ -270,7 +351,7 @@ bool VulkanBinder::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
             << mShaderStages[0].module << ", " << mShaderStages[1].module << ")" << utils::io::endl;
     #endif
 
-    VkResult err = vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo,
+    VkResult err = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineCreateInfo,
             VKALLOC, pipeline);
     if (err) {
         utils::slog.e << "vkCreateGraphicsPipelines error " << err << utils::io::endl;
@@ -288,12 +369,17 @@ bool VulkanBinder::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
 
 void VulkanBinder::bindProgramBundle(const ProgramBundle& bundle) noexcept {
     const VkShaderModule shaders[2] = { bundle.vertex, bundle.fragment };
+    bool changed = false;
     for (uint32_t ssi = 0; ssi < NUM_SHADER_MODULES; ssi++) {
         if (mPipelineKey.shaders[ssi] != shaders[ssi]) {
             mDirtyPipeline = true;
             mPipelineKey.shaders[ssi] = shaders[ssi];
+            changed = true;
         }
     }
+    if (changed) {
+        updatePipelineHash(PIPELINE_HASH_SHADERS);
+    }
 }
 
 void VulkanBinder::bindRasterState(const RasterState& rasterState) noexcept {
@@ -320,6 +406,7 @@ void VulkanBinder::bindRasterState(const RasterState& rasterState) noexcept {
     ) {
         mDirtyPipeline = true;
         mPipelineKey.rasterState = rasterState;
+        updatePipelineHash(PIPELINE_HASH_RASTER_STATE);
     }
 }
 
@@ -327,6 +414,7 @@ void VulkanBinder::bindRenderPass(VkRenderPass renderPass) noexcept {
     if (mPipelineKey.renderPass != renderPass) {
         mDirtyPipeline = true;
         mPipelineKey.renderPass = renderPass;
+        updatePipelineHash(PIPELINE_HASH_RENDER_PASS);
     }
 }
 
@@ -334,10 +422,12 @@ void VulkanBinder::bindPrimitiveTopology(VkPrimitiveTopology topology) noexcept
     if (mPipelineKey.topology != topology) {
         mDirtyPipeline = true;
         mPipelineKey.topology = topology;
+        updatePipelineHash(PIPELINE_HASH_TOPOLOGY);
     }
 }
 
 void VulkanBinder::bindVertexArray(const VertexArray& varray) noexcept {
+    bool changed = false;
     for (size_t i = 0; i < MAX_VERTEX_ATTRIBUTES; i++) {
         VkVertexInputAttributeDescription& attrib0 = mPipelineKey.vertexAttributes[i];
         const VkVertexInputAttributeDescription& attrib1 = varray.attributes[i];
@@ -348,6 +438,7 @@ void VulkanBinder::bindVertexArray(const VertexArray& varray) noexcept {
             attrib0.location = attrib1.location;
             attrib0.offset = attrib1.offset;
             mDirtyPipeline = true;
+            changed = true;
         }
         VkVertexInputBindingDescription& buffer0 = mPipelineKey.vertexBuffers[i];
         const VkVertexInputBindingDescription& buffer1 = varray.buffers[i];
@@ -356,8 +447,12 @@ void VulkanBinder::bindVertexArray(const VertexArray& varray) noexcept {
             buffer0.binding = buffer1.binding;
             buffer0.stride = buffer1.stride;
             mDirtyPipeline = true;
+            changed = true;
         }
     }
+    if (changed) {
+        updatePipelineHash(PIPELINE_HASH_VERTEX_ARRAY);
+    }
 }
 
 void VulkanBinder::unbindUniformBuffer(VkBuffer uniformBuffer) noexcept {
@@ -367,6 +462,7 @@ void VulkanBinder::unbindUniformBuffer(VkBuffer uniformBuffer) noexcept {
             key.uniformBuffers[bindingIndex] = {};
             key.uniformBufferSizes[bindingIndex] = {};
             key.uniformBufferOffsets[bindingIndex] = {};
+            updateUniformBufferHash(bindingIndex);
             mDirtyDescriptor = true;
         }
     }
@@ -388,6 +484,7 @@ void VulkanBinder::unbindImageView(VkImageView imageView) noexcept {
             mDescriptorKey.samplers[bindingIndex] = {
                 .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
             };
+            updateSamplerHash(bindingIndex);
             mDirtyDescriptor = true;
         }
     }
@@ -428,6 +525,7 @@ void VulkanBinder::bindUniformBuffer(uint32_t bindingIndex, VkBuffer uniformBuff
         key.uniformBuffers[bindingIndex] = uniformBuffer;
         key.uniformBufferOffsets[bindingIndex] = offset;
         key.uniformBufferSizes[bindingIndex] = size;
+        updateUniformBufferHash(bindingIndex);
         mDirtyDescriptor = true;
     }
 }
@@ -440,6 +538,7 @@ void VulkanBinder::bindSampler(uint32_t bindingIndex, VkDescriptorImageInfo samp
     if (imageInfo.sampler != samplerInfo.sampler || imageInfo.imageView != samplerInfo.imageView ||
         imageInfo.imageLayout != samplerInfo.imageLayout) {
         imageInfo = samplerInfo;
+        updateSamplerHash(bindingIndex - offset);
         mDirtyDescriptor = true;
     }
 }
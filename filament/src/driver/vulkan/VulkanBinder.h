@@ -114,6 +114,10 @@ public:
     ~VulkanBinder();
     void setDevice(VkDevice device) { mDevice = device; }
 
+    // Optional pipeline cache used by vkCreateGraphicsPipelines. The cache is owned by the
+    // client (it outlives all pipelines and is typically persisted to disk across runs).
+    void setPipelineCache(VkPipelineCache cache) { mPipelineCache = cache; }
+
     // Clients should initialize their copy of the raster state using this method. They can then
     // mutate their copy and pass it back through bindRasterState().
     const RasterState& getDefaultRasterState() const { return mDefaultRasterState; }
@@ -162,8 +166,9 @@ public:
 
 private:
     // The pipeline key is a POD that represents all currently bound states that form the immutable
-    // VkPipeline object. We apply a hash function to its contents only if has been mutated since
-    // the previous call to getOrCreatePipeline.
+    // VkPipeline object. Its hash is maintained incrementally: each bindFoo method rehashes only
+    // the group of fields it mutated and folds the result into "cachedHash" (see
+    // updatePipelineHash), so the full ~400 byte key is never rehashed per draw.
     struct alignas(8) PipelineKey {
         VkShaderModule shaders[NUM_SHADER_MODULES]; // 8*2 bytes
         RasterState rasterState; // 248 bytes
@@ -171,6 +176,8 @@ private:
         VkPrimitiveTopology topology; // 4 bytes
         VkVertexInputAttributeDescription vertexAttributes[MAX_VERTEX_ATTRIBUTES]; // 16*5 bytes
         VkVertexInputBindingDescription vertexBuffers[MAX_VERTEX_ATTRIBUTES]; // 12*5 bytes
+        uint32_t cachedHash; // 4 bytes, pure function of the fields above
+        uint32_t padding; // 4 bytes
     };
 
     static_assert(sizeof(PipelineKey) ==
@@ -179,12 +186,17 @@ private:
         sizeof(PipelineKey::renderPass) +
         sizeof(PipelineKey::topology) +
         sizeof(PipelineKey::vertexAttributes) +
-        sizeof(PipelineKey::vertexBuffers),
+        sizeof(PipelineKey::vertexBuffers) +
+        sizeof(PipelineKey::cachedHash) +
+        sizeof(PipelineKey::padding),
         "Implicit padding is not allowed for fast hashing");
 
     static_assert(std::is_pod<PipelineKey>::value, "PipelineKey must be a POD for fast hashing.");
 
-    using PipelineHashFn = utils::hash::MurmurHashFn<PipelineKey>;
+    // The hash is precomputed, so stored keys are never rehashed when the table grows.
+    struct PipelineHashFn {
+        uint32_t operator()(const PipelineKey& key) const { return key.cachedHash; }
+    };
 
     struct PipelineEqual {
         bool operator()(const PipelineKey& k1, const PipelineKey& k2) const;
@@ -202,25 +214,32 @@ private:
     };
 
     // The descriptor key is a POD that represents all currently bound states that go into the
-    // descriptor set. We apply a hash function to its contents only if has been mutated since
-    // the previous call to getOrCreateDescriptor.
+    // descriptor set. As with PipelineKey, its hash is maintained incrementally: each bind method
+    // rehashes only the binding slot it mutated (see updateUniformBufferHash / updateSamplerHash).
     struct alignas(8) DescriptorKey {
         VkBuffer uniformBuffers[NUM_UBUFFER_BINDINGS];
         VkDescriptorImageInfo samplers[NUM_SAMPLER_BINDINGS];
         VkDeviceSize uniformBufferOffsets[NUM_UBUFFER_BINDINGS];
         VkDeviceSize uniformBufferSizes[NUM_UBUFFER_BINDINGS];
+        uint32_t cachedHash; // pure function of the fields above
+        uint32_t padding;
     };
 
     static_assert(sizeof(DescriptorKey) ==
         sizeof(DescriptorKey::uniformBuffers) +
         sizeof(DescriptorKey::samplers) +
         sizeof(DescriptorKey::uniformBufferOffsets) +
-        sizeof(DescriptorKey::uniformBufferSizes),
+        sizeof(DescriptorKey::uniformBufferSizes) +
+        sizeof(DescriptorKey::cachedHash) +
+        sizeof(DescriptorKey::padding),
         "Implicit padding is not allowed for fast hashing");
 
     static_assert(std::is_pod<DescriptorKey>::value, "DescriptorKey must be a POD.");
 
-    using DescHashFn = utils::hash::MurmurHashFn<DescriptorKey>;
+    // The hash is precomputed, so stored keys are never rehashed when the table grows.
+    struct DescHashFn {
+        uint32_t operator()(const DescriptorKey& key) const { return key.cachedHash; }
+    };
 
     struct DescEqual {
         bool operator()(const DescriptorKey& k1, const DescriptorKey& k2) const;
@@ -241,7 +260,22 @@ private:
     void destroyLayoutsAndDescriptors() noexcept;
     void evictDescriptors(std::function<bool(const DescriptorKey&)> filter) noexcept;
 
+    // The pipeline key's hash is the XOR of independently seeded hashes of these field groups;
+    // the bind methods rehash only the group they mutated.
+    enum PipelineHashGroup {
+        PIPELINE_HASH_SHADERS = 0,
+        PIPELINE_HASH_RASTER_STATE,
+        PIPELINE_HASH_RENDER_PASS,
+        PIPELINE_HASH_TOPOLOGY,
+        PIPELINE_HASH_VERTEX_ARRAY,
+        PIPELINE_HASH_GROUP_COUNT
+    };
+    void updatePipelineHash(PipelineHashGroup group) noexcept;
+    void updateUniformBufferHash(uint32_t bindingIndex) noexcept;
+    void updateSamplerHash(uint32_t bindingIndex) noexcept;
+
     VkDevice mDevice = nullptr;
+    VkPipelineCache mPipelineCache = VK_NULL_HANDLE; // owned by the client, see setPipelineCache
     const RasterState mDefaultRasterState;
 
     // Info structs used only in a transient way but they are stored for convenience.
@@ -266,6 +300,11 @@ private:
     bool mDirtyPipeline = true;
     bool mDirtyDescriptor = true;
 
+    // Per-group and per-slot hashes backing the keys' incrementally maintained "cachedHash".
+    uint32_t mPipelineGroupHashes[PIPELINE_HASH_GROUP_COUNT] = {};
+    uint32_t mUniformBufferHashes[NUM_UBUFFER_BINDINGS] = {};
+    uint32_t mSamplerHashes[NUM_SAMPLER_BINDINGS] = {};
+
     // Cached Vulkan objects. These objects are owned by the Binder.
     VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
     VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
@@ -50,6 +50,37 @@ void VulkanBuffer::loadFromCpu(const void* cpuData, uint32_t byteOffset, uint32_
     vmaUnmapMemory(mContext.allocator, stage->memory);
     vmaFlushAllocation(mContext.allocator, stage->memory, byteOffset, numBytes);
 
+    // Within a frame, batch the copy onto the dedicated transfer queue when the device has one.
+    // The whole buffer is overwritten, so ownership can be acquired without a prior release
+    // (the old contents become undefined, which is fine here). The frame's graphics submission
+    // waits on the batched transfer work before executing the acquire barrier below.
+    if (hasDedicatedTransferQueue(mContext) && mContext.cmdbuffer) {
+        VkCommandBuffer transferCmd = acquireTransferBuffer(mContext);
+        VkBufferCopy region { .size = numBytes };
+        vkCmdCopyBuffer(transferCmd, stage->buffer, mGpuBuffer, 1, &region);
+        VkBufferMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcQueueFamilyIndex = mContext.transferQueueFamilyIndex,
+            .dstQueueFamilyIndex = mContext.graphicsQueueFamilyIndex,
+            .buffer = mGpuBuffer,
+            .size = VK_WHOLE_SIZE
+        };
+        // Release on the transfer queue; the destination access mask is ignored on this side.
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        // Acquire on the graphics queue; the source access mask is ignored on this side.
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(mContext.cmdbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        getSwapContext(mContext).pendingWork.emplace_back([this, stage] (VkCommandBuffer) {
+            mStagePool.releaseStage(stage);
+        });
+        return;
+    }
+
     // Create and submit a one-off command buffer to allow uploading outside a frame.
     VkCommandBuffer cmdbuffer;
     VkFence fence;
@@ -21,6 +21,8 @@
 #include "VulkanBuffer.h"
 #include "VulkanHandles.h"
 
+#include "driver/ProgramBinaryCache.h"
+
 #include <utils/Panic.h>
 #include <utils/CString.h>
 #include <utils/trap.h>
@@ -149,6 +151,33 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
     createVirtualDevice(mContext);
     mBinder.setDevice(mContext.device);
 
+    // Create the pipeline cache, seeded from disk when the application configured a cache
+    // directory. The serialized VkPipelineCache embeds the vendor/device identity, so the
+    // driver itself rejects data written by a different GPU or driver revision.
+    if (char const* const cacheDirectory = ProgramBinaryCache::getCacheDirectory()) {
+        mPipelineCachePath = std::string(cacheDirectory) + "/filament_vk_pipelines.bin";
+        const std::vector<uint8_t> initialData =
+                ProgramBinaryCache::readBlobFile(mPipelineCachePath);
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.data();
+        VkResult error = vkCreatePipelineCache(mContext.device, &cacheInfo, VKALLOC,
+                &mPipelineCache);
+        if (error != VK_SUCCESS && !initialData.empty()) {
+            // e.g. corrupt file content; retry with an empty cache
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            error = vkCreatePipelineCache(mContext.device, &cacheInfo, VKALLOC,
+                    &mPipelineCache);
+        }
+        if (error == VK_SUCCESS) {
+            mBinder.setPipelineCache(mPipelineCache);
+        } else {
+            mPipelineCache = VK_NULL_HANDLE;
+        }
+    }
+
     // Choose a depth format that meets our requirements. Take care not to include stencil formats
     // just yet, since that would require a corollary change to the "aspect" flags for the VkImage.
     mContext.depthFormat = findSupportedFormat(mContext,
@@ -180,10 +209,27 @@ void VulkanDriver::terminate() {
     }
     waitForIdle(mContext);
     mBinder.destroyCache();
+    if (mPipelineCache != VK_NULL_HANDLE) {
+        // persist the accumulated pipeline binaries for the next start
+        size_t size = 0;
+        if (vkGetPipelineCacheData(mContext.device, mPipelineCache, &size, nullptr) ==
+                VK_SUCCESS && size > 0) {
+            std::vector<uint8_t> data(size);
+            if (vkGetPipelineCacheData(mContext.device, mPipelineCache, &size, data.data()) ==
+                    VK_SUCCESS) {
+                ProgramBinaryCache::writeBlobFile(mPipelineCachePath, data.data(), size);
+            }
+        }
+        vkDestroyPipelineCache(mContext.device, mPipelineCache, VKALLOC);
+        mPipelineCache = VK_NULL_HANDLE;
+    }
     mStagePool.reset();
     mFramebufferCache.reset();
     mSamplerCache.reset();
     vmaDestroyAllocator(mContext.allocator);
+    if (mContext.transferCommandPool != mContext.commandPool) {
+        vkDestroyCommandPool(mContext.device, mContext.transferCommandPool, VKALLOC);
+    }
     vkDestroyCommandPool(mContext.device, mContext.commandPool, VKALLOC);
     vkDestroyDevice(mContext.device, VKALLOC);
     if (mDebugCallback) {
@@ -216,6 +262,10 @@ void VulkanDriver::beginFrame(uint64_t monotonic_clock_ns, uint32_t frameId) {
     // interest of maintaining a small memory footprint.
     mBinder.resetBindings();
 
+    // Like the pipeline and descriptor bindings above, vertex and index buffer bindings are
+    // specific to a command buffer.
+    mCurrentRenderPrimitive = nullptr;
+
     // Now that a command buffer is ready, perform any pending work that has been scheduled by
     // VulkanDriver, such as reclaiming memory. There are two sets of work queues: one in the
     // global context, and one in the per-cmdbuffer contexts. Crucially, we have begun the frame
@@ -226,6 +276,15 @@ void VulkanDriver::beginFrame(uint64_t monotonic_clock_ns, uint32_t frameId) {
     mStagePool.gc();
     mFramebufferCache.gc();
     mBinder.gc();
+
+    // Refresh the sub-allocator occupancy stats exposed through DebugRegistry.
+    VmaStats vmaStats;
+    vmaCalculateStats(mContext.allocator, &vmaStats);
+    GpuAllocatorStats& stats = getGpuAllocatorStats();
+    stats.blockCount = (int) vmaStats.total.blockCount;
+    stats.allocationCount = (int) vmaStats.total.allocationCount;
+    stats.usedMegabytes = float(vmaStats.total.usedBytes / 1024) / 1024.0f;
+    stats.unusedMegabytes = float(vmaStats.total.unusedBytes / 1024) / 1024.0f;
 }
 
 void VulkanDriver::setPresentationTime(uint64_t monotonic_clock_ns) {
@@ -240,16 +299,19 @@ void VulkanDriver::flush(int) {
 }
 
 void VulkanDriver::createVertexBuffer(Driver::VertexBufferHandle vbh, uint8_t bufferCount,
-        uint8_t attributeCount, uint32_t elementCount, Driver::AttributeArray attributes) {
+        uint8_t attributeCount, uint32_t elementCount, Driver::AttributeArray attributes,
+        Driver::Usage usage) {
+    // the staging pool already recycles CPU-side buffers on a fence, so STREAM doesn't
+    // need a dedicated path here; the hint is just recorded
     construct_handle<VulkanVertexBuffer>(mHandleMap, vbh, mContext, mStagePool, bufferCount,
-            attributeCount, elementCount, attributes);
+            attributeCount, elementCount, attributes, usage);
 }
 
 void VulkanDriver::createIndexBuffer(Driver::IndexBufferHandle ibh, Driver::ElementType elementType,
-        uint32_t indexCount) {
+        uint32_t indexCount, Driver::Usage usage) {
     auto elementSize = (uint8_t) getElementTypeSize(elementType);
     construct_handle<VulkanIndexBuffer>(mHandleMap, ibh, mContext, mStagePool, elementSize,
-            indexCount);
+            indexCount, usage);
 }
 
 void VulkanDriver::createTexture(Driver::TextureHandle th, SamplerType target, uint8_t levels,
@@ -308,6 +370,14 @@ void VulkanDriver::createRenderTarget(Driver::RenderTargetHandle rth,
 void VulkanDriver::createFence(Driver::FenceHandle fh, int) {
 }
 
+void VulkanDriver::createTimerQuery(Driver::TimerQueryHandle tqh, int) {
+    construct_handle<VulkanTimerQuery>(mHandleMap, tqh, mContext);
+}
+
+void VulkanDriver::createOcclusionQuery(Driver::OcclusionQueryHandle oqh, int) {
+    // TODO: implement with a vkCmdBeginQuery occlusion pool, like VulkanTimerQuery
+}
+
 void VulkanDriver::createSwapChain(Driver::SwapChainHandle sch, void* nativeWindow,
         uint64_t flags) {
     auto* swapChain = construct_handle<VulkanSwapChain>(mHandleMap, sch);
@@ -327,6 +397,11 @@ void VulkanDriver::createSwapChain(Driver::SwapChainHandle sch, void* nativeWind
     }
 }
 
+void VulkanDriver::createSwapChainHeadless(Driver::SwapChainHandle sch, uint32_t width,
+        uint32_t height, uint64_t flags) {
+    // TODO: render into a plain VkImage (no VK_KHR_surface / VK_KHR_swapchain needed).
+}
+
 void VulkanDriver::createStreamFromTextureId(Driver::StreamHandle sh, intptr_t externalTextureId,
         uint32_t width, uint32_t height) {
 }
@@ -371,10 +446,22 @@ Handle<HwFence> VulkanDriver::createFenceSynchronous() noexcept {
     return {};
 }
 
+Handle<HwTimerQuery> VulkanDriver::createTimerQuerySynchronous() noexcept {
+    return alloc_handle<VulkanTimerQuery, HwTimerQuery>();
+}
+
+Handle<HwOcclusionQuery> VulkanDriver::createOcclusionQuerySynchronous() noexcept {
+    return {};
+}
+
 Handle<HwSwapChain> VulkanDriver::createSwapChainSynchronous() noexcept {
     return alloc_handle<VulkanSwapChain, HwSwapChain>();
 }
 
+Handle<HwSwapChain> VulkanDriver::createSwapChainHeadlessSynchronous() noexcept {
+    return {};
+}
+
 Handle<HwStream> VulkanDriver::createStreamFromTextureIdSynchronous() noexcept {
     return {};
 }
@@ -396,6 +483,10 @@ void VulkanDriver::destroyIndexBuffer(Driver::IndexBufferHandle ibh) {
 void VulkanDriver::destroyRenderPrimitive(Driver::RenderPrimitiveHandle rph) {
     if (rph) {
         waitForIdle(mContext);
+        // a subsequently created primitive could be allocated at the same address
+        if (mCurrentRenderPrimitive == handle_cast<VulkanRenderPrimitive>(mHandleMap, rph)) {
+            mCurrentRenderPrimitive = nullptr;
+        }
         destruct_handle<VulkanRenderPrimitive>(mHandleMap, rph);
     }
 }
@@ -460,6 +551,16 @@ void VulkanDriver::destroySwapChain(Driver::SwapChainHandle sch) {
 void VulkanDriver::destroyStream(Driver::StreamHandle sh) {
 }
 
+void VulkanDriver::destroyTimerQuery(Driver::TimerQueryHandle tqh) {
+    if (tqh) {
+        waitForIdle(mContext);
+        destruct_handle<VulkanTimerQuery>(mHandleMap, tqh);
+    }
+}
+
+void VulkanDriver::destroyOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+}
+
 Handle<HwStream> VulkanDriver::createStream(void* nativeStream) {
     return {};
 }
@@ -470,6 +571,12 @@ void VulkanDriver::setStreamDimensions(Driver::StreamHandle sh, uint32_t width,
 void VulkanDriver::updateStreams(CommandStream* driver) {
 }
 
+void VulkanDriver::queueStreamFrame(Driver::StreamHandle sh, int64_t timestampNs) {
+}
+
+void VulkanDriver::setStreamTargetLatency(Driver::StreamHandle sh, int64_t latencyNs) {
+}
+
 void VulkanDriver::destroyFence(Driver::FenceHandle fh) {
 }
 
@@ -479,7 +586,7 @@ Driver::FenceStatus VulkanDriver::wait(Driver::FenceHandle fh, uint64_t timeout)
 
 // We create all textures using VK_IMAGE_TILING_OPTIMAL, so our definition of "supported" is that
 // the GPU supports the given texture format with non-zero optimal tiling features.
-bool VulkanDriver::isTextureFormatSupported(Driver::TextureFormat format) {
+bool VulkanDriver::isTextureFormatSupported(Driver::TextureFormat format) const {
     assert(mContext.physicalDevice);
     VkFormat vkformat = getVkFormat(format);
     if (vkformat == VK_FORMAT_UNDEFINED) {
@@ -490,7 +597,7 @@ bool VulkanDriver::isTextureFormatSupported(Driver::TextureFormat format) {
     return info.optimalTilingFeatures != 0;
 }
 
-bool VulkanDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) {
+bool VulkanDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) const {
     assert(mContext.physicalDevice);
     VkFormat vkformat = getVkFormat(format);
     if (vkformat == VK_FORMAT_UNDEFINED) {
@@ -501,7 +608,30 @@ bool VulkanDriver::isRenderTargetFormatSupported(Driver::TextureFormat format) {
     return (info.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) != 0;
 }
 
-bool VulkanDriver::isFrameTimeSupported() {
+bool VulkanDriver::isFrameTimeSupported() const {
+    return false;
+}
+
+bool VulkanDriver::isInTileResolveSupported() const {
+    // TODO: implement with pResolveAttachments in the render pass
+    return false;
+}
+
+bool VulkanDriver::getTimerQueryValue(Driver::TimerQueryHandle tqh, uint64_t* elapsedTime) {
+    // this is a synchronous call, it runs on the application's thread; the result is
+    // published by the backend thread when it becomes available (see beginTimerQuery()).
+    if (tqh) {
+        auto* tq = handle_cast<VulkanTimerQuery>(mHandleMap, tqh);
+        uint64_t elapsed = tq->elapsed.load(std::memory_order_relaxed);
+        if (elapsed) {
+            *elapsedTime = elapsed;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VulkanDriver::getOcclusionQueryResult(Driver::OcclusionQueryHandle oqh, bool* visible) {
     return false;
 }
 
@@ -528,6 +658,13 @@ void VulkanDriver::load2DImage(Driver::TextureHandle th,
     scheduleDestroy(std::move(data));
 }
 
+void VulkanDriver::loadArrayImage(Driver::TextureHandle th, uint32_t level, uint32_t layer,
+        uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
+        PixelBufferDescriptor&& data) {
+    assert(false && "Array textures are not yet supported by the Vulkan backend.");
+    scheduleDestroy(std::move(data));
+}
+
 void VulkanDriver::loadCubeImage(Driver::TextureHandle th, uint32_t level,
         PixelBufferDescriptor&& data, FaceOffsets faceOffsets) {
     assert(data.type != driver::PixelDataType::COMPRESSED && "Compression not yet supported.");
@@ -538,6 +675,11 @@ void VulkanDriver::loadCubeImage(Driver::TextureHandle th, uint32_t level,
 void VulkanDriver::setExternalImage(Driver::TextureHandle th, void* image) {
 }
 
+void VulkanDriver::setExternalHardwareBuffer(Driver::TextureHandle th, void* hardwareBuffer,
+        int fenceFd) {
+    // TODO: import with VK_ANDROID_external_memory_android_hardware_buffer
+}
+
 void VulkanDriver::setExternalStream(Driver::TextureHandle th, Driver::StreamHandle sh) {
 }
 
@@ -548,14 +690,31 @@ void VulkanDriver::updateUniformBuffer(Driver::UniformBufferHandle ubh,
         UniformBuffer&& uniformBuffer) {
     auto* buffer = handle_cast<VulkanUniformBuffer>(mHandleMap, ubh);
     if (uniformBuffer.isDirty()) {
-        buffer->loadFromCpu(uniformBuffer.getBuffer(), (uint32_t) uniformBuffer.getSize());
+        buffer->loadFromCpu(uniformBuffer.getBuffer(), 0, (uint32_t) uniformBuffer.getSize());
     }
     buffer->ub = std::move(uniformBuffer);
 }
 
+void VulkanDriver::updateUniformBuffers(uint32_t count, Driver::BufferDescriptor&& batch) {
+    auto const* const records =
+            static_cast<Driver::UniformBufferUpdateRecord const*>(batch.buffer);
+    char const* const base = static_cast<char const*>(batch.buffer);
+    for (uint32_t i = 0; i < count; i++) {
+        Handle<HwUniformBuffer> ubh = records[i].ubh;
+        auto* buffer = handle_cast<VulkanUniformBuffer>(mHandleMap, ubh);
+        buffer->loadFromCpu(base + records[i].offset, records[i].bufferOffset,
+                records[i].size);
+    }
+    scheduleDestroy(std::move(batch));
+}
+
 void VulkanDriver::updateSamplerBuffer(Driver::SamplerBufferHandle sbh,
         SamplerBuffer&& samplerBuffer) {
     auto* sb = handle_cast<VulkanSamplerBuffer>(mHandleMap, sbh);
+    if (sb->sb->getVersion() == samplerBuffer.getVersion()) {
+        // same content generation as what we already hold
+        return;
+    }
     *sb->sb = samplerBuffer;
 }
 
@@ -661,6 +820,10 @@ void VulkanDriver::setRenderPrimitiveBuffer(Driver::RenderPrimitiveHandle rph,
     auto primitive = handle_cast<VulkanRenderPrimitive>(mHandleMap, rph);
     primitive->setBuffers(handle_cast<VulkanVertexBuffer>(mHandleMap, vbh),
             handle_cast<VulkanIndexBuffer>(mHandleMap, ibh), enabledAttributes);
+    // the buffer bindings cached by draw() are now stale
+    if (mCurrentRenderPrimitive == primitive) {
+        mCurrentRenderPrimitive = nullptr;
+    }
 }
 
 void VulkanDriver::setRenderPrimitiveRange(Driver::RenderPrimitiveHandle rph,
@@ -746,10 +909,14 @@ void VulkanDriver::viewport(ssize_t left, ssize_t bottom, size_t width, size_t h
 
 void VulkanDriver::bindUniforms(size_t index, Driver::UniformBufferHandle ubh) {
     auto* buffer = handle_cast<VulkanUniformBuffer>(mHandleMap, ubh);
-    // The driver API does not currently expose offset / range, but it will do so in the future.
-    const VkDeviceSize offset = 0;
-    const VkDeviceSize size = VK_WHOLE_SIZE;
-    mBinder.bindUniformBuffer((uint32_t) index, buffer->getGpuBuffer(), offset, size);
+    mBinder.bindUniformBuffer((uint32_t) index, buffer->getGpuBuffer(), 0, VK_WHOLE_SIZE);
+}
+
+void VulkanDriver::bindUniformsRange(size_t index, Driver::UniformBufferHandle ubh,
+        size_t offset, size_t size) {
+    auto* buffer = handle_cast<VulkanUniformBuffer>(mHandleMap, ubh);
+    mBinder.bindUniformBuffer((uint32_t) index, buffer->getGpuBuffer(),
+            (VkDeviceSize) offset, (VkDeviceSize) size);
 }
 
 void VulkanDriver::bindSamplers(size_t index, Driver::SamplerBufferHandle sbh) {
@@ -782,6 +949,48 @@ void VulkanDriver::popGroupMarker(int) {
     }
 }
 
+void VulkanDriver::beginTimerQuery(Driver::TimerQueryHandle tqh) {
+    ASSERT_POSTCONDITION(mContext.cmdbuffer,
+            "Timer queries can only be used within a beginFrame / endFrame.");
+    auto* tq = handle_cast<VulkanTimerQuery>(mHandleMap, tqh);
+    if (!tq->timerPool) {
+        return;
+    }
+    // before reusing the query pool, collect the result of its previous use if it's ready --
+    // if it isn't (i.e. the GPU is more than a frame behind), that sample is simply dropped.
+    if (tq->begun) {
+        uint64_t timestamps[2];
+        VkResult result = vkGetQueryPoolResults(mContext.device, tq->timerPool, 0, 2,
+                sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS && timestamps[1] > timestamps[0]) {
+            double period = mContext.physicalDeviceProperties.limits.timestampPeriod;
+            tq->elapsed.store(uint64_t(double(timestamps[1] - timestamps[0]) * period),
+                    std::memory_order_relaxed);
+        }
+    }
+    // note: this must be called outside of a render pass
+    vkCmdResetQueryPool(mContext.cmdbuffer, tq->timerPool, 0, 2);
+    vkCmdWriteTimestamp(mContext.cmdbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, tq->timerPool, 0);
+    tq->begun = true;
+}
+
+void VulkanDriver::endTimerQuery(Driver::TimerQueryHandle tqh) {
+    ASSERT_POSTCONDITION(mContext.cmdbuffer,
+            "Timer queries can only be used within a beginFrame / endFrame.");
+    auto* tq = handle_cast<VulkanTimerQuery>(mHandleMap, tqh);
+    if (!tq->timerPool) {
+        return;
+    }
+    vkCmdWriteTimestamp(mContext.cmdbuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            tq->timerPool, 1);
+}
+
+void VulkanDriver::beginOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+}
+
+void VulkanDriver::endOcclusionQuery(Driver::OcclusionQueryHandle oqh) {
+}
+
 void VulkanDriver::readPixels(Driver::RenderTargetHandle src,
         uint32_t x, uint32_t y, uint32_t width, uint32_t height,
         PixelBufferDescriptor&& p) {
@@ -801,7 +1010,7 @@ void VulkanDriver::blit(TargetBufferFlags buffers,
 }
 
 void VulkanDriver::draw(Driver::ProgramHandle ph, Driver::RasterState rasterState,
-        Driver::RenderPrimitiveHandle rph) {
+        Driver::RenderPrimitiveHandle rph, uint32_t instances) {
     VkCommandBuffer cmdbuffer = mContext.cmdbuffer;
     ASSERT_POSTCONDITION(cmdbuffer, "Draw calls can occur only within a beginFrame / endFrame.");
     const VulkanRenderPrimitive& prim = *handle_cast<VulkanRenderPrimitive>(mHandleMap, rph);
@@ -898,23 +1107,35 @@ void VulkanDriver::draw(Driver::ProgramHandle ph, Driver::RasterState rasterStat
         vkCmdBindPipeline(cmdbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     }
 
-    // Next bind the vertex buffers and index buffer. One potential performance improvement is to
-    // avoid rebinding these if they are already bound, but since we do not (yet) support subranges
-    // it would be rare for a client to make consecutive draw calls with the same render primitive.
-    vkCmdBindVertexBuffers(cmdbuffer, 0, (uint32_t) prim.buffers.size(),
-            prim.buffers.data(), prim.offsets.data());
-    vkCmdBindIndexBuffer(cmdbuffer, prim.indexBuffer->buffer->getGpuBuffer(), 0,
-            prim.indexBuffer->indexType);
+    // Next bind the vertex buffers and index buffer. Draw commands are sorted by the frontend, so
+    // consecutive draws with the same render primitive are common (e.g. instanced-like batches of
+    // the same mesh); skip the rebind in that case.
+    if (mCurrentRenderPrimitive != &prim) {
+        vkCmdBindVertexBuffers(cmdbuffer, 0, (uint32_t) prim.buffers.size(),
+                prim.buffers.data(), prim.offsets.data());
+        vkCmdBindIndexBuffer(cmdbuffer, prim.indexBuffer->buffer->getGpuBuffer(), 0,
+                prim.indexBuffer->indexType);
+        mCurrentRenderPrimitive = &prim;
+    }
 
     // Finally, make the actual draw call. TODO: support subranges
     const uint32_t indexCount = prim.count;
-    const uint32_t instanceCount = 1;
+    const uint32_t instanceCount = instances;
     const uint32_t firstIndex = prim.offset / prim.indexBuffer->elementSize;
     const int32_t vertexOffset = 0;
     const uint32_t firstInstId = 1;
     vkCmdDrawIndexed(cmdbuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstId);
 }
 
+void VulkanDriver::drawConditional(Driver::ProgramHandle ph, Driver::RasterState rasterState,
+        Driver::RenderPrimitiveHandle rph, uint32_t instances,
+        Driver::OcclusionQueryHandle oqh) {
+    // TODO: predicate with VK_EXT_conditional_rendering once occlusion queries are
+    // implemented for this backend; until then queries never produce a result, so
+    // conservatively always draw.
+    draw(ph, rasterState, rph, instances);
+}
+
 #ifndef NDEBUG
 void VulkanDriver::debugCommand(const char* methodName) {
     static const std::set<utils::StaticString> OUTSIDE_COMMANDS = {
@@ -29,6 +29,7 @@
 #include <utils/compiler.h>
 #include <utils/Allocator.h>
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -65,6 +66,9 @@ private:
 #define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params) \
     RetType methodName(paramsDecl) override;
 
+#define DECL_DRIVER_API_SYNCHRONOUS_CONST(RetType, methodName, paramsDecl, params) \
+    RetType methodName(paramsDecl) const override;
+
 #define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) \
     RetType methodName##Synchronous() noexcept override; \
     UTILS_ALWAYS_INLINE void methodName(RetType, paramsDecl);
@@ -134,8 +138,17 @@ private:
     VulkanFboCache mFramebufferCache;
     VulkanSamplerCache mSamplerCache;
     VulkanRenderTarget* mCurrentRenderTarget = nullptr;
+
+    // tracks the render primitive whose vertex and index buffers are bound to the current
+    // command buffer, allowing consecutive draws of the same primitive to skip the rebind
+    VulkanRenderPrimitive const* mCurrentRenderPrimitive = nullptr;
     VulkanSamplerBuffer* mSamplerBindings[VulkanBinder::NUM_SAMPLER_BINDINGS] = {};
     VkDebugReportCallbackEXT mDebugCallback = VK_NULL_HANDLE;
+
+    // pipeline cache persisted to disk across runs (VK_NULL_HANDLE when no cache directory
+    // has been configured, see ProgramBinaryCache::setCacheDirectory)
+    VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+    std::string mPipelineCachePath;
 };
 
 } // namespace driver
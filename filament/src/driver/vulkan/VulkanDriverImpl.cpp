@@ -67,6 +67,7 @@ void selectPhysicalDevice(VulkanContext& context) {
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamiliesCount,
                 queueFamiliesProperties.data());
         context.graphicsQueueFamilyIndex = 0xffff;
+        context.transferQueueFamilyIndex = 0xffff;
         for (uint32_t j = 0; j < queueFamiliesCount; ++j) {
             VkQueueFamilyProperties props = queueFamiliesProperties[j];
             if (props.queueCount == 0) {
@@ -74,9 +75,20 @@ void selectPhysicalDevice(VulkanContext& context) {
             }
             if (props.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
                 context.graphicsQueueFamilyIndex = j;
+            } else if (props.queueFlags & VK_QUEUE_TRANSFER_BIT) {
+                // Prefer a transfer-only family: those map to DMA engines, which can move data
+                // without competing with the 3D engine for execution resources.
+                if (context.transferQueueFamilyIndex == 0xffff ||
+                        !(props.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+                    context.transferQueueFamilyIndex = j;
+                }
             }
         }
         if (context.graphicsQueueFamilyIndex == 0xffff) continue;
+        if (context.transferQueueFamilyIndex == 0xffff) {
+            // No dedicated transfer family; uploads will share the graphics queue.
+            context.transferQueueFamilyIndex = context.graphicsQueueFamilyIndex;
+        }
 
         // Does the device support the VK_KHR_swapchain extension?
         uint32_t extensionCount;
@@ -138,7 +150,7 @@ void selectPhysicalDevice(VulkanContext& context) {
 }
 
 void createVirtualDevice(VulkanContext& context) {
-    VkDeviceQueueCreateInfo deviceQueueCreateInfo[1] = {};
+    VkDeviceQueueCreateInfo deviceQueueCreateInfo[2] = {};
     static const float queuePriority[] = {1.0f};
     VkDeviceCreateInfo deviceCreateInfo = {};
     std::vector<const char*> deviceExtensionNames = {
@@ -147,12 +159,20 @@ void createVirtualDevice(VulkanContext& context) {
     if (context.debugMarkersSupported) {
         deviceExtensionNames.push_back(VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
     }
-    deviceQueueCreateInfo->sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    deviceQueueCreateInfo->queueFamilyIndex = context.graphicsQueueFamilyIndex;
-    deviceQueueCreateInfo->queueCount = 1;
-    deviceQueueCreateInfo->pQueuePriorities = &queuePriority[0];
+    deviceQueueCreateInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    deviceQueueCreateInfo[0].queueFamilyIndex = context.graphicsQueueFamilyIndex;
+    deviceQueueCreateInfo[0].queueCount = 1;
+    deviceQueueCreateInfo[0].pQueuePriorities = &queuePriority[0];
+    uint32_t queueCreateInfoCount = 1;
+    if (hasDedicatedTransferQueue(context)) {
+        deviceQueueCreateInfo[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        deviceQueueCreateInfo[1].queueFamilyIndex = context.transferQueueFamilyIndex;
+        deviceQueueCreateInfo[1].queueCount = 1;
+        deviceQueueCreateInfo[1].pQueuePriorities = &queuePriority[0];
+        queueCreateInfoCount = 2;
+    }
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.queueCreateInfoCount = 1;
+    deviceCreateInfo.queueCreateInfoCount = queueCreateInfoCount;
     deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfo;
     deviceCreateInfo.pEnabledFeatures = nullptr;
     deviceCreateInfo.enabledExtensionCount = deviceExtensionNames.size();
@@ -169,6 +189,17 @@ void createVirtualDevice(VulkanContext& context) {
     createInfo.queueFamilyIndex = context.graphicsQueueFamilyIndex;
     result = vkCreateCommandPool(context.device, &createInfo, VKALLOC, &context.commandPool);
     ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkCreateCommandPool error.");
+    if (hasDedicatedTransferQueue(context)) {
+        vkGetDeviceQueue(context.device, context.transferQueueFamilyIndex, 0,
+                &context.transferQueue);
+        createInfo.queueFamilyIndex = context.transferQueueFamilyIndex;
+        result = vkCreateCommandPool(context.device, &createInfo, VKALLOC,
+                &context.transferCommandPool);
+        ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkCreateCommandPool error.");
+    } else {
+        context.transferQueue = context.graphicsQueue;
+        context.transferCommandPool = context.commandPool;
+    }
 
     const VmaVulkanFunctions funcs {
         .vkGetPhysicalDeviceProperties = vkGetPhysicalDeviceProperties,
@@ -349,23 +380,13 @@ void createDepthBuffer(VulkanContext& context, VulkanSurfaceContext& surfaceCont
         .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
         .samples = VK_SAMPLE_COUNT_1_BIT,
     };
-    VkResult error = vkCreateImage(context.device, &imageInfo, VKALLOC, &depthImage);
-    ASSERT_POSTCONDITION(!error, "Unable to create depth image.");
-
-    // Allocate memory for the VkImage and bind it.
-    VkMemoryRequirements memReqs;
-    vkGetImageMemoryRequirements(context.device, depthImage, &memReqs);
-    VkMemoryAllocateInfo allocInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memReqs.size,
-        .memoryTypeIndex = selectMemoryType(context, memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    // Create the VkImage and sub-allocate device memory for it from the shared allocator.
+    const VmaAllocationCreateInfo allocInfo {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
     };
-    error = vkAllocateMemory(context.device, &allocInfo, nullptr,
-            &surfaceContext.depth.memory);
-    ASSERT_POSTCONDITION(!error, "Unable to allocate depth memory.");
-    error = vkBindImageMemory(context.device, depthImage, surfaceContext.depth.memory, 0);
-    ASSERT_POSTCONDITION(!error, "Unable to bind depth memory.");
+    VkResult error = vmaCreateImage(context.allocator, &imageInfo, &allocInfo, &depthImage,
+            &surfaceContext.depth.memory, nullptr);
+    ASSERT_POSTCONDITION(!error, "Unable to create depth image.");
 
     // Create a VkImageView so that we can attach depth to the framebuffer.
     VkImageView depthView;
@@ -460,6 +481,7 @@ void createCommandBuffersAndFences(VulkanContext& context, VulkanSurfaceContext&
         result = vkCreateFence(context.device, &fenceCreateInfo, VKALLOC,
                 &surfaceContext.swapContexts[i].fence);
         ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkCreateFence error.");
+        createSemaphore(context.device, &surfaceContext.swapContexts[i].transferDone);
     }
 }
 
@@ -467,8 +489,10 @@ void destroySurfaceContext(VulkanContext& context, VulkanSurfaceContext& surface
     for (SwapContext& swapContext : surfaceContext.swapContexts) {
         vkFreeCommandBuffers(context.device, context.commandPool, 1, &swapContext.cmdbuffer);
         vkDestroyFence(context.device, swapContext.fence, VKALLOC);
+        vkDestroySemaphore(context.device, swapContext.transferDone, VKALLOC);
         vkDestroyImageView(context.device, swapContext.attachment.view, VKALLOC);
         swapContext.fence = VK_NULL_HANDLE;
+        swapContext.transferDone = VK_NULL_HANDLE;
         swapContext.attachment.view = VK_NULL_HANDLE;
     }
     vkDestroySwapchainKHR(context.device, surfaceContext.swapchain, VKALLOC);
@@ -476,26 +500,12 @@ void destroySurfaceContext(VulkanContext& context, VulkanSurfaceContext& surface
     vkDestroySemaphore(context.device, surfaceContext.renderingFinished, VKALLOC);
     vkDestroySurfaceKHR(context.instance, surfaceContext.surface, VKALLOC);
     vkDestroyImageView(context.device, surfaceContext.depth.view, VKALLOC);
-    vkDestroyImage(context.device, surfaceContext.depth.image, VKALLOC);
-    vkFreeMemory(context.device, surfaceContext.depth.memory, VKALLOC);
+    vmaDestroyImage(context.allocator, surfaceContext.depth.image, surfaceContext.depth.memory);
     if (context.currentSurface == &surfaceContext) {
         context.currentSurface = nullptr;
     }
 }
 
-uint32_t selectMemoryType(VulkanContext& context, uint32_t flags, VkFlags reqs) {
-    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
-        if (flags & 1) {
-            if ((context.memoryProperties.memoryTypes[i].propertyFlags & reqs) == reqs) {
-                return i;
-            }
-        }
-        flags >>= 1;
-    }
-    ASSERT_POSTCONDITION(false, "Unable to find a memory type that meets requirements.");
-    return (uint32_t) ~0ul;
-}
-
 VkFormat getVkFormat(ElementType type, bool normalized) {
     using ElementType = ElementType;
     if (normalized) {
@@ -814,20 +824,36 @@ void acquireCommandBuffer(VulkanContext& context) {
 }
 
 void releaseCommandBuffer(VulkanContext& context) {
+    // Submit this frame's batched uploads first; the graphics submission below waits until the
+    // transfer queue has finished and the acquire barriers recorded into the frame's command
+    // buffer take ownership of the uploaded resources.
+    flushTransferBatch(context);
+
     // Finalize the command buffer and set the cmdbuffer pointer to null.
     VkResult result = vkEndCommandBuffer(context.cmdbuffer);
     ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkEndCommandBuffer error.");
     context.cmdbuffer = nullptr;
 
     // Submit the command buffer.
-    VkPipelineStageFlags waitDestStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
     VulkanSurfaceContext& surfaceContext = *context.currentSurface;
     SwapContext& swapContext = getSwapContext(context);
+    VkSemaphore waitSemaphores[2] = { surfaceContext.imageAvailable, VK_NULL_HANDLE };
+    VkPipelineStageFlags waitDestStageMasks[2] = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        // the acquire barriers are recorded with a TOP_OF_PIPE source stage, so the transfer
+        // semaphore must gate the whole submission
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+    };
+    uint32_t waitSemaphoreCount = 1;
+    if (context.transfer.submitted) {
+        waitSemaphores[waitSemaphoreCount++] = swapContext.transferDone;
+        context.transfer.submitted = false;
+    }
     VkSubmitInfo submitInfo {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = 1u,
-        .pWaitSemaphores = &surfaceContext.imageAvailable,
-        .pWaitDstStageMask = &waitDestStageMask,
+        .waitSemaphoreCount = waitSemaphoreCount,
+        .pWaitSemaphores = waitSemaphores,
+        .pWaitDstStageMask = waitDestStageMasks,
         .commandBufferCount = 1,
         .pCommandBuffers = &swapContext.cmdbuffer,
         .signalSemaphoreCount = 1u,
@@ -838,6 +864,63 @@ void releaseCommandBuffer(VulkanContext& context) {
     swapContext.submitted = true;
 }
 
+bool hasDedicatedTransferQueue(const VulkanContext& context) {
+    return context.transferQueueFamilyIndex != context.graphicsQueueFamilyIndex;
+}
+
+VkCommandBuffer acquireTransferBuffer(VulkanContext& context) {
+    VulkanTransferBatch& batch = context.transfer;
+    if (batch.cmdbuffer == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = context.transferCommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        VkResult result = vkAllocateCommandBuffers(context.device, &allocateInfo,
+                &batch.cmdbuffer);
+        ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkAllocateCommandBuffers error.");
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        result = vkBeginCommandBuffer(batch.cmdbuffer, &beginInfo);
+        ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkBeginCommandBuffer error.");
+    }
+    return batch.cmdbuffer;
+}
+
+void flushTransferBatch(VulkanContext& context) {
+    VulkanTransferBatch& batch = context.transfer;
+    if (batch.cmdbuffer == VK_NULL_HANDLE) {
+        return;
+    }
+    VkResult result = vkEndCommandBuffer(batch.cmdbuffer);
+    ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkEndCommandBuffer error.");
+    SwapContext& swapContext = getSwapContext(context);
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &batch.cmdbuffer,
+        .signalSemaphoreCount = 1u,
+        .pSignalSemaphores = &swapContext.transferDone,
+    };
+    result = vkQueueSubmit(context.transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    ASSERT_POSTCONDITION(result == VK_SUCCESS, "vkQueueSubmit error.");
+
+    // The graphics submission for this frame waits on transferDone, so by the time the swap
+    // context's fence has been waited on, the transfer work has necessarily retired too and the
+    // command buffer can be reclaimed through the usual pendingWork mechanism.
+    VkCommandBuffer cmdbuffer = batch.cmdbuffer;
+    VkDevice device = context.device;
+    VkCommandPool pool = context.transferCommandPool;
+    swapContext.pendingWork.emplace_back([device, pool, cmdbuffer] (VkCommandBuffer) {
+        vkFreeCommandBuffers(device, pool, 1, &cmdbuffer);
+    });
+    batch.cmdbuffer = VK_NULL_HANDLE;
+    batch.submitted = true;
+}
+
 void performPendingWork(VulkanContext& context, SwapContext& swapContext, VkCommandBuffer cmdbuf) {
     // First, execute pending tasks that are specific to this swap context. Copy the tasks into a
     // local queue first, which allows newly added tasks to be deferred until the next frame.
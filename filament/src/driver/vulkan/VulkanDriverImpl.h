@@ -42,6 +42,14 @@ using VulkanTaskQueue = std::vector<VulkanTask>;
 
 struct VulkanSurfaceContext;
 
+// Batches all uploads recorded during a frame into a single submission on the dedicated transfer
+// queue. Ownership of the destination resources is released on the transfer queue and acquired on
+// the graphics queue, whose submission waits on the current SwapContext's transferDone semaphore.
+struct VulkanTransferBatch {
+    VkCommandBuffer cmdbuffer = VK_NULL_HANDLE; // open command buffer, lazily allocated
+    bool submitted = false;                     // whether the graphics submit must wait
+};
+
 // For now we only support a single-device, single-instance scenario. Our concept of "context" is a
 // bundle of state containing the Device, the Instance, and various globally-useful Vulkan objects.
 struct VulkanContext {
@@ -54,6 +62,12 @@ struct VulkanContext {
     VkCommandPool commandPool;
     uint32_t graphicsQueueFamilyIndex;
     VkQueue graphicsQueue;
+    // The transfer queue aliases the graphics queue when no dedicated family exists, in which
+    // case transferCommandPool aliases commandPool as well.
+    uint32_t transferQueueFamilyIndex;
+    VkQueue transferQueue;
+    VkCommandPool transferCommandPool;
+    VulkanTransferBatch transfer;
     bool debugMarkersSupported;
     VulkanTaskQueue pendingWork;
     VulkanBinder::RasterState rasterState;
@@ -69,7 +83,7 @@ struct VulkanAttachment {
     VkFormat format;
     VkImage image;
     VkImageView view;
-    VkDeviceMemory memory;
+    VmaAllocation memory;
 };
 
 // The SwapContext is the set of objects that gets "swapped" at each beginFrame().
@@ -78,6 +92,7 @@ struct SwapContext {
     VulkanAttachment attachment;
     VkCommandBuffer cmdbuffer;
     VkFence fence;
+    VkSemaphore transferDone;
     VulkanTaskQueue pendingWork;
     bool submitted;
 };
@@ -109,7 +124,6 @@ void createDepthBuffer(VulkanContext& context, VulkanSurfaceContext& sc, VkForma
 void transitionDepthBuffer(VulkanContext& context, VulkanSurfaceContext& sc, VkFormat depthFormat);
 void createCommandBuffersAndFences(VulkanContext& context, VulkanSurfaceContext& sc);
 void destroySurfaceContext(VulkanContext& context, VulkanSurfaceContext& sc);
-uint32_t selectMemoryType(VulkanContext& context, uint32_t flags, VkFlags reqs);
 VkFormat getVkFormat(ElementType type, bool normalized);
 VkFormat getVkFormat(TextureFormat format);
 uint32_t getBytesPerPixel(TextureFormat format);
@@ -121,6 +135,9 @@ VkBlendFactor getBlendFactor(BlendFunction mode);
 void waitForIdle(VulkanContext& context);
 void acquireCommandBuffer(VulkanContext& context);
 void releaseCommandBuffer(VulkanContext& context);
+bool hasDedicatedTransferQueue(const VulkanContext& context);
+VkCommandBuffer acquireTransferBuffer(VulkanContext& context);
+void flushTransferBatch(VulkanContext& context);
 void performPendingWork(VulkanContext& context, SwapContext& swapContext, VkCommandBuffer cmdbuf);
 void flushCommandBuffer(VulkanContext& context);
 VkFormat findSupportedFormat(VulkanContext& context, const std::vector<VkFormat>& candidates,
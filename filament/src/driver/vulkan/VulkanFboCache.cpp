@@ -175,32 +175,53 @@ VkRenderPass VulkanFboCache::getRenderPass(RenderPassKey config) noexcept {
 
 void VulkanFboCache::reset() noexcept {
     for (auto pair : mFramebufferCache) {
-        mRenderPassRefCount[pair.first.renderPass]--;
-        vkDestroyFramebuffer(mContext.device, pair.second.handle, VKALLOC);
+        if (pair.second.handle != VK_NULL_HANDLE) {
+            vkDestroyFramebuffer(mContext.device, pair.second.handle, VKALLOC);
+        }
     }
     mFramebufferCache.clear();
     for (auto pair : mRenderPassCache) {
-        vkDestroyRenderPass(mContext.device, pair.second.handle, VKALLOC);
+        if (pair.second.handle != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(mContext.device, pair.second.handle, VKALLOC);
+        }
     }
     mRenderPassCache.clear();
+    mRenderPassRefCount.clear();
 }
 
 // Frees up old framebuffers and render passes, then nulls out their key.  Doesn't bother removing
 // the actual map entry since it is fairly small.
+//
+// A framebuffer is just a binding table between a render pass and a set of image views, so it is
+// cheap to recreate and can be evicted aggressively; this matters when RenderTargetPool recycles
+// targets, since each recycled set of image views creates a new framebuffer entry. Render passes
+// on the other hand are keyed on formats only and are referenced by cached pipelines, so
+// recreating one mid-frame is a hitch; keep them around much longer.
 void VulkanFboCache::gc() noexcept {
     mCurrentTime++;
-    const uint32_t evictTime = mCurrentTime - TIME_BEFORE_EVICTION;
-    for (auto iter = mFramebufferCache.begin(); iter != mFramebufferCache.end(); ++iter) {
-        if (iter->second.timestamp < evictTime) {
-            vkDestroyFramebuffer(mContext.device, iter->second.handle, VKALLOC);
-            iter.value().handle = VK_NULL_HANDLE;
+    // the guards against mCurrentTime also prevent the subtractions from wrapping around
+    // during the first few frames
+    if (mCurrentTime > FB_TIME_BEFORE_EVICTION) {
+        const uint32_t evictTime = mCurrentTime - FB_TIME_BEFORE_EVICTION;
+        for (auto iter = mFramebufferCache.begin(); iter != mFramebufferCache.end(); ++iter) {
+            if (iter->second.handle != VK_NULL_HANDLE && iter->second.timestamp < evictTime) {
+                // release this framebuffer's reference on its render pass, which otherwise
+                // could never drop to zero
+                mRenderPassRefCount[iter->first.renderPass]--;
+                vkDestroyFramebuffer(mContext.device, iter->second.handle, VKALLOC);
+                iter.value().handle = VK_NULL_HANDLE;
+            }
         }
     }
-    for (auto iter = mRenderPassCache.begin(); iter != mRenderPassCache.end(); ++iter) {
-        VkRenderPass handle = iter->second.handle;
-        if (iter->second.timestamp < evictTime && mRenderPassRefCount[handle] == 0) {
-            vkDestroyRenderPass(mContext.device, handle, VKALLOC);
-            iter.value().handle = VK_NULL_HANDLE;
+    if (mCurrentTime > RP_TIME_BEFORE_EVICTION) {
+        const uint32_t evictTime = mCurrentTime - RP_TIME_BEFORE_EVICTION;
+        for (auto iter = mRenderPassCache.begin(); iter != mRenderPassCache.end(); ++iter) {
+            VkRenderPass handle = iter->second.handle;
+            if (handle != VK_NULL_HANDLE && iter->second.timestamp < evictTime &&
+                    mRenderPassRefCount[handle] == 0) {
+                vkDestroyRenderPass(mContext.device, handle, VKALLOC);
+                iter.value().handle = VK_NULL_HANDLE;
+            }
         }
     }
 }
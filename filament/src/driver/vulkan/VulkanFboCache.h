@@ -104,7 +104,13 @@ private:
     tsl::robin_map<RenderPassKey, RenderPassVal, RenderPassHash, RenderPassEq> mRenderPassCache;
     tsl::robin_map<VkRenderPass, uint32_t> mRenderPassRefCount;
     uint32_t mCurrentTime = 0;
-    static constexpr uint32_t TIME_BEFORE_EVICTION = 2;
+
+    // Framebuffers are cheap bindings between a render pass and a set of image views, so they are
+    // evicted aggressively. Render passes are compatibility classes (keyed on formats only) that
+    // cached pipelines are built against; recreating one causes a mid-frame hitch, so they are
+    // kept for much longer.
+    static constexpr uint32_t FB_TIME_BEFORE_EVICTION = 2;
+    static constexpr uint32_t RP_TIME_BEFORE_EVICTION = 128;
 };
 
 } // namespace filament
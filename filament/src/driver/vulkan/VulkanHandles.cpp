@@ -96,13 +96,11 @@ VulkanProgram::~VulkanProgram() {
 VulkanRenderTarget::~VulkanRenderTarget() {
     if (!mSharedColorImage) {
         vkDestroyImageView(mContext.device, mColor.view, VKALLOC);
-        vkDestroyImage(mContext.device, mColor.image, VKALLOC);
-        vkFreeMemory(mContext.device, mColor.memory, VKALLOC);
+        vmaDestroyImage(mContext.allocator, mColor.image, mColor.memory);
     }
     if (!mSharedDepthImage) {
         vkDestroyImageView(mContext.device, mDepth.view, VKALLOC);
-        vkDestroyImage(mContext.device, mDepth.image, VKALLOC);
-        vkFreeMemory(mContext.device, mDepth.memory, VKALLOC);
+        vmaDestroyImage(mContext.allocator, mDepth.image, mDepth.memory);
     }
 }
 
@@ -185,22 +183,13 @@ void VulkanRenderTarget::createColorImage(VkFormat format) {
         .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
         .samples = VK_SAMPLE_COUNT_1_BIT,
     };
-    VkResult error = vkCreateImage(mContext.device, &colorImageInfo, VKALLOC, &mColor.image);
-    ASSERT_POSTCONDITION(!error, "Unable to create color attachment.");
-
-    // Allocate memory for the color image and bind it.
-    VkMemoryRequirements memReqs;
-    vkGetImageMemoryRequirements(mContext.device, mColor.image, &memReqs);
-    VkMemoryAllocateInfo allocInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memReqs.size,
-        .memoryTypeIndex = selectMemoryType(mContext, memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    // Create the VkImage and sub-allocate device memory for it from the shared allocator.
+    const VmaAllocationCreateInfo allocInfo {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
     };
-    error = vkAllocateMemory(mContext.device, &allocInfo, nullptr, &mColor.memory);
-    ASSERT_POSTCONDITION(!error, "Unable to allocate color memory.");
-    error = vkBindImageMemory(mContext.device, mColor.image, mColor.memory, 0);
-    ASSERT_POSTCONDITION(!error, "Unable to bind color memory.");
+    VkResult error = vmaCreateImage(mContext.allocator, &colorImageInfo, &allocInfo,
+            &mColor.image, &mColor.memory, nullptr);
+    ASSERT_POSTCONDITION(!error, "Unable to create color attachment.");
 
     // Transition the color image into an optimal layout.
     VkImageMemoryBarrier barrier {
@@ -247,22 +236,13 @@ void VulkanRenderTarget::createDepthImage(VkFormat format) {
         .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
         .samples = VK_SAMPLE_COUNT_1_BIT,
     };
-    VkResult error = vkCreateImage(mContext.device, &depthImageInfo, VKALLOC, &mDepth.image);
-    ASSERT_POSTCONDITION(!error, "Unable to create depth attachment.");
-
-    // Allocate memory for the depth image and bind it.
-    VkMemoryRequirements memReqs;
-    vkGetImageMemoryRequirements(mContext.device, mDepth.image, &memReqs);
-    VkMemoryAllocateInfo depthAllocInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memReqs.size,
-        .memoryTypeIndex = selectMemoryType(mContext, memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    // Create the VkImage and sub-allocate device memory for it from the shared allocator.
+    const VmaAllocationCreateInfo depthAllocInfo {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
     };
-    error = vkAllocateMemory(mContext.device, &depthAllocInfo, nullptr, &mDepth.memory);
-    ASSERT_POSTCONDITION(!error, "Unable to allocate depth memory.");
-    error = vkBindImageMemory(mContext.device, mDepth.image, mDepth.memory, 0);
-    ASSERT_POSTCONDITION(!error, "Unable to bind depth memory.");
+    VkResult error = vmaCreateImage(mContext.allocator, &depthImageInfo, &depthAllocInfo,
+            &mDepth.image, &mDepth.memory, nullptr);
+    ASSERT_POSTCONDITION(!error, "Unable to create depth attachment.");
 
     // Transition the depth image into an optimal layout and assume there's no need to read from it.
     VkImageMemoryBarrier depthBarrier {
@@ -306,8 +286,8 @@ void VulkanRenderTarget::setDepthImage(VulkanAttachment d) {
 
 VulkanVertexBuffer::VulkanVertexBuffer(VulkanContext& context, VulkanStagePool& stagePool,
         uint8_t bufferCount, uint8_t attributeCount, uint32_t elementCount,
-        Driver::AttributeArray const& attributes) :
-        HwVertexBuffer(bufferCount, attributeCount, elementCount, attributes) {
+        Driver::AttributeArray const& attributes, Driver::Usage usage) :
+        HwVertexBuffer(bufferCount, attributeCount, elementCount, attributes, usage) {
     buffers.reserve(bufferCount);
     for (uint8_t bufferIndex = 0; bufferIndex < bufferCount; ++bufferIndex) {
         uint32_t size = 0;
@@ -336,7 +316,8 @@ VulkanUniformBuffer::VulkanUniformBuffer(VulkanContext& context, VulkanStagePool
     vmaCreateBuffer(mContext.allocator, &bufferInfo, &allocInfo, &mGpuBuffer, &mGpuMemory, 0);
 }
 
-void VulkanUniformBuffer::loadFromCpu(const void* cpuData, uint32_t numBytes) {
+void VulkanUniformBuffer::loadFromCpu(const void* cpuData, uint32_t byteOffset,
+        uint32_t numBytes) {
     VkDevice device = mContext.device;
     VulkanStage const* stage = mStagePool.acquireStage(numBytes);
     void* mapped;
@@ -356,7 +337,7 @@ void VulkanUniformBuffer::loadFromCpu(const void* cpuData, uint32_t numBytes) {
         .commandBufferCount = 1
     };
     VkFenceCreateInfo fenceCreateInfo { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-    VkBufferCopy region { .size = numBytes };
+    VkBufferCopy region { .dstOffset = byteOffset, .size = numBytes };
     vkAllocateCommandBuffers(device, &allocateInfo, &cmdbuffer);
     vkCreateFence(device, &fenceCreateInfo, VKALLOC, &fence);
     vkBeginCommandBuffer(cmdbuffer, &beginInfo);
@@ -430,7 +411,15 @@ VulkanTexture::VulkanTexture(VulkanContext& context, SamplerType target, uint8_t
     } else {
         imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     }
-    VkResult error = vkCreateImage(context.device, &imageInfo, VKALLOC, &textureImage);
+    // Create the VkImage and sub-allocate device memory for it from the shared allocator. Going
+    // through the sub-allocator is important here: streaming scenarios create thousands of
+    // textures, and one vkAllocateMemory per texture quickly exhausts
+    // maxMemoryAllocationCount (4096 on many drivers).
+    const VmaAllocationCreateInfo allocInfo {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+    VkResult error = vmaCreateImage(context.allocator, &imageInfo, &allocInfo, &textureImage,
+            &textureImageMemory, nullptr);
     if (error) {
         utils::slog.d << "vkCreateImage: "
             << "result = " << error << ", "
@@ -440,20 +429,6 @@ VulkanTexture::VulkanTexture(VulkanContext& context, SamplerType target, uint8_t
     }
     ASSERT_POSTCONDITION(!error, "Unable to create image.");
 
-    // Allocate memory for the VkImage and bind it.
-    VkMemoryRequirements memReqs = {};
-    vkGetImageMemoryRequirements(context.device, textureImage, &memReqs);
-    VkMemoryAllocateInfo allocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memReqs.size,
-        .memoryTypeIndex = selectMemoryType(context, memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-    };
-    error = vkAllocateMemory(context.device, &allocInfo, nullptr, &textureImageMemory);
-    ASSERT_POSTCONDITION(!error, "Unable to allocate image memory.");
-    error = vkBindImageMemory(context.device, textureImage, textureImageMemory, 0);
-    ASSERT_POSTCONDITION(!error, "Unable to bind image.");
-
     // Create a VkImageView so that shaders can sample from the image.
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -478,9 +453,8 @@ VulkanTexture::VulkanTexture(VulkanContext& context, SamplerType target, uint8_t
 
 VulkanTexture::~VulkanTexture() {
     assert(!hasPendingWork(mContext) && "Texture destroyed while work is pending.");
-    vkDestroyImage(mContext.device, textureImage, VKALLOC);
     vkDestroyImageView(mContext.device, imageView, VKALLOC);
-    vkFreeMemory(mContext.device, textureImageMemory, VKALLOC);
+    vmaDestroyImage(mContext.allocator, textureImage, textureImageMemory);
 }
 
 void VulkanTexture::load2DImage(PixelBufferDescriptor&& data, uint32_t width, uint32_t height,
@@ -500,6 +474,23 @@ void VulkanTexture::load2DImage(PixelBufferDescriptor&& data, uint32_t width, ui
     vmaUnmapMemory(mContext.allocator, stage->memory);
     vmaFlushAllocation(mContext.allocator, stage->memory, 0, numBytes);
 
+    // Within a frame, uploads go through the dedicated transfer queue when the device has one,
+    // so that texture streaming doesn't steal graphics-queue time. The copy is recorded into the
+    // per-frame transfer batch; ownership of the image is released there and acquired by the
+    // frame's graphics command buffer, whose submission waits on the batch.
+    if (hasDedicatedTransferQueue(mContext) && mContext.cmdbuffer) {
+        VkCommandBuffer transferCmd = acquireTransferBuffer(mContext);
+        transitionImageLayout(transferCmd, textureImage, VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, miplevel);
+        copyBufferToImage(transferCmd, stage->buffer, textureImage, width, height, nullptr,
+                miplevel);
+        transferOwnershipToGraphics(transferCmd, mContext.cmdbuffer, miplevel);
+        getSwapContext(mContext).pendingWork.emplace_back([this, stage] (VkCommandBuffer) {
+            mStagePool.releaseStage(stage);
+        });
+        return;
+    }
+
     // Create a copy-to-device functor because we might need to defer it.
     auto copyToDevice = [this, stage, width, height, miplevel] (VkCommandBuffer cmd) {
         transitionImageLayout(cmd, textureImage, VK_IMAGE_LAYOUT_UNDEFINED,
@@ -533,6 +524,20 @@ void VulkanTexture::loadCubeImage(PixelBufferDescriptor&& data,  const FaceOffse
     vmaUnmapMemory(mContext.allocator, stage->memory);
     vmaFlushAllocation(mContext.allocator, stage->memory, 0, numBytes);
 
+    // See load2DImage for how in-frame uploads are batched onto the transfer queue.
+    if (hasDedicatedTransferQueue(mContext) && mContext.cmdbuffer) {
+        VkCommandBuffer transferCmd = acquireTransferBuffer(mContext);
+        transitionImageLayout(transferCmd, textureImage, VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, miplevel);
+        copyBufferToImage(transferCmd, stage->buffer, textureImage, width, height, &faceOffsets,
+                miplevel);
+        transferOwnershipToGraphics(transferCmd, mContext.cmdbuffer, miplevel);
+        getSwapContext(mContext).pendingWork.emplace_back([this, stage] (VkCommandBuffer) {
+            mStagePool.releaseStage(stage);
+        });
+        return;
+    }
+
     // Create a copy-to-device functor because we might need to defer it.
     auto copyToDevice = [this, faceOffsets, stage, miplevel] (VkCommandBuffer cmd) {
         transitionImageLayout(cmd, textureImage, VK_IMAGE_LAYOUT_UNDEFINED,
@@ -620,6 +625,54 @@ void VulkanTexture::copyBufferToImage(VkCommandBuffer cmd, VkBuffer buffer, VkIm
     vkCmdCopyBufferToImage(cmd, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 }
 
+// Records a queue-family ownership transfer for one mip level: a release barrier on the transfer
+// queue's command buffer and the matching acquire barrier on the graphics queue's. Both sides
+// carry the TRANSFER_DST => SHADER_READ_ONLY layout transition, as the spec requires identical
+// barriers for a release/acquire pair.
+void VulkanTexture::transferOwnershipToGraphics(VkCommandBuffer transferCmd,
+        VkCommandBuffer graphicsCmd, uint32_t miplevel) {
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = mContext.transferQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = mContext.graphicsQueueFamilyIndex;
+    barrier.image = textureImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = miplevel;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = this->target == SamplerType::SAMPLER_CUBEMAP ? 6 : 1;
+    // Release on the transfer queue; the destination access mask is ignored on this side.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    // Acquire on the graphics queue; the source access mask is ignored on this side.
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(graphicsCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VulkanTimerQuery::VulkanTimerQuery(VulkanContext& context) : context(context) {
+    // timestampPeriod is zero on devices that do not support timestamp queries.
+    if (context.physicalDeviceProperties.limits.timestampPeriod > 0) {
+        VkQueryPoolCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2,
+        };
+        vkCreateQueryPool(context.device, &createInfo, VKALLOC, &timerPool);
+    }
+}
+
+VulkanTimerQuery::~VulkanTimerQuery() {
+    if (timerPool) {
+        vkDestroyQueryPool(context.device, timerPool, VKALLOC);
+    }
+}
+
 void VulkanRenderPrimitive::setPrimitiveType(Driver::PrimitiveType pt) {
     this->type = pt;
     switch (pt) {
@@ -84,13 +84,13 @@ struct VulkanSwapChain : public HwSwapChain {
 struct VulkanVertexBuffer : public HwVertexBuffer {
     VulkanVertexBuffer(VulkanContext& context, VulkanStagePool& stagePool, uint8_t bufferCount,
             uint8_t attributeCount, uint32_t elementCount,
-            Driver::AttributeArray const& attributes);
+            Driver::AttributeArray const& attributes, Driver::Usage usage);
     std::vector<std::unique_ptr<VulkanBuffer>> buffers;
 };
 
 struct VulkanIndexBuffer : public HwIndexBuffer {
     VulkanIndexBuffer(VulkanContext& context, VulkanStagePool& stagePool, uint8_t elementSize,
-            uint32_t indexCount) : HwIndexBuffer(elementSize, indexCount),
+            uint32_t indexCount, Driver::Usage usage) : HwIndexBuffer(elementSize, indexCount, usage),
             indexType(elementSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32),
             buffer(new VulkanBuffer(context, stagePool, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
             elementSize * indexCount)) {}
@@ -101,7 +101,7 @@ struct VulkanIndexBuffer : public HwIndexBuffer {
 struct VulkanUniformBuffer : public HwUniformBuffer {
     VulkanUniformBuffer(VulkanContext& context, VulkanStagePool& stagePool, uint32_t numBytes);
     ~VulkanUniformBuffer();
-    void loadFromCpu(const void* cpuData, uint32_t numBytes);
+    void loadFromCpu(const void* cpuData, uint32_t byteOffset, uint32_t numBytes);
     VkBuffer getGpuBuffer() const { return mGpuBuffer; }
 private:
     VulkanContext& mContext;
@@ -124,17 +124,28 @@ struct VulkanTexture : public HwTexture {
     VkFormat format;
     VkImageView imageView = VK_NULL_HANDLE;
     VkImage textureImage = VK_NULL_HANDLE;
-    VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
+    VmaAllocation textureImageMemory = VK_NULL_HANDLE;
 private:
     void transitionImageLayout(VkCommandBuffer cmdbuffer, VkImage image,
             VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t miplevel);
     void copyBufferToImage(VkCommandBuffer cmdbuffer, VkBuffer buffer, VkImage image,
             uint32_t width, uint32_t height, FaceOffsets const* faceOffsets, uint32_t miplevel);
+    void transferOwnershipToGraphics(VkCommandBuffer transferCmd, VkCommandBuffer graphicsCmd,
+            uint32_t miplevel);
     VulkanContext& mContext;
     VulkanStagePool& mStagePool;
     uint32_t mByteCount;
 };
 
+struct VulkanTimerQuery : public HwTimerQuery {
+    VulkanTimerQuery(VulkanContext& context);
+    ~VulkanTimerQuery();
+    VulkanContext& context;
+    VkQueryPool timerPool = VK_NULL_HANDLE;
+    // whether timestamps have been written at least once (i.e. it's legal to ask for results)
+    bool begun = false;
+};
+
 struct VulkanRenderPrimitive : public HwRenderPrimitive {
     VulkanRenderPrimitive(VulkanContext& context) {}
     void setPrimitiveType(Driver::PrimitiveType pt);
@@ -16,13 +16,29 @@
 
 #include <filament/Box.h>
 #include <filament/Frustum.h>
+#include <filament/LightManager.h>
+#include <filament/Viewport.h>
+
+#include "details/Allocators.h"
 #include "details/Culler.h"
+#include "details/Engine.h"
+#include "details/Froxelizer.h"
+#include "details/Scene.h"
+
+#include "driver/CircularBuffer.h"
+#include "driver/CommandStream.h"
+#include "driver/UniformBuffer.h"
+#include "driver/noop/NoopDriver.h"
 
+#include <utils/EntityManager.h>
+#include <utils/JobSystem.h>
 #include <utils/Profiler.h>
 #include <utils/compiler.h>
 #include <math/fast.h>
 #include <math/scalar.h>
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <random>
@@ -32,6 +48,17 @@ using namespace filament::details;
 using namespace math;
 using namespace utils;
 
+// one result per benchmark; this is what --json dumps, so the perf CI can
+// diff runs against a baseline
+struct BenchmarkResult {
+    const char* name;
+    size_t items;           // work items processed by one call of the workload
+    double nsPerItem;       // best observed wall-clock time per item
+    double cvPct;           // run-to-run coefficient of variation, in percent
+};
+
+static std::vector<BenchmarkResult> g_results;
+
 UTILS_NOINLINE
 void printResults(char const* name, size_t REPEAT, Profiler::Counters const& c) {
     std::cout << name << ":" << std::endl;
@@ -39,12 +66,11 @@ void printResults(char const* name, size_t REPEAT, Profiler::Counters const& c)
     std::cout << "cycles:       " << c.getCpuCycles() / float(REPEAT) << std::endl;
     std::cout << "bpu misses:   " << c.getBranchMisses() / float(REPEAT) << " (" << c.getBranchMisses() << "/" << REPEAT << ")" << std::endl;
     std::cout << "CPI:          " << c.getCPI() << std::endl;
-    std::cout << "" << std::endl;
 }
 
 template <typename T, size_t REPEAT = 2>
-void benchmark(Profiler& p, const char* const name, T f) {
-    Profiler::Counters b;
+void benchmark(Profiler& p, const char* const name, size_t items, T f) {
+    // hardware counters -- these read zero on platforms without perf events
     Profiler::Counters c;
     p.start();
 
@@ -60,12 +86,69 @@ void benchmark(Profiler& p, const char* const name, T f) {
     p.stop();
     p.readCounters(&c);
     printResults(name, REPEAT, c);
+
+    // wall-clock time, available everywhere: calibrate the number of calls so a
+    // run lasts at least ~10ms, then keep the best of a few runs (the minimum is
+    // the least noisy estimator on a quiet machine)
+    using clock = std::chrono::steady_clock;
+    auto runOnce = [&f](size_t calls) -> double {
+        auto t0 = clock::now();
+        for (size_t i = 0; i < calls; i++) {
+            f();
+        }
+        auto t1 = clock::now();
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    };
+
+    size_t calls = 1;
+    double ns = runOnce(calls);
+    while (ns < 10000000.0 && calls < (size_t(1) << 24)) {
+        calls *= 2;
+        ns = runOnce(calls);
+    }
+    // several measured runs: the minimum is the least noisy estimator on a quiet
+    // machine, and the spread across runs tells the perf CI how much variance to
+    // expect -- a 3% regression is only credible when the variance is well below
+    // that (run with --deterministic to take the scheduler out of the spread)
+    constexpr size_t RUNS = 5;
+    double best = ns / double(calls);
+    double sum = 0.0, sum2 = 0.0;
+    for (size_t run = 0; run < RUNS; run++) {
+        const double t = runOnce(calls) / double(calls);
+        best = std::min(best, t);
+        sum += t;
+        sum2 += t * t;
+    }
+    const double mean = sum / RUNS;
+    const double variance = std::max(0.0, sum2 / RUNS - mean * mean);
+    const double cvPct = mean > 0.0 ? 100.0 * std::sqrt(variance) / mean : 0.0;
+
+    const double nsPerItem = best / double(items);
+    std::cout << "time:         " << best << " ns (" << nsPerItem << " ns / item)" << std::endl;
+    std::cout << "variance:     " << cvPct << " % over " << RUNS << " runs" << std::endl;
+    std::cout << "" << std::endl;
+
+    g_results.push_back({ name, items, nsPerItem, cvPct });
 }
 
-// ------------------------------------------------------------------------------------------------
+static bool writeJson(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+    fputs("{\"benchmarks\":[\n", f);
+    for (size_t i = 0; i < g_results.size(); i++) {
+        BenchmarkResult const& r = g_results[i];
+        fprintf(f, "  {\"name\":\"%s\",\"items\":%zu,\"ns_per_item\":%.3f,\"cv_pct\":%.2f}%s\n",
+                r.name, r.items, r.nsPerItem, r.cvPct, i + 1 < g_results.size() ? "," : "");
+    }
+    fputs("]}\n", f);
+    return fclose(f) == 0;
+}
 
-int main(void) {
+// ------------------------------------------------------------------------------------------------
 
+static void benchmarkCuller(Profiler& p) {
     std::mt19937 gen;
     std::uniform_real_distribution<float> rand(-100.0f, 100.0f);
 
@@ -96,14 +179,7 @@ int main(void) {
     Culler::result_type * __restrict__ visibles = nullptr;
     posix_memalign((void**)&visibles, 32, batch * sizeof(*visibles));
 
-    Profiler::Counters c;
-    Profiler& p = Profiler::get();
-    p.resetEvents(
-            Profiler::EV_CPU_CYCLES |
-            Profiler::EV_BPU_MISSES
-    );
-
-    benchmark(p, "Box Culling Direct", [&]() {
+    benchmark(p, "Culler::intersects (boxes)", batch, [&]() {
         Culler::Test::intersects(visibles, frustum, boxesCenter.data(), boxesExtent.data(), batch);
     });
 
@@ -112,7 +188,14 @@ int main(void) {
         vb = vb + (visibles[i] ? 1 : 0);
     }
 
-    benchmark(p, "Sphere Culling Direct", [&]() {
+    // scalar reference path, so the speed-up (and per-box cost) of the SIMD path can
+    // be read off directly from the same run
+    benchmark(p, "Culler::intersects (boxes, scalar)", batch, [&]() {
+        Culler::Test::intersectsScalar(visibles, frustum, boxesCenter.data(), boxesExtent.data(),
+                batch);
+    });
+
+    benchmark(p, "Culler::intersects (spheres)", batch, [&]() {
         Culler::Test::intersects(visibles, frustum, spheres.data(), batch);
     });
 
@@ -121,6 +204,27 @@ int main(void) {
         vs = vs + (visibles[i] ? 1 : 0);
     }
 
+    benchmark(p, "Culler::intersects (spheres, scalar)", batch, [&]() {
+        Culler::Test::intersectsScalar(visibles, frustum, spheres.data(), batch);
+    });
+
+    // conformance spot-check: the benchmark runs in Release where the gtest
+    // conformance suite isn't built, so flag scalar/SIMD divergence here too
+    {
+        std::vector<Culler::result_type> scalar(batch, 0);
+        Culler::Test::intersectsScalar(scalar.data(), frustum,
+                boxesCenter.data(), boxesExtent.data(), batch);
+        Culler::Test::intersects(visibles, frustum,
+                boxesCenter.data(), boxesExtent.data(), batch);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < batch; i++) {
+            mismatches += visibles[i] != scalar[i] ? 1 : 0;
+        }
+        if (mismatches) {
+            std::cout << "WARNING: scalar/SIMD culling mismatches: " << mismatches << std::endl;
+        }
+    }
+
     std::cout << "visible boxes: " << vb << std::endl;
     std::cout << "visible spheres: " << vs << std::endl;
     std::cout << std::endl;
@@ -128,37 +232,37 @@ int main(void) {
     free(visibles);
 
 
-    benchmark(p, "cos", [&]() {
+    benchmark(p, "cos", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheres[i].x = std::cos(spheres[i].x);
         }
     });
 
-    benchmark(p, "fast::cos", [&]() {
+    benchmark(p, "fast::cos", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheres[i].x = math::fast::cos<float>(spheres[i].x);
         }
     });
-    
-    benchmark(p, "rsqrt", [&]() {
+
+    benchmark(p, "rsqrt", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheres[i].x = 1.0f / std::sqrt(spheres[i].x);
         }
     });
 
-    benchmark(p, "fast::rsqrt", [&]() {
+    benchmark(p, "fast::rsqrt", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheres[i].x = math::fast::isqrt(spheres[i].x);
         }
     });
 
-    benchmark(p, "half4", [&]() {
+    benchmark(p, "half4", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheresHalf[i] = half4(spheres[i]);
         }
     });
 
-    benchmark(p, "half x 4", [&]() {
+    benchmark(p, "half x 4", batch, [&]() {
         for (size_t i = 0; i < batch; i++) {
             spheresHalf[i] = half4(
                     spheres[i].x,
@@ -168,6 +272,137 @@ int main(void) {
             );
         }
     });
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static void benchmarkUniformBuffer(Profiler& p) {
+    // typical per-view UBO size; scattered stores exercise the dirty range
+    // tracking of invalidateUniforms()
+    constexpr size_t UBO_SIZE = 16384;
+    constexpr size_t COUNT = 256;
+    UniformBuffer ub(UBO_SIZE);
+
+    benchmark(p, "UniformBuffer invalidation (float4)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            // stride co-prime with the buffer size so the offsets scatter
+            size_t offset = (i * 21 * sizeof(float4)) % (UBO_SIZE - sizeof(float4));
+            ub.setUniform(offset, float4{ float(i) });
+        }
+        ub.clean();
+    });
+
+    benchmark(p, "UniformBuffer invalidation (mat4f)", COUNT, [&]() {
+        for (size_t i = 0; i < COUNT; i++) {
+            size_t offset = (i * 3 * sizeof(mat4f)) % (UBO_SIZE - sizeof(mat4f));
+            ub.setUniform(offset, mat4f{});
+        }
+        ub.clean();
+    });
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static void benchmarkCommandStream(Profiler& p) {
+    // records COUNT trivial commands into a CircularBuffer and dispatches them
+    // into the no-op driver, which isolates the cost of the command machinery
+    // (encode, dispatch, pointer chase) from any GL/Vulkan work
+    constexpr size_t COUNT = 1024;
+    CircularBuffer circularBuffer(1048576);
+    Driver* driver = NoopDriver::create();
+    CommandStream stream(*driver, circularBuffer);
+
+    benchmark(p, "CommandStream dispatch", COUNT, [&]() {
+        void* buffer = circularBuffer.getHead();
+        for (size_t i = 0; i < COUNT / 2; i++) {
+            stream.pushGroupMarker("benchmark");
+            stream.popGroupMarker();
+        }
+        new(circularBuffer.allocate(sizeof(NoopCommand))) NoopCommand(nullptr);
+        stream.execute(buffer);
+        circularBuffer.circularize();
+    });
+
+    delete driver;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static void benchmarkFroxelizer(Profiler& p) {
+    FEngine* engine = FEngine::create();
+
+    LinearAllocatorArena arena("FRenderer: per-frame allocator",
+            FEngine::CONFIG_PER_RENDER_PASS_ARENA_SIZE);
+    utils::ArenaScope<LinearAllocatorArena> scope(arena);
+
+    Viewport vp(0, 0, 1280, 720);
+    mat4f projection = mat4f::perspective(90, 16.0f / 9.0f, 0.1, 100, mat4f::Fov::HORIZONTAL);
+
+    Froxelizer froxelizer(*engine);
+    froxelizer.setOptions(5, 100);
+    froxelizer.prepare(engine->getDriverApi(), scope, vp, projection, 0.1, 100);
+
+    // a dummy point light that can be referenced from the LightSoa; the
+    // froxelization cost depends on positions/radii, not on light parameters
+    Entity e = engine->getEntityManager().create();
+    LightManager::Builder(LightManager::Type::POINT).build(*engine, e);
+    LightManager::Instance instance = engine->getLightManager().getInstance(e);
+
+    // lights scattered in the frustum (view-space), radii large enough to
+    // cover several froxels each -- roughly what a dense game scene produces
+    constexpr size_t LIGHT_COUNT = 256;
+    std::mt19937 gen;
+    std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+
+    FScene::LightSoa lights;
+    lights.push_back({}, {}, {}, {}, {});   // first one is always skipped (directional)
+    for (size_t i = 0; i < LIGHT_COUNT; i++) {
+        float z = 0.5f + rand(gen) * 90.0f;
+        float x = (rand(gen) * 2.0f - 1.0f) * z;
+        float y = (rand(gen) * 2.0f - 1.0f) * z * (9.0f / 16.0f);
+        float radius = 1.0f + rand(gen) * 4.0f;
+        lights.push_back(float4{ x, y, -z, radius }, {}, instance, 1, {});
+    }
+
+    benchmark(p, "Froxelizer::froxelizeLights", LIGHT_COUNT, [&]() {
+        froxelizer.froxelizeLights(*engine, {}, lights);
+    });
+
+    froxelizer.terminate(engine->getDriverApi());
+    engine->shutdown();
+    delete engine;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (!strcmp(argv[i], "--deterministic")) {
+            // must be set before the engine (and its JobSystem) is created
+            JobSystem::setDeterministic(true);
+        }
+    }
+
+    Profiler& p = Profiler::get();
+    p.resetEvents(
+            Profiler::EV_CPU_CYCLES |
+            Profiler::EV_BPU_MISSES
+    );
+
+    benchmarkCuller(p);
+    benchmarkUniformBuffer(p);
+    benchmarkCommandStream(p);
+    benchmarkFroxelizer(p);
+
+    if (jsonPath) {
+        if (!writeJson(jsonPath)) {
+            std::cerr << "could not write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
 
     return 0;
 }
@@ -178,3 +413,9 @@ int main(void) {
 //
 // make -j4 && adb push filament/filament/test/benchmark_filament /data/local/tmp
 // adb shell /data/local/tmp/filament_benchmark
+//
+// On desktop, run directly; pass "--json <path>" to write the results as JSON
+// ({"benchmarks":[{"name":...,"ns_per_item":...,"cv_pct":...},...]}) for the perf CI
+// to diff against its baselines; cv_pct is the run-to-run variance, which sizes the
+// regression threshold. Pass "--deterministic" for repeatable JobSystem scheduling
+// when bisecting small regressions.
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/CircularBuffer.h"
+#include "driver/CommandStream.h"
+#include "driver/noop/NoopDriver.h"
+
+#include <chrono>
+#include <iostream>
+#include <new>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament;
+
+// Replays a command stream capture (see CommandStream::startRecording()) against the
+// no-op driver. This gives a deterministic, GPU-independent measurement of the CPU
+// cost of the submission path: command decode, dispatch and driver entry.
+
+static void printUsage(const char* name) {
+    std::cout << "usage: " << name << " [options] <capture>\n"
+              << "options:\n"
+              << "   --generate, -g\n"
+              << "       write a synthetic capture to <capture> instead of replaying\n"
+              << "   --iterations=<n>, -n <n>\n"
+              << "       number of replay iterations (default 100)\n"
+              << "   --json=<path>, -j <path>\n"
+              << "       also write the results as JSON for the perf CI\n"
+              << "   --max-ns-per-command=<x>, -m <x>\n"
+              << "       fail (exit 1) if a command costs more than <x> ns on average,\n"
+              << "       so the CI can gate regressions of the submission path\n";
+}
+
+// records a synthetic frame so the harness can be exercised without an application
+// capture at hand
+static int generateCapture(const char* path) {
+    CircularBuffer circularBuffer(1048576);
+    Driver* driver = NoopDriver::create();
+    CommandStream stream(*driver, circularBuffer);
+
+    if (!stream.startRecording(path)) {
+        std::cerr << "could not write " << path << std::endl;
+        delete driver;
+        return 1;
+    }
+
+    void* const buffer = circularBuffer.getHead();
+    // mimic a frame's hot loop: per "primitive", the two (compact) bind commands
+    // followed by a draw, with a group marker pair per "pass"
+    Driver::RasterState rs;
+    for (size_t i = 0; i < 256; i++) {
+        stream.pushGroupMarker("replay");
+        for (size_t j = 0; j < 16; j++) {
+            stream.bindUniforms(0, Driver::UniformBufferHandle());
+            stream.bindSamplers(1, Driver::SamplerBufferHandle());
+            stream.draw(Driver::ProgramHandle(), rs, Driver::RenderPrimitiveHandle(), 1);
+        }
+        stream.popGroupMarker();
+    }
+    new(circularBuffer.allocate(sizeof(NoopCommand))) NoopCommand(nullptr);
+    stream.execute(buffer);
+    circularBuffer.circularize();
+    stream.stopRecording();
+
+    delete driver;
+    std::cout << "wrote " << path << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* capturePath = nullptr;
+    const char* jsonPath = nullptr;
+    size_t iterations = 100;
+    double maxNsPerCommand = 0.0;
+    bool generate = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--generate") || !strcmp(arg, "-g")) {
+            generate = true;
+        } else if (!strncmp(arg, "--iterations=", 13)) {
+            iterations = size_t(atol(arg + 13));
+        } else if (!strcmp(arg, "-n") && i + 1 < argc) {
+            iterations = size_t(atol(argv[++i]));
+        } else if (!strncmp(arg, "--json=", 7)) {
+            jsonPath = arg + 7;
+        } else if (!strcmp(arg, "-j") && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (!strncmp(arg, "--max-ns-per-command=", 21)) {
+            maxNsPerCommand = atof(arg + 21);
+        } else if (!strcmp(arg, "-m") && i + 1 < argc) {
+            maxNsPerCommand = atof(argv[++i]);
+        } else if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            capturePath = arg;
+        }
+    }
+
+    if (!capturePath || !iterations) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (generate) {
+        return generateCapture(capturePath);
+    }
+
+    Driver* driver = NoopDriver::create();
+    CircularBuffer circularBuffer(CircularBuffer::BLOCK_SIZE);  // execute() doesn't allocate
+    CommandStream stream(*driver, circularBuffer);
+
+    size_t size = 0;
+    size_t commandCount = 0;
+    void* const pristine = CommandStream::loadCapture(capturePath, *driver, &size, &commandCount);
+    if (!pristine) {
+        std::cerr << "could not load " << capturePath << std::endl;
+        delete driver;
+        return 1;
+    }
+
+    // dispatching consumes the commands, so each iteration replays a fresh copy
+    void* const buffer = malloc(size);
+
+    // warm-up, also primes the page cache and branch predictors
+    memcpy(buffer, pristine, size);
+    stream.execute(buffer);
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        memcpy(buffer, pristine, size);
+        stream.execute(buffer);
+    }
+    auto t1 = clock::now();
+
+    const double total =
+            double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    const double nsPerFrame = total / double(iterations);
+    const double nsPerCommand = commandCount ? nsPerFrame / double(commandCount) : 0.0;
+
+    std::cout << "commands:     " << commandCount << " (" << size << " bytes)" << std::endl;
+    std::cout << "iterations:   " << iterations << std::endl;
+    std::cout << "frame:        " << nsPerFrame << " ns" << std::endl;
+    std::cout << "per command:  " << nsPerCommand << " ns" << std::endl;
+
+    int status = 0;
+    if (maxNsPerCommand > 0.0 && nsPerCommand > maxNsPerCommand) {
+        std::cerr << "FAILED: " << nsPerCommand << " ns per command exceeds the gate of "
+                  << maxNsPerCommand << " ns" << std::endl;
+        status = 1;
+    }
+    if (jsonPath) {
+        FILE* f = fopen(jsonPath, "w");
+        if (f) {
+            fprintf(f, "{\"capture\":\"%s\",\"commands\":%zu,\"iterations\":%zu,"
+                       "\"ns_per_frame\":%.3f,\"ns_per_command\":%.3f}\n",
+                    capturePath, commandCount, iterations, nsPerFrame, nsPerCommand);
+            fclose(f);
+        } else {
+            std::cerr << "could not write " << jsonPath << std::endl;
+            status = 1;
+        }
+    }
+
+    free(buffer);
+    free(pristine);
+    delete driver;
+    return status;
+}
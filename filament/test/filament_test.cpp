@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -28,6 +32,7 @@
 #include <filament/Material.h>
 #include <filament/Engine.h>
 
+#include "driver/SamplerBuffer.h"
 #include "driver/UniformBuffer.h"
 #include <filament/UniformInterfaceBlock.h>
 
@@ -36,6 +41,11 @@
 #include "details/Camera.h"
 #include "details/Froxelizer.h"
 #include "details/Engine.h"
+#include "details/OcclusionBuffer.h"
+#include "details/RenderableBvh.h"
+#include "details/ShadowAtlas.h"
+
+#include <utils/JobSystem.h>
 #include "components/TransformManager.h"
 #include "utils/RangeSet.h"
 
@@ -144,6 +154,49 @@ TEST(FilamentTest, TransformManager) {
     EXPECT_EQ(tcm.getWorldTransform(child), mat4f{ float4{ 8 }});
 }
 
+TEST(FilamentTest, TransformManagerDirtySubtrees) {
+    filament::details::FTransformManager tcm;
+    EntityManager& em = EntityManager::get();
+    std::array<Entity, 4> entities;
+    em.create(entities.size(), entities.data());
+
+    // two independent subtrees: a -> b and c -> d
+    tcm.create(entities[0]);
+    TransformManager::Instance a = tcm.getInstance(entities[0]);
+    tcm.create(entities[1], a, mat4f{});
+    tcm.create(entities[2]);
+    TransformManager::Instance c = tcm.getInstance(entities[2]);
+    tcm.create(entities[3], c, mat4f{});
+
+    // only dirty the first subtree
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 2 }});
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[0])), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[1])), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[2])), mat4f{ float4{ 1 }});
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[3])), mat4f{ float4{ 1 }});
+
+    // dirty both roots in one transaction, they form independent dirty subtrees
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 4 }});
+    tcm.setTransform(tcm.getInstance(entities[2]), mat4f{ float4{ 8 }});
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[1])), mat4f{ float4{ 4 }});
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[3])), mat4f{ float4{ 8 }});
+
+    // dirtying a node and one of its descendants must not recompute the subtree twice
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 2 }});
+    tcm.setTransform(tcm.getInstance(entities[1]), mat4f{ float4{ 2 }});
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[0])), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getWorldTransform(tcm.getInstance(entities[1])), mat4f{ float4{ 4 }});
+}
+
 TEST(FilamentTest, UniformInterfaceBlock) {
 
     UniformInterfaceBlock::Builder b;
@@ -328,6 +381,108 @@ TEST(FilamentTest, UniformBuffer) {
     //buffer.log(std::cout, ib);
 }
 
+TEST(FilamentTest, UniformBufferDirtyRanges) {
+    UniformBuffer buffer(4096);
+
+    // a freshly created buffer is entirely dirty
+    EXPECT_TRUE(buffer.isDirty());
+    ASSERT_EQ(1, buffer.getDirtyRangeCount());
+    EXPECT_EQ(0, buffer.getDirtyRange(0).begin);
+    EXPECT_EQ(4096, buffer.getDirtyRange(0).end);
+
+    buffer.clean();
+    EXPECT_FALSE(buffer.isDirty());
+    EXPECT_EQ(0, buffer.getDirtyRangeCount());
+
+    // nearby writes coalesce into a single range...
+    buffer.setUniform(0, 1.0f);
+    buffer.setUniform(16, 1.0f);
+    ASSERT_EQ(1, buffer.getDirtyRangeCount());
+    EXPECT_EQ(0, buffer.getDirtyRange(0).begin);
+    EXPECT_EQ(20, buffer.getDirtyRange(0).end);
+
+    // ...while distant writes get their own range instead of spanning the hole
+    buffer.setUniform(1024, 1.0f);
+    buffer.setUniform(2048, 1.0f);
+    buffer.setUniform(3072, 1.0f);
+    ASSERT_EQ(4, buffer.getDirtyRangeCount());
+    EXPECT_EQ(1024, buffer.getDirtyRange(1).begin);
+    EXPECT_EQ(1028, buffer.getDirtyRange(1).end);
+
+    // the spanning range is still tracked for consumers that want a single upload
+    EXPECT_EQ(0, buffer.getDirtyOffset());
+    EXPECT_EQ(3076, buffer.getDirtySize());
+
+    // when the set is full, the write merges with the nearest range
+    buffer.setUniform(512, 1.0f);
+    ASSERT_EQ(4, buffer.getDirtyRangeCount());
+    EXPECT_EQ(0, buffer.getDirtyRange(0).begin);
+    EXPECT_EQ(516, buffer.getDirtyRange(0).end);
+
+    buffer.clean();
+    EXPECT_EQ(0, buffer.getDirtyRangeCount());
+}
+
+TEST(FilamentTest, SamplerBufferVersion) {
+    SamplerBuffer sb(4);
+    EXPECT_FALSE(sb.isDirty());
+    uint32_t const v0 = sb.getVersion();
+
+    // setting a sampler to its current (default) content is a no-op
+    sb.setSampler(0, SamplerBuffer::Sampler{ Handle<HwTexture>{}, driver::SamplerParams{} });
+    EXPECT_FALSE(sb.isDirty());
+    EXPECT_EQ(v0, sb.getVersion());
+
+    // an actual change dirties the buffer and bumps the generation
+    driver::SamplerParams params;
+    params.filterMag = driver::SamplerMagFilter::LINEAR;
+    sb.setSampler(0, Handle<HwTexture>{ 16 }, params);
+    EXPECT_TRUE(sb.isDirty());
+    EXPECT_NE(v0, sb.getVersion());
+
+    // re-setting the same content leaves the generation alone...
+    sb.clean();
+    uint32_t const v1 = sb.getVersion();
+    sb.setSampler(0, Handle<HwTexture>{ 16 }, params);
+    EXPECT_FALSE(sb.isDirty());
+    EXPECT_EQ(v1, sb.getVersion());
+
+    // ...and the generation survives the copy sent through the command stream
+    SamplerBuffer copy(sb);
+    EXPECT_EQ(sb.getVersion(), copy.getVersion());
+}
+
+TEST(FilamentTest, UniformInterfaceBlockPack) {
+    UniformInterfaceBlock::Builder b;
+    b.name("TestPack");
+    b.add("a_float_0", 1, UniformInterfaceBlock::Type::FLOAT);
+    b.add("a_mat4_0",  1, UniformInterfaceBlock::Type::MAT4);
+    b.add("a_float_1", 1, UniformInterfaceBlock::Type::FLOAT);
+    b.add("a_vec4_0",  1, UniformInterfaceBlock::Type::FLOAT4);
+    b.add("a_float[3]",3, UniformInterfaceBlock::Type::FLOAT);
+    b.add("a_float_2", 1, UniformInterfaceBlock::Type::FLOAT);
+    b.pack();
+
+    UniformInterfaceBlock ib(b.build());
+    auto const& info = ib.getUniformInfoList();
+
+    // double4-aligned members first (declaration order preserved among them),
+    // scalars packed together at the end
+    EXPECT_STREQ("a_mat4_0",  info[0].name.c_str());
+    EXPECT_STREQ("a_vec4_0",  info[1].name.c_str());
+    EXPECT_STREQ("a_float[3]",info[2].name.c_str());
+    EXPECT_STREQ("a_float_0", info[3].name.c_str());
+    EXPECT_STREQ("a_float_1", info[4].name.c_str());
+    EXPECT_STREQ("a_float_2", info[5].name.c_str());
+
+    // the scalars are contiguous, with no padding between them
+    EXPECT_EQ(info[3].offset + 1, info[4].offset);
+    EXPECT_EQ(info[4].offset + 1, info[5].offset);
+
+    // offsets are still found by name after the reorder
+    EXPECT_EQ(ssize_t(info[4].offset) * 4, ib.getUniformOffset("a_float_1", 0));
+}
+
 TEST(FilamentTest, BoxCulling) {
     Frustum frustum(mat4f::frustum(-1, 1, -1, 1, 1, 100));
 
@@ -408,6 +563,240 @@ TEST(FilamentTest, SphereCulling) {
     EXPECT_TRUE(frustum.intersects({ 0, 200 }));
 }
 
+TEST(FilamentTest, RenderableBvh) {
+    using filament::details::RenderableBvh;
+    using filament::details::Culler;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> pos(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> ext(0.1f, 10.0f);
+
+    constexpr uint32_t N = 5000;
+    std::vector<float3> centers(Culler::round(N) + Culler::MODULO);
+    std::vector<float3> extents(Culler::round(N) + Culler::MODULO);
+    for (uint32_t i = 0; i < N; i++) {
+        centers[i] = { pos(gen), pos(gen), pos(gen) };
+        extents[i] = { ext(gen), ext(gen), ext(gen) };
+    }
+
+    Frustum frustum(mat4f::perspective(60.0f, 1.5f, 0.1f, 150.0f));
+
+    // the BVH must produce exactly the same visibility bits as the flat path
+    std::vector<Culler::result_type> flat(centers.size(), 0);
+    std::vector<Culler::result_type> hierarchical(centers.size(), 0);
+    Culler::intersects(flat.data(), frustum,
+            centers.data(), extents.data(), Culler::round(N), 2);
+
+    RenderableBvh bvh;
+    bvh.build(centers.data(), extents.data(), N);
+    EXPECT_EQ(N, bvh.size());
+    bvh.cull(frustum, hierarchical.data(), 2);
+
+    size_t visible = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        EXPECT_EQ(flat[i], hierarchical[i]);
+        visible += flat[i] ? 1 : 0;
+    }
+    // sanity: the frustum must neither contain everything nor nothing
+    EXPECT_GT(visible, 0);
+    EXPECT_LT(visible, N);
+
+    // move everything and refit: bounds must follow without a rebuild
+    for (uint32_t i = 0; i < N; i++) {
+        centers[i].x += 25.0f;
+    }
+    bvh.refit(centers.data(), extents.data());
+
+    std::fill(flat.begin(), flat.end(), 0);
+    std::fill(hierarchical.begin(), hierarchical.end(), 0);
+    Culler::intersects(flat.data(), frustum,
+            centers.data(), extents.data(), Culler::round(N), 0);
+    bvh.cull(frustum, hierarchical.data(), 0);
+    for (uint32_t i = 0; i < N; i++) {
+        EXPECT_EQ(flat[i], hierarchical[i]);
+    }
+}
+
+TEST(FilamentTest, CullerScalarSimdConformance) {
+    using filament::details::Culler;
+
+    // The vectorized culling paths must produce the same visibility bits as the scalar
+    // reference (Culler::Test::intersectsScalar) on adversarial inputs. The only
+    // tolerated divergence is a bound lying on a plane within floating-point rounding
+    // distance -- the two paths accumulate the plane equation in a different order, so
+    // they may round such a distance to opposite signs. That case is detected by
+    // recomputing the distance in double precision and requiring it to be zero within
+    // a few ulp of the terms' magnitude; anything larger is a real precision bug.
+    auto isBoundary = [](double distance, double scale) {
+        return std::abs(distance) <= scale * 1e-6 + 1e-30;
+    };
+
+    auto checkBoxes = [&](Frustum const& frustum, const char* name,
+            std::vector<float3> const& c, std::vector<float3> const& e) {
+        const size_t count = c.size();
+        std::vector<Culler::result_type> simd(count, 0);
+        std::vector<Culler::result_type> scalar(count, 0);
+        Culler::Test::intersects(simd.data(), frustum, c.data(), e.data(), count);
+        Culler::Test::intersectsScalar(scalar.data(), frustum, c.data(), e.data(), count);
+        float4 const* const planes = frustum.getNormalizedPlanes();
+        for (size_t i = 0; i < count; i++) {
+            if (simd[i] == scalar[i]) continue;
+            bool boundary = false;
+            for (size_t j = 0; j < 6 && !boundary; j++) {
+                const double px = planes[j].x, py = planes[j].y, pz = planes[j].z;
+                const double terms[7] = {
+                        px * c[i].x, -std::abs(px) * e[i].x,
+                        py * c[i].y, -std::abs(py) * e[i].y,
+                        pz * c[i].z, -std::abs(pz) * e[i].z,
+                        double(planes[j].w) };
+                double d = 0, scale = 0;
+                for (double t : terms) { d += t; scale += std::abs(t); }
+                boundary = isBoundary(d, scale);
+            }
+            EXPECT_TRUE(boundary) << name << ": box " << i
+                    << " simd=" << int(simd[i]) << " scalar=" << int(scalar[i]);
+        }
+    };
+
+    auto checkSpheres = [&](Frustum const& frustum, const char* name,
+            std::vector<float4> const& b) {
+        const size_t count = b.size();
+        std::vector<Culler::result_type> simd(count, 0);
+        std::vector<Culler::result_type> scalar(count, 0);
+        Culler::Test::intersects(simd.data(), frustum, b.data(), count);
+        Culler::Test::intersectsScalar(scalar.data(), frustum, b.data(), count);
+        float4 const* const planes = frustum.getNormalizedPlanes();
+        for (size_t i = 0; i < count; i++) {
+            if (simd[i] == scalar[i]) continue;
+            bool boundary = false;
+            for (size_t j = 0; j < 6 && !boundary; j++) {
+                const double terms[5] = {
+                        double(planes[j].x) * b[i].x, double(planes[j].y) * b[i].y,
+                        double(planes[j].z) * b[i].z, double(planes[j].w),
+                        -double(b[i].w) };
+                double d = 0, scale = 0;
+                for (double t : terms) { d += t; scale += std::abs(t); }
+                boundary = isBoundary(d, scale);
+            }
+            EXPECT_TRUE(boundary) << name << ": sphere " << i
+                    << " simd=" << int(simd[i]) << " scalar=" << int(scalar[i]);
+        }
+    };
+
+    const Frustum frustums[3] = {
+            Frustum(mat4f::perspective(45.0f, 1.0f, 0.1f, 100.0f)),
+            Frustum(mat4f::perspective(120.0f, 1.78f, 0.01f, 10000.0f)),
+            Frustum(mat4f::ortho(-50, 50, -50, 50, 0, 100)),
+    };
+
+    constexpr size_t N = 1024;  // already a multiple of Culler::MODULO
+    std::mt19937 gen(1207);
+    auto frand = [&gen](float lo, float hi) {
+        return std::uniform_real_distribution<float>(lo, hi)(gen);
+    };
+
+    // adversarial bound distributions; all batches are MODULO-sized
+    std::vector<float3> centers(N), extents(N);
+    std::vector<float4> spheres(N);
+
+    // plausible scene content
+    for (size_t i = 0; i < N; i++) {
+        centers[i] = { frand(-200, 200), frand(-200, 200), frand(-200, 200) };
+        extents[i] = { frand(0.1f, 10), frand(0.1f, 10), frand(0.1f, 10) };
+        spheres[i] = { centers[i], frand(0.1f, 10) };
+    }
+    for (Frustum const& f : frustums) {
+        checkBoxes(f, "uniform", centers, extents);
+        checkSpheres(f, "uniform", spheres);
+    }
+
+    // degenerate bounds: points and flat boxes (zero extent on some or all axes)
+    for (size_t i = 0; i < N; i++) {
+        centers[i] = { frand(-120, 120), frand(-120, 120), frand(-120, 120) };
+        extents[i] = { (i % 2) ? 0.0f : frand(0, 5), (i % 3) ? 0.0f : frand(0, 5), 0.0f };
+        spheres[i] = { centers[i], 0.0f };
+    }
+    for (Frustum const& f : frustums) {
+        checkBoxes(f, "degenerate", centers, extents);
+        checkSpheres(f, "degenerate", spheres);
+    }
+
+    // huge coordinates, including bounds that dwarf the frustum
+    for (size_t i = 0; i < N; i++) {
+        centers[i] = { frand(-1, 1) * 1e30f, frand(-1, 1) * 1e30f, frand(-1, 1) * 1e30f };
+        extents[i] = { frand(0, 1) * 1e30f, frand(0, 1) * 1e18f, frand(0, 1) };
+        spheres[i] = { centers[i], frand(0, 1) * 1e30f };
+    }
+    for (Frustum const& f : frustums) {
+        checkBoxes(f, "huge", centers, extents);
+        checkSpheres(f, "huge", spheres);
+    }
+
+    // denormals: magnitudes below FLT_MIN must not trap, flush inconsistently
+    // between the paths, or produce garbage visibility
+    const float denorm = std::numeric_limits<float>::denorm_min();
+    for (size_t i = 0; i < N; i++) {
+        const float s = denorm * float(1 + (i % 1000));
+        centers[i] = { frand(-1, 1) * s, frand(-1, 1) * s, frand(-1, 1) * s };
+        extents[i] = { frand(0, 1) * s, frand(0, 1) * s, frand(0, 1) * s };
+        spheres[i] = { centers[i], frand(0, 1) * s };
+    }
+    for (Frustum const& f : frustums) {
+        checkBoxes(f, "denormal", centers, extents);
+        checkSpheres(f, "denormal", spheres);
+    }
+}
+
+TEST(FilamentTest, OcclusionBuffer) {
+    using filament::details::OcclusionBuffer;
+
+    // camera at the origin looking down -z
+    const mat4f viewProjection = mat4f::frustum(-1, 1, -1, 1, 1, 100);
+
+    utils::JobSystem js;
+    js.adopt();
+
+    OcclusionBuffer buffer;
+
+    // a large quad at z = -10 spanning [-5, 5]^2, i.e. the center quarter of the screen
+    const float3 vertices[4] = {
+            { -5, -5, -10 }, { 5, -5, -10 }, { 5, 5, -10 }, { -5, 5, -10 }
+    };
+    const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    // with no occluders, nothing is culled
+    buffer.rasterize(js, viewProjection, vertices, indices, 0);
+    EXPECT_FALSE(buffer.isOccluded({ 0, 0, -50 }, { 1, 1, 1 }));
+
+    buffer.rasterize(js, viewProjection, vertices, indices, 6);
+
+    // box behind the occluder, well inside its projection
+    EXPECT_TRUE(buffer.isOccluded({ 0, 0, -50 }, { 1, 1, 1 }));
+
+    // box in front of the occluder
+    EXPECT_FALSE(buffer.isOccluded({ 0, 0, -5 }, { 1, 1, 1 }));
+
+    // box behind the occluder's plane but outside its projection
+    EXPECT_FALSE(buffer.isOccluded({ 30, 0, -50 }, { 1, 1, 1 }));
+
+    // box sticking out of the occluder's projection
+    EXPECT_FALSE(buffer.isOccluded({ 0, 0, -50 }, { 40, 1, 1 }));
+
+    // box crossing the near plane is never culled
+    EXPECT_FALSE(buffer.isOccluded({ 0, 0, 0 }, { 1, 1, 1 }));
+
+    // visibility bits: only hidden boxes get their bit cleared, other bits are preserved
+    const float3 centers[3] = { { 0, 0, -50 }, { 0, 0, -5 }, { 30, 0, -50 } };
+    const float3 extents[3] = { { 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 } };
+    uint8_t visible[3] = { 0x3, 0x3, 0x2 };
+    buffer.cullOccluded(visible, centers, extents, 3, 0);
+    EXPECT_EQ(0x2, visible[0]);     // occluded, bit 0 cleared
+    EXPECT_EQ(0x3, visible[1]);     // in front, untouched
+    EXPECT_EQ(0x2, visible[2]);     // bit 0 wasn't set, untouched
+
+    js.emancipate();
+}
+
 TEST(FilamentTest, ColorConversion) {
     // Linear to Gamma
     // 0.0 stays 0.0
@@ -806,6 +1195,71 @@ TEST(FilamentTest, RangeSet) {
     EXPECT_EQ(250, b[2].end);
 }
 
+TEST(FilamentTest, ShadowAtlas) {
+    using details::ShadowAtlas;
+
+    // 512 / 256 = a 2x2 atlas, 4 tiles
+    ShadowAtlas atlas(512, 256);
+    EXPECT_EQ(4, atlas.getTileCount());
+    EXPECT_EQ(0, atlas.getAllocatedCount());
+
+    atlas.beginFrame();
+
+    // tiles are distinct and keep a 1-texel border
+    ShadowAtlas::Tile const* t0 = atlas.acquire(100, 1.0f, 0xaa);
+    ShadowAtlas::Tile const* t1 = atlas.acquire(101, 0.5f, 0xbb);
+    ASSERT_TRUE(t0 && t1);
+    EXPECT_TRUE(t0->needsRendering);
+    EXPECT_TRUE(t1->needsRendering);
+    EXPECT_EQ(254, t0->viewport.width);
+    EXPECT_FALSE(t0->viewport.left == t1->viewport.left
+            && t0->viewport.bottom == t1->viewport.bottom);
+
+    // same light, same content: same tile, no re-render
+    atlas.beginFrame();
+    ShadowAtlas::Tile const* t = atlas.acquire(100, 1.0f, 0xaa);
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t0, t);
+    EXPECT_FALSE(t->needsRendering);
+
+    // content changed: same tile, re-render
+    atlas.beginFrame();
+    t = atlas.acquire(100, 1.0f, 0xab);
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t0, t);
+    EXPECT_TRUE(t->needsRendering);
+
+    // fill the atlas
+    atlas.acquire(101, 0.5f, 0xbb);
+    atlas.acquire(102, 0.4f, 0xcc);
+    atlas.acquire(103, 0.3f, 0xdd);
+    EXPECT_EQ(4, atlas.getAllocatedCount());
+
+    // all tiles are used this frame, a 5th light can't get one
+    EXPECT_EQ(nullptr, atlas.acquire(104, 9.0f, 0xee));
+
+    // next frame, a less important light can't evict active lights...
+    atlas.beginFrame();
+    atlas.acquire(100, 1.0f, 0xab);
+    atlas.acquire(101, 0.5f, 0xbb);
+    atlas.acquire(102, 0.4f, 0xcc);
+    EXPECT_EQ(nullptr, atlas.acquire(104, 0.1f, 0xee));
+
+    // ... but a more important one evicts the least important (103)
+    t = atlas.acquire(105, 2.0f, 0xff);
+    ASSERT_TRUE(t);
+    EXPECT_TRUE(t->needsRendering);
+    EXPECT_EQ(4, atlas.getAllocatedCount());
+
+    // the evicted light gets a tile back next frame (105 is idle by then) and must
+    // re-render even with its old content hash
+    atlas.beginFrame();
+    atlas.beginFrame();
+    t = atlas.acquire(103, 0.3f, 0xdd);
+    ASSERT_TRUE(t);
+    EXPECT_TRUE(t->needsRendering);
+}
+
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -24,13 +24,17 @@ namespace filament {
 // Update hasIntegerTarget() in VertexBuffer when adding an attribute that will
 // be read as integers in the shaders
 enum VertexAttribute : uint8_t {
-    POSITION        = 0, // XYZ position (float3)
-    TANGENTS        = 1, // tangent, bitangent and normal, encoded as a quaternion (float4)
-    COLOR           = 2, // vertex color (float4)
-    UV0             = 3, // texture coordinates (float2)
-    UV1             = 4, // texture coordinates (float2)
-    BONE_INDICES    = 5, // indices of 4 bones, as unsigned integers (uvec4)
-    BONE_WEIGHTS    = 6, // weights of the 4 bones (normalized float4)
+    POSITION          = 0, // XYZ position (float3)
+    TANGENTS          = 1, // tangent, bitangent and normal, encoded as a quaternion (float4)
+    COLOR             = 2, // vertex color (float4)
+    UV0               = 3, // texture coordinates (float2)
+    UV1               = 4, // texture coordinates (float2)
+    BONE_INDICES      = 5, // indices of 4 bones, as unsigned integers (uvec4)
+    BONE_WEIGHTS      = 6, // weights of the 4 bones (normalized float4)
+    MORPH_POSITION_0  = 7, // morph target 0 position delta (float3)
+    MORPH_POSITION_1  = 8, // morph target 1 position delta (float3)
+    MORPH_POSITION_2  = 9, // morph target 2 position delta (float3)
+    MORPH_POSITION_3  = 10,// morph target 3 position delta (float3)
 };
 
 // Binding points for uniform buffers and sampler buffers.
@@ -49,8 +53,12 @@ namespace BindingPoints {
 static_assert(BindingPoints::PER_MATERIAL_INSTANCE == BindingPoints::COUNT - 1,
         "Dynamically sized sampler buffer must be the last binding point.");
 
-constexpr uint32_t ATTRIBUTE_INDEX_COUNT = 7;
-constexpr size_t MAX_ATTRIBUTE_BUFFERS_COUNT = 8; // FIXME: should match Driver::MAX_ATTRIBUTE_BUFFER_COUNT
+constexpr uint32_t ATTRIBUTE_INDEX_COUNT = 11;
+constexpr size_t MAX_ATTRIBUTE_BUFFERS_COUNT = 12; // FIXME: should match Driver::MAX_ATTRIBUTE_BUFFER_COUNT
+
+// number of morph targets that can be blended at once; limited by the number of
+// MORPH_POSITION_* attributes and the size of morphWeights in PerRenderableUib
+constexpr size_t CONFIG_MAX_MORPH_TARGET_COUNT = 4;
 
 // This value is limited by UBO size, ES3.0 only guarantees 16 KiB.
 // Values <= 256, use less CPU and GPU resources.
@@ -84,12 +84,16 @@ namespace filament {
         // when adding more entries, make sure to update VERTEX_DOMAIN_COUNT
     };
 
-    static constexpr size_t POST_PROCESS_STAGES_COUNT = 4;
+    static constexpr size_t POST_PROCESS_STAGES_COUNT = 8;
     enum class PostProcessStage : uint8_t {
         TONE_MAPPING_OPAQUE,           // Tone mapping post-process
         TONE_MAPPING_TRANSLUCENT,      // Tone mapping post-process
         ANTI_ALIASING_OPAQUE,          // Anti-aliasing stage
         ANTI_ALIASING_TRANSLUCENT,     // Anti-aliasing stage
+        TRANSPARENCY_UPSAMPLE,         // Half-resolution transparency composite
+        LUMINANCE_DOWNSAMPLE,          // Log-luminance of the color buffer (auto-exposure)
+        LUMINANCE_ADAPTATION,          // Temporal adaptation of the average luminance
+        SHADOW_PREFILTER,              // EVSM moments from the shadow map depth (soft shadows)
     };
 
     static constexpr size_t MATERIAL_VARIABLES_COUNT = 4;
@@ -19,6 +19,7 @@
 
 #include <filament/EngineEnums.h>
 
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
 
@@ -47,6 +48,10 @@ class SamplerInterfaceBlock;
 // Also stores the mapping as a flat vector of 4-tuples to make it easy to [de]serialize.
 class SamplerBindingMap {
 public:
+    SamplerBindingMap() {
+        std::fill_n(mSamplerBlockOffsets, filament::BindingPoints::COUNT, UNKNOWN_OFFSET);
+    }
+
     // Assigns a range of finalized binding points to each sampler block. If a per-material SIB
     // is provided, then material samplers are also inserted (always at the end).
     void populate(SamplerInterfaceBlock* perMaterialSib = nullptr);
@@ -66,7 +71,8 @@ public:
         return true;
     }
 
-    // Adds the given sampler to the mapping. Useful for deserialization.
+    // Adds the given sampler to the mapping and updates the per-block offset table.
+    // Useful for deserialization.
     void addSampler(SamplerBindingInfo info);
 
     // Retrieves all samplers as a flat list. Useful for serialization.
@@ -88,7 +94,7 @@ private:
     }
     std::vector<SamplerBindingInfo> mBindingList;
     std::unordered_map<BindingKey, SamplerBindingInfo> mBindingMap;
-    uint8_t mSamplerBlockOffsets[filament::BindingPoints::COUNT] = { UNKNOWN_OFFSET };
+    uint8_t mSamplerBlockOffsets[filament::BindingPoints::COUNT];
 };
 
 
@@ -50,6 +50,13 @@ public:
         // Add a uniform
         Builder& add(const std::string& uniformName, size_t size,
                 Type type, Precision precision = Precision::DEFAULT);
+        // Reorder the uniforms added so far from largest to smallest base alignment
+        // (stable, so declaration order is preserved within each alignment class).
+        // This minimizes std140 padding and packs the scalar parameters -- typically
+        // the ones animated per frame -- into contiguous bytes, which keeps their
+        // dirty ranges small (see UniformBuffer). Must not be used on blocks that
+        // mirror a C++ struct, since it changes the offsets.
+        Builder& pack();
         // build and return the UniformInterfaceBlock
         UniformInterfaceBlock build();
     private:
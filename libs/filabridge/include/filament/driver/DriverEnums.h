@@ -53,6 +53,13 @@ enum TargetBufferFlags : uint8_t {
     DEPTH = 0x2,                //!< Depth buffer selected.
     STENCIL = 0x4,              //!< Stencil buffer selected.
     SHADOW = DEPTH | 0x8,
+    /**
+     * Resolve MSAA in-tile into a single-sample color attachment (e.g. via
+     * EXT_multisampled_render_to_texture), so the multi-sampled data never reaches
+     * main memory and no separate resolve pass is needed. Check
+     * isInTileResolveSupported() before requesting this.
+     */
+    RESOLVE_IN_TILE = 0x10,
     COLOR_AND_DEPTH = COLOR | DEPTH,
     COLOR_AND_STENCIL = COLOR | STENCIL,
     DEPTH_AND_STENCIL = DEPTH | STENCIL,
@@ -152,6 +159,7 @@ enum class Precision : uint8_t {
 //! Texture sampler type
 enum class SamplerType : uint8_t {
     SAMPLER_2D,         //!< 2D texture
+    SAMPLER_2D_ARRAY,   //!< 2D array texture
     SAMPLER_CUBEMAP,    //!< Cube map texture
     SAMPLER_EXTERNAL,   //!< External texture
 };
@@ -194,8 +202,10 @@ enum class ElementType : uint8_t {
 };
 
 enum class Usage : uint8_t {
-    STATIC,
-    DYNAMIC
+    STATIC,     //!< content is specified once and drawn many times
+    DYNAMIC,    //!< content is updated occasionally
+    STREAM      //!< content is re-specified every frame (e.g. UI geometry);
+                //!< drivers may multi-buffer the storage to avoid stalls
 };
 
 enum class CullingMode : uint8_t {
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILABRIDGE_UIBSTRUCTS_H
+#define TNT_FILABRIDGE_UIBSTRUCTS_H
+
+#include <filament/EngineEnums.h>
+
+#include <math/mat3.h>
+#include <math/mat4.h>
+#include <math/vec2.h>
+#include <math/vec4.h>
+
+#include <stdint.h>
+
+/*
+ * C++ mirrors of the engine-owned uniform interface blocks, the single source of
+ * truth for their std140 layouts. The engine writes uniforms with
+ * offsetof(PerViewUib, field) -- a direct store, no name lookup -- and the shader
+ * generator declares the matching GLSL blocks from UibGenerator, whose definitions
+ * are validated field by field against these structs (see UibGenerator.cpp).
+ *
+ * IMPORTANT: respect the std140 layout; don't update one of these structs without
+ * updating the corresponding block in UibGenerator.cpp.
+ */
+
+namespace filament {
+
+class UniformInterfaceBlock;
+
+struct PerViewUib {
+    static UniformInterfaceBlock getUib() noexcept;
+    math::mat4f viewFromWorldMatrix;
+    math::mat4f worldFromViewMatrix;
+    math::mat4f clipFromViewMatrix;
+    math::mat4f viewFromClipMatrix;
+    math::mat4f clipFromWorldMatrix;
+    math::mat4f lightFromWorldMatrix;
+
+    math::float4 resolution; // width, height, 1/width, 1/height
+
+    math::float3 cameraPosition;
+    float time; // time in seconds, with a 1 second period
+
+    math::float4 lightColorIntensity; // directional light
+
+    math::float4 sun; // cos(sunAngle), sin(sunAngle), 1/(sunAngle*HALO_SIZE-sunAngle), HALO_EXP
+
+    math::float3 lightDirection;
+    uint32_t fParamsX; // stride-x
+
+    math::float3 shadowBias; // constant bias, normal bias, unused
+    float oneOverFroxelDimensionY;
+
+    math::float4 zParams; // froxel Z parameters
+
+    math::uint2 fParams; // stride-y, stride-z
+    math::float2 origin; // viewport left, viewport bottom
+
+    float oneOverFroxelDimensionX;
+    float iblLuminance;
+    float exposure;
+    float ev100;
+
+    alignas(16) math::float4 iblSH[9]; // actually float3 entries (std140 requires float4 alignment)
+
+    // crossfade factor between iblSpecular and iblSpecularBlend (0 = iblSpecular only)
+    float iblBlend;
+    float padding0[3];
+
+    // world-space box the reflections were captured in (see setProbeVolume());
+    // centers' w is 0 when the environment is at infinity
+    math::float4 iblProbeCenter;        // xyz, w = 1.0 when a probe volume is set
+    math::float4 iblProbeHalfExtent;    // xyz, w unused
+
+    // soft shadows (EVSM): x = enabled (0/1), y = max penumbra mip lod, z/w unused
+    math::float4 vsmParams;
+
+    // froxel z-slice distribution curve (see Froxelizer::setDepthDistribution):
+    // x = 1/power, y = 1/(sliceCount-1), z = sliceCount-1, w = unused
+    math::float4 froxelCurve;
+};
+
+struct PerRenderableUib {
+    static UniformInterfaceBlock getUib() noexcept;
+    math::mat4f worldFromModelMatrix;
+    math::mat3f worldFromModelNormalMatrix;
+    float padding0[3];          // a mat3 occupies 3 float4 in the std140 layout
+    math::float4 morphWeights;
+    // dequantization of quantized POSITION attributes (see setQuantizedPositionTransform())
+    math::float4 posUnpackScale;
+    math::float4 posUnpackOffset;
+};
+
+struct LightsUib {
+    static UniformInterfaceBlock getUib() noexcept;
+    // one mat4-sized record per light, see FScene::prepareDynamicLights()
+    math::mat4f lights[CONFIG_MAX_LIGHT_COUNT];
+};
+
+struct PostProcessingUib {
+    static UniformInterfaceBlock getUib() noexcept;
+    math::float2 uvScale;
+    float time;             // time in seconds, with a 1 second period, used for dithering
+    float yOffset;
+    math::float4 lutInfo;   // tone-mapping LUT: enabled, size, 1 / encoded domain max
+    // auto-exposure: enabled, adaptation factor, pyramid top lod, middle-grey key
+    math::float4 exposureInfo;
+};
+
+struct PerRenderableBonesUib {
+    static UniformInterfaceBlock getUib() noexcept;
+    // two float4 per bone (see FRenderableManager::setBones())
+    math::float4 bones[CONFIG_MAX_BONE_COUNT * 2];
+};
+
+// std140 rounds every block up to a float4 boundary
+static_assert(sizeof(PerViewUib) % 16 == 0, "PerViewUib should be a multiple of 16 bytes");
+static_assert(sizeof(PerRenderableUib) % 16 == 0, "PerRenderableUib should be a multiple of 16 bytes");
+static_assert(sizeof(PostProcessingUib) % 16 == 0, "PostProcessingUib should be a multiple of 16 bytes");
+
+} // namespace filament
+
+#endif // TNT_FILABRIDGE_UIBSTRUCTS_H
@@ -31,6 +31,10 @@ SamplerInterfaceBlock& SibGenerator::getPerViewSib() noexcept {
             .add("froxels",       Type::SAMPLER_2D,      Format::UINT,  Precision::MEDIUM)
             .add("iblDFG",        Type::SAMPLER_2D,      Format::FLOAT, Precision::MEDIUM)
             .add("iblSpecular",   Type::SAMPLER_CUBEMAP, Format::FLOAT, Precision::MEDIUM)
+            .add("iblSpecularBlend", Type::SAMPLER_CUBEMAP, Format::FLOAT, Precision::MEDIUM)
+            // prefiltered EVSM moments of the shadow map, used instead of shadowMap when
+            // soft shadows are enabled (see shadowVsm() in shadowing.fs)
+            .add("shadowVsm",     Type::SAMPLER_2D,      Format::FLOAT, Precision::MEDIUM)
             .build();
     return sib;
 }
@@ -42,6 +46,10 @@ SamplerInterfaceBlock& SibGenerator::getPostProcessSib() noexcept {
     static SamplerInterfaceBlock sib = SamplerInterfaceBlock::Builder()
             .name("PostProcess")
             .add("colorBuffer", Type::SAMPLER_2D, Format::FLOAT, Precision::MEDIUM, false)
+            // 3D tone-mapping LUT flattened into a 2D texture (slices along x)
+            .add("colorGradingLut", Type::SAMPLER_2D, Format::FLOAT, Precision::MEDIUM, false)
+            // 1x1 adapted average log-luminance (auto-exposure)
+            .add("luminance", Type::SAMPLER_2D, Format::FLOAT, Precision::MEDIUM, false)
             .build();
     return sib;
 }
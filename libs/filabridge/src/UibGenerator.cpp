@@ -15,15 +15,39 @@
  */
 
 #include "private/filament/UibGenerator.h"
+#include "private/filament/UibStructs.h"
 
 #include "filament/EngineEnums.h"
 #include "filament/driver/DriverEnums.h"
 
+#include <utils/compiler.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <initializer_list>
+#include <utility>
+
 namespace filament {
     using namespace driver;
 
+#ifndef NDEBUG
+// Checks, once per block, that the runtime-built layout matches the C++ mirror struct
+// the engine writes through (see UibStructs.h) -- field by field, via the offsetof()
+// tables below. This keeps the per-frame writers free of any lookup or validation.
+static bool validateUib(UniformInterfaceBlock const& uib, size_t structSize,
+        std::initializer_list<std::pair<const char*, size_t>> fields) noexcept {
+    assert(uib.getSize() == structSize);
+    for (auto const& field : fields) {
+        assert(uib.getUniformOffset(field.first, 0) == ssize_t(field.second));
+    }
+    return true;
+}
+#endif
+
 UniformInterfaceBlock& UibGenerator::getPerViewUib() noexcept  {
-    // IMPORTANT NOTE: Respect std140 layout, don't update without updating Engine::PerViewUib
+    // IMPORTANT NOTE: Respect std140 layout, don't update without updating PerViewUib
+    // in UibStructs.h (the offsets are validated against it below)
     static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
             .name("FrameUniforms")
             // transforms
@@ -60,43 +84,144 @@ UniformInterfaceBlock& UibGenerator::getPerViewUib() noexcept  {
             .add("ev100",                   1, UniformInterfaceBlock::Type::FLOAT)
             // ibl
             .add("iblSH",                   9, UniformInterfaceBlock::Type::FLOAT3)
+            // ibl crossfade
+            .add("iblBlend",                1, UniformInterfaceBlock::Type::FLOAT)
+            // ibl probe volume for parallax-corrected reflections
+            .add("iblProbeCenter",          1, UniformInterfaceBlock::Type::FLOAT4)
+            .add("iblProbeHalfExtent",      1, UniformInterfaceBlock::Type::FLOAT4)
+            // soft shadows (EVSM): x = enabled (0/1), y = max penumbra mip lod, z/w unused
+            .add("vsmParams",               1, UniformInterfaceBlock::Type::FLOAT4)
+            // froxel z-slice distribution curve: x = 1/power, y = 1/(sliceCount-1),
+            // z = sliceCount-1, w = unused
+            .add("froxelCurve",             1, UniformInterfaceBlock::Type::FLOAT4)
             .build();
+#ifndef NDEBUG
+    UTILS_UNUSED static const bool ok = validateUib(uib, sizeof(PerViewUib), {
+            { "viewFromWorldMatrix",     offsetof(PerViewUib, viewFromWorldMatrix) },
+            { "worldFromViewMatrix",     offsetof(PerViewUib, worldFromViewMatrix) },
+            { "clipFromViewMatrix",      offsetof(PerViewUib, clipFromViewMatrix) },
+            { "viewFromClipMatrix",      offsetof(PerViewUib, viewFromClipMatrix) },
+            { "clipFromWorldMatrix",     offsetof(PerViewUib, clipFromWorldMatrix) },
+            { "lightFromWorldMatrix",    offsetof(PerViewUib, lightFromWorldMatrix) },
+            { "resolution",              offsetof(PerViewUib, resolution) },
+            { "cameraPosition",          offsetof(PerViewUib, cameraPosition) },
+            { "time",                    offsetof(PerViewUib, time) },
+            { "lightColorIntensity",     offsetof(PerViewUib, lightColorIntensity) },
+            { "sun",                     offsetof(PerViewUib, sun) },
+            { "lightDirection",          offsetof(PerViewUib, lightDirection) },
+            { "fParamsX",                offsetof(PerViewUib, fParamsX) },
+            { "shadowBias",              offsetof(PerViewUib, shadowBias) },
+            { "oneOverFroxelDimensionY", offsetof(PerViewUib, oneOverFroxelDimensionY) },
+            { "zParams",                 offsetof(PerViewUib, zParams) },
+            { "fParams",                 offsetof(PerViewUib, fParams) },
+            { "origin",                  offsetof(PerViewUib, origin) },
+            { "oneOverFroxelDimension",  offsetof(PerViewUib, oneOverFroxelDimensionX) },
+            { "iblLuminance",            offsetof(PerViewUib, iblLuminance) },
+            { "exposure",                offsetof(PerViewUib, exposure) },
+            { "ev100",                   offsetof(PerViewUib, ev100) },
+            { "iblSH",                   offsetof(PerViewUib, iblSH) },
+            { "iblBlend",                offsetof(PerViewUib, iblBlend) },
+            { "iblProbeCenter",          offsetof(PerViewUib, iblProbeCenter) },
+            { "iblProbeHalfExtent",      offsetof(PerViewUib, iblProbeHalfExtent) },
+            { "vsmParams",               offsetof(PerViewUib, vsmParams) },
+            { "froxelCurve",             offsetof(PerViewUib, froxelCurve) },
+    });
+#endif
     return uib;
 }
 
+UniformInterfaceBlock PerViewUib::getUib() noexcept {
+    return UibGenerator::getPerViewUib();
+}
+
 UniformInterfaceBlock& UibGenerator::getPerRenderableUib() noexcept {
     static UniformInterfaceBlock uib =  UniformInterfaceBlock::Builder()
             .name("ObjectUniforms")
             .add("worldFromModelMatrix",       1, UniformInterfaceBlock::Type::MAT4, Precision::HIGH)
             .add("worldFromModelNormalMatrix", 1, UniformInterfaceBlock::Type::MAT3, Precision::HIGH)
+            // blend weights of the MORPH_POSITION_* vertex attributes
+            .add("morphWeights",               1, UniformInterfaceBlock::Type::FLOAT4, Precision::MEDIUM)
+            // dequantization of the POSITION attribute: model position = attribute * scale + offset.
+            // identity for unquantized (float/half) positions.
+            .add("posUnpackScale",             1, UniformInterfaceBlock::Type::FLOAT4, Precision::HIGH)
+            .add("posUnpackOffset",            1, UniformInterfaceBlock::Type::FLOAT4, Precision::HIGH)
             .build();
+#ifndef NDEBUG
+    UTILS_UNUSED static const bool ok = validateUib(uib, sizeof(PerRenderableUib), {
+            { "worldFromModelMatrix",       offsetof(PerRenderableUib, worldFromModelMatrix) },
+            { "worldFromModelNormalMatrix", offsetof(PerRenderableUib, worldFromModelNormalMatrix) },
+            { "morphWeights",               offsetof(PerRenderableUib, morphWeights) },
+            { "posUnpackScale",             offsetof(PerRenderableUib, posUnpackScale) },
+            { "posUnpackOffset",            offsetof(PerRenderableUib, posUnpackOffset) },
+    });
+#endif
     return uib;
 }
 
+UniformInterfaceBlock PerRenderableUib::getUib() noexcept {
+    return UibGenerator::getPerRenderableUib();
+}
+
 UniformInterfaceBlock& UibGenerator::getLightsUib() noexcept {
     static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
             .name("LightsUniforms")
             .add("lights", CONFIG_MAX_LIGHT_COUNT, UniformInterfaceBlock::Type::MAT4, Precision::HIGH)
             .build();
+#ifndef NDEBUG
+    UTILS_UNUSED static const bool ok = validateUib(uib, sizeof(LightsUib), {
+            { "lights", offsetof(LightsUib, lights) },
+    });
+#endif
     return uib;
 }
 
+UniformInterfaceBlock LightsUib::getUib() noexcept {
+    return UibGenerator::getLightsUib();
+}
+
 UniformInterfaceBlock& UibGenerator::getPostProcessingUib() noexcept {
     static UniformInterfaceBlock uib =  UniformInterfaceBlock::Builder()
             .name("PostProcessUniforms")
             .add("uvScale", 1, UniformInterfaceBlock::Type::FLOAT2)
             .add("time",    1, UniformInterfaceBlock::Type::FLOAT)
             .add("yOffset", 1, UniformInterfaceBlock::Type::FLOAT)
+            // tone-mapping LUT: x = enabled (0/1), y = LUT size, z = 1 / encoded domain max
+            .add("lutInfo", 1, UniformInterfaceBlock::Type::FLOAT4)
+            // auto-exposure: x = enabled (0/1), y = adaptation factor,
+            // z = top lod of the luminance pyramid, w = middle-grey key
+            .add("exposureInfo", 1, UniformInterfaceBlock::Type::FLOAT4)
             .build();
+#ifndef NDEBUG
+    UTILS_UNUSED static const bool ok = validateUib(uib, sizeof(PostProcessingUib), {
+            { "uvScale",      offsetof(PostProcessingUib, uvScale) },
+            { "time",         offsetof(PostProcessingUib, time) },
+            { "yOffset",      offsetof(PostProcessingUib, yOffset) },
+            { "lutInfo",      offsetof(PostProcessingUib, lutInfo) },
+            { "exposureInfo", offsetof(PostProcessingUib, exposureInfo) },
+    });
+#endif
     return uib;
 }
 
+UniformInterfaceBlock PostProcessingUib::getUib() noexcept {
+    return UibGenerator::getPostProcessingUib();
+}
+
 UniformInterfaceBlock& UibGenerator::getPerRenderableBonesUib() noexcept {
     static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
             .name("BonesUniforms")
             .add("bones", CONFIG_MAX_BONE_COUNT * 2, UniformInterfaceBlock::Type::FLOAT4, Precision::MEDIUM)
             .build();
+#ifndef NDEBUG
+    UTILS_UNUSED static const bool ok = validateUib(uib, sizeof(PerRenderableBonesUib), {
+            { "bones", offsetof(PerRenderableBonesUib, bones) },
+    });
+#endif
     return uib;
 }
 
+UniformInterfaceBlock PerRenderableBonesUib::getUib() noexcept {
+    return UibGenerator::getPerRenderableBonesUib();
+}
+
 } // namespace filament
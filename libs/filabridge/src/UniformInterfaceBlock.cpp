@@ -19,6 +19,7 @@
 #include <utils/Panic.h>
 #include <utils/compiler.h>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 
@@ -38,6 +39,22 @@ UniformInterfaceBlock::Builder& UniformInterfaceBlock::Builder::add(
     return *this;
 }
 
+UniformInterfaceBlock::Builder& UniformInterfaceBlock::Builder::pack() {
+    // same effective alignment the layout code below uses
+    auto alignmentOf = [](Entry const& e) -> size_t {
+        size_t alignment = baseAlignmentForType(e.type);
+        if (e.size > 1) { // arrays are rounded up to the alignment of a double4
+            alignment = (alignment + 3) & ~3;
+        }
+        return alignment;
+    };
+    std::stable_sort(mEntries.begin(), mEntries.end(),
+            [&alignmentOf](Entry const& lhs, Entry const& rhs) {
+                return alignmentOf(lhs) > alignmentOf(rhs);
+            });
+    return *this;
+}
+
 UniformInterfaceBlock UniformInterfaceBlock::Builder::build() {
     return UniformInterfaceBlock(*this);
 }
@@ -33,7 +33,9 @@ class UTILS_PUBLIC ChunkContainer {
     using Type = filamat::ChunkType;
 
 public:
-    ChunkContainer(void* data, size_t size) : mData(data), mSize(size) {}
+    // the data is not copied, the caller must keep it alive (and unchanged) for the
+    // lifetime of this object -- it can be a read-only memory-mapped region
+    ChunkContainer(const void* data, size_t size) : mData(data), mSize(size) {}
 
     ~ChunkContainer() = default;
 
@@ -80,7 +82,7 @@ public:
 private:
     bool parseChunk(Unflattener& unflattener);
 
-    void* mData;
+    const void* mData;
     size_t mSize;
     tsl::robin_map<filamat::ChunkType, ChunkContainer::ChunkDesc> mChunks;
 };
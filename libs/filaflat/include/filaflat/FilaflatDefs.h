@@ -80,6 +80,7 @@ enum UTILS_PUBLIC ChunkType : uint64_t {
 
     MaterialVertexDomain =charTo64bitNum("MAT_VEDO"),
     MaterialInterpolation= charTo64bitNum("MAT_INTR"),
+    MaterialSupportedVariants = charTo64bitNum("MAT_SVAR"),
 
     PostProcessVersion = charTo64bitNum("POSP_VER"),
 
@@ -42,7 +42,13 @@ struct MaterialParserDetails;
 
 class UTILS_PUBLIC MaterialParser {
 public:
-    MaterialParser(filament::driver::Backend backend, const void* data, size_t size);
+    // By default the package is copied. When 'copy' is false the caller keeps ownership of
+    // 'data' (e.g. a memory-mapped file or a compiled-in package) and must keep it alive and
+    // unchanged for the lifetime of this parser; chunk payloads, dictionary entries and
+    // shader text are then served as views into the caller's region, so only the shader
+    // variants actually requested through getShader() are ever touched (and paged in).
+    MaterialParser(filament::driver::Backend backend, const void* data, size_t size,
+            bool copy = true);
     ~MaterialParser();
 
     MaterialParser(MaterialParser const& rhs) noexcept = delete;
@@ -77,6 +83,13 @@ public:
     bool getRequiredAttributes(filament::AttributeBitset*) const noexcept;
     bool hasCustomDepthShader(bool* value) const noexcept;
 
+    // bitmask over variant keys of the variants whose shaders are present in the package
+    // (see Variant); absent from packages compiled before variant pruning was introduced
+    bool getSupportedVariants(uint32_t* value) const noexcept;
+
+    // Thread-safe: after parse() succeeded, the const accessors only read chunk data and
+    // getShader() serializes its lazily built shader index and dictionary internally, so a
+    // single parser may be shared by several engines (see FMaterial).
     bool getShader(
             filament::driver::ShaderModel shaderModel, uint8_t variant,
             filament::driver::ShaderType st,
@@ -36,8 +36,8 @@ bool ChunkContainer::parseChunk(Unflattener& unflattener) {
     // If size goes beyond the boundaries of the package, this is an invalid chunk. Discard it.
     // All remaining chunks cannot be accessed and will not be mapped.
     auto cursor = unflattener.getCursor();
-    if (!(cursor + size >= (uint8_t *)mData &&
-          cursor + size <= (uint8_t *)mData + mSize)) {
+    if (!(cursor + size >= (const uint8_t *)mData &&
+          cursor + size <= (const uint8_t *)mData + mSize)) {
         return false;
     }
 
@@ -47,7 +47,7 @@ bool ChunkContainer::parseChunk(Unflattener& unflattener) {
 }
 
 bool ChunkContainer::parse() noexcept {
-    Unflattener unflattener((uint8_t *)mData, (uint8_t *)mData + mSize);
+    Unflattener unflattener((const uint8_t *)mData, (const uint8_t *)mData + mSize);
     do {
         if (!parseChunk(unflattener)) {
             return false;
@@ -24,6 +24,53 @@ using namespace filament::driver;
 namespace filaflat {
 
 
+// decoded shader bodies are shared across all materials of the process
+static ShaderTextCache sShaderTextCache;
+
+bool ShaderTextCache::get(const uint8_t* base, uint32_t key, ShaderBuilder& builder) noexcept {
+    std::lock_guard<std::mutex> guard(mLock);
+    for (Entry& entry : mEntries) {
+        if (entry.base == base && entry.key == key) {
+            entry.stamp = ++mStamp;
+            builder.announce(entry.text.size());
+            builder.appendPart(entry.text.data(), entry.text.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShaderTextCache::put(const uint8_t* base, uint32_t key, const char* text,
+        size_t size) noexcept {
+    std::lock_guard<std::mutex> guard(mLock);
+    Entry* lru = &mEntries[0];
+    for (Entry& entry : mEntries) {
+        if (entry.stamp < lru->stamp) {
+            lru = &entry;
+        }
+    }
+    lru->base = base;
+    lru->key = key;
+    lru->stamp = ++mStamp;
+    lru->text.assign(text, text + size);
+}
+
+void ShaderTextCache::purge(const uint8_t* base) noexcept {
+    std::lock_guard<std::mutex> guard(mLock);
+    for (Entry& entry : mEntries) {
+        if (entry.base == base) {
+            entry = Entry{};
+        }
+    }
+}
+
+MaterialChunk::~MaterialChunk() noexcept {
+    if (mBase) {
+        // the package memory may be reused for another material, drop our entries
+        sShaderTextCache.purge(mBase);
+    }
+}
+
 static inline uint32_t makeKey(ShaderModel shaderModel, uint8_t variant, ShaderType type) noexcept {
     static_assert(sizeof(ShaderModel) == 1, "ShaderModel must not exceed 8 bits");
     static_assert(sizeof(ShaderType) == 1, "ShaderType must not exceed 8 bits");
@@ -102,6 +149,13 @@ bool MaterialChunk::getTextShader(Unflattener unflattener, BlobDictionary& dicti
         // This shader was not found.
         return false;
     }
+
+    // a previous decode of this variant (possibly by another material sharing the same
+    // package) may still be in the LRU
+    if (sShaderTextCache.get(mBase, key, shader)) {
+        return true;
+    }
+
     unflattener.setCursor(mBase + offset);
 
     // Read how big the shader is.
@@ -133,6 +187,9 @@ bool MaterialChunk::getTextShader(Unflattener unflattener, BlobDictionary& dicti
     // Write the terminating null character.
     shader.appendPart("", 1);
 
+    // keep the decoded body (including the terminator) for the next request
+    sShaderTextCache.put(mBase, key, shader.getShader(), shader.size());
+
     return true;
 }
 
@@ -29,10 +29,47 @@
 
 #include <tsl/robin_map.h>
 
+#include <mutex>
+#include <vector>
+
 namespace filaflat {
 
+// Process-wide LRU of decoded shader bodies, shared across materials. Decoding a text
+// shader walks the dictionary line by line; during level streaming the same hot variants
+// get decoded over and over as materials come and go, so we keep the last few decoded
+// bodies around. Entries are keyed by the shader index base pointer + variant key and
+// purged when the owning MaterialChunk goes away (the base pointer may be reused).
+class ShaderTextCache {
+public:
+    // decoded shaders are usually a few KB; 16 entries cover the hot variants of a
+    // streaming batch without holding on to a meaningful amount of memory
+    static constexpr size_t CAPACITY = 16;
+
+    // returns true and appends the decoded body to 'builder' on a hit
+    bool get(const uint8_t* base, uint32_t key, ShaderBuilder& builder) noexcept;
+
+    // inserts a decoded body, evicting the least recently used entry if needed
+    void put(const uint8_t* base, uint32_t key, const char* text, size_t size) noexcept;
+
+    // removes all entries decoded from this shader index
+    void purge(const uint8_t* base) noexcept;
+
+private:
+    struct Entry {
+        const uint8_t* base = nullptr;
+        uint32_t key = 0;
+        uint32_t stamp = 0;
+        std::vector<char> text;
+    };
+    std::mutex mLock;
+    uint32_t mStamp = 0;
+    Entry mEntries[CAPACITY];
+};
+
 class MaterialChunk {
 public:
+    ~MaterialChunk() noexcept;
+
     bool getTextShader(
             Unflattener unflattener, BlobDictionary& dictionary, ShaderBuilder& shaderBuilder,
             filament::driver::ShaderModel shaderModel, uint8_t variant,
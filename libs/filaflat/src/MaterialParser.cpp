@@ -34,6 +34,7 @@
 
 #include <cstdlib>
 
+#include <mutex>
 #include <string>
 
 using namespace utils;
@@ -42,14 +43,19 @@ using namespace filamat;
 
 namespace filaflat {
 
-// Make a copy of content and own the allocated memory.
+// Holds the material package. By default it makes a copy and owns the allocated memory;
+// in zero-copy mode it is just a view into a caller-owned region (e.g. a memory-mapped
+// file or a compiled-in package), which must outlive this object.
 class ManagedBuffer  {
     void* mStart = nullptr;
     size_t mSize = 0;
+    bool mOwner = false;
 public:
-    explicit ManagedBuffer(const void* start, size_t size)
-            : mStart(malloc(size)), mSize(size) {
-        memcpy(mStart, start, size);
+    ManagedBuffer(const void* start, size_t size, bool copy)
+            : mStart(copy ? malloc(size) : const_cast<void*>(start)), mSize(size), mOwner(copy) {
+        if (copy) {
+            memcpy(mStart, start, size);
+        }
     }
 
     void* begin() const noexcept { return mStart; }
@@ -57,13 +63,16 @@ public:
     size_t size() const noexcept { return mSize; }
 
     ~ManagedBuffer() noexcept {
-        free(mStart);
+        if (mOwner) {
+            free(mStart);
+        }
     }
 };
 
 struct MaterialParserDetails {
-    MaterialParserDetails(filament::driver::Backend backend, const void* data, size_t size)
-            : mUnflattenable(data, size),
+    MaterialParserDetails(filament::driver::Backend backend, const void* data, size_t size,
+            bool copy)
+            : mUnflattenable(data, size, copy),
               mChunkContainer(mUnflattenable.begin(), mUnflattenable.size()),
               mBackend(backend) {
     }
@@ -74,6 +83,9 @@ struct MaterialParserDetails {
     filament::driver::Backend mBackend;
     MaterialChunk mMaterialChunk;
     BlobDictionary mBlobDictionary;
+    // guards the lazily built shader index and dictionary above, so a parser shared
+    // between several engines can serve getShader() from any of their threads
+    std::mutex mShaderLock;
 
     template<typename T>
     bool getFromSimpleChunk(filamat::ChunkType type, T* value) const noexcept;
@@ -96,8 +108,9 @@ bool MaterialParserDetails::getFromSimpleChunk(filamat::ChunkType type, T* value
     return unflattener.read(value);
 }
 
-MaterialParser::MaterialParser(filament::driver::Backend backend, const void* data, size_t size)
-        : mImpl(new MaterialParserDetails(backend, data, size)) {
+MaterialParser::MaterialParser(filament::driver::Backend backend, const void* data, size_t size,
+        bool copy)
+        : mImpl(new MaterialParserDetails(backend, data, size, copy)) {
 }
 
 MaterialParser::~MaterialParser() {
@@ -257,6 +270,10 @@ bool MaterialParser::hasCustomDepthShader(bool* value) const noexcept {
     return mImpl->getFromSimpleChunk(ChunkType::MaterialHasCustomDepthShader, value);
 }
 
+bool MaterialParser::getSupportedVariants(uint32_t* value) const noexcept {
+    return mImpl->getFromSimpleChunk(ChunkType::MaterialSupportedVariants, value);
+}
+
 bool MaterialParser::getRequiredAttributes(AttributeBitset* value) const noexcept {
     uint32_t rawAttributes = 0;
     if (!mImpl->getFromSimpleChunk(ChunkType::MaterialRequiredAttributes, &rawAttributes)) {
@@ -272,6 +289,8 @@ bool MaterialParser::getRequiredAttributes(AttributeBitset* value) const noexcep
 bool MaterialParser::getShader(
         filament::driver::ShaderModel shaderModel, uint8_t variant, filament::driver::ShaderType st,
         ShaderBuilder& shader) noexcept {
+    // program builds are rare enough that serializing them is free in practice
+    std::lock_guard<std::mutex> guard(mImpl->mShaderLock);
     return (mImpl->mBackend == filament::driver::Backend::VULKAN) ?
            mImpl->getVkShader(shaderModel, variant, st, shader) :
            mImpl->getGlShader(shaderModel, variant, st, shader);
@@ -240,6 +240,8 @@ void ImGuiHelper::createVertexBuffer(size_t bufferIndex, size_t capacity) {
             .attribute(VertexAttribute::COLOR, 0, VertexBuffer::AttributeType::UBYTE4,
                     2 * sizeof(math::float2), sizeof(ImDrawVert))
             .normalized(VertexAttribute::COLOR)
+            // the UI geometry is re-specified every frame
+            .usage(VertexBuffer::BufferUsage::STREAM)
             .build(*mEngine);
 }
 
@@ -249,6 +251,8 @@ void ImGuiHelper::createIndexBuffer(size_t bufferIndex, size_t capacity) {
     mIndexBuffers[bufferIndex] = IndexBuffer::Builder()
             .indexCount(capacity)
             .bufferType(IndexBuffer::IndexType::USHORT)
+            // the UI geometry is re-specified every frame
+            .usage(IndexBuffer::BufferUsage::STREAM)
             .build(*mEngine);
 }
 
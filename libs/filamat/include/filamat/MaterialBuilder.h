@@ -194,6 +194,20 @@ public:
     // specifies a list of variants that should be filtered out during code generation.
     MaterialBuilder& variantFilter(uint8_t variantFilter) noexcept;
 
+    // restricts the package to the given set of variants, one bit per variant key (defaults
+    // to all variants). The mask is typically recorded at runtime from the "d.variants.used"
+    // debug property. The depth variants are always kept, as the engine relies on them.
+    MaterialBuilder& variantAllowlist(uint16_t variantMask) noexcept;
+
+    // number of threads used to generate and post-process the shader variants (defaults to 1).
+    // The post-processor callback must be reentrant when more than one thread is requested.
+    MaterialBuilder& threads(uint32_t threadCount) noexcept;
+
+    // directory used to cache post-processed shaders across runs. Entries are keyed by the
+    // content of the generated shader, so unchanged variants are reused instead of being
+    // post-processed again (e.g. across successive CI builds).
+    MaterialBuilder& compileCache(const char* path) noexcept;
+
     // build the material
     Package build() noexcept;
 
@@ -284,6 +298,10 @@ private:
     bool mDepthWriteSet = false;
 
     PostProcessCallBack mPostprocessorCallback = nullptr;
+
+    uint32_t mThreadCount = 1;
+    utils::CString mCompileCachePath;
+    uint16_t mVariantAllowlist = 0xffff;
 };
 
 } // namespace filamat
@@ -16,6 +16,10 @@
 
 #include "filamat/MaterialBuilder.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
 #include <vector>
 
 #include <utils/Panic.h>
@@ -265,6 +269,21 @@ MaterialBuilder& MaterialBuilder::variantFilter(uint8_t variantFilter) noexcept
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::variantAllowlist(uint16_t variantMask) noexcept {
+    mVariantAllowlist = variantMask;
+    return *this;
+}
+
+MaterialBuilder& MaterialBuilder::threads(uint32_t threadCount) noexcept {
+    mThreadCount = threadCount > 0 ? threadCount : 1;
+    return *this;
+}
+
+MaterialBuilder& MaterialBuilder::compileCache(const char* path) noexcept {
+    mCompileCachePath = CString(path);
+    return *this;
+}
+
 bool MaterialBuilder::hasExternalSampler() const noexcept {
     for (size_t i = 0, c = mParameterCount; i < c; i++) {
         auto const& param = mParameters[i];
@@ -302,7 +321,10 @@ void MaterialBuilder::prepareToBuild(MaterialInfo& info) noexcept {
     }
 
     info.sib = sbb.name("MaterialParams").build();
-    info.uib = ibb.name("MaterialParams").build();
+    // pack() is safe here: material parameter offsets are always looked up by name, and
+    // the runtime rebuilds this block from the serialized (already packed) field order,
+    // so CPU-side offsets and the generated shader declaration stay consistent
+    info.uib = ibb.name("MaterialParams").pack().build();
 
     info.isLit = isLit();
     info.isDoubleSided = mDoubleSided;
@@ -314,6 +336,86 @@ void MaterialBuilder::prepareToBuild(MaterialInfo& info) noexcept {
     info.samplerBindings.populate(&info.sib);
 }
 
+// Content-hash compile cache
+//
+// Post-processing a shader (glslang + spirv-cross) dominates matc's runtime. Cache entries
+// are keyed by the content of the *generated* shader (plus the parameters that affect the
+// post-processor's output), so any edit that changes the generated code naturally misses,
+// while unchanged variants are reused across runs.
+
+static constexpr uint32_t COMPILE_CACHE_MAGIC   = 0x43434D46u; // 'FMCC'
+static constexpr uint32_t COMPILE_CACHE_VERSION = 1;
+
+static uint64_t hashShaderContent(const std::string& shader, uint8_t shaderModel,
+        uint8_t stage, uint8_t codeGenTargetApi, bool wantSpirv) noexcept {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    auto mix = [&h](const char* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            h = (h ^ uint8_t(data[i])) * 0x100000001b3ull;
+        }
+    };
+    mix(shader.data(), shader.size());
+    const char salt[4] = { char(shaderModel), char(stage), char(codeGenTargetApi),
+            char(wantSpirv) };
+    mix(salt, sizeof(salt));
+    return h;
+}
+
+static std::string compileCacheEntryPath(const char* dir, uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.matcache", (unsigned long long)key);
+    return std::string(dir) + name;
+}
+
+static bool readCompileCacheEntry(const char* dir, uint64_t key,
+        std::string* glsl, std::vector<uint32_t>* spirv) {
+    FILE* file = fopen(compileCacheEntryPath(dir, key).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = false;
+    uint32_t header[4]; // magic, version, glsl size, spirv word count
+    if (fread(header, sizeof(header), 1, file) == 1 &&
+            header[0] == COMPILE_CACHE_MAGIC && header[1] == COMPILE_CACHE_VERSION) {
+        glsl->resize(header[2]);
+        ok = header[2] == 0 || fread(&(*glsl)[0], header[2], 1, file) == 1;
+        if (ok && spirv != nullptr) {
+            spirv->resize(header[3]);
+            ok = header[3] == 0 ||
+                    fread(spirv->data(), header[3] * sizeof(uint32_t), 1, file) == 1;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+static void writeCompileCacheEntry(const char* dir, uint64_t key,
+        const std::string& glsl, const std::vector<uint32_t>* spirv) {
+    const std::string path = compileCacheEntryPath(dir, key);
+    const std::string tmpPath = path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        return;
+    }
+    const uint32_t header[4] = { COMPILE_CACHE_MAGIC, COMPILE_CACHE_VERSION,
+            uint32_t(glsl.size()), uint32_t(spirv ? spirv->size() : 0) };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+    if (ok && !glsl.empty()) {
+        ok = fwrite(glsl.data(), glsl.size(), 1, file) == 1;
+    }
+    if (ok && spirv != nullptr && !spirv->empty()) {
+        ok = fwrite(spirv->data(), spirv->size() * sizeof(uint32_t), 1, file) == 1;
+    }
+    fclose(file);
+    // the write-to-temporary/rename dance keeps concurrent matc invocations from seeing
+    // (or producing) a truncated entry
+    if (ok) {
+        rename(tmpPath.c_str(), path.c_str());
+    } else {
+        remove(tmpPath.c_str());
+    }
+}
+
 static void showErrorMessage(const char* materialName, uint8_t variant,
         MaterialBuilder::TargetApi targetApi, filament::driver::ShaderType shaderType,
         const std::string& shaderCode) {
@@ -376,10 +478,10 @@ Package MaterialBuilder::build() noexcept {
     MaterialSamplerInterfaceBlockChunk matSib = MaterialSamplerInterfaceBlockChunk(info.sib);
     container.addChild(&matSib);
 
+    // Sampler bindings, always emitted so that the engine never has to recompute the table at
+    // load time -- this also guarantees that all backends agree on the binding assignments.
     MaterialSamplerBindingsChunk matSb = MaterialSamplerBindingsChunk(info.samplerBindings);
-    if (mTargetApi == TargetApi::VULKAN || mTargetApi == TargetApi::ALL) {
-        container.addChild(&matSb);
-    }
+    container.addChild(&matSb);
 
     SimpleFieldChunk<bool> matDepthWriteSet(ChunkType::MaterialDepthWriteSet, mDepthWriteSet);
     container.addChild(&matDepthWriteSet);
@@ -426,7 +528,6 @@ Package MaterialBuilder::build() noexcept {
     std::vector<SpirvEntry> spirvEntries;
     LineDictionary glslDictionary;
     BlobDictionary spirvDictionary;
-    std::vector<uint32_t> spirv;
 
     ShaderGenerator sg(mProperties, mVariables,
             mMaterialCode, mMaterialLineOffset, mMaterialVertexCode, mMaterialVertexLineOffset);
@@ -437,96 +538,169 @@ Package MaterialBuilder::build() noexcept {
     SimpleFieldChunk<bool> hasCustomDepth(ChunkType::MaterialHasCustomDepthShader, customDepth);
     container.addChild(&hasCustomDepth);
 
-    bool errorOccured = false;
-    for (const auto& params : mCodeGenPermutations) {
-        const ShaderModel shaderModel = ShaderModel(params.shaderModel);
-        const TargetApi targetApi = params.targetApi;
-        const TargetApi codeGenTargetApi = params.codeGenTargetApi;
-        std::vector<uint32_t>* pSpirv = (targetApi == TargetApi::VULKAN) ? &spirv : nullptr;
-
-        GlslEntry glslEntry;
-        SpirvEntry spirvEntry;
-
-        glslEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
-        spirvEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
+    // Each variant's generation and post-processing is fully isolated in its VariantJob, so
+    // jobs can run on a thread pool (see threads()). The dictionaries and entry lists are
+    // filled serially afterwards, in the same order as the jobs were created, so the package
+    // layout stays deterministic regardless of the thread count.
+    struct VariantJob {
+        uint8_t shaderModel;
+        TargetApi targetApi;
+        TargetApi codeGenTargetApi;
+        uint8_t variant;
+        filament::driver::ShaderType stage;
+        std::string shader;             // output GLSL (holds the error log on failure)
+        std::vector<uint32_t> spirv;    // output SPIR-V when targeting Vulkan
+        bool ok = true;
+    };
+
+    std::vector<VariantJob> variantJobs;
+
+    // apply custom variants filters
+    const uint8_t variantMask = ~mVariantFilter;
+
+    // Expand the variant allowlist into the set of vertex and fragment shaders the allowed
+    // variants resolve to, so shaders shared with a stripped variant are kept. The depth
+    // variants are always included: the engine relies on them for depth-only passes.
+    const uint16_t allowlist = mVariantAllowlist
+            | uint16_t(1u << filament::Variant::DEPTH_VARIANT)
+            | uint16_t(1u << (filament::Variant::DEPTH_VARIANT | filament::Variant::SKINNING));
+    uint16_t allowedVertexVariants = 0;
+    uint16_t allowedFragmentVariants = 0;
+    for (uint8_t k = 0; k < filament::VARIANT_COUNT; k++) {
+        if (filament::Variant::isReserved(k) || !(allowlist & (1u << k))) {
+            continue;
+        }
+        uint8_t v = filament::Variant::filterVariant(k & variantMask,
+                isLit() || mShadowMultiplier);
+        allowedVertexVariants |= uint16_t(1u << filament::Variant::filterVariantVertex(v));
+        allowedFragmentVariants |= uint16_t(1u << filament::Variant::filterVariantFragment(v));
+    }
 
-        // apply custom variants filters
-        uint8_t variantMask = ~mVariantFilter;
+    // Precompute the set of variants the engine can actually request at runtime: the
+    // non-reserved fixed points of variant filtering, restricted to the allowlist. The
+    // engine uses this to resolve variants with a table lookup and to pre-build all
+    // programs (Material::compile()) without touching stripped variants.
+    uint32_t supportedVariants = 0;
+    for (uint8_t k = 0; k < filament::VARIANT_COUNT; k++) {
+        if (filament::Variant::isReserved(k) || !(allowlist & (1u << k))) {
+            continue;
+        }
+        uint8_t v = filament::Variant::filterVariant(k & variantMask,
+                isLit() || mShadowMultiplier);
+        supportedVariants |= uint32_t(1u << v);
+    }
+    SimpleFieldChunk<uint32_t> matSupportedVariants(ChunkType::MaterialSupportedVariants,
+            supportedVariants);
+    container.addChild(&matSupportedVariants);
 
+    for (const auto& params : mCodeGenPermutations) {
         for (uint8_t k = 0; k < filament::VARIANT_COUNT; k++) {
-
             if (filament::Variant::isReserved(k)) {
                 continue;
             }
-
-            glslEntry.variant = k;
-            spirvEntry.variant = k;
-
             // Remove variants for unlit materials
-            uint8_t v = filament::Variant::filterVariant(k & variantMask, isLit() || mShadowMultiplier);
-
-            if (filament::Variant::filterVariantVertex(v) == k) {
-                // Vertex Shader
-                std::string vs = sg.createVertexProgram(
-                        shaderModel, targetApi, codeGenTargetApi, info, k,
-                        mInterpolation, mVertexDomain);
-                if (mPostprocessorCallback != nullptr) {
-                    bool ok = mPostprocessorCallback(vs, filament::driver::ShaderType::VERTEX,
-                            shaderModel, &vs, pSpirv);
-                    if (!ok) {
-                        showErrorMessage(mMaterialName.c_str_safe(), k, targetApi,
-                                filament::driver::ShaderType::VERTEX, vs);
-                        errorOccured = true;
-                        break;
-                    }
-                }
-                if (targetApi == TargetApi::OPENGL) {
-                    glslEntry.stage = filament::driver::ShaderType::VERTEX;
-                    glslEntry.shaderSize = vs.size();
-                    glslEntry.shader = (char*)malloc(glslEntry.shaderSize + 1);
-                    strcpy(glslEntry.shader, vs.c_str());
-                    glslDictionary.addText(glslEntry.shader);
-                    glslEntries.push_back(glslEntry);
-                }
-                if (targetApi == TargetApi::VULKAN) {
-                    assert(spirv.size() > 0);
-                    spirvEntry.stage = filament::driver::ShaderType::VERTEX;
-                    spirvEntry.dictionaryIndex = spirvDictionary.addBlob(spirv);
-                    spirv.clear();
-                    spirvEntries.push_back(spirvEntry);
-                }
+            uint8_t v = filament::Variant::filterVariant(k & variantMask,
+                    isLit() || mShadowMultiplier);
+
+            if (filament::Variant::filterVariantVertex(v) == k
+                    && (allowedVertexVariants & (1u << k))) {
+                variantJobs.push_back({ params.shaderModel, params.targetApi,
+                        params.codeGenTargetApi, k, filament::driver::ShaderType::VERTEX });
             }
+            if (filament::Variant::filterVariantFragment(v) == k
+                    && (allowedFragmentVariants & (1u << k))) {
+                variantJobs.push_back({ params.shaderModel, params.targetApi,
+                        params.codeGenTargetApi, k, filament::driver::ShaderType::FRAGMENT });
+            }
+        }
+    }
 
-            if (filament::Variant::filterVariantFragment(v) == k) {
-                // Fragment Shader
-                std::string fs = sg.createFragmentProgram(
-                        shaderModel, targetApi, codeGenTargetApi, info, k, mInterpolation);
-                if (mPostprocessorCallback != nullptr) {
-                    bool ok = mPostprocessorCallback(fs, filament::driver::ShaderType::FRAGMENT,
-                            shaderModel, &fs, pSpirv);
-                    if (!ok) {
-                        showErrorMessage(mMaterialName.c_str_safe(), k, targetApi,
-                                filament::driver::ShaderType::FRAGMENT, fs);
-                        errorOccured = true;
-                        break;
-                    }
-                }
-                if (targetApi == TargetApi::OPENGL) {
-                    glslEntry.stage = filament::driver::ShaderType::FRAGMENT;
-                    glslEntry.shaderSize = fs.size();
-                    glslEntry.shader = (char*)malloc(glslEntry.shaderSize + 1);
-                    strcpy(glslEntry.shader, fs.c_str());
-                    glslDictionary.addText(glslEntry.shader);
-                    glslEntries.push_back(glslEntry);
-                }
-                if (targetApi == TargetApi::VULKAN) {
-                    assert(spirv.size() > 0);
-                    spirvEntry.stage = filament::driver::ShaderType::FRAGMENT;
-                    spirvEntry.dictionaryIndex = spirvDictionary.addBlob(spirv);
-                    spirv.clear();
-                    spirvEntries.push_back(spirvEntry);
+    auto processJob = [this, &sg, &info](VariantJob& job) {
+        const ShaderModel shaderModel = ShaderModel(job.shaderModel);
+        std::vector<uint32_t>* pSpirv =
+                (job.targetApi == TargetApi::VULKAN) ? &job.spirv : nullptr;
+
+        std::string shader = (job.stage == filament::driver::ShaderType::VERTEX)
+                ? sg.createVertexProgram(shaderModel, job.targetApi, job.codeGenTargetApi,
+                        info, job.variant, mInterpolation, mVertexDomain)
+                : sg.createFragmentProgram(shaderModel, job.targetApi, job.codeGenTargetApi,
+                        info, job.variant, mInterpolation);
+
+        if (mPostprocessorCallback != nullptr) {
+            uint64_t cacheKey = 0;
+            if (!mCompileCachePath.empty()) {
+                cacheKey = hashShaderContent(shader, job.shaderModel, uint8_t(job.stage),
+                        uint8_t(job.codeGenTargetApi), pSpirv != nullptr);
+                if (readCompileCacheEntry(mCompileCachePath.c_str(), cacheKey,
+                        &shader, pSpirv)) {
+                    job.shader = std::move(shader);
+                    return;
                 }
             }
+            bool ok = mPostprocessorCallback(shader, job.stage, shaderModel, &shader, pSpirv);
+            if (!ok) {
+                job.ok = false;
+                job.shader = std::move(shader);
+                return;
+            }
+            if (!mCompileCachePath.empty()) {
+                writeCompileCacheEntry(mCompileCachePath.c_str(), cacheKey, shader, pSpirv);
+            }
+        }
+        job.shader = std::move(shader);
+    };
+
+    const uint32_t threadCount = uint32_t(std::min(size_t(mThreadCount),
+            std::max(size_t(1), variantJobs.size())));
+    if (threadCount > 1) {
+        std::atomic<size_t> nextJob(0);
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++) {
+            workers.emplace_back([&variantJobs, &nextJob, &processJob]() {
+                size_t j;
+                while ((j = nextJob.fetch_add(1, std::memory_order_relaxed))
+                        < variantJobs.size()) {
+                    processJob(variantJobs[j]);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    } else {
+        for (VariantJob& job : variantJobs) {
+            processJob(job);
+        }
+    }
+
+    bool errorOccured = false;
+    for (VariantJob& job : variantJobs) {
+        if (!job.ok) {
+            showErrorMessage(mMaterialName.c_str_safe(), job.variant, job.targetApi,
+                    job.stage, job.shader);
+            errorOccured = true;
+            continue;
+        }
+        if (job.targetApi == TargetApi::OPENGL) {
+            GlslEntry glslEntry;
+            glslEntry.shaderModel = job.shaderModel;
+            glslEntry.variant = job.variant;
+            glslEntry.stage = job.stage;
+            glslEntry.shaderSize = job.shader.size();
+            glslEntry.shader = (char*)malloc(glslEntry.shaderSize + 1);
+            strcpy(glslEntry.shader, job.shader.c_str());
+            glslDictionary.addText(glslEntry.shader);
+            glslEntries.push_back(glslEntry);
+        }
+        if (job.targetApi == TargetApi::VULKAN) {
+            assert(job.spirv.size() > 0);
+            SpirvEntry spirvEntry;
+            spirvEntry.shaderModel = job.shaderModel;
+            spirvEntry.variant = job.variant;
+            spirvEntry.stage = job.stage;
+            spirvEntry.dictionaryIndex = spirvDictionary.addBlob(job.spirv);
+            spirvEntries.push_back(spirvEntry);
         }
     }
 
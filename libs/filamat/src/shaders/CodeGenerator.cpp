@@ -139,6 +139,13 @@ std::ostream& CodeGenerator::generatePostProcessMain(std::ostream& out,
             case PostProcessStage::ANTI_ALIASING_TRANSLUCENT:
                 out << filament::shaders::fxaa_fs;
                 break;
+            case PostProcessStage::TRANSPARENCY_UPSAMPLE:
+                // a plain up-sampling fetch, no helpers needed
+                break;
+            case PostProcessStage::LUMINANCE_DOWNSAMPLE:
+            case PostProcessStage::LUMINANCE_ADAPTATION:
+                // luminance() comes from the common helpers, nothing extra needed
+                break;
         }
         out << filament::shaders::post_process_fs;
     }
@@ -184,6 +191,13 @@ std::ostream& CodeGenerator::generateVariables(std::ostream& out, ShaderType typ
     bool hasBoneWeights = attributes.test(VertexAttribute::BONE_WEIGHTS);
     generateDefine(out, "HAS_ATTRIBUTE_BONE_WEIGHTS", hasBoneWeights);
 
+    bool hasMorphPosition[4];
+    for (size_t i = 0; i < 4; i++) {
+        hasMorphPosition[i] = attributes.test(VertexAttribute::MORPH_POSITION_0 + i);
+        generateDefine(out, ("HAS_ATTRIBUTE_MORPH_POSITION_" + std::to_string(i)).c_str(),
+                hasMorphPosition[i]);
+    }
+
     if (type == ShaderType::VERTEX) {
         out << "\n";
         generateDefine(out, "LOCATION_POSITION", uint32_t(VertexAttribute::POSITION));
@@ -205,6 +219,12 @@ std::ostream& CodeGenerator::generateVariables(std::ostream& out, ShaderType typ
         if (hasBoneWeights) {
             generateDefine(out, "LOCATION_BONE_WEIGHTS", uint32_t(VertexAttribute::BONE_WEIGHTS));
         }
+        for (size_t i = 0; i < 4; i++) {
+            if (hasMorphPosition[i]) {
+                generateDefine(out, ("LOCATION_MORPH_POSITION_" + std::to_string(i)).c_str(),
+                        uint32_t(VertexAttribute::MORPH_POSITION_0 + i));
+            }
+        }
 
         out << filament::shaders::variables_vs;
     } else if (type == ShaderType::FRAGMENT) {
@@ -497,6 +517,14 @@ char const* CodeGenerator::getSamplerTypeName(SamplerType type, SamplerFormat fo
                     case SamplerFormat::SHADOW: return "sampler2DShadow";   // should not happen
                 }
             }
+        case SamplerType::SAMPLER_2D_ARRAY:
+            assert(!multisample);
+            switch (format) {
+                case SamplerFormat::INT:    return "isampler2DArray";
+                case SamplerFormat::UINT:   return "usampler2DArray";
+                case SamplerFormat::FLOAT:  return "sampler2DArray";
+                case SamplerFormat::SHADOW: return "sampler2DArrayShadow";
+            }
         case SamplerType::SAMPLER_CUBEMAP:
             assert(!multisample);
             switch (format) {
@@ -392,29 +392,93 @@ void ShaderPostProcessGenerator::generatePostProcessStageDefines(std::stringstre
             uint32_t(PostProcessStage::ANTI_ALIASING_OPAQUE));
     cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING_TRANSLUCENT",
             uint32_t(PostProcessStage::ANTI_ALIASING_TRANSLUCENT));
+    cg.generateDefine(vs, "POST_PROCESS_TRANSPARENCY_UPSAMPLE",
+            uint32_t(PostProcessStage::TRANSPARENCY_UPSAMPLE));
+    cg.generateDefine(vs, "POST_PROCESS_LUMINANCE_DOWNSAMPLE",
+            uint32_t(PostProcessStage::LUMINANCE_DOWNSAMPLE));
+    cg.generateDefine(vs, "POST_PROCESS_LUMINANCE_ADAPTATION",
+            uint32_t(PostProcessStage::LUMINANCE_ADAPTATION));
+    cg.generateDefine(vs, "POST_PROCESS_SHADOW_PREFILTER",
+            uint32_t(PostProcessStage::SHADOW_PREFILTER));
     switch (variant) {
         case PostProcessStage::TONE_MAPPING_OPAQUE:
             cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_TONE_MAPPING_OPAQUE");
             cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  1u);
             cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
             cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        1u);
             break;
         case PostProcessStage::TONE_MAPPING_TRANSLUCENT:
             cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_TONE_MAPPING_TRANSLUCENT");
             cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  1u);
             cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
             cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
             break;
         case PostProcessStage::ANTI_ALIASING_OPAQUE:
             cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_ANTI_ALIASING_OPAQUE");
             cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
             cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 1u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
             cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        1u);
             break;
         case PostProcessStage::ANTI_ALIASING_TRANSLUCENT:
             cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_ANTI_ALIASING_TRANSLUCENT");
             cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
             cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 1u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
+            cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
+            break;
+        case PostProcessStage::TRANSPARENCY_UPSAMPLE:
+            cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_TRANSPARENCY_UPSAMPLE");
+            cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
+            cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      1u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
+            cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
+            break;
+        case PostProcessStage::LUMINANCE_DOWNSAMPLE:
+            cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_LUMINANCE_DOWNSAMPLE");
+            cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
+            cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     1u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
+            cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
+            break;
+        case PostProcessStage::LUMINANCE_ADAPTATION:
+            cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_LUMINANCE_ADAPTATION");
+            cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
+            cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    1u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   0u);
+            cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
+            break;
+        case PostProcessStage::SHADOW_PREFILTER:
+            cg.generateDefine(vs, "POST_PROCESS_STAGE", "POST_PROCESS_SHADOW_PREFILTER");
+            cg.generateDefine(vs, "POST_PROCESS_TONE_MAPPING",  0u);
+            cg.generateDefine(vs, "POST_PROCESS_ANTI_ALIASING", 0u);
+            cg.generateDefine(vs, "POST_PROCESS_UPSAMPLE",      0u);
+            cg.generateDefine(vs, "POST_PROCESS_LUMINANCE",     0u);
+            cg.generateDefine(vs, "POST_PROCESS_ADAPTATION",    0u);
+            cg.generateDefine(vs, "POST_PROCESS_SHADOW_EVSM",   1u);
             cg.generateDefine(vs, "POST_PROCESS_OPAQUE",        0u);
             break;
     }
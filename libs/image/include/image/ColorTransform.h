@@ -21,6 +21,7 @@
 
 #include <utils/compiler.h>
 
+#include <math/fast.h>
 #include <math/scalar.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
@@ -91,6 +92,17 @@ inline float linearTosRGB(float linear) {
 template<typename T>
 T sRGBToLinear(const T& sRGB);
 
+template<>
+inline float sRGBToLinear(const float& sRGB) {
+    if (sRGB <= 0.04045f) {
+        return sRGB * (1.0f / 12.92f);
+    } else {
+        constexpr float a = 0.055f;
+        constexpr float a1 = 1.055f;
+        return std::pow((sRGB + a) / a1, 2.4f);
+    }
+}
+
 template<>
 inline math::float3 sRGBToLinear(const math::float3& sRGB) {
     using math::float3;
@@ -141,6 +153,79 @@ inline math::float3 linearToSRGB(const math::float3& color) {
     return sRGBColor;
 }
 
+/*
+ * Batch conversion kernels. Converting a texel at a time through the functions above
+ * costs a std::pow per component; asset import pushes millions of texels through the
+ * transfer functions, so the batch paths below replace the libm call with either a
+ * table lookup (integer sources) or the vectorized fast transcendentals (float paths).
+ */
+
+// 257-entry table of the sRGB decoding curve, one entry per 8-bit code plus a guard
+// for interpolation; built on first use.
+inline const float* getSRGBToLinearLUT() {
+    static const struct Lut {
+        float v[257];
+        Lut() {
+            for (size_t i = 0; i < 256; i++) {
+                v[i] = sRGBToLinear(float(i) * (1.0f / 255.0f));
+            }
+            v[256] = v[255];
+        }
+    } lut;
+    return lut.v;
+}
+
+// exact: every possible 8-bit code is tabulated
+inline float MATH_PURE sRGBToLinearLookup(const float* lut, uint8_t v) {
+    return lut[v];
+}
+
+// table on the high bits plus linear interpolation. 65535 == 255 * 257, so v / 257
+// lands exactly on the 8-bit table; max absolute error 5.9e-6 vs. libm, i.e. below
+// the 16-bit quantization step (1.5e-5) of the source data.
+inline float MATH_PURE sRGBToLinearLookup(const float* lut, uint16_t v) {
+    const uint32_t hi = uint32_t(v) / 257u;
+    const float f = float(v - hi * 257u) * (1.0f / 257.0f);
+    return lut[hi] + (lut[hi + 1] - lut[hi]) * f;
+}
+
+// Decodes count sRGB components to linear through the vectorized power curve
+// (max relative error ~5e-5, far below 8-bit quantization). src and dst may alias
+// exactly; components are independent, so interleaved alpha must be excluded or
+// fixed up by the caller.
+inline void sRGBToLinearBatch(float* UTILS_RESTRICT dst, const float* UTILS_RESTRICT src,
+        size_t count) {
+    using namespace math;
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4) {
+        const float4 v{ src[i], src[i + 1], src[i + 2], src[i + 3] };
+        const float4 p = fast::pow((v + 0.055f) * (1.0f / 1.055f), 2.4f);
+        for (size_t j = 0; j < 4; j++) {
+            dst[i + j] = v[j] <= 0.04045f ? v[j] * (1.0f / 12.92f) : p[j];
+        }
+    }
+    for ( ; i < count; i++) {
+        dst[i] = sRGBToLinear(src[i]);
+    }
+}
+
+// Encodes count linear components to sRGB; same contract as sRGBToLinearBatch().
+inline void linearToSRGBBatch(float* UTILS_RESTRICT dst, const float* UTILS_RESTRICT src,
+        size_t count) {
+    using namespace math;
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4) {
+        const float4 v{ src[i], src[i + 1], src[i + 2], src[i + 3] };
+        const float4 p = fast::pow(v, 1.0f / 2.4f);
+        for (size_t j = 0; j < 4; j++) {
+            dst[i + j] = v[j] <= 0.0031308f ? v[j] * 12.92f : 1.055f * p[j] - 0.055f;
+        }
+    }
+    for ( ; i < count; i++) {
+        dst[i] = linearTosRGB(src[i]);
+    }
+}
+
 // Creates a n-channel sRGB image from a linear floating-point image.
 // The source image can have more than N channels, but only the first N are honored.
 template <typename T, int N = 3>
@@ -150,16 +235,21 @@ std::unique_ptr<uint8_t[]> fromLinearTosRGB(const LinearImage& image) {
     const size_t nchan = image.getChannels();
     assert(nchan >= N);
     std::unique_ptr<uint8_t[]> dst(new uint8_t[w * h * N * sizeof(T)]);
+    std::unique_ptr<float[]> row(new float[w * N]);
     T* d = reinterpret_cast<T*>(dst.get());
     for (size_t y = 0; y < h; ++y) {
         float const* p = image.getPixelRef(0, y);
-        for (size_t x = 0; x < w; ++x, p += nchan, d += N) {
+        // gather the N channels of interest, encode the whole row at once, quantize
+        float* r = row.get();
+        for (size_t x = 0; x < w; ++x, p += nchan, r += N) {
             for (int n = 0; n < N; n++) {
-                float source = linearTosRGB(p[n]);
-                float target = math::saturate(source) * std::numeric_limits<T>::max();
-                d[n] = T(target);
+                r[n] = p[n];
             }
         }
+        linearToSRGBBatch(row.get(), row.get(), w * N);
+        for (size_t i = 0, c = w * N; i < c; ++i, ++d) {
+            *d = T(math::saturate(row[i]) * std::numeric_limits<T>::max());
+        }
     }
     return dst;
 }
@@ -229,22 +319,64 @@ std::unique_ptr<uint8_t[]> fromLinearToGrayscale(const LinearImage& image) {
     return dst;
 }
 
-// Constructs a 3-channel LinearImage from an untyped data blob.
+// Converts an untyped data blob into the given 3-channel image, which may be a strided view
+// into a larger image; this is how the decoders stream bands of rows into their destination.
 // The "proc" lambda converts a single color component into a float.
 // The "transform" lambda performs an arbitrary float-to-float transformation.
 template<typename T, typename PROCESS, typename TRANSFORM>
-static LinearImage toLinear(size_t w, size_t h, size_t bpr,
-            const uint8_t* src, PROCESS proc, TRANSFORM transform) {
-    LinearImage result((uint32_t) w, (uint32_t) h, 3);
-    auto d = result.get<math::float3>();
+static void toLinearInto(LinearImage& target, size_t bpr,
+        const uint8_t* src, PROCESS proc, TRANSFORM transform) {
+    assert(target.getChannels() == 3);
+    const size_t w = target.getWidth();
+    const size_t h = target.getHeight();
     for (size_t y = 0; y < h; ++y) {
         T const* p = reinterpret_cast<T const*>(src + y * bpr);
+        auto d = reinterpret_cast<math::float3*>(target.getPixelRef(0, (uint32_t) y));
         for (size_t x = 0; x < w; ++x, p += 3) {
             math::float3 sRGB(proc(p[0]), proc(p[1]), proc(p[2]));
             sRGB /= std::numeric_limits<T>::max();
-            *d++ = transform(sRGB);
+            d[x] = transform(sRGB);
+        }
+    }
+}
+
+// Like toLinearInto()/toLinearWithAlphaInto() with the sRGB decoding transform, but
+// through the lookup table instead of a std::pow per component -- this is the path
+// the decoders use for sRGB sources. Handles 3- and 4-channel targets (a 4th channel
+// is treated as alpha and scaled linearly). The "proc" lambda converts a single color
+// component into a T, e.g. for endian swaps.
+template<typename T, typename PROCESS>
+static void sRGBToLinearInto(LinearImage& target, size_t bpr,
+        const uint8_t* src, PROCESS proc) {
+    static_assert(std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value,
+            "sRGBToLinearInto expects 8- or 16-bit sources");
+    const size_t channels = target.getChannels();
+    assert(channels == 3 || channels == 4);
+    const float* UTILS_RESTRICT lut = getSRGBToLinearLUT();
+    const size_t w = target.getWidth();
+    const size_t h = target.getHeight();
+    for (size_t y = 0; y < h; ++y) {
+        T const* p = reinterpret_cast<T const*>(src + y * bpr);
+        float* d = target.getPixelRef(0, (uint32_t) y);
+        for (size_t x = 0; x < w; ++x, p += channels, d += channels) {
+            d[0] = sRGBToLinearLookup(lut, T(proc(p[0])));
+            d[1] = sRGBToLinearLookup(lut, T(proc(p[1])));
+            d[2] = sRGBToLinearLookup(lut, T(proc(p[2])));
+            if (channels == 4) {
+                d[3] = float(proc(p[3])) * (1.0f / std::numeric_limits<T>::max());
+            }
         }
     }
+}
+
+// Constructs a 3-channel LinearImage from an untyped data blob.
+// The "proc" lambda converts a single color component into a float.
+// The "transform" lambda performs an arbitrary float-to-float transformation.
+template<typename T, typename PROCESS, typename TRANSFORM>
+static LinearImage toLinear(size_t w, size_t h, size_t bpr,
+            const uint8_t* src, PROCESS proc, TRANSFORM transform) {
+    LinearImage result((uint32_t) w, (uint32_t) h, 3);
+    toLinearInto<T>(result, bpr, src, proc, transform);
     return result;
 }
 
@@ -257,22 +389,35 @@ static LinearImage toLinear(size_t w, size_t h, size_t bpr,
     return toLinear<T>(w, h, bpr, src.get(), proc, transform);
 }
 
-// Constructs a 4-channel LinearImage from an untyped data blob.
+// Converts an untyped data blob into the given 4-channel image (possibly a strided view);
+// see toLinearInto.
 // The "proc" lambda converts a single color component into a float.
 // the "transform" lambda performs an arbitrary float-to-float transformation.
 template<typename T, typename PROCESS, typename TRANSFORM>
-static LinearImage toLinearWithAlpha(size_t w, size_t h, size_t bpr,
+static void toLinearWithAlphaInto(LinearImage& target, size_t bpr,
         const uint8_t* src, PROCESS proc, TRANSFORM transform) {
-    LinearImage result((uint32_t) w, (uint32_t) h, 4);
-    auto d = result.get<math::float4>();
+    assert(target.getChannels() == 4);
+    const size_t w = target.getWidth();
+    const size_t h = target.getHeight();
     for (size_t y = 0; y < h; ++y) {
         T const* p = reinterpret_cast<T const*>(src + y * bpr);
+        auto d = reinterpret_cast<math::float4*>(target.getPixelRef(0, (uint32_t) y));
         for (size_t x = 0; x < w; ++x, p += 4) {
             math::float4 sRGB(proc(p[0]), proc(p[1]), proc(p[2]), proc(p[3]));
             sRGB /= std::numeric_limits<T>::max();
-            *d++ = transform(sRGB);
+            d[x] = transform(sRGB);
         }
     }
+}
+
+// Constructs a 4-channel LinearImage from an untyped data blob.
+// The "proc" lambda converts a single color component into a float.
+// the "transform" lambda performs an arbitrary float-to-float transformation.
+template<typename T, typename PROCESS, typename TRANSFORM>
+static LinearImage toLinearWithAlpha(size_t w, size_t h, size_t bpr,
+        const uint8_t* src, PROCESS proc, TRANSFORM transform) {
+    LinearImage result((uint32_t) w, (uint32_t) h, 4);
+    toLinearWithAlphaInto<T>(result, bpr, src, proc, transform);
     return result;
 }
 
@@ -53,6 +53,10 @@ LinearImage transpose(const LinearImage& image);
 // The boundary is specified as Left Top Right Bottom.
 LinearImage cropRegion(const LinearImage& image, uint32_t l, uint32_t t, uint32_t r, uint32_t b);
 
+// Zero-copy equivalent of cropRegion: returns a strided view over the crop window that shares
+// pixel ownership with the source image. All operations in this header accept such views.
+LinearImage cropRegionView(LinearImage& image, uint32_t l, uint32_t t, uint32_t r, uint32_t b);
+
 // Lexicographically compares two images, similar to memcmp.
 int compare(const LinearImage& a, const LinearImage& b, float epsilon = 0.0f);
 
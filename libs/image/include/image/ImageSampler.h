@@ -110,6 +110,15 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         Filter filter = Filter::DEFAULT);
 
+/**
+ * Resamples only the target-space rectangle [x0, x1) x [y0, y1) of what resampleImage(source,
+ * width, height, filter) would produce, returning it as a (x1-x0) x (y1-y0) image. The pixels are
+ * bit-identical to the corresponding rectangle of the full resample, which makes this suitable
+ * for incrementally re-cooking a damaged region of a large atlas.
+ */
+LinearImage resampleImageRegion(const LinearImage& source, uint32_t width, uint32_t height,
+        Filter filter, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
 /**
  * Computes a single sample for the given texture coordinate and writes the resulting color
  * components into the given output holder.
@@ -20,6 +20,10 @@
 #include <cstdint>
 #include <memory>
 
+namespace utils {
+class JobSystem;
+}
+
 namespace image {
 
 struct KtxInfo {
@@ -84,6 +88,34 @@ public:
      */
     bool serialize(uint8_t* destination, uint32_t numBytes) const;
 
+    /**
+     * Enables or disables zlib compression of the blob data in serialize().
+     *
+     * Blobs are deflated individually with a dictionary shared across the whole bundle, so they
+     * can be re-inflated in any order (and in parallel). Block-compressed texture data is quite
+     * redundant across mips and faces, so environment maps typically shrink 3x or more.
+     *
+     * Note that the resulting stream is no longer a conformant KTX file; it can only be read
+     * back with the deserializing constructor, which detects compression automatically.
+     */
+    void setCompression(bool enabled);
+
+    /**
+     * Returns true if serialize() will compress blob data (see setCompression). This is set
+     * automatically when deserializing a compressed bundle.
+     */
+    bool isCompressed() const { return mCompression; }
+
+    /**
+     * Inflates all blobs that have not yet been decoded, spreading the work across the given
+     * JobSystem. Returns false if any blob fails to decode.
+     *
+     * Compressed blobs are normally decoded lazily, one at a time, when first accessed through
+     * getBlob(). Calling this from a worker thread instead lets the decode overlap other work
+     * (e.g. the GPU upload of blobs that are already available).
+     */
+    bool decompress(utils::JobSystem& js);
+
     /**
      * Computes the size (in bytes) of the serialized bundle.
      */
@@ -118,7 +150,8 @@ public:
 
     /**
      * Retrieves a weak reference to a given data blob. Returns false if the given blob index is out
-     * of bounds, or if the blob at the given index is empty.
+     * of bounds, or if the blob at the given index is empty. If the bundle was deserialized from a
+     * compressed stream, the blob is inflated on first access (see setCompression).
      */
     bool getBlob(KtxBlobIndex index, uint8_t** data, uint32_t* size) const;
 
@@ -203,6 +236,7 @@ private:
     uint32_t mNumMipLevels;
     uint32_t mArrayLength;
     uint32_t mNumCubeFaces;
+    bool mCompression = false;
     std::unique_ptr<KtxBlobList> mBlobs;
     std::unique_ptr<KtxMetadata> mMetadata;
 };
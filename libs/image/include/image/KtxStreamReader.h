@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_KTXSTREAMREADER_H
+#define IMAGE_KTXSTREAMREADER_H
+
+#include <image/KtxBundle.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace image {
+
+/**
+ * KtxStreamReader provides read-only access to a KTX file without loading it into memory.
+ *
+ * Unlike KtxBundle, which deserializes the whole byte stream into owned storage, the reader
+ * memory-maps the file and hands out blob views pointing straight into the mapping; pages are
+ * faulted in by the OS as each blob is actually consumed. This bounds the cost of opening
+ * multi-gigabyte texture sets by what is actually uploaded.
+ *
+ * Mip levels are intended to be uploaded smallest-first (the "mip tail"): upload the levels
+ * returned by getMipUploadOrder() one (or a few) per frame via Texture::setImage(), setting
+ * the texture's base/max level as the larger mips stream in. A texture thus becomes usable
+ * after a bounded amount of I/O regardless of asset size.
+ *
+ * The returned blob pointers remain valid for the lifetime of the reader.
+ */
+class KtxStreamReader {
+public:
+
+    /**
+     * Maps the given KTX file. Check isValid() before using the reader; it fails if the
+     * file can't be opened, is truncated, or doesn't carry the KTX identifier.
+     */
+    explicit KtxStreamReader(const char* path);
+
+    ~KtxStreamReader();
+
+    KtxStreamReader(KtxStreamReader const&) = delete;
+    KtxStreamReader& operator=(KtxStreamReader const&) = delete;
+
+    bool isValid() const { return mMapping != nullptr; }
+
+    /**
+     * Information about the texture object, such as format and type.
+     */
+    KtxInfo const& getInfo() const { return mInfo; }
+
+    /**
+     * Gets the number of miplevels (this is never zero).
+     */
+    uint32_t getNumMipLevels() const { return mNumMipLevels; }
+
+    /**
+     * Gets the number of array elements (this is never zero).
+     */
+    uint32_t getArrayLength() const { return mArrayLength; }
+
+    /**
+     * Returns whether or not this is a cubemap.
+     */
+    bool isCubemap() const { return mNumCubeFaces > 1; }
+
+    /**
+     * Retrieves a view into the mapped file for the given blob; no copy is made. Returns
+     * false if the given blob index is out of bounds.
+     */
+    bool getBlob(KtxBlobIndex index, uint8_t const** data, uint32_t* size) const;
+
+    /**
+     * The i-th mip level to upload (i in [0, getNumMipLevels())), smallest level first.
+     */
+    uint32_t getMipUploadOrder(uint32_t i) const { return mNumMipLevels - 1 - i; }
+
+    /**
+     * Retrieves a value from the key/value metadata, or null if the key doesn't exist.
+     * The returned pointer is a view into the mapped file and is not null-terminated;
+     * use valueSize.
+     */
+    const char* getMetadata(const char* key, size_t* valueSize = nullptr) const;
+
+private:
+    KtxInfo mInfo = {};
+    uint32_t mNumMipLevels = 1;
+    uint32_t mArrayLength = 1;
+    uint32_t mNumCubeFaces = 1;
+
+    // the mapped file
+    uint8_t const* mMapping = nullptr;
+    size_t mMappingSize = 0;
+    int mFd = -1;
+    bool mOwnsMemory = false;   // true when mmap isn't available and we fell back to read()
+
+    // key/value metadata region (view into the mapping)
+    uint8_t const* mMetadata = nullptr;
+    uint32_t mMetadataSize = 0;
+
+    // per-mip offset (from the start of the mapping) and per-blob size
+    uint64_t* mMipOffsets = nullptr;
+    uint32_t* mFaceSizes = nullptr;
+};
+
+} // namespace image
+
+#endif // IMAGE_KTXSTREAMREADER_H
@@ -36,8 +36,8 @@ namespace image {
  * the image object without incurring a deep copy. Shared access to pixels is not thread safe.
  *
  * By convention, we do not use channel major order (i.e. planar). However we provide a free
- * function in ImageOps to combine planar data. Pixels are stored such that the row stride is simply
- * width * channels * sizeof(float).
+ * function in ImageOps to combine planar data. For images that own their pixels, the row stride is
+ * simply width * channels * sizeof(float); strided views (see createView) may have a larger one.
  */
 class LinearImage {
 public:
@@ -45,7 +45,9 @@ public:
     ~LinearImage();
 
     /**
-     * Allocates a zeroed-out image.
+     * Allocates a zeroed-out image. The pixel buffer is drawn from a process-wide pool (see
+     * purgePixelBufferPool), so filter chains that repeatedly allocate and free intermediate
+     * images of the same sizes stop hitting the heap after the first pass.
      */
     LinearImage(uint32_t width, uint32_t height, uint32_t channels);
 
@@ -60,6 +62,21 @@ public:
      */
     LinearImage() : mDataRef(nullptr), mData(nullptr), mWidth(0), mHeight(0), mChannels(0) {}
 
+    /**
+     * Wraps caller-owned pixel data in a non-owning view. The row stride is expressed in floats
+     * (not pixels or bytes) and must be at least width * channels; pass 0 for tightly packed
+     * rows. The caller must keep the data alive and valid for the lifetime of the view and of
+     * any copies made of it.
+     */
+    static LinearImage createView(float* pixels, uint32_t width, uint32_t height,
+            uint32_t channels, uint32_t rowStride = 0);
+
+    /**
+     * Creates a strided view of a window of this image, sharing ownership of the pixel data.
+     * Nothing is copied: writes through the view are visible in the source image.
+     */
+    LinearImage createView(uint32_t left, uint32_t top, uint32_t width, uint32_t height) const;
+
     /**
      * Gets a pointer to the underlying pixel data.
      */
@@ -76,7 +93,7 @@ public:
      * Gets a pointer to the pixel data at the given column and row. (not bounds checked)
      */
     float* getPixelRef(uint32_t column, uint32_t row) {
-        return mData + (column + row * mWidth) * mChannels;
+        return mData + column * mChannels + row * mRowStride;
     }
 
     template<typename T>
@@ -88,7 +105,7 @@ public:
      * Gets a pointer to the immutable pixel data at the given column and row. (not bounds checked)
      */
     float const* getPixelRef(uint32_t column, uint32_t row) const {
-        return mData + (column + row * mWidth) * mChannels;
+        return mData + column * mChannels + row * mRowStride;
     }
 
     template<typename T>
@@ -99,6 +116,13 @@ public:
     uint32_t getWidth() const { return mWidth; }
     uint32_t getHeight() const { return mHeight; }
     uint32_t getChannels() const { return mChannels; }
+
+    /**
+     * Gets the number of floats between successive rows; this equals width * channels unless the
+     * image is a strided view. Rows are contiguous only when the two are equal.
+     */
+    uint32_t getRowStride() const { return mRowStride; }
+
     void reset() { *this = LinearImage(); }
     bool isValid() const { return mData; }
 
@@ -111,8 +135,15 @@ private:
     uint32_t mWidth;
     uint32_t mHeight;
     uint32_t mChannels;
+    uint32_t mRowStride = 0;
 };
 
+/**
+ * Frees the pixel buffers that are being retained for reuse by subsequent image allocations.
+ * Useful for tools that want to release memory after a large batch of filtering work.
+ */
+void purgePixelBufferPool();
+
 } // namespace image
 
 #endif /* IMAGE_LINEARIMAGE_H */
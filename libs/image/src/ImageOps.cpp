@@ -60,7 +60,7 @@ LinearImage horizontalStack(const LinearImage* first, size_t count) {
         for (size_t c = 0; c < count; ++c) {
             const auto& img = first[c];
             uint32_t swidth = img.getWidth();
-            float const* src = img.getPixelRef() + row * swidth * nchannels;
+            float const* src = img.getPixelRef(0, row);
             memcpy(dst, src, swidth * nchannels * sizeof(float));
             dst += swidth * nchannels;
         }
@@ -121,10 +121,12 @@ LinearImage vectorsToColors(const LinearImage& image) {
     ASSERT_PRECONDITION(image.getChannels() == 3, "Must be a 3-channel image.");
     const uint32_t width = image.getWidth(), height = image.getHeight();
     LinearImage result(width, height, 3);
-    auto src = (float3 const*) image.getPixelRef();
-    auto dst = (float3*) result.getPixelRef();
-    for (uint32_t n = 0, end = width * height; n < end; ++n) {
-        dst[n] = 0.5f * (src[n] + float3(1));
+    for (uint32_t row = 0; row < height; ++row) {
+        auto src = (float3 const*) image.getPixelRef(0, row);
+        auto dst = (float3*) result.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col) {
+            dst[col] = 0.5f * (src[col] + float3(1));
+        }
     }
     return result;
 }
@@ -133,10 +135,12 @@ LinearImage colorsToVectors(const LinearImage& image) {
     ASSERT_PRECONDITION(image.getChannels() == 3, "Must be a 3-channel image.");
     const uint32_t width = image.getWidth(), height = image.getHeight();
     LinearImage result(width, height, 3);
-    auto src = (float3 const*) image.getPixelRef();
-    auto dst = (float3*) result.getPixelRef();
-    for (uint32_t n = 0, end = width * height; n < end; ++n) {
-        dst[n] = 2.0f * src[n] - float3(1);
+    for (uint32_t row = 0; row < height; ++row) {
+        auto src = (float3 const*) image.getPixelRef(0, row);
+        auto dst = (float3*) result.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col) {
+            dst[col] = 2.0f * src[col] - float3(1);
+        }
     }
     return result;
 }
@@ -146,10 +150,12 @@ LinearImage extractChannel(const LinearImage& source, uint32_t channel) {
     const uint32_t nchan = source.getChannels();
     ASSERT_PRECONDITION(channel < nchan, "Channel is out of range.");
     LinearImage result(width, height, 1);
-    auto src = source.getPixelRef();
-    auto dst = result.getPixelRef();
-    for (uint32_t n = 0, npixels = width * height; n < npixels; ++n, ++dst, src += nchan) {
-        dst[0] = src[channel];
+    for (uint32_t row = 0; row < height; ++row) {
+        auto src = source.getPixelRef(0, row);
+        auto dst = result.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col, ++dst, src += nchan) {
+            dst[0] = src[channel];
+        }
     }
     return result;
 }
@@ -170,15 +176,13 @@ LinearImage combineChannels(LinearImage const* img, size_t count) {
         ASSERT_PRECONDITION(plane.getChannels() == 1, "Planes must be single channel.");
     }
     LinearImage result(width, height, (uint32_t) count);
-    float* dst = result.getPixelRef();
-    uint32_t sindex = 0, dindex = 0;
-    while (dindex < width * height * count) {
-        for (size_t c = 0; c < count; ++c, ++dindex) {
-            const LinearImage& plane = img[c];
-            float const* src = plane.getPixelRef();
-            dst[dindex] = src[sindex];
+    for (uint32_t row = 0; row < height; ++row) {
+        float* dst = result.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col) {
+            for (size_t c = 0; c < count; ++c, ++dst) {
+                dst[0] = img[c].getPixelRef(col, row)[0];
+            }
         }
-        ++sindex;
     }
     return result;
 }
@@ -193,15 +197,13 @@ LinearImage transpose(const LinearImage& image) {
     const uint32_t height = image.getHeight();
     const uint32_t channels = image.getChannels();
     LinearImage result(height, width, channels);
-    float const* source = image.getPixelRef();
-    float* target = result.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
-        const uint32_t i = n / width;
-        const uint32_t j = n % width;
-        float const* src = source + channels * n;
-        float* dst = target + channels * (height * j + i);
-        for (uint32_t c = 0; c < channels; ++c) {
-            dst[c] = src[c];
+    for (uint32_t row = 0; row < height; ++row) {
+        float const* src = image.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col, src += channels) {
+            float* dst = result.getPixelRef(row, col);
+            for (uint32_t c = 0; c < channels; ++c) {
+                dst[c] = src[c];
+            }
         }
     }
     return result;
@@ -213,16 +215,19 @@ LinearImage cropRegion(const LinearImage& image, uint32_t left, uint32_t top, ui
     uint32_t height = bottom - top;
     uint32_t channels = image.getChannels();
     LinearImage result(width, height, channels);
-    float const* source = image.getPixelRef(left, top);
     float* target = result.getPixelRef();
     for (int32_t row = 0; row < height; ++row) {
-        memcpy(target, source, width * channels * sizeof(float));
+        memcpy(target, image.getPixelRef(left, top + row), width * channels * sizeof(float));
         target += width * channels;
-        source += image.getWidth() * channels;
     }
     return result;
 }
 
+LinearImage cropRegionView(LinearImage& image, uint32_t left, uint32_t top, uint32_t right,
+        uint32_t bottom) {
+    return image.createView(left, top, right - left, bottom - top);
+}
+
 int compare(const LinearImage& a, const LinearImage& b, float epsilon) {
     auto w = a.getWidth();
     auto h = a.getHeight();
@@ -230,10 +235,18 @@ int compare(const LinearImage& a, const LinearImage& b, float epsilon) {
     if (b.getWidth() != w || b.getHeight() != h || b.getChannels() != c) {
         return -1;
     }
-    float const* adata = a.getPixelRef();
-    float const* bdata = b.getPixelRef();
-    return std::lexicographical_compare(adata, adata + w * h * c, bdata, bdata + w * h * c,
-            [epsilon](float x, float y) { return x < y - epsilon; });
+    const auto less = [epsilon](float x, float y) { return x < y - epsilon; };
+    for (uint32_t row = 0; row < h; ++row) {
+        float const* adata = a.getPixelRef(0, row);
+        float const* bdata = b.getPixelRef(0, row);
+        if (std::lexicographical_compare(adata, adata + w * c, bdata, bdata + w * c, less)) {
+            return 1;
+        }
+        if (std::lexicographical_compare(bdata, bdata + w * c, adata, adata + w * c, less)) {
+            return 0;
+        }
+    }
+    return 0;
 }
 
 } // namespace image
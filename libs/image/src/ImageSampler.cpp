@@ -17,11 +17,20 @@
 #include <image/ImageSampler.h>
 #include <image/ImageOps.h>
 
+#include <math/compiler.h>
 #include <math/vec3.h>
 #include <utils/Panic.h>
 #include <utils/CString.h>
 
+#if defined(MATH_HAS_NEON)
+#include <arm_neon.h>
+#elif defined(MATH_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
 #include <memory>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 
@@ -169,6 +178,21 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
+// Drops every instruction whose target index lies outside [lo, hi) and rebases the remaining
+// target indices onto the window. Because the weights come from the full-size program, executing
+// the windowed program reproduces the corresponding slice of the full result bit-for-bit.
+void windowMadProgram(uint32_t lo, uint32_t hi, MadProgram* program) {
+    MadProgram result;
+    result.reserve(program->size());
+    for (auto mad : *program) {
+        if (mad.targetIndex >= lo && mad.targetIndex < hi) {
+            mad.targetIndex -= lo;
+            result.push_back(mad);
+        }
+    }
+    program->swap(result);
+}
+
 // Transforms a MAD program intended for single-channel data into a program intended for
 // multi-channel data.
 void expandMadProgram(uint32_t nchannels, MadProgram* program) {
@@ -187,6 +211,89 @@ void expandMadProgram(uint32_t nchannels, MadProgram* program) {
     program->swap(result);
 }
 
+// Runs the given row function over [0, nrows), handing each thread a contiguous band of rows.
+// Every row is processed by exactly one thread and rows are independent of each other, so the
+// result is bit-identical to the serial loop no matter how the rows get distributed.
+template<typename ROWFUNC>
+void forEachRowBand(uint32_t nrows, size_t workPerRow, ROWFUNC func) {
+    // Threading only pays off on large images; this cutoff keeps small mip levels and
+    // single-sample queries on the calling thread.
+    constexpr size_t MIN_WORK_PER_THREAD = 64 * 1024;
+    uint32_t nthreads = std::thread::hardware_concurrency();
+    nthreads = uint32_t(std::min<size_t>(nthreads, workPerRow * nrows / MIN_WORK_PER_THREAD));
+    nthreads = std::min(nthreads, nrows);
+    if (nthreads <= 1) {
+        func(0, nrows);
+        return;
+    }
+    const uint32_t band = (nrows + nthreads - 1) / nthreads;
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (uint32_t t = 0; t < nthreads; ++t) {
+        const uint32_t startRow = t * band;
+        const uint32_t endRow = std::min(startRow + band, nrows);
+        threads.emplace_back([func, startRow, endRow] { func(startRow, endRow); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Executes a single-channel MAD program over one row of 4-channel data, processing the four
+// channels in a single vector operation. Each channel accumulates in exactly the same order as
+// the scalar loop over the expanded program, so the results are bit-identical (we deliberately
+// use separate multiply and add so the rounding matches the scalar code).
+void executeMadRow4(const MadProgram& program, float const* source, float* target) {
+#if defined(MATH_HAS_NEON)
+    for (auto mad : program) {
+        float32x4_t s = vld1q_f32(source + mad.sourceIndex * 4);
+        float32x4_t t = vld1q_f32(target + mad.targetIndex * 4);
+        t = vaddq_f32(t, vmulq_n_f32(s, mad.weight));
+        vst1q_f32(target + mad.targetIndex * 4, t);
+    }
+#elif defined(MATH_HAS_SSE2)
+    for (auto mad : program) {
+        __m128 s = _mm_loadu_ps(source + mad.sourceIndex * 4);
+        __m128 t = _mm_loadu_ps(target + mad.targetIndex * 4);
+        t = _mm_add_ps(t, _mm_mul_ps(s, _mm_set1_ps(mad.weight)));
+        _mm_storeu_ps(target + mad.targetIndex * 4, t);
+    }
+#else
+    for (auto mad : program) {
+        float const* s = source + mad.sourceIndex * 4;
+        float* t = target + mad.targetIndex * 4;
+        for (uint32_t c = 0; c < 4; ++c) {
+            t[c] += s[c] * mad.weight;
+        }
+    }
+#endif
+}
+
+// 4-channel variant of the MIN filter kernel; see executeMadRow4.
+void executeMinRow4(const MadProgram& program, float const* source, float* target) {
+#if defined(MATH_HAS_NEON)
+    for (auto mad : program) {
+        float32x4_t s = vld1q_f32(source + mad.sourceIndex * 4);
+        float32x4_t t = vld1q_f32(target + mad.targetIndex * 4);
+        vst1q_f32(target + mad.targetIndex * 4, vminq_f32(s, t));
+    }
+#elif defined(MATH_HAS_SSE2)
+    for (auto mad : program) {
+        __m128 s = _mm_loadu_ps(source + mad.sourceIndex * 4);
+        __m128 t = _mm_loadu_ps(target + mad.targetIndex * 4);
+        _mm_storeu_ps(target + mad.targetIndex * 4, _mm_min_ps(s, t));
+    }
+#else
+    for (auto mad : program) {
+        float const* s = source + mad.sourceIndex * 4;
+        float* t = target + mad.targetIndex * 4;
+        for (uint32_t c = 0; c < 4; ++c) {
+            t[c] = std::min(s[c], t[c]);
+        }
+    }
+#endif
+}
+
 FilterFunction createFilterFunction(Filter ftype) {
     FilterFunction fn;
     switch (ftype) {
@@ -207,56 +314,92 @@ FilterFunction createFilterFunction(Filter ftype) {
 void normalize(LinearImage& image) {
     ASSERT_PRECONDITION(image.getChannels() == 3, "Must be a 3-channel image.");
     const uint32_t width = image.getWidth(), height = image.getHeight();
-    auto vecs = (math::float3*) image.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
-        vecs[n] = normalize(vecs[n]);
+    for (uint32_t row = 0; row < height; ++row) {
+        auto vecs = (math::float3*) image.getPixelRef(0, row);
+        for (uint32_t col = 0; col < width; ++col) {
+            vecs[col] = normalize(vecs[col]);
+        }
     }
 }
 
+// The optional [wx0, wx1) window restricts the output to that range of target columns (the full
+// width when wx1 is 0); the resulting pixels are bit-identical to the same columns of the
+// unwindowed resample.
 LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
+        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier,
+        uint32_t wx0 = 0, uint32_t wx1 = 0) {
     const uint32_t swidth = source.getWidth();
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
     const bool mag = twidth > swidth;
     if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
     const FilterFunction hfn = createFilterFunction(filter);
+    if (wx1 == 0) wx1 = twidth;
 
-    // Generate a flat list of multiply-add (MAD) instructions.
+    // Generate a flat list of multiply-add (MAD) instructions. Four-channel images keep the
+    // single-channel program and process channels with the vector kernels; any other channel
+    // count gets the program expanded for the generic scalar loop.
     program->clear();
     generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
+    if (wx0 != 0 || wx1 != twidth) {
+        windowMadProgram(wx0, wx1, program);
+    }
+    const uint32_t owidth = wx1 - wx0;
+    const bool vectorized = nchan == 4;
+    if (!vectorized) {
+        expandMadProgram(nchan, program);
+    }
+    const size_t workPerRow = program->size() * (vectorized ? 4 : 1);
 
-    // Allocate the target image.
-    LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
+    // Allocate the target image. The source may be a strided view, so rows are walked with its
+    // row stride; the freshly allocated target is always tightly packed.
+    LinearImage result(owidth, sheight, nchan);
+    const size_t sstride = source.getRowStride();
+    float const* sourcePixels = source.getPixelRef();
+    float* targetPixels = result.getPixelRef();
 
     // The MIN filter is special because it starts with non-zero values and ignores filter weights.
     if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
+        for (uint32_t n = 0; n < owidth * sheight * nchan; ++n) {
+            targetPixels[n] = std::numeric_limits<float>::max();
         }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
+        forEachRowBand(sheight, workPerRow, [&](uint32_t startRow, uint32_t endRow) {
+            float const* sourceRow = sourcePixels + size_t(startRow) * sstride;
+            float* targetRow = targetPixels + size_t(startRow) * owidth * nchan;
+            for (uint32_t row = startRow; row < endRow; ++row) {
+                if (vectorized) {
+                    executeMinRow4(*program, sourceRow, targetRow);
+                } else {
+                    for (auto mad : *program) {
+                        const float a = sourceRow[mad.sourceIndex];
+                        const float b = targetRow[mad.targetIndex];
+                        targetRow[mad.targetIndex] = std::min(a, b);
+                    }
+                }
+                targetRow += owidth * nchan;
+                sourceRow += sstride;
             }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
-        }
+        });
         return result;
     }
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+    // Resize the image horizontally by executing the MAD instructions over each row. Rows are
+    // independent, so bands of rows are farmed out to worker threads on large images.
+    forEachRowBand(sheight, workPerRow, [&](uint32_t startRow, uint32_t endRow) {
+        float const* sourceRow = sourcePixels + size_t(startRow) * sstride;
+        float* targetRow = targetPixels + size_t(startRow) * owidth * nchan;
+        for (uint32_t row = startRow; row < endRow; ++row) {
+            if (vectorized) {
+                executeMadRow4(*program, sourceRow, targetRow);
+            } else {
+                for (auto mad : *program) {
+                    targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+                }
+            }
+            targetRow += owidth * nchan;
+            sourceRow += sstride;
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
-    }
+    });
 
     // Perform post processing for the current pass.
     if (filter == Filter::GAUSSIAN_NORMALS) {
@@ -302,6 +445,19 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     });
 }
 
+LinearImage resampleImageRegion(const LinearImage& source, uint32_t width, uint32_t height,
+        Filter filter, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    ASSERT_PRECONDITION(x0 < x1 && x1 <= width && y0 < y1 && y1 <= height,
+            "Invalid target rectangle.");
+    // Both passes build the program for the full-size target and then window it, so the weights
+    // (and therefore the output pixels) are exactly those of the full-size resample.
+    MadProgram program;
+    LinearImage result;
+    result = transpose(resampleImage1D(source, &program, width, filter, 0, 1, 1, x0, x1));
+    result = transpose(resampleImage1D(result, &program, height, filter, 0, 1, 1, y0, y1));
+    return result;
+}
+
 void computeSingleSample(const LinearImage& source, float x, float y, SingleSample* result,
         Filter filter) {
     const float radius = 1.0f;
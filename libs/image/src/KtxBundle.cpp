@@ -16,8 +16,12 @@
 
 #include <image/KtxBundle.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
+#include <zlib.h>
+
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -44,6 +48,57 @@ inline size_t flatten(const image::KtxBundle* bundle, image::KtxBlobIndex index)
 
 const uint8_t MAGIC[] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
 
+// Metadata key (and value) that marks a serialized stream as having compressed blob data.
+const char* const COMPRESSION_KEY = "compression";
+const char* const COMPRESSION_SCHEME = "zlib";
+
+// The shared dictionary is capped to the deflate window size; anything larger can't be used.
+constexpr uint32_t DICTIONARY_MAX_SIZE = 32768;
+
+// Deflates a single blob with the given (possibly empty) preset dictionary.
+bool deflateBlob(const std::vector<uint8_t>& dictionary, uint8_t const* src, uint32_t srcSize,
+        std::vector<uint8_t>& dst) {
+    z_stream stream = {};
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    if (!dictionary.empty()) {
+        deflateSetDictionary(&stream, dictionary.data(), dictionary.size());
+    }
+    dst.resize(deflateBound(&stream, srcSize));
+    stream.next_in = const_cast<uint8_t*>(src);
+    stream.avail_in = srcSize;
+    stream.next_out = dst.data();
+    stream.avail_out = dst.size();
+    int error = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (error != Z_STREAM_END) {
+        return false;
+    }
+    dst.resize(stream.total_out);
+    return true;
+}
+
+// Inflates a single blob into dst, which must already have the exact decoded size.
+bool inflateBlob(const std::vector<uint8_t>& dictionary, uint8_t const* src, uint32_t srcSize,
+        uint8_t* dst, uint32_t dstSize) {
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = const_cast<uint8_t*>(src);
+    stream.avail_in = srcSize;
+    stream.next_out = dst;
+    stream.avail_out = dstSize;
+    int error = inflate(&stream, Z_FINISH);
+    if (error == Z_NEED_DICT && !dictionary.empty()) {
+        inflateSetDictionary(&stream, dictionary.data(), dictionary.size());
+        error = inflate(&stream, Z_FINISH);
+    }
+    inflateEnd(&stream);
+    return error == Z_STREAM_END && stream.total_out == dstSize;
+}
+
 }
 
 namespace image  {
@@ -60,6 +115,16 @@ struct KtxBlobList {
     std::vector<uint8_t> blobs;
     std::vector<uint32_t> sizes;
 
+    // Compressed payloads held until first access (each entry becomes empty once its blob has
+    // been decoded), along with their decoded sizes and the dictionary shared by every blob.
+    // These are only populated when deserializing a compressed bundle.
+    std::vector<std::vector<uint8_t>> compressed;
+    std::vector<uint32_t> uncompressedSizes;
+    std::vector<uint8_t> dictionary;
+
+    // Deflated payloads built on demand for serialization; dropped whenever a blob changes.
+    std::vector<std::vector<uint8_t>> deflated;
+
     // Obtains a pointer to the given blob.
     uint8_t* get(uint32_t blobIndex) {
         uint8_t* result = blobs.data();
@@ -94,6 +159,73 @@ struct KtxBlobList {
         sizes[blobIndex] = newSize;
         blobs.swap(newBlobs);
     }
+
+    // Returns true if the given blob still holds an undecoded compressed payload.
+    bool isCompressed(uint32_t blobIndex) const {
+        return blobIndex < compressed.size() && !compressed[blobIndex].empty();
+    }
+
+    // Inflates the given blob into the contiguous storage and drops its compressed payload.
+    bool decode(uint32_t blobIndex) {
+        resize(blobIndex, uncompressedSizes[blobIndex]);
+        if (!inflateBlob(dictionary, compressed[blobIndex].data(), compressed[blobIndex].size(),
+                get(blobIndex), sizes[blobIndex])) {
+            return false;
+        }
+        std::vector<uint8_t>().swap(compressed[blobIndex]);
+        return true;
+    }
+
+    bool decodeAll() {
+        for (uint32_t i = 0; i < compressed.size(); ++i) {
+            if (isCompressed(i) && !decode(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Deflates every blob (decoding pending ones first), building the shared dictionary from
+    // the coarsest miplevels: their content is highly representative of the finer mips, and
+    // since the flat blob order is mip-major we simply walk the list backwards.
+    bool ensureDeflated() {
+        if (!deflated.empty()) {
+            return true;
+        }
+        if (!decodeAll()) {
+            return false;
+        }
+        // The dictionary is stored verbatim in the stream, so cap it relative to the payload
+        // to avoid bloating small bundles.
+        size_t totalBlobSize = 0;
+        for (uint32_t size : sizes) {
+            totalBlobSize += size;
+        }
+        const size_t dictionarySize = std::min<size_t>(DICTIONARY_MAX_SIZE, totalBlobSize / 4);
+        dictionary.clear();
+        for (size_t i = sizes.size(); i-- > 0 && dictionary.size() < dictionarySize; ) {
+            uint8_t const* src = get(i);
+            size_t count = std::min<size_t>(sizes[i], dictionarySize - dictionary.size());
+            dictionary.insert(dictionary.end(), src, src + count);
+        }
+        deflated.resize(sizes.size());
+        for (uint32_t i = 0; i < sizes.size(); ++i) {
+            if (!deflateBlob(dictionary, get(i), sizes[i], deflated[i])) {
+                deflated.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Called when a blob is replaced: its pending compressed payload (if any) and the deflated
+    // serialization cache are both stale.
+    void invalidate(uint32_t blobIndex) {
+        if (blobIndex < compressed.size()) {
+            compressed[blobIndex].clear();
+        }
+        deflated.clear();
+    }
 };
 
 KtxBundle::~KtxBundle() = default;
@@ -149,6 +281,37 @@ KtxBundle::KtxBundle(uint8_t const* bytes, uint32_t nbytes) :
     const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
     const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
 
+    // If the stream was serialized with compression enabled, hold on to the compressed payloads
+    // and decode them lazily (see getBlob and decompress).
+    auto compression = mMetadata->keyvals.find(COMPRESSION_KEY);
+    mCompression = compression != mMetadata->keyvals.end() &&
+            compression->second == COMPRESSION_SCHEME;
+    if (mCompression) {
+        const uint32_t dictionarySize = *((uint32_t const*) pdata);
+        pdata += sizeof(uint32_t);
+        mBlobs->dictionary.assign(pdata, pdata + dictionarySize);
+        pdata += dictionarySize;
+        const uint32_t blobCount = mNumMipLevels * mArrayLength * mNumCubeFaces;
+        mBlobs->compressed.resize(blobCount);
+        mBlobs->uncompressedSizes.resize(blobCount);
+        for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
+            const uint32_t imageSize = *((uint32_t const*) pdata);
+            const uint32_t faceSize = isNonArrayCube ? imageSize : (imageSize / facesPerMip);
+            pdata += sizeof(uint32_t);
+            for (uint32_t layer = 0; layer < mArrayLength; ++layer) {
+                for (uint32_t face = 0; face < mNumCubeFaces; ++face) {
+                    const size_t flatIndex = flatten(this, {mipmap, layer, face});
+                    const uint32_t compressedSize = *((uint32_t const*) pdata);
+                    pdata += sizeof(uint32_t);
+                    mBlobs->uncompressedSizes[flatIndex] = faceSize;
+                    mBlobs->compressed[flatIndex].assign(pdata, pdata + compressedSize);
+                    pdata += compressedSize;
+                }
+            }
+        }
+        return;
+    }
+
     // Extract blobs from the serialized byte stream.
     const uint32_t totalSize = nbytes - (pdata - bytes);
     mBlobs->blobs.resize(totalSize);
@@ -219,6 +382,37 @@ bool KtxBundle::serialize(uint8_t* destination, uint32_t numBytes) const {
     const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
     const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
 
+    // With compression enabled, write the shared dictionary followed by each deflated payload,
+    // prefixed with its compressed size. The uncompressed "imageSize" fields are retained so
+    // that blob sizes can be recovered without inflating anything.
+    if (mCompression) {
+        if (!mBlobs->ensureDeflated()) {
+            return false;
+        }
+        const uint32_t dictionarySize = mBlobs->dictionary.size();
+        memcpy(pdata, &dictionarySize, sizeof(uint32_t));
+        pdata += sizeof(uint32_t);
+        memcpy(pdata, mBlobs->dictionary.data(), dictionarySize);
+        pdata += dictionarySize;
+        for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
+            const uint32_t faceSize = mBlobs->sizes[flatten(this, {mipmap, 0, 0})];
+            const uint32_t imageSize = isNonArrayCube ? faceSize : (faceSize * facesPerMip);
+            memcpy(pdata, &imageSize, sizeof(uint32_t));
+            pdata += sizeof(uint32_t);
+            for (uint32_t layer = 0; layer < mArrayLength; ++layer) {
+                for (uint32_t face = 0; face < mNumCubeFaces; ++face) {
+                    auto const& payload = mBlobs->deflated[flatten(this, {mipmap, layer, face})];
+                    const uint32_t compressedSize = payload.size();
+                    memcpy(pdata, &compressedSize, sizeof(uint32_t));
+                    pdata += sizeof(uint32_t);
+                    memcpy(pdata, payload.data(), compressedSize);
+                    pdata += compressedSize;
+                }
+            }
+        }
+        return true;
+    }
+
     // Extract blobs from the serialized byte stream.
     for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
 
@@ -253,6 +447,16 @@ uint32_t KtxBundle::getSerializedLength() const {
         const uint32_t kvpadding = 3 - ((kvsize + 3) % 4);
         total += sizeof(uint32_t) + kvsize + kvpadding;
     }
+    if (mCompression) {
+        ASSERT_PRECONDITION(mBlobs->ensureDeflated(), "Unable to compress blobs");
+        total += sizeof(uint32_t) + mBlobs->dictionary.size();
+        for (auto const& payload : mBlobs->deflated) {
+            total += sizeof(uint32_t) + payload.size();
+        }
+        total += mNumMipLevels * sizeof(uint32_t);
+        return total;
+    }
+    ASSERT_PRECONDITION(mBlobs->decodeAll(), "Unable to decode compressed blobs");
     for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
         total += sizeof(uint32_t);
         size_t blobSize = 0;
@@ -292,6 +496,10 @@ bool KtxBundle::getBlob(KtxBlobIndex index, uint8_t** data, uint32_t* size) cons
         return false;
     }
     uint32_t flatIndex = flatten(this, index);
+    // Decode lazily, so that clients only pay for the blobs they actually touch.
+    if (mBlobs->isCompressed(flatIndex) && !mBlobs->decode(flatIndex)) {
+        return false;
+    }
     auto blobSize = mBlobs->sizes[flatIndex];
     if (blobSize == 0) {
         return false;
@@ -307,6 +515,7 @@ bool KtxBundle::setBlob(KtxBlobIndex index, uint8_t const* data, uint32_t size)
         return false;
     }
     uint32_t flatIndex = flatten(this, index);
+    mBlobs->invalidate(flatIndex);
     uint32_t blobSize = mBlobs->sizes[flatIndex];
     if (blobSize != size) {
         mBlobs->resize(flatIndex, size);
@@ -321,9 +530,53 @@ bool KtxBundle::allocateBlob(KtxBlobIndex index, uint32_t size) {
         return false;
     }
     uint32_t flatIndex = flatten(this, index);
-    uint32_t blobSize = mBlobs->sizes[flatIndex];
+    mBlobs->invalidate(flatIndex);
     mBlobs->resize(flatIndex, size);
     return true;
 }
 
+void KtxBundle::setCompression(bool enabled) {
+    mCompression = enabled;
+    if (enabled) {
+        mMetadata->keyvals[COMPRESSION_KEY] = COMPRESSION_SCHEME;
+    } else {
+        mMetadata->keyvals.erase(COMPRESSION_KEY);
+    }
+}
+
+bool KtxBundle::decompress(utils::JobSystem& js) {
+    auto& blobList = *mBlobs;
+    if (blobList.compressed.empty()) {
+        return true;
+    }
+
+    // Size every pending blob up front: resizing rebuilds the contiguous storage, so it cannot
+    // overlap with the inflate jobs. Once done, each job writes to a disjoint region.
+    std::vector<uint32_t> pending;
+    for (uint32_t i = 0; i < blobList.compressed.size(); ++i) {
+        if (blobList.isCompressed(i)) {
+            blobList.resize(i, blobList.uncompressedSizes[i]);
+            pending.push_back(i);
+        }
+    }
+
+    std::atomic<bool> success(true);
+    utils::JobSystem::Job* parent = js.createJob();
+    for (uint32_t i : pending) {
+        js.run(utils::jobs::createJob(js, parent, [&blobList, &success, i]() {
+            auto const& payload = blobList.compressed[i];
+            if (!inflateBlob(blobList.dictionary, payload.data(), payload.size(),
+                    blobList.get(i), blobList.sizes[i])) {
+                success.store(false);
+            }
+        }));
+    }
+    js.runAndWait(parent);
+
+    for (uint32_t i : pending) {
+        std::vector<uint8_t>().swap(blobList.compressed[i]);
+    }
+    return success.load();
+}
+
 }  // namespace image
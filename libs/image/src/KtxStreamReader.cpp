@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/KtxStreamReader.h>
+
+#include <cstdio>
+#include <cstring>
+
+#if !defined(WIN32)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace {
+
+// same on-disk layout as KtxBundle's SerializationHeader
+struct KtxFileHeader {
+    uint8_t magic[12];
+    image::KtxInfo info;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxFileHeader) == 16 * 4, "Unexpected header size.");
+
+const uint8_t MAGIC[] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+
+}
+
+namespace image {
+
+KtxStreamReader::KtxStreamReader(const char* path) {
+    uint8_t const* bytes = nullptr;
+    size_t nbytes = 0;
+
+#if !defined(WIN32)
+    mFd = open(path, O_RDONLY);
+    if (mFd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(mFd, &st) < 0 || st.st_size < (off_t) sizeof(KtxFileHeader)) {
+        close(mFd);
+        mFd = -1;
+        return;
+    }
+    nbytes = (size_t) st.st_size;
+    void* mapping = mmap(nullptr, nbytes, PROT_READ, MAP_PRIVATE, mFd, 0);
+    if (mapping == MAP_FAILED) {
+        close(mFd);
+        mFd = -1;
+        return;
+    }
+    bytes = (uint8_t const*) mapping;
+#else
+    // no mmap on this platform; fall back to reading the whole file
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    nbytes = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (nbytes < sizeof(KtxFileHeader)) {
+        fclose(file);
+        return;
+    }
+    uint8_t* buffer = new uint8_t[nbytes];
+    if (fread(buffer, 1, nbytes, file) != nbytes) {
+        delete [] buffer;
+        fclose(file);
+        return;
+    }
+    fclose(file);
+    bytes = buffer;
+    mOwnsMemory = true;
+#endif
+
+    // "parse" the header by casting it to a struct
+    KtxFileHeader const* header = (KtxFileHeader const*) bytes;
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        goto fail;
+    }
+
+    {
+        mInfo = header->info;
+        mNumMipLevels = header->numberOfMipmapLevels ? header->numberOfMipmapLevels : 1;
+        mArrayLength = header->numberOfArrayElements ? header->numberOfArrayElements : 1;
+        mNumCubeFaces = header->numberOfFaces ? header->numberOfFaces : 1;
+
+        // the metadata is consumed in place, we only remember where it lives
+        mMetadata = bytes + sizeof(KtxFileHeader);
+        mMetadataSize = header->bytesOfKeyValueData;
+
+        // One aspect of the KTX spec is that the semantics differ for non-array cubemaps.
+        const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
+        const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
+
+        // walk the mip chain once to build the offset table; only the 4-byte imageSize
+        // field of each level is touched, so this faults in at most one page per level
+        mMipOffsets = new uint64_t[mNumMipLevels];
+        mFaceSizes = new uint32_t[mNumMipLevels];
+        uint64_t offset = sizeof(KtxFileHeader) + mMetadataSize;
+        for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
+            if (offset + sizeof(uint32_t) > nbytes) {
+                goto fail;
+            }
+            uint32_t imageSize;
+            memcpy(&imageSize, bytes + offset, sizeof(imageSize));
+            const uint32_t faceSize = isNonArrayCube ? imageSize : (imageSize / facesPerMip);
+            offset += sizeof(uint32_t);
+            mMipOffsets[mipmap] = offset;
+            mFaceSizes[mipmap] = faceSize;
+            offset += uint64_t(faceSize) * facesPerMip;
+            if (offset > nbytes) {
+                goto fail;
+            }
+        }
+    }
+
+    mMapping = bytes;
+    mMappingSize = nbytes;
+    return;
+
+fail:
+    delete [] mMipOffsets;
+    delete [] mFaceSizes;
+    mMipOffsets = nullptr;
+    mFaceSizes = nullptr;
+    if (mOwnsMemory) {
+        delete [] bytes;
+    } else {
+#if !defined(WIN32)
+        munmap(const_cast<uint8_t*>(bytes), nbytes);
+        close(mFd);
+        mFd = -1;
+#endif
+    }
+}
+
+KtxStreamReader::~KtxStreamReader() {
+    delete [] mMipOffsets;
+    delete [] mFaceSizes;
+    if (mOwnsMemory) {
+        delete [] mMapping;
+    } else if (mMapping) {
+#if !defined(WIN32)
+        munmap(const_cast<uint8_t*>(mMapping), mMappingSize);
+        close(mFd);
+#endif
+    }
+}
+
+bool KtxStreamReader::getBlob(KtxBlobIndex index, uint8_t const** data, uint32_t* size) const {
+    if (!isValid() || index.mipLevel >= mNumMipLevels || index.arrayIndex >= mArrayLength ||
+            index.cubeFace >= mNumCubeFaces) {
+        return false;
+    }
+    const uint32_t faceSize = mFaceSizes[index.mipLevel];
+    const uint32_t face = index.arrayIndex * mNumCubeFaces + index.cubeFace;
+    *data = mMapping + mMipOffsets[index.mipLevel] + uint64_t(face) * faceSize;
+    *size = faceSize;
+    return true;
+}
+
+const char* KtxStreamReader::getMetadata(const char* key, size_t* valueSize) const {
+    if (!isValid()) {
+        return nullptr;
+    }
+    // scan the key/value data in place; each entry is a 32-bit size followed by a
+    // null-terminated key and a binary value, padded to 4 bytes
+    const size_t keyLength = strlen(key);
+    uint8_t const* pdata = mMetadata;
+    uint8_t const* const end = mMetadata + mMetadataSize;
+    while (pdata + sizeof(uint32_t) <= end) {
+        uint32_t keyAndValueByteSize;
+        memcpy(&keyAndValueByteSize, pdata, sizeof(uint32_t));
+        pdata += sizeof(uint32_t);
+        if (pdata + keyAndValueByteSize > end) {
+            break;
+        }
+        if (keyAndValueByteSize > keyLength &&
+                memcmp(pdata, key, keyLength + 1) == 0) {
+            if (valueSize) {
+                *valueSize = keyAndValueByteSize - keyLength - 1;
+            }
+            return (const char*) (pdata + keyLength + 1);
+        }
+        pdata += keyAndValueByteSize;
+        pdata += 3 - ((keyAndValueByteSize + 3) % 4);
+    }
+    return nullptr;
+}
+
+}  // namespace image
@@ -18,15 +18,76 @@
 
 #include <cstring> // for memset
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// Process-wide recycler for pixel buffers. Filter chains continuously allocate and release
+// intermediate images of the same few sizes (e.g. each miplevel and its transpose), so after the
+// first pass through a chain every request is served from the free list. Buffers are recycled by
+// exact float count and the total retained size is capped, with overflow going back to the heap.
+class BufferPool {
+public:
+    // Deliberately leaked so that images destroyed during static destruction can still release
+    // their buffers safely.
+    static BufferPool& get() {
+        static BufferPool* pool = new BufferPool;
+        return *pool;
+    }
+
+    float* acquire(uint32_t nfloats) {
+        std::lock_guard<std::mutex> guard(mLock);
+        auto iter = mFreeList.find(nfloats);
+        if (iter != mFreeList.end()) {
+            float* buffer = iter->second;
+            mFreeList.erase(iter);
+            mRetainedFloats -= nfloats;
+            return buffer;
+        }
+        return new float[nfloats];
+    }
+
+    void release(uint32_t nfloats, float* buffer) {
+        std::lock_guard<std::mutex> guard(mLock);
+        if (mRetainedFloats + nfloats > MAX_RETAINED_FLOATS) {
+            delete[] buffer;
+            return;
+        }
+        mFreeList.insert({nfloats, buffer});
+        mRetainedFloats += nfloats;
+    }
+
+    void purge() {
+        std::lock_guard<std::mutex> guard(mLock);
+        for (auto& entry : mFreeList) {
+            delete[] entry.second;
+        }
+        mFreeList.clear();
+        mRetainedFloats = 0;
+    }
+
+private:
+    // 256 MiB, enough for the working set of a 4K mipgen chain.
+    static constexpr size_t MAX_RETAINED_FLOATS = 64 * 1024 * 1024;
+
+    std::mutex mLock;
+    std::unordered_multimap<uint32_t, float*> mFreeList;
+    size_t mRetainedFloats = 0;
+};
+
+} // anonymous namespace
 
 namespace image  {
 
 struct LinearImage::SharedReference {
     SharedReference(uint32_t width, uint32_t height, uint32_t channels) {
         const uint32_t nfloats = width * height * channels;
-        float* floats = new float[nfloats];
+        float* floats = BufferPool::get().acquire(nfloats);
         memset(floats, 0, sizeof(float) * nfloats);
-        pixels = std::shared_ptr<float>(floats, std::default_delete<float[]>());
+        pixels = std::shared_ptr<float>(floats, [nfloats](float* buffer) {
+            BufferPool::get().release(nfloats, buffer);
+        });
     }
     std::shared_ptr<float> pixels;
 };
@@ -38,19 +99,49 @@ LinearImage::~LinearImage() {
 LinearImage::LinearImage(uint32_t width, uint32_t height, uint32_t channels) :
     mDataRef(new SharedReference(width, height, channels)),
     mData(mDataRef->pixels.get()),
-    mWidth(width), mHeight(height), mChannels(channels) {}
+    mWidth(width), mHeight(height), mChannels(channels), mRowStride(width * channels) {}
 
 LinearImage::LinearImage(const LinearImage& that) {
     *this = that;
 }
 
 LinearImage& LinearImage::operator=(const LinearImage& that) {
-    mDataRef = that.mDataRef ? new SharedReference(*that.mDataRef) : nullptr;
+    if (this == &that) {
+        return *this;
+    }
+    SharedReference* dataRef = that.mDataRef ? new SharedReference(*that.mDataRef) : nullptr;
+    delete mDataRef;
+    mDataRef = dataRef;
     mData = that.mData;
     mWidth = that.mWidth;
     mHeight = that.mHeight;
     mChannels = that.mChannels;
+    mRowStride = that.mRowStride;
     return *this;
 }
 
+LinearImage LinearImage::createView(float* pixels, uint32_t width, uint32_t height,
+        uint32_t channels, uint32_t rowStride) {
+    LinearImage result;
+    result.mData = pixels;
+    result.mWidth = width;
+    result.mHeight = height;
+    result.mChannels = channels;
+    result.mRowStride = rowStride ? rowStride : width * channels;
+    return result;
+}
+
+LinearImage LinearImage::createView(uint32_t left, uint32_t top, uint32_t width,
+        uint32_t height) const {
+    LinearImage result(*this);
+    result.mData += left * mChannels + top * mRowStride;
+    result.mWidth = width;
+    result.mHeight = height;
+    return result;
+}
+
+void purgePixelBufferPool() {
+    BufferPool::get().purge();
+}
+
 }  // namespace image
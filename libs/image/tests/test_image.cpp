@@ -16,6 +16,7 @@
 
 #include <image/ColorTransform.h>
 #include <image/KtxBundle.h>
+#include <image/KtxStreamReader.h>
 #include <image/ImageOps.h>
 #include <image/ImageSampler.h>
 #include <image/LinearImage.h>
@@ -26,6 +27,7 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -33,6 +35,7 @@
 #include <math/vec4.h>
 
 #include <fstream>
+#include <random>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -207,6 +210,100 @@ TEST_F(ImageTest, DepthFilters) { // NOLINT
     updateOrCompare(atlas, "depths.png");
 }
 
+TEST_F(ImageTest, ResampleChannels) { // NOLINT
+    // the vectorized 4-channel kernels and the threaded row bands must produce exactly the
+    // same bits as resampling each channel on its own
+    const uint32_t SW = 257, SH = 131, TW = 64, TH = 200;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> dist(0, 1);
+    LinearImage source(SW, SH, 4);
+    float* pixels = source.getPixelRef();
+    for (uint32_t n = 0; n < SW * SH * 4; ++n) {
+        pixels[n] = dist(generator);
+    }
+    LinearImage planes[4];
+    for (uint32_t c = 0; c < 4; ++c) {
+        planes[c] = LinearImage(SW, SH, 1);
+        float* plane = planes[c].getPixelRef();
+        for (uint32_t n = 0; n < SW * SH; ++n) {
+            plane[n] = pixels[n * 4 + c];
+        }
+    }
+    for (Filter filter : { Filter::LANCZOS, Filter::MITCHELL, Filter::MINIMUM }) {
+        LinearImage whole = resampleImage(source, TW, TH, filter);
+        for (uint32_t c = 0; c < 4; ++c) {
+            LinearImage plane = resampleImage(planes[c], TW, TH, filter);
+            for (uint32_t n = 0; n < TW * TH; ++n) {
+                ASSERT_EQ(whole.getPixelRef()[n * 4 + c], plane.getPixelRef()[n]);
+            }
+        }
+    }
+}
+
+TEST_F(ImageTest, ResampleRegion) { // NOLINT
+    // a windowed resample must reproduce the corresponding rectangle of the full resample
+    // bit-for-bit, for smooth and discontinuous kernels alike
+    const uint32_t SW = 300, SH = 220, TW = 75, TH = 55;
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> dist(0, 1);
+    LinearImage source(SW, SH, 3);
+    for (uint32_t n = 0; n < SW * SH * 3; ++n) {
+        source.getPixelRef()[n] = dist(generator);
+    }
+    for (Filter filter : { Filter::LANCZOS, Filter::BOX, Filter::MINIMUM }) {
+        LinearImage whole = resampleImage(source, TW, TH, filter);
+        const uint32_t x0 = 13, y0 = 7, x1 = 60, y1 = 42;
+        LinearImage region = resampleImageRegion(source, TW, TH, filter, x0, y0, x1, y1);
+        ASSERT_EQ(region.getWidth(), x1 - x0);
+        ASSERT_EQ(region.getHeight(), y1 - y0);
+        for (uint32_t y = y0; y < y1; ++y) {
+            for (uint32_t x = x0; x < x1; ++x) {
+                for (uint32_t c = 0; c < 3; ++c) {
+                    ASSERT_EQ(whole.getPixelRef()[(y * TW + x) * 3 + c],
+                            region.getPixelRef()[((y - y0) * (x1 - x0) + x - x0) * 3 + c]);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(ImageTest, StridedViews) { // NOLINT
+    // a strided crop view must behave exactly like a deep-copied crop throughout the library
+    const uint32_t SW = 32, SH = 24;
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> dist(0, 1);
+    LinearImage source(SW, SH, 3);
+    for (uint32_t n = 0; n < SW * SH * 3; ++n) {
+        source.getPixelRef()[n] = dist(generator);
+    }
+    LinearImage copied = cropRegion(source, 4, 2, 20, 18);
+    LinearImage view = cropRegionView(source, 4, 2, 20, 18);
+    ASSERT_EQ(view.getWidth(), copied.getWidth());
+    ASSERT_EQ(view.getHeight(), copied.getHeight());
+    ASSERT_EQ(view.getRowStride(), SW * 3);
+    auto same = [](const LinearImage& a, const LinearImage& b) {
+        return compare(a, b) == 0 && compare(b, a) == 0;
+    };
+    ASSERT_TRUE(same(copied, view));
+    ASSERT_TRUE(same(transpose(copied), transpose(view)));
+    ASSERT_TRUE(same(horizontalFlip(copied), horizontalFlip(view)));
+    ASSERT_TRUE(same(verticalFlip(copied), verticalFlip(view)));
+    ASSERT_TRUE(same(extractChannel(copied, 1), extractChannel(view, 1)));
+    for (Filter filter : { Filter::LANCZOS, Filter::BOX, Filter::MINIMUM }) {
+        ASSERT_TRUE(same(resampleImage(copied, 8, 8, filter),
+                resampleImage(view, 8, 8, filter)));
+    }
+
+    // writes through a view land in the source image
+    view.getPixelRef(0, 0)[0] = 42.0f;
+    ASSERT_EQ(source.getPixelRef(4, 2)[0], 42.0f);
+
+    // a non-owning view wraps caller-owned pixels without copying them
+    std::vector<float> pixels(20 * 8, 1.0f);
+    LinearImage wrapped = LinearImage::createView(pixels.data(), 5, 8, 1, 20);
+    ASSERT_EQ(wrapped.getPixelRef(4, 7), pixels.data() + 7 * 20 + 4);
+}
+
 TEST_F(ImageTest, ImageOps) { // NOLINT
     auto finalize = [] (LinearImage image) {
         return resampleImage(image, 100, 100, Filter::NEAREST);
@@ -281,6 +378,44 @@ TEST_F(ImageTest, ColorTransformRGBA) { // NOLINT
     ASSERT_NEAR(pixels[3].w, 0.99183642f, 0.001f);
 }
 
+TEST_F(ImageTest, ColorTransformBatch) { // NOLINT
+    // the lookup-table decoder must agree with the std::pow reference path
+    constexpr size_t w = 4;
+    constexpr size_t h = 1;
+    constexpr uint16_t texels[] = {
+        0, 1, 14, 60000,
+        10000, 20000, 40000, 65535,
+        13000, 23000, 43000, 63000,
+        15000, 25000, 45000, 30000,
+    };
+    constexpr size_t bpr = w * sizeof(uint16_t) * 4;
+    std::unique_ptr<uint8_t[]> data(new uint8_t[h * bpr]);
+    memcpy(data.get(), texels, sizeof(texels));
+    const auto proc = [ ](uint16_t v) -> uint16_t { return v; };
+    LinearImage expected = image::toLinearWithAlpha<uint16_t>(w, h, bpr, data, proc,
+        sRGBToLinear<math::float4>);
+    LinearImage img(w, h, 4);
+    image::sRGBToLinearInto<uint16_t>(img, bpr, data.get(), proc);
+    auto e = reinterpret_cast<float4*>(expected.getPixelRef());
+    auto p = reinterpret_cast<float4*>(img.getPixelRef());
+    for (size_t i = 0; i < w * h; i++) {
+        for (size_t n = 0; n < 4; n++) {
+            ASSERT_NEAR(e[i][n], p[i][n], 1e-5f);
+        }
+    }
+
+    // the float batch kernels roundtrip and match the scalar transfer functions
+    constexpr float values[] = { 0.0f, 0.001f, 0.02f, 0.2f, 0.5f, 0.9f, 1.0f };
+    constexpr size_t count = sizeof(values) / sizeof(values[0]);
+    float linear[count], back[count];
+    image::sRGBToLinearBatch(linear, values, count);
+    image::linearToSRGBBatch(back, linear, count);
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_NEAR(linear[i], sRGBToLinear(values[i]), 1e-4f);
+        ASSERT_NEAR(back[i], values[i], 1e-4f);
+    }
+}
+
 TEST_F(ImageTest, Mipmaps) { // NOLINT
     Filter filter = filterFromString("HERMITE");
     ASSERT_EQ(filter, Filter::HERMITE);
@@ -375,6 +510,119 @@ TEST_F(ImageTest, Ktx) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, KtxCompression) { // NOLINT
+    uint8_t* data;
+    uint32_t size;
+
+    // Build a small two-level cubemap bundle with repetitive (i.e. compressible) content.
+    KtxBundle bundle(2, 1, true);
+    vector<uint8_t> mip0(4096), mip1(1024);
+    for (size_t i = 0; i < mip0.size(); ++i) mip0[i] = uint8_t((i * 7) % 51);
+    for (size_t i = 0; i < mip1.size(); ++i) mip1[i] = uint8_t((i * 7) % 51);
+    for (uint32_t face = 0; face < 6; ++face) {
+        ASSERT_TRUE(bundle.setBlob({0, 0, face}, mip0.data(), mip0.size()));
+        ASSERT_TRUE(bundle.setBlob({1, 0, face}, mip1.data(), mip1.size()));
+    }
+    const uint32_t rawSize = bundle.getSerializedLength();
+
+    bundle.setCompression(true);
+    ASSERT_TRUE(bundle.isCompressed());
+    const uint32_t compressedSize = bundle.getSerializedLength();
+    ASSERT_LT(compressedSize, rawSize);
+    vector<uint8_t> stream(compressedSize);
+    ASSERT_TRUE(bundle.serialize(stream.data(), compressedSize));
+
+    // Lazy per-blob decode through getBlob.
+    KtxBundle lazy(stream.data(), stream.size());
+    ASSERT_TRUE(lazy.isCompressed());
+    ASSERT_TRUE(lazy.getBlob({1, 0, 3}, &data, &size));
+    ASSERT_EQ(size, mip1.size());
+    ASSERT_EQ(memcmp(data, mip1.data(), size), 0);
+
+    // Parallel decode on the JobSystem.
+    KtxBundle parallel(stream.data(), stream.size());
+    utils::JobSystem js;
+    js.adopt();
+    ASSERT_TRUE(parallel.decompress(js));
+    for (uint32_t face = 0; face < 6; ++face) {
+        ASSERT_TRUE(parallel.getBlob({0, 0, face}, &data, &size));
+        ASSERT_EQ(size, mip0.size());
+        ASSERT_EQ(memcmp(data, mip0.data(), size), 0);
+    }
+
+    // Disabling compression after a round trip yields a plain KTX stream again.
+    parallel.setCompression(false);
+    vector<uint8_t> raw(parallel.getSerializedLength());
+    ASSERT_EQ(raw.size(), rawSize);
+    ASSERT_TRUE(parallel.serialize(raw.data(), raw.size()));
+    KtxBundle plain(raw.data(), raw.size());
+    ASSERT_FALSE(plain.isCompressed());
+    ASSERT_TRUE(plain.getBlob({0, 0, 5}, &data, &size));
+    ASSERT_EQ(size, mip0.size());
+    ASSERT_EQ(memcmp(data, mip0.data(), size), 0);
+}
+
+TEST_F(ImageTest, KtxStream) { // NOLINT
+    // build a small two-level cubemap bundle and serialize it to a file
+    KtxBundle bundle(2, 1, true);
+    bundle.info() = { 0x04030201, 1, 2, 3, 4, 5, 64, 64, 0 };
+    bundle.setMetadata("sphere", "harmonics");
+    uint8_t level0[16];
+    uint8_t level1[4];
+    for (uint32_t face = 0; face < 6; face++) {
+        memset(level0, 0x10 + face, sizeof(level0));
+        memset(level1, 0x20 + face, sizeof(level1));
+        ASSERT_TRUE(bundle.setBlob({0, 0, face}, level0, sizeof(level0)));
+        ASSERT_TRUE(bundle.setBlob({1, 0, face}, level1, sizeof(level1)));
+    }
+    std::vector<uint8_t> buffer(bundle.getSerializedLength());
+    ASSERT_TRUE(bundle.serialize(buffer.data(), buffer.size()));
+
+    const std::string path = "/tmp/test_image_stream.ktx";
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*) buffer.data(), buffer.size());
+    out.close();
+
+    // the streaming reader must see the same content, without copying
+    KtxStreamReader reader(path.c_str());
+    ASSERT_TRUE(reader.isValid());
+    ASSERT_EQ(reader.getNumMipLevels(), 2);
+    ASSERT_EQ(reader.getArrayLength(), 1);
+    ASSERT_TRUE(reader.isCubemap());
+    ASSERT_EQ(reader.getInfo().pixelWidth, 64);
+
+    for (uint32_t face = 0; face < 6; face++) {
+        uint8_t const* data = nullptr;
+        uint32_t size = 0;
+        ASSERT_TRUE(reader.getBlob({0, 0, face}, &data, &size));
+        ASSERT_EQ(size, sizeof(level0));
+        ASSERT_EQ(data[0], 0x10 + face);
+        ASSERT_TRUE(reader.getBlob({1, 0, face}, &data, &size));
+        ASSERT_EQ(size, sizeof(level1));
+        ASSERT_EQ(data[0], 0x20 + face);
+    }
+
+    // mip tail first: the smallest level is uploaded first
+    ASSERT_EQ(reader.getMipUploadOrder(0), 1);
+    ASSERT_EQ(reader.getMipUploadOrder(1), 0);
+
+    size_t valueSize = 0;
+    const char* value = reader.getMetadata("sphere", &valueSize);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(std::string(value, valueSize), "harmonics");
+    ASSERT_EQ(reader.getMetadata("missing"), nullptr);
+
+    // out-of-bounds indices are rejected
+    uint8_t const* data = nullptr;
+    uint32_t size = 0;
+    ASSERT_FALSE(reader.getBlob({2, 0, 0}, &data, &size));
+    ASSERT_FALSE(reader.getBlob({0, 0, 6}, &data, &size));
+
+    // a bogus path yields an invalid reader
+    KtxStreamReader bogus("/tmp/does_not_exist.ktx");
+    ASSERT_FALSE(bogus.isValid());
+}
+
 static void printUsage(const char* name) {
     string exec_name(utils::Path(name).getName());
     string usage(
@@ -39,11 +39,101 @@
 
 #include <tinyexr.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <image/ColorTransform.h>
 #include <image/ImageOps.h>
 
+namespace {
+
+// Hands bands of decoded rows to a small pool of conversion threads. The producer (typically a
+// sequential entropy decode, which cannot be parallelized) publishes bands as they complete;
+// each worker claims the next unclaimed band and converts it into its slice of the destination
+// image, so the conversion to linear float overlaps the remainder of the decode.
+class RowBandPipeline {
+public:
+    RowBandPipeline(uint32_t bandCount, std::function<void(uint32_t band)> converter)
+            : mBandCount(bandCount), mConverter(std::move(converter)) {
+        uint32_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+        nthreads = std::min(nthreads, bandCount);
+        mWorkers.reserve(nthreads);
+        for (uint32_t t = 0; t < nthreads; ++t) {
+            mWorkers.emplace_back([this] { work(); });
+        }
+    }
+
+    // Unblocks the workers without converting the outstanding bands; used when the producer
+    // bails out with an exception.
+    ~RowBandPipeline() {
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            mAborted = true;
+        }
+        mCondition.notify_all();
+        join();
+    }
+
+    // Called by the producer once the given number of leading bands has been fully decoded.
+    void publish(uint32_t bandsReady) {
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            mBandsReady = bandsReady;
+        }
+        mCondition.notify_all();
+    }
+
+    // Publishes everything and waits for every band to be converted.
+    void finish() {
+        publish(mBandCount);
+        join();
+    }
+
+private:
+    void work() {
+        while (true) {
+            const uint32_t band = mNextBand++;
+            if (band >= mBandCount) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mLock);
+                mCondition.wait(lock, [this, band] { return mAborted || mBandsReady > band; });
+                if (mAborted) {
+                    return;
+                }
+            }
+            mConverter(band);
+        }
+    }
+
+    void join() {
+        for (auto& worker : mWorkers) {
+            worker.join();
+        }
+        mWorkers.clear();
+    }
+
+    const uint32_t mBandCount;
+    const std::function<void(uint32_t band)> mConverter;
+    std::atomic<uint32_t> mNextBand {0};
+    uint32_t mBandsReady = 0;
+    bool mAborted = false;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<std::thread> mWorkers;
+};
+
+// Rows per band; small enough to keep all cores busy on typical source images, large enough
+// that the synchronization cost is noise.
+constexpr uint32_t ROWS_PER_BAND = 64;
+
+} // anonymous namespace
+
 namespace image {
 
 class PNGDecoder : public ImageDecoder::Decoder {
@@ -256,6 +346,9 @@ LinearImage PNGDecoder::decode() {
             png_set_expand_16(mPNG);
         }
 
+        const bool interlaced =
+                png_get_interlace_type(mPNG, mInfo) != PNG_INTERLACE_NONE;
+
         png_read_update_info(mPNG, mInfo);
         uint32_t width  = png_get_image_width(mPNG, mInfo);
         uint32_t height = png_get_image_height(mPNG, mInfo);
@@ -266,31 +359,50 @@ LinearImage PNGDecoder::decode() {
         for (size_t y = 0 ; y < height ; y++) {
             rowPointers[y] = &imageData[y * rowBytes];
         }
-        png_read_image(mPNG, rowPointers.get());
-        png_read_end(mPNG, mInfo);
 
-        if (colorType == PNG_COLOR_TYPE_RGBA) {
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [ ](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear<math::float4>);
-            } else {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [ ](uint16_t v) -> uint16_t { return ntohs(v); },
+        // The inflate stream itself is inherently sequential, but the conversion to linear
+        // float (notably the sRGB transfer function) is not: bands of decoded rows are handed
+        // to the pipeline and converted in parallel, directly into their slice of the result,
+        // while the remaining rows are still inflating.
+        const bool srgb = getColorSpace() == ImageDecoder::ColorSpace::SRGB;
+        const bool hasAlpha = colorType == PNG_COLOR_TYPE_RGBA;
+        const auto proc = [ ](uint16_t v) -> uint16_t { return ntohs(v); };
+        LinearImage image(width, height, hasAlpha ? 4 : 3);
+        const uint32_t bandCount = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+        RowBandPipeline pipeline(bandCount, [&](uint32_t band) {
+            const uint32_t y0 = band * ROWS_PER_BAND;
+            const uint32_t bandHeight = std::min(ROWS_PER_BAND, height - y0);
+            LinearImage view = image.createView(0u, y0, width, bandHeight);
+            uint8_t const* src = imageData.get() + size_t(y0) * rowBytes;
+            // Convert to linear float (PNG 16 stores data in network order (big endian)).
+            if (srgb) {
+                // decodes the transfer function through the lookup table; handles
+                // both the 3- and 4-channel layouts
+                sRGBToLinearInto<uint16_t>(view, rowBytes, src, proc);
+            } else if (hasAlpha) {
+                toLinearWithAlphaInto<uint16_t>(view, rowBytes, src, proc,
                         [ ](const math::float4& color) -> math::float4 { return color; });
-            }
-        } else {
-            // Convert to linear float (PNG 16 stores data in network order (big endian).
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [ ](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear<math::float3>);
             } else {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [ ](uint16_t v) -> uint16_t { return ntohs(v); },
+                toLinearInto<uint16_t>(view, rowBytes, src, proc,
                         [ ](const math::float3& color) -> math::float3 { return color; });
             }
+        });
+
+        if (interlaced) {
+            // Interlaced images need multiple passes over every row, so the whole image is
+            // decoded before any band becomes available.
+            png_read_image(mPNG, rowPointers.get());
+        } else {
+            for (uint32_t band = 0; band < bandCount; ++band) {
+                const uint32_t y0 = band * ROWS_PER_BAND;
+                const uint32_t bandHeight = std::min(ROWS_PER_BAND, height - y0);
+                png_read_rows(mPNG, rowPointers.get() + y0, nullptr, bandHeight);
+                pipeline.publish(band + 1);
+            }
         }
+        png_read_end(mPNG, mInfo);
+        pipeline.finish();
+        return image;
     } catch(std::runtime_error& e) {
         // reset the stream, like we found it
         std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
@@ -586,17 +698,21 @@ LinearImage EXRDecoder::decode() {
 
         LinearImage image(width, height, 3);
 
-        size_t i = 0;
-        for (size_t y = 0; y < height; y++) {
-            for (size_t x = 0; x < width; x++) {
-                math::float3& pixel = *reinterpret_cast<math::float3*>(image.getPixelRef(x, y));
-                pixel.r = rgba[i++];
-                pixel.g = rgba[i++];
-                pixel.b = rgba[i++];
-                // skip alpha
-                i++;
+        // tinyexr's one-shot API hands back the fully decoded RGBA buffer, so unlike PNG there
+        // is nothing to overlap; the RGBA-to-RGB repack is still spread across row bands.
+        const uint32_t bandCount = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+        RowBandPipeline pipeline(bandCount, [&](uint32_t band) {
+            const uint32_t y0 = band * ROWS_PER_BAND;
+            const uint32_t y1 = std::min(y0 + ROWS_PER_BAND, uint32_t(height));
+            for (uint32_t y = y0; y < y1; y++) {
+                float const* src = rgba + size_t(y) * width * 4;
+                auto dst = reinterpret_cast<math::float3*>(image.getPixelRef(0, y));
+                for (uint32_t x = 0; x < width; x++, src += 4) {
+                    dst[x] = math::float3(src[0], src[1], src[2]); // skip alpha
+                }
             }
-        }
+        });
+        pipeline.finish();
 
         free(rgba);
 
@@ -49,3 +49,10 @@
 #else
 #   define MATH_EMPTY_BASES
 #endif
+
+// instruction-set detection for the explicitly vectorized kernels (see math/simd.h)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define MATH_HAS_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define MATH_HAS_SSE2 1
+#endif
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <type_traits>
 #include <math/compiler.h>
+#include <math/vec4.h>
 
 #ifdef __ARM_NEON
 #include <arm_neon.h>
@@ -87,6 +88,101 @@ inline double MATH_PURE isqrt(double x) noexcept {
 #endif
 }
 
+/*
+ * Vectorized transcendentals over float4.
+ *
+ * All four lanes are computed with the same straight-line code so these compile to a
+ * handful of vector instructions. The accuracy policy selects between the polynomial
+ * approximations (FAST, error bounds documented on each function) and libm applied
+ * per lane (PRECISE) without changing the call site.
+ */
+
+enum class Accuracy {
+    FAST,       // polynomial approximations, see each function for bounds
+    PRECISE     // libm accuracy, applied per lane
+};
+
+// fast log2() over float4: exponent taken from the bit pattern, degree-5 minimax fit
+// of the mantissa (more accurate than the scalar fast::log2() above). Max absolute
+// error 1.8e-5, i.e. ~150 ULP for results of magnitude 1, proportionally fewer for
+// larger magnitudes. x must be finite and non-zero; the sign bit is ignored.
+template<Accuracy A = Accuracy::FAST>
+inline float4 MATH_PURE log2(float4 x) noexcept {
+    float4 r;
+    for (size_t i = 0; i < 4; i++) {    // this loop vectorizes
+        if (A == Accuracy::PRECISE) {
+            r[i] = std::log2(x[i]);
+        } else {
+            union { float val; int32_t x; } u = { x[i] };
+            const float e = float(((u.x >> 23) & 0xff) - 127);
+            u.x = (u.x & 0x007fffff) | 0x3f800000;
+            const float m = u.val;
+            r[i] = e - 2.787926207f + m * (5.047855413f + m * (-3.489878551f
+                    + m * (1.589474295f + m * (-4.025133935e-1f + m * 4.300495779e-2f))));
+        }
+    }
+    return r;
+}
+
+// fast exp2() over float4: degree-4 minimax fit of the fractional part, integer part
+// moved into the exponent bits. Max relative error 3.6e-6 (34 ULP). The integer part
+// is clamped to +/-127, so out-of-range inputs saturate to ~0 / ~2^127 instead of
+// overflowing the exponent.
+template<Accuracy A = Accuracy::FAST>
+inline float4 MATH_PURE exp2(float4 x) noexcept {
+    float4 r;
+    for (size_t i = 0; i < 4; i++) {    // this loop vectorizes
+        if (A == Accuracy::PRECISE) {
+            r[i] = std::exp2(x[i]);
+        } else {
+            const float z = std::floor(x[i]);
+            const float f = x[i] - z;
+            const float p = 1.000003493f + f * (6.929729222e-1f + f * (2.416043573e-1f
+                    + f * (5.174499776e-2f + f * 1.367030945e-2f)));
+            union { int32_t x; float val; } u;
+            int32_t e = int32_t(z);
+            e = e < -127 ? -127 : (e > 127 ? 127 : e);
+            u.x = (e + 127) << 23;
+            r[i] = u.val * p;
+        }
+    }
+    return r;
+}
+
+// fast pow() over float4 for x > 0, computed as exp2(log2(x) * y). The error is
+// dominated by the log2() term scaled by the exponent: max relative error ~1.3e-5 * |y|
+// (measured 5e-5 for |y| <= 4). pow(0, y) with y > 0 returns a denormal ~1e-38 rather
+// than exactly 0, courtesy of the exp2() clamp.
+template<Accuracy A = Accuracy::FAST>
+inline float4 MATH_PURE pow(float4 x, float y) noexcept {
+    if (A == Accuracy::PRECISE) {
+        return { std::pow(x[0], y), std::pow(x[1], y), std::pow(x[2], y), std::pow(x[3], y) };
+    }
+    return exp2<A>(log2<A>(x) * y);
+}
+
+// fast 1/sqrt() over float4. On ARMv8 the FAST policy uses the vector estimate plus one
+// Newton-Raphson step, max relative error ~1e-6; elsewhere both policies are a division
+// and a square root per lane (exact to 1 ULP), which still vectorizes.
+template<Accuracy A = Accuracy::FAST>
+inline float4 MATH_PURE isqrt(float4 x) noexcept {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    if (A == Accuracy::FAST) {
+        float32x4_t v = vld1q_f32(&x[0]);
+        float32x4_t y = vrsqrteq_f32(v);
+        y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(v, y), y));
+        float4 r;
+        vst1q_f32(&r[0], y);
+        return r;
+    }
+#endif
+    float4 r;
+    for (size_t i = 0; i < 4; i++) {    // this loop vectorizes
+        r[i] = 1 / std::sqrt(x[i]);
+    }
+    return r;
+}
+
 inline int signbit(float x) noexcept {
 #if __has_builtin(__builtin_signbitf)
     // Note: on Android NDK, signbit() is a function call -- not what we want.
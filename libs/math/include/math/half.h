@@ -17,10 +17,17 @@
 #ifndef TNT_MATH_HALF_H
 #define TNT_MATH_HALF_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <limits>
 #include <type_traits>
 
+#if defined(__ARM_NEON)
+#   include <arm_neon.h>
+#elif defined(__F16C__)
+#   include <immintrin.h>
+#endif
+
 #ifdef __cplusplus
 #   define LIKELY( exp )    (__builtin_expect( !!(exp), true ))
 #   define UNLIKELY( exp )  (__builtin_expect( !!(exp), false ))
@@ -150,6 +157,84 @@ constexpr float half::htof(half::fp16 in) noexcept {
 
 #endif // __ARM_NEON
 
+/*
+ * Bulk float <-> half conversions, for vertex and image data which is converted
+ * megabytes at a time on load. These use the hardware converters (F16C, NEON vcvt)
+ * when the target has them, four elements per instruction, and fall back to the
+ * scalar conversions above otherwise. in and out must not overlap.
+ */
+
+#if defined(__ARM_NEON) && (defined(__aarch64__) || \
+        (defined(__ARM_NEON_FP) && (__ARM_NEON_FP & 2)))
+
+inline void convertArray(half* out, const float* in, size_t count) noexcept {
+    while (count >= 4) {
+        vst1_f16(reinterpret_cast<__fp16*>(out), vcvt_f16_f32(vld1q_f32(in)));
+        in += 4;
+        out += 4;
+        count -= 4;
+    }
+    while (count--) {
+        *out++ = half(*in++);
+    }
+}
+
+inline void convertArray(float* out, const half* in, size_t count) noexcept {
+    while (count >= 4) {
+        vst1q_f32(out, vcvt_f32_f16(vld1_f16(reinterpret_cast<__fp16 const*>(in))));
+        in += 4;
+        out += 4;
+        count -= 4;
+    }
+    while (count--) {
+        *out++ = float(*in++);
+    }
+}
+
+#elif defined(__F16C__)
+
+inline void convertArray(half* out, const float* in, size_t count) noexcept {
+    while (count >= 4) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                _mm_cvtps_ph(_mm_loadu_ps(in), _MM_FROUND_TO_NEAREST_INT));
+        in += 4;
+        out += 4;
+        count -= 4;
+    }
+    while (count--) {
+        *out++ = half(*in++);
+    }
+}
+
+inline void convertArray(float* out, const half* in, size_t count) noexcept {
+    while (count >= 4) {
+        _mm_storeu_ps(out,
+                _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(in))));
+        in += 4;
+        out += 4;
+        count -= 4;
+    }
+    while (count--) {
+        *out++ = float(*in++);
+    }
+}
+
+#else
+
+inline void convertArray(half* out, const float* in, size_t count) noexcept {
+    while (count--) {
+        *out++ = half(*in++);
+    }
+}
+
+inline void convertArray(float* out, const half* in, size_t count) noexcept {
+    while (count--) {
+        *out++ = float(*in++);
+    }
+}
+
+#endif
+
 inline constexpr math::half operator"" _h(long double v) {
     return math::half(v);
 }
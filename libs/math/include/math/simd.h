@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MATH_SIMD_H_
+#define MATH_SIMD_H_
+
+#include <math/compiler.h>
+#include <math/mat4.h>
+#include <math/vec4.h>
+
+#include <stddef.h>
+
+#if defined(MATH_HAS_NEON)
+#   include <arm_neon.h>
+#elif defined(MATH_HAS_SSE2)
+#   include <emmintrin.h>
+#endif
+
+namespace math {
+
+/*
+ * Explicitly vectorized batch kernels for float 4x4 matrices. The templated scalar code
+ * in TMatHelpers.h is fine for a handful of matrices, but transform and skinning updates
+ * process thousands per frame; these loops keep one operand's columns in registers and
+ * dispatch the instruction set once for the whole array instead of per element.
+ */
+
+#if defined(MATH_HAS_NEON)
+
+// out[i] = a[i] * b[i], column-major. in-place operation (out == a or b) is allowed.
+inline void multiplyArray(mat4f* out,
+        const mat4f* a, const mat4f* b, size_t count) noexcept {
+    float* o = reinterpret_cast<float*>(out);
+    const float* pa = reinterpret_cast<const float*>(a);
+    const float* pb = reinterpret_cast<const float*>(b);
+    while (count--) {
+        const float32x4_t a0 = vld1q_f32(pa);
+        const float32x4_t a1 = vld1q_f32(pa + 4);
+        const float32x4_t a2 = vld1q_f32(pa + 8);
+        const float32x4_t a3 = vld1q_f32(pa + 12);
+        for (size_t j = 0; j < 4; j++) {
+            const float32x4_t bj = vld1q_f32(pb + 4 * j);
+            float32x4_t r = vmulq_lane_f32(a0, vget_low_f32(bj), 0);
+            r = vmlaq_lane_f32(r, a1, vget_low_f32(bj), 1);
+            r = vmlaq_lane_f32(r, a2, vget_high_f32(bj), 0);
+            r = vmlaq_lane_f32(r, a3, vget_high_f32(bj), 1);
+            vst1q_f32(o + 4 * j, r);
+        }
+        pa += 16;
+        pb += 16;
+        o += 16;
+    }
+}
+
+// out[i] = m * v[i]. in-place operation (out == v) is allowed.
+inline void multiplyArray(float4* out,
+        const mat4f& m, const float4* v, size_t count) noexcept {
+    float* o = reinterpret_cast<float*>(out);
+    const float* pm = reinterpret_cast<const float*>(&m);
+    const float* pv = reinterpret_cast<const float*>(v);
+    const float32x4_t m0 = vld1q_f32(pm);
+    const float32x4_t m1 = vld1q_f32(pm + 4);
+    const float32x4_t m2 = vld1q_f32(pm + 8);
+    const float32x4_t m3 = vld1q_f32(pm + 12);
+    while (count--) {
+        const float32x4_t vi = vld1q_f32(pv);
+        float32x4_t r = vmulq_lane_f32(m0, vget_low_f32(vi), 0);
+        r = vmlaq_lane_f32(r, m1, vget_low_f32(vi), 1);
+        r = vmlaq_lane_f32(r, m2, vget_high_f32(vi), 0);
+        r = vmlaq_lane_f32(r, m3, vget_high_f32(vi), 1);
+        vst1q_f32(o, r);
+        pv += 4;
+        o += 4;
+    }
+}
+
+#elif defined(MATH_HAS_SSE2)
+
+// out[i] = a[i] * b[i], column-major. in-place operation (out == a or b) is allowed.
+inline void multiplyArray(mat4f* out,
+        const mat4f* a, const mat4f* b, size_t count) noexcept {
+    float* o = reinterpret_cast<float*>(out);
+    const float* pa = reinterpret_cast<const float*>(a);
+    const float* pb = reinterpret_cast<const float*>(b);
+    while (count--) {
+        const __m128 a0 = _mm_loadu_ps(pa);
+        const __m128 a1 = _mm_loadu_ps(pa + 4);
+        const __m128 a2 = _mm_loadu_ps(pa + 8);
+        const __m128 a3 = _mm_loadu_ps(pa + 12);
+        for (size_t j = 0; j < 4; j++) {
+            const __m128 bj = _mm_loadu_ps(pb + 4 * j);
+            __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, 0x00));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, 0x55)));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, 0xAA)));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, 0xFF)));
+            _mm_storeu_ps(o + 4 * j, r);
+        }
+        pa += 16;
+        pb += 16;
+        o += 16;
+    }
+}
+
+// out[i] = m * v[i]. in-place operation (out == v) is allowed.
+inline void multiplyArray(float4* out,
+        const mat4f& m, const float4* v, size_t count) noexcept {
+    float* o = reinterpret_cast<float*>(out);
+    const float* pm = reinterpret_cast<const float*>(&m);
+    const float* pv = reinterpret_cast<const float*>(v);
+    const __m128 m0 = _mm_loadu_ps(pm);
+    const __m128 m1 = _mm_loadu_ps(pm + 4);
+    const __m128 m2 = _mm_loadu_ps(pm + 8);
+    const __m128 m3 = _mm_loadu_ps(pm + 12);
+    while (count--) {
+        const __m128 vi = _mm_loadu_ps(pv);
+        __m128 r = _mm_mul_ps(m0, _mm_shuffle_ps(vi, vi, 0x00));
+        r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_shuffle_ps(vi, vi, 0x55)));
+        r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_shuffle_ps(vi, vi, 0xAA)));
+        r = _mm_add_ps(r, _mm_mul_ps(m3, _mm_shuffle_ps(vi, vi, 0xFF)));
+        _mm_storeu_ps(o, r);
+        pv += 4;
+        o += 4;
+    }
+}
+
+#else
+
+// scalar fallback. in-place operation (out == a or b) is allowed.
+inline void multiplyArray(mat4f* out,
+        const mat4f* a, const mat4f* b, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+inline void multiplyArray(float4* out,
+        const mat4f& m, const float4* v, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = m * v[i];
+    }
+}
+
+#endif
+
+} // namespace math
+
+#endif // MATH_SIMD_H_
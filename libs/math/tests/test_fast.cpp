@@ -72,3 +72,32 @@ TEST_F(FastTest, Trig) {
     EXPECT_NEAR    (-sqrt1_2d,  fast::cos<double>(M_PI_2 + M_PI_4), abs_error);
     EXPECT_FLOAT_EQ(-1.0f,      fast::cos<double>(M_PI));
 }
+
+TEST_F(FastTest, Transcendentals) {
+    // bounds documented in fast.h
+    constexpr float log2_abs_error = 1.8e-5f;
+    constexpr float exp2_rel_error = 3.6e-6f;
+    constexpr float pow_rel_error = 1.3e-5f * 4.0f;   // ~1.3e-5 * |y|
+
+    const float4 x{ 0.001f, 0.7f, 1.0f, 11456.3f };
+    const float4 l = fast::log2(x);
+    const float4 e = fast::exp2(float4{ -9.1f, -0.5f, 0.0f, 13.7f });
+    const float4 p = fast::pow(x, 2.4f);
+    const float4 s = fast::isqrt(x);
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_NEAR(std::log2(x[i]), l[i], log2_abs_error);
+        const float e_expected = std::exp2(float4{ -9.1f, -0.5f, 0.0f, 13.7f }[i]);
+        EXPECT_NEAR(e_expected, e[i], e_expected * exp2_rel_error);
+        const float p_expected = std::pow(x[i], 2.4f);
+        EXPECT_NEAR(p_expected, p[i], p_expected * pow_rel_error);
+        EXPECT_NEAR(1.0f / std::sqrt(x[i]), s[i], 1e-3f / std::sqrt(x[i]));
+    }
+
+    // out-of-range exp2() inputs saturate instead of wrapping the exponent
+    EXPECT_LT(fast::exp2(float4{ -1000.0f })[0], 1e-37f);
+    EXPECT_GT(fast::exp2(float4{ 1000.0f })[0], 1e38f);
+
+    // the PRECISE policy matches libm
+    EXPECT_FLOAT_EQ(std::log2(0.7f), fast::log2<fast::Accuracy::PRECISE>(x)[1]);
+    EXPECT_FLOAT_EQ(std::pow(0.7f, 2.4f), fast::pow<fast::Accuracy::PRECISE>(x, 2.4f)[1]);
+}
@@ -18,6 +18,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include <math/half.h>
 #include <math/vec4.h>
 
@@ -90,3 +92,24 @@ TEST_F(HalfTest, Vec) {
     EXPECT_EQ(f4.xyz, h3);
     EXPECT_EQ(f4.xy, h2);
 }
+
+TEST_F(HalfTest, ConvertArray) {
+    // odd count to exercise the vector loop and the scalar tail
+    constexpr size_t N = 1027;
+    std::vector<float> in(N), back(N);
+    std::vector<half> out(N);
+    for (size_t i = 0; i < N; i++) {
+        in[i] = (float(i) - float(N / 2)) * 0.5f;
+    }
+
+    // the bulk conversion must match the scalar conversion
+    convertArray(out.data(), in.data(), N);
+    for (size_t i = 0; i < N; i++) {
+        EXPECT_EQ(getBits(half(in[i])), getBits(out[i]));
+    }
+
+    convertArray(back.data(), out.data(), N);
+    for (size_t i = 0; i < N; i++) {
+        EXPECT_EQ(float(out[i]), back[i]);
+    }
+}
@@ -20,10 +20,13 @@
 #include <random>
 #include <functional>
 
+#include <vector>
+
 #include <math/mat2.h>
 #include <math/mat4.h>
 #include <math/mat3.h>
 #include <math/quat.h>
+#include <math/simd.h>
 
 using namespace math;
 
@@ -160,6 +163,51 @@ TEST_F(MatTest, ElementAccess) {
     EXPECT_FLOAT_EQ(m(3, 2), 100);
 }
 
+TEST_F(MatTest, MultiplyArray) {
+    std::default_random_engine generator(82828);
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+    auto rand_gen = std::bind(distribution, generator);
+
+    constexpr size_t N = 100;
+    std::vector<mat4f> a(N), b(N), out(N);
+    std::vector<float4> v(N), vout(N);
+    for (size_t i = 0; i < N; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                a[i][c][r] = rand_gen();
+                b[i][c][r] = rand_gen();
+            }
+            v[i][c] = rand_gen();
+        }
+    }
+
+    // the batched kernels accumulate in the same order as the scalar operators
+    multiplyArray(out.data(), a.data(), b.data(), N);
+    for (size_t i = 0; i < N; i++) {
+        const mat4f ref = a[i] * b[i];
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                EXPECT_FLOAT_EQ(out[i][c][r], ref[c][r]);
+            }
+        }
+    }
+
+    multiplyArray(vout.data(), a[0], v.data(), N);
+    for (size_t i = 0; i < N; i++) {
+        const float4 ref = a[0] * v[i];
+        for (size_t c = 0; c < 4; c++) {
+            EXPECT_FLOAT_EQ(vout[i][c], ref[c]);
+        }
+    }
+
+    // in-place operation is supported
+    std::vector<mat4f> inPlace(a);
+    multiplyArray(inPlace.data(), inPlace.data(), b.data(), N);
+    for (size_t i = 0; i < N; i++) {
+        EXPECT_EQ(inPlace[i], out[i]);
+    }
+}
+
 //------------------------------------------------------------------------------
 // MAT 3
 //------------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_ADAPTIVEMUTEX_H
+#define TNT_UTILS_ADAPTIVEMUTEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/compiler.h>
+#include <utils/Mutex.h>
+
+namespace utils {
+
+/*
+ * A mutex for very short critical sections (tens of nanoseconds, e.g. a free-list
+ * push or a set insertion). The platform mutex parks the thread as soon as the lock
+ * is contended, and the futex round-trip then costs orders of magnitude more than
+ * the critical section it guards. AdaptiveMutex first spins a bounded number of
+ * times with exponential backoff -- under brief contention the owner releases the
+ * lock within a few iterations -- and only parks when spinning failed, so it
+ * degrades to regular Mutex behavior when critical sections turn out to be long or
+ * the system is oversubscribed.
+ *
+ * Usable anywhere a BasicLockable is expected (std::lock_guard<>, ResourceList's
+ * LockingPolicy, ...). Not recursive.
+ */
+class AdaptiveMutex {
+public:
+    AdaptiveMutex() noexcept = default;
+    AdaptiveMutex(const AdaptiveMutex&) = delete;
+    AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+    void lock() noexcept {
+        if (UTILS_LIKELY(mMutex.try_lock())) {
+            return;
+        }
+        // bounded spin; each failed attempt doubles the backoff so that spinners
+        // don't hammer the owner's cache line
+        uint32_t backoff = 1;
+        for (size_t i = 0; i < SPIN_ATTEMPTS; i++) {
+            for (uint32_t j = backoff; j > 0; j--) {
+                UTILS_PAUSE();
+            }
+            if (mMutex.try_lock()) {
+                return;
+            }
+            if (backoff < MAX_BACKOFF) {
+                backoff *= 2;
+            }
+        }
+        // the critical section isn't as short as advertised, park like a regular mutex
+        mMutex.lock();
+    }
+
+    bool try_lock() noexcept {
+        return mMutex.try_lock();
+    }
+
+    void unlock() noexcept {
+        mMutex.unlock();
+    }
+
+private:
+    // ~500 pauses worst case, i.e. a few hundred nanoseconds -- comparable to the
+    // futex round-trip we're trying to avoid; past that, parking is cheaper
+    static constexpr size_t SPIN_ATTEMPTS = 8;
+    static constexpr uint32_t MAX_BACKOFF = 128;
+
+    Mutex mMutex;
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_ADAPTIVEMUTEX_H
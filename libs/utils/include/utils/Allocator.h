@@ -130,6 +130,91 @@ private:
     void* mCurrent = nullptr;
 };
 
+/* ------------------------------------------------------------------------------------------------
+ * LinearAllocatorWithFallback
+ *
+ * + Allocates blocks linearly from a fixed area, like LinearAllocator
+ * + Falls back to heap-allocated slabs when the area overflows, instead of failing
+ * + Slabs are retained across reset() (i.e. the allocator keeps its high watermark)
+ *   and are only returned to the heap on destruction
+ * + Doesn't call destructors
+ * ------------------------------------------------------------------------------------------------
+ */
+
+class LinearAllocatorWithFallback : private LinearAllocator {
+public:
+    // use memory area provided
+    LinearAllocatorWithFallback(void* begin, void* end) noexcept : LinearAllocator(begin, end) { }
+
+    template <typename AREA>
+    explicit LinearAllocatorWithFallback(const AREA& area)
+            : LinearAllocatorWithFallback(area.begin(), area.end()) { }
+
+    // Allocators can't be copied
+    LinearAllocatorWithFallback(const LinearAllocatorWithFallback& rhs) = delete;
+    LinearAllocatorWithFallback& operator=(const LinearAllocatorWithFallback& rhs) = delete;
+
+    ~LinearAllocatorWithFallback() noexcept;
+
+    // our allocator concept
+    void* alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0) {
+        if (UTILS_LIKELY(!mCurrentSlab)) {
+            void* const p = LinearAllocator::alloc(size, alignment, extra);
+            if (UTILS_LIKELY(p)) {
+                return p;
+            }
+        }
+        // once we've overflowed, everything is allocated from the slabs, so that rewind()
+        // ordering stays well-defined
+        return allocSlow(size, alignment, extra);
+    }
+
+    // API specific to this allocator
+
+    void* getCurrent() noexcept {
+        return mCurrentSlab ? mCurrentSlab->current : LinearAllocator::getCurrent();
+    }
+
+    // free memory back to the specified point, either in the primary area or in a slab
+    void rewind(void* p) noexcept;
+
+    // frees all allocated blocks; the slabs themselves are retained
+    void reset() noexcept;
+
+    // memory currently allocated, in the primary area and in the slabs
+    size_t allocated() const noexcept;
+
+    // the most memory this allocator has ever had allocated; use this to size the
+    // primary area from telemetry instead of guessing
+    size_t highWatermark() const noexcept {
+        size_t const current = allocated();
+        return current > mHighWatermark ? current : mHighWatermark;
+    }
+
+    using LinearAllocator::base;
+
+    // LinearAllocatorWithFallback shouldn't have a free() method (see LinearAllocator)
+    void free(void*) UTILS_RESTRICT noexcept { }
+
+private:
+    // a heap-allocated slab; the header lives at the beginning of the slab itself
+    struct Slab {
+        Slab* next;
+        void* end;
+        void* current;
+        void* begin() const noexcept { return (void*)(this + 1); }
+    };
+
+    // slabs are at least this big, so overflowing frames don't hit malloc() often
+    static constexpr size_t SLAB_SIZE = 1024 * 1024;
+
+    void* allocSlow(size_t size, size_t alignment, size_t extra) noexcept;
+
+    Slab* mSlabs = nullptr;         // all slabs, in allocation order
+    Slab* mCurrentSlab = nullptr;   // slab currently allocated from, nullptr if none
+    size_t mHighWatermark = 0;      // recorded at rewind() / reset()
+};
+
 /* ------------------------------------------------------------------------------------------------
  * HeapAllocator
  *
@@ -654,6 +739,53 @@ private:
 };
 
 
+// ------------------------------------------------------------------------------------------------
+
+/*
+ * ScratchArena provides per-thread scratch memory with RAII scope rewind, so jobs running
+ * on JobSystem workers (or any thread, e.g. one that called JobSystem::adopt()) can get
+ * temporary memory without touching the heap. Each thread lazily reserves its own slab on
+ * first use, which is released when the thread exits.
+ *
+ * usage:
+ *      ScratchArena::Scope scope;
+ *      float* temp = scope.allocate<float>(count);
+ *      // temp is reclaimed when scope is destroyed
+ *
+ * Scopes nest naturally; like ArenaScope, non-trivially-destructible objects created
+ * with make<>() have their destructor called on rewind.
+ */
+class ScratchArena {
+public:
+    using Arena = utils::Arena<LinearAllocator, LockingPolicy::NoLock>;
+
+    // each thread's slab size. scratch allocations are transient by nature, so this
+    // doesn't need to accommodate more than the deepest scope nesting.
+    static constexpr size_t SLAB_SIZE = 1024 * 1024;
+
+    // returns the calling thread's scratch arena, creating it on first use
+    static ScratchArena& get() noexcept;
+
+    Arena& getArena() noexcept { return mArena; }
+
+    // RAII scope on the calling thread's arena; allocations made through it are
+    // rewound when it's destroyed
+    class Scope : public ArenaScope<Arena> {
+    public:
+        Scope() noexcept : ArenaScope<Arena>(ScratchArena::get().getArena()) { }
+    };
+
+    ScratchArena() noexcept : mArena("ScratchArena", SLAB_SIZE) { }
+
+    ScratchArena(ScratchArena const&) = delete;
+    ScratchArena& operator=(ScratchArena const&) = delete;
+
+private:
+    Arena mArena;
+};
+
+// ------------------------------------------------------------------------------------------------
+
 template <typename TYPE, typename ARENA>
 class STLAllocator {
 public:
@@ -51,6 +51,18 @@ struct hashCStrings {
     }
 };
 
+/**
+ * Process-wide string interning pool.
+ *
+ * Returns a canonical, immutable, never-deallocated copy of the given null-terminated
+ * string; equal strings always intern to the same pointer, so interned strings can be
+ * compared and hashed by pointer. Thread-safe.
+ *
+ * Intended for small, long-lived name sets (e.g. material parameter names) resolved
+ * once outside of hot paths: entries are never evicted.
+ */
+const char* internString(const char* cstr) noexcept;
+
 //! \privatesection
 struct lessCStrings {
     typedef const char* first_argument_type;
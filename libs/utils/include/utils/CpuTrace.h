@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_CPUTRACE_H
+#define TNT_UTILS_CPUTRACE_H
+
+#include <utils/compiler.h>
+
+#include <atomic>
+#include <chrono>
+
+#include <stdint.h>
+
+namespace utils {
+
+/**
+ * Lightweight, always-available CPU zone tracing.
+ *
+ * Events are recorded into a fixed-size per-thread ring buffer (the oldest events are
+ * overwritten), so recording never allocates, never locks and never grows; the cost of a
+ * zone is two clock reads and one ring store when enabled, a single relaxed load when
+ * disabled. This makes it suitable for production builds on platforms where systrace
+ * isn't available (Windows, macOS, stock Linux).
+ *
+ * The recorded events can be written out as a chrome://tracing JSON file with dump().
+ * Recording should be disabled (or quiescent) while dumping.
+ *
+ * This backend is routed behind the SYSTRACE_* macros when UTILS_CPUTRACE is defined
+ * (see utils/Systrace.h); it can also be used directly.
+ */
+class CpuTrace {
+public:
+    // number of events retained per thread; must be a power-of-two
+    static constexpr size_t EVENT_COUNT = 16384;
+
+    static void enable() noexcept { sEnabled.store(true, std::memory_order_relaxed); }
+    static void disable() noexcept { sEnabled.store(false, std::memory_order_relaxed); }
+    static bool isEnabled() noexcept { return sEnabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Writes all events currently retained by all threads to a chrome://tracing
+     * JSON file (load it from the chrome://tracing page or with Perfetto).
+     * @return false if the file couldn't be written
+     */
+    static bool dump(const char* path) noexcept;
+
+    //! Records a zone spanning the lifetime of the Scope object.
+    class Scope {
+    public:
+        explicit Scope(const char* name) noexcept
+                : mName(isEnabled() ? name : nullptr) {
+            if (UTILS_UNLIKELY(mName)) {
+                mStart = now();
+            }
+        }
+        ~Scope() noexcept {
+            if (UTILS_UNLIKELY(mName)) {
+                zone(mName, mStart, now());
+            }
+        }
+    private:
+        const char* mName;      // nullptr when tracing was disabled at scope entry
+        uint64_t mStart = 0;
+    };
+
+    static void asyncBegin(const char* name, int32_t cookie) noexcept;
+    static void asyncEnd(const char* name, int32_t cookie) noexcept;
+    static void value(const char* name, int64_t value) noexcept;
+
+    enum class Type : uint8_t { ZONE, ASYNC_BEGIN, ASYNC_END, VALUE };
+
+    // the name pointers must be string literals (they're kept, not copied)
+    struct Event {
+        const char* name;
+        uint64_t start;     // nanoseconds, see now()
+        uint64_t extra;     // ZONE: duration, VALUE: the value, ASYNC_*: the cookie
+        Type type;
+    };
+
+private:
+    friend class Scope;
+
+    static uint64_t now() noexcept {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static void zone(const char* name, uint64_t start, uint64_t end) noexcept;
+    static void record(Type type, const char* name, uint64_t start, uint64_t extra) noexcept;
+
+    static std::atomic<bool> sEnabled;
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_CPUTRACE_H
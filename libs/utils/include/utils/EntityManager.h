@@ -20,6 +20,8 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <atomic>
+
 #include <utils/Entity.h>
 
 namespace utils {
@@ -65,10 +67,12 @@ public:
     }
 
     // return whether the given Entity has been destroyed (false) or not (true).
-    // Thread safe.
+    // Thread safe and lock-free; this is called on hot paths (e.g. generation checks
+    // in component managers), so it's a single relaxed load of the generation table.
     bool isAlive(Entity e) const noexcept {
         assert(getIndex(e) < RAW_INDEX_COUNT);
-        return (!e.isNull()) && (getGeneration(e) == mGens[getIndex(e)]);
+        return (!e.isNull()) &&
+               (getGeneration(e) == mGens[getIndex(e)].load(std::memory_order_relaxed));
     }
 
     // registers a listener to be called when an entity is destroyed. thread safe.
@@ -87,7 +91,7 @@ public:
 
     // current generation of the given index. Use for debugging and testing.
     uint8_t getGenerationForIndex(size_t index) const noexcept {
-        return mGens[index];
+        return mGens[index].load(std::memory_order_relaxed);
     }
     // singleton, can't be copied
     EntityManager(const EntityManager& rhs) = delete;
@@ -114,8 +118,9 @@ private:
         return (g << GENERATION_SHIFT) | (i & INDEX_MASK);
     }
 
-    // stores the generation of each index.
-    uint8_t * const mGens;
+    // Stores the generation of each index. Written under the free-list lock (with
+    // release semantics), but read lock-free by isAlive().
+    std::atomic<uint8_t>* const mGens;
 };
 
 } // namespace utils
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_GPUCOUNTERS_H
+#define TNT_UTILS_GPUCOUNTERS_H
+
+#include <utils/compiler.h>
+
+#include <stdint.h>
+
+namespace utils {
+
+/**
+ * Reads GPU device counters exposed by the kernel drivers of tile-based mobile
+ * GPUs. This is the GPU-side sibling of Profiler (which wraps perf_event for CPU
+ * counters): sampling is a handful of sysfs reads, cheap enough for once-per-frame
+ * use in production builds.
+ *
+ * Sources probed, in order:
+ *  - Adreno (kgsl): the gpubusy node, which accumulates busy/total cycles since
+ *    the previous read, and the gpubw/busmon devfreq node, whose current
+ *    frequency is the memory-bus bandwidth vote in MB/s.
+ *  - Mali (kbase): the utilisation node (instantaneous busy percentage) and the
+ *    device's devfreq. Mali's raw hardware counters (DDK dumps) need a privileged
+ *    ioctl interface and are not read here.
+ *
+ * On platforms with none of these (desktop GPUs, locked-down sysfs), isValid()
+ * returns false and sample() returns zeroes.
+ */
+class GpuCounters {
+public:
+    static GpuCounters& get() noexcept;
+
+    GpuCounters(const GpuCounters& rhs) = delete;
+    GpuCounters(GpuCounters&& rhs) = delete;
+    GpuCounters& operator=(const GpuCounters& rhs) = delete;
+    GpuCounters& operator=(GpuCounters&& rhs) = delete;
+
+    // false when no supported counter source was found
+    bool isValid() const noexcept { return mValid; }
+
+    struct Sample {
+        uint64_t intervalNs = 0;    // wall time covered by this sample
+        uint64_t busyNs = 0;        // GPU busy time within the interval
+        uint64_t bytes = 0;         // memory-bus traffic within the interval (estimate)
+    };
+
+    // Reads the counters accumulated since the previous call. The first call
+    // establishes the baseline and returns zeroes.
+    Sample sample() noexcept;
+
+private:
+    GpuCounters() noexcept;
+    ~GpuCounters() noexcept;
+
+    // re-reads a sysfs node from the start; out must hold up to 2 values
+    static size_t readValues(int fd, int64_t* out, size_t count) noexcept;
+
+    int mBusyFd = -1;           // kgsl gpubusy: "<busy> <total>" since last read
+    int mUtilisationFd = -1;    // mali utilisation, in percent
+    int mBandwidthFd = -1;      // bus devfreq cur_freq, in MB/s
+    uint64_t mLastSampleTime = 0;
+    bool mValid = false;
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_GPUCOUNTERS_H
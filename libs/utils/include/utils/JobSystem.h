@@ -47,6 +47,7 @@ namespace utils {
 class JobSystem {
     static constexpr size_t MAX_JOB_COUNT = 4096;
     static_assert(MAX_JOB_COUNT <= 0x7FFE, "MAX_JOB_COUNT must be <= 0x7FFE");
+    static constexpr size_t MAX_STEAL_BATCH = 16;
     using WorkQueue = WorkStealingDequeue<uint16_t, MAX_JOB_COUNT>;
 
 public:
@@ -76,7 +77,8 @@ public:
             (CACHELINE_SIZE % sizeof(Job) == 0),
             "A Job must be N cache-lines long or N Jobs must fit in a cache line exactly.");
 
-    explicit JobSystem(size_t threadCount = 0, size_t adoptableThreadsCount = 1) noexcept;
+    explicit JobSystem(size_t threadCount = 0, size_t adoptableThreadsCount = 1,
+            size_t backgroundThreadCount = 0) noexcept;
 
     ~JobSystem();
 
@@ -220,7 +222,9 @@ public:
 
     // Add job to this thread's execution queue.
     // Current thread must be owned by JobSystem's thread pool. See adopt().
-    enum runFlags { DONT_SIGNAL = 0x1 };
+    // BACKGROUND hands the job to the EFFICIENCY group instead (see AffinityGroup below);
+    // if no EFFICIENCY workers exist, the job is queued normally.
+    enum runFlags { DONT_SIGNAL = 0x1, BACKGROUND = 0x2 };
     void run(Job* job, uint32_t flags = 0) noexcept;
 
     // Wait on a job.
@@ -254,10 +258,81 @@ public:
     static void setThreadPriority(Priority priority) noexcept;
     static void setThreadAffinity(uint32_t mask) noexcept;
 
+    // Named worker groups. All workers belong to the PERFORMANCE group, except for the
+    // backgroundThreadCount workers reserved at construction, which form the EFFICIENCY
+    // group. EFFICIENCY workers run at Priority::NORMAL and only service jobs submitted
+    // with the BACKGROUND flag, so latency-critical jobs never land on them.
+    enum class AffinityGroup : uint8_t { PERFORMANCE, EFFICIENCY };
+
+    // Restricts the workers of an affinity group to the given set of CPUs (bit i = CPU i).
+    // On big.LITTLE devices this is how render jobs are kept on the big cores while
+    // BACKGROUND jobs (e.g. asset decoding) run on the LITTLE cores. A zero mask -- the
+    // default -- leaves the threads free to migrate. Each worker applies the new mask the
+    // next time it wakes up.
+    void setAffinityGroup(AffinityGroup group, uint32_t cpuMask) noexcept;
+
     size_t getParallelSplitCount() const noexcept {
         return mParallelSplitCount;
     }
 
+    // Whether the calling thread's work queue is empty, i.e.: there is nothing left for
+    // other workers to steal from us. Must be called from a thread owned by JobSystem's
+    // thread pool. This is inherently racy and only a hint; it's used by
+    // jobs::AdaptiveSplitter to decide whether more splitting is worthwhile.
+    static bool isCurrentThreadWorkQueueEmpty() noexcept;
+
+    // Tunables for the work-stealing loop, for per-platform scheduling experiments.
+    // The defaults reproduce the historical behavior (steal one job, retry
+    // immediately). On machines with many cores and very small jobs, a batchCount
+    // of half the typical queue depth together with a modest backoff keeps the
+    // workers out of each other's way; measure, these are workload dependent.
+    struct StealPolicy {
+        // jobs taken from a victim per successful steal (clamped to [1, 16] and to
+        // half of what the victim has); the extras are re-queued on the thief's own
+        // queue, so other starving workers steal from it instead of storming the
+        // same victim
+        uint32_t batchCount = 1;
+        // pause instructions executed after an empty-handed steal attempt before
+        // picking another victim; limits CAS traffic when jobs are tiny and most
+        // attempts fail
+        uint32_t backoffPauses = 0;
+    };
+
+    // takes effect on the next steal attempt of each worker; can be called anytime
+    void setStealPolicy(StealPolicy policy) noexcept {
+        uint32_t batch = policy.batchCount;
+        if (batch < 1) { batch = 1; }
+        if (batch > MAX_STEAL_BATCH) { batch = MAX_STEAL_BATCH; }
+        mStealBatchCount.store(batch, std::memory_order_relaxed);
+        mStealBackoffPauses.store(policy.backoffPauses, std::memory_order_relaxed);
+    }
+
+    StealPolicy getStealPolicy() const noexcept {
+        return { mStealBatchCount.load(std::memory_order_relaxed),
+                 mStealBackoffPauses.load(std::memory_order_relaxed) };
+    }
+
+    // Steal telemetry, for tuning StealPolicy: cumulative counts since construction,
+    // aggregated over all workers (the per-worker breakdown is printed by the
+    // debugging operator<<). Collection is always on -- it's a couple of relaxed
+    // increments on a path that just failed to find work.
+    struct StealStatistics {
+        uint64_t attempts = 0;      // steal attempts (i.e. times a worker ran dry)
+        uint64_t failures = 0;      // attempts that came back empty-handed
+        uint64_t steals = 0;        // jobs successfully stolen
+    };
+
+    StealStatistics getStealStatistics() const noexcept;
+
+    // Deterministic scheduling mode, for bisecting performance regressions: when
+    // enabled -- it must be set before the JobSystem is constructed -- each worker's
+    // steal-victim generator is seeded from its worker index instead of the system
+    // entropy source, so the steal order repeats from run to run. Execution order is
+    // still not fully reproducible (the OS schedules the threads), but this removes
+    // our own source of randomness and tightens run-to-run timing variance.
+    static void setDeterministic(bool enabled) noexcept;
+    static bool isDeterministic() noexcept;
+
 private:
     // this is just to avoid using std::default_random_engine, since we're in a public header.
     class default_random_engine {
@@ -276,12 +351,19 @@ private:
         // make sure storage is cache-line aligned
         WorkQueue workQueue;
 
+        // steal telemetry; written only by the owning worker, read by
+        // getStealStatistics() and operator<<
+        std::atomic<uint64_t> stealAttempts = { 0 };
+        std::atomic<uint64_t> stealFailures = { 0 };
+        std::atomic<uint64_t> stealCount = { 0 };
+
         // these are not accessed by the worker threads
         alignas(CACHELINE_SIZE)     // this causes 56-bytes padding
         JobSystem* js;
         std::thread thread;
         default_random_engine rndGen;
         uint32_t mask;
+        AffinityGroup group;
     };
 
     static_assert(sizeof(ThreadState) % CACHELINE_SIZE == 0,
@@ -298,7 +380,9 @@ private:
     bool exitRequested() const noexcept;
 
     void loop(ThreadState* threadState) noexcept;
+    void loopBackground(ThreadState* threadState) noexcept;
     bool execute(JobSystem::ThreadState& state) noexcept;
+    void applyAffinityGroup(ThreadState const* state) noexcept;
 
     void put(WorkQueue& workQueue, Job* job) noexcept {
         size_t index = job - mJobStorageBase;
@@ -312,17 +396,16 @@ private:
         return !index ? nullptr : (mJobStorageBase - 1) + index;
     }
 
-    Job* steal(WorkQueue& workQueue) noexcept {
-        size_t index = workQueue.steal();
-        assert(index <= MAX_JOB_COUNT);
-        return !index ? nullptr : (mJobStorageBase - 1) + index;
-    }
+    // steals up to the policy's batch count from the victim's queue; the first job is
+    // returned, the extras are re-queued on the thief's own queue
+    Job* steal(ThreadState& state, ThreadState& victim) noexcept;
 
     // these have thread contention, keep them together
     utils::Mutex mLock;
     utils::Condition mCondition;
     std::atomic<uint32_t> mActiveJobs = { 0 };
     utils::Arena<utils::ThreadSafeObjectPoolAllocator<Job>, LockingPolicy::NoLock> mJobPool;
+    std::vector<Job*> mBackgroundQueue;                 // guarded by mLock
 
     template <typename T>
     using aligned_vector = std::vector<T, utils::STLAlignedAllocator<T>>;
@@ -337,12 +420,18 @@ private:
     aligned_vector<ThreadState> mThreadStates;          // actual data is stored offline
     std::atomic<bool> mExitRequested = { 0 };           // this one is almost never written
     std::atomic<uint16_t> mAdoptedThreads = { 0 };      // this one is almost never written
+    std::atomic<uint32_t> mAffinityMasks[2] = { { 0 }, { 0 } };  // almost never written
+    std::atomic<uint32_t> mAffinityEpoch = { 0 };       // bumped by setAffinityGroup()
+    std::atomic<uint32_t> mStealBatchCount = { 1 };     // almost never written
+    std::atomic<uint32_t> mStealBackoffPauses = { 0 };  // almost never written
     Job* const mJobStorageBase;                         // Base for conversion to indices
     uint16_t mThreadCount = 0;                          // total # of threads in the pool
+    uint16_t mBackgroundThreadCount = 0;                // # of EFFICIENCY threads in the pool
     uint8_t mParallelSplitCount = 0;                    // # of split allowable in parallel_for
     Job* mMasterJob = nullptr;
 
     static UTILS_DECLARE_TLS(ThreadState *) sThreadState;
+    static std::atomic<bool> sDeterministic;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -567,6 +656,25 @@ public:
     }
 };
 
+/*
+ * Lazy binary splitting: a range keeps splitting only while the calling worker's queue
+ * is empty -- i.e. while other workers could be starving. Once our queue has work in it
+ * that nobody stole, further splitting would only add job overhead, so we process the
+ * remaining range in place; if the queued half does get stolen, the thief resumes
+ * splitting against its own (empty) queue. This auto-balances skewed workloads without
+ * per-call-site split tuning.
+ *
+ * COUNT is the minimum number of items per job, MAX_SPLITS bounds the job explosion.
+ */
+template <size_t COUNT = 64, size_t MAX_SPLITS = 12>
+class AdaptiveSplitter {
+public:
+    bool split(size_t splits, size_t count) const noexcept {
+        return (splits < MAX_SPLITS && count >= COUNT * 2)
+                && JobSystem::isCurrentThreadWorkQueueEmpty();
+    }
+};
+
 } // namespace jobs
 } // namespace utils
 
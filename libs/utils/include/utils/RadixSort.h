@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_RADIXSORT_H
+#define TNT_UTILS_RADIXSORT_H
+
+#include <utils/JobSystem.h>
+#include <utils/Slice.h>
+#include <utils/compiler.h>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace utils {
+
+/*
+ * Stable LSD radix sort over a contiguous Slice<T>, one byte per pass.
+ *
+ * The key is provided by a functor mapping T const& to an unsigned integral; the number of
+ * passes is the key's size in bytes. All histograms are built in a single sweep over the
+ * keys -- sliced across the JobSystem workers when one is provided -- and a pass whose
+ * byte is identical across all keys is skipped entirely, so uniform high-order key fields
+ * cost nothing.
+ *
+ * The scatter passes ping-pong between the items and a caller-provided scratch slice of at
+ * least the same size, typically taken from a per-frame arena. Below MIN_COUNT elements,
+ * or when no scratch is available, this falls back to introsort on the keys, which wins at
+ * small sizes (note that unlike the radix passes, the fallback is not stable).
+ */
+class RadixSort {
+public:
+    // below this size the fixed cost of the radix passes doesn't pay for itself
+    static constexpr size_t MIN_COUNT = 512;
+
+    template<typename T, typename KeyFn>
+    static void sort(Slice<T> items, Slice<T> scratch, KeyFn keyOf) noexcept {
+        sortImpl(nullptr, items, scratch, keyOf);
+    }
+
+    // same as above, with the histogram sweep sliced across the JobSystem workers
+    // (the scatter passes stay sequential, they're what makes the sort stable)
+    template<typename T, typename KeyFn>
+    static void sort(JobSystem& js, Slice<T> items, Slice<T> scratch, KeyFn keyOf) noexcept {
+        sortImpl(&js, items, scratch, keyOf);
+    }
+
+private:
+    // below this size a parallel histogram sweep costs more than it saves
+    static constexpr size_t PARALLEL_MIN_COUNT = 4096;
+    static constexpr size_t CHUNK_COUNT_MAX = 8;
+
+    template<typename T, typename KeyFn>
+    static void sortImpl(JobSystem* js, Slice<T> items, Slice<T> scratch, KeyFn keyOf) noexcept {
+        using Key = typename std::decay<decltype(keyOf(items[0]))>::type;
+        static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value,
+                "radix sort keys must be unsigned integrals");
+        constexpr size_t PASS_COUNT = sizeof(Key);
+
+        T* const begin = items.data();
+        size_t const count = items.size();
+        if (count < MIN_COUNT || scratch.size() < count) {
+            std::sort(begin, begin + count, [&keyOf](T const& lhs, T const& rhs) {
+                return keyOf(lhs) < keyOf(rhs);
+            });
+            return;
+        }
+
+        struct Histograms {
+            uint32_t h[PASS_COUNT][256];
+        };
+
+        Histograms histograms = {};
+        size_t const chunkCount = js ? std::min(CHUNK_COUNT_MAX, count / PARALLEL_MIN_COUNT) : 1;
+        if (chunkCount > 1) {
+            std::unique_ptr<Histograms[]> chunks(new Histograms[chunkCount]());
+            Histograms* const chunkHistograms = chunks.get();
+            auto parent = js->createJob();
+            for (size_t c = 0; c < chunkCount; c++) {
+                size_t const first = c * count / chunkCount;
+                size_t const last = (c + 1) * count / chunkCount;
+                js->run(jobs::createJob(*js, parent,
+                        [begin, first, last, keyOf, histogram = chunkHistograms + c]() {
+                            for (size_t i = first; i < last; i++) {
+                                Key key = keyOf(begin[i]);
+                                for (size_t p = 0; p < PASS_COUNT; p++, key >>= 8) {
+                                    histogram->h[p][key & 0xffu]++;
+                                }
+                            }
+                        }));
+            }
+            js->runAndWait(parent);
+            for (size_t c = 0; c < chunkCount; c++) {
+                for (size_t p = 0; p < PASS_COUNT; p++) {
+                    for (size_t j = 0; j < 256; j++) {
+                        histograms.h[p][j] += chunkHistograms[c].h[p][j];
+                    }
+                }
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                Key key = keyOf(begin[i]);
+                for (size_t p = 0; p < PASS_COUNT; p++, key >>= 8) {
+                    histograms.h[p][key & 0xffu]++;
+                }
+            }
+        }
+
+        Key const key0 = keyOf(begin[0]);
+        T* UTILS_RESTRICT src = begin;
+        T* UTILS_RESTRICT dst = scratch.data();
+        for (size_t p = 0; p < PASS_COUNT; p++) {
+            uint32_t* const UTILS_RESTRICT histogram = histograms.h[p];
+            unsigned const shift = unsigned(p) * 8u;
+
+            // all keys share this byte, nothing to do for this pass
+            if (histogram[(key0 >> shift) & 0xffu] == count) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (size_t j = 0; j < 256; j++) {
+                uint32_t const h = histogram[j];
+                histogram[j] = offset;
+                offset += h;
+            }
+            for (size_t i = 0; i < count; i++) {
+                dst[histogram[(keyOf(src[i]) >> shift) & 0xffu]++] = src[i];
+            }
+            std::swap(src, dst);
+        }
+
+        if (src != begin) {
+            // odd number of scatter passes, move the result back in place
+            std::copy_n(src, count, begin);
+        }
+    }
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_RADIXSORT_H
@@ -219,7 +219,26 @@ private:
 } // namespace utils
 
 // ------------------------------------------------------------------------------------------------
-#else // !ANDROID
+#elif defined(UTILS_CPUTRACE) // !ANDROID
+// ------------------------------------------------------------------------------------------------
+
+// Always-available backend: fixed-size per-thread rings with chrome://tracing export
+// (see utils/CpuTrace.h). Tags are not supported; everything traces when enabled.
+
+#include <utils/CpuTrace.h>
+
+#define SYSTRACE_ENABLE() utils::CpuTrace::enable()
+#define SYSTRACE_DISABLE() utils::CpuTrace::disable()
+#define SYSTRACE_CONTEXT()
+#define SYSTRACE_NAME(name) utils::CpuTrace::Scope ___tracer(name)
+#define SYSTRACE_CALL() SYSTRACE_NAME(__FUNCTION__)
+#define SYSTRACE_ASYNC_BEGIN(name, cookie) utils::CpuTrace::asyncBegin(name, cookie)
+#define SYSTRACE_ASYNC_END(name, cookie) utils::CpuTrace::asyncEnd(name, cookie)
+#define SYSTRACE_VALUE32(name, val) utils::CpuTrace::value(name, int64_t(val))
+#define SYSTRACE_VALUE64(name, val) utils::CpuTrace::value(name, int64_t(val))
+
+// ------------------------------------------------------------------------------------------------
+#else // !ANDROID && !UTILS_CPUTRACE
 // ------------------------------------------------------------------------------------------------
 
 #define SYSTRACE_ENABLE()
@@ -36,10 +36,23 @@ class WorkStealingDequeue {
 public:
     using value_type = TYPE;
 
+    // outcome of a single steal attempt (see trySteal())
+    enum class StealResult { SUCCESS, EMPTY, LOST_RACE };
+
     inline void push(TYPE item) noexcept;
     inline TYPE pop() noexcept;
+
+    // single steal attempt; on LOST_RACE another thread (the owner or a thief) took
+    // the item from under us and the caller decides whether to retry or back off
+    inline StealResult trySteal(TYPE& item) noexcept;
+
+    // steals one item, retrying on lost races until it succeeds or the queue is empty
     inline TYPE steal() noexcept;
 
+    // steals up to count items, stopping at the first lost race so the caller's
+    // backoff policy applies; returns the number of items actually stolen
+    inline size_t steal(TYPE* out, size_t count) noexcept;
+
     size_t getSize() const noexcept { return COUNT; }
 
     bool isEmpty() const noexcept {
@@ -114,32 +127,61 @@ TYPE WorkStealingDequeue<TYPE, COUNT>::pop() noexcept {
 }
 
 template <typename TYPE, size_t COUNT>
-TYPE WorkStealingDequeue<TYPE, COUNT>::steal() noexcept {
-    do {
-        // mTop must be read before mBottom
-        int32_t top = mTop.load(std::memory_order_seq_cst);
+typename WorkStealingDequeue<TYPE, COUNT>::StealResult
+WorkStealingDequeue<TYPE, COUNT>::trySteal(TYPE& item) noexcept {
+    // mTop must be read before mBottom
+    int32_t top = mTop.load(std::memory_order_seq_cst);
 
-        // mBottom is written concurrently to the read below in pop() or push(), so
-        // we need basic atomicity. Also makes sure that writes made in push()
-        // (prior to mBottom update) are visible.
-        int32_t bottom = mBottom.load(std::memory_order_acquire);
+    // mBottom is written concurrently to the read below in pop() or push(), so
+    // we need basic atomicity. Also makes sure that writes made in push()
+    // (prior to mBottom update) are visible.
+    int32_t bottom = mBottom.load(std::memory_order_acquire);
 
-        if (top >= bottom) {
-            // queue is empty
-            return TYPE();
-        }
+    if (top >= bottom) {
+        // queue is empty
+        return StealResult::EMPTY;
+    }
 
-        // The queue isn't empty
-        TYPE item(getItemAt(top));
-        if (mTop.compare_exchange_strong(top, top + 1,
-                std::memory_order_seq_cst,
-                std::memory_order_relaxed)) {
-            // success: we stole a job, just return it.
-            return item;
-        }
-        // failure: the item we just tried to steal was pop()'ed under our feet,
-        // simply discard it; nothing to do.
-    } while (true);
+    // The queue isn't empty
+    item = getItemAt(top);
+    if (mTop.compare_exchange_strong(top, top + 1,
+            std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+        // success: we stole a job
+        return StealResult::SUCCESS;
+    }
+    // failure: the item we just tried to steal was pop()'ed or stolen under our
+    // feet, simply discard it; nothing to do.
+    return StealResult::LOST_RACE;
+}
+
+template <typename TYPE, size_t COUNT>
+TYPE WorkStealingDequeue<TYPE, COUNT>::steal() noexcept {
+    TYPE item{};
+    StealResult result;
+    do {
+        result = trySteal(item);
+    } while (result == StealResult::LOST_RACE);
+    return result == StealResult::SUCCESS ? item : TYPE();
+}
+
+template <typename TYPE, size_t COUNT>
+size_t WorkStealingDequeue<TYPE, COUNT>::steal(TYPE* out, size_t count) noexcept {
+    // never take more than half of what the owner appears to have, so it doesn't
+    // immediately run dry and turn around to steal from us (getCount() is racy,
+    // which is fine for a bound -- correctness comes from trySteal()'s CAS)
+    int32_t const half = (getCount() + 1) / 2;
+    if (half > 0 && count > size_t(half)) {
+        count = size_t(half);
+    }
+    // each item is taken with its own CAS: this doesn't make the steal cheaper, but
+    // it amortizes victim selection and lets the thief redistribute the extra items
+    // through its own queue, spreading future thieves across more queues
+    size_t n = 0;
+    while (n < count && trySteal(out[n]) == StealResult::SUCCESS) {
+        n++;
+    }
+    return n;
 }
 
 
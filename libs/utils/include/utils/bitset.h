@@ -33,6 +33,13 @@
 #   endif
 #endif
 
+#if !defined(TNT_UTILS_BITSET_USE_NEON)
+#   if defined(__SSE2__) || defined(__x86_64__)
+#       include <emmintrin.h>
+#       define TNT_UTILS_BITSET_USE_SSE2 1
+#   endif
+#endif
+
 namespace utils {
 
 /*
@@ -150,6 +157,15 @@ public:
             }
             return bool(r[0] | r[1]);
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i const* const p = (__m128i const*) storage;
+            __m128i r = _mm_loadu_si128(p);
+            for (size_t i = 1; i < BIT_COUNT / 128; ++i) {
+                r = _mm_or_si128(r, _mm_loadu_si128(p + i));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128())) != 0xFFFF;
+        } else
 #endif
         {
             T r = storage[0];
@@ -174,6 +190,15 @@ public:
             }
             return T(~(r[0] & r[1])) == T(0);
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i const* const p = (__m128i const*) storage;
+            __m128i r = _mm_loadu_si128(p);
+            for (size_t i = 1; i < BIT_COUNT / 128; ++i) {
+                r = _mm_and_si128(r, _mm_loadu_si128(p + i));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_set1_epi8(-1))) == 0xFFFF;
+        } else
 #endif
         {
             T r = storage[0];
@@ -195,6 +220,17 @@ public:
             }
             return bool(r[0] | r[1]);
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i const* const p = (__m128i const*) storage;
+            __m128i const* const q = (__m128i const*) b.storage;
+            __m128i r = _mm_xor_si128(_mm_loadu_si128(p), _mm_loadu_si128(q));
+            for (size_t i = 1; i < BIT_COUNT / 128; ++i) {
+                r = _mm_or_si128(r,
+                        _mm_xor_si128(_mm_loadu_si128(p + i), _mm_loadu_si128(q + i)));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128())) != 0xFFFF;
+        } else
 #endif
         {
             T r = storage[0] ^ b.storage[0];
@@ -218,6 +254,15 @@ public:
                 p[i] &= q[i];
             }
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i* const p = (__m128i*) storage;
+            __m128i const* const q = (__m128i const*) b.storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                _mm_storeu_si128(p + i,
+                        _mm_and_si128(_mm_loadu_si128(p + i), _mm_loadu_si128(q + i)));
+            }
+        } else
 #endif
         {
             for (size_t i = 0; i < N; ++i) {
@@ -227,6 +272,34 @@ public:
         return *this;
     }
 
+    // *this &= ~b, as a single pass (no temporary for the complement)
+    bitset& andNot(const bitset& b) noexcept {
+#if defined(TNT_UTILS_BITSET_USE_NEON)
+        if (BIT_COUNT % 128 == 0) {
+            uint8x16_t* const p = (uint8x16_t*) storage;
+            uint8x16_t const* const q = (uint8x16_t const*) b.storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                p[i] = vbicq_u8(p[i], q[i]);
+            }
+        } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i* const p = (__m128i*) storage;
+            __m128i const* const q = (__m128i const*) b.storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                _mm_storeu_si128(p + i,
+                        _mm_andnot_si128(_mm_loadu_si128(q + i), _mm_loadu_si128(p + i)));
+            }
+        } else
+#endif
+        {
+            for (size_t i = 0; i < N; ++i) {
+                storage[i] &= ~b.storage[i];
+            }
+        }
+        return *this;
+    }
+
     bitset& operator|=(const bitset& b) noexcept {
 #if defined(TNT_UTILS_BITSET_USE_NEON)
         if (BIT_COUNT % 128 == 0) {
@@ -236,6 +309,15 @@ public:
                 p[i] |= q[i];
             }
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i* const p = (__m128i*) storage;
+            __m128i const* const q = (__m128i const*) b.storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                _mm_storeu_si128(p + i,
+                        _mm_or_si128(_mm_loadu_si128(p + i), _mm_loadu_si128(q + i)));
+            }
+        } else
 #endif
         {
             for (size_t i = 0; i < N; ++i) {
@@ -254,6 +336,15 @@ public:
                 p[i] ^= q[i];
             }
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i* const p = (__m128i*) storage;
+            __m128i const* const q = (__m128i const*) b.storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                _mm_storeu_si128(p + i,
+                        _mm_xor_si128(_mm_loadu_si128(p + i), _mm_loadu_si128(q + i)));
+            }
+        } else
 #endif
         {
             for (size_t i = 0; i < N; ++i) {
@@ -273,6 +364,15 @@ public:
                 p[i] = ~q[i];
             }
         } else
+#elif defined(TNT_UTILS_BITSET_USE_SSE2)
+        if (BIT_COUNT % 128 == 0) {
+            __m128i* const p = (__m128i*) r.storage;
+            __m128i const* const q = (__m128i const*) storage;
+            for (size_t i = 0; i < BIT_COUNT / 128; ++i) {
+                _mm_storeu_si128(p + i,
+                        _mm_xor_si128(_mm_loadu_si128(q + i), _mm_set1_epi8(-1)));
+            }
+        } else
 #endif
         {
             for (size_t i = 0; i < N; ++i) {
@@ -294,6 +394,10 @@ private:
         return bitset(lhs) &= rhs;
     }
 
+    friend bitset andNot(const bitset& lhs, const bitset& rhs) noexcept {
+        return bitset(lhs).andNot(rhs);
+    }
+
     friend bitset operator|(const bitset& lhs, const bitset& rhs) noexcept {
         return bitset(lhs) |= rhs;
     }
@@ -47,6 +47,12 @@ public:
         }
     }
 
+    bool try_lock() noexcept {
+        uint32_t old_state = UNLOCKED;
+        return mState.compare_exchange_strong(old_state,
+                LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
     void unlock() noexcept {
         if (UTILS_UNLIKELY(mState.exchange(UNLOCKED, std::memory_order_release) == LOCKED_CONTENDED)) {
             linuxutil::futex_wake_ex(&mState, false, LOCKED);
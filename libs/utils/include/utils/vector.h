@@ -14,13 +14,152 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <utils/compiler.h>
+
 #ifndef UTILS_VECTOR_H
 #define UTILS_VECTOR_H
 
 namespace utils {
 
+/**
+ * A vector with inline storage for its first N elements. As long as the size stays
+ * at or below N no heap allocation is performed, which makes it suitable for per-frame
+ * scratch containers whose typical size is small but unbounded (per-frame malloc/free
+ * shows up as allocator lock contention in traces). Past N it grows on the heap like
+ * std::vector. Only the subset of the std::vector interface we actually use is provided.
+ */
+template<typename T, size_t N>
+class SmallVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    SmallVector() noexcept = default;
+
+    SmallVector(SmallVector const& rhs) {
+        reserve(rhs.mSize);
+        for (T const& v : rhs) {
+            push_back(v);
+        }
+    }
+
+    SmallVector& operator=(SmallVector const& rhs) {
+        if (this != &rhs) {
+            clear();
+            reserve(rhs.mSize);
+            for (T const& v : rhs) {
+                push_back(v);
+            }
+        }
+        return *this;
+    }
+
+    ~SmallVector() noexcept {
+        clear();
+        if (UTILS_UNLIKELY(mData != inlineStorage())) {
+            ::operator delete(mData);
+        }
+    }
+
+    T* data() noexcept { return mData; }
+    T const* data() const noexcept { return mData; }
+    size_t size() const noexcept { return mSize; }
+    size_t capacity() const noexcept { return mCapacity; }
+    bool empty() const noexcept { return mSize == 0; }
+
+    iterator begin() noexcept { return mData; }
+    iterator end() noexcept { return mData + mSize; }
+    const_iterator begin() const noexcept { return mData; }
+    const_iterator end() const noexcept { return mData + mSize; }
+
+    T& operator[](size_t i) noexcept { return mData[i]; }
+    T const& operator[](size_t i) const noexcept { return mData[i]; }
+    T& back() noexcept { return mData[mSize - 1]; }
+    T const& back() const noexcept { return mData[mSize - 1]; }
+
+    void push_back(T const& v) { emplace_back(v); }
+    void push_back(T&& v) { emplace_back(std::move(v)); }
+
+    template<typename ... ARGS>
+    T& emplace_back(ARGS&& ... args) {
+        if (UTILS_UNLIKELY(mSize == mCapacity)) {
+            grow(mCapacity * 2);
+        }
+        T* p = new(mData + mSize) T(std::forward<ARGS>(args)...);
+        mSize++;
+        return *p;
+    }
+
+    void pop_back() noexcept {
+        mSize--;
+        mData[mSize].~T();
+    }
+
+    void clear() noexcept {
+        for (size_t i = 0; i < mSize; i++) {
+            mData[i].~T();
+        }
+        mSize = 0;
+    }
+
+    void reserve(size_t capacity) {
+        if (UTILS_UNLIKELY(capacity > mCapacity)) {
+            grow(capacity);
+        }
+    }
+
+    void resize(size_t size) {
+        reserve(size);
+        while (mSize < size) {
+            new(mData + mSize) T();
+            mSize++;
+        }
+        while (mSize > size) {
+            pop_back();
+        }
+    }
+
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last) {
+        clear();
+        reserve(size_t(last - first));
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+private:
+    T* inlineStorage() noexcept { return reinterpret_cast<T*>(mStorage); }
+
+    void grow(size_t capacity) {
+        capacity = capacity > mCapacity * 2 ? capacity : mCapacity * 2;
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        for (size_t i = 0; i < mSize; i++) {
+            new(data + i) T(std::move_if_noexcept(mData[i]));
+            mData[i].~T();
+        }
+        if (mData != inlineStorage()) {
+            ::operator delete(mData);
+        }
+        mData = data;
+        mCapacity = capacity;
+    }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type mStorage[N];
+    T* mData = inlineStorage();
+    size_t mSize = 0;
+    size_t mCapacity = N;
+};
+
 /**
  * Inserts the specified item in the vector at its sorted position.
  */
@@ -22,6 +22,7 @@
 #include <algorithm>
 
 #include <utils/Log.h>
+#include <utils/ThreadLocal.h>
 
 namespace utils {
 
@@ -51,6 +52,123 @@ void LinearAllocator::swap(LinearAllocator& rhs) noexcept {
     std::swap(mCurrent, rhs.mCurrent);
 }
 
+// ------------------------------------------------------------------------------------------------
+// LinearAllocatorWithFallback
+// ------------------------------------------------------------------------------------------------
+
+LinearAllocatorWithFallback::~LinearAllocatorWithFallback() noexcept {
+    Slab* slab = mSlabs;
+    while (slab) {
+        Slab* const next = slab->next;
+        ::free(slab);
+        slab = next;
+    }
+}
+
+void* LinearAllocatorWithFallback::allocSlow(size_t size, size_t alignment, size_t extra) noexcept {
+    // first try the slabs we already have, starting with the current one
+    // (slabs past mCurrentSlab are always fully rewound)
+    Slab* slab = mCurrentSlab ? mCurrentSlab : mSlabs;
+    Slab* last = nullptr;
+    while (slab) {
+        void* const p = pointermath::align(slab->current, alignment, extra);
+        void* const c = pointermath::add(p, size);
+        if (c <= slab->end) {
+            slab->current = c;
+            mCurrentSlab = slab;
+            return p;
+        }
+        last = slab;
+        slab = slab->next;
+    }
+
+    // no retained slab can hold this allocation, get a new one from the heap,
+    // large enough for the allocation and its worst-case alignment padding
+    size_t slabSize = size + alignment + extra;
+    slabSize = slabSize > SLAB_SIZE ? slabSize : SLAB_SIZE;
+    slab = static_cast<Slab*>(malloc(sizeof(Slab) + slabSize));
+    if (UTILS_UNLIKELY(!slab)) {
+        return nullptr;
+    }
+    slab->next = nullptr;
+    slab->end = pointermath::add(slab->begin(), slabSize);
+    slab->current = slab->begin();
+    if (last) {
+        last->next = slab;
+    } else {
+        // walk to the tail; we got here without visiting any slab
+        Slab** pprev = &mSlabs;
+        while (*pprev) {
+            pprev = &(*pprev)->next;
+        }
+        *pprev = slab;
+    }
+    mCurrentSlab = slab;
+
+    void* const p = pointermath::align(slab->current, alignment, extra);
+    slab->current = pointermath::add(p, size);
+    assert(slab->current <= slab->end);
+    return p;
+}
+
+void LinearAllocatorWithFallback::rewind(void* p) noexcept {
+    size_t const current = allocated();
+    mHighWatermark = current > mHighWatermark ? current : mHighWatermark;
+
+    if (!mCurrentSlab) {
+        LinearAllocator::rewind(p);
+        return;
+    }
+
+    void* const begin = base();
+    void* const end = pointermath::add(begin,
+            LinearAllocator::allocated() + LinearAllocator::available());
+    if (p >= begin && p < end) {
+        // the rewind point is in the primary area, all slabs become free again
+        for (Slab* slab = mSlabs; slab; slab = slab->next) {
+            slab->current = slab->begin();
+        }
+        mCurrentSlab = nullptr;
+        LinearAllocator::rewind(p);
+        return;
+    }
+
+    // the rewind point is inside one of the slabs
+    for (Slab* slab = mSlabs; slab; slab = slab->next) {
+        if (p >= slab->begin() && p <= slab->end) {
+            slab->current = p;
+            mCurrentSlab = slab;
+            for (Slab* s = slab->next; s; s = s->next) {
+                s->current = s->begin();
+            }
+            return;
+        }
+    }
+    // this pointer doesn't belong to this allocator
+    assert(false);
+}
+
+void LinearAllocatorWithFallback::reset() noexcept {
+    size_t const current = allocated();
+    mHighWatermark = current > mHighWatermark ? current : mHighWatermark;
+    for (Slab* slab = mSlabs; slab; slab = slab->next) {
+        slab->current = slab->begin();
+    }
+    mCurrentSlab = nullptr;
+    LinearAllocator::reset();
+}
+
+size_t LinearAllocatorWithFallback::allocated() const noexcept {
+    size_t size = LinearAllocator::allocated();
+    for (Slab const* slab = mSlabs; slab; slab = slab->next) {
+        size += uintptr_t(slab->current) - uintptr_t(slab->begin());
+        if (slab == mCurrentSlab) {
+            break;
+        }
+    }
+    return size;
+}
+
 // ------------------------------------------------------------------------------------------------
 // FreeList
 // ------------------------------------------------------------------------------------------------
@@ -103,4 +221,12 @@ TrackingPolicy::HighWatermark::~HighWatermark() noexcept {
            << wm / 1024 << " KiB (" << wmpct << "%)" << io::endl;
 }
 
+// Each thread's scratch arena. Created on first use; the slab is released when the
+// thread exits (via the TLS destructor).
+static UTILS_DEFINE_TLS(ScratchArena) sScratchArena;
+
+ScratchArena& ScratchArena::get() noexcept {
+    return sScratchArena;
+}
+
 } // namespace utils
@@ -18,8 +18,27 @@
 
 #include <utils/compiler.h>
 
+#include <mutex>
+#include <unordered_set>
+
 namespace utils {
 
+const char* internString(const char* cstr) noexcept {
+    static std::unordered_set<const char*, hashCStrings, equalCStrings> sPool;
+    static std::mutex sPoolLock;
+
+    std::lock_guard<std::mutex> guard(sPoolLock);
+    auto pos = sPool.find(cstr);
+    if (pos != sPool.end()) {
+        return *pos;
+    }
+    size_t const length = strlen(cstr);
+    char* const copy = (char*)malloc(length + 1);
+    memcpy(copy, cstr, length + 1);
+    sPool.insert(copy);
+    return copy;
+}
+
 int StaticString::compare(const StaticString& rhs) const noexcept {
     size_type lhs_size = size();
     size_type rhs_size = rhs.size();
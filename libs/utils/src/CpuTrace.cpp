@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/CpuTrace.h>
+
+#include <utils/Mutex.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+namespace utils {
+
+std::atomic<bool> CpuTrace::sEnabled{ false };
+
+namespace {
+
+struct ThreadLog {
+    CpuTrace::Event events[CpuTrace::EVENT_COUNT];
+    // monotonically increasing; the slot is head & (EVENT_COUNT - 1), so the
+    // ring holds the most recent min(head, EVENT_COUNT) events in order
+    uint64_t head = 0;
+    uint32_t tid = 0;
+    ThreadLog* next = nullptr;
+};
+
+// all thread logs, linked at first use and never removed (logs must survive their
+// thread so late dumps still see its events)
+Mutex sRegistryLock;
+ThreadLog* sRegistry = nullptr;
+uint32_t sNextTid = 0;
+
+ThreadLog& getThreadLog() noexcept {
+    static thread_local ThreadLog* log = nullptr;
+    if (UTILS_UNLIKELY(!log)) {
+        log = new ThreadLog;
+        std::lock_guard<Mutex> guard(sRegistryLock);
+        log->tid = sNextTid++;
+        log->next = sRegistry;
+        sRegistry = log;
+    }
+    return *log;
+}
+
+void writeName(FILE* f, const char* name) noexcept {
+    fputc('"', f);
+    for (const char* p = name; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', f);
+        }
+        fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+} // anonymous namespace
+
+void CpuTrace::record(Type type, const char* name, uint64_t start, uint64_t extra) noexcept {
+    ThreadLog& log = getThreadLog();
+    Event& e = log.events[log.head & (EVENT_COUNT - 1)];
+    e = { name, start, extra, type };
+    log.head++;
+}
+
+void CpuTrace::zone(const char* name, uint64_t start, uint64_t end) noexcept {
+    record(Type::ZONE, name, start, end - start);
+}
+
+void CpuTrace::asyncBegin(const char* name, int32_t cookie) noexcept {
+    if (UTILS_UNLIKELY(isEnabled())) {
+        record(Type::ASYNC_BEGIN, name, now(), uint64_t(cookie));
+    }
+}
+
+void CpuTrace::asyncEnd(const char* name, int32_t cookie) noexcept {
+    if (UTILS_UNLIKELY(isEnabled())) {
+        record(Type::ASYNC_END, name, now(), uint64_t(cookie));
+    }
+}
+
+void CpuTrace::value(const char* name, int64_t value) noexcept {
+    if (UTILS_UNLIKELY(isEnabled())) {
+        record(Type::VALUE, name, now(), uint64_t(value));
+    }
+}
+
+bool CpuTrace::dump(const char* path) noexcept {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+
+    fputs("{\"traceEvents\":[\n", f);
+
+    std::lock_guard<Mutex> guard(sRegistryLock);
+    bool first = true;
+    for (ThreadLog* log = sRegistry; log; log = log->next) {
+        const uint64_t count = std::min(log->head, uint64_t(EVENT_COUNT));
+        for (uint64_t i = log->head - count; i < log->head; i++) {
+            Event const& e = log->events[i & (EVENT_COUNT - 1)];
+            if (!first) {
+                fputs(",\n", f);
+            }
+            first = false;
+            // chrome://tracing timestamps are in microseconds
+            const double ts = double(e.start) * 1e-3;
+            fputs("{\"name\":", f);
+            writeName(f, e.name);
+            switch (e.type) {
+                case Type::ZONE:
+                    fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                            ts, double(e.extra) * 1e-3);
+                    break;
+                case Type::ASYNC_BEGIN:
+                    fprintf(f, ",\"ph\":\"S\",\"ts\":%.3f,\"id\":%lld",
+                            ts, (long long)int64_t(e.extra));
+                    break;
+                case Type::ASYNC_END:
+                    fprintf(f, ",\"ph\":\"F\",\"ts\":%.3f,\"id\":%lld",
+                            ts, (long long)int64_t(e.extra));
+                    break;
+                case Type::VALUE:
+                    fprintf(f, ",\"ph\":\"C\",\"ts\":%.3f,\"args\":{\"value\":%lld}",
+                            ts, (long long)int64_t(e.extra));
+                    break;
+            }
+            fprintf(f, ",\"pid\":0,\"tid\":%u}", log->tid);
+        }
+    }
+
+    fputs("\n]}\n", f);
+    return fclose(f) == 0;
+}
+
+} // namespace utils
@@ -19,6 +19,7 @@
 
 #include <utils/EntityManager.h>
 
+#include <utils/AdaptiveMutex.h>
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/Mutex.h>
@@ -46,10 +47,10 @@ public:
     void create(size_t n, Entity* entities) {
         Entity::Type index;
         auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
+        std::atomic<uint8_t>* const gens = mGens;
 
         // this must be thread-safe, acquire the free-list mutex
-        std::lock_guard<Mutex> lock(mFreeListLock);
+        std::lock_guard<AdaptiveMutex> lock(mFreeListLock);
         Entity::Type currentIndex = mCurrentIndex;
         for (size_t i = 0; i < n; i++) {
             // If we have more than a certain number of freed indices, get one from the list.
@@ -73,16 +74,17 @@ public:
                 // that it doesn't happen in practice.
                 index = currentIndex++;
             }
-            entities[i] = Entity{ makeIdentity(gens[index], index) };
+            entities[i] = Entity{
+                    makeIdentity(gens[index].load(std::memory_order_relaxed), index) };
         }
         mCurrentIndex = currentIndex;
     }
 
     void destroy(size_t n, Entity* entities) noexcept {
         auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
+        std::atomic<uint8_t>* const gens = mGens;
 
-        std::unique_lock<Mutex> lock(mFreeListLock);
+        std::unique_lock<AdaptiveMutex> lock(mFreeListLock);
         for (size_t i = 0; i < n; i++) {
             if (!entities[i]) {
                 // behave like free(), ok to free null Entity.
@@ -99,11 +101,11 @@ public:
                 Entity::Type index = getIndex(entities[i]);
                 freeList.push_back(index);
 
-                // The generation update doesn't require the lock because it's only used for isAlive()
-                // and entities work as weak references -- it just means that isAlive() could return
-                // true a little longer than expected in some other threads.
-                // We do need a memory fence though, it is provided by the mFreeListLock.unlock() below.
-                gens[index]++;
+                // The generation update doesn't require the lock because it's only used for
+                // isAlive() and entities work as weak references -- it just means that
+                // isAlive() could return true a little longer than expected in some other
+                // threads. The release store pairs with the relaxed loads in isAlive().
+                gens[index].fetch_add(1, std::memory_order_release);
             }
         }
         lock.unlock();
@@ -117,13 +119,13 @@ public:
 
 
     void clear() noexcept {
-        uint8_t* const gens = mGens;
+        std::atomic<uint8_t>* const gens = mGens;
 
-        std::unique_lock<Mutex> lock(mFreeListLock);
+        std::unique_lock<AdaptiveMutex> lock(mFreeListLock);
 
         // make all indices that were ever used invalid
         for (size_t i = 0, c = mCurrentIndex; i < c; i++) {
-            gens[i]++;
+            gens[i].fetch_add(1, std::memory_order_release);
         }
 
         // clear the free-list entirely.
@@ -157,8 +159,9 @@ public:
 private:
     uint32_t mCurrentIndex = 1;
 
-    // stores indices that got freed
-    mutable Mutex mFreeListLock;
+    // stores indices that got freed; the critical sections around it are a few
+    // dozen nanoseconds, so parking on contention would dominate them
+    mutable AdaptiveMutex mFreeListLock;
     std::deque<Entity::Type> mFreeList;
 
     mutable Mutex mListenerLock;
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/GpuCounters.h>
+
+#include <stdlib.h>
+
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+
+namespace utils {
+
+#if defined(__linux__)
+
+// Known locations of the counter nodes; kernel and DT naming varies across devices,
+// so each counter probes a small list and keeps the first node that opens.
+static constexpr const char* BUSY_PATHS[] = {
+        "/sys/class/kgsl/kgsl-3d0/gpubusy",
+};
+static constexpr const char* UTILISATION_PATHS[] = {
+        "/sys/class/misc/mali0/device/utilisation",
+        "/sys/devices/platform/mali.0/utilisation",
+};
+static constexpr const char* BANDWIDTH_PATHS[] = {
+        "/sys/class/devfreq/soc:qcom,gpubw/cur_freq",
+        "/sys/class/devfreq/soc:qcom,kgsl-busmon/cur_freq",
+};
+
+template<size_t N>
+static int openFirst(const char* const (&paths)[N]) noexcept {
+    for (const char* path : paths) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+#endif // __linux__
+
+GpuCounters& GpuCounters::get() noexcept {
+    static GpuCounters sGpuCounters;
+    return sGpuCounters;
+}
+
+GpuCounters::GpuCounters() noexcept {
+#if defined(__linux__)
+    mBusyFd = openFirst(BUSY_PATHS);
+    if (mBusyFd < 0) {
+        mUtilisationFd = openFirst(UTILISATION_PATHS);
+    }
+    mBandwidthFd = openFirst(BANDWIDTH_PATHS);
+    mValid = mBusyFd >= 0 || mUtilisationFd >= 0;
+#endif
+}
+
+GpuCounters::~GpuCounters() noexcept {
+#if !defined(WIN32)
+    const int fds[] = { mBusyFd, mUtilisationFd, mBandwidthFd };
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+size_t GpuCounters::readValues(int fd, int64_t* out, size_t count) noexcept {
+#if !defined(WIN32)
+    char buffer[64];
+    ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    buffer[n] = '\0';
+    size_t read = 0;
+    char* p = buffer;
+    while (read < count) {
+        char* end;
+        int64_t v = strtoll(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        out[read++] = v;
+        p = end;
+    }
+    return read;
+#else
+    return 0;
+#endif
+}
+
+GpuCounters::Sample GpuCounters::sample() noexcept {
+    Sample sample;
+    if (!mValid) {
+        return sample;
+    }
+
+    const uint64_t now = uint64_t(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+    const uint64_t intervalNs = mLastSampleTime ? now - mLastSampleTime : 0;
+    mLastSampleTime = now;
+
+    int64_t values[2];
+    if (mBusyFd >= 0) {
+        // kgsl accumulates busy/total ticks since the previous read, so the ratio
+        // covers our sampling interval exactly (the tick unit cancels out)
+        if (readValues(mBusyFd, values, 2) == 2 && values[1] > 0) {
+            sample.busyNs = uint64_t(double(intervalNs)
+                    * double(values[0]) / double(values[1]));
+        }
+    } else if (mUtilisationFd >= 0) {
+        // mali reports an instantaneous busy percentage; treat it as constant over
+        // the interval, which is fine at per-frame sampling rates
+        if (readValues(mUtilisationFd, values, 1) == 1) {
+            sample.busyNs = intervalNs * uint64_t(values[0]) / 100;
+        }
+    }
+
+    if (mBandwidthFd >= 0) {
+        // the bus devfreq frequency is the bandwidth vote in MB/s
+        if (readValues(mBandwidthFd, values, 1) == 1) {
+            sample.bytes = uint64_t(double(values[0]) * 1e6 * double(intervalNs) * 1e-9);
+        }
+    }
+
+    sample.intervalNs = intervalNs;
+    return sample;
+}
+
+} // namespace utils
@@ -24,6 +24,8 @@
 
 #include <utils/JobSystem.h>
 
+#include <utils/Allocator.h>
+
 #include <cmath>
 #include <random>
 
@@ -58,6 +60,15 @@
 namespace utils {
 
 UTILS_DEFINE_TLS(JobSystem::ThreadState *) JobSystem::sThreadState(nullptr);
+std::atomic<bool> JobSystem::sDeterministic = { false };
+
+void JobSystem::setDeterministic(bool enabled) noexcept {
+    sDeterministic.store(enabled, std::memory_order_relaxed);
+}
+
+bool JobSystem::isDeterministic() noexcept {
+    return sDeterministic.load(std::memory_order_relaxed);
+}
 
 void JobSystem::setThreadName(const char* name) noexcept {
 #if defined(__linux__)
@@ -103,7 +114,23 @@ void JobSystem::setThreadAffinity(uint32_t mask) noexcept {
 #endif
 }
 
-JobSystem::JobSystem(size_t threadCount, size_t adoptableThreadsCount) noexcept
+void JobSystem::setAffinityGroup(AffinityGroup group, uint32_t cpuMask) noexcept {
+    mAffinityMasks[size_t(group)].store(cpuMask, std::memory_order_relaxed);
+    mAffinityEpoch.fetch_add(1, std::memory_order_release);
+    // wake everybody up so the new mask is applied promptly
+    { std::lock_guard<Mutex> lock(mLock); }
+    mCondition.notify_all();
+}
+
+void JobSystem::applyAffinityGroup(ThreadState const* state) noexcept {
+    uint32_t const mask = mAffinityMasks[size_t(state->group)].load(std::memory_order_relaxed);
+    if (mask) {
+        setThreadAffinity(mask);
+    }
+}
+
+JobSystem::JobSystem(size_t threadCount, size_t adoptableThreadsCount,
+        size_t backgroundThreadCount) noexcept
     : mJobPool("JobSystem Job pool", MAX_JOB_COUNT * sizeof(Job)),
       mJobStorageBase(static_cast<Job *>(mJobPool.getAllocator().getCurrent()))
 {
@@ -121,9 +148,13 @@ JobSystem::JobSystem(size_t threadCount, size_t adoptableThreadsCount) noexcept
         }
     }
     threadCount = std::min(size_t(UTILS_HAS_THREADING ? 32 : 0), threadCount);
+    backgroundThreadCount = std::min(size_t(UTILS_HAS_THREADING ? 8 : 0), backgroundThreadCount);
 
-    mThreadStates = aligned_vector<ThreadState>(threadCount + adoptableThreadsCount);
-    mThreadCount = uint16_t(threadCount);
+    mThreadStates = aligned_vector<ThreadState>(
+            threadCount + backgroundThreadCount + adoptableThreadsCount);
+    mThreadCount = uint16_t(threadCount + backgroundThreadCount);
+    mBackgroundThreadCount = uint16_t(backgroundThreadCount);
+    // only the PERFORMANCE workers take part in parallel_for
     mParallelSplitCount = (uint8_t)std::ceil((std::log2f(threadCount + adoptableThreadsCount)));
 
     // this is pitty these are not compile-time checks (C++17 supports it apparently)
@@ -131,15 +162,22 @@ JobSystem::JobSystem(size_t threadCount, size_t adoptableThreadsCount) noexcept
     assert(Job().runningJobCount.is_lock_free());
 
     std::random_device rd;
+    const bool deterministic = isDeterministic();
     const size_t hardwareThreadCount = mThreadCount;
     auto& states = mThreadStates;
 
     #pragma nounroll
     for (size_t i = 0, n = states.size(); i < n; i++) {
         auto& state = states[i];
-        state.rndGen = default_random_engine(rd());
+        // in deterministic mode each worker's steal order is a pure function of its
+        // index, so it repeats from run to run (see setDeterministic())
+        state.rndGen = default_random_engine(deterministic ? uint32_t(i + 1) : rd());
         state.mask = uint32_t(1UL << i);
         state.js = this;
+        // the last backgroundThreadCount pool threads form the EFFICIENCY group,
+        // adoptable slots are always PERFORMANCE
+        state.group = (i >= threadCount && i < hardwareThreadCount)
+                ? AffinityGroup::EFFICIENCY : AffinityGroup::PERFORMANCE;
         if (i < hardwareThreadCount) {
             // don't start a thread of adoptable thread slots
             state.thread = std::thread(&JobSystem::loop, this, &state);
@@ -190,6 +228,10 @@ inline JobSystem::ThreadState& JobSystem::getState() noexcept {
     return *sThreadState;
 }
 
+bool JobSystem::isCurrentThreadWorkQueueEmpty() noexcept {
+    return getState().workQueue.isEmpty();
+}
+
 JobSystem::Job* JobSystem::allocateJob() noexcept {
     return mJobPool.make<Job>();
 }
@@ -202,6 +244,33 @@ inline JobSystem::ThreadState& JobSystem::getStateToStealFrom(JobSystem::ThreadS
     return mThreadStates[index];
 }
 
+JobSystem::Job* JobSystem::steal(ThreadState& state, ThreadState& victim) noexcept {
+    state.stealAttempts.fetch_add(1, std::memory_order_relaxed);
+
+    uint16_t stolen[MAX_STEAL_BATCH];
+    size_t const batch = mStealBatchCount.load(std::memory_order_relaxed);
+    size_t const n = victim.workQueue.steal(stolen, batch);
+    if (UTILS_LIKELY(n)) {
+        state.stealCount.fetch_add(n, std::memory_order_relaxed);
+        assert(stolen[0] <= MAX_JOB_COUNT);
+        // keep the first job for ourselves, redistribute the extras through our own
+        // queue so other starving workers steal from us instead of all storming the
+        // same victim
+        for (size_t i = 1; i < n; i++) {
+            state.workQueue.push(stolen[i]);
+        }
+        return (mJobStorageBase - 1) + stolen[0];
+    }
+
+    state.stealFailures.fetch_add(1, std::memory_order_relaxed);
+    // back off before the next attempt, so that workloads made of many tiny jobs
+    // don't degenerate into CAS storms on the victims' queues (see StealPolicy)
+    for (uint32_t i = mStealBackoffPauses.load(std::memory_order_relaxed); i > 0; i--) {
+        UTILS_PAUSE();
+    }
+    return nullptr;
+}
+
 bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
 
     Job* job = pop(state.workQueue);
@@ -210,7 +279,7 @@ bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
         ThreadState& stateToStealFrom = getStateToStealFrom(state);
         if (&stateToStealFrom != &state) {
             // don't steal from our own queue
-            job = steal(stateToStealFrom.workQueue);
+            job = steal(state, stateToStealFrom);
             // nullptr -> nothing to steal in that queue either
         }
     }
@@ -234,18 +303,76 @@ bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
 
 void JobSystem::loop(ThreadState* threadState) noexcept {
     setThreadName("JobSystem::loop");
-    setThreadPriority(Priority::DISPLAY);
 
     // record our work queue to thread-local storage
     sThreadState = threadState;
 
+    // reserve this worker's scratch slab now, rather than faulting it in during a job
+    ScratchArena::get();
+
+    if (UTILS_UNLIKELY(threadState->group == AffinityGroup::EFFICIENCY)) {
+        // EFFICIENCY workers only service the background queue, at a lower priority
+        setThreadPriority(Priority::NORMAL);
+        loopBackground(threadState);
+        return;
+    }
+
+    setThreadPriority(Priority::DISPLAY);
+
     // run our main loop...
+    uint32_t appliedEpoch = 0;
     do {
+        uint32_t const epoch = mAffinityEpoch.load(std::memory_order_acquire);
+        if (UTILS_UNLIKELY(epoch != appliedEpoch)) {
+            appliedEpoch = epoch;
+            applyAffinityGroup(threadState);
+        }
         if (!execute(*threadState)) {
             std::unique_lock<Mutex> lock(mLock);
-            while (!exitRequested() && !(mActiveJobs.load(std::memory_order_relaxed))) {
+            while (!exitRequested() && !(mActiveJobs.load(std::memory_order_relaxed))
+                    && epoch == mAffinityEpoch.load(std::memory_order_relaxed)) {
+                mCondition.wait(lock);
+            }
+        }
+    } while (!exitRequested());
+}
+
+void JobSystem::loopBackground(ThreadState* threadState) noexcept {
+    uint32_t appliedEpoch = 0;
+    do {
+        uint32_t const epoch = mAffinityEpoch.load(std::memory_order_acquire);
+        if (UTILS_UNLIKELY(epoch != appliedEpoch)) {
+            appliedEpoch = epoch;
+            applyAffinityGroup(threadState);
+        }
+        Job* job = nullptr;
+        {
+            std::unique_lock<Mutex> lock(mLock);
+            while (!exitRequested() && mBackgroundQueue.empty()
+                    && epoch == mAffinityEpoch.load(std::memory_order_relaxed)) {
                 mCondition.wait(lock);
             }
+            if (!mBackgroundQueue.empty()) {
+                job = mBackgroundQueue.back();
+                mBackgroundQueue.pop_back();
+            }
+        }
+        if (job) {
+            if (UTILS_LIKELY(job->function)) {
+                job->function(job->padding, *this, job);
+            }
+            finish(job);
+            // the job may have enqueued children on our work queue with run(); drain them
+            // here so they too stay on the EFFICIENCY cores -- PERFORMANCE workers can
+            // still steal them if they run dry.
+            Job* child;
+            while ((child = pop(threadState->workQueue)) != nullptr) {
+                mActiveJobs.fetch_sub(1, std::memory_order_acq_rel);
+                if (UTILS_LIKELY(child->function)) {
+                    child->function(child->padding, *this, child);
+                }
+                finish(child);
+            }
         }
     } while (!exitRequested());
 }
@@ -308,6 +435,19 @@ void JobSystem::run(JobSystem::Job* job, uint32_t flags) noexcept {
     SYSTRACE_CALL();
 #endif
 
+    if (UTILS_UNLIKELY(flags & BACKGROUND)) {
+        if (mBackgroundThreadCount) {
+            // background jobs are handed to the EFFICIENCY group through a separate,
+            // lock-protected queue; they're infrequent enough that the lock doesn't matter.
+            std::unique_lock<Mutex> lock(mLock);
+            mBackgroundQueue.push_back(job);
+            lock.unlock();
+            mCondition.notify_all();
+            return;
+        }
+        // no EFFICIENCY workers in this pool, treat it as a regular job
+    }
+
     ThreadState& state(getState());
 
     // increase the active job count before we add the job to the queue, because otherwise
@@ -358,6 +498,9 @@ void JobSystem::adopt() {
         return;
     }
 
+    // make sure this thread has its scratch arena (see ScratchArena), then register it
+    ScratchArena::get();
+
     uint16_t adopted = mAdoptedThreads.fetch_add(1, std::memory_order_relaxed);
     size_t index = mThreadCount + adopted;
 
@@ -381,9 +524,25 @@ void JobSystem::emancipate() {
     sThreadState = nullptr;
 }
 
+JobSystem::StealStatistics JobSystem::getStealStatistics() const noexcept {
+    StealStatistics stats;
+    for (auto const& state : mThreadStates) {
+        stats.attempts += state.stealAttempts.load(std::memory_order_relaxed);
+        stats.failures += state.stealFailures.load(std::memory_order_relaxed);
+        stats.steals   += state.stealCount.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
 io::ostream& operator<<(io::ostream& out, JobSystem const& js) {
     for (auto const& item : js.mThreadStates) {
-        out << size_t(std::log2f(item.mask)) << ": " << item.workQueue.getCount() << io::endl;
+        uint64_t const attempts = item.stealAttempts.load(std::memory_order_relaxed);
+        uint64_t const failures = item.stealFailures.load(std::memory_order_relaxed);
+        uint64_t const steals = item.stealCount.load(std::memory_order_relaxed);
+        out << size_t(std::log2f(item.mask)) << ": " << item.workQueue.getCount()
+            << " (stolen " << size_t(steals)
+            << ", failed " << size_t(failures) << "/" << size_t(attempts) << ")"
+            << io::endl;
     }
     return out;
 }
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <functional>
 #include <bitset>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -319,3 +320,39 @@ TEST(AllocatorTest, STLAllocator) {
 
     EXPECT_EQ(0, arena.getListener().allocations.size());
 }
+
+TEST(AllocatorTest, ScratchArena) {
+    using utils::ScratchArena;
+
+    // same thread always gets the same arena
+    ScratchArena& arena = ScratchArena::get();
+    EXPECT_EQ(&arena, &ScratchArena::get());
+
+    void* outer;
+    {
+        ScratchArena::Scope scope;
+        outer = scope.allocate(64, 16);
+        EXPECT_TRUE(outer != nullptr);
+        {
+            // nested scopes rewind independently
+            ScratchArena::Scope nested;
+            void* inner = nested.allocate(64, 16);
+            EXPECT_TRUE(inner != nullptr);
+            EXPECT_NE(outer, inner);
+        }
+        // the nested scope's memory is available again
+        ScratchArena::Scope again;
+        EXPECT_TRUE(again.allocate(64, 16) != nullptr);
+    }
+    {
+        // the outer scope rewound everything
+        ScratchArena::Scope scope;
+        EXPECT_EQ(outer, scope.allocate(64, 16));
+    }
+
+    // each thread gets its own arena
+    ScratchArena* other = nullptr;
+    std::thread t([&other] { other = &ScratchArena::get(); });
+    t.join();
+    EXPECT_NE(&arena, other);
+}
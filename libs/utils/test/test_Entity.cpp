@@ -16,7 +16,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "../src/EntityManagerImpl.h"
 #include <utils/NameComponentManager.h>
@@ -129,6 +132,38 @@ TEST(EntityTest, Lots) {
 }
 
 
+TEST(EntityTest, ConcurrentIsAlive) {
+    // isAlive() is lock-free; poll stale handles from another thread while the
+    // generation table is being updated under the free-list lock
+    EntityManagerImpl em;
+    constexpr size_t N = 1024;
+    std::vector<Entity> entities(N);
+    em.create(N, entities.data());
+
+    // the reader polls its own stable copy of the handles, so the only shared
+    // mutable state is the generation table itself
+    const std::vector<Entity> stale(entities);
+    std::atomic<bool> done(false);
+    std::thread reader([&em, &stale, &done] {
+        while (!done.load(std::memory_order_relaxed)) {
+            for (Entity e : stale) {
+                em.isAlive(e);
+            }
+        }
+    });
+
+    for (size_t iter = 0; iter < 100; iter++) {
+        em.destroy(N, entities.data());
+        em.create(N, entities.data());
+    }
+    done.store(true);
+    reader.join();
+
+    for (Entity e : entities) {
+        EXPECT_TRUE(em.isAlive(e));
+    }
+}
+
 TEST(EntityTest, NameComponent) {
 
     EntityManagerImpl em;
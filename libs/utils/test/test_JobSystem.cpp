@@ -283,6 +283,73 @@ TEST(JobSystem, JobSystemParallelFor) {
     js.emancipate();
 }
 
+TEST(JobSystem, JobSystemParallelForAdaptive) {
+    JobSystem js;
+    js.adopt();
+
+    std::array<math::float3, 4096*16> vertices;
+    for (size_t j = 0; j<vertices.size(); ++j) {
+        vertices[j] = math::float3(j);
+    }
+
+    struct Executor {
+        void operator()(math::float3* v, size_t c) {
+            for (size_t i=0 ; i<c; ++i) {
+                v[i] = matrix * v[i];
+            }
+        }
+        math::mat3f matrix;
+    } state;
+    state.matrix = math::mat3f(2);
+
+    JobSystem::Job* job = parallel_for(js, nullptr, vertices.data(), vertices.size(),
+            std::ref(state), AdaptiveSplitter<4>());
+    js.runAndWait(job);
+
+    const math::mat3f matrix(2);
+    for (size_t j = 0; j<vertices.size(); ++j) {
+        EXPECT_TRUE(vertices[j] == matrix*math::float3(j));
+    }
+
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemBackgroundJobs) {
+    // two PERFORMANCE workers, one adoptable slot, one EFFICIENCY worker
+    JobSystem js(2, 1, 1);
+    js.adopt();
+
+    std::atomic_int counter = { 0 };
+
+    JobSystem::Job* job = js.createJob(nullptr,
+            [&counter](JobSystem&, JobSystem::Job*) {
+        counter.fetch_add(1);
+    });
+    js.run(job, JobSystem::BACKGROUND);
+    js.wait(job);
+    EXPECT_EQ(1, counter.load());
+
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemBackgroundJobsFallback) {
+    // no EFFICIENCY workers: BACKGROUND jobs must run as regular jobs
+    JobSystem js(2, 1);
+    js.adopt();
+
+    std::atomic_int counter = { 0 };
+
+    JobSystem::Job* job = js.createJob(nullptr,
+            [&counter](JobSystem&, JobSystem::Job*) {
+        counter.fetch_add(1);
+    });
+    js.run(job, JobSystem::BACKGROUND);
+    js.wait(job);
+    EXPECT_EQ(1, counter.load());
+
+    js.emancipate();
+}
+
 TEST(JobSystem, JobSystemDelegates) {
     JobSystem js;
     js.adopt();
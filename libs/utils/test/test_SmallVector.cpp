@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/vector.h>
+
+using namespace utils;
+
+TEST(SmallVectorTest, InlineStorage) {
+    SmallVector<int, 8> v;
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(8u, v.capacity());
+
+    const int* inlineData = v.data();
+    for (int i = 0; i < 8; i++) {
+        v.push_back(i);
+    }
+    // filling up to N must not allocate
+    EXPECT_EQ(inlineData, v.data());
+    EXPECT_EQ(8u, v.size());
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(i, v[i]);
+    }
+}
+
+TEST(SmallVectorTest, GrowsToHeap) {
+    SmallVector<int, 4> v;
+    for (int i = 0; i < 100; i++) {
+        v.push_back(i);
+    }
+    EXPECT_EQ(100u, v.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i, v[i]);
+    }
+
+    v.clear();
+    EXPECT_TRUE(v.empty());
+}
+
+TEST(SmallVectorTest, NonTrivialElements) {
+    static int liveCount = 0;
+    struct Tracked {
+        int value;
+        explicit Tracked(int value) : value(value) { liveCount++; }
+        Tracked(Tracked const& rhs) : value(rhs.value) { liveCount++; }
+        Tracked(Tracked&& rhs) noexcept : value(rhs.value) { liveCount++; }
+        ~Tracked() { liveCount--; }
+    };
+    {
+        SmallVector<Tracked, 2> v;
+        for (int i = 0; i < 10; i++) {
+            v.emplace_back(i);
+        }
+        EXPECT_EQ(10, liveCount);
+        EXPECT_EQ(7, v[7].value);
+        v.pop_back();
+        EXPECT_EQ(9, liveCount);
+    }
+    EXPECT_EQ(0, liveCount);
+}
+
+TEST(SmallVectorTest, AssignResizeCopy) {
+    const int data[] = { 1, 2, 3, 4, 5 };
+    SmallVector<int, 2> v;
+    v.assign(data, data + 5);
+    EXPECT_EQ(5u, v.size());
+    EXPECT_EQ(5, v.back());
+
+    v.resize(2);
+    EXPECT_EQ(2u, v.size());
+    v.resize(4);
+    EXPECT_EQ(4u, v.size());
+    EXPECT_EQ(0, v[3]);
+
+    SmallVector<int, 2> w(v);
+    EXPECT_EQ(4u, w.size());
+    EXPECT_EQ(2, w[1]);
+    w = v;
+    EXPECT_EQ(4u, w.size());
+}
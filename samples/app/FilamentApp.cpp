@@ -400,13 +400,11 @@ void FilamentApp::loadIBL(const Config& config) {
             return;
         }
 
-        if (!iblPath.isDirectory()) {
-            std::cerr << "The specified IBL path is not a directory: " << iblPath << std::endl;
-            return;
-        }
-
         mIBL = std::make_unique<IBL>(*mEngine);
-        if (!mIBL->loadFromDirectory(iblPath)) {
+
+        // a plain file is assumed to be a bundle generated with cmgen --deploy-bundle
+        if (!(iblPath.isDirectory()
+                ? mIBL->loadFromDirectory(iblPath) : mIBL->loadFromBundle(iblPath))) {
             std::cerr << "Could not load the specified IBL: " << iblPath << std::endl;
             mIBL.reset(nullptr);
             return;
@@ -16,6 +16,8 @@
 
 #include "IBL.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <string>
 
@@ -44,6 +46,99 @@ IBL::~IBL() {
     mEngine.destroy(mSkyboxTexture);
 }
 
+// Raw deployment bundle written by cmgen --deploy-bundle. All pixel data is tightly packed RGBM
+// in px/nx/py/ny/pz/nz order, starting at dataOffset. The layout must match the writer in
+// tools/cmgen/src/cmgen.cpp.
+struct BundleHeader {
+    uint32_t magic;         // BUNDLE_MAGIC
+    uint32_t dimensions;    // dimension of the base prefiltered miplevel
+    uint32_t levels;        // number of prefiltered miplevels
+    uint32_t shBands;       // number of SH bands (shBands^2 float3 coefficients follow the header)
+    uint32_t skyboxDim;     // dimension of the skybox faces, stored after the prefiltered levels
+    uint32_t dataOffset;    // file offset of the first prefiltered face
+};
+
+static constexpr uint32_t BUNDLE_MAGIC = 0x314c4249;    // 'IBL1', little-endian
+
+bool IBL::loadFromBundle(const utils::Path& path) {
+    std::ifstream input(path.getAbsolutePath(), std::ios::binary);
+
+    BundleHeader header;
+    if (!input.read((char*) &header, sizeof(header)) || header.magic != BUNDLE_MAGIC) {
+        std::cerr << path << " is not an IBL bundle" << std::endl;
+        return false;
+    }
+
+    // The coefficients are already pre-scaled, no parsing or conversion needed.
+    const size_t numCoefs = std::min(size_t(header.shBands * header.shBands), size_t(9));
+    if (!input.read((char*) mBands, numCoefs * sizeof(float3))) {
+        return false;
+    }
+
+    input.seekg(header.dataOffset);
+
+    // Prefiltered reflections: one contiguous read per miplevel.
+    const size_t numLevels = (size_t) std::log2(header.dimensions) + 1;
+    mTexture = Texture::Builder()
+            .width(header.dimensions)
+            .height(header.dimensions)
+            .levels((uint8_t) numLevels)
+            .format(Texture::InternalFormat::RGBA8)
+            .rgbm(true)
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .build(mEngine);
+
+    size_t dim = header.dimensions;
+    for (size_t level = 0; level < header.levels; level++, dim >>= 1) {
+        const size_t faceSize = dim * dim * 4;
+        Texture::FaceOffsets offsets;
+        Texture::PixelBufferDescriptor buffer(
+                malloc(faceSize * 6), faceSize * 6,
+                Texture::Format::RGBM, Texture::Type::UBYTE,
+                (Texture::PixelBufferDescriptor::Callback) &free);
+        for (size_t j = 0; j < 6; j++) {
+            offsets[j] = faceSize * j;
+        }
+        if (!input.read(static_cast<char*>(buffer.buffer), faceSize * 6)) {
+            return false;
+        }
+        mTexture->setImage(mEngine, level, std::move(buffer), offsets);
+    }
+
+    // Skybox: the unfiltered base level.
+    const size_t faceSize = size_t(header.skyboxDim) * header.skyboxDim * 4;
+    Texture::FaceOffsets offsets;
+    Texture::PixelBufferDescriptor buffer(
+            malloc(faceSize * 6), faceSize * 6,
+            Texture::Format::RGBM, Texture::Type::UBYTE,
+            (Texture::PixelBufferDescriptor::Callback) &free);
+    for (size_t j = 0; j < 6; j++) {
+        offsets[j] = faceSize * j;
+    }
+    if (!input.read(static_cast<char*>(buffer.buffer), faceSize * 6)) {
+        return false;
+    }
+    mSkyboxTexture = Texture::Builder()
+            .width(header.skyboxDim)
+            .height(header.skyboxDim)
+            .levels(1)
+            .format(Texture::InternalFormat::RGBA8)
+            .rgbm(true)
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .build(mEngine);
+    mSkyboxTexture->setImage(mEngine, 0, std::move(buffer), offsets);
+
+    mIndirectLight = IndirectLight::Builder()
+            .reflections(mTexture)
+            .irradiance(3, mBands)
+            .intensity(30000.0f)
+            .build(mEngine);
+
+    mSkybox = Skybox::Builder().environment(mSkyboxTexture).showSun(true).build(mEngine);
+
+    return true;
+}
+
 bool IBL::loadFromDirectory(const utils::Path& path) {
     // Read spherical harmonics
     Path sh(Path::concat(path, "sh.txt"));
@@ -40,6 +40,7 @@ public:
     ~IBL();
 
     bool loadFromDirectory(const utils::Path& path);
+    bool loadFromBundle(const utils::Path& path);
 
     filament::IndirectLight* getIndirectLight() const noexcept {
         return mIndirectLight;
@@ -16,6 +16,7 @@
 
 #include "MeshIO.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 #include <fcntl.h>
 #if !defined(WIN32)
 #    include <unistd.h>
+#    include <sys/mman.h>
 #else
 #    include <io.h>
 #endif
@@ -35,11 +37,11 @@
 
 #include <filament/Box.h>
 #include <filament/Engine.h>
-#include <filament/Fence.h>
 #include <filament/Material.h>
 #include <filament/MaterialInstance.h>
 #include <filament/RenderableManager.h>
 #include <filament/Scene.h>
+#include <filament/TransformManager.h>
 
 using namespace filament;
 using namespace math;
@@ -87,8 +89,31 @@ struct Part {
     uint32_t maxIndex;
     uint32_t materialID;
     Box      aabb;
+    // added in version 3; older files get this "never cull" default
+    math::float4 normalCone = { 0.0f, 0.0f, 0.0f, 1.0f };
 };
 
+// The vertex and index BufferDescriptors both point into the same memory-mapped (or, on
+// Windows, heap-allocated) file; the mapping is released when the engine is done with the
+// last of the two buffers.
+struct FileMapping {
+    char* data;
+    size_t size;
+    std::atomic<int> refs;
+};
+
+static void releaseMapping(void* buffer, size_t size, void* user) {
+    FileMapping* mapping = (FileMapping*) user;
+    if (--mapping->refs == 0) {
+#if !defined(WIN32)
+        munmap(mapping->data, mapping->size);
+#else
+        free(mapping->data);
+#endif
+        delete mapping;
+    }
+}
+
 MeshIO::Mesh MeshIO::loadMeshFromFile(filament::Engine* engine, const utils::Path& path,
         const std::map<std::string, filament::MaterialInstance*>& materials) {
 
@@ -97,10 +122,19 @@ MeshIO::Mesh MeshIO::loadMeshFromFile(filament::Engine* engine, const utils::Pat
     int fd = open(path.c_str(), O_RDONLY);
 
     size_t size = fileSize(fd);
+#if !defined(WIN32)
+    char* data = (char*) mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+    }
+#else
     char* data = (char*) malloc(size);
     read(fd, data, size);
+#endif
 
     if (data) {
+        // the loader holds a reference of its own, released below
+        FileMapping* mapping = new FileMapping { data, size, { 1 } };
         char *p = data;
 
         char magic[9];
@@ -118,8 +152,19 @@ MeshIO::Mesh MeshIO::loadMeshFromFile(filament::Engine* engine, const utils::Pat
             char* indices = p;
             p += header->indexSize;
 
-            Part* parts = (Part*) p;
-            p += header->parts * sizeof(Part);
+            if (header->version >= 2) {
+                // version 2 pads the index data so the part table is 4-byte aligned
+                p += (4 - (header->indexSize & 3)) & 3;
+            }
+
+            // version 3 appends a normal cone to each part record
+            const size_t partSize = header->version >= 3 ?
+                    sizeof(Part) : sizeof(Part) - sizeof(Part::normalCone);
+            std::vector<Part> parts(header->parts);
+            for (size_t i = 0; i < header->parts; i++) {
+                memcpy(&parts[i], p + i * partSize, partSize);
+            }
+            p += header->parts * partSize;
 
             uint32_t materialCount = (uint32_t) *p;
             p += sizeof(uint32_t);
@@ -141,8 +186,10 @@ MeshIO::Mesh MeshIO::loadMeshFromFile(filament::Engine* engine, const utils::Pat
                                                   : IndexBuffer::IndexType::UINT)
                     .build(*engine);
 
+            ++mapping->refs;
             mesh.indexBuffer->setBuffer(*engine,
-                    IndexBuffer::BufferDescriptor(indices, header->indexSize));
+                    IndexBuffer::BufferDescriptor(indices, header->indexSize,
+                            releaseMapping, mapping));
 
             VertexBuffer::Builder vbb;
             vbb.vertexCount(header->vertexCount)
@@ -166,31 +213,50 @@ MeshIO::Mesh MeshIO::loadMeshFromFile(filament::Engine* engine, const utils::Pat
 
             mesh.vertexBuffer = vbb.build(*engine);
 
-            VertexBuffer::BufferDescriptor buffer(vertexData, header->vertexSize);
+            ++mapping->refs;
+            VertexBuffer::BufferDescriptor buffer(vertexData, header->vertexSize,
+                    releaseMapping, mapping);
             mesh.vertexBuffer->setBufferAt(*engine, 0, std::move(buffer));
 
-            RenderableManager::Builder builder(header->parts);
-            builder.boundingBox(header->aabb);
-
-
-            for (size_t i = 0; i < header->parts; i++) {
-                builder.geometry(i, RenderableManager::PrimitiveType::TRIANGLES,
-                        mesh.vertexBuffer, mesh.indexBuffer, parts[i].offset,
-                        parts[i].minIndex, parts[i].maxIndex, parts[i].indexCount);
+            auto findMaterial = [&materials, &partsMaterial](size_t i) {
                 auto m = materials.find(partsMaterial[i]);
-                if (m != materials.end()) {
-                    builder.material(i, m->second);
-                } else {
-                    builder.material(i, materials.at("DefaultMaterial"));
-                }
+                return m != materials.end() ? m->second : materials.at("DefaultMaterial");
+            };
+
+            // One renderable per part: each part is culled against its own bounding box
+            // instead of the whole mesh's, so parts that fall outside the frustum don't
+            // generate draw calls. The first part's renderable also acts as the root of
+            // the transform hierarchy.
+            utils::EntityManager& em = utils::EntityManager::get();
+            auto& tcm = engine->getTransformManager();
+
+            mesh.renderable = em.create();
+            RenderableManager::Builder(1)
+                    .boundingBox(parts[0].aabb)
+                    .bounds(0, parts[0].aabb, parts[0].normalCone)
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            mesh.vertexBuffer, mesh.indexBuffer, parts[0].offset,
+                            parts[0].minIndex, parts[0].maxIndex, parts[0].indexCount)
+                    .material(0, findMaterial(0))
+                    .build(*engine, mesh.renderable);
+
+            mesh.parts.reserve(header->parts - 1);
+            for (size_t i = 1; i < header->parts; i++) {
+                utils::Entity entity = em.create();
+                tcm.create(entity, tcm.getInstance(mesh.renderable));
+                RenderableManager::Builder(1)
+                        .boundingBox(parts[i].aabb)
+                        .bounds(0, parts[i].aabb, parts[i].normalCone)
+                        .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                                mesh.vertexBuffer, mesh.indexBuffer, parts[i].offset,
+                                parts[i].minIndex, parts[i].maxIndex, parts[i].indexCount)
+                        .material(0, findMaterial(i))
+                        .build(*engine, entity);
+                mesh.parts.push_back(entity);
             }
-
-            mesh.renderable = utils::EntityManager::get().create();
-            builder.build(*engine, mesh.renderable);
         }
 
-        Fence::waitAndDestroy(engine->createFence());
-        free(data);
+        releaseMapping(nullptr, 0, mapping);
     }
     close(fd);
 
@@ -18,6 +18,9 @@
 #define TNT_FILAMENT_SAMPLE_MESHIO_H
 
 #include <map>
+#include <string>
+#include <vector>
+
 #include <utils/Entity.h>
 
 namespace filament {
@@ -36,6 +39,11 @@ class MeshIO {
 public:
     struct Mesh {
         utils::Entity renderable;
+        // Multi-part meshes get one renderable per part so each part is culled against
+        // its own bounding box. The first part lives on `renderable`; `parts` holds the
+        // entities of the remaining parts, parented to `renderable` in the transform
+        // hierarchy. Empty for single-part meshes.
+        std::vector<utils::Entity> parts;
         filament::VertexBuffer* vertexBuffer = nullptr;
         filament::IndexBuffer* indexBuffer = nullptr;
     };
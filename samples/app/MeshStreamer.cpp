@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshStreamer.h"
+
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include <string.h>
+
+#include <fcntl.h>
+#if !defined(WIN32)
+#    include <unistd.h>
+#    include <sys/mman.h>
+#else
+#    include <io.h>
+#endif
+
+#include <utils/EntityManager.h>
+
+#include <math/vec2.h>
+#include <math/vec4.h>
+
+#include <filament/Box.h>
+#include <filament/Engine.h>
+#include <filament/Fence.h>
+#include <filament/IndexBuffer.h>
+#include <filament/MaterialInstance.h>
+#include <filament/RenderableManager.h>
+#include <filament/Scene.h>
+#include <filament/TransformManager.h>
+#include <filament/VertexBuffer.h>
+
+using namespace filament;
+using namespace math;
+
+// how many renderables at most are built and attached per update() call
+static constexpr size_t ATTACH_PER_FRAME = 4;
+
+static size_t fileSize(int fd) {
+    size_t filesize;
+    filesize = (size_t) lseek(fd, 0, SEEK_END);
+    lseek(fd, 0, SEEK_SET);
+    return filesize;
+}
+
+// these mirror the filamesh format structures in MeshIO.cpp
+struct Header {
+    uint32_t version;
+    uint32_t parts;
+    Box      aabb;
+    uint32_t interleaved;
+    uint32_t offsetPosition;
+    uint32_t stridePosition;
+    uint32_t offsetTangents;
+    uint32_t strideTangents;
+    uint32_t offsetColor;
+    uint32_t strideColor;
+    uint32_t offsetUV0;
+    uint32_t strideUV0;
+    uint32_t offsetUV1;
+    uint32_t strideUV1;
+    uint32_t vertexCount;
+    uint32_t vertexSize;
+    uint32_t indexType;
+    uint32_t indexCount;
+    uint32_t indexSize;
+};
+
+struct Part {
+    uint32_t offset;
+    uint32_t indexCount;
+    uint32_t minIndex;
+    uint32_t maxIndex;
+    uint32_t materialID;
+    Box      aabb;
+    // added in version 3; older files get this "never cull" default
+    math::float4 normalCone = { 0.0f, 0.0f, 0.0f, 1.0f };
+};
+
+// The vertex and index BufferDescriptors both point into the same memory-mapped (or, on
+// Windows, heap-allocated) file; the mapping is released when the engine is done with the
+// last of the two buffers.
+struct FileMapping {
+    char* data;
+    size_t size;
+    std::atomic<int> refs;
+};
+
+static void releaseMapping(void* buffer, size_t size, void* user) {
+    FileMapping* mapping = (FileMapping*) user;
+    if (--mapping->refs == 0) {
+#if !defined(WIN32)
+        munmap(mapping->data, mapping->size);
+#else
+        free(mapping->data);
+#endif
+        delete mapping;
+    }
+}
+
+struct MeshStreamer::PendingLoad {
+    enum class Stage {
+        DECODING,   // a worker is mapping and parsing the file
+        DECODED,    // parse done; GPU buffers not created yet
+        WAITING,    // buffers created and uploads queued; waiting on the resource fence
+        ATTACHING,  // uploads done; renderables being attached, a few per frame
+        DONE,
+        FAILED
+    };
+
+    utils::Path path;
+    MaterialMap materials;
+
+    // written by the decode job, then published by the stage store; the main thread
+    // only reads these after observing DECODED
+    FileMapping* mapping = nullptr;
+    const Header* header = nullptr;
+    char* vertexData = nullptr;
+    char* indexData = nullptr;
+    std::vector<Part> parts;
+    std::vector<std::string> partsMaterial;
+
+    Mesh mesh;
+    Fence* fence = nullptr;
+    size_t nextPart = 0;
+
+    std::atomic<Stage> stage { Stage::DECODING };
+
+    // runs on a JobSystem worker
+    void decode() {
+        int fd = open(path.c_str(), O_RDONLY);
+        size_t size = fileSize(fd);
+#if !defined(WIN32)
+        char* data = (char*) mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+#else
+        char* data = (char*) malloc(size);
+        read(fd, data, size);
+#endif
+        close(fd);
+
+        if (!data) {
+            stage.store(Stage::FAILED, std::memory_order_release);
+            return;
+        }
+
+        // the loader holds a reference of its own, released when the last renderable
+        // has been attached (or the load abandoned)
+        mapping = new FileMapping { data, size, { 1 } };
+        char* p = data;
+
+        char magic[9];
+        memcpy(magic, (const char*) p, sizeof(char) * 8);
+        magic[8] = '\0';
+        p += sizeof(char) * 8;
+
+        if (strcmp("FILAMESH", magic) != 0) {
+            std::cerr << path << " is not a filamesh file" << std::endl;
+            releaseMapping(nullptr, 0, mapping);
+            mapping = nullptr;
+            stage.store(Stage::FAILED, std::memory_order_release);
+            return;
+        }
+
+        header = (Header const*) p;
+        p += sizeof(Header);
+
+        vertexData = p;
+        p += header->vertexSize;
+
+        indexData = p;
+        p += header->indexSize;
+
+        if (header->version >= 2) {
+            // version 2 pads the index data so the part table is 4-byte aligned
+            p += (4 - (header->indexSize & 3)) & 3;
+        }
+
+        // version 3 appends a normal cone to each part record
+        const size_t partSize = header->version >= 3 ?
+                sizeof(Part) : sizeof(Part) - sizeof(Part::normalCone);
+        parts.resize(header->parts);
+        for (size_t i = 0; i < header->parts; i++) {
+            memcpy(&parts[i], p + i * partSize, partSize);
+        }
+        p += header->parts * partSize;
+
+        uint32_t materialCount = (uint32_t) *p;
+        p += sizeof(uint32_t);
+
+        partsMaterial.resize(materialCount);
+        for (size_t i = 0; i < materialCount; i++) {
+            uint32_t nameLength = (uint32_t) *p;
+            p += sizeof(uint32_t);
+            partsMaterial[i] = p;
+            p += nameLength + 1; // null terminated
+        }
+
+        stage.store(Stage::DECODED, std::memory_order_release);
+    }
+
+    // main thread: creates the GPU buffers through the background resource queue; the
+    // descriptors alias the file mapping, no CPU-side copy is ever made
+    void createBuffers(Engine& engine) {
+        const bool wasAsync = engine.isAsyncResourceLoadingEnabled();
+        engine.setAsyncResourceLoadingEnabled(true);
+
+        mesh.indexBuffer = IndexBuffer::Builder()
+                .indexCount(header->indexCount)
+                .bufferType(header->indexType ? IndexBuffer::IndexType::USHORT
+                                              : IndexBuffer::IndexType::UINT)
+                .build(engine);
+
+        ++mapping->refs;
+        mesh.indexBuffer->setBuffer(engine,
+                IndexBuffer::BufferDescriptor(indexData, header->indexSize,
+                        releaseMapping, mapping));
+
+        VertexBuffer::Builder vbb;
+        vbb.vertexCount(header->vertexCount)
+            .bufferCount(1)
+            .normalized(VertexAttribute::TANGENTS)
+            .normalized(VertexAttribute::COLOR)
+            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::HALF4,
+                    header->offsetPosition, uint8_t(header->stridePosition))
+            .attribute(VertexAttribute::TANGENTS, 0, VertexBuffer::AttributeType::SHORT4,
+                    header->offsetTangents, uint8_t(header->strideTangents))
+            .attribute(VertexAttribute::COLOR,    0, VertexBuffer::AttributeType::UBYTE4,
+                    header->offsetColor, uint8_t(header->strideColor))
+            .attribute(VertexAttribute::UV0,      0, VertexBuffer::AttributeType::HALF2,
+                    header->offsetUV0, uint8_t(header->strideUV0));
+
+        if (header->offsetUV1 != std::numeric_limits<uint32_t>::max() &&
+                header->strideUV1 != std::numeric_limits<uint32_t>::max()) {
+            vbb.attribute(VertexAttribute::UV1,   0, VertexBuffer::AttributeType::HALF2,
+                    header->offsetUV1, uint8_t(header->strideUV1));
+        }
+
+        mesh.vertexBuffer = vbb.build(engine);
+
+        ++mapping->refs;
+        mesh.vertexBuffer->setBufferAt(engine, 0,
+                VertexBuffer::BufferDescriptor(vertexData, header->vertexSize,
+                        releaseMapping, mapping));
+
+        engine.setAsyncResourceLoadingEnabled(wasAsync);
+
+        // the buffers must not be referenced by a renderable until this has signaled
+        fence = engine.createResourceFence();
+    }
+
+    // main thread: builds and attaches up to `budget` renderables; returns how many
+    size_t attach(Engine& engine, Scene* scene, size_t budget) {
+        auto findMaterial = [this](size_t i) {
+            auto m = materials.find(partsMaterial[i]);
+            return m != materials.end() ? m->second : materials.at("DefaultMaterial");
+        };
+
+        utils::EntityManager& em = utils::EntityManager::get();
+        auto& tcm = engine.getTransformManager();
+
+        size_t attached = 0;
+        while (nextPart < header->parts && attached < budget) {
+            const size_t i = nextPart++;
+            utils::Entity entity = em.create();
+            if (i == 0) {
+                // like MeshIO, the first part's renderable is the root of the
+                // transform hierarchy
+                mesh.renderable = entity;
+            } else {
+                tcm.create(entity, tcm.getInstance(mesh.renderable));
+                mesh.parts.push_back(entity);
+            }
+            RenderableManager::Builder(1)
+                    .boundingBox(parts[i].aabb)
+                    .bounds(0, parts[i].aabb, parts[i].normalCone)
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            mesh.vertexBuffer, mesh.indexBuffer, parts[i].offset,
+                            parts[i].minIndex, parts[i].maxIndex, parts[i].indexCount)
+                    .material(0, findMaterial(i))
+                    .build(engine, entity);
+            scene->addEntity(entity);
+            attached++;
+        }
+        return attached;
+    }
+};
+
+MeshStreamer::MeshStreamer(Engine& engine)
+        : mEngine(engine), mJobSystem(2) {
+    // the main thread joins the pool so it can submit jobs
+    mJobSystem.adopt();
+}
+
+MeshStreamer::~MeshStreamer() {
+    // wait for in-flight decode jobs; their PendingLoad must outlive them
+    for (auto const& p : mPending) {
+        while (p->stage.load(std::memory_order_acquire) == PendingLoad::Stage::DECODING) {
+            std::this_thread::yield();
+        }
+    }
+    // release what never made it to the scene; GPU buffers already created are the
+    // engine's (and the app's) to destroy, like MeshIO meshes
+    for (auto const& p : mPending) {
+        if (p->fence) {
+            mEngine.destroy(p->fence);
+        }
+        if (p->mapping) {
+            releaseMapping(nullptr, 0, p->mapping);
+        }
+    }
+    mJobSystem.emancipate();
+}
+
+void MeshStreamer::load(const utils::Path& path, const MaterialMap& materials) {
+    mPending.emplace_back(new PendingLoad);
+    PendingLoad* p = mPending.back().get();
+    p->path = path;
+    p->materials = materials;
+    mJobSystem.run(utils::jobs::createJob(mJobSystem, nullptr, &PendingLoad::decode, p));
+}
+
+size_t MeshStreamer::update(Scene* scene) {
+    size_t attached = 0;
+    for (auto it = mPending.begin(); it != mPending.end(); ) {
+        PendingLoad* p = it->get();
+        switch (p->stage.load(std::memory_order_acquire)) {
+            case PendingLoad::Stage::DECODING:
+                break;
+            case PendingLoad::Stage::DECODED:
+                p->createBuffers(mEngine);
+                p->stage.store(PendingLoad::Stage::WAITING, std::memory_order_relaxed);
+                break;
+            case PendingLoad::Stage::WAITING:
+                // a zero timeout polls; FLUSH makes sure the queued resource commands
+                // are actually submitted
+                if (p->fence->wait(Fence::Mode::FLUSH, 0) ==
+                        Fence::FenceStatus::CONDITION_SATISFIED) {
+                    mEngine.destroy(p->fence);
+                    p->fence = nullptr;
+                    p->stage.store(PendingLoad::Stage::ATTACHING, std::memory_order_relaxed);
+                }
+                break;
+            case PendingLoad::Stage::ATTACHING:
+                attached += p->attach(mEngine, scene, ATTACH_PER_FRAME - attached);
+                if (p->nextPart == p->header->parts) {
+                    releaseMapping(nullptr, 0, p->mapping);
+                    p->mapping = nullptr;
+                    mMeshes.push_back(p->mesh);
+                    p->stage.store(PendingLoad::Stage::DONE, std::memory_order_relaxed);
+                }
+                break;
+            case PendingLoad::Stage::DONE:
+            case PendingLoad::Stage::FAILED:
+                it = mPending.erase(it);
+                continue;
+        }
+        ++it;
+    }
+    return attached;
+}
+
+bool MeshStreamer::isIdle() const {
+    return mPending.empty();
+}
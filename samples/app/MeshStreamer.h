@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_SAMPLE_MESHSTREAMER_H
+#define TNT_FILAMENT_SAMPLE_MESHSTREAMER_H
+
+#include "MeshIO.h"
+
+#include <utils/JobSystem.h>
+#include <utils/Path.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace filament {
+    class Engine;
+    class Fence;
+    class MaterialInstance;
+    class Scene;
+}
+
+/*
+ * A streaming filamesh loader: the intended fast path for getting meshes on screen
+ * without blocking the rendering thread.
+ *
+ * The pipeline has three stages, each overlapping the frame loop:
+ *  1. the file is memory-mapped and parsed on a JobSystem worker (no frame-thread I/O),
+ *  2. the GPU buffers are created on the main thread through the engine's background
+ *     resource queue (see Engine::setAsyncResourceLoadingEnabled()), with the buffer
+ *     descriptors pointing straight into the mapping -- the data is never copied on
+ *     the CPU -- and a resource fence marking the end of the uploads,
+ *  3. once the fence signals, the renderables are built and attached to the scene a
+ *     few parts per frame, so a large multi-part mesh doesn't hitch on its first frame.
+ *
+ * Usage: call load() for each mesh (returns immediately), then update() once per frame
+ * from the main thread -- e.g. from FilamentApp's pre-render callback -- until isIdle().
+ * Attached meshes accumulate in getMeshes(); destroying them is the caller's business,
+ * as with MeshIO.
+ */
+class MeshStreamer {
+public:
+    using Mesh = MeshIO::Mesh;
+    using MaterialMap = std::map<std::string, filament::MaterialInstance*>;
+
+    explicit MeshStreamer(filament::Engine& engine);
+
+    // drains in-flight loads (blocking if necessary)
+    ~MeshStreamer();
+
+    MeshStreamer(MeshStreamer const&) = delete;
+    MeshStreamer& operator=(MeshStreamer const&) = delete;
+
+    // Starts loading the given filamesh file; returns immediately. The material map is
+    // copied and consulted when the renderables are built; it needs a "DefaultMaterial"
+    // entry like MeshIO's.
+    void load(const utils::Path& path, const MaterialMap& materials);
+
+    // Advances the pipeline; must be called once per frame from the main thread.
+    // Returns the number of renderables attached to the scene during this call.
+    size_t update(filament::Scene* scene);
+
+    // true once every load() has been fully attached
+    bool isIdle() const;
+
+    // the meshes attached so far
+    const std::vector<Mesh>& getMeshes() const { return mMeshes; }
+
+private:
+    struct PendingLoad;
+
+    filament::Engine& mEngine;
+    // the loader's own worker pool; decode jobs are cheap and bounded, two workers are
+    // plenty and keep the engine's pool free for frame work
+    utils::JobSystem mJobSystem;
+    std::vector<std::unique_ptr<PendingLoad>> mPending;
+    std::vector<Mesh> mMeshes;
+};
+
+#endif // TNT_FILAMENT_SAMPLE_MESHSTREAMER_H
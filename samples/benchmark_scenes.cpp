@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Standardized, reproducible performance scenes for the device lab: procedurally
+// generated workloads (no asset dependencies, fixed random seeds) rendered for a
+// fixed number of frames, with the DebugRegistry counter snapshot, the GPU pass
+// timer queries and the CPU frame times written out as JSON. The same scene renders
+// the same frames on every device and every run, so the JSON can be diffed across
+// driver updates.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <getopt/getopt.h>
+
+#include <filament/Camera.h>
+#include <filament/Color.h>
+#include <filament/DebugRegistry.h>
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/TransformManager.h>
+#include <filament/View.h>
+
+#include <utils/EntityManager.h>
+#include <utils/Path.h>
+
+#include <math/mat4.h>
+#include <math/vec3.h>
+
+#include "app/Config.h"
+#include "app/FilamentApp.h"
+#include "app/Sphere.h"
+
+using namespace math;
+using namespace filament;
+using namespace utils;
+
+static constexpr uint8_t MATERIAL_LIT_PACKAGE[] = {
+    #include "generated/material/sandboxLit.inc"
+};
+
+static constexpr uint8_t MATERIAL_LIT_FADE_PACKAGE[] = {
+    #include "generated/material/sandboxLitFade.inc"
+};
+
+enum class SceneType {
+    CITY,           // 10k opaque draws under a shadow-casting sun
+    LIGHTS,         // 500 point lights over a field of objects (froxelizer load)
+    PARTICLES,      // heavily overlapping blended objects (bandwidth load)
+};
+
+struct FrameSample {
+    double cpuFrameMs;
+    Renderer::GpuPassTimings gpu;
+};
+
+static Config g_config;
+static SceneType g_sceneType = SceneType::CITY;
+static int g_frameCount = 600;
+static std::string g_jsonPath;
+
+static Material* g_litMaterial = nullptr;
+static Material* g_fadeMaterial = nullptr;
+static std::vector<Sphere> g_objects;
+static std::vector<Entity> g_lights;
+static std::vector<FrameSample> g_samples;
+static int g_currentFrame = 0;
+
+static void printUsage(char* name) {
+    std::string exec_name(Path(name).getName());
+    std::string usage(
+            "BENCHMARK_SCENES renders procedurally-generated performance scenes\n"
+            "Usage:\n"
+            "    BENCHMARK_SCENES [options]\n"
+            "\n"
+            "The scenes are fully procedural with fixed random seeds, so they render the\n"
+            "same frames on every run; the collected metrics can be diffed across devices\n"
+            "and driver versions.\n"
+            "\n"
+            "Options:\n"
+            "   --help, -h\n"
+            "       Prints this message\n\n"
+            "   --api, -a\n"
+            "       Specify the backend API: opengl (default) or vulkan\n\n"
+            "   --scene=[city|lights|particles], -s [city|lights|particles]\n"
+            "       city: 10k opaque draws under a shadow-casting sun (default)\n"
+            "       lights: 500 point lights over a field of objects\n"
+            "       particles: heavily overlapping blended objects\n\n"
+            "   --frames=[integer > 0], -c [integer > 0]\n"
+            "       Number of frames to render before exiting (default 600)\n\n"
+            "   --json=<path>, -j <path>\n"
+            "       Write the collected metrics to <path> as JSON\n\n"
+    );
+    const std::string from("BENCHMARK_SCENES");
+    for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
+        usage.replace(pos, from.length(), exec_name);
+    }
+    std::cout << usage;
+}
+
+static int handleCommandLineArgments(int argc, char* argv[], Config* config) {
+    static constexpr const char* OPTSTR = "ha:s:c:j:";
+    static const struct option OPTIONS[] = {
+            { "help",   no_argument,       nullptr, 'h' },
+            { "api",    required_argument, nullptr, 'a' },
+            { "scene",  required_argument, nullptr, 's' },
+            { "frames", required_argument, nullptr, 'c' },
+            { "json",   required_argument, nullptr, 'j' },
+            { nullptr, 0, nullptr, 0 }  // termination of the option list
+    };
+    int opt;
+    int option_index = 0;
+    while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &option_index)) >= 0) {
+        std::string arg(optarg ? optarg : "");
+        switch (opt) {
+            default:
+            case 'h':
+                printUsage(argv[0]);
+                exit(0);
+            case 'a':
+                if (arg == "opengl") {
+                    config->backend = Engine::Backend::OPENGL;
+                } else if (arg == "vulkan") {
+                    config->backend = Engine::Backend::VULKAN;
+                } else {
+                    std::cerr << "Unrecognized backend. Must be 'opengl'|'vulkan'." << std::endl;
+                }
+                break;
+            case 's':
+                if (arg == "city") {
+                    g_sceneType = SceneType::CITY;
+                } else if (arg == "lights") {
+                    g_sceneType = SceneType::LIGHTS;
+                } else if (arg == "particles") {
+                    g_sceneType = SceneType::PARTICLES;
+                } else {
+                    std::cerr << "Unrecognized scene. Must be 'city'|'lights'|'particles'."
+                              << std::endl;
+                }
+                break;
+            case 'c':
+                g_frameCount = std::max(1, atoi(arg.c_str()));
+                break;
+            case 'j':
+                g_jsonPath = arg;
+                break;
+        }
+    }
+    return optind;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static void addObject(Engine* engine, Scene* scene, Material const* material,
+        float3 position, float3 scale, float3 color, float roughness, float alpha) {
+    g_objects.emplace_back(*engine, material, true);
+    Sphere& object = g_objects.back();
+    MaterialInstance* mi = object.getMaterialInstance();
+    mi->setParameter("baseColor", color);
+    mi->setParameter("roughness", roughness);
+    mi->setParameter("metallic", 0.0f);
+    mi->setParameter("reflectance", 0.5f);
+    mi->setParameter("clearCoat", 0.0f);
+    mi->setParameter("clearCoatRoughness", 0.0f);
+    mi->setParameter("anisotropy", 0.0f);
+    if (material == g_fadeMaterial) {
+        mi->setParameter("alpha", alpha);
+    }
+    auto& tcm = engine->getTransformManager();
+    tcm.create(object.getSolidRenderable(), {},
+            mat4f::translate(position) * mat4f::scale(scale));
+    scene->addEntity(object.getSolidRenderable());
+}
+
+static Entity addSun(Engine* engine, Scene* scene, bool shadows) {
+    Entity sun = EntityManager::get().create();
+    LightManager::Builder(LightManager::Type::SUN)
+            .color(Color::toLinear<ACCURATE>({0.98f, 0.92f, 0.89f}))
+            .intensity(110000.0f)
+            .direction(normalize(float3{ 0.6f, -1.0f, -0.8f }))
+            .castShadows(shadows)
+            .build(*engine, sun);
+    scene->addEntity(sun);
+    return sun;
+}
+
+// 10k-draw city: a jittered grid of scaled "buildings", one shadow-casting sun.
+// Exercises command generation, culling and the shadow pass at high draw counts.
+static void buildCity(Engine* engine, Scene* scene) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+
+    constexpr int GRID = 100;       // 100 x 100 = 10,000 draws
+    g_objects.reserve(GRID * GRID);
+    for (int x = 0; x < GRID; x++) {
+        for (int z = 0; z < GRID; z++) {
+            const float h = 0.5f + 3.5f * rand(gen) * rand(gen);
+            const float3 position{
+                    (x - GRID / 2) * 2.0f + 0.5f * rand(gen),
+                    h * 0.5f,
+                    (z - GRID / 2) * 2.0f + 0.5f * rand(gen) };
+            const float c = 0.3f + 0.5f * rand(gen);
+            addObject(engine, scene, g_litMaterial,
+                    position, { 0.6f, h, 0.6f }, { c, c, c }, 0.4f + 0.5f * rand(gen), 1.0f);
+        }
+    }
+    g_lights.push_back(addSun(engine, scene, true));
+}
+
+// 500-light night scene: a field of objects lit by point lights. Exercises the
+// froxelizer and the per-fragment light loops.
+static void buildLights(Engine* engine, Scene* scene) {
+    std::mt19937 gen(43);
+    std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+
+    constexpr int GRID = 32;        // ~1k receivers
+    g_objects.reserve(GRID * GRID);
+    for (int x = 0; x < GRID; x++) {
+        for (int z = 0; z < GRID; z++) {
+            const float3 position{ (x - GRID / 2) * 2.5f, 0.0f, (z - GRID / 2) * 2.5f };
+            addObject(engine, scene, g_litMaterial,
+                    position, { 1.0f, 0.3f, 1.0f }, { 0.8f, 0.8f, 0.8f },
+                    0.2f + 0.7f * rand(gen), 1.0f);
+        }
+    }
+
+    constexpr int LIGHT_COUNT = 500;
+    auto& em = EntityManager::get();
+    for (int i = 0; i < LIGHT_COUNT; i++) {
+        Entity light = em.create();
+        LightManager::Builder(LightManager::Type::POINT)
+                .color(Color::toLinear<ACCURATE>({ rand(gen), rand(gen), rand(gen) }))
+                .intensity(3000.0f)
+                .position({ (rand(gen) - 0.5f) * 80.0f, 1.0f + 2.0f * rand(gen),
+                            (rand(gen) - 0.5f) * 80.0f })
+                .falloff(4.0f + 4.0f * rand(gen))
+                .build(*engine, light);
+        scene->addEntity(light);
+        g_lights.push_back(light);
+    }
+}
+
+// Heavy-transparency particles: large, heavily overlapping blended objects around
+// the camera axis. Exercises sorting, blending and fill-rate/bandwidth.
+static void buildParticles(Engine* engine, Scene* scene) {
+    std::mt19937 gen(44);
+    std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+
+    constexpr int COUNT = 2000;
+    g_objects.reserve(COUNT);
+    for (int i = 0; i < COUNT; i++) {
+        const float3 position{
+                (rand(gen) - 0.5f) * 30.0f,
+                (rand(gen) - 0.5f) * 15.0f,
+                (rand(gen) - 0.5f) * 30.0f };
+        const float s = 1.0f + 3.0f * rand(gen);
+        addObject(engine, scene, g_fadeMaterial,
+                position, { s, s, s }, { rand(gen), rand(gen), 1.0f },
+                0.8f, 0.1f + 0.2f * rand(gen));
+    }
+    g_lights.push_back(addSun(engine, scene, false));
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static bool writeJson(const char* path, Engine* engine) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+
+    const char* sceneName = g_sceneType == SceneType::CITY ? "city"
+            : g_sceneType == SceneType::LIGHTS ? "lights" : "particles";
+    fprintf(f, "{\"scene\":\"%s\",\"frames\":%d,\n", sceneName, g_frameCount);
+
+    // per-frame CPU time and GPU pass times (the timer queries lag by a few frames,
+    // which doesn't matter here: every frame renders the same workload)
+    fputs("\"samples\":[\n", f);
+    for (size_t i = 0; i < g_samples.size(); i++) {
+        FrameSample const& s = g_samples[i];
+        fprintf(f, "  {\"cpu_ms\":%.3f,\"gpu_shadow_ns\":%llu,\"gpu_color_ns\":%llu,"
+                "\"gpu_postprocess_ns\":%llu}%s\n",
+                s.cpuFrameMs,
+                (unsigned long long)s.gpu.shadowPass,
+                (unsigned long long)s.gpu.colorPass,
+                (unsigned long long)s.gpu.postProcess,
+                i + 1 < g_samples.size() ? "," : "");
+    }
+    fputs("],\n", f);
+
+    // the engine's counter snapshot (draw calls, pool hits, GPU busy time, ...)
+    auto counters = engine->getDebugRegistry().getCounters();
+    fputs("\"counters\":{\n", f);
+    for (size_t i = 0; i < counters.second; i++) {
+        fprintf(f, "  \"%s\":%llu%s\n", counters.first[i].name,
+                (unsigned long long)counters.first[i].value,
+                i + 1 < counters.second ? "," : "");
+    }
+    fputs("}}\n", f);
+    return fclose(f) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    handleCommandLineArgments(argc, argv, &g_config);
+    g_config.title = "benchmark_scenes";
+    g_samples.reserve(size_t(g_frameCount));
+
+    auto setup = [](Engine* engine, View* view, Scene* scene) {
+        g_litMaterial = Material::Builder()
+                .package((void*) MATERIAL_LIT_PACKAGE, sizeof(MATERIAL_LIT_PACKAGE))
+                .build(*engine);
+        g_fadeMaterial = Material::Builder()
+                .package((void*) MATERIAL_LIT_FADE_PACKAGE, sizeof(MATERIAL_LIT_FADE_PACKAGE))
+                .build(*engine);
+
+        switch (g_sceneType) {
+            case SceneType::CITY:      buildCity(engine, scene);      break;
+            case SceneType::LIGHTS:    buildLights(engine, scene);    break;
+            case SceneType::PARTICLES: buildParticles(engine, scene); break;
+        }
+    };
+
+    auto cleanup = [](Engine* engine, View*, Scene*) {
+        g_objects.clear();  // each Sphere destroys its renderable and material instance
+        for (Entity light : g_lights) {
+            engine->destroy(light);
+            EntityManager::get().destroy(light);
+        }
+        engine->destroy(g_litMaterial);
+        engine->destroy(g_fadeMaterial);
+    };
+
+    // deterministic camera path: a slow orbit around the scene, a pure function of
+    // the frame index (not of wall-clock time, so slow devices render the same frames)
+    FilamentApp& filamentApp = FilamentApp::get();
+    filamentApp.animate([](Engine*, View* view, double) {
+        const double t = double(g_currentFrame) / double(g_frameCount);
+        const float angle = float(2.0 * M_PI * t);
+        const float distance = g_sceneType == SceneType::PARTICLES ? 25.0f : 60.0f;
+        view->getCamera().lookAt(
+                { distance * std::cos(angle), 20.0f, distance * std::sin(angle) },
+                { 0.0f, 0.0f, 0.0f });
+    });
+
+    auto preRender = [](Engine*, View*, Scene*, Renderer*) {
+    };
+
+    auto postRender = [](Engine* engine, View*, Scene*, Renderer* renderer) {
+        using namespace std::chrono;
+        static steady_clock::time_point lastFrame = steady_clock::now();
+        const steady_clock::time_point now = steady_clock::now();
+        g_samples.push_back({
+                duration<double, std::milli>(now - lastFrame).count(),
+                renderer->getGpuPassTimings() });
+        lastFrame = now;
+
+        if (++g_currentFrame >= g_frameCount) {
+            if (!g_jsonPath.empty()) {
+                if (!writeJson(g_jsonPath.c_str(), engine)) {
+                    std::cerr << "could not write " << g_jsonPath << std::endl;
+                }
+            }
+            FilamentApp::get().close();
+        }
+    };
+
+    filamentApp.run(g_config, setup, cleanup, FilamentApp::ImGuiCallback(),
+            preRender, postRender);
+
+    return 0;
+}
@@ -160,6 +160,10 @@ static void cleanup(Engine* engine, View*, Scene*) {
         engine->destroy(mesh.indexBuffer);
         engine->destroy(mesh.renderable);
         em.destroy(mesh.renderable);
+        for (auto part : mesh.parts) {
+            engine->destroy(part);
+            em.destroy(part);
+        }
     }
     engine->destroy(g_light);
     em.destroy(g_light);
@@ -319,6 +323,9 @@ static void setup(Engine* engine, View*, Scene* scene) {
             tcm.setTransform(ei, mat4f{ mat3f(g_config.scale), float3(0.0f, 0.0f, -4.0f) } *
                                  tcm.getWorldTransform(ei));
             scene->addEntity(mesh.renderable);
+            for (auto part : mesh.parts) {
+                scene->addEntity(part);
+            }
             g_meshes.push_back(mesh);
         }
     }
@@ -155,6 +155,10 @@ static void cleanup(Engine* engine, View* view, Scene* scene) {
         engine->destroy(mesh.indexBuffer);
         engine->destroy(mesh.renderable);
         em.destroy(mesh.renderable);
+        for (auto part : mesh.parts) {
+            engine->destroy(part);
+            em.destroy(part);
+        }
     }
     engine->destroy(g_light);
 }
@@ -238,6 +242,15 @@ static void setup(Engine* engine, View* view, Scene* scene) {
                     blendingMode == BlendingMode::OPAQUE || blendingMode == BlendingMode::MASKED);
             rcm.setReceiveShadows(ri, true);
             scene->addEntity(mesh.renderable);
+            for (auto part : mesh.parts) {
+                auto pi = rcm.getInstance(part);
+                auto partBlending =
+                        rcm.getMaterialInstanceAt(pi, 0)->getMaterial()->getBlendingMode();
+                rcm.setCastShadows(pi, partBlending == BlendingMode::OPAQUE ||
+                                       partBlending == BlendingMode::MASKED);
+                rcm.setReceiveShadows(pi, true);
+                scene->addEntity(part);
+            }
             g_meshes.push_back(mesh);
         }
     }
@@ -136,6 +136,10 @@ static void cleanup(Engine* engine, View* view, Scene* scene) {
         engine->destroy(mesh.indexBuffer);
         engine->destroy(mesh.renderable);
         em.destroy(mesh.renderable);
+        for (auto part : mesh.parts) {
+            engine->destroy(part);
+            em.destroy(part);
+        }
     }
     engine->destroy(g_light);
     em.destroy(g_light);
@@ -227,6 +231,9 @@ static void setup(Engine* engine, View* view, Scene* scene) {
             tcm.setTransform(ei, mat4f{ mat3f(g_config.scale), float3(0.0f, 0.0f, -4.0f) } *
                                  tcm.getWorldTransform(ei));
             scene->addEntity(mesh.renderable);
+            for (auto part : mesh.parts) {
+                scene->addEntity(part);
+            }
             g_meshes.push_back(mesh);
         }
     }
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Streaming mesh loading demo: the filamesh files given on the command line are
+// memory-mapped and decoded on JobSystem workers, their GPU buffers are created and
+// uploaded through the engine's background resource queue, and the renderables appear
+// in the scene progressively as their data becomes resident -- the frame loop never
+// blocks on I/O or uploads. See app/MeshStreamer for the loader itself; it is meant as
+// the reference to copy from when integrating Filament.
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <getopt/getopt.h>
+
+#include <utils/EntityManager.h>
+#include <utils/Path.h>
+
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/TransformManager.h>
+
+#include <math/mat3.h>
+#include <math/mat4.h>
+#include <math/vec4.h>
+
+#include "app/Config.h"
+#include "app/FilamentApp.h"
+#include "app/MeshStreamer.h"
+
+using namespace math;
+using namespace filament;
+using namespace utils;
+
+static std::vector<Path> g_filenames;
+
+static std::map<std::string, MaterialInstance*> g_materialInstances;
+static std::unique_ptr<MeshStreamer> g_streamer;
+static Entity g_light;
+
+static Config g_config;
+
+static void printUsage(char* name) {
+    std::string exec_name(Path(name).getName());
+    std::string usage(
+            "STREAMED_MESH loads filamesh files asynchronously while rendering\n"
+            "Usage:\n"
+            "    STREAMED_MESH [options] <filamesh input files>\n"
+            "Options:\n"
+            "   --help, -h\n"
+            "       Prints this message\n\n"
+            "   --ibl=<path to cmgen IBL>, -i <path>\n"
+            "       Applies an IBL generated by cmgen's deploy option\n\n"
+            "   --split-view, -v\n"
+            "       Splits the window into 4 views\n\n"
+            "   --scale=[number], -s [number]\n"
+            "       Applies uniform scale\n\n"
+    );
+    const std::string from("STREAMED_MESH");
+    for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
+        usage.replace(pos, from.length(), exec_name);
+    }
+    std::cout << usage;
+}
+
+static int handleCommandLineArgments(int argc, char* argv[], Config* config) {
+    static constexpr const char* OPTSTR = "hi:vs:";
+    static const struct option OPTIONS[] = {
+            { "help",           no_argument,       0, 'h' },
+            { "ibl",            required_argument, 0, 'i' },
+            { "split-view",     no_argument,       0, 'v' },
+            { "scale",          required_argument, 0, 's' },
+            { 0, 0, 0, 0 }  // termination of the option list
+    };
+    int opt;
+    int option_index = 0;
+    while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &option_index)) >= 0) {
+        std::string arg(optarg ? optarg : "");
+        switch (opt) {
+            default:
+            case 'h':
+                printUsage(argv[0]);
+                exit(0);
+            case 'i':
+                config->iblDirectory = arg;
+                break;
+            case 's':
+                try {
+                    config->scale = std::stof(arg);
+                } catch (std::invalid_argument& e) {
+                    // keep scale of 1.0
+                } catch (std::out_of_range& e) {
+                    // keep scale of 1.0
+                }
+                break;
+            case 'v':
+                config->splitView = true;
+                break;
+        }
+    }
+
+    return optind;
+}
+
+static void cleanup(Engine* engine, View*, Scene*) {
+    EntityManager& em = EntityManager::get();
+    for (auto const& mesh : g_streamer->getMeshes()) {
+        engine->destroy(mesh.vertexBuffer);
+        engine->destroy(mesh.indexBuffer);
+        engine->destroy(mesh.renderable);
+        em.destroy(mesh.renderable);
+        for (auto part : mesh.parts) {
+            engine->destroy(part);
+            em.destroy(part);
+        }
+    }
+    g_streamer.reset();
+    for (auto material : g_materialInstances) {
+        engine->destroy(material.second);
+    }
+    engine->destroy(g_light);
+    em.destroy(g_light);
+}
+
+static void setup(Engine* engine, View*, Scene*) {
+    g_materialInstances["DefaultMaterial"] =
+            FilamentApp::get().getDefaultMaterial()->createInstance();
+
+    g_streamer.reset(new MeshStreamer(*engine));
+    for (const auto& filename : g_filenames) {
+        // returns immediately; decode starts on a worker right away
+        g_streamer->load(filename, g_materialInstances);
+    }
+
+    g_light = EntityManager::get().create();
+    LightManager::Builder(LightManager::Type::SUN)
+            .color(Color::toLinear<ACCURATE>({ 0.98f, 0.92f, 0.89f }))
+            .intensity(110000)
+            .direction({ 0.6, -1, -0.8 })
+            .build(*engine, g_light);
+}
+
+static void preRender(Engine* engine, View*, Scene* scene, Renderer*) {
+    // advance the streaming pipeline; renderables show up as they become ready
+    const size_t attached = g_streamer->update(scene);
+    if (attached > 0) {
+        auto& tcm = engine->getTransformManager();
+        for (auto const& mesh : g_streamer->getMeshes()) {
+            auto ei = tcm.getInstance(mesh.renderable);
+            tcm.setTransform(ei, mat4f{ mat3f(g_config.scale), float3(0.0f, 0.0f, -4.0f) });
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int option_index = handleCommandLineArgments(argc, argv, &g_config);
+    int num_args = argc - option_index;
+    if (num_args < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (int i = option_index; i < argc; i++) {
+        utils::Path filename = argv[i];
+        if (!filename.exists()) {
+            std::cerr << "file " << argv[i] << " not found!" << std::endl;
+            return 1;
+        }
+        g_filenames.push_back(filename);
+    }
+
+    g_config.title = "streamed mesh";
+    FilamentApp& filamentApp = FilamentApp::get();
+    filamentApp.run(g_config, setup, cleanup, FilamentApp::ImGuiCallback(), preRender);
+
+    return 0;
+}
@@ -61,6 +61,8 @@ struct Part {
     uint32_t maxIndex;
     uint32_t materialID;
     Box      aabb;
+    // added in version 3; older files get this "never cull" default
+    math::float4 normalCone = { 0.0f, 0.0f, 0.0f, 1.0f };
 };
 
 Filamesh decodeMesh(Engine& engine, void const* data, off_t offset, MaterialInstance* mi,
@@ -81,8 +83,19 @@ Filamesh decodeMesh(Engine& engine, void const* data, off_t offset, MaterialInst
     char const* indices = p;
     p += header->indexSize;
 
-    Part* parts = (Part*) p;
-    p += header->parts * sizeof(Part);
+    if (header->version >= 2) {
+        // version 2 pads the index data so the part table is 4-byte aligned
+        p += (4 - (header->indexSize & 3)) & 3;
+    }
+
+    // version 3 appends a normal cone to each part record
+    const size_t partSize = header->version >= 3 ?
+            sizeof(Part) : sizeof(Part) - sizeof(Part::normalCone);
+    vector<Part> parts(header->parts);
+    for (size_t i = 0; i < header->parts; i++) {
+        memcpy(&parts[i], p + i * partSize, partSize);
+    }
+    p += header->parts * partSize;
 
     uint32_t materialCount = (uint32_t) *p;
     p += sizeof(uint32_t);
@@ -134,6 +147,7 @@ Filamesh decodeMesh(Engine& engine, void const* data, off_t offset, MaterialInst
         builder.geometry(i, RenderableManager::PrimitiveType::TRIANGLES,
                             mesh->vertexBuffer, mesh->indexBuffer, parts[i].offset,
                             parts[i].minIndex, parts[i].maxIndex, parts[i].indexCount);
+        builder.bounds(i, parts[i].aabb, parts[i].normalCone);
         builder.material(i, mi);
     }
     builder.build(engine, mesh->renderable);
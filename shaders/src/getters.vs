@@ -40,11 +40,27 @@ void skinPosition(inout vec3 p, const uvec4 ids, const vec4 weights) {
 
 /** @public-api */
 vec4 getPosition() {
-    return mesh_position;
+    vec4 pos = mesh_position;
+    // dequantize normalized-integer (e.g. SNORM16) positions; the transform is the
+    // identity for float positions, so this is a single fused multiply-add
+    pos.xyz = pos.xyz * objectUniforms.posUnpackScale.xyz + objectUniforms.posUnpackOffset.xyz;
+    return pos;
 }
 
 vec4 getSkinnedPosition() {
     vec4 pos = getPosition();
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_0)
+    pos.xyz += objectUniforms.morphWeights.x * mesh_morph_position_0.xyz;
+#endif
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_1)
+    pos.xyz += objectUniforms.morphWeights.y * mesh_morph_position_1.xyz;
+#endif
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_2)
+    pos.xyz += objectUniforms.morphWeights.z * mesh_morph_position_2.xyz;
+#endif
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_3)
+    pos.xyz += objectUniforms.morphWeights.w * mesh_morph_position_3.xyz;
+#endif
 #if defined(HAS_SKINNING)
     skinPosition(pos.xyz, mesh_bone_indices, mesh_bone_weights);
 #endif
@@ -160,17 +160,29 @@ vec3 diffuseIrradiance(const vec3 n) {
 // IBL specular
 //------------------------------------------------------------------------------
 
+vec3 prefilteredRadiance(const vec3 r, float lod) {
+    vec3 radiance = decodeDataForIBL(textureLod(light_iblSpecular, r, lod));
+    // crossfade with a second environment; the branch is on a uniform, so it's
+    // effectively free when no transition is in progress
+    if (frameUniforms.iblBlend > 0.0) {
+        radiance = mix(radiance,
+                decodeDataForIBL(textureLod(light_iblSpecularBlend, r, lod)),
+                frameUniforms.iblBlend);
+    }
+    return radiance;
+}
+
 vec3 specularIrradiance(const vec3 r, float roughness) {
     // lod = lod_count * sqrt(linear_roughness), which is the mapping used by cmgen
     // where linear_roughness = roughness^2
     // using all the mip levels requires seamless cubemap sampling
     float lod = IBL_MAX_MIP_LEVEL * roughness;
-    return decodeDataForIBL(textureLod(light_iblSpecular, r, lod));
+    return prefilteredRadiance(r, lod);
 }
 
 vec3 specularIrradiance(const vec3 r, float roughness, float offset) {
     float lod = IBL_MAX_MIP_LEVEL * roughness * roughness;
-    return decodeDataForIBL(textureLod(light_iblSpecular, r, lod + offset));
+    return prefilteredRadiance(r, lod + offset);
 }
 
 vec3 getSpecularDominantDirection(vec3 n, vec3 r, float linearRoughness) {
@@ -214,13 +226,36 @@ vec3 getReflectedVector(const PixelParams pixel, const vec3 v, const vec3 n) {
     return r;
 }
 
+/**
+ * Parallax-corrects a world-space reflection vector against the indirect light's
+ * probe volume ("box projection"), if one was set. The corrected vector points from
+ * the probe center to the intersection of the reflection ray with the volume, which
+ * makes the prefiltered cubemap act as a reflection local to the volume instead of
+ * an environment at infinity. The branch is on a uniform, so it's effectively free
+ * for distant environments.
+ */
+vec3 correctReflectionVector(const vec3 r) {
+    if (frameUniforms.iblProbeCenter.w > 0.0) {
+        vec3 position = shading_position;
+        vec3 center = frameUniforms.iblProbeCenter.xyz;
+        vec3 halfExtent = frameUniforms.iblProbeHalfExtent.xyz;
+        // distance along r of the exit point out of the box, for each pair of planes
+        vec3 exitMax = (center + halfExtent - position) / r;
+        vec3 exitMin = (center - halfExtent - position) / r;
+        vec3 exit = max(exitMax, exitMin);
+        float d = min(min(exit.x, exit.y), exit.z);
+        return position + r * d - center;
+    }
+    return r;
+}
+
 vec3 getReflectedVector(const PixelParams pixel, const vec3 n) {
 #if defined(MATERIAL_HAS_ANISOTROPY)
     vec3 r = getReflectedVector(pixel, shading_view, n);
 #else
     vec3 r = shading_reflected;
 #endif
-    return getSpecularDominantDirection(n, r, pixel.linearRoughness);
+    return correctReflectionVector(getSpecularDominantDirection(n, r, pixel.linearRoughness));
 }
 
 //------------------------------------------------------------------------------
@@ -334,6 +369,10 @@ vec3 isEvaluateIBL(const PixelParams pixel, vec3 n, vec3 v, float NoV) {
 
             // we use texture() instead of textureLod() to take advantage of mipmapping
             vec3 L = decodeDataForIBL(texture(light_iblSpecular, l, mipLevel));
+            if (frameUniforms.iblBlend > 0.0) {
+                L = mix(L, decodeDataForIBL(texture(light_iblSpecularBlend, l, mipLevel)),
+                        frameUniforms.iblBlend);
+            }
 
             float D = distribution(linearRoughness, NoH, h);
             float V = visibility(pixel.roughness, linearRoughness, NoV, NoL, LoH);
@@ -413,7 +452,8 @@ void evaluateClearCoatIBL(const PixelParams pixel, float specularAO, inout vec3
     float Fc = F_Schlick(0.04, 1.0, clearCoatNoV) * pixel.clearCoat;
     float attenuation = 1.0 - Fc;
     Fr *= sq(attenuation);
-    Fr += specularIrradiance(clearCoatR, pixel.clearCoatRoughness) * (specularAO * Fc);
+    Fr += specularIrradiance(correctReflectionVector(clearCoatR), pixel.clearCoatRoughness)
+            * (specularAO * Fc);
     Fd *= attenuation;
 #endif
 }
@@ -27,9 +27,20 @@ uvec3 getFroxelCoords(const vec3 fragCoords) {
     froxelCoord.xy = uvec2((fragCoords.xy - frameUniforms.origin.xy) *
             vec2(frameUniforms.oneOverFroxelDimension, frameUniforms.oneOverFroxelDimensionY));
 
-    froxelCoord.z = uint(max(0.0,
-            log2(frameUniforms.zParams.x * fragCoords.z + frameUniforms.zParams.y) *
-                    frameUniforms.zParams.z + frameUniforms.zParams.w));
+    float zSlice = log2(frameUniforms.zParams.x * fragCoords.z + frameUniforms.zParams.y) *
+            frameUniforms.zParams.z + frameUniforms.zParams.w;
+
+    if (frameUniforms.froxelCurve.x != 1.0) {
+        // remap through the configurable z-slice distribution curve (see
+        // Froxelizer::setDepthDistribution()): recover the normalized distance from the
+        // far slice and apply the exponent. The branch is on a uniform, so it's free on
+        // most GPUs and keeps a pow() out of the default path.
+        float u = (frameUniforms.zParams.w - zSlice) * frameUniforms.froxelCurve.y;
+        zSlice = frameUniforms.zParams.w -
+                frameUniforms.froxelCurve.z * pow(max(u, 0.0), frameUniforms.froxelCurve.x);
+    }
+
+    froxelCoord.z = uint(max(0.0, zSlice));
 
     return froxelCoord;
 }
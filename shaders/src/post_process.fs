@@ -11,17 +11,58 @@ vec4 resolveAlphaFragment(const ivec2 uv) {
     return texelFetch(postProcess_colorBuffer, uv, 0);
 }
 
+vec3 colorGrade(const vec3 x) {
+    // Tone-mapping + OECF baked into a 3D LUT, stored as lutSize slices of
+    // lutSize x lutSize laid out along the x axis of a 2D texture. The input is
+    // encoded as x / (1 + x), which covers the HDR range of the LUT while giving
+    // more precision to darker values (see PostProcessManager for the bake).
+    HIGHP float lutSize = postProcessUniforms.lutInfo.y;
+    HIGHP vec3 c = saturate((x / (1.0 + x)) * postProcessUniforms.lutInfo.z);
+    // scale + offset to sample at texel centers
+    HIGHP float texelScale  = (lutSize - 1.0) / lutSize;
+    HIGHP float texelOffset = 0.5 / lutSize;
+    // bilinear filtering handles red/green, the blue axis is interpolated manually
+    HIGHP float slice = c.b * (lutSize - 1.0);
+    HIGHP float s0 = floor(slice);
+    HIGHP float s1 = min(s0 + 1.0, lutSize - 1.0);
+    HIGHP float u = (c.r * texelScale + texelOffset) / lutSize;
+    HIGHP float v = c.g * texelScale + texelOffset;
+    vec3 g0 = texture(postProcess_colorGradingLut, vec2(u + s0 / lutSize, v)).rgb;
+    vec3 g1 = texture(postProcess_colorGradingLut, vec2(u + s1 / lutSize, v)).rgb;
+    return mix(g0, g1, slice - s0);
+}
+
+vec3 applyAutoExposure(vec3 x) {
+    // scale the frame so the adapted average luminance maps to the middle-grey key
+    // (see PostProcessManager::autoExposure())
+    if (postProcessUniforms.exposureInfo.x > 0.0) {
+        float average = exp2(texelFetch(postProcess_luminance, ivec2(0), 0).r);
+        x *= postProcessUniforms.exposureInfo.w / max(average, 1e-4);
+    }
+    return x;
+}
+
 vec4 resolve() {
 #if POST_PROCESS_OPAQUE
     vec4 color = vec4(resolveFragment(ivec2(vertex_uv)), 1.0);
-    color.rgb  = tonemap(color.rgb);
-    color.rgb  = OECF(color.rgb);
+    color.rgb = applyAutoExposure(color.rgb);
+    if (postProcessUniforms.lutInfo.x > 0.0) {
+        color.rgb = colorGrade(color.rgb);
+    } else {
+        color.rgb = tonemap(color.rgb);
+        color.rgb = OECF(color.rgb);
+    }
     color.a    = luminance(color.rgb);
 #else
     vec4 color = resolveAlphaFragment(ivec2(vertex_uv));
     color.rgb /= color.a + FLT_EPS;
-    color.rgb  = tonemap(color.rgb);
-    color.rgb  = OECF(color.rgb);
+    color.rgb = applyAutoExposure(color.rgb);
+    if (postProcessUniforms.lutInfo.x > 0.0) {
+        color.rgb = colorGrade(color.rgb);
+    } else {
+        color.rgb = tonemap(color.rgb);
+        color.rgb = OECF(color.rgb);
+    }
     color.rgb *= color.a + FLT_EPS;
 #endif
     return color;
@@ -60,11 +101,65 @@ vec4 PostProcess_AntiAliasing() {
 }
 #endif
 
+#if POST_PROCESS_UPSAMPLE
+vec4 PostProcess_TransparencyUpsample() {
+    // Bilinear up-sample of the half-resolution transparency buffer. The colors are
+    // pre-multiplied and still linear; blending over the full resolution buffer is
+    // done by the raster state of the composite draw.
+    HIGHP vec2 uv = vertex_uv * frameUniforms.resolution.zw * postProcessUniforms.uvScale;
+    return texture(postProcess_colorBuffer, uv);
+}
+#endif
+
+#if POST_PROCESS_LUMINANCE
+vec4 PostProcess_LuminanceDownsample() {
+    // Log-luminance of the color buffer, rendered into the base of a small pyramid.
+    // The top mip then holds the average log-luminance, i.e. the log of the scene's
+    // geometric mean luminance (see PostProcessManager::autoExposure()).
+    HIGHP vec2 uv = vertex_uv * frameUniforms.resolution.zw * postProcessUniforms.uvScale;
+    vec3 c = texture(postProcess_colorBuffer, uv).rgb;
+    return vec4(log2(max(luminance(c), 1e-5)), 0.0, 0.0, 1.0);
+}
+#endif
+
+#if POST_PROCESS_ADAPTATION
+vec4 PostProcess_LuminanceAdaptation() {
+    // Exponentially adapt the 1x1 average log-luminance towards this frame's value
+    // (the top mip of the pyramid), emulating the eye's temporal adaptation.
+    float average = textureLod(postProcess_colorBuffer, vec2(0.5),
+            postProcessUniforms.exposureInfo.z).r;
+    float adapted = texelFetch(postProcess_luminance, ivec2(0), 0).r;
+    return vec4(mix(adapted, average, postProcessUniforms.exposureInfo.y), 0.0, 0.0, 1.0);
+}
+#endif
+
+#if POST_PROCESS_SHADOW_EVSM
+vec4 PostProcess_ShadowPrefilter() {
+    // Warp the shadow map depth into exponential space and store the first two moments.
+    // Once mip-chained, a single trilinear fetch of these moments yields a prefiltered
+    // Chebyshev visibility estimate (see shadowVsm() in shadowing.fs).
+    // Keep the exponent in sync with EVSM_EXPONENT in shadowing.fs; it is the largest
+    // value whose square still fits comfortably in a half-float moment.
+    HIGHP vec2 uv = vertex_uv * frameUniforms.resolution.zw * postProcessUniforms.uvScale;
+    HIGHP float depth = texture(postProcess_colorBuffer, uv).r;
+    HIGHP float warped = exp(5.54 * (2.0 * depth - 1.0));
+    return vec4(warped, warped * warped, 0.0, 1.0);
+}
+#endif
+
 vec4 postProcess() {
 #if POST_PROCESS_TONE_MAPPING
     return PostProcess_ToneMapping();
 #elif POST_PROCESS_ANTI_ALIASING
     return PostProcess_AntiAliasing();
+#elif POST_PROCESS_UPSAMPLE
+    return PostProcess_TransparencyUpsample();
+#elif POST_PROCESS_LUMINANCE
+    return PostProcess_LuminanceDownsample();
+#elif POST_PROCESS_ADAPTATION
+    return PostProcess_LuminanceAdaptation();
+#elif POST_PROCESS_SHADOW_EVSM
+    return PostProcess_ShadowPrefilter();
 #endif
 }
 
@@ -223,6 +223,47 @@ float ShadowSample_PCF_High(const lowp sampler2DShadow map, const vec2 size, vec
 }
 #endif
 
+//------------------------------------------------------------------------------
+// EVSM (soft shadows with prefiltered moments)
+//------------------------------------------------------------------------------
+
+// Keep in sync with PostProcess_ShadowPrefilter() in post_process.fs
+#define EVSM_EXPONENT           5.54
+// below this visibility the Chebyshev bound is mostly light bleeding, remap it away
+#define EVSM_LIGHT_BLEEDING     0.15
+
+float chebyshevUpperBound(const HIGHP vec2 moments, const HIGHP float mean) {
+    // Donnelly and Lauritzen 2006, "Variance Shadow Maps"
+    HIGHP float variance = moments.y - moments.x * moments.x;
+    HIGHP float d = mean - moments.x;
+    float visibility = variance / (variance + d * d);
+    // the bound only applies to receivers beyond the stored mean
+    visibility = mean <= moments.x ? 1.0 : visibility;
+    // remap to hide light bleeding behind multiple occluders
+    return saturate((visibility - EVSM_LIGHT_BLEEDING) / (1.0 - EVSM_LIGHT_BLEEDING));
+}
+
+/**
+ * Samples the light visibility from the prefiltered EVSM moments. The penumbra width
+ * maps to a mip level of the moments' chain, so the cost is a constant two trilinear
+ * fetches regardless of the kernel size: a coarse fetch estimates the occluder
+ * distance (contact hardening), then the visibility is evaluated at the resulting lod.
+ */
+float shadowVsm(const mediump sampler2D moments, const HIGHP vec3 shadowPosition) {
+    float maxLod = frameUniforms.vsmParams.y;
+    HIGHP float receiver = exp(EVSM_EXPONENT * (2.0 * shadowPosition.z - 1.0));
+
+    // contact hardening: the average warped occluder depth at the coarsest useful lod
+    // gives a penumbra estimate -- receivers close to their occluders get a narrow
+    // kernel, distant ones the full width
+    HIGHP float occluder = textureLod(moments, shadowPosition.xy, maxLod).r;
+    float penumbra = saturate(1.0 - occluder / receiver);
+    float lod = maxLod * penumbra;
+
+    HIGHP vec2 m = textureLod(moments, shadowPosition.xy, lod).rg;
+    return chebyshevUpperBound(m, receiver);
+}
+
 //------------------------------------------------------------------------------
 // Shadow sampling dispatch
 //------------------------------------------------------------------------------
@@ -232,7 +273,11 @@ float ShadowSample_PCF_High(const lowp sampler2DShadow map, const vec2 size, vec
  * space. The output is a filtered visibility factor that can be used to multiply
  * the light intensity.
  */
-float shadow(const lowp sampler2DShadow shadowMap, const vec3 shadowPosition) {
+float shadow(const lowp sampler2DShadow shadowMap, const mediump sampler2D shadowVsmMap,
+        const vec3 shadowPosition) {
+    if (frameUniforms.vsmParams.x > 0.0) {
+        return shadowVsm(shadowVsmMap, shadowPosition);
+    }
     vec2 size = vec2(textureSize(shadowMap, 0));
 #if SHADOW_SAMPLING_METHOD == SHADOW_SAMPLING_HARD
     return ShadowSample_Hard(shadowMap, size, shadowPosition);
@@ -24,6 +24,22 @@ layout(location = LOCATION_BONE_INDICES) in uvec4 mesh_bone_indices;
 layout(location = LOCATION_BONE_WEIGHTS) in vec4 mesh_bone_weights;
 #endif
 
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_0)
+layout(location = LOCATION_MORPH_POSITION_0) in vec4 mesh_morph_position_0;
+#endif
+
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_1)
+layout(location = LOCATION_MORPH_POSITION_1) in vec4 mesh_morph_position_1;
+#endif
+
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_2)
+layout(location = LOCATION_MORPH_POSITION_2) in vec4 mesh_morph_position_2;
+#endif
+
+#if defined(HAS_ATTRIBUTE_MORPH_POSITION_3)
+layout(location = LOCATION_MORPH_POSITION_3) in vec4 mesh_morph_position_3;
+#endif
+
 LAYOUT_LOCATION(4) out HIGHP vec3 vertex_worldPosition;
 #if defined(HAS_ATTRIBUTE_TANGENTS)
 LAYOUT_LOCATION(5) SHADING_INTERPOLATION out MEDIUMP vec3 vertex_worldNormal;
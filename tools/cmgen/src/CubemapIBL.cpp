@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include "CubemapIBL.h"
@@ -209,53 +211,31 @@ static double __UNUSED VisibilityAshikhmin(double NoV, double NoL, double a) {
  *
  */
 
-void CubemapIBL::roughnessFilter(Cubemap& dst,
-        const std::vector<Cubemap>& levels, double linearRoughness, size_t maxNumSamples)
-{
-    const float numSamples = maxNumSamples;
-    const float inumSamples = 1.0f / numSamples;
-    const size_t maxLevel = levels.size()-1;
-    const float maxLevelf = maxLevel;
-    const Cubemap& base(levels[0]);
-    const size_t dim0 = base.getDimensions();
-    const float omegaP = float((4 * M_PI) / (6 * dim0 * dim0));
-
-    ProgressUpdater updater(1);
-    std::atomic_uint progress = {0};
-
-    if (linearRoughness == 0) {
-        if (!g_quiet) {
-            updater.start();
-        }
-        CubemapUtils::process<CubemapUtils::EmptyState>(dst, [&, quiet = g_quiet]
-                (CubemapUtils::EmptyState&, size_t y, Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-                    size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-                    if (!quiet) {
-                        updater.update(0, p, dim * 6);
-                    }
-                    const Cubemap& cm = levels[0];
-                    for (size_t x = 0; x < dim; ++x, ++data) {
-                        const double2 p(dst.center(x, y));
-                        const double3 N(dst.getDirectionFor(f, p.x, p.y));
-                        // FIXME: we should pick the proper LOD here and do trilinear filtering
-                        Cubemap::writeAt(data, cm.sampleAt(N));
-                    }
-                });
-        if (!g_quiet) {
-            updater.stop();
-        }
-        return;
+// be careful w/ the size of this structure, the smaller the better
+struct CacheEntry {
+    double3 L;
+    float brdf_NoL;
+    float lerp;
+    uint8_t l0;
+    uint8_t l1;
+};
+
+// The GGX sample directions and weights only depend on the roughness, the sample count and the
+// source mip geometry -- not on the environment -- so they are built once per run and shared
+// between the prefilter levels and the --extract-blur pass. Must be called from the main thread.
+static const std::vector<CacheEntry>& getPrefilterSamples(double linearRoughness,
+        size_t maxNumSamples, size_t maxLevel, float omegaP) {
+    using Key = std::tuple<double, size_t, size_t, float>;
+    static std::map<Key, std::vector<CacheEntry>> sampleSets;
+
+    const Key key(linearRoughness, maxNumSamples, maxLevel, omegaP);
+    auto iter = sampleSets.find(key);
+    if (iter != sampleSets.end()) {
+        return iter->second;
     }
 
-
-    // be careful w/ the size of this structure, the smaller the better
-    struct CacheEntry {
-        double3 L;
-        float brdf_NoL;
-        float lerp;
-        uint8_t l0;
-        uint8_t l1;
-    };
+    const float numSamples = maxNumSamples;
+    const float maxLevelf = maxLevel;
 
     std::vector<CacheEntry> cache;
     cache.reserve(maxNumSamples);
@@ -269,7 +249,7 @@ void CubemapIBL::roughnessFilter(Cubemap& dst,
     for (size_t sampleIndex = 0 ; sampleIndex < maxNumSamples; sampleIndex++) {
 
         // get Hammersley distribution for the half-sphere
-        const double2 u = hammersley(uint32_t(sampleIndex), inumSamples);
+        const double2 u = hammersley(uint32_t(sampleIndex), 1.0f / numSamples);
 
         // Importance sampling GGX - Trowbridge-Reitz
         const double3 H = hemisphereImportanceSampleDggx(u, linearRoughness);
@@ -318,11 +298,68 @@ void CubemapIBL::roughnessFilter(Cubemap& dst,
         entry.brdf_NoL /= weight;
     });
 
-    // we can sample the cubemap in any order, sort by the weight, it could improve fp precision
+    // gather from one pair of miplevels at a time, so consecutive samples hit the same source
+    // images instead of thrashing the cache across the whole mip chain; within a level we can
+    // sample in any order, sort by the weight, it could improve fp precision
     std::sort(cache.begin(), cache.end(), [](CacheEntry const& lhs, CacheEntry const& rhs){
-        return lhs.brdf_NoL < rhs.brdf_NoL;
+        return (lhs.l0 != rhs.l0) ? (lhs.l0 < rhs.l0) : (lhs.brdf_NoL < rhs.brdf_NoL);
     });
 
+    return sampleSets.emplace(key, std::move(cache)).first->second;
+}
+
+size_t CubemapIBL::adaptiveSampleCount(size_t budget, double linearRoughness) {
+    // The solid angle of the GGX lobe grows with roughness, and with it the number of
+    // samples the estimator needs to converge; conversely the mirror-like levels are mostly
+    // filtered by the trilinear mip fetches and need very few. The exponent is chosen so the
+    // default 9-level chain reproduces the doubling schedule we used to hard-code in cmgen
+    // (1x at the sharpest levels up to 128x at roughness 1), but now as a function of
+    // roughness alone. Rough levels also render into the smallest cubemaps, so the large
+    // multipliers don't dominate the run time.
+    const double spread = std::exp2(8.0 * std::sqrt(linearRoughness) - 1.0);
+    const double scale = std::min(128.0, std::max(0.5, spread));
+    return std::max(size_t(64), size_t(budget * scale));
+}
+
+void CubemapIBL::roughnessFilter(Cubemap& dst,
+        const std::vector<Cubemap>& levels, double linearRoughness, size_t maxNumSamples)
+{
+    const size_t maxLevel = levels.size()-1;
+    const Cubemap& base(levels[0]);
+    const size_t dim0 = base.getDimensions();
+    const float omegaP = float((4 * M_PI) / (6 * dim0 * dim0));
+
+    ProgressUpdater updater(1);
+    std::atomic_uint progress = {0};
+
+    if (linearRoughness == 0) {
+        if (!g_quiet) {
+            updater.start();
+        }
+        CubemapUtils::process<CubemapUtils::EmptyState>(dst, [&, quiet = g_quiet]
+                (CubemapUtils::EmptyState&, size_t y, Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
+                    size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
+                    if (!quiet) {
+                        updater.update(0, p, dim * 6);
+                    }
+                    const Cubemap& cm = levels[0];
+                    for (size_t x = 0; x < dim; ++x, ++data) {
+                        const double2 p(dst.center(x, y));
+                        const double3 N(dst.getDirectionFor(f, p.x, p.y));
+                        // FIXME: we should pick the proper LOD here and do trilinear filtering
+                        Cubemap::writeAt(data, cm.sampleAt(N));
+                    }
+                });
+        if (!g_quiet) {
+            updater.stop();
+        }
+        return;
+    }
+
+
+    const std::vector<CacheEntry>& cache =
+            getPrefilterSamples(linearRoughness, maxNumSamples, maxLevel, omegaP);
+
     if (!g_quiet) {
         updater.start();
     }
@@ -33,6 +33,13 @@ public:
     static void roughnessFilter(Cubemap& dst,
             const std::vector<Cubemap>& levels, double linearRoughness, size_t maxNumSamples = 1024);
 
+    /*
+     * Number of importance samples roughnessFilter() needs for the given roughness,
+     * derived from a per-level budget. The GGX lobe widens with roughness, so rough levels
+     * get a larger share of the work while mirror-like levels get away with very few samples.
+     */
+    static size_t adaptiveSampleCount(size_t budget, double linearRoughness);
+
     static void diffuseIrradiance(Cubemap& dst, const std::vector<Cubemap>& levels, size_t maxNumSamples = 1024);
 
     static void DFG(Image& dst, bool multiscatter = false);
@@ -16,8 +16,15 @@
 
 #include "CubemapSH.h"
 
+#include <math/compiler.h>
 #include <math/mat4.h>
 
+#if defined(MATH_HAS_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(MATH_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+
 #include "Cubemap.h"
 #include "CubemapUtils.h"
 #include "utilities.h"
@@ -179,48 +186,117 @@ void CubemapSH::computeShBasis(
     }
 }
 
+/*
+ * Accumulates four projected texels onto every SH basis in a single pass over the
+ * coefficients. The partial sums are kept channel-major (numCoefs red, then green, then
+ * blue) so each channel is one contiguous multiply-add stream; B holds the four texels'
+ * bases back-to-back, and each color has already been weighted by its solid angle.
+ */
+static void accumulateShSamples4(
+        double* UTILS_RESTRICT SHc,
+        size_t numCoefs,
+        double const* UTILS_RESTRICT B,
+        double3 const* UTILS_RESTRICT colors)
+{
+    double const* const b0 = B;
+    double const* const b1 = B + numCoefs;
+    double const* const b2 = B + 2 * numCoefs;
+    double const* const b3 = B + 3 * numCoefs;
+    for (size_t channel = 0; channel < 3; channel++) {
+        double* const out = SHc + channel * numCoefs;
+        const double c0 = colors[0][channel];
+        const double c1 = colors[1][channel];
+        const double c2 = colors[2][channel];
+        const double c3 = colors[3][channel];
+        size_t i = 0;
+#if defined(MATH_HAS_NEON) && defined(__aarch64__)
+        for ( ; i + 2 <= numCoefs; i += 2) {
+            float64x2_t acc = vld1q_f64(out + i);
+            acc = vaddq_f64(acc, vmulq_n_f64(vld1q_f64(b0 + i), c0));
+            acc = vaddq_f64(acc, vmulq_n_f64(vld1q_f64(b1 + i), c1));
+            acc = vaddq_f64(acc, vmulq_n_f64(vld1q_f64(b2 + i), c2));
+            acc = vaddq_f64(acc, vmulq_n_f64(vld1q_f64(b3 + i), c3));
+            vst1q_f64(out + i, acc);
+        }
+#elif defined(MATH_HAS_SSE2)
+        const __m128d w0 = _mm_set1_pd(c0);
+        const __m128d w1 = _mm_set1_pd(c1);
+        const __m128d w2 = _mm_set1_pd(c2);
+        const __m128d w3 = _mm_set1_pd(c3);
+        for ( ; i + 2 <= numCoefs; i += 2) {
+            __m128d acc = _mm_loadu_pd(out + i);
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(b0 + i), w0));
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(b1 + i), w1));
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(b2 + i), w2));
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(b3 + i), w3));
+            _mm_storeu_pd(out + i, acc);
+        }
+#endif
+        for ( ; i < numCoefs; i++) {
+            out[i] += b0[i] * c0 + b1[i] * c1 + b2[i] * c2 + b3[i] * c3;
+        }
+    }
+}
+
 std::unique_ptr<double3[]> CubemapSH::computeSH(const Cubemap& cm, size_t numBands, bool irradiance) {
 
     const size_t numCoefs = numBands*numBands;
     std::unique_ptr<double3[]> SH(new double3[numCoefs]{});
 
+    // solid angles don't depend on the face, compute them once for all six
+    const std::unique_ptr<double[]> solidAngles(
+            CubemapUtils::buildSolidAngleTable(cm.getDimensions()));
+
     struct State {
         State() = default;
         explicit State(size_t numCoefs) : numCoefs(numCoefs) { }
 
         State& operator=(State const & rhs) {
-            SH.reset(new double3[rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
-            SHb.reset(new double[rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
+            numCoefs = rhs.numCoefs;
+            SHc.reset(new double[3 * rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
+            SHb.reset(new double[4 * rhs.numCoefs]{}); // NOLINT(modernize-make-unique)
             return *this;
         }
         size_t numCoefs = 0;
-        std::unique_ptr<double3[]> SH;
+        // channel-major partial sums, see accumulateShSamples4()
+        std::unique_ptr<double[]> SHc;
+        // SH bases for a batch of four texels
         std::unique_ptr<double[]> SHb;
     } prototype(numCoefs);
 
     CubemapUtils::process<State>(const_cast<Cubemap&>(cm),
             [&](State& state, size_t y, Cubemap::Face f, Cubemap::Texel const* data, size_t dim) {
-        for (size_t x=0 ; x<dim ; ++x, ++data) {
-
+        const double* UTILS_RESTRICT solidAngleRow = solidAngles.get() + y * dim;
+
+        // The basis recursion in computeShBasis() is inherently serial per texel, so we
+        // evaluate it scalar into a four-texel staging buffer and vectorize the expensive
+        // part: folding the weighted colors into the per-band partial sums.
+        double3 colors[4];
+        size_t x = 0;
+        for ( ; x + 4 <= dim; x += 4, data += 4) {
+            for (size_t j = 0; j < 4; j++) {
+                double3 s(cm.getDirectionFor(f, x + j, y));
+                colors[j] = double3(Cubemap::sampleAt(data + j)) * solidAngleRow[x + j];
+                computeShBasis(state.SHb.get() + j * numCoefs, numBands, s);
+            }
+            accumulateShSamples4(state.SHc.get(), numCoefs, state.SHb.get(), colors);
+        }
+        for ( ; x < dim; ++x, ++data) {
             double3 s(cm.getDirectionFor(f, x, y));
-
-            // sample a color
             double3 color(Cubemap::sampleAt(data));
-
-            // take solid angle into account
-            color *= CubemapUtils::solidAngle(dim, x, y);
-
+            color *= solidAngleRow[x];
             computeShBasis(state.SHb.get(), numBands, s);
-
-            // apply coefficients to the sampled color
             for (size_t i=0 ; i<numCoefs ; i++) {
-                state.SH[i] += color * state.SHb[i];
+                state.SHc[i]                += color[0] * state.SHb[i];
+                state.SHc[numCoefs + i]     += color[1] * state.SHb[i];
+                state.SHc[2 * numCoefs + i] += color[2] * state.SHb[i];
             }
         }
     },
     [&](State& state) {
         for (size_t i=0 ; i<numCoefs ; i++) {
-            SH[i] += state.SH[i];
+            SH[i] += double3(state.SHc[i],
+                    state.SHc[numCoefs + i], state.SHc[2 * numCoefs + i]);
         }
     }, prototype);
 
@@ -298,6 +374,9 @@ std::unique_ptr<double3[]> CubemapSH::computeIrradianceSH3Bands(const Cubemap& c
         double3 SH[9] = { };
     };
 
+    const std::unique_ptr<double[]> solidAngles(
+            CubemapUtils::buildSolidAngleTable(cm.getDimensions()));
+
     CubemapUtils::process<State>(const_cast<Cubemap&>(cm),
             [&](State& state, size_t y, Cubemap::Face f, Cubemap::Texel const* data, size_t dim) {
         for (size_t x=0 ; x<dim ; ++x, ++data) {
@@ -308,7 +387,7 @@ std::unique_ptr<double3[]> CubemapSH::computeIrradianceSH3Bands(const Cubemap& c
             double3 color(Cubemap::sampleAt(data));
 
             // take solid angle into account
-            color *= CubemapUtils::solidAngle(dim, x, y);
+            color *= solidAngles[y * dim + x];
 
             state.SH[0] += color * A[0];
             state.SH[1] += color * A[1] * s.y;
@@ -381,3 +381,13 @@ double CubemapUtils::solidAngle(size_t dim, size_t u, size_t v) {
                         sphereQuadrantArea(x1, y1);
     return solidAngle;
 }
+
+std::unique_ptr<double[]> CubemapUtils::buildSolidAngleTable(size_t dim) {
+    std::unique_ptr<double[]> table(new double[dim * dim]);
+    for (size_t v = 0; v < dim; v++) {
+        for (size_t u = 0; u < dim; u++) {
+            table[v * dim + u] = solidAngle(dim, u, v);
+        }
+    }
+    return table;
+}
@@ -19,6 +19,10 @@
 
 #include <utils/JobSystem.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "Cubemap.h"
 #include "Image.h"
 
@@ -75,6 +79,10 @@ public:
 
     static double solidAngle(size_t dim, size_t u, size_t v);
 
+    // Table of solidAngle(dim, u, v) for a whole face, indexed [v * dim + u]. The weights
+    // are the same for all six faces, so the table is built once and shared.
+    static std::unique_ptr<double[]> buildSolidAngleTable(size_t dim);
+
     static void generateUVGrid(Cubemap& cml, size_t gridFrequencyX, size_t gridFrequencyY);
 
 private:
@@ -96,8 +104,11 @@ void CubemapUtils::process(
 
     const size_t dim = cm.getDimensions();
 
-    // multithread only on large-ish cubemaps
-    STATE states[6];
+    // Split each face into bands of scanlines, each band owning its own STATE, so proc never
+    // needs any synchronization. The bands are pushed as individual jobs, which lets the
+    // JobSystem's work-stealing keep all cores busy even though there are only six faces.
+    const size_t numBands = std::min(dim, size_t(32));
+    std::vector<STATE> states(6 * numBands);
     for (STATE& s : states) {
         s = prototype;
     }
@@ -105,34 +116,23 @@ void CubemapUtils::process(
     JobSystem::Job* parent = js.createJob();
     for (size_t faceIndex = 0; faceIndex < 6; faceIndex++) {
         const Cubemap::Face f = (Cubemap::Face)faceIndex;
-        JobSystem::Job* face = jobs::createJob(js, parent,
-                [faceIndex, &states, f, &cm, &dim, &proc]
-                        (utils::JobSystem& js, utils::JobSystem::Job* parent) {
-                    STATE& s = states[faceIndex];
-                    Image& image(cm.getImageForFace(f));
-
-                    auto parallelJobTask = [&image, &proc, &s, dim, f](size_t y0, size_t c) {
-                        for (size_t y = y0; y < y0 + c; y++) {
+        Image& image(cm.getImageForFace(f));
+        for (size_t band = 0; band < numBands; band++) {
+            const size_t y0 = band * dim / numBands;
+            const size_t y1 = (band + 1) * dim / numBands;
+            STATE& s = states[faceIndex * numBands + band];
+            JobSystem::Job* job = jobs::createJob(js, parent,
+                    [&image, &proc, &s, dim, f, y0, y1]() {
+                        for (size_t y = y0; y < y1; y++) {
                             Cubemap::Texel* data =
                                     static_cast<Cubemap::Texel*>(image.getPixelRef(0, y));
                             proc(s, y, f, data, dim);
                         }
-                    };
-
-                    if (std::is_same<STATE, CubemapUtils::EmptyState>::value) {
-                        auto job = jobs::parallel_for(js, parent, 0, uint32_t(dim),
-                                std::ref(parallelJobTask), jobs::CountSplitter<1, 8>());
-
-                        // we need to wait here because parallelJobTask is passed by reference
-                        js.runAndWait(job);
-                    } else {
-                        // if we have a per-thread STATE, we can't parallel_for()
-                        parallelJobTask(0, dim);
-                    }
-                }, std::ref(js), parent);
-        js.run(face);
+                    });
+            js.run(job);
+        }
     }
-    // wait for all our threads to finish
+    // wait for all our jobs to finish
     js.runAndWait(parent);
     js.reset();
 
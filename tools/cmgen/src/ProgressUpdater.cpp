@@ -50,34 +50,37 @@ static inline void printProgress(float v, size_t width) {
 }
 
 void ProgressUpdater::start() {
-    auto thread_main = [this]() -> int {
+    initProgressValues();
+    printProgressBars();
+
+    // The rendering thread repaints the bars with whatever the latest values are; any number
+    // of updates may be folded into a single repaint. Only the value store happens under the
+    // lock, so workers never wait on console I/O.
+    m_thread = std::thread([this]() {
+        std::vector<float> snapshot(m_numBars);
         bool exitRequested = false;
         while (!exitRequested) {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            while (!mExitRequested && m_jobQueue.isEmpty()) {
-                m_condition.wait(lock);
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return m_dirty || m_exitRequested; });
+                exitRequested = m_exitRequested;
+                m_dirty = false;
+                snapshot = m_progress;
             }
-            exitRequested = mExitRequested;
-            lock.unlock();
-            if (!exitRequested) {
-                m_jobQueue.runAllJobs();
+            moveCursorUp(m_numBars);
+            for (float v : snapshot) {
+                printProgress(v, 32);
+                std::cout << std::endl;
             }
-        };
-        m_jobQueue.runAllJobs();
-        return 0;
-    };
-
-    m_thread = std::thread(thread_main);
-
-    initProgressValues();
-    printProgressBars();
+        }
+    });
 
     hideCursor();
 }
 
 void ProgressUpdater::stop() {
     std::unique_lock<std::mutex> lock(m_mutex);
-    mExitRequested = true;
+    m_exitRequested = true;
     lock.unlock();
     m_condition.notify_all();
     m_thread.join();
@@ -90,11 +93,8 @@ void ProgressUpdater::update(size_t progressBarIndex, float value) {
 
     value = std::max(0.0f, std::min(value, 1.0f));
     std::unique_lock<std::mutex> lock(m_mutex);
-    m_jobQueue.push([value, progressBarIndex, this]() {
-        m_progress[progressBarIndex] = value;
-        moveCursorUp(m_numBars);
-        printProgressBars();
-    });
+    m_progress[progressBarIndex] = value;
+    m_dirty = true;
     lock.unlock();
     m_condition.notify_one();
 }
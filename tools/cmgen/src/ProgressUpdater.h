@@ -20,11 +20,10 @@
 #include <condition_variable>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <vector>
 #include <thread>
 
-#include "JobQueue.h"
-
 class ProgressUpdater {
 public:
     explicit ProgressUpdater(size_t numProgressBars) : m_numBars(numProgressBars) {
@@ -40,6 +39,11 @@ public:
      */
     void stop();
 
+    /**
+     * Updates a progress bar. This only stores the latest value and wakes the rendering
+     * thread, so it's cheap enough to call from tight worker loops; the rendering thread
+     * coalesces whatever updates happened since its last repaint.
+     */
     void update(size_t progressBarIndex, float value);
     void update(size_t progressBarIndex, size_t value, size_t max);
 
@@ -53,9 +57,9 @@ private:
     std::mutex m_mutex;
     std::condition_variable m_condition;
 
-    JobQueue m_jobQueue;
     std::thread m_thread;
-    bool mExitRequested = false;
+    bool m_dirty = false;
+    bool m_exitRequested = false;
 };
 
 #endif //SRC_PROGRESS_UPDATER_H
@@ -18,6 +18,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
 
 #include <math/scalar.h>
@@ -29,6 +30,7 @@
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/Hash.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
@@ -88,11 +90,16 @@ static utils::Path g_ibl_irradiance_dir;
 
 static bool g_deploy = false;
 static utils::Path g_deploy_dir;
+static bool g_bundle = false;
 
 static size_t g_num_samples = 1024;
 
 static bool g_mirror = false;
 
+static bool g_incremental = false;
+static uint32_t g_face_hashes[6] = {};
+static uint32_t g_input_digest = 0;
+
 // -----------------------------------------------------------------------------------------------
 
 static void generateMipmaps(std::vector<Cubemap>& levels, std::vector<Image>& images);
@@ -112,6 +119,18 @@ static void saveImage(const std::string& path, ImageEncoder::Format format, cons
         const std::string& compression);
 static LinearImage toLinearImage(const Image& image);
 static void exportKtxFaces(KtxBundle& container, uint32_t miplevel, const Cubemap& cm);
+static void computeInputDigests(const Cubemap& cm);
+static bool isProductUpToDate(const utils::Path& outputDir, const std::string& product);
+static void updateManifest(const utils::Path& outputDir, const std::string& product);
+static void writeDeployBundle(const utils::Path& iname, const Cubemap& skybox,
+        const utils::Path& dir);
+
+// RGBM payloads collected by the prefilter pass when --deploy-bundle is used.
+struct BundleLevel {
+    size_t dim;
+    std::unique_ptr<uint8_t[]> faces[6];
+};
+static std::vector<BundleLevel> g_bundle_levels;
 
 // -----------------------------------------------------------------------------------------------
 
@@ -165,6 +184,14 @@ static void printUsage(char* name) {
             "       Size of the output cubemaps (base level), 256 by default\n\n"
             "   --deploy=dir, -x dir\n"
             "       Generate everything needed for deployment into <dir>\n\n"
+            "   --deploy-bundle=dir\n"
+            "       Like --deploy, but emits a single <name>.ibl file containing the SH\n"
+            "       coefficients, prefiltered mipmaps and skybox faces as raw RGBM data,\n"
+            "       page-aligned so it can be memory-mapped without parsing\n\n"
+            "   --incremental\n"
+            "       Record content hashes of the input faces and tool options in a\n"
+            "       cmgen.manifest file next to each output, and skip products that are\n"
+            "       already up to date\n\n"
             "   --extract=dir\n"
             "       Extract faces of the cubemap into <dir>\n\n"
             "   --extract-blur=roughness\n"
@@ -232,6 +259,8 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "ibl-dfg-multiscatter",       no_argument, nullptr, 'u' },
             { "ibl-samples",          required_argument, nullptr, 'k' },
             { "deploy",               required_argument, nullptr, 'x' },
+            { "deploy-bundle",        required_argument, nullptr, 'w' },
+            { "incremental",                no_argument, nullptr, 'g' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
             { "debug",                      no_argument, nullptr, 'd' },
             { nullptr, 0, 0, 0 }  // termination of the option list
@@ -380,6 +409,14 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
                 g_deploy = true;
                 g_deploy_dir = arg;
                 break;
+            case 'w':
+                g_deploy = true;
+                g_bundle = true;
+                g_deploy_dir = arg;
+                break;
+            case 'g':
+                g_incremental = true;
+                break;
             case 'd':
                 g_debug = true;
                 break;
@@ -446,6 +483,12 @@ int main(int argc, char* argv[]) {
         // prefilter
         g_prefilter = true;
         g_prefilter_dir = g_deploy_dir;
+
+        if (g_bundle) {
+            // everything goes into the single bundle file
+            g_sh_file = ShFile::SH_NONE;
+            g_extract_faces = false;
+        }
     }
 
     if (g_debug) {
@@ -567,6 +610,12 @@ int main(int argc, char* argv[]) {
     // make the cubemap seamless
     levels[0].makeSeamless();
 
+    if (g_incremental) {
+        // the base level fully determines every product, so hashing it (together with the
+        // options) is enough to decide whether any of the outputs need to be regenerated
+        computeInputDigests(levels[0]);
+    }
+
     // Now generate all the mipmap levels
     generateMipmaps(levels, images);
 
@@ -579,46 +628,92 @@ int main(int argc, char* argv[]) {
     }
 
     if (g_is_mipmap) {
-        if (!g_quiet) {
-            std::cout << "IBL mipmaps for prefiltered importance sampling..." << std::endl;
+        utils::Path outputDir(g_is_mipmap_dir.getAbsolutePath() + iname.getNameWithoutExtension());
+        if (g_incremental && isProductUpToDate(outputDir, "is_mipmap")) {
+            if (!g_quiet) {
+                std::cout << "IBL mipmaps are up to date, skipping..." << std::endl;
+            }
+        } else {
+            if (!g_quiet) {
+                std::cout << "IBL mipmaps for prefiltered importance sampling..." << std::endl;
+            }
+            iblMipmapPrefilter(iname, images, levels, g_is_mipmap_dir);
+            if (g_incremental) {
+                updateManifest(outputDir, "is_mipmap");
+            }
         }
-        iblMipmapPrefilter(iname, images, levels, g_is_mipmap_dir);
     }
 
     if (g_prefilter) {
-        if (!g_quiet) {
-            std::cout << "IBL prefiltering..." << std::endl;
+        utils::Path outputDir(g_prefilter_dir.getAbsolutePath() + iname.getNameWithoutExtension());
+        const std::string product = g_bundle ? "bundle" : "prefilter";
+        if (g_incremental && isProductUpToDate(outputDir, product)) {
+            if (!g_quiet) {
+                std::cout << "IBL prefiltering is up to date, skipping..." << std::endl;
+            }
+        } else {
+            if (!g_quiet) {
+                std::cout << "IBL prefiltering..." << std::endl;
+            }
+            iblRoughnessPrefilter(iname, levels, g_prefilter_dir);
+            if (g_bundle) {
+                writeDeployBundle(iname, levels[0], g_deploy_dir);
+            }
+            if (g_incremental) {
+                updateManifest(outputDir, product);
+            }
         }
-        iblRoughnessPrefilter(iname, levels, g_prefilter_dir);
     }
 
     if (g_ibl_irradiance) {
-        if (!g_quiet) {
-            std::cout << "IBL diffuse irradiance..." << std::endl;
+        utils::Path outputDir(
+                g_ibl_irradiance_dir.getAbsolutePath() + iname.getNameWithoutExtension());
+        if (g_incremental && isProductUpToDate(outputDir, "irradiance")) {
+            if (!g_quiet) {
+                std::cout << "IBL diffuse irradiance is up to date, skipping..." << std::endl;
+            }
+        } else {
+            if (!g_quiet) {
+                std::cout << "IBL diffuse irradiance..." << std::endl;
+            }
+            iblDiffuseIrradiance(iname, levels, g_ibl_irradiance_dir);
+            if (g_incremental) {
+                updateManifest(outputDir, "irradiance");
+            }
         }
-        iblDiffuseIrradiance(iname, levels, g_ibl_irradiance_dir);
     }
 
     if (g_extract_faces) {
         Cubemap const& cm(levels[0]);
-        if (g_extract_blur != 0) {
-            if (!g_quiet) {
-                std::cout << "Blurring..." << std::endl;
-            }
-            const double linear_roughness = g_extract_blur * g_extract_blur;
-            const size_t dim = g_output_size ? g_output_size : cm.getDimensions();
-            Image image;
-            Cubemap blurred = CubemapUtils::create(image, dim);
-            CubemapIBL::roughnessFilter(blurred, levels, linear_roughness, g_num_samples);
+        utils::Path outputDir(g_extract_dir.getAbsolutePath() + iname.getNameWithoutExtension());
+        if (g_incremental && isProductUpToDate(outputDir, "skybox")) {
             if (!g_quiet) {
-                std::cout << "Extract faces..." << std::endl;
+                std::cout << "Skybox faces are up to date, skipping..." << std::endl;
             }
-            extractCubemapFaces(iname, blurred, g_extract_dir);
         } else {
-            if (!g_quiet) {
-                std::cout << "Extract faces..." << std::endl;
+            if (g_extract_blur != 0) {
+                if (!g_quiet) {
+                    std::cout << "Blurring..." << std::endl;
+                }
+                const double linear_roughness = g_extract_blur * g_extract_blur;
+                const size_t dim = g_output_size ? g_output_size : cm.getDimensions();
+                Image image;
+                Cubemap blurred = CubemapUtils::create(image, dim);
+                CubemapIBL::roughnessFilter(blurred, levels, linear_roughness,
+                        CubemapIBL::adaptiveSampleCount(g_num_samples, linear_roughness));
+                if (!g_quiet) {
+                    std::cout << "Extract faces..." << std::endl;
+                }
+                extractCubemapFaces(iname, blurred, g_extract_dir);
+            } else {
+                if (!g_quiet) {
+                    std::cout << "Extract faces..." << std::endl;
+                }
+                extractCubemapFaces(iname, cm, g_extract_dir);
+            }
+            if (g_incremental) {
+                updateManifest(outputDir, "skybox");
             }
-            extractCubemapFaces(iname, cm, g_extract_dir);
         }
     }
 
@@ -660,23 +755,36 @@ void sphericalHarmonics(const utils::Path& iname, const Cubemap& inputCubemap) {
 
         if (g_sh_file != ShFile::SH_NONE) {
             utils::Path outputDir(g_sh_filename.getAbsolutePath().getParent());
-            if (!outputDir.exists()) {
-                outputDir.mkdirRecursive();
-            }
-
-            if (g_sh_shader) {
-                CubemapSH::renderPreScaledSH3Bands(cm, sh);
+            // note: the coefficients above are always recomputed (they are cheap compared to the
+            // IBL integrations, and may be needed by the KTX or bundle outputs), only the file
+            // output is skipped here
+            if (g_incremental && isProductUpToDate(outputDir, "sh")) {
+                if (!g_quiet) {
+                    std::cout << "SH output is up to date, skipping..." << std::endl;
+                }
             } else {
-                CubemapSH::renderSH(cm, sh, g_sh_compute);
-            }
+                if (!outputDir.exists()) {
+                    outputDir.mkdirRecursive();
+                }
 
-            if (g_sh_file == ShFile::SH_CROSS) {
-                saveImage(g_sh_filename, ImageEncoder::chooseFormat(g_sh_filename.getName()),
-                        image, g_compression);
-            }
-            if (g_sh_file == ShFile::SH_TEXT) {
-                std::ofstream outputStream(g_sh_filename, std::ios::trunc);
-                outputSh(outputStream, sh, g_sh_compute);
+                if (g_sh_shader) {
+                    CubemapSH::renderPreScaledSH3Bands(cm, sh);
+                } else {
+                    CubemapSH::renderSH(cm, sh, g_sh_compute);
+                }
+
+                if (g_sh_file == ShFile::SH_CROSS) {
+                    saveImage(g_sh_filename, ImageEncoder::chooseFormat(g_sh_filename.getName()),
+                            image, g_compression);
+                }
+                if (g_sh_file == ShFile::SH_TEXT) {
+                    std::ofstream outputStream(g_sh_filename, std::ios::trunc);
+                    outputSh(outputStream, sh, g_sh_compute);
+                }
+
+                if (g_incremental) {
+                    updateManifest(outputDir, "sh");
+                }
             }
         }
 
@@ -803,7 +911,6 @@ void iblRoughnessPrefilter(const utils::Path& iname,
     const bool DEBUG_FULL_RESOLUTION = false;
 
     const size_t baseExp = __builtin_ctz(g_output_size ? g_output_size : IBL_DEFAULT_SIZE);
-    size_t numSamples = g_num_samples;
     const size_t numLevels = baseExp + 1;
 
     // It's convenient to create an empty KTX bundle on the stack in this scope, regardless of
@@ -824,24 +931,21 @@ void iblRoughnessPrefilter(const utils::Path& iname,
     for (ssize_t i = baseExp; i >= 0; --i) {
         const size_t dim = 1U << (DEBUG_FULL_RESOLUTION ? baseExp : i);
         const size_t level = baseExp - i;
-        if (level >= 2) {
-            // starting at level 2, we increase the number of samples per level
-            // this helps as the filter gets wider, and since there are 4x less work
-            // per level, this doesn't slow things down a lot.
-            if (!DEBUG_FULL_RESOLUTION) {
-                numSamples *= 2;
-            }
-        }
 
         const double lod = saturate(level / (numLevels - 1.0));
         // map the lod to a linear_roughness,  here we're using ^2, but other mappings are possible.
         // ==> lod = sqrt(linear_roughness)
         const double linear_roughness = lod * lod;
+        // as the filter gets wider, it needs more samples to converge; since there is 4x less
+        // work per level, this doesn't slow things down a lot.
+        const size_t numSamples = DEBUG_FULL_RESOLUTION ? g_num_samples
+                : CubemapIBL::adaptiveSampleCount(g_num_samples, linear_roughness);
         if (!g_quiet) {
             std::cout << "Level " << level <<
                     std::setprecision(3)
                     << ", roughness(lin) = " << linear_roughness
                     << ", roughness = " << sqrt(linear_roughness)
+                    << ", samples = " << numSamples
                     << std::endl;
         }
         Image image;
@@ -859,6 +963,25 @@ void iblRoughnessPrefilter(const utils::Path& iname,
 
         std::string ext = ImageEncoder::chooseExtension(g_format);
 
+        if (g_bundle) {
+            BundleLevel bundleLevel;
+            bundleLevel.dim = dim;
+            for (size_t j = 0; j < 6; j++) {
+                Cubemap::Face face;
+                switch (j) {
+                    case 0: face = Cubemap::Face::PX; break;
+                    case 1: face = Cubemap::Face::NX; break;
+                    case 2: face = Cubemap::Face::PY; break;
+                    case 3: face = Cubemap::Face::NY; break;
+                    case 4: face = Cubemap::Face::PZ; break;
+                    case 5: face = Cubemap::Face::NZ; break;
+                }
+                bundleLevel.faces[j] = fromLinearToRGBM<uint8_t>(dst.getImageForFace(face));
+            }
+            g_bundle_levels.push_back(std::move(bundleLevel));
+            continue;
+        }
+
         if (g_type == OutputType::KTX) {
             exportKtxFaces(container, level, dst);
             continue;
@@ -1129,3 +1252,155 @@ static void exportKtxFaces(KtxBundle& container, uint32_t miplevel, const Cubema
         container.setBlob(blobIndex, uintData.get(), dim * dim * 4);
     }
 }
+
+// -----------------------------------------------------------------------------------------------
+// Incremental mode
+// -----------------------------------------------------------------------------------------------
+
+static const char* MANIFEST_NAME = "cmgen.manifest";
+
+static uint32_t hashImage(const Image& image, uint32_t seed) {
+    // hash row by row since the image may have padding
+    const size_t height = image.getHeight();
+    const size_t wordsPerRow = (image.getWidth() * image.getBytesPerPixel()) / sizeof(uint32_t);
+    uint32_t hash = seed;
+    for (size_t y = 0; y < height; ++y) {
+        hash = utils::hash::murmur3(
+                static_cast<uint32_t const*>(image.getPixelRef(0, y)), wordsPerRow, hash);
+    }
+    return hash;
+}
+
+static uint32_t computeOptionsHash() {
+    uint32_t words[] = {
+            (uint32_t) g_output_size,
+            (uint32_t) g_num_samples,
+            (uint32_t) g_mirror,
+            (uint32_t) g_sh_compute,
+            (uint32_t) g_sh_irradiance | ((uint32_t) g_sh_shader << 1),
+            (uint32_t) g_format,
+            (uint32_t) g_type,
+            (uint32_t) g_bundle,
+    };
+    uint32_t hash = utils::hash::murmur3(words, sizeof(words) / sizeof(words[0]), 0);
+    if (!g_compression.empty()) {
+        // fold in the compression string, zero-padded to a whole number of words
+        std::vector<uint32_t> padded((g_compression.size() + 3) / 4, 0);
+        memcpy(padded.data(), g_compression.data(), g_compression.size());
+        hash = utils::hash::murmur3(padded.data(), padded.size(), hash);
+    }
+    return hash;
+}
+
+void computeInputDigests(const Cubemap& cm) {
+    uint32_t words[7];
+    for (size_t i = 0; i < 6; i++) {
+        g_face_hashes[i] = hashImage(cm.getImageForFace((Cubemap::Face) i), 0);
+        words[i] = g_face_hashes[i];
+    }
+    words[6] = computeOptionsHash();
+    g_input_digest = utils::hash::murmur3(words, 7, 0);
+}
+
+static std::map<std::string, uint32_t> readManifest(const utils::Path& outputDir) {
+    std::map<std::string, uint32_t> entries;
+    std::ifstream input(outputDir + MANIFEST_NAME);
+    std::string key;
+    uint32_t value;
+    while (input >> key >> std::hex >> value) {
+        entries[key] = value;
+    }
+    return entries;
+}
+
+bool isProductUpToDate(const utils::Path& outputDir, const std::string& product) {
+    const auto entries = readManifest(outputDir);
+    const auto it = entries.find(product);
+    return it != entries.end() && it->second == g_input_digest;
+}
+
+void updateManifest(const utils::Path& outputDir, const std::string& product) {
+    auto entries = readManifest(outputDir);
+    for (size_t i = 0; i < 6; i++) {
+        entries["face_" + CubemapUtils::getFaceName((Cubemap::Face) i)] = g_face_hashes[i];
+    }
+    entries[product] = g_input_digest;
+    std::ofstream output(outputDir + MANIFEST_NAME, std::ios::trunc);
+    for (const auto& entry : entries) {
+        output << entry.first << " "
+               << std::setfill('0') << std::setw(8) << std::hex << entry.second << "\n";
+    }
+}
+
+// -----------------------------------------------------------------------------------------------
+// Deployment bundle
+// -----------------------------------------------------------------------------------------------
+
+// Raw deployment bundle written by --deploy-bundle. All pixel data is tightly packed RGBM in
+// px/nx/py/ny/pz/nz order, and the first face starts on a page boundary so the file can be
+// memory-mapped and handed to the engine as-is. The layout must match the reader in
+// samples/app/IBL.cpp.
+struct BundleHeader {
+    uint32_t magic;         // BUNDLE_MAGIC
+    uint32_t dimensions;    // dimension of the base prefiltered miplevel
+    uint32_t levels;        // number of prefiltered miplevels
+    uint32_t shBands;       // number of SH bands (shBands^2 float3 coefficients follow the header)
+    uint32_t skyboxDim;     // dimension of the skybox faces, stored after the prefiltered levels
+    uint32_t dataOffset;    // file offset of the first prefiltered face
+};
+
+static constexpr uint32_t BUNDLE_MAGIC = 0x314c4249;    // 'IBL1', little-endian
+static constexpr uint32_t BUNDLE_DATA_ALIGNMENT = 4096;
+
+void writeDeployBundle(const utils::Path& iname, const Cubemap& skybox, const utils::Path& dir) {
+    utils::Path outputDir(dir.getAbsolutePath() + iname.getNameWithoutExtension());
+    if (!outputDir.exists()) {
+        outputDir.mkdirRecursive();
+    }
+
+    BundleHeader header = {
+            .magic = BUNDLE_MAGIC,
+            .dimensions = (uint32_t) g_bundle_levels[0].dim,
+            .levels = (uint32_t) g_bundle_levels.size(),
+            .shBands = (uint32_t) g_sh_compute,
+            .skyboxDim = (uint32_t) skybox.getDimensions(),
+            .dataOffset = BUNDLE_DATA_ALIGNMENT,
+    };
+
+    utils::Path filePath = outputDir + (iname.getNameWithoutExtension() + ".ibl");
+    std::ofstream output(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    output.write((const char*) &header, sizeof(header));
+
+    // the pre-scaled SH coefficients, as computed for the sh.txt deployment output
+    const size_t numCoefs = g_sh_compute * g_sh_compute;
+    for (size_t i = 0; i < numCoefs; i++) {
+        const math::float3 v(g_coefficients ? math::float3(g_coefficients[i]) : math::float3(0));
+        output.write((const char*) &v, sizeof(v));
+    }
+
+    const std::string padding(BUNDLE_DATA_ALIGNMENT - sizeof(header) - numCoefs * sizeof(math::float3), '\0');
+    output.write(padding.data(), padding.size());
+
+    for (const BundleLevel& level : g_bundle_levels) {
+        const size_t faceSize = level.dim * level.dim * 4;
+        for (size_t j = 0; j < 6; j++) {
+            output.write((const char*) level.faces[j].get(), faceSize);
+        }
+    }
+
+    // the unfiltered base level doubles as the skybox
+    for (size_t j = 0; j < 6; j++) {
+        Cubemap::Face face;
+        switch (j) {
+            case 0: face = Cubemap::Face::PX; break;
+            case 1: face = Cubemap::Face::NX; break;
+            case 2: face = Cubemap::Face::PY; break;
+            case 3: face = Cubemap::Face::NY; break;
+            case 4: face = Cubemap::Face::PZ; break;
+            case 5: face = Cubemap::Face::NZ; break;
+        }
+        auto rgbm = fromLinearToRGBM<uint8_t>(skybox.getImageForFace(face));
+        output.write((const char*) rgbm.get(), header.skyboxDim * header.skyboxDim * 4);
+    }
+    output.close();
+}
@@ -15,8 +15,13 @@
  */
 
 
+#include <algorithm>
+#include <cassert>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <vector>
 
 #include <math/half.h>
 #include <math/mat3.h>
@@ -24,6 +29,7 @@
 #include <math/quat.h>
 #include <math/vec3.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
@@ -38,7 +44,12 @@ using namespace utils;
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 
-static const uint32_t VERSION = 1;
+// Version 2 pads the index data to a 4-byte boundary, which guarantees that every
+// section of the file is naturally aligned when the file is memory-mapped. Loaders
+// can then hand the vertex and index data directly to the engine without copying.
+// Version 3 appends a normal cone (xyz axis, w = sine of the half-angle) to each
+// part record, enabling per-primitive backface cluster culling at render time.
+static const uint32_t VERSION = 3;
 
 using Assimp::Importer;
 
@@ -65,6 +76,7 @@ struct Header {
 };
 
 struct Vertex {
+    Vertex() = default;
     Vertex(const float3& position, const quatf& tangents, const float4& color, const float3& uv0):
             position(position, 1.0_h),
             tangents(packSnorm16(tangents.xyzw)),
@@ -80,13 +92,14 @@ struct Vertex {
 
 struct Mesh {
     Mesh(uint32_t offset, uint32_t count, uint32_t minIndex, uint32_t maxIndex,
-            uint32_t material, const Box& aabb):
+            uint32_t material, const Box& aabb, const float4& normalCone):
             offset(offset),
             count(count),
             minIndex(minIndex),
             maxIndex(maxIndex),
             material(material),
-            aabb(aabb) {
+            aabb(aabb),
+            normalCone(normalCone) {
     }
 
     uint32_t offset;
@@ -95,10 +108,19 @@ struct Mesh {
     uint32_t maxIndex;
     uint32_t material;
     Box aabb;
+    float4 normalCone;
 };
 
 // configuration
 bool g_interleaved = false;
+bool g_optimize = true;
+
+// number of post-transform cache entries assumed by the vertex cache optimization;
+// chosen below the size of actual hardware caches so the ordering also works on GPUs
+// with smaller caches
+static constexpr uint32_t VERTEX_CACHE_SIZE = 24;
+// FIFO cache size used to report ACMR (average cache miss ratio, misses per triangle)
+static constexpr uint32_t ACMR_CACHE_SIZE = 32;
 
 uint32_t g_vertexCount = 0;
 std::vector<uint32_t> g_indices;
@@ -111,6 +133,104 @@ std::vector<decltype(Vertex::color)>     g_colors;
 std::vector<decltype(Vertex::uv0)>       g_uv0;
 std::vector<decltype(Vertex::uv0)>       g_uv1;
 
+static utils::JobSystem& getJobSystem() {
+    static utils::JobSystem js;
+    js.adopt();
+    return js;
+}
+
+// number of vertices processed per job when packing vertex attributes; large enough that the
+// compiler can vectorize the inner loops and the scheduling overhead stays negligible
+static constexpr uint32_t VERTEX_BLOCK_SIZE = 2048;
+
+// Generates per-vertex tangent frames from the UV parameterization, following the mikktspace
+// conventions: per-corner tangents and bitangents are accumulated at each vertex weighted by
+// the corner angle, then orthonormalized against the vertex normal, with the handedness carried
+// by the reconstructed bitangent. Source meshes that already contain tangents keep them.
+static void generateTangentFrames(const aiMesh* mesh,
+        std::vector<float3>& outTangents, std::vector<float3>& outBitangents) {
+    const size_t numVertices = mesh->mNumVertices;
+    const float3* positions = reinterpret_cast<const float3*>(mesh->mVertices);
+    const float3* normals = reinterpret_cast<const float3*>(mesh->mNormals);
+    const float3* uv0 = reinterpret_cast<const float3*>(mesh->mTextureCoords[0]);
+
+    outTangents.assign(numVertices, float3(0));
+    outBitangents.assign(numVertices, float3(0));
+
+    if (mesh->HasTangentsAndBitangents()) {
+        const float3* tangents = reinterpret_cast<const float3*>(mesh->mTangents);
+        const float3* bitangents = reinterpret_cast<const float3*>(mesh->mBitangents);
+        std::copy(tangents, tangents + numVertices, outTangents.begin());
+        std::copy(bitangents, bitangents + numVertices, outBitangents.begin());
+        return;
+    }
+
+    // accumulation shares vertices between triangles, so this part stays sequential; it is
+    // only a handful of mads per triangle and is dwarfed by the per-vertex pass below
+    const aiFace* faces = mesh->mFaces;
+    for (size_t t = 0; t < mesh->mNumFaces; t++) {
+        const aiFace& face = faces[t];
+        if (face.mNumIndices != 3) {
+            continue;
+        }
+        const uint32_t i0 = face.mIndices[0];
+        const uint32_t i1 = face.mIndices[1];
+        const uint32_t i2 = face.mIndices[2];
+        const float3 e1 = positions[i1] - positions[i0];
+        const float3 e2 = positions[i2] - positions[i0];
+        const float2 duv1 = uv0[i1].xy - uv0[i0].xy;
+        const float2 duv2 = uv0[i2].xy - uv0[i0].xy;
+
+        const float det = duv1.x * duv2.y - duv2.x * duv1.y;
+        if (std::abs(det) < std::numeric_limits<float>::epsilon()) {
+            // degenerate parameterization, an arbitrary frame is chosen in the vertex pass
+            continue;
+        }
+        const float invDet = 1.0f / det;
+        const float3 tangent = (e1 * duv2.y - e2 * duv1.y) * invDet;
+        const float3 bitangent = (e2 * duv1.x - e1 * duv2.x) * invDet;
+
+        for (size_t k = 0; k < 3; k++) {
+            const uint32_t a = face.mIndices[k];
+            const uint32_t b = face.mIndices[(k + 1) % 3];
+            const uint32_t c = face.mIndices[(k + 2) % 3];
+            const float3 ab = normalize(positions[b] - positions[a]);
+            const float3 ac = normalize(positions[c] - positions[a]);
+            const float w = std::acos(clamp(dot(ab, ac), -1.0f, 1.0f));
+            outTangents[a] += tangent * w;
+            outBitangents[a] += bitangent * w;
+        }
+    }
+
+    // orthonormalize per vertex, in parallel over vertex blocks
+    float3* tangents = outTangents.data();
+    float3* bitangents = outBitangents.data();
+    auto orthonormalizeTask = [tangents, bitangents, normals](uint32_t start, uint32_t count) {
+                for (uint32_t j = start; j < start + count; j++) {
+                    const float3 n = normals[j];
+                    float3 t = tangents[j];
+                    t -= n * dot(n, t);
+                    if (length2(t) < std::numeric_limits<float>::epsilon()) {
+                        // no usable parameterization, pick any frame around the normal
+                        const float3 up = std::abs(n.z) < 0.999f
+                                ? float3(0, 0, 1) : float3(1, 0, 0);
+                        t = normalize(cross(up, n));
+                        bitangents[j] = cross(n, t);
+                    } else {
+                        t = normalize(t);
+                        const float sign = dot(cross(n, t), bitangents[j]) < 0 ? -1.0f : 1.0f;
+                        bitangents[j] = cross(n, t) * sign;
+                    }
+                    tangents[j] = t;
+                }
+            };
+    utils::JobSystem& js = getJobSystem();
+    auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(numVertices),
+            std::ref(orthonormalizeTask), jobs::CountSplitter<VERTEX_BLOCK_SIZE>());
+    js.runAndWait(job);
+    js.reset();
+}
+
 template<typename T>
 void write(std::ofstream& out, const T& value) {
     out.write((const char*) &value, sizeof(T));
@@ -136,6 +256,241 @@ static Box computeAABB(VECTOR const* positions, INDEX const* indices,
     return Box().set(bmin, bmax);
 }
 
+// Normal cone of a triangle set: the axis is the (area-weighted) average face normal,
+// the w component is the sine of the cone's half-angle. A primitive can be skipped when
+// the whole cone faces away from the viewpoint (see RenderableManager::Builder::bounds()).
+// w >= 1 means the cone covers more than a hemisphere and the test is disabled; this is
+// also what degenerate geometry returns.
+template<typename VECTOR, typename INDEX>
+static math::float4 computeNormalCone(VECTOR const* positions, INDEX const* indices,
+        size_t count, size_t stride) noexcept {
+    auto position = [positions, stride](INDEX index) -> math::float3 {
+        VECTOR const* p = reinterpret_cast<VECTOR const *>(
+                (char const*) positions + index * stride);
+        return math::float3(p->x, p->y, p->z);
+    };
+    // area-weighted average of the face normals (cross products are twice the face area)
+    math::float3 axis(0.0f);
+    for (size_t i = 0; i + 2 < count; i += 3) {
+        const math::float3 v0(position(indices[i]));
+        axis += cross(position(indices[i + 1]) - v0, position(indices[i + 2]) - v0);
+    }
+    const float l = length(axis);
+    if (!(l > 0.0f)) {
+        return math::float4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    axis *= 1.0f / l;
+    // the cone's angle is the largest angle between the axis and a face normal
+    float mindot = 1.0f;
+    for (size_t i = 0; i + 2 < count; i += 3) {
+        const math::float3 v0(position(indices[i]));
+        const math::float3 n(cross(position(indices[i + 1]) - v0,
+                position(indices[i + 2]) - v0));
+        const float ln = length(n);
+        if (ln > 0.0f) {
+            mindot = std::min(mindot, dot(n, axis) / ln);
+        }
+    }
+    if (mindot <= 0.0f) {
+        // normals spread over a hemisphere or more, the cone can never be culled
+        return math::float4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    return math::float4(axis, std::sqrt(1.0f - mindot * mindot));
+}
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO
+// post-transform cache of the given size. 3.0 is worst case, 0.5 is the
+// theoretical best for a regular grid.
+static float computeACMR(uint32_t const* indices, size_t indexCount,
+        uint32_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i];
+        if (time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+    return float(misses) / float(triangleCount);
+}
+
+// Reorders triangles to minimize post-transform vertex cache misses using the
+// linear-speed algorithm of Sander et al. 2007 ("Tipsify"). Triangles are emitted
+// by fanning around a focus vertex; the next focus is chosen among the 1-ring so
+// it is still in the cache once its remaining triangles are emitted, which also
+// yields compact, roughly planar clusters.
+static void optimizeIndices(uint32_t* indices, size_t indexCount,
+        uint32_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // per-vertex list of incident triangles
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        liveTriangles[indices[i]]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (size_t j = 0; j < 3; j++) {
+                adjacency[cursors[indices[t * 3 + j]]++] = uint32_t(t);
+            }
+        }
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    uint32_t time = cacheSize + 1;
+    uint32_t scanCursor = 0;    // for restarts once the dead-end stack is exhausted
+    int64_t fanning = indices[0];
+
+    while (fanning >= 0) {
+        candidates.clear();
+
+        // emit all live triangles around the fanning vertex
+        for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            const uint32_t t = adjacency[i];
+            if (!emitted[t]) {
+                emitted[t] = true;
+                for (size_t j = 0; j < 3; j++) {
+                    const uint32_t v = indices[t * 3 + j];
+                    output.push_back(v);
+                    deadEndStack.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+                    if (time - timestamps[v] > cacheSize) {
+                        timestamps[v] = time++;
+                    }
+                }
+            }
+        }
+
+        // pick the next fanning vertex among the 1-ring: prefer the vertex that will
+        // still be in the cache after its remaining triangles are emitted, oldest first
+        fanning = -1;
+        uint32_t bestPriority = 0;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            const uint32_t age = time - timestamps[v];
+            const uint32_t priority = (age + 2 * liveTriangles[v] <= cacheSize) ? age : 0;
+            if (fanning < 0 || priority > bestPriority) {
+                fanning = v;
+                bestPriority = priority;
+            }
+        }
+
+        if (fanning < 0) {
+            // dead-end: backtrack through recently visited vertices, then scan
+            while (!deadEndStack.empty()) {
+                const uint32_t v = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveTriangles[v] > 0) {
+                    fanning = v;
+                    break;
+                }
+            }
+            while (fanning < 0 && scanCursor < vertexCount) {
+                if (liveTriangles[scanCursor] > 0) {
+                    fanning = scanCursor;
+                }
+                scanCursor++;
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template<typename T>
+static void reorderVertices(std::vector<T>& data, std::vector<uint32_t> const& remap) {
+    if (data.empty()) {
+        return;
+    }
+    // the remap is a permutation of the full vertex range, so every non-empty
+    // attribute array must be dense: one entry per vertex
+    assert(data.size() == remap.size());
+    std::vector<T> reordered(data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        reordered[remap[i]] = data[i];
+    }
+    data.swap(reordered);
+}
+
+// Cook-time geometry optimization: reorders each part's triangles for the
+// post-transform cache, then renumbers the vertices in first-use order so the
+// pre-transform fetch is sequential. Parts and AABBs are unaffected; only the
+// ordering within the buffers changes.
+static void optimizeGeometry(std::vector<Mesh>& meshes) {
+    const float acmrBefore =
+            computeACMR(g_indices.data(), g_indices.size(), g_vertexCount, ACMR_CACHE_SIZE);
+
+    for (Mesh& mesh : meshes) {
+        optimizeIndices(g_indices.data() + mesh.offset, mesh.count,
+                g_vertexCount, VERTEX_CACHE_SIZE);
+    }
+
+    // renumber vertices in first-use order; unreferenced vertices go last
+    const uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(g_vertexCount, INVALID);
+    uint32_t nextVertex = 0;
+    for (uint32_t& index : g_indices) {
+        if (remap[index] == INVALID) {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+    for (uint32_t v = 0; v < g_vertexCount; v++) {
+        if (remap[v] == INVALID) {
+            remap[v] = nextVertex++;
+        }
+    }
+
+    reorderVertices(g_vertices, remap);
+    reorderVertices(g_positions, remap);
+    reorderVertices(g_tangents, remap);
+    reorderVertices(g_colors, remap);
+    reorderVertices(g_uv0, remap);
+    reorderVertices(g_uv1, remap);
+
+    // the renumbering moved each part's index range
+    for (Mesh& mesh : meshes) {
+        uint32_t minIndex = INVALID;
+        uint32_t maxIndex = 0;
+        for (uint32_t i = mesh.offset; i < mesh.offset + mesh.count; i++) {
+            minIndex = std::min(minIndex, g_indices[i]);
+            maxIndex = std::max(maxIndex, g_indices[i]);
+        }
+        mesh.minIndex = minIndex;
+        mesh.maxIndex = maxIndex;
+    }
+
+    const float acmrAfter =
+            computeACMR(g_indices.data(), g_indices.size(), g_vertexCount, ACMR_CACHE_SIZE);
+    std::cout << "Vertex cache ACMR: " << std::fixed << std::setprecision(3)
+              << acmrBefore << " -> " << acmrAfter
+              << " (FIFO " << ACMR_CACHE_SIZE << ")" << std::endl;
+}
+
 template<bool INTERLEAVED>
 void processNode(const aiScene* scene, const aiNode* node, std::vector<Mesh>& meshes) {
     for (size_t i = 0; i < node->mNumMeshes; ++i) {
@@ -146,8 +501,6 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Mesh>& me
         }
 
         const float3* vertices = reinterpret_cast<const float3*>(mesh->mVertices);
-        const float3* tangents = reinterpret_cast<const float3*>(mesh->mTangents);
-        const float3* bitangents = reinterpret_cast<const float3*>(mesh->mBitangents);
         const float3* normals = reinterpret_cast<const float3*>(mesh->mNormals);
         const float4* colors = reinterpret_cast<const float4*>(mesh->mColors[0]);
         const float3* uv0 = reinterpret_cast<const float3*>(mesh->mTextureCoords[0]);
@@ -160,8 +513,6 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Mesh>& me
             uv1 = nullptr;
         }
 
-        float4 color = {};
-
         const size_t numVertices = mesh->mNumVertices;
         if (numVertices > 0) {
             const aiFace* faces = mesh->mFaces;
@@ -171,32 +522,54 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Mesh>& me
                 size_t indicesOffset = g_vertexCount;
                 g_vertexCount += numVertices;
                 if (INTERLEAVED) {
-                    g_vertices.reserve(g_vertexCount);
+                    g_vertices.resize(g_vertexCount);
                 } else {
-                    g_positions.reserve(g_vertexCount);
-                    g_tangents.reserve(g_vertexCount);
-                    g_uv0.reserve(g_vertexCount);
-                }
-
-                for (size_t j = 0; j < numVertices; j++) {
-                    quatf q = mat3f::packTangentFrame({tangents[j], bitangents[j], normals[j]});
-
-                    color = colors ? colors[j] : float4(1.0f);
-                    if (INTERLEAVED) {
-                        g_vertices.emplace_back(vertices[j], q, color, uv0[j]);
-                    } else {
-                        // use the same conversions as in the interleaved case
-                        Vertex v(vertices[j], q, color, uv0[j]);
-                        g_positions.emplace_back(v.position);
-                        g_tangents.emplace_back(v.tangents);
-                        g_colors.emplace_back(v.color);
-                        g_uv0.emplace_back(v.uv0);
-                        if (uv1 != nullptr) {
-                            g_uv1.emplace_back(uv1[j].xy);
-                        }
+                    g_positions.resize(g_vertexCount);
+                    g_tangents.resize(g_vertexCount);
+                    g_colors.resize(g_vertexCount);
+                    g_uv0.resize(g_vertexCount);
+                    // UV1 is optional per mesh: once any mesh carries it, the channel
+                    // is kept dense at one entry per vertex (zero-filled for meshes
+                    // without it), so the vertex remap of optimizeGeometry() applies
+                    // uniformly and the writer emits exactly the vertexCount entries
+                    // the header's offsetUV1 accounts for
+                    if (uv1 != nullptr || !g_uv1.empty()) {
+                        g_uv1.resize(g_vertexCount);
                     }
                 }
 
+                std::vector<float3> meshTangents;
+                std::vector<float3> meshBitangents;
+                generateTangentFrames(mesh, meshTangents, meshBitangents);
+
+                // pack the vertex attributes in parallel over vertex blocks; the quaternion
+                // tangent encoding is what the engine's vertex shaders expect
+                auto packTask = [&, base = indicesOffset](uint32_t start, uint32_t count) {
+                            for (uint32_t j = start; j < start + count; j++) {
+                                const quatf q = mat3f::packTangentFrame(
+                                        { meshTangents[j], meshBitangents[j], normals[j] });
+                                const float4 color = colors ? colors[j] : float4(1.0f);
+                                // use the same conversions in both layouts
+                                const Vertex v(vertices[j], q, color, uv0[j]);
+                                if (INTERLEAVED) {
+                                    g_vertices[base + j] = v;
+                                } else {
+                                    g_positions[base + j] = v.position;
+                                    g_tangents[base + j] = v.tangents;
+                                    g_colors[base + j] = v.color;
+                                    g_uv0[base + j] = v.uv0;
+                                    if (uv1 != nullptr) {
+                                        g_uv1[base + j] = half2(uv1[j].xy);
+                                    }
+                                }
+                            }
+                        };
+                utils::JobSystem& js = getJobSystem();
+                auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(numVertices),
+                        std::ref(packTask), jobs::CountSplitter<VERTEX_BLOCK_SIZE>());
+                js.runAndWait(job);
+                js.reset();
+
                 // all faces should be triangles since we configure assimp to triangulate faces
                 size_t indicesCount = numFaces * faces[0].mNumIndices;
                 size_t indexBufferOffset = g_indices.size();
@@ -214,9 +587,12 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Mesh>& me
                         INTERLEAVED ? &g_vertices.data()->position : g_positions.data();
                 const Box aabb(computeAABB(positions,
                         g_indices.data() + indexBufferOffset, indicesCount, stride));
+                const float4 normalCone(computeNormalCone(positions,
+                        g_indices.data() + indexBufferOffset, indicesCount, stride));
 
                 meshes.emplace_back(indexBufferOffset, indicesCount, indicesOffset,
-                        indicesOffset + indicesCount - 1, mesh->mMaterialIndex, aabb);
+                        indicesOffset + indicesCount - 1, mesh->mMaterialIndex, aabb,
+                        normalCone);
             }
         }
     }
@@ -245,6 +621,9 @@ static void printUsage(const char* name) {
                     "       Print copyright and license information\n\n"
                     "   --interleaved, -i\n"
                     "       interleaves mesh attributes\n\n"
+                    "   --no-optimize, -n\n"
+                    "       keep the source triangle and vertex order (skips the\n"
+                    "       vertex cache / vertex fetch optimization)\n\n"
     );
 
     const std::string from("FILAMESH");
@@ -261,11 +640,12 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hil";
+    static constexpr const char* OPTSTR = "hiln";
     static const struct option OPTIONS[] = {
             { "help",        no_argument, 0, 'h' },
             { "license",     no_argument, 0, 'l' },
             { "interleaved", no_argument, 0, 'i' },
+            { "no-optimize", no_argument, 0, 'n' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -287,6 +667,9 @@ static int handleArguments(int argc, char* argv[]) {
             case 'i':
                 g_interleaved = true;
                 break;
+            case 'n':
+                g_optimize = false;
+                break;
         }
     }
 
@@ -315,15 +698,15 @@ int main(int argc, char* argv[]) {
     importer.SetPropertyBool(AI_CONFIG_PP_PTV_KEEP_HIERARCHY, true);
 
     const aiScene* scene = importer.ReadFile(src,
-            // normals and tangents
+            // normals (tangent frames are generated by our own multi-threaded pass,
+            // unless the source mesh provides them)
             aiProcess_GenSmoothNormals |
-            aiProcess_CalcTangentSpace |
             // topology optimization
             aiProcess_FindInstances |
             aiProcess_OptimizeMeshes |
             aiProcess_JoinIdenticalVertices |
-            // misc optimization
-            aiProcess_ImproveCacheLocality |
+            // misc optimization (vertex cache ordering is done by our own pass below,
+            // which also covers vertex fetch order and reports ACMR)
             aiProcess_PreTransformVertices |
             aiProcess_SortByPType |
             // we only support triangles
@@ -344,6 +727,10 @@ int main(int argc, char* argv[]) {
         processNode<false>(scene, node, meshes);
     }
 
+    if (g_optimize && !meshes.empty()) {
+        optimizeGeometry(meshes);
+    }
+
     Path dst(argv[optionIndex + 1]);
     std::ofstream out(dst, std::ios::binary | std::ios::trunc);
     if (!out.good()) {
@@ -426,6 +813,12 @@ int main(int argc, char* argv[]) {
         write(out, smallIndices.data(), uint32_t(smallIndices.size()));
     }
 
+    // pad the index data so the part table that follows is 4-byte aligned
+    uint32_t padding = (4 - (header.indexSize & 3)) & 3;
+    if (padding > 0) {
+        write(out, "\0\0\0", padding);
+    }
+
     write(out, meshes.data(), header.parts);
 
     uint32_t materialCount = scene->mNumMaterials;
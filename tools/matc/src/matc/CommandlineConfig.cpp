@@ -22,6 +22,8 @@
 
 #include <utils/Path.h>
 
+#include <cstdlib>
+#include <fstream>
 #include <istream>
 #include <sstream>
 #include <string>
@@ -59,6 +61,15 @@ static void usage(char* name) {
             "       Specify the target API: opengl (default), vulkan or all\n\n"
             "   --reflect, -r\n"
             "       Reflect the specified metadata as JSON: parameters\n\n"
+            "   --jobs=<n>, -j <n>\n"
+            "       Compile the shader variants on <n> threads (default 1)\n\n"
+            "   --cache=<dir>, -c <dir>\n"
+            "       Cache compiled shaders in <dir>, keyed by their content, so unchanged\n"
+            "       variants are reused across runs\n\n"
+            "   --variant-allowlist=<file>, -w <file>\n"
+            "       Only keep the variants whose keys are listed in <file> (decimal or 0x hex,\n"
+            "       whitespace separated, '#' starts a comment), typically recorded at runtime\n"
+            "       from the 'd.variants.used' debug property. Depth variants are always kept\n\n"
             "   --variant-filter=<filter>, -v <filter>\n"
             "       Filter out specified comma-separated variants:\n"
             "           directionalLighting, dynamicLighting, shadowReceiver, skinning\n"
@@ -91,7 +102,7 @@ CommandlineConfig::CommandlineConfig(int argc, char** argv) : Config(), mArgc(ar
 }
 
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hxo:f:dm:a:p:OSEr:v:";
+    static constexpr const char* OPTSTR = "hxo:f:dm:a:p:OSEr:v:w:j:c:";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'l' },
@@ -100,6 +111,7 @@ bool CommandlineConfig::parse() {
             { "debug",                   no_argument, nullptr, 'd' },
             { "mode",              required_argument, nullptr, 'm' },
             { "variant-filter",    required_argument, nullptr, 'v' },
+            { "variant-allowlist", required_argument, nullptr, 'w' },
             { "platform",          required_argument, nullptr, 'p' },
             { "optimize",                no_argument, nullptr, 'x' },
             { "optimize",                no_argument, nullptr, 'O' },
@@ -108,6 +120,8 @@ bool CommandlineConfig::parse() {
             { "api",               required_argument, nullptr, 'a' },
             { "reflect",           required_argument, nullptr, 'r' },
             { "print",                   no_argument, nullptr, 't' },
+            { "jobs",              required_argument, nullptr, 'j' },
+            { "cache",             required_argument, nullptr, 'c' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -201,6 +215,32 @@ bool CommandlineConfig::parse() {
                 mVariantFilter = variantFilter;
                 break;
             }
+            case 'w': {
+                std::ifstream manifest(arg.c_str());
+                if (!manifest) {
+                    std::cerr << "Could not open the variant allowlist manifest: " << arg
+                            << std::endl;
+                    return false;
+                }
+                uint16_t variantAllowlist = 0;
+                std::string token;
+                while (manifest >> token) {
+                    if (token[0] == '#') {
+                        // comment, skip the rest of the line
+                        std::getline(manifest, token);
+                        continue;
+                    }
+                    unsigned long key = strtoul(token.c_str(), nullptr, 0);
+                    if (key >= filament::VARIANT_COUNT) {
+                        std::cerr << "Variant key out of range in allowlist manifest: "
+                                << token << std::endl;
+                        return false;
+                    }
+                    variantAllowlist |= uint16_t(1u << key);
+                }
+                mVariantAllowlist = variantAllowlist;
+                break;
+            }
             case 'O':
             case 'x':
                 mOptimizationLevel = Optimization::PERFORMANCE;
@@ -217,6 +257,14 @@ bool CommandlineConfig::parse() {
             case 't':
                 mPrintShaders = true;
                 break;
+            case 'j': {
+                int jobs = atoi(arg.c_str());
+                mJobs = jobs > 0 ? uint32_t(jobs) : 1;
+                break;
+            }
+            case 'c':
+                mCompileCacheDir = arg;
+                break;
         }
     }
 
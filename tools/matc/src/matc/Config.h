@@ -136,6 +136,18 @@ public:
         return mVariantFilter;
     }
 
+    uint16_t getVariantAllowlist() const noexcept {
+        return mVariantAllowlist;
+    }
+
+    uint32_t getJobs() const noexcept {
+        return mJobs;
+    }
+
+    const std::string& getCompileCacheDir() const noexcept {
+        return mCompileCacheDir;
+    }
+
 protected:
     bool mDebug = false;
     bool mIsValid = true;
@@ -147,6 +159,9 @@ protected:
     OutputFormat mOutputFormat = OutputFormat::BLOB;
     TargetApi mTargetApi = TargetApi::OPENGL;
     uint8_t mVariantFilter = 0;
+    uint16_t mVariantAllowlist = 0xffff;
+    uint32_t mJobs = 1;
+    std::string mCompileCacheDir;
 };
 
 }
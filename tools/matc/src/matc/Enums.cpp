@@ -74,6 +74,7 @@ std::unordered_map<std::string, UniformType>& Enums::getMap<UniformType>() noexc
 
 std::unordered_map<std::string, SamplerType> Enums::mStringToSamplerType = {
         { "sampler2d",       SamplerType::SAMPLER_2D },
+        { "sampler2dArray",  SamplerType::SAMPLER_2D_ARRAY },
         { "samplerCubemap",  SamplerType::SAMPLER_CUBEMAP },
         { "samplerExternal", SamplerType::SAMPLER_EXTERNAL },
 };
@@ -288,7 +288,13 @@ bool MaterialCompiler::run(const Config& config) {
         .platform(config.getPlatform())
         .targetApi(config.getTargetApi())
         .codeGenTargetApi(config.getCodeGenTargetApi())
-        .variantFilter(config.getVariantFilter() | builder.getVariantFilter());
+        .variantFilter(config.getVariantFilter() | builder.getVariantFilter())
+        .variantAllowlist(config.getVariantAllowlist())
+        .threads(config.getJobs());
+
+    if (!config.getCompileCacheDir().empty()) {
+        builder.compileCache(config.getCompileCacheDir().c_str());
+    }
 
     // At this point the builder may be able to generate valid shaders if the user populated the
     // properties section in the config file properly. If she hasn't, guess them.
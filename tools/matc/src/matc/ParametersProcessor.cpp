@@ -115,6 +115,10 @@ ParametersProcessor::ParametersProcessor() {
     mStringToAttributeIndex["tangents"] = filament::VertexAttribute::TANGENTS;
     mStringToAttributeIndex["uv0"] = filament::VertexAttribute::UV0;
     mStringToAttributeIndex["uv1"] = filament::VertexAttribute::UV1;
+    mStringToAttributeIndex["morphPosition0"] = filament::VertexAttribute::MORPH_POSITION_0;
+    mStringToAttributeIndex["morphPosition1"] = filament::VertexAttribute::MORPH_POSITION_1;
+    mStringToAttributeIndex["morphPosition2"] = filament::VertexAttribute::MORPH_POSITION_2;
+    mStringToAttributeIndex["morphPosition3"] = filament::VertexAttribute::MORPH_POSITION_3;
 
     mStringToShading["cloth"] = MaterialBuilder::Shading::CLOTH;
     mStringToShading["lit"] = MaterialBuilder::Shading::LIT;
@@ -38,24 +38,33 @@ public:
 
     using SpirvBlob = std::vector<uint32_t>;
 
+    // Reentrant: all per-invocation state lives on the stack, so process() may be called
+    // concurrently from several threads (see filamat::MaterialBuilder::threads()).
     bool process(const std::string& inputShader, filament::driver::ShaderType shaderType,
             filament::driver::ShaderModel shaderModel, std::string* outputGlsl,
             SpirvBlob* outputSpirv);
 
 private:
+    // per-invocation state, passed down instead of stored in members so that process()
+    // stays reentrant
+    struct InternalConfig {
+        std::string* glslOutput = nullptr;
+        SpirvBlob* spirvOutput = nullptr;
+        EShLanguage shLang = EShLangFragment;
+        int langVersion = 0;
+    };
+
     void fullOptimization(const glslang::TShader& tShader,
-            const filament::driver::ShaderModel shaderModel) const;
+            const filament::driver::ShaderModel shaderModel,
+            InternalConfig const& internalConfig) const;
     void preprocessOptimization(glslang::TShader& tShader,
-            const filament::driver::ShaderModel shaderModel) const;
+            const filament::driver::ShaderModel shaderModel,
+            InternalConfig const& internalConfig) const;
 
     void registerSizePasses(spvtools::Optimizer& optimizer) const;
     void registerPerformancePasses(spvtools::Optimizer& optimizer) const;
 
     const Config& mConfig;
-    std::string* mGlslOutput = nullptr;
-    SpirvBlob* mSpirvOutput = nullptr;
-    EShLanguage mShLang = EShLangFragment;
-    int mLangVersion = 0;
 };
 
 } // namespace matc
@@ -36,6 +36,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 
 using namespace filaflat;
 using namespace utils;
@@ -47,6 +48,8 @@ struct Config {
     bool printSPIRV = false;
     bool transpile = false;
     bool binary = false;
+    bool perf = false;
+    uint32_t budget = 0;
     uint64_t shaderIndex;
 };
 
@@ -75,6 +78,12 @@ static void printUsage(const char* name) {
                     "       Print the nth Vulkan shader transpiled into GLSL\n\n"
                     "   --dump-binary=[index], -b\n"
                     "       Dump binary SPIRV for the nth Vulkan shader to 'out.spv'\n\n"
+                    "   --perf=[budget], -p [budget]\n"
+                    "       Estimate the static cost of every variant from the package's\n"
+                    "       SPIR-V (scalar ALU ops, texture fetches, branches, loops, and a\n"
+                    "       register-pressure proxy). Variants whose score exceeds [budget]\n"
+                    "       are flagged and the exit code is non-zero, so CI can reject\n"
+                    "       expensive materials; a budget of 0 only prints the estimates\n\n"
                     "   --license\n"
                     "       Print copyright and license information\n\n"
     );
@@ -93,7 +102,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[], Config* config) {
-    static constexpr const char* OPTSTR = "hlg:s:v:b:";
+    static constexpr const char* OPTSTR = "hlg:s:v:b:p:";
     static const struct option OPTIONS[] = {
             { "help",         no_argument,       0, 'h' },
             { "license",      no_argument,       0, 'l' },
@@ -101,6 +110,7 @@ static int handleArguments(int argc, char* argv[], Config* config) {
             { "print-spirv",  required_argument, 0, 's' },
             { "print-vkglsl", required_argument, 0, 'v' },
             { "dump-binary",  required_argument, 0, 'b' },
+            { "perf",         required_argument, 0, 'p' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -135,6 +145,10 @@ static int handleArguments(int argc, char* argv[], Config* config) {
                 config->shaderIndex = static_cast<uint64_t>(std::stoi(arg));
                 config->binary = true;
                 break;
+            case 'p':
+                config->perf = true;
+                config->budget = static_cast<uint32_t>(std::stoi(arg));
+                break;
         }
     }
 
@@ -283,6 +297,7 @@ template<>
 const char* toString(filament::SamplerInterfaceBlock::Type type) {
     switch (type) {
         case filament::driver::SamplerType::SAMPLER_2D: return "sampler2D";
+        case filament::driver::SamplerType::SAMPLER_2D_ARRAY: return "sampler2dArray";
         case filament::driver::SamplerType::SAMPLER_CUBEMAP: return "samplerCubemap";
         case filament::driver::SamplerType::SAMPLER_EXTERNAL: return "samplerExternal";
     }
@@ -728,11 +743,172 @@ static void dumpSpirvBinary(const std::vector<uint32_t>& spirv, std::string file
     std::cout << "Binary SPIR-V dumped to " << filename << std::endl;
 }
 
+// Static cost estimate of a shader, from a single pass over its SPIR-V. The counts
+// are static (each instruction counted once, regardless of loops and branches), so
+// they are a lower bound for the dynamic cost; the loop count is reported separately
+// as a warning sign. "Registers" counts the scalar components of function-local
+// variables, a proxy for register pressure (spills on mobile GPUs cut occupancy).
+struct ShaderCost {
+    uint32_t alu = 0;           // scalar ALU ops (vector ops count per component,
+                                // transcendentals are weighted 4x)
+    uint32_t tex = 0;           // texture sample/fetch/gather instructions
+    uint32_t branches = 0;      // conditional branches and switches
+    uint32_t loops = 0;         // structured loops
+    uint32_t registers = 0;     // scalar components of function-local variables
+
+    // single figure of merit for the budget: texture fetches dominate on
+    // bandwidth-limited mobile GPUs, branches cost divergence
+    uint32_t score() const noexcept {
+        return alu + 16 * tex + 4 * branches;
+    }
+};
+
+static ShaderCost analyzeSpirv(const std::vector<uint32_t>& spirv) {
+    ShaderCost cost;
+    if (spirv.size() < 5) {
+        return cost;
+    }
+
+    // scalar component count of each type id, so vector/matrix ops can be costed
+    // per component (they execute per component on scalar mobile GPU ALUs)
+    std::map<uint32_t, uint32_t> typeComponents;
+    auto components = [&typeComponents](uint32_t typeId) -> uint32_t {
+        auto pos = typeComponents.find(typeId);
+        return pos == typeComponents.end() ? 1u : pos->second;
+    };
+
+    for (size_t i = 5; i < spirv.size(); ) {
+        const uint16_t op = uint16_t(spirv[i] & 0xffffu);
+        const uint16_t wordCount = uint16_t(spirv[i] >> 16);
+        if (wordCount == 0 || i + wordCount > spirv.size()) {
+            break; // malformed; stop rather than walk out of bounds
+        }
+        const uint32_t* operands = spirv.data() + i + 1;
+        switch (op) {
+            case 21:    // OpTypeInt
+            case 22:    // OpTypeFloat
+                typeComponents[operands[0]] = 1;
+                break;
+            case 23:    // OpTypeVector
+            case 24:    // OpTypeMatrix (operand 2 is the column count)
+                typeComponents[operands[0]] = components(operands[1]) * operands[2];
+                break;
+            case 32:    // OpTypePointer, forwards to the pointee for OpVariable below
+                typeComponents[operands[0]] = components(operands[2]);
+                break;
+            case 59:    // OpVariable, storage class Function (7) = a shader local
+                if (wordCount >= 4 && operands[2] == 7) {
+                    cost.registers += components(operands[0]);
+                }
+                break;
+            case 12: {  // OpExtInst, GLSL.std.450: operand 3 is the instruction
+                const uint32_t inst = operands[3];
+                // 13..34 is the trig/pow/exp/log/sqrt family; several hardware cycles
+                // each, where the simple ops are single-cycle
+                const uint32_t weight = (inst >= 13 && inst <= 34) ? 4 : 1;
+                cost.alu += components(operands[0]) * weight;
+                break;
+            }
+            case 246:   // OpLoopMerge
+                cost.loops++;
+                break;
+            case 250:   // OpBranchConditional
+            case 251:   // OpSwitch
+                cost.branches++;
+                break;
+            default:
+                if (op >= 126 && op <= 148) {
+                    // the arithmetic block (OpSNegate..OpDot)
+                    cost.alu += components(operands[0]);
+                } else if ((op >= 87 && op <= 97) || (op >= 305 && op <= 315)) {
+                    // OpImageSample*/OpImageFetch/OpImageGather and sparse versions
+                    cost.tex++;
+                }
+                break;
+        }
+        i += wordCount;
+    }
+    return cost;
+}
+
+// --perf: estimates the cost of every variant in the package and flags the ones over
+// budget. The estimate is driven from the SPIR-V (the GLSL text would need a parser),
+// so the package must have been compiled with a vulkan target.
+static bool analyzeShaderCosts(const ChunkContainer& container, void* data, size_t size,
+        uint32_t budget) {
+    if (!container.hasChunk(filamat::ChunkType::MaterialSpirv)) {
+        std::cerr << "The package has no SPIR-V; compile with matc -a vulkan (or -a all) "
+                "to enable --perf." << std::endl;
+        return false;
+    }
+
+    MaterialParser parser(filament::driver::Backend::VULKAN, data, size);
+    if (!parser.parse() || (!parser.isShadingMaterial() && !parser.isPostProcessMaterial())) {
+        return false;
+    }
+
+    std::vector<ShaderInfo> info;
+    if (!getVkShaderInfo(container, &info)) {
+        std::cerr << "Failed to parse SPIRV chunk." << std::endl;
+        return false;
+    }
+
+    std::cout << "Estimated cost per variant:" << std::endl;
+    std::cout << "    #    model  stage variant "
+              << std::setw(8) << std::right << "ALU"
+              << std::setw(8) << "tex"
+              << std::setw(8) << "branch"
+              << std::setw(8) << "loop"
+              << std::setw(8) << "reg"
+              << std::setw(8) << "score" << std::endl;
+
+    bool withinBudget = true;
+    for (uint64_t i = 0; i < info.size(); ++i) {
+        const auto& item = info[i];
+        filaflat::ShaderBuilder builder;
+        parser.getShader(item.shaderModel, item.variant, item.pipelineStage, builder);
+
+        uint32_t const* words = reinterpret_cast<uint32_t const*>(builder.getShader());
+        assert(0 == (builder.size() % 4));
+        const ShaderCost cost = analyzeSpirv(
+                std::vector<uint32_t>(words, words + builder.size() / 4));
+
+        const bool over = budget > 0 && cost.score() > budget;
+        withinBudget = withinBudget && !over;
+
+        std::cout << "    #";
+        std::cout << std::setw(4) << std::left << i;
+        std::cout << std::setw(6) << std::left << toString(item.shaderModel);
+        std::cout << " ";
+        std::cout << std::setw(2) << std::left << toString(item.pipelineStage);
+        std::cout << "    ";
+        std::cout << "0x" << std::hex << std::setfill('0') << std::setw(2)
+                  << std::right << (int) item.variant;
+        std::cout << std::setfill(' ') << std::dec;
+        std::cout << std::setw(9) << std::right << cost.alu
+                  << std::setw(8) << cost.tex
+                  << std::setw(8) << cost.branches
+                  << std::setw(8) << cost.loops
+                  << std::setw(8) << cost.registers
+                  << std::setw(8) << cost.score()
+                  << (over ? "  OVER BUDGET" : "") << std::endl;
+    }
+    std::cout << std::endl;
+
+    if (!withinBudget) {
+        std::cerr << "One or more variants exceed the budget of " << budget << "." << std::endl;
+    }
+    return withinBudget;
+}
+
 static bool parseChunks(Config config, void* data, size_t size) {
     ChunkContainer container(data, size);
     if (!container.parse()) {
         return false;
     }
+    if (config.perf) {
+        return analyzeShaderCosts(container, data, size, config.budget);
+    }
     if (config.printGLSL || config.printSPIRV) {
         filaflat::ShaderBuilder builder;
         std::vector<ShaderInfo> info;
@@ -44,6 +44,8 @@ static bool g_stripAlpha = false;
 static bool g_grayscale = false;
 static bool g_ktxContainer = false;
 static bool g_linearized = false;
+static string g_cachePath = "";
+static uint32_t g_tileSize = 0;
 
 static const char* USAGE = R"TXT(
 MIPGEN generates mipmaps for an image down to the 1x1 level.
@@ -76,6 +78,12 @@ Options:
        the "normals" filter may automatically change the compression scheme
    --strip-alpha
        ignore the alpha component of the input image
+   --cache=FILE, -C FILE
+       skip regeneration entirely when neither the source pixels nor the settings
+       changed since FILE was written; useful for incremental cooks
+   --tile-size=SIZE, -t SIZE
+       with --cache, hash SIZE x SIZE tiles of the source and recompute only the
+       mip regions covered by modified tiles (ignored when compression is used)
    --compression=COMPRESSION, -c COMPRESSION
        format specific compression:
            KTX:
@@ -134,7 +142,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hLlgpf:c:k:s";
+    static constexpr const char* OPTSTR = "hLlgpf:c:k:sC:t:";
     static const struct option OPTIONS[] = {
             { "help",                 no_argument, 0, 'h' },
             { "license",              no_argument, 0, 'L' },
@@ -145,6 +153,8 @@ static int handleArguments(int argc, char* argv[]) {
             { "compression",    required_argument, 0, 'c' },
             { "kernel",         required_argument, 0, 'k' },
             { "strip-alpha",          no_argument, 0, 's' },
+            { "cache",          required_argument, 0, 'C' },
+            { "tile-size",      required_argument, 0, 't' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -213,12 +223,205 @@ static int handleArguments(int argc, char* argv[]) {
             case 'c':
                 g_compression = arg;
                 break;
+            case 'C':
+                g_cachePath = arg;
+                break;
+            case 't':
+                g_tileSize = (uint32_t) atoi(arg.c_str());
+                if (g_tileSize == 0) {
+                    cerr << "Warning: invalid tile size, tiled caching disabled." << endl;
+                }
+                break;
         }
     }
 
     return optind;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Incremental cooking support, see --cache and --tile-size.
+// ------------------------------------------------------------------------------------------------
+
+static const uint32_t CACHE_MAGIC = 0x4350494d; // 'MIPC'
+static const uint32_t CACHE_VERSION = 1;
+
+struct MipgenCache {
+    uint64_t settings = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 0;
+    uint32_t tileSize = 0;
+    vector<uint64_t> tileHashes;
+    vector<LinearImage> miplevels; // stored only in tiled mode, to allow patching
+};
+
+// FNV-1a, used to fingerprint the source pixels and the generation settings.
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    auto bytes = (const uint8_t*) data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Everything that affects the output must land in this hash, otherwise a settings change could
+// be mistaken for an unchanged cook.
+static uint64_t hashSettings(const string& outputPattern) {
+    string settings = outputPattern + '|' + g_compression + '|';
+    settings += char('0' + (int) g_filter);
+    settings += g_grayscale ? 'g' : '-';
+    settings += g_linearized ? 'l' : '-';
+    settings += g_stripAlpha ? 's' : '-';
+    settings += g_ktxContainer ? 'k' : char('0' + (int) g_format);
+    return hashBytes(settings.data(), settings.size());
+}
+
+// Hashes each tileSize x tileSize tile of the image, or the whole image if tileSize is 0.
+static vector<uint64_t> computeTileHashes(const LinearImage& image, uint32_t tileSize) {
+    const uint32_t width = image.getWidth();
+    const uint32_t height = image.getHeight();
+    const uint32_t nchan = image.getChannels();
+    float const* pixels = image.getPixelRef();
+    if (tileSize == 0) {
+        return { hashBytes(pixels, sizeof(float) * width * height * nchan) };
+    }
+    const uint32_t tilesX = (width + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (height + tileSize - 1) / tileSize;
+    vector<uint64_t> hashes(tilesX * tilesY);
+    for (uint32_t ty = 0; ty < tilesY; ++ty) {
+        for (uint32_t tx = 0; tx < tilesX; ++tx) {
+            const uint32_t x0 = tx * tileSize, x1 = std::min(x0 + tileSize, width);
+            const uint32_t y0 = ty * tileSize, y1 = std::min(y0 + tileSize, height);
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (uint32_t y = y0; y < y1; ++y) {
+                hash = hashBytes(pixels + (size_t(y) * width + x0) * nchan,
+                        sizeof(float) * (x1 - x0) * nchan, hash);
+            }
+            hashes[ty * tilesX + tx] = hash;
+        }
+    }
+    return hashes;
+}
+
+static bool readCache(const string& path, MipgenCache* cache) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return false;
+    }
+    auto read32 = [&in]() { uint32_t v = 0; in.read((char*) &v, sizeof(v)); return v; };
+    auto read64 = [&in]() { uint64_t v = 0; in.read((char*) &v, sizeof(v)); return v; };
+    if (read32() != CACHE_MAGIC || read32() != CACHE_VERSION) {
+        return false;
+    }
+    cache->settings = read64();
+    cache->width = read32();
+    cache->height = read32();
+    cache->channels = read32();
+    cache->tileSize = read32();
+    const uint32_t ntiles = read32();
+    if (!in || cache->channels == 0 || cache->channels > 4 || ntiles > (1u << 22)) {
+        return false;
+    }
+    cache->tileHashes.resize(ntiles);
+    for (uint32_t i = 0; i < ntiles; ++i) {
+        cache->tileHashes[i] = read64();
+    }
+    const uint32_t mipCount = read32();
+    if (!in || mipCount > 32) {
+        return false;
+    }
+    cache->miplevels.resize(mipCount);
+    for (uint32_t i = 0; i < mipCount; ++i) {
+        const uint32_t w = read32();
+        const uint32_t h = read32();
+        if (!in || w == 0 || h == 0 || w > (1u << 16) || h > (1u << 16)) {
+            return false;
+        }
+        LinearImage img(w, h, cache->channels);
+        in.read((char*) img.getPixelRef(), sizeof(float) * w * h * cache->channels);
+        cache->miplevels[i] = img;
+    }
+    return bool(in);
+}
+
+static void writeCache(const string& path, const MipgenCache& cache, bool storeMips) {
+    ofstream out(path, ios::binary | ios::trunc);
+    auto write32 = [&out](uint32_t v) { out.write((const char*) &v, sizeof(v)); };
+    auto write64 = [&out](uint64_t v) { out.write((const char*) &v, sizeof(v)); };
+    write32(CACHE_MAGIC);
+    write32(CACHE_VERSION);
+    write64(cache.settings);
+    write32(cache.width);
+    write32(cache.height);
+    write32(cache.channels);
+    write32(cache.tileSize);
+    write32((uint32_t) cache.tileHashes.size());
+    for (uint64_t hash : cache.tileHashes) {
+        write64(hash);
+    }
+    write32(storeMips ? (uint32_t) cache.miplevels.size() : 0);
+    if (storeMips) {
+        for (const auto& img : cache.miplevels) {
+            write32(img.getWidth());
+            write32(img.getHeight());
+            out.write((const char*) img.getPixelRef(),
+                    sizeof(float) * img.getWidth() * img.getHeight() * img.getChannels());
+        }
+    }
+}
+
+// A cache hit is only honored when the outputs it stands for are still on disk.
+static bool outputsExist(const string& outputPattern, uint32_t count) {
+    if (g_ktxContainer) {
+        return ifstream(outputPattern, ios::binary).good();
+    }
+    char path[256];
+    for (uint32_t mip = 1; mip <= count; ++mip) {
+        int result = snprintf(path, sizeof(path), outputPattern.c_str(), mip);
+        if (result < 0 || result >= sizeof(path)) {
+            return false;
+        }
+        if (!ifstream(path, ios::binary).good()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Recomputes every miplevel inside the mip-space footprint of the given dirty source rect.
+// The footprint is padded by the filter support so that every target pixel whose filter window
+// touches a modified source pixel gets recomputed; resampleImageRegion guarantees the recomputed
+// pixels are bit-identical to a full regeneration.
+static void patchMipRegions(const LinearImage& source, Filter filter,
+        vector<LinearImage>& miplevels, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    // every filter in ImageSampler has a bounding radius of at most 2 target pixels; one more
+    // pixel absorbs rounding
+    const uint32_t MARGIN = 3;
+    const uint32_t swidth = source.getWidth();
+    const uint32_t sheight = source.getHeight();
+    for (auto& mip : miplevels) {
+        const uint32_t mw = mip.getWidth();
+        const uint32_t mh = mip.getHeight();
+        const uint32_t nchan = mip.getChannels();
+        // the dirty rect in mip coordinates, padded by the filter support
+        const uint32_t dx0 = uint32_t(uint64_t(x0) * mw / swidth);
+        const uint32_t dy0 = uint32_t(uint64_t(y0) * mh / sheight);
+        const uint32_t dx1 = uint32_t((uint64_t(x1) * mw + swidth - 1) / swidth);
+        const uint32_t dy1 = uint32_t((uint64_t(y1) * mh + sheight - 1) / sheight);
+        const uint32_t ax0 = dx0 > MARGIN ? dx0 - MARGIN : 0;
+        const uint32_t ay0 = dy0 > MARGIN ? dy0 - MARGIN : 0;
+        const uint32_t ax1 = std::min(mw, dx1 + MARGIN);
+        const uint32_t ay1 = std::min(mh, dy1 + MARGIN);
+        const LinearImage patch = resampleImageRegion(source, mw, mh, filter,
+                ax0, ay0, ax1, ay1);
+        for (uint32_t y = ay0; y < ay1; ++y) {
+            float* dst = mip.getPixelRef() + (size_t(y) * mw + ax0) * nchan;
+            float const* src = patch.getPixelRef() + size_t(y - ay0) * (ax1 - ax0) * nchan;
+            memcpy(dst, src, sizeof(float) * (ax1 - ax0) * nchan);
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
     int optionIndex = handleArguments(argc, argv);
     int numArgs = argc - optionIndex;
@@ -257,10 +460,79 @@ int main(int argc, char* argv[]) {
         sourceImage = colorsToVectors(sourceImage);
     }
 
-    puts("Generating miplevels...");
     uint32_t count = getMipmapCount(sourceImage);
+
+    // When cooking incrementally, skip everything if neither the source pixels nor the
+    // settings changed since the cache was written.
+    MipgenCache cache;
+    vector<uint64_t> tileHashes;
+    uint64_t settingsHash = 0;
+    bool cacheUsable = false;
+    if (!g_cachePath.empty()) {
+        settingsHash = hashSettings(outputPattern);
+        tileHashes = computeTileHashes(sourceImage, g_tileSize);
+        cacheUsable = readCache(g_cachePath, &cache) &&
+                cache.settings == settingsHash &&
+                cache.width == sourceImage.getWidth() &&
+                cache.height == sourceImage.getHeight() &&
+                cache.channels == sourceImage.getChannels() &&
+                cache.tileSize == g_tileSize &&
+                cache.tileHashes.size() == tileHashes.size();
+        if (cacheUsable && cache.tileHashes == tileHashes && outputsExist(outputPattern, count)) {
+            puts("Source and settings unchanged, skipping regeneration.");
+            return 0;
+        }
+    }
+
+    puts("Generating miplevels...");
     vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+
+    // In tiled mode, patch the cached miplevels instead of regenerating them when only some
+    // of the source tiles changed. Compression always goes through the full path because the
+    // encoders work on whole images anyway.
+    bool partial = cacheUsable && g_tileSize > 0 && g_compression.empty() &&
+            cache.miplevels.size() == count;
+    if (partial) {
+        const uint32_t width = sourceImage.getWidth();
+        const uint32_t height = sourceImage.getHeight();
+        const uint32_t tilesX = (width + g_tileSize - 1) / g_tileSize;
+        uint32_t x0 = width, y0 = height, x1 = 0, y1 = 0;
+        for (size_t i = 0; i < tileHashes.size(); ++i) {
+            if (tileHashes[i] != cache.tileHashes[i]) {
+                const uint32_t tx = uint32_t(i) % tilesX;
+                const uint32_t ty = uint32_t(i) / tilesX;
+                x0 = std::min(x0, tx * g_tileSize);
+                y0 = std::min(y0, ty * g_tileSize);
+                x1 = std::max(x1, std::min((tx + 1) * g_tileSize, width));
+                y1 = std::max(y1, std::min((ty + 1) * g_tileSize, height));
+            }
+        }
+        if (x0 < x1 && y0 < y1) {
+            printf("Patching %ux%u dirty region...\n", x1 - x0, y1 - y0);
+            miplevels = std::move(cache.miplevels);
+            patchMipRegions(sourceImage, g_filter, miplevels, x0, y0, x1, y1);
+        } else {
+            // the pixels are unchanged but an output went missing; fall through
+            partial = false;
+        }
+    }
+    if (!partial) {
+        generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    }
+
+    const auto updateCache = [&]() {
+        if (g_cachePath.empty()) {
+            return;
+        }
+        cache.settings = settingsHash;
+        cache.width = sourceImage.getWidth();
+        cache.height = sourceImage.getHeight();
+        cache.channels = sourceImage.getChannels();
+        cache.tileSize = g_tileSize;
+        cache.tileHashes = tileHashes;
+        cache.miplevels = miplevels;
+        writeCache(g_cachePath, cache, g_tileSize > 0 && g_compression.empty());
+    };
 
     if (g_ktxContainer) {
         puts("Writing KTX file to disk...");
@@ -341,6 +613,7 @@ int main(int argc, char* argv[]) {
         ofstream outputStream(outputPattern, ios::out | ios::binary);
         outputStream.write((const char*) fileContents.data(), fileContents.size());
         outputStream.close();
+        updateCache();
         puts("Done.");
         return 0;
     }
@@ -397,5 +670,6 @@ int main(int argc, char* argv[]) {
         html << HTML_SUFFIX;
     }
 
+    updateCache();
     puts("Done.");
 }